@@ -200,6 +200,8 @@ void K3b::Core::init()
 
     externalBinManager()->search();
 
+    // the device settings contain the cached capabilities of known devices
+    deviceManager()->readConfig( KSharedConfig::openConfig()->group( QStringLiteral("Devices") ) );
     deviceManager()->scanBus();
 
     mediaCache()->buildDeviceList( deviceManager() );
@@ -278,7 +280,10 @@ QList<K3b::Job*> K3b::Core::runningJobs() const
 bool K3b::Core::blockDevice( K3b::Device::Device* dev )
 {
     if( QThread::currentThread() == s_guiThreadHandle ) {
-        return internalBlockDevice( dev );
+        if( !internalBlockDevice( dev ) )
+            return false;
+        emit deviceInUse( dev );
+        return true;
     }
     else {
         bool success = false;
@@ -329,8 +334,11 @@ bool K3b::Core::deviceBlocked( Device::Device* dev ) const
 void K3b::Core::customEvent( QEvent* e )
 {
     if( DeviceBlockingEvent* de = dynamic_cast<DeviceBlockingEvent*>(e) ) {
-        if( de->block )
+        if( de->block ) {
             *de->success = internalBlockDevice( de->device );
+            if( *de->success )
+                emit deviceInUse( de->device );
+        }
         else
             internalUnblockDevice( de->device );
         de->cond->done();
@@ -127,6 +127,11 @@ namespace K3b {
         void jobFinished( K3b::Job* );
         void burnJobFinished( K3b::BurnJob* );
 
+        /**
+         * Emitted in the GUI thread once @p dev has been blocked via blockDevice().
+         */
+        void deviceInUse( K3b::Device::Device* dev );
+
     public Q_SLOTS:
         /**
          * Every running job registers itself with the core.
@@ -18,6 +18,11 @@ K3b::GlobalSettings::GlobalSettings()
       m_overburn(false),
       m_useManualBufferSize(false),
       m_bufferSize(4),
+      m_onTheFlyBufferSize(64),
+      m_onTheFlyBufferSpill(false),
+      m_imageCacheSize(0),
+      m_sampledVerification(false),
+      m_verificationConfidence(95),
       m_force(false)
 {
 }
@@ -35,6 +40,11 @@ void K3b::GlobalSettings::readSettings( const KConfigGroup& c )
     m_overburn = c.readEntry( "Allow overburning", false );
     m_useManualBufferSize = c.readEntry( "Manual buffer size", false );
     m_bufferSize = c.readEntry( "Fifo buffer", 4 );
+    m_onTheFlyBufferSize = c.readEntry( "On-the-fly buffer", 64 );
+    m_onTheFlyBufferSpill = c.readEntry( "Spill on-the-fly buffer", false );
+    m_imageCacheSize = c.readEntry( "Image cache size", 0 );
+    m_sampledVerification = c.readEntry( "Sampled verification", false );
+    m_verificationConfidence = c.readEntry( "Verification confidence", 95 );
     m_force = c.readEntry( "Force unsafe operations", false );
 	m_defaultTempPath = c.readPathEntry("Temp Dir",
             QStandardPaths::writableLocation(QStandardPaths::MoviesLocation));
@@ -53,6 +63,11 @@ void K3b::GlobalSettings::saveSettings( KConfigGroup c )
     c.writeEntry( "Allow overburning", m_overburn );
     c.writeEntry( "Manual buffer size", m_useManualBufferSize );
     c.writeEntry( "Fifo buffer", m_bufferSize );
+    c.writeEntry( "On-the-fly buffer", m_onTheFlyBufferSize );
+    c.writeEntry( "Spill on-the-fly buffer", m_onTheFlyBufferSpill );
+    c.writeEntry( "Image cache size", m_imageCacheSize );
+    c.writeEntry( "Sampled verification", m_sampledVerification );
+    c.writeEntry( "Verification confidence", m_verificationConfidence );
     c.writeEntry( "Force unsafe operations", m_force );
     c.writeEntry( "Temp Dir", m_defaultTempPath );
 }
@@ -40,6 +40,38 @@ namespace K3b {
         bool useManualBufferSize() const { return m_useManualBufferSize; }
         int bufferSize() const { return m_bufferSize; }
 
+        /**
+         * The maximum size in MB of the buffer between the source and the
+         * writer when writing on-the-fly. 0 disables the buffer.
+         */
+        int onTheFlyBufferSize() const { return m_onTheFlyBufferSize; }
+
+        /**
+         * If true the on-the-fly buffer may spill data to the temp folder
+         * once its memory is exhausted.
+         */
+        bool onTheFlyBufferSpill() const { return m_onTheFlyBufferSpill; }
+
+        /**
+         * The size in GB of the cache which keeps the images of data
+         * projects for writing them again. 0 disables the cache.
+         *
+         * \see ImageCache
+         */
+        int imageCacheSize() const { return m_imageCacheSize; }
+
+        /**
+         * If true only a sample of the written data is verified where possible.
+         *
+         * \see VerificationJob::setSampling
+         */
+        bool sampledVerification() const { return m_sampledVerification; }
+
+        /**
+         * The confidence in percent used for sampled verification.
+         */
+        int verificationConfidence() const { return m_verificationConfidence; }
+
         /**
          * If force is set to true K3b will continue in certain "unsafe" situations.
          * The most common being a medium not suitable for the writer in terms of
@@ -58,6 +90,11 @@ namespace K3b {
         void setOverburn( bool b ) { m_overburn = b; }
         void setUseManualBufferSize( bool b ) { m_useManualBufferSize = b; }
         void setBufferSize( int size ) { m_bufferSize = size; }
+        void setOnTheFlyBufferSize( int size ) { m_onTheFlyBufferSize = size; }
+        void setOnTheFlyBufferSpill( bool b ) { m_onTheFlyBufferSpill = b; }
+        void setImageCacheSize( int size ) { m_imageCacheSize = size; }
+        void setSampledVerification( bool b ) { m_sampledVerification = b; }
+        void setVerificationConfidence( int c ) { m_verificationConfidence = c; }
         void setForce( bool b ) { m_force = b; }
         void setDefaultTempPath( const QString& s ) { m_defaultTempPath = s; }
 
@@ -68,6 +105,11 @@ namespace K3b {
         bool m_overburn;
         bool m_useManualBufferSize;
         int m_bufferSize;
+        int m_onTheFlyBufferSize;
+        bool m_onTheFlyBufferSpill;
+        int m_imageCacheSize;
+        bool m_sampledVerification;
+        int m_verificationConfidence;
         bool m_force;
         QString m_defaultTempPath;
     };
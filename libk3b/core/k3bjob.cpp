@@ -7,10 +7,14 @@
 #include "k3bjob.h"
 #include "k3bglobals.h"
 #include "k3bcore.h"
+#include "k3bglobalsettings.h"
+#include "k3babstractwriter.h"
+#include "k3bprefetchbuffer.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
 #include <QEventLoop>
+#include <QPointer>
 #include <QStringList>
 
 
@@ -298,6 +302,9 @@ class K3b::BurnJob::Private
 {
 public:
     K3b::WritingApp writeMethod;
+
+    // the writer fed by the last prefetch buffer
+    QPointer<K3b::AbstractWriter> prefetchWriter;
 };
 
 
@@ -333,4 +340,38 @@ K3b::WritingApps K3b::BurnJob::supportedWritingApps() const
     return K3b::WritingAppAuto | K3b::WritingAppCdrdao | K3b::WritingAppCdrecord;
 }
 
+
+K3b::PrefetchBuffer* K3b::BurnJob::createPrefetchBuffer( K3b::AbstractWriter* writer, bool closeWriter )
+{
+    K3b::GlobalSettings* settings = k3bcore->globalSettings();
+    const qint64 size = qint64( settings->onTheFlyBufferSize() ) * 1024 * 1024;
+    if( size <= 0 || !writer->ioDevice() )
+        return 0;
+
+    K3b::PrefetchBuffer* buffer = new K3b::PrefetchBuffer();
+    buffer->setSize( size / 4, size );
+    if( settings->onTheFlyBufferSpill() )
+        buffer->setSpillDirectory( settings->defaultTempPath(), 4 * size );
+    buffer->writeTo( writer->ioDevice(), closeWriter );
+
+    d->prefetchWriter = writer;
+    connect( buffer, SIGNAL(fillLevelChanged(int)), this, SIGNAL(prefetchBuffer(int)) );
+    connect( buffer, SIGNAL(sourceRate(int)), this, SIGNAL(sourceThroughput(int)) );
+    connect( buffer, SIGNAL(underrunImminent(int)), this, SLOT(slotPrefetchUnderrun(int)) );
+
+    return buffer;
+}
+
+
+void K3b::BurnJob::slotPrefetchUnderrun( int seconds )
+{
+    if( d->prefetchWriter && d->prefetchWriter->reduceWriteSpeed() )
+        return;
+
+    emit infoMessage( i18np("The source does not deliver the data fast enough. The buffer will run empty in %1 second.",
+                            "The source does not deliver the data fast enough. The buffer will run empty in %1 seconds.",
+                            qMax( 1, seconds ) ),
+                      MessageWarning );
+}
+
 #include "moc_k3bjob.cpp"
@@ -22,6 +22,9 @@ namespace K3b {
         class Device;
     }
 
+    class AbstractWriter;
+    class PrefetchBuffer;
+
     /**
      * This is the baseclass for all the jobs in K3b which actually do the work like burning a cd!
      * The Job object takes care of registering with the k3bcore or with a parent Job.
@@ -297,6 +300,17 @@ namespace K3b {
 
         void deviceBuffer( int );
 
+        /**
+         * Fill level of the PrefetchBuffer used when writing on-the-fly.
+         */
+        void prefetchBuffer( int );
+
+        /**
+         * The rate in KB/s at which the source delivers the data when
+         * writing on-the-fly.
+         */
+        void sourceThroughput( int );
+
         /**
          * @param speed current writing speed in Kb
          * @param multiplicator use 150 for CDs and 1380 for DVDs
@@ -312,6 +326,22 @@ namespace K3b {
          */
         void burning(bool);
 
+    protected:
+        /**
+         * Creates a PrefetchBuffer configured according to the global settings
+         * which feeds the ioDevice() of @p writer. Its fill level is emitted
+         * via prefetchBuffer() and @p writer is asked to lower the writing speed
+         * once the buffer is about to run empty.
+         *
+         * The caller takes ownership of the buffer.
+         *
+         * \return 0 if the user disabled the buffer.
+         */
+        PrefetchBuffer* createPrefetchBuffer( AbstractWriter* writer, bool closeWriter );
+
+    private Q_SLOTS:
+        void slotPrefetchUnderrun( int seconds );
+
     private:
         class Private;
         Private* const d;
@@ -0,0 +1,661 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "k3bbatchingestjob.h"
+#include "k3baudiosessionreadingjob.h"
+#include "k3bdatatrackreader.h"
+#include "k3bchecksumpipe.h"
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3bdevicehandler.h"
+#include "k3bdiskinfo.h"
+#include "k3biso9660.h"
+#include "k3bmediacache.h"
+#include "k3bmedium.h"
+#include "k3btoc.h"
+#include "k3btrack.h"
+#include "k3b_i18n.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QTextStream>
+
+
+class K3b::BatchIngestJob::Private
+{
+public:
+    class Drive
+    {
+    public:
+        Drive()
+            : device( 0 ),
+              reader( 0 ),
+              audio( false ),
+              waiting( false ),
+              ejecting( false ),
+              percent( 0 ) {
+        }
+
+        Device::Device* device;
+        QString bus;
+
+        // the disc which is being read or has been read last
+        Medium medium;
+
+        Job* reader;
+        bool audio;
+        bool waiting;
+        bool ejecting;
+        int percent;
+
+        QString imagePath;
+        QFile imageFile;
+        ChecksumPipe checksumPipe;
+    };
+
+    Private()
+        : discCount( 0 ),
+          maxReadersPerBus( 1 ),
+          ejectWhenDone( true ),
+          ignoreReadErrors( false ),
+          readRetries( 128 ),
+          imaged( 0 ),
+          failed( 0 ),
+          running( false ),
+          canceled( false ) {
+    }
+
+    Drive* drive( Device::Device* dev ) const {
+        Q_FOREACH( Drive* drive, drives ) {
+            if( drive->device == dev )
+                return drive;
+        }
+        return 0;
+    }
+
+    Drive* drive( QObject* reader ) const {
+        Q_FOREACH( Drive* drive, drives ) {
+            if( reader && drive->reader == reader )
+                return drive;
+        }
+        return 0;
+    }
+
+    int readers() const {
+        int n = 0;
+        Q_FOREACH( Drive* drive, drives ) {
+            if( drive->reader )
+                ++n;
+        }
+        return n;
+    }
+
+    int readersOnBus( const QString& bus ) const {
+        int n = 0;
+        Q_FOREACH( Drive* drive, drives ) {
+            if( drive->reader && drive->bus == bus )
+                ++n;
+        }
+        return n;
+    }
+
+    QString imageBaseName( const Drive* drive ) const;
+    bool writeChecksumFile( const Drive* drive ) const;
+    bool writeCueFile( const Drive* drive ) const;
+
+    QList<Device::Device*> devices;
+    QString targetDir;
+    int discCount;
+    int maxReadersPerBus;
+    bool ejectWhenDone;
+    bool ignoreReadErrors;
+    int readRetries;
+
+    QList<Drive*> drives;
+
+    // the drives with a disc waiting for a free slot on their bus, in order of insertion
+    QList<Drive*> queue;
+    QHash<Device::DeviceHandler*, Drive*> ejects;
+
+    int imaged;
+    int failed;
+    bool running;
+    bool canceled;
+};
+
+
+QString K3b::BatchIngestJob::Private::imageBaseName( const Drive* drive ) const
+{
+    QString name = drive->medium.volumeId().trimmed();
+    if( name.isEmpty() )
+        name = drive->medium.cdText().title().trimmed();
+    name.replace( QRegularExpression( "[^\\w.-]+" ), "_" );
+    if( name.isEmpty() )
+        name = "disc";
+    name += '-' + QDateTime::currentDateTime().toString( "yyyyMMdd-hhmmss" );
+
+    // two drives might finish discs with the same name in the same second
+    QDir dir( targetDir );
+    QString baseName = name;
+    for( int i = 2; QFile::exists( dir.filePath( baseName + ".iso" ) ) || QFile::exists( dir.filePath( baseName + ".bin" ) ); ++i )
+        baseName = name + QString( "-%1" ).arg( i );
+
+    return dir.filePath( baseName );
+}
+
+
+bool K3b::BatchIngestJob::Private::writeChecksumFile( const Drive* drive ) const
+{
+    QFile f( drive->imagePath + ".md5" );
+    if( !f.open( QIODevice::WriteOnly ) )
+        return false;
+
+    // the format understood by md5sum -c
+    QTextStream s( &f );
+    s << drive->checksumPipe.checksum() << "  " << QFileInfo( drive->imagePath ).fileName() << '\n';
+    s.flush();
+    return s.status() == QTextStream::Ok;
+}
+
+
+bool K3b::BatchIngestJob::Private::writeCueFile( const Drive* drive ) const
+{
+    QFile f( drive->imagePath.left( drive->imagePath.lastIndexOf( '.' ) ) + ".cue" );
+    if( !f.open( QIODevice::WriteOnly ) )
+        return false;
+
+    QTextStream s( &f );
+    const Device::CdText cdText = drive->medium.cdText();
+    if( !cdText.title().isEmpty() )
+        s << "TITLE \"" << cdText.title() << "\"\n";
+    if( !cdText.performer().isEmpty() )
+        s << "PERFORMER \"" << cdText.performer() << "\"\n";
+
+    // the session reader writes big endian samples
+    s << "FILE \"" << QFileInfo( drive->imagePath ).fileName() << "\" MOTOROLA\n";
+
+    // the audio tracks are read without gaps starting at the first one
+    const Device::Toc toc = drive->medium.toc();
+    int firstSector = -1;
+    for( int i = 0; i < toc.count(); ++i ) {
+        const Device::Track& track = toc[i];
+        if( track.type() != Device::Track::TYPE_AUDIO ) {
+            if( firstSector >= 0 )
+                break;
+            continue;
+        }
+        if( firstSector < 0 )
+            firstSector = track.firstSector().lba();
+
+        s << QString( "  TRACK %1 AUDIO\n" ).arg( i+1, 2, 10, QChar( '0' ) );
+        if( i < cdText.count() && !cdText[i].title().isEmpty() )
+            s << "    TITLE \"" << cdText[i].title() << "\"\n";
+        s << "    INDEX 01 " << Msf( track.firstSector().lba() - firstSector ).toString() << '\n';
+    }
+
+    s.flush();
+    return s.status() == QTextStream::Ok;
+}
+
+
+K3b::BatchIngestJob::BatchIngestJob( K3b::JobHandler* hdl, QObject* parent )
+    : K3b::Job( hdl, parent ),
+      d( new Private() )
+{
+}
+
+
+K3b::BatchIngestJob::~BatchIngestJob()
+{
+    qDeleteAll( d->drives );
+    delete d;
+}
+
+
+QString K3b::BatchIngestJob::jobDescription() const
+{
+    return i18n("Imaging Discs");
+}
+
+
+QString K3b::BatchIngestJob::jobDetails() const
+{
+    if( d->discCount > 0 )
+        return i18np( "1 disc from %2", "%1 discs from %2", d->discCount,
+                      i18np( "1 drive", "%1 drives", d->devices.count() ) );
+    else
+        return i18np( "1 drive", "%1 drives", d->devices.count() );
+}
+
+
+QString K3b::BatchIngestJob::jobTarget() const
+{
+    return d->targetDir;
+}
+
+
+int K3b::BatchIngestJob::imagedDiscs() const
+{
+    return d->imaged;
+}
+
+
+int K3b::BatchIngestJob::failedDiscs() const
+{
+    return d->failed;
+}
+
+
+void K3b::BatchIngestJob::setDevices( const QList<K3b::Device::Device*>& devices )
+{
+    d->devices = devices;
+}
+
+
+void K3b::BatchIngestJob::setTargetDirectory( const QString& dir )
+{
+    d->targetDir = dir;
+}
+
+
+void K3b::BatchIngestJob::setDiscCount( int count )
+{
+    d->discCount = count;
+}
+
+
+void K3b::BatchIngestJob::setMaxReadersPerBus( int readers )
+{
+    d->maxReadersPerBus = qMax( 1, readers );
+}
+
+
+void K3b::BatchIngestJob::setEjectWhenDone( bool b )
+{
+    d->ejectWhenDone = b;
+}
+
+
+void K3b::BatchIngestJob::setIgnoreReadErrors( bool b )
+{
+    d->ignoreReadErrors = b;
+}
+
+
+void K3b::BatchIngestJob::setReadRetries( int retries )
+{
+    d->readRetries = retries;
+}
+
+
+// static
+QString K3b::BatchIngestJob::busId( K3b::Device::Device* dev )
+{
+#ifdef Q_OS_LINUX
+    //
+    // The sysfs path of an optical drive looks like
+    //   /sys/devices/pci0000:00/0000:00:1f.2/ata2/host1/target1:0:0/1:0:0:0
+    // for a SATA drive and like
+    //   /sys/devices/pci0000:00/0000:00:14.0/usb2/2-1/2-1:1.0/host6/target6:0:0/6:0:0:0
+    // for a USB drive. Every SATA port has its own bandwidth while all devices
+    // behind a USB root hub share it. Thus the path up to the first port or bus
+    // component identifies the bus.
+    //
+    const QString name = QFileInfo( dev->blockDeviceName() ).fileName();
+    const QString path = QFileInfo( QString( "/sys/class/block/%1/device" ).arg( name ) ).canonicalFilePath();
+    if( !path.isEmpty() ) {
+        static const QRegularExpression s_busRx( "^(usb|ata|host)\\d+$" );
+        const QStringList components = path.split( '/', Qt::SkipEmptyParts );
+        for( int i = 0; i < components.count(); ++i ) {
+            if( s_busRx.match( components[i] ).hasMatch() )
+                return '/' + QStringList( components.mid( 0, i+1 ) ).join( '/' );
+        }
+    }
+#endif
+    return dev->blockDeviceName();
+}
+
+
+void K3b::BatchIngestJob::start()
+{
+    jobStarted();
+
+    d->running = true;
+    d->canceled = false;
+    d->imaged = d->failed = 0;
+    d->queue.clear();
+    d->ejects.clear();
+    qDeleteAll( d->drives );
+    d->drives.clear();
+
+    if( d->devices.isEmpty() ) {
+        emit infoMessage( i18n("No drives selected."), MessageError );
+        d->running = false;
+        jobFinished( false );
+        return;
+    }
+
+    if( d->targetDir.isEmpty() || !QDir().mkpath( d->targetDir ) ) {
+        emit infoMessage( i18n("Unable to create folder '%1'.", d->targetDir), MessageError );
+        d->running = false;
+        jobFinished( false );
+        return;
+    }
+
+    Q_FOREACH( Device::Device* dev, d->devices ) {
+        Private::Drive* drive = new Private::Drive();
+        drive->device = dev;
+        drive->bus = busId( dev );
+        d->drives.append( drive );
+        qDebug() << "(K3b::BatchIngestJob)" << dev->blockDeviceName() << "on bus" << drive->bus;
+    }
+
+    emit newTask( i18n("Waiting for media") );
+
+    connect( k3bcore->mediaCache(), SIGNAL(mediumChanged(K3b::Device::Device*)),
+             this, SLOT(slotMediumChanged(K3b::Device::Device*)) );
+
+    // pick up the discs which are already inserted
+    Q_FOREACH( Device::Device* dev, d->devices )
+        slotMediumChanged( dev );
+}
+
+
+void K3b::BatchIngestJob::cancel()
+{
+    if( !d->running || d->canceled )
+        return;
+
+    d->canceled = true;
+
+    Q_FOREACH( Private::Drive* drive, d->queue )
+        drive->waiting = false;
+    d->queue.clear();
+
+    Q_FOREACH( Private::Drive* drive, d->drives ) {
+        if( drive->reader )
+            drive->reader->cancel();
+    }
+
+    finishIfDone();
+}
+
+
+void K3b::BatchIngestJob::slotMediumChanged( K3b::Device::Device* dev )
+{
+    Private::Drive* drive = d->drive( dev );
+    if( !d->running || d->canceled || !drive ||
+        drive->waiting || drive->reader || drive->ejecting )
+        return;
+
+    const Medium medium = k3bcore->mediaCache()->medium( dev );
+    const Device::MediaState state = medium.diskInfo().diskState();
+    if( ( state != Device::STATE_COMPLETE && state != Device::STATE_INCOMPLETE ) ||
+        !( medium.content() & ( Medium::ContentData|Medium::ContentAudio ) ) )
+        return;
+
+    // the disc has been read already but was not ejected
+    if( drive->medium.sameMedium( medium ) )
+        return;
+
+    qDebug() << "(K3b::BatchIngestJob) new disc in" << dev->blockDeviceName();
+
+    drive->medium = medium;
+    drive->waiting = true;
+    d->queue.append( drive );
+
+    startReaders();
+}
+
+
+void K3b::BatchIngestJob::startReaders()
+{
+    //
+    // The discs are read in the order they have been inserted. A disc on a busy
+    // bus does not block the ones on other buses but is the first to start once
+    // its bus becomes available.
+    //
+    int i = 0;
+    while( i < d->queue.count() ) {
+        if( d->discCount > 0 && d->imaged + d->failed + d->readers() >= d->discCount )
+            break;
+
+        Private::Drive* drive = d->queue[i];
+        if( d->readersOnBus( drive->bus ) >= d->maxReadersPerBus ) {
+            ++i;
+            continue;
+        }
+
+        d->queue.removeAt( i );
+        drive->waiting = false;
+
+        if( !startReader( d->drives.indexOf( drive ) ) ) {
+            ++d->failed;
+            emit discImaged( drive->device, QString() );
+        }
+    }
+
+    updateProgress();
+    finishIfDone();
+}
+
+
+bool K3b::BatchIngestJob::startReader( int index )
+{
+    Private::Drive* drive = d->drives[index];
+    const Device::Toc toc = drive->medium.toc();
+
+    drive->audio = !( drive->medium.content() & Medium::ContentData );
+    drive->imagePath = d->imageBaseName( drive ) + ( drive->audio ? ".bin" : ".iso" );
+    drive->percent = 0;
+
+    if( drive->audio ) {
+        AudioSessionReadingJob* reader = new AudioSessionReadingJob( this, this );
+        reader->setDevice( drive->device );
+        reader->setToc( toc );
+        reader->setReadRetries( d->readRetries );
+        reader->setNeverSkip( !d->ignoreReadErrors );
+        reader->writeTo( &drive->checksumPipe );
+        drive->reader = reader;
+    }
+    else {
+        const Device::Track* track = 0;
+        for( int i = 0; i < toc.count(); ++i ) {
+            if( toc[i].type() == Device::Track::TYPE_DATA ) {
+                track = &toc[i];
+                break;
+            }
+        }
+        if( !track ) {
+            emit infoMessage( i18n("Unable to find a data track on the medium in %1.", drive->device->blockDeviceName()), MessageError );
+            return false;
+        }
+
+        //
+        // The TOC of overwritable media and of TAO written CDs does not tell
+        // the size of the data. For a single track we use the size of the
+        // ISO 9660 file system instead.
+        //
+        int lastSector = track->lastSector().lba();
+        const Iso9660SimplePrimaryDescriptor& iso = drive->medium.iso9660Descriptor();
+        if( toc.count() == 1 && iso.volumeSpaceSize > 0 && iso.logicalBlockSize > 0 )
+            lastSector = qMin( lastSector, int( track->firstSector().lba() + iso.volumeSpaceSize*iso.logicalBlockSize/2048 - 1 ) );
+
+        DataTrackReader* reader = new DataTrackReader( this, this );
+        reader->setDevice( drive->device );
+        reader->setSectorRange( track->firstSector(), lastSector );
+        reader->setSectorSize( DataTrackReader::MODE1 );
+        reader->setRetries( d->readRetries );
+        reader->setIgnoreErrors( d->ignoreReadErrors );
+        reader->writeTo( &drive->checksumPipe );
+        drive->reader = reader;
+    }
+
+    drive->imageFile.setFileName( drive->imagePath );
+    if( !drive->imageFile.open( QIODevice::WriteOnly ) ) {
+        emit infoMessage( i18n("Unable to open '%1' for writing.", drive->imagePath), MessageError );
+        delete drive->reader;
+        drive->reader = 0;
+        return false;
+    }
+    drive->checksumPipe.writeTo( &drive->imageFile, true );
+    drive->checksumPipe.open( true );
+
+    connect( drive->reader, SIGNAL(infoMessage(QString,int)), this, SLOT(slotReaderInfoMessage(QString,int)) );
+    connect( drive->reader, SIGNAL(debuggingOutput(QString,QString)), this, SIGNAL(debuggingOutput(QString,QString)) );
+    connect( drive->reader, SIGNAL(percent(int)), this, SLOT(slotReaderPercent(int)) );
+    connect( drive->reader, SIGNAL(finished(bool)), this, SLOT(slotReaderFinished(bool)) );
+
+    emit infoMessage( i18n("Reading %1 in %2 to %3.",
+                           drive->medium.shortString(),
+                           drive->device->blockDeviceName(),
+                           drive->imagePath ), MessageInfo );
+    emit newSubTask( i18np( "Reading 1 disc", "Reading %1 discs", d->readers() ) );
+
+    drive->reader->start();
+    return true;
+}
+
+
+void K3b::BatchIngestJob::slotReaderInfoMessage( const QString& message, int type )
+{
+    Private::Drive* drive = d->drive( sender() );
+    if( drive )
+        emit infoMessage( QString( "%1: %2" ).arg( drive->device->blockDeviceName() ).arg( message ), type );
+    else
+        emit infoMessage( message, type );
+}
+
+
+void K3b::BatchIngestJob::slotReaderPercent( int percent )
+{
+    Private::Drive* drive = d->drive( sender() );
+    if( drive ) {
+        drive->percent = percent;
+        updateProgress();
+    }
+}
+
+
+void K3b::BatchIngestJob::updateProgress()
+{
+    int sum = 0;
+    int readers = 0;
+    Q_FOREACH( Private::Drive* drive, d->drives ) {
+        if( drive->reader ) {
+            sum += drive->percent;
+            ++readers;
+        }
+    }
+
+    if( d->discCount > 0 )
+        emit percent( ( 100*( d->imaged + d->failed ) + sum ) / d->discCount );
+    emit subPercent( readers > 0 ? sum / readers : 0 );
+}
+
+
+void K3b::BatchIngestJob::slotReaderFinished( bool success )
+{
+    Private::Drive* drive = d->drive( sender() );
+    if( !drive )
+        return;
+
+    drive->checksumPipe.close();
+    drive->imageFile.close();
+    drive->reader->deleteLater();
+    drive->reader = 0;
+
+    if( success && !d->canceled ) {
+        if( !d->writeChecksumFile( drive ) )
+            emit infoMessage( i18n("Unable to write checksum file for %1.", drive->imagePath), MessageWarning );
+        if( drive->audio && !d->writeCueFile( drive ) )
+            emit infoMessage( i18n("Unable to write cue file for %1.", drive->imagePath), MessageWarning );
+
+        ++d->imaged;
+        emit infoMessage( i18n("Successfully read %1 in %2 (MD5 %3).",
+                               drive->medium.shortString(),
+                               drive->device->blockDeviceName(),
+                               QString::fromLatin1( drive->checksumPipe.checksum() ) ), MessageSuccess );
+        emit discImaged( drive->device, drive->imagePath );
+    }
+    else {
+        QFile::remove( drive->imagePath );
+        if( !d->canceled ) {
+            ++d->failed;
+            emit infoMessage( i18n("Error while reading %1 in %2.",
+                                   drive->medium.shortString(),
+                                   drive->device->blockDeviceName() ), MessageError );
+            emit discImaged( drive->device, QString() );
+        }
+    }
+
+    // failed discs are ejected as well so the next one can be inserted
+    if( d->ejectWhenDone && !d->canceled ) {
+        drive->ejecting = true;
+        Device::DeviceHandler* dh = Device::eject( drive->device );
+        d->ejects.insert( dh, drive );
+        connect( dh, SIGNAL(finished(K3b::Device::DeviceHandler*)),
+                 this, SLOT(slotEjectFinished(K3b::Device::DeviceHandler*)) );
+    }
+
+    if( d->readers() == 0 )
+        emit newSubTask( i18n("Waiting for media") );
+
+    startReaders();
+}
+
+
+void K3b::BatchIngestJob::slotEjectFinished( K3b::Device::DeviceHandler* dh )
+{
+    Private::Drive* drive = d->ejects.take( dh );
+    if( !drive )
+        return;
+
+    drive->ejecting = false;
+
+    if( dh->success() ) {
+        // the same disc may be inserted again to read it once more
+        drive->medium = Medium();
+    }
+    else {
+        emit infoMessage( i18n("Unable to eject the medium in %1. Please do so manually.", drive->device->blockDeviceName()), MessageWarning );
+    }
+
+    finishIfDone();
+}
+
+
+void K3b::BatchIngestJob::finishIfDone()
+{
+    if( !d->running )
+        return;
+
+    if( !d->canceled && ( d->discCount <= 0 || d->imaged + d->failed < d->discCount ) )
+        return;
+
+    Q_FOREACH( Private::Drive* drive, d->drives ) {
+        if( drive->reader || drive->ejecting )
+            return;
+    }
+
+    disconnect( k3bcore->mediaCache(), SIGNAL(mediumChanged(K3b::Device::Device*)),
+                this, SLOT(slotMediumChanged(K3b::Device::Device*)) );
+    d->running = false;
+
+    if( d->canceled ) {
+        emit canceled();
+        jobFinished( false );
+    }
+    else {
+        jobFinished( d->failed == 0 );
+    }
+}
+
+#include "moc_k3bbatchingestjob.cpp"
@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef _K3B_BATCH_INGEST_JOB_H_
+#define _K3B_BATCH_INGEST_JOB_H_
+
+#include "k3bjob.h"
+#include "k3b_export.h"
+
+#include <QList>
+#include <QString>
+
+namespace K3b {
+    namespace Device {
+        class Device;
+        class DeviceHandler;
+    }
+
+    /**
+     * Images every disc which is inserted into one of several drives.
+     *
+     * The job watches the drives through the MediaCache. Once a data or
+     * audio disc is inserted it is read into the target folder while the
+     * other drives keep working:
+     * \li Data discs are read with a DataTrackReader into an ISO image.
+     * \li Audio discs are ripped into a big endian raw image with a cue
+     *     sheet (file type MOTOROLA).
+     *
+     * An md5sum compatible checksum file is written next to every image.
+     * Once a disc has been read it is ejected (see setEjectWhenDone()).
+     *
+     * Drives which are connected to the same bus (for example several drives
+     * behind one USB root hub) share its bandwidth. To keep them from slowing
+     * each other down only setMaxReadersPerBus() of them read at the same time.
+     * The others wait in the order in which the discs have been inserted.
+     */
+    class LIBK3B_EXPORT BatchIngestJob : public Job
+    {
+        Q_OBJECT
+
+    public:
+        explicit BatchIngestJob( JobHandler*, QObject* parent = 0 );
+        ~BatchIngestJob() override;
+
+        QString jobDescription() const override;
+        QString jobDetails() const override;
+        QString jobTarget() const override;
+
+        /**
+         * The number of discs which have been imaged successfully.
+         */
+        int imagedDiscs() const;
+
+        /**
+         * The number of discs which could not be imaged.
+         */
+        int failedDiscs() const;
+
+        /**
+         * \return An identifier of the bus @p dev is connected to. Drives which
+         *         return the same identifier share their bandwidth.
+         *
+         * On Linux this is derived from the sysfs path of the device, on other
+         * systems every drive is assumed to have a bus of its own.
+         */
+        static QString busId( Device::Device* dev );
+
+    public Q_SLOTS:
+        void start() override;
+        void cancel() override;
+
+        void setDevices( const QList<K3b::Device::Device*>& devices );
+        void setTargetDirectory( const QString& dir );
+
+        /**
+         * Finish once @p count discs have been read. The default of 0 means
+         * to continue until the job is canceled.
+         */
+        void setDiscCount( int count );
+
+        /**
+         * The number of drives on one bus which may read at the same time.
+         * Default is 1.
+         */
+        void setMaxReadersPerBus( int readers );
+
+        /**
+         * Default is true.
+         */
+        void setEjectWhenDone( bool b );
+
+        void setIgnoreReadErrors( bool b );
+        void setReadRetries( int retries );
+
+    Q_SIGNALS:
+        /**
+         * Emitted once a disc has been read.
+         *
+         * \param image The path of the image or an empty string if it could not be read.
+         */
+        void discImaged( K3b::Device::Device* dev, const QString& image );
+
+    private Q_SLOTS:
+        void slotMediumChanged( K3b::Device::Device* dev );
+        void slotReaderInfoMessage( const QString& message, int type );
+        void slotReaderPercent( int percent );
+        void slotReaderFinished( bool success );
+        void slotEjectFinished( K3b::Device::DeviceHandler* dh );
+
+    private:
+        class Private;
+        Private* const d;
+
+        void startReaders();
+        bool startReader( int drive );
+        void updateProgress();
+        void finishIfDone();
+    };
+}
+
+#endif
@@ -23,6 +23,7 @@
 #include "k3binffilewriter.h"
 #include "k3bglobalsettings.h"
 #include "k3bcddb.h"
+#include "k3bprefetchbuffer.h"
 #include "k3b_i18n.h"
 
 #include <KConfig>
@@ -56,7 +57,8 @@ public:
           audioSessionReader(0),
           cdrecordWriter(0),
           infFileWriter(0),
-          cddb(0) {
+          cddb(0),
+          prefetchBuffer(0) {
     }
 
     bool canceled;
@@ -104,6 +106,9 @@ public:
     // used to determine progress
     QVector<long> sessionSizes;
     long overallSize;
+
+    // bridges read errors and slow sectors when copying on-the-fly
+    K3b::PrefetchBuffer* prefetchBuffer;
 };
 
 
@@ -116,6 +121,7 @@ K3b::CdCopyJob::CdCopyJob( K3b::JobHandler* hdl, QObject* parent )
       m_ignoreDataReadErrors(false),
       m_ignoreAudioReadErrors(true),
       m_noCorrection(false),
+      m_rescueMode(false),
       m_dataReadRetries(128),
       m_audioReadRetries(5),
       m_copyCdText(true),
@@ -128,6 +134,7 @@ K3b::CdCopyJob::CdCopyJob( K3b::JobHandler* hdl, QObject* parent )
 K3b::CdCopyJob::~CdCopyJob()
 {
     delete d->infFileWriter;
+    delete d->prefetchBuffer;
     delete d;
 }
 
@@ -488,6 +495,9 @@ void K3b::CdCopyJob::cancel()
 {
     d->canceled = true;
 
+    if( d->prefetchBuffer )
+        d->prefetchBuffer->abort();
+
     if( d->writerRunning ) {
         //
         // we will handle cleanup in slotWriterFinished()
@@ -570,7 +580,9 @@ bool K3b::CdCopyJob::prepareImageFiles()
     }
     else {
         // we only need a single image file
+        // an image with a rescue map is continued instead of overwritten
         if( !fi.isFile() ||
+            ( m_rescueMode && QFile::exists( m_tempPath + ".map" ) ) ||
             questionYesNo( i18n("Do you want to overwrite %1?",m_tempPath),
                            i18n("File Exists") ) ) {
             if( fi.isDir() )
@@ -627,7 +639,7 @@ void K3b::CdCopyJob::readNextSession()
         d->audioSessionReader->setReadRetries( m_audioReadRetries );
         d->audioSessionReader->setNeverSkip( !m_ignoreAudioReadErrors );
         if( m_onTheFly )
-            d->audioSessionReader->writeTo( d->cdrecordWriter->ioDevice() );
+            d->audioSessionReader->writeTo( onTheFlyDevice() );
         else
             d->audioSessionReader->setImageNames( d->imageNames );  // the audio tracks are always the first tracks
 
@@ -648,6 +660,7 @@ void K3b::CdCopyJob::readNextSession()
         d->dataTrackReader->setDevice( m_readerDevice );
         d->dataTrackReader->setIgnoreErrors( m_ignoreDataReadErrors );
         d->dataTrackReader->setNoCorrection( m_noCorrection );
+        d->dataTrackReader->setRescueMode( m_rescueMode && ( !m_onTheFly || m_onlyCreateImages ) );
         d->dataTrackReader->setRetries( m_dataReadRetries );
         if( m_onlyCreateImages )
             d->dataTrackReader->setSectorSize( K3b::DataTrackReader::MODE1 );
@@ -677,7 +690,7 @@ void K3b::CdCopyJob::readNextSession()
             trackNum = d->toc.count();
 
         if( m_onTheFly )
-            d->dataTrackReader->writeTo( d->cdrecordWriter->ioDevice() );
+            d->dataTrackReader->writeTo( onTheFlyDevice() );
         else
             d->dataTrackReader->setImagePath( d->imageNames[trackNum-1] );
 
@@ -690,6 +703,19 @@ void K3b::CdCopyJob::readNextSession()
 }
 
 
+QIODevice* K3b::CdCopyJob::onTheFlyDevice()
+{
+    delete d->prefetchBuffer;
+
+    // cdrecord knows the size of the tracks, no need to close its stdin
+    d->prefetchBuffer = createPrefetchBuffer( d->cdrecordWriter, false );
+    if( d->prefetchBuffer && d->prefetchBuffer->open() )
+        return d->prefetchBuffer;
+
+    return d->cdrecordWriter->ioDevice();
+}
+
+
 bool K3b::CdCopyJob::writeNextSession()
 {
     // we emit our own task since the cdrecord task is way too simple
@@ -967,6 +993,14 @@ void K3b::CdCopyJob::slotSessionReaderFinished( bool success )
 {
     d->audioReaderRunning = d->dataReaderRunning = false;
 
+    // the writer gets the remaining data from the buffer
+    if( d->prefetchBuffer ) {
+        if( success )
+            d->prefetchBuffer->close();
+        else
+            d->prefetchBuffer->abort();
+    }
+
     if( success ) {
         if( d->numSessions > 1 )
             emit infoMessage( i18n("Successfully read session %1.",d->currentReadSession), MessageSuccess );
@@ -1102,16 +1136,22 @@ void K3b::CdCopyJob::slotMediaReloadedForNextSession( K3b::Device::DeviceHandler
 
 void K3b::CdCopyJob::cleanup()
 {
-    if( m_onTheFly || !m_keepImage || ((d->canceled || d->error) && !d->readingSuccessful) ) {
+    // a failed rescue leaves the images and the maps behind to be continued later
+    const bool readingFailed = ( d->canceled || d->error ) && !d->readingSuccessful;
+    const bool removeImages = ( readingFailed ? !m_rescueMode : !m_keepImage );
+
+    if( m_onTheFly || removeImages ) {
         emit infoMessage( i18n("Removing temporary files."), MessageInfo );
         for( QStringList::iterator it = d->infNames.begin(); it != d->infNames.end(); ++it )
             QFile::remove( *it );
     }
 
-    if( !m_onTheFly && (!m_keepImage || ((d->canceled || d->error) && !d->readingSuccessful)) ) {
+    if( !m_onTheFly && removeImages ) {
         emit infoMessage( i18n("Removing image files."), MessageInfo );
-        for( QStringList::iterator it = d->imageNames.begin(); it != d->imageNames.end(); ++it )
+        for( QStringList::iterator it = d->imageNames.begin(); it != d->imageNames.end(); ++it ) {
             QFile::remove( *it );
+            QFile::remove( *it + ".map" );
+        }
 
         // remove the tempdir created in prepareImageFiles()
         if( d->deleteTempDir ) {
@@ -16,6 +16,8 @@
 
 #include <KCDDB/KCDDB>
 
+class QIODevice;
+
 namespace K3b {
     namespace Device {
         class Device;
@@ -66,6 +68,13 @@ namespace K3b {
         void setCopyCdText( bool b ) { m_copyCdText = b; }
         void setNoCorrection( bool b ) { m_noCorrection = b; }
 
+        /**
+         * Read the data tracks in rescue mode (see DataTrackReader::setRescueMode()).
+         * Only used when the images are written to disk. Reading continues from the
+         * rescue map next to the images if they have been kept from a former run.
+         */
+        void setRescueMode( bool b ) { m_rescueMode = b; }
+
     private Q_SLOTS:
         void slotDiskInfoReady( K3b::Device::DeviceHandler* );
         void slotCdTextReady( K3b::Device::DeviceHandler* );
@@ -86,6 +95,7 @@ namespace K3b {
         void queryCddb();
         bool writeNextSession();
         void readNextSession();
+        QIODevice* onTheFlyDevice();
         bool prepareImageFiles();
         void cleanup();
         void finishJob( bool canceled, bool error );
@@ -102,6 +112,7 @@ namespace K3b {
         bool m_ignoreDataReadErrors;
         bool m_ignoreAudioReadErrors;
         bool m_noCorrection;
+        bool m_rescueMode;
         int m_dataReadRetries;
         int m_audioReadRetries;
         bool m_copyCdText;
@@ -7,20 +7,353 @@
 #include "k3blibdvdcss.h"
 #include "k3bdevice.h"
 #include "k3bdeviceglobals.h"
+#include "k3breadqueue.h"
 #include "k3btrack.h"
 #include "k3bthread.h"
 #include "k3bcore.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QSaveFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
 
 #include <unistd.h>
 
 
 
-// FIXME: determine max DMA buffer size
-static int s_bufferSizeSectors = 10;
+
+namespace {
+    //
+    // Buffers are acquired and filled by the reading thread and written
+    // in the same order by the WriterThread.
+    //
+    class BufferRing
+    {
+    public:
+        BufferRing( int count, int bufferSize )
+            : m_count( count ),
+              m_bufferSize( bufferSize ),
+              m_data( new unsigned char[count*bufferSize] ),
+              m_lengths( count ),
+              m_acquired( 0 ),
+              m_committed( 0 ),
+              m_released( 0 ),
+              m_finished( false ),
+              m_aborted( false ) {
+        }
+
+        ~BufferRing() {
+            delete [] m_data;
+        }
+
+        /**
+         * \return The next free buffer or 0 if the ring has been aborted.
+         */
+        unsigned char* acquire() {
+            QMutexLocker locker( &m_mutex );
+            while( !m_aborted && m_acquired - m_released >= m_count )
+                m_condition.wait( &m_mutex );
+            if( m_aborted )
+                return 0;
+            return buffer( m_acquired++ );
+        }
+
+        /**
+         * Hands the oldest acquired buffer with @p len bytes of data to the writer.
+         */
+        void commit( int len ) {
+            QMutexLocker locker( &m_mutex );
+            m_lengths[m_committed % m_count] = len;
+            ++m_committed;
+            m_condition.wakeAll();
+        }
+
+        void finish() {
+            QMutexLocker locker( &m_mutex );
+            m_finished = true;
+            m_condition.wakeAll();
+        }
+
+        void abort() {
+            QMutexLocker locker( &m_mutex );
+            m_aborted = true;
+            m_condition.wakeAll();
+        }
+
+        /**
+         * \return The oldest committed buffer or 0 once all data has been written.
+         */
+        unsigned char* next( int* len ) {
+            QMutexLocker locker( &m_mutex );
+            while( !m_aborted && !m_finished && m_released == m_committed )
+                m_condition.wait( &m_mutex );
+            if( m_aborted || m_released == m_committed )
+                return 0;
+            *len = m_lengths[m_released % m_count];
+            return buffer( m_released );
+        }
+
+        void release() {
+            QMutexLocker locker( &m_mutex );
+            ++m_released;
+            m_condition.wakeAll();
+        }
+
+    private:
+        unsigned char* buffer( qint64 index ) const {
+            return &m_data[( index % m_count ) * m_bufferSize];
+        }
+
+        const int m_count;
+        const int m_bufferSize;
+        unsigned char* m_data;
+        QVector<int> m_lengths;
+        qint64 m_acquired;
+        qint64 m_committed;
+        qint64 m_released;
+        bool m_finished;
+        bool m_aborted;
+        QMutex m_mutex;
+        QWaitCondition m_condition;
+    };
+
+
+    class WriterThread : public QThread
+    {
+    public:
+        WriterThread( BufferRing* ring, QIODevice* dev )
+            : m_ring( ring ),
+              m_device( dev ),
+              m_bytesWritten( 0 ),
+              m_error( false ) {
+        }
+
+        qint64 bytesWritten() const { return m_bytesWritten; }
+        bool error() const { return m_error; }
+
+    protected:
+        void run() override {
+            int len = 0;
+            while( unsigned char* buffer = m_ring->next( &len ) ) {
+                if( m_device->write( reinterpret_cast<char*>( buffer ), len ) != len ) {
+                    m_error = true;
+                    m_ring->abort();
+                    return;
+                }
+                m_bytesWritten += len;
+                m_ring->release();
+            }
+        }
+
+    private:
+        BufferRing* m_ring;
+        QIODevice* m_device;
+        qint64 m_bytesWritten;
+        bool m_error;
+    };
+
+
+    struct ReadRequest {
+        unsigned char* buffer;
+        int sector;
+        int sectors;
+        bool queued;
+    };
+
+
+    //
+    // The state of every sector of a rescue read. The ranges are sorted and
+    // cover the whole sector range without gaps.
+    //
+    // The map is saved as text in the style of a ddrescue mapfile:
+    //
+    //   # K3b rescue map
+    //   # <first sector> <last sector> <sector size> <block size>
+    //   <start> <length> <state>
+    //
+    class RescueMap
+    {
+    public:
+        enum State {
+            Untried = '?',  // not read yet
+            Failed = '*',   // failed with a block size bigger than one sector
+            Bad = '-',      // the single sector could not be read
+            Good = '+'
+        };
+
+        struct Range {
+            unsigned long start;
+            unsigned long length;
+            State state;
+        };
+
+        void init( unsigned long first, unsigned long last ) {
+            m_ranges.clear();
+            m_counts.clear();
+            const Range r = { first, last - first + 1, Untried };
+            insert( r );
+        }
+
+        void mark( unsigned long start, unsigned long length, State state ) {
+            const unsigned long end = start + length;
+            split( start );
+            split( end );
+
+            QMap<unsigned long, Range>::iterator it = m_ranges.lowerBound( start );
+            while( it != m_ranges.end() && it->start < end ) {
+                m_counts[it->state] -= it->length;
+                it = m_ranges.erase( it );
+            }
+
+            const Range marked = { start, length, state };
+            insert( marked );
+        }
+
+        /**
+         * Find the first sectors in @p state at or after @p from.
+         */
+        bool find( State state, unsigned long from, Range& range ) const {
+            QMap<unsigned long, Range>::const_iterator it = m_ranges.upperBound( from );
+            if( it != m_ranges.constBegin() )
+                --it;
+            for( ; it != m_ranges.constEnd(); ++it ) {
+                const Range& r = it.value();
+                if( r.state == state && r.start + r.length > from ) {
+                    range = r;
+                    if( range.start < from ) {
+                        range.length -= from - range.start;
+                        range.start = from;
+                    }
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        unsigned long count( State state ) const {
+            return m_counts.value( state );
+        }
+
+        // bad sectors get another chance with every run
+        void retryBad() {
+            QList<Range> bad;
+            Q_FOREACH( const Range& r, m_ranges ) {
+                if( r.state == Bad )
+                    bad.append( r );
+            }
+            Q_FOREACH( const Range& r, bad )
+                mark( r.start, r.length, Failed );
+        }
+
+        bool load( const QString& path, unsigned long first, unsigned long last, int sectorSize, int& blockSize ) {
+            QFile f( path );
+            if( !f.open( QIODevice::ReadOnly ) )
+                return false;
+
+            QTextStream s( &f );
+            QString line = s.readLine();
+            if( line != QLatin1String( "# K3b rescue map" ) )
+                return false;
+            const QStringList header = s.readLine().split( ' ', Qt::SkipEmptyParts );
+            if( header.count() != 5 ||
+                header[1].toULong() != first ||
+                header[2].toULong() != last ||
+                header[3].toInt() != sectorSize )
+                return false;
+            blockSize = qMax( 1, header[4].toInt() );
+
+            m_ranges.clear();
+            m_counts.clear();
+            unsigned long next = first;
+            while( !( line = s.readLine() ).isNull() ) {
+                const QStringList fields = line.split( ' ', Qt::SkipEmptyParts );
+                if( fields.isEmpty() || fields[0].startsWith( '#' ) )
+                    continue;
+                if( fields.count() != 3 || fields[2].length() != 1 )
+                    return false;
+                bool ok1 = false, ok2 = false;
+                const Range r = { fields[0].toULong( &ok1 ), fields[1].toULong( &ok2 ),
+                                  State( fields[2].at( 0 ).toLatin1() ) };
+                if( !ok1 || !ok2 || r.start != next || r.length == 0 ||
+                    ( r.state != Untried && r.state != Failed && r.state != Bad && r.state != Good ) ) {
+                    init( first, last );
+                    return false;
+                }
+                insert( r );
+                next = r.start + r.length;
+            }
+            if( next != last + 1 ) {
+                init( first, last );
+                return false;
+            }
+
+            return true;
+        }
+
+        bool save( const QString& path, unsigned long first, unsigned long last, int sectorSize, int blockSize ) const {
+            QSaveFile f( path );
+            if( !f.open( QIODevice::WriteOnly ) )
+                return false;
+
+            QTextStream s( &f );
+            s << "# K3b rescue map" << '\n'
+              << "# " << first << ' ' << last << ' ' << sectorSize << ' ' << blockSize << '\n';
+            Q_FOREACH( const Range& r, m_ranges )
+                s << r.start << ' ' << r.length << ' ' << char( r.state ) << '\n';
+            s.flush();
+            return f.commit();
+        }
+
+    private:
+        // makes sure a range starts at @p pos
+        void split( unsigned long pos ) {
+            QMap<unsigned long, Range>::iterator it = m_ranges.upperBound( pos );
+            if( it == m_ranges.begin() )
+                return;
+            --it;
+            const Range r = it.value();
+            if( r.start < pos && r.start + r.length > pos ) {
+                it->length = pos - r.start;
+                const Range after = { pos, r.start + r.length - pos, r.state };
+                m_ranges.insert( pos, after );
+            }
+        }
+
+        // puts @p r into a gap and merges it with its neighbours in the same state
+        void insert( Range r ) {
+            m_counts[r.state] += r.length;
+
+            QMap<unsigned long, Range>::iterator next = m_ranges.lowerBound( r.start );
+            if( next != m_ranges.end() && next->state == r.state && next->start == r.start + r.length ) {
+                r.length += next->length;
+                next = m_ranges.erase( next );
+            }
+            if( next != m_ranges.begin() ) {
+                QMap<unsigned long, Range>::iterator prev = next;
+                --prev;
+                if( prev->state == r.state && prev->start + prev->length == r.start ) {
+                    prev->length += r.length;
+                    return;
+                }
+            }
+            m_ranges.insert( r.start, r );
+        }
+
+        // the ranges by their first sector
+        QMap<unsigned long, Range> m_ranges;
+        QHash<int, unsigned long> m_counts;
+    };
+}
 
 
 class K3b::DataTrackReader::Private
@@ -31,7 +364,14 @@ public:
 
     bool ignoreReadErrors;
     bool noCorrection;
+    bool rescueMode;
     int retries;
+    int queueDepth;
+
+    // the transfer size shrinks around read errors and grows back afterwards
+    int maxTransferSectors;
+    int transferSectors;
+    int successfulReads;
     K3b::Device::Device* device;
     K3b::Msf firstSector;
     K3b::Msf lastSector;
@@ -53,9 +393,12 @@ public:
 K3b::DataTrackReader::Private::Private()
     : ignoreReadErrors(false),
       noCorrection(false),
+      rescueMode(false),
       retries(10),
+      queueDepth(4),
       device(0),
       ioDevice(0),
+      sectorSize(AUTO),
       libcss(0)
 {
 }
@@ -113,6 +456,18 @@ void K3b::DataTrackReader::setNoCorrection( bool b )
 }
 
 
+void K3b::DataTrackReader::setRescueMode( bool b )
+{
+    d->rescueMode = b;
+}
+
+
+void K3b::DataTrackReader::setQueueDepth( int depth )
+{
+    d->queueDepth = depth;
+}
+
+
 void K3b::DataTrackReader::writeTo( QIODevice* ioDev )
 {
     d->ioDevice = ioDev;
@@ -219,10 +574,19 @@ bool K3b::DataTrackReader::run()
                           .arg( d->lastSector.lba() - d->firstSector.lba() + 1 )
                           .arg( quint64(d->usedSectorSize) * (quint64)(d->lastSector.lba() - d->firstSector.lba() + 1) ) );
 
+    if( d->rescueMode && d->ioDevice ) {
+        d->device->close();
+        if( d->useLibdvdcss )
+            d->libcss->close();
+        emit infoMessage( i18n("Rescue mode needs an image file."), K3b::Job::MessageError );
+        return false;
+    }
+
     QFile file;
     if( !d->ioDevice ) {
         file.setFileName( d->imagePath );
-        if( !file.open( QIODevice::WriteOnly ) ) {
+        // in rescue mode the sectors read in former runs are kept
+        if( !file.open( d->rescueMode ? QIODevice::ReadWrite : QIODevice::WriteOnly ) ) {
             d->device->close();
             if( d->useLibdvdcss )
                 d->libcss->close();
@@ -245,87 +609,125 @@ bool K3b::DataTrackReader::run()
     //
     d->device->setSpeed( 0xffff, 0xffff );
 
-#ifdef Q_OS_NETBSD
-    s_bufferSizeSectors = 31;
-#else
-    s_bufferSizeSectors = 128;
-#endif
-    unsigned char* buffer = new unsigned char[d->usedSectorSize*s_bufferSizeSectors];
-    while( s_bufferSizeSectors > 0 && read( buffer, d->firstSector.lba(), s_bufferSizeSectors ) < 0 ) {
-        qDebug() << "(K3b::DataTrackReader) determine max read sectors: "
-                 << s_bufferSizeSectors << " too high." << Qt::endl;
-        s_bufferSizeSectors /= 2;
-    }
-    qDebug() << "(K3b::DataTrackReader) determine max read sectors: "
-             << s_bufferSizeSectors << " is max." << Qt::endl;
+    d->maxTransferSectors = qMax( 1, d->device->maxTransferLength() / d->usedSectorSize );
+    d->transferSectors = d->maxTransferSectors;
+    d->successfulReads = 0;
+
+    qDebug() << "(K3b::DataTrackReader) using buffer size of " << d->maxTransferSectors << " blocks.";
+    emit debuggingOutput( "K3b::DataTrackReader", QString("using buffer size of %1 blocks.").arg( d->maxTransferSectors ) );
+
+    if( d->rescueMode ) {
+        const bool success = rescue( file );
 
-    //    s_bufferSizeSectors = K3b::Device::determineMaxReadingBufferSize( d->device, d->firstSector );
-    if( s_bufferSizeSectors <= 0 ) {
-        emit infoMessage( i18n("Error while reading sector %1.",d->firstSector.lba()), K3b::Job::MessageError );
+        setErrorRecovery( d->device, d->oldErrorRecoveryMode );
         d->device->block( false );
         k3bcore->unblockDevice( d->device );
-        return false;
+        if( d->useLibdvdcss )
+            d->libcss->close();
+        d->device->close();
+
+        return success;
     }
 
-    qDebug() << "(K3b::DataTrackReader) using buffer size of " << s_bufferSizeSectors << " blocks.";
-    emit debuggingOutput( "K3b::DataTrackReader", QString("using buffer size of %1 blocks.").arg( s_bufferSizeSectors ) );
+    //
+    // Keep several read commands in flight if possible. libdvdcss does its own reading.
+    //
+    K3b::Device::ReadQueue queue( d->device );
+    bool useQueue = ( !d->useLibdvdcss && d->queueDepth > 1 && queue.open( d->queueDepth ) );
+    bool queueVerified = false;
+    if( useQueue )
+        emit debuggingOutput( "K3b::DataTrackReader", QString("using %1 queued read commands.").arg( queue.depth() ) );
+
+    //
+    // The data is written in a separate thread while the next sectors are read
+    //
+    const int bufferLen = d->maxTransferSectors*d->usedSectorSize;
+    BufferRing ring( qMax( 4, 2*queue.depth() ), bufferLen );
+    WriterThread writer( &ring, d->ioDevice ? d->ioDevice : &file );
+    writer.start();
 
     // 2. get it on
     K3b::Msf currentSector = d->firstSector;
+    K3b::Msf nextRequestSector = d->firstSector;
     K3b::Msf totalReadSectors;
+    QQueue<ReadRequest> requests;
     d->nextReadSector = 0;
     d->errorSectorCount = 0;
-    bool writeError = false;
     bool readError = false;
     int lastPercent = 0;
     unsigned long lastReadMb = 0;
-    int bufferLen = s_bufferSizeSectors*d->usedSectorSize;
-    while( !canceled() && currentSector <= d->lastSector ) {
-
-        int maxReadSectors = qMin( bufferLen/d->usedSectorSize, d->lastSector.lba()-currentSector.lba()+1 );
+    while( !canceled() ) {
 
-        int readSectors = read( buffer,
-                                currentSector.lba(),
-                                maxReadSectors );
-        if( readSectors < 0 ) {
-            if( !retryRead( buffer,
-                            currentSector.lba(),
-                            maxReadSectors ) ) {
-                readError = true;
-                break;
+        //
+        // request as many sectors as the queue allows
+        //
+        while( requests.count() < ( useQueue ? queue.depth() : 1 ) && nextRequestSector <= d->lastSector ) {
+            ReadRequest request;
+            request.buffer = ring.acquire();
+            if( !request.buffer )
+                break; // the writer failed
+            request.sector = nextRequestSector.lba();
+            request.sectors = qMin( d->transferSectors, d->lastSector.lba()-nextRequestSector.lba()+1 );
+            request.queued = false;
+            if( useQueue ) {
+                request.queued = queueRead( queue, request.buffer, request.sector, request.sectors );
+                if( !request.queued ) {
+                    qDebug() << "(K3b::DataTrackReader) queued reading failed. Falling back to synchronous reading.";
+                    useQueue = false;
+                }
             }
-            else
-                readSectors = maxReadSectors;
+            requests.enqueue( request );
+            nextRequestSector += request.sectors;
         }
 
-        totalReadSectors += readSectors;
+        if( requests.isEmpty() )
+            break;
 
-        int readBytes = readSectors * d->usedSectorSize;
+        ReadRequest request = requests.dequeue();
 
-        if( d->ioDevice ) {
-            if( d->ioDevice->write( reinterpret_cast<char*>(buffer ), readBytes ) != readBytes ) {
-                qDebug() << "(K3b::DataTrackReader::WorkThread) error while writing to dev " << d->ioDevice
-                         << " current sector: " << (currentSector.lba()-d->firstSector.lba()) << Qt::endl;
-                emit debuggingOutput( "K3b::DataTrackReader",
-                                      QString("Error while writing to IO device. Current sector is %2.")
-                                      .arg(currentSector.lba()-d->firstSector.lba()) );
-                writeError = true;
-                break;
+        int readSectors = -1;
+        if( request.queued ) {
+            if( queue.waitForCompletion() ) {
+                readSectors = request.sectors;
+                queueVerified = true;
+            }
+            else if( !queueVerified ) {
+                // the generic device might not handle our buffer size. Do not blame the medium for it.
+                qDebug() << "(K3b::DataTrackReader) queued reading failed. Falling back to synchronous reading.";
+                useQueue = false;
+                readSectors = read( request.buffer, request.sector, request.sectors );
             }
         }
         else {
-            if( file.write( reinterpret_cast<char*>(buffer), readBytes ) != readBytes ) {
-                qDebug() << "(K3b::DataTrackReader::WorkThread) error while writing to file " << d->imagePath
-                         << " current sector: " << (currentSector.lba()-d->firstSector.lba()) << Qt::endl;
-                emit debuggingOutput( "K3b::DataTrackReader",
-                                      QString("Error while writing to file %1. Current sector is %2.")
-                                      .arg(d->imagePath).arg(currentSector.lba()-d->firstSector.lba()) );
-                writeError = true;
+            readSectors = read( request.buffer, request.sector, request.sectors );
+        }
+
+        if( readSectors < 0 ) {
+            if( !readErrorRegion( request.buffer,
+                                  request.sector,
+                                  request.sectors ) ) {
+                readError = true;
                 break;
             }
+            else
+                readSectors = request.sectors;
+        }
+        else if( d->transferSectors < d->maxTransferSectors && ++d->successfulReads >= 8 ) {
+            // we are past the error region
+            d->transferSectors = qMin( 2*d->transferSectors, d->maxTransferSectors );
+            d->successfulReads = 0;
         }
 
-        currentSector += readSectors;
+        // libdvdcss may return less sectors than requested. Synchronous requests are never
+        // followed by other requests so we simply continue after the last sector read.
+        if( !request.queued )
+            nextRequestSector = request.sector + readSectors;
+
+        ring.commit( readSectors * d->usedSectorSize );
+
+        totalReadSectors += readSectors;
+
+        currentSector = request.sector + readSectors;
 
         int currentPercent = 100 * (currentSector.lba() - d->firstSector.lba() + 1 ) /
                              (d->lastSector.lba() - d->firstSector.lba() + 1 );
@@ -342,6 +744,35 @@ bool K3b::DataTrackReader::run()
         }
     }
 
+    // wait for the commands in flight before the buffers go away
+    queue.close();
+
+    // on cancellation there is no point in writing the remaining buffers
+    if( canceled() )
+        ring.abort();
+    else
+        ring.finish();
+    writer.wait();
+
+    bool writeError = writer.error();
+    if( writeError ) {
+        const qint64 writtenSectors = writer.bytesWritten() / d->usedSectorSize;
+        if( d->ioDevice ) {
+            qDebug() << "(K3b::DataTrackReader::WorkThread) error while writing to dev " << d->ioDevice
+                     << " current sector: " << writtenSectors << Qt::endl;
+            emit debuggingOutput( "K3b::DataTrackReader",
+                                  QString("Error while writing to IO device. Current sector is %2.")
+                                  .arg(writtenSectors) );
+        }
+        else {
+            qDebug() << "(K3b::DataTrackReader::WorkThread) error while writing to file " << d->imagePath
+                     << " current sector: " << writtenSectors << Qt::endl;
+            emit debuggingOutput( "K3b::DataTrackReader",
+                                  QString("Error while writing to file %1. Current sector is %2.")
+                                  .arg(d->imagePath).arg(writtenSectors) );
+        }
+    }
+
     if( d->errorSectorCount > 0 )
         emit infoMessage( i18np("Ignored %1 erroneous sector.", "Ignored a total of %1 erroneous sectors.", d->errorSectorCount ),
                           K3b::Job::MessageError );
@@ -356,7 +787,6 @@ bool K3b::DataTrackReader::run()
     if( d->useLibdvdcss )
         d->libcss->close();
     d->device->close();
-    delete [] buffer;
 
     emit debuggingOutput( "K3b::DataTrackReader",
                           QString("Read a total of %1 sectors (%2 bytes)")
@@ -408,6 +838,63 @@ int K3b::DataTrackReader::read( unsigned char* buffer, unsigned long sector, uns
 }
 
 
+bool K3b::DataTrackReader::queueRead( Device::ReadQueue& queue, unsigned char* buffer, unsigned long sector, unsigned int len )
+{
+    if( d->usedSectorSize == 2048 )
+        return queue.submitRead10( buffer, len*2048, sector, len );
+    else
+        return queue.submitReadCd( buffer,
+                                   len*d->usedSectorSize,
+                                   0,     // all sector types
+                                   false, // no dap
+                                   sector,
+                                   len,
+                                   false, // no sync
+                                   false, // no header
+                                   d->usedSectorSize != MODE1,  // subheader
+                                   true,  // user data
+                                   false, // no edc/ecc
+                                   0,     // no c2 error info
+                                   0      // no subchannel data
+            );
+}
+
+
+// read the sectors of a failed request in smaller parts down to single sectors
+bool K3b::DataTrackReader::readErrorRegion( unsigned char* buffer, unsigned long startSector, unsigned int len )
+{
+    d->successfulReads = 0;
+    d->transferSectors = qMax( 1, qMin<int>( d->transferSectors, len ) / 2 );
+
+    emit debuggingOutput( "K3b::DataTrackReader",
+                          QString( "Read error at sector %1. Reducing transfer size to %2 sectors." )
+                          .arg( startSector ).arg( d->transferSectors ) );
+
+    unsigned int pos = 0;
+    while( pos < len ) {
+        if( canceled() )
+            return false;
+
+        int sectors = qMin<int>( d->transferSectors, len - pos );
+        int readSectors = read( &buffer[pos * d->usedSectorSize], startSector + pos, sectors );
+        if( readSectors > 0 ) {
+            pos += readSectors;
+        }
+        else if( d->transferSectors > 1 ) {
+            d->transferSectors /= 2;
+        }
+        else if( retryRead( &buffer[pos * d->usedSectorSize], startSector + pos, 1 ) ) {
+            ++pos;
+        }
+        else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
 // here we read every single sector for itself to find the troubling ones
 bool K3b::DataTrackReader::retryRead( unsigned char* buffer, unsigned long startSector, unsigned int len )
 {
@@ -447,6 +934,167 @@ bool K3b::DataTrackReader::retryRead( unsigned char* buffer, unsigned long start
 }
 
 
+//
+// Reading in the style of ddrescue: the first pass reads the untried sectors
+// with the maximum transfer size and skips ahead after read errors, the
+// further the more errors follow each other. The skipped sectors are read in
+// a second pass without skipping. The blocks which failed are then read in
+// passes with halved block sizes until single sectors remain.
+//
+bool K3b::DataTrackReader::rescue( QFile& image )
+{
+    const unsigned long first = d->firstSector.lba();
+    const unsigned long last = d->lastSector.lba();
+    const unsigned long total = last - first + 1;
+    const QString mapPath = d->imagePath + ".map";
+
+    RescueMap map;
+    int blockSize = 0;
+    if( image.size() == qint64( total ) * d->usedSectorSize &&
+        map.load( mapPath, first, last, d->usedSectorSize, blockSize ) ) {
+        map.retryBad();
+        emit infoMessage( i18n("Continuing the rescue from %1.", mapPath), K3b::Job::MessageInfo );
+    }
+    else {
+        map.init( first, last );
+        blockSize = qMax( 1, d->maxTransferSectors / 2 );
+        if( !image.resize( qint64( total ) * d->usedSectorSize ) ) {
+            emit infoMessage( i18n("Unable to open '%1' for writing.",d->imagePath), K3b::Job::MessageError );
+            return false;
+        }
+    }
+
+    emit debuggingOutput( "K3b::DataTrackReader",
+                          QString( "Rescue reading: %1 untried, %2 failed, %3 good sectors." )
+                          .arg( map.count( RescueMap::Untried ) )
+                          .arg( map.count( RescueMap::Failed ) )
+                          .arg( map.count( RescueMap::Good ) ) );
+
+    QVector<unsigned char> buffer( d->maxTransferSectors * d->usedSectorSize );
+    const unsigned long maxSkip = qMax<unsigned long>( d->maxTransferSectors, total / 100 );
+    QElapsedTimer saveTimer;
+    saveTimer.start();
+    int lastPercent = -1;
+    bool writeError = false;
+
+    for( int pass = 1; !canceled() && !writeError; ++pass ) {
+        RescueMap::State state = ( map.count( RescueMap::Untried ) > 0 ? RescueMap::Untried : RescueMap::Failed );
+        if( state == RescueMap::Failed && map.count( RescueMap::Failed ) == 0 )
+            break;
+
+        const bool skipping = ( pass == 1 );
+        const int len = ( state == RescueMap::Untried ? d->maxTransferSectors : blockSize );
+        emit debuggingOutput( "K3b::DataTrackReader",
+                              QString( "Rescue pass %1: reading %2 sectors with block size %3." )
+                              .arg( pass ).arg( map.count( state ) ).arg( len ) );
+
+        unsigned long skip = 0;
+        unsigned long pos = first;
+        RescueMap::Range range;
+        while( !canceled() && map.find( state, pos, range ) ) {
+            const unsigned int sectors = qMin<unsigned long>( len, range.length );
+            int readSectors = rescueRead( image, buffer.data(), range.start, sectors );
+
+            // single sectors get the configured number of retries
+            for( int retry = 1; readSectors == 0 && sectors == 1 && state == RescueMap::Failed &&
+                     retry < d->retries && !canceled(); ++retry )
+                readSectors = rescueRead( image, buffer.data(), range.start, 1 );
+
+            if( readSectors < 0 ) {
+                writeError = true;
+                break;
+            }
+            else if( readSectors > 0 ) {
+                map.mark( range.start, readSectors, RescueMap::Good );
+                pos = range.start + readSectors;
+                skip = 0;
+            }
+            else if( sectors == 1 && state == RescueMap::Failed ) {
+                map.mark( range.start, 1, RescueMap::Bad );
+                pos = range.start + 1;
+            }
+            else {
+                map.mark( range.start, sectors, RescueMap::Failed );
+                pos = range.start + sectors;
+                if( skipping && state == RescueMap::Untried ) {
+                    // the skipped sectors stay untried for the next pass
+                    skip = ( skip == 0 ? sectors : qMin( 2*skip, maxSkip ) );
+                    pos += skip;
+                }
+            }
+
+            const unsigned long done = map.count( RescueMap::Good ) + map.count( RescueMap::Bad );
+            const int currentPercent = quint64( 100 ) * done / total;
+            if( currentPercent > lastPercent ) {
+                lastPercent = currentPercent;
+                emit percent( currentPercent );
+                emit processedSize( done / 512, total / 512 );
+            }
+
+            if( saveTimer.elapsed() > 10000 ) {
+                map.save( mapPath, first, last, d->usedSectorSize, blockSize );
+                saveTimer.restart();
+            }
+        }
+
+        // the next pass over the failed blocks halves the block size
+        if( !canceled() && !writeError && state == RescueMap::Failed ) {
+            if( blockSize == 1 )
+                break;
+            blockSize = qMax( 1, blockSize / 2 );
+        }
+    }
+
+    if( !map.save( mapPath, first, last, d->usedSectorSize, blockSize ) )
+        emit infoMessage( i18n("Unable to save the rescue map %1.", mapPath), K3b::Job::MessageWarning );
+
+    if( writeError ) {
+        emit infoMessage( i18n("Error while writing to file %1.", d->imagePath), K3b::Job::MessageError );
+        return false;
+    }
+
+    if( canceled() )
+        return false;
+
+    const unsigned long badSectors = map.count( RescueMap::Bad );
+    emit debuggingOutput( "K3b::DataTrackReader",
+                          QString( "Rescue reading finished: %1 good and %2 bad sectors." )
+                          .arg( map.count( RescueMap::Good ) ).arg( badSectors ) );
+
+    if( badSectors > 0 ) {
+        d->errorSectorCount = badSectors;
+        if( d->ignoreReadErrors ) {
+            emit infoMessage( i18np("Ignored %1 erroneous sector.", "Ignored a total of %1 erroneous sectors.", badSectors ),
+                              K3b::Job::MessageError );
+        }
+        else {
+            emit infoMessage( i18np("%1 sector could not be read. Start the rescue again to retry it.",
+                                    "%1 sectors could not be read. Start the rescue again to retry them.", badSectors ),
+                              K3b::Job::MessageError );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+// \return the number of sectors read, 0 on read errors, and -1 on write errors
+int K3b::DataTrackReader::rescueRead( QFile& image, unsigned char* buffer, unsigned long sector, unsigned int len )
+{
+    const int readSectors = read( buffer, sector, len );
+    if( readSectors <= 0 )
+        return 0;
+
+    const qint64 bytes = qint64( readSectors ) * d->usedSectorSize;
+    if( !image.seek( qint64( sector - d->firstSector.lba() ) * d->usedSectorSize ) ||
+        image.write( reinterpret_cast<char*>( buffer ), bytes ) != bytes )
+        return -1;
+
+    return readSectors;
+}
+
+
 bool K3b::DataTrackReader::setErrorRecovery( K3b::Device::Device* dev, int code )
 {
     Device::UByteArray data;
@@ -9,12 +9,15 @@
 
 #include "k3bglobals.h"
 #include "k3bmsf.h"
+#include "k3b_export.h"
 
+class QFile;
 class QIODevice;
 
 namespace K3b {
     namespace Device {
         class Device;
+        class ReadQueue;
     }
 
     /**
@@ -29,7 +32,7 @@ namespace K3b {
      *
      * Formless Mode2 sectors will not be read.
      */
-    class DataTrackReader : public ThreadJob
+    class LIBK3B_EXPORT DataTrackReader : public ThreadJob
     {
         Q_OBJECT
 
@@ -65,13 +68,44 @@ namespace K3b {
 
         void setNoCorrection( bool b );
 
+        /**
+         * The number of read commands which are kept in flight. Reading and
+         * writing the data happens in separate threads connected through a
+         * ring of buffers anyway. With a depth bigger than one the drive also
+         * receives the next commands while the previous ones are processed.
+         *
+         * Queued reading is only available on Linux. Otherwise or if the
+         * drive does not support it the sectors are read one command at a time.
+         *
+         * Default is 4.
+         */
+        void setQueueDepth( int depth );
+
+        /**
+         * In rescue mode areas with read errors are skipped first and read
+         * again in later passes with decreasing block sizes. The state of all
+         * sectors is saved in a map next to the image (the image path with
+         * the suffix ".map") and a new run with the same image and sector
+         * range continues from the map. Sectors which could not be read are
+         * tried again in every run.
+         *
+         * Rescue mode needs an image path (setImagePath()).
+         *
+         * Default is false.
+         */
+        void setRescueMode( bool b );
+
         void writeTo( QIODevice* ioDev );
 
     private:
         bool run() override;
 
         int read( unsigned char* buffer, unsigned long sector, unsigned int len );
+        bool queueRead( Device::ReadQueue& queue, unsigned char* buffer, unsigned long sector, unsigned int len );
+        bool readErrorRegion( unsigned char* buffer, unsigned long startSector, unsigned int len );
         bool retryRead( unsigned char* buffer, unsigned long startSector, unsigned int len );
+        bool rescue( QFile& image );
+        int rescueRead( QFile& image, unsigned char* buffer, unsigned long sector, unsigned int len );
         bool setErrorRecovery( Device::Device* dev, int code );
 
         class Private;
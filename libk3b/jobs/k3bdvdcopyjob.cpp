@@ -23,6 +23,8 @@
 #include "k3biso9660.h"
 #include "k3bfilesplitter.h"
 #include "k3bchecksumpipe.h"
+#include "k3bfanoutbuffer.h"
+#include "k3bprefetchbuffer.h"
 #include "k3bverificationjob.h"
 #include "k3bglobalsettings.h"
 #include "k3b_i18n.h"
@@ -46,10 +48,63 @@ public:
           dataTrackReader(0),
           verificationJob(0),
           usedWritingMode(K3b::WritingModeAuto),
-          verifyData(false) {
+          verifyData(false),
+          writeImageDirectly(false),
+          parallel(false),
+          prefetchBuffer(0) {
         outPipe.readFrom( &imageFile, true );
     }
 
+    ~Private() {
+        qDeleteAll( parallelWriters );
+        delete prefetchBuffer;
+    }
+
+    //
+    // One of the drives writing at the same time. In image mode every drive
+    // reads the image on its own, on-the-fly they share the fan-out buffer.
+    //
+    class ParallelWriter
+    {
+    public:
+        ParallelWriter( K3b::Device::Device* dev )
+            : device( dev ),
+              writerJob( 0 ),
+              verificationJob( 0 ),
+              running( false ),
+              verifying( false ),
+              success( false ),
+              writerPercent( 0 ),
+              verificationPercent( 0 ) {
+            outPipe.readFrom( &imageFile, true );
+        }
+
+        ~ParallelWriter() {
+            delete verificationJob;
+            delete writerJob;
+        }
+
+        K3b::Device::Device* device;
+        K3b::AbstractWriter* writerJob;
+        K3b::VerificationJob* verificationJob;
+        bool running;
+        bool verifying;
+        bool success;
+        int writerPercent;
+        int verificationPercent;
+
+        K3b::FileSplitter imageFile;
+        K3b::ActivePipe outPipe;
+    };
+
+    ParallelWriter* parallelWriter( QObject* job ) const {
+        Q_FOREACH( ParallelWriter* w, parallelWriters ) {
+            if( job && ( w->writerJob == job || w->verificationJob == job ) )
+                return w;
+        }
+        return 0;
+    }
+
     K3b::WritingApp usedWritingApp;
 
     int doneCopies;
@@ -75,6 +130,17 @@ public:
     K3b::ActivePipe outPipe;
 
     bool verifyData;
+
+    // the writing application reads the image file itself instead of its stdin
+    bool writeImageDirectly;
+
+    bool parallel;
+    QList<K3b::Device::Device*> additionalWriters;
+    QList<ParallelWriter*> parallelWriters;
+    K3b::FanOutBuffer fanOut;
+
+    // bridges read errors and slow sectors when copying on-the-fly to a single writer
+    K3b::PrefetchBuffer* prefetchBuffer;
 };
 
 
@@ -89,6 +155,7 @@ K3b::DvdCopyJob::DvdCopyJob( K3b::JobHandler* hdl, QObject* parent )
       m_copies(1),
       m_onlyCreateImage(false),
       m_ignoreReadErrors(false),
+      m_rescueMode(false),
       m_readRetries(128),
       m_writingMode( K3b::WritingModeAuto )
 {
@@ -110,6 +177,7 @@ void K3b::DvdCopyJob::start()
     d->canceled = false;
     d->running = true;
     d->readerRunning = d->writerRunning = false;
+    d->parallel = !d->additionalWriters.isEmpty() && !m_onlyCreateImage;
 
     emit newTask( i18n("Checking Source Medium") );
     const K3b::ExternalBin* growisofsBin = k3bcore->externalBinManager()->binObject("growisofs");
@@ -121,6 +189,17 @@ void K3b::DvdCopyJob::start()
         emit infoMessage( i18n("Disabling on-the-fly writing."), MessageInfo );
     }
 
+    if( m_rescueMode ) {
+        if( m_onTheFly ) {
+            m_onTheFly = false;
+            emit infoMessage( i18n("Rescue mode needs an image file. Disabling on-the-fly writing."), MessageInfo );
+        }
+        if( d->verifyData && !m_onlyCreateImage ) {
+            d->verifyData = false;
+            emit infoMessage( i18n("Copies of a medium read in rescue mode cannot be verified."), MessageWarning );
+        }
+    }
+
     emit newSubTask( i18n("Waiting for source medium") );
 
     // wait for a source disk
@@ -232,7 +311,10 @@ void K3b::DvdCopyJob::slotDiskInfoReady( K3b::Device::DeviceHandler* dh )
             if( !m_onlyCreateImage ) {
                 if( dh->diskInfo().numLayers() > 1 &&
                     dh->diskInfo().size() > MediaSizeDvd4Gb ) {
-                    if( !(m_writerDevice->type() & (K3b::Device::DEVICE_DVD_R_DL|K3b::Device::DEVICE_DVD_PLUS_R_DL)) ) {
+                    bool writersSupportDl = ( m_writerDevice->type() & (K3b::Device::DEVICE_DVD_R_DL|K3b::Device::DEVICE_DVD_PLUS_R_DL) );
+                    Q_FOREACH( K3b::Device::Device* dev, d->additionalWriters )
+                        writersSupportDl = writersSupportDl && ( dev->type() & (K3b::Device::DEVICE_DVD_R_DL|K3b::Device::DEVICE_DVD_PLUS_R_DL) );
+                    if( !writersSupportDl ) {
                         emit infoMessage( i18n("The writer does not support writing Double Layer DVDs."), MessageError );
                         d->running = false;
                         jobFinished(false);
@@ -313,8 +395,10 @@ void K3b::DvdCopyJob::slotDiskInfoReady( K3b::Device::DeviceHandler* dh )
             //
             // Check the image path
             //
+            // an image with a rescue map is continued instead of overwritten
             QFileInfo fi( m_imagePath );
             if( !fi.isFile() ||
+                ( m_rescueMode && QFile::exists( m_imagePath + ".map" ) ) ||
                 questionYesNo( i18n("Do you want to overwrite %1?",m_imagePath),
                                i18n("File Exists") ) ) {
                 if( fi.isDir() )
@@ -355,8 +439,9 @@ void K3b::DvdCopyJob::slotDiskInfoReady( K3b::Device::DeviceHandler* dh )
                 }
             }
 
+            // in rescue mode the reader writes the image itself
             d->imageFile.setName( m_imagePath );
-            if( !d->imageFile.open( QIODevice::WriteOnly ) ) {
+            if( !m_rescueMode && !d->imageFile.open( QIODevice::WriteOnly ) ) {
                 emit infoMessage( i18n("Unable to open '%1' for writing.",m_imagePath), MessageError );
                 jobFinished( false );
                 d->running = false;
@@ -373,7 +458,16 @@ void K3b::DvdCopyJob::slotDiskInfoReady( K3b::Device::DeviceHandler* dh )
             emit newTask( i18n("Creating image") );
         }
         else if( m_onTheFly && !m_onlyCreateImage ) {
-            if( waitForDvd() ) {
+            if( d->parallel ) {
+                if( !startParallelWriters() ) {
+                    if( d->canceled )
+                        emit canceled();
+                    jobFinished(false);
+                    d->running = false;
+                    return;
+                }
+            }
+            else if( waitForDvd( m_writerDevice ) ) {
                 prepareWriter();
                 if( m_simulate )
                     emit newTask( i18n("Simulating copy") );
@@ -412,6 +506,17 @@ void K3b::DvdCopyJob::cancel()
             d->writerJob->cancel();
         if ( d->verificationJob && d->verificationJob->active() )
             d->verificationJob->cancel();
+        Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+            if( w->running )
+                w->writerJob->cancel();
+            if( w->verificationJob && w->verificationJob->active() )
+                w->verificationJob->cancel();
+            if( w->writerJob )
+                d->fanOut.dropSink( w->writerJob->ioDevice() );
+            w->outPipe.close();
+        }
+        if( d->prefetchBuffer )
+            d->prefetchBuffer->abort();
         d->inPipe.close();
         d->outPipe.close();
         d->imageFile.close();
@@ -439,8 +544,24 @@ void K3b::DvdCopyJob::prepareReader()
     d->dataTrackReader->setIgnoreErrors( m_ignoreReadErrors );
     d->dataTrackReader->setRetries( m_readRetries );
     d->dataTrackReader->setSectorRange( 0, d->lastSector );
+    d->dataTrackReader->setRescueMode( m_rescueMode );
+
+    delete d->prefetchBuffer;
+    d->prefetchBuffer = 0;
 
-    if( m_onTheFly && !m_onlyCreateImage )
+    // the sectors are not read in order, thus there is nothing to pipe
+    if( m_rescueMode ) {
+        d->dataTrackReader->setImagePath( m_imagePath );
+        return;
+    }
+    if( m_onTheFly && !m_onlyCreateImage && !d->parallel )
+        d->prefetchBuffer = createPrefetchBuffer( d->writerJob, d->usedWritingApp == K3b::WritingAppGrowisofs );
+
+    if( m_onTheFly && !m_onlyCreateImage && d->parallel )
+        d->inPipe.writeTo( &d->fanOut, true );
+    else if( d->prefetchBuffer )
+        d->inPipe.writeTo( d->prefetchBuffer, true );
+    else if( m_onTheFly && !m_onlyCreateImage )
         // there are several uses of pipe->writeTo( d->writerJob->ioDevice(), ... ) in this file!
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
@@ -449,6 +570,7 @@ void K3b::DvdCopyJob::prepareReader()
     else
         d->inPipe.writeTo( &d->imageFile, true );
 
+    d->inPipe.setExtentSize( K3b::VerificationJob::defaultExtentSize() );
     d->inPipe.open( true );
     d->dataTrackReader->writeTo( &d->inPipe );
 }
@@ -459,8 +581,31 @@ void K3b::DvdCopyJob::prepareWriter()
 {
     delete d->writerJob;
 
+    d->writerJob = createWriter( m_writerDevice );
+
+    connect( d->writerJob, SIGNAL(infoMessage(QString,int)), this, SIGNAL(infoMessage(QString,int)) );
+    connect( d->writerJob, SIGNAL(percent(int)), this, SLOT(slotWriterProgress(int)) );
+    connect( d->writerJob, SIGNAL(processedSize(int,int)), this, SIGNAL(processedSize(int,int)) );
+    connect( d->writerJob, SIGNAL(processedSubSize(int,int)), this, SIGNAL(processedSubSize(int,int)) );
+    connect( d->writerJob, SIGNAL(buffer(int)), this, SIGNAL(bufferStatus(int)) );
+    connect( d->writerJob, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
+    connect( d->writerJob, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
+    connect( d->writerJob, SIGNAL(finished(bool)), this, SLOT(slotWriterFinished(bool)) );
+    //  connect( d->writerJob, SIGNAL(newTask(QString)), this, SIGNAL(newTask(QString)) );
+    connect( d->writerJob, SIGNAL(newSubTask(QString)), this, SIGNAL(newSubTask(QString)) );
+    connect( d->writerJob, SIGNAL(debuggingOutput(QString,QString)),
+             this, SIGNAL(debuggingOutput(QString,QString)) );
+}
+
+
+// ALWAYS CALL WAITFORDVD BEFORE CREATEWRITER! It determines the writing mode.
+K3b::AbstractWriter* K3b::DvdCopyJob::createWriter( K3b::Device::Device* writerDevice )
+{
+    // split images still need to be joined by the FileSplitter
+    d->writeImageDirectly = !m_onTheFly && !K3b::FileSplitter( m_imagePath ).isSplit();
+
     if ( d->usedWritingApp == K3b::WritingAppGrowisofs ) {
-        K3b::GrowisofsWriter* job = new K3b::GrowisofsWriter( m_writerDevice, this, this );
+        K3b::GrowisofsWriter* job = new K3b::GrowisofsWriter( writerDevice, this, this );
 
         // these do only make sense with DVD-R(W)
         job->setSimulate( m_simulate );
@@ -481,37 +626,29 @@ void K3b::DvdCopyJob::prepareWriter()
             job->setTrackSize( d->lastSector.lba()+1 );
         }
 
-        job->setImageToWrite( QString() ); // write to stdin
+        if( d->writeImageDirectly )
+            job->setImageToWrite( m_imagePath );
+        else
+            job->setImageToWrite( QString() ); // write to stdin
 
-        d->writerJob = job;
+        return job;
     }
 
     else {
-        K3b::CdrecordWriter* writer = new K3b::CdrecordWriter( m_writerDevice, this, this );
+        K3b::CdrecordWriter* writer = new K3b::CdrecordWriter( writerDevice, this, this );
 
         writer->setWritingMode( d->usedWritingMode );
         writer->setSimulate( m_simulate );
         writer->setBurnSpeed( m_speed );
 
         writer->addArgument( "-data" );
-        writer->addArgument( QString("-tsize=%1s").arg( d->lastSector.lba()+1 ) )->addArgument("-");
+        if( d->writeImageDirectly )
+            writer->addArgument( m_imagePath );
+        else
+            writer->addArgument( QString("-tsize=%1s").arg( d->lastSector.lba()+1 ) )->addArgument("-");
 
-        d->writerJob = writer;
+        return writer;
     }
-
-
-    connect( d->writerJob, SIGNAL(infoMessage(QString,int)), this, SIGNAL(infoMessage(QString,int)) );
-    connect( d->writerJob, SIGNAL(percent(int)), this, SLOT(slotWriterProgress(int)) );
-    connect( d->writerJob, SIGNAL(processedSize(int,int)), this, SIGNAL(processedSize(int,int)) );
-    connect( d->writerJob, SIGNAL(processedSubSize(int,int)), this, SIGNAL(processedSubSize(int,int)) );
-    connect( d->writerJob, SIGNAL(buffer(int)), this, SIGNAL(bufferStatus(int)) );
-    connect( d->writerJob, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
-    connect( d->writerJob, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
-    connect( d->writerJob, SIGNAL(finished(bool)), this, SLOT(slotWriterFinished(bool)) );
-    //  connect( d->writerJob, SIGNAL(newTask(QString)), this, SIGNAL(newTask(QString)) );
-    connect( d->writerJob, SIGNAL(newSubTask(QString)), this, SIGNAL(newSubTask(QString)) );
-    connect( d->writerJob, SIGNAL(debuggingOutput(QString,QString)),
-             this, SIGNAL(debuggingOutput(QString,QString)) );
 }
 
 
@@ -520,7 +657,7 @@ void K3b::DvdCopyJob::slotReaderProgress( int p )
     if( !m_onTheFly || m_onlyCreateImage ) {
         emit subPercent( p );
 
-        int bigParts = ( m_onlyCreateImage ? 1 : (m_simulate ? 2 : ( d->verifyData ? m_copies*2 : m_copies ) + 1 ) );
+        int bigParts = ( m_onlyCreateImage ? 1 : d->parallel ? 2 : (m_simulate ? 2 : ( d->verifyData ? m_copies*2 : m_copies ) + 1 ) );
         emit percent( p/bigParts );
     }
 }
@@ -563,7 +700,9 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
         return;
 
     if( d->canceled ) {
-        removeImageFiles();
+        // keep the image and the map to continue the rescue later
+        if( !m_rescueMode )
+            removeImageFiles();
         emit canceled();
         jobFinished(false);
         d->running = false;
@@ -576,7 +715,7 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
             d->running = false;
         }
         else {
-            if( m_writerDevice == m_readerDevice ) {
+            if( m_writerDevice == m_readerDevice || d->additionalWriters.contains( m_readerDevice ) ) {
                 // eject the media (we do this blocking to know if it worked
                 // because if it did not it might happen that k3b overwrites a CD-RW
                 // source)
@@ -586,11 +725,27 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
                 }
             }
 
-            if( !m_onTheFly ) {
+            if( m_onTheFly && d->parallel ) {
+                // let the writers know that there is no more data
+                d->inPipe.close();
+            }
+            else if( !m_onTheFly && d->parallel ) {
+                d->imageFile.close();
+
+                if( !startParallelWriters() ) {
+                    if( m_removeImageFiles )
+                        removeImageFiles();
+                    if( d->canceled )
+                        emit canceled();
+                    jobFinished(false);
+                    d->running = false;
+                }
+            }
+            else if( !m_onTheFly ) {
 
                 d->imageFile.close();
 
-                if( waitForDvd() ) {
+                if( waitForDvd( m_writerDevice ) ) {
                     prepareWriter();
                     if( m_copies > 1 )
                         emit newTask( i18n("Writing copy %1",d->doneCopies+1) );
@@ -601,11 +756,13 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
 
                     d->writerRunning = true;
                     d->writerJob->start();
+                    if( !d->writeImageDirectly ) {
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
-                    d->outPipe.writeTo( d->writerJob->ioDevice(), d->usedWritingApp == K3b::WritingAppGrowisofs );
-                    d->outPipe.open( true );
+                        d->outPipe.writeTo( d->writerJob->ioDevice(), d->usedWritingApp == K3b::WritingAppGrowisofs );
+                        d->outPipe.open( true );
+                    }
                 }
                 else {
                     if( m_removeImageFiles )
@@ -619,7 +776,13 @@ void K3b::DvdCopyJob::slotReaderFinished( bool success )
         }
     }
     else {
-        removeImageFiles();
+        // the parallel writers would wait for data forever
+        Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+            if( w->running )
+                w->writerJob->cancel();
+        }
+        if( !m_rescueMode )
+            removeImageFiles();
         jobFinished(false);
         d->running = false;
     }
@@ -663,7 +826,9 @@ void K3b::DvdCopyJob::slotWriterFinished( bool success )
 
             }
             d->verificationJob->setDevice( m_writerDevice );
-            d->verificationJob->addTrack( 1, d->inPipe.checksum(), d->lastSector+1 );
+            d->verificationJob->addTrack( 1, d->inPipe.checksum(),
+                                          d->inPipe.extentChecksums(), d->inPipe.extentSize(),
+                                          d->lastSector+1 );
 
             if( m_copies > 1 )
                 emit newTask( i18n("Verifying copy %1",d->doneCopies+1) );
@@ -681,7 +846,7 @@ void K3b::DvdCopyJob::slotWriterFinished( bool success )
                 blockingInformation( i18n("K3b was unable to eject the written medium. Please do so manually.") );
             }
 
-            if( waitForDvd() ) {
+            if( waitForDvd( m_writerDevice ) ) {
                 prepareWriter();
                 emit newTask( i18n("Writing copy %1",d->doneCopies+1) );
 
@@ -703,7 +868,7 @@ void K3b::DvdCopyJob::slotWriterFinished( bool success )
                 d->readerRunning = true;
                 d->dataTrackReader->start();
             }
-            else {
+            else if( !d->writeImageDirectly ) {
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
@@ -741,7 +906,7 @@ void K3b::DvdCopyJob::slotVerificationFinished( bool success )
     // job already emits a message
     else if( ++d->doneCopies < m_copies ) {
 
-        if( waitForDvd() ) {
+        if( waitForDvd( m_writerDevice ) ) {
             prepareWriter();
             emit newTask( i18n("Writing copy %1",d->doneCopies+1) );
 
@@ -763,7 +928,7 @@ void K3b::DvdCopyJob::slotVerificationFinished( bool success )
             d->readerRunning = true;
             d->dataTrackReader->start();
         }
-        else {
+        else if( !d->writeImageDirectly ) {
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
@@ -780,9 +945,217 @@ void K3b::DvdCopyJob::slotVerificationFinished( bool success )
 }
 
 
+bool K3b::DvdCopyJob::startParallelWriters()
+{
+    qDeleteAll( d->parallelWriters );
+    d->parallelWriters.clear();
+    d->fanOut.clearSinks();
+
+    const QList<K3b::Device::Device*> writers = QList<K3b::Device::Device*>() << m_writerDevice << d->additionalWriters;
+
+    //
+    // Wait for all media before starting any of the writers. Otherwise the first
+    // drives might run out of data while the user is still inserting discs.
+    //
+    Q_FOREACH( K3b::Device::Device* dev, writers ) {
+        if( !waitForDvd( dev ) )
+            return false;
+
+        Private::ParallelWriter* w = new Private::ParallelWriter( dev );
+        w->writerJob = createWriter( dev );
+        d->parallelWriters.append( w );
+
+        connect( w->writerJob, SIGNAL(infoMessage(QString,int)), this, SLOT(slotParallelWriterInfoMessage(QString,int)) );
+        connect( w->writerJob, SIGNAL(percent(int)), this, SLOT(slotParallelWriterProgress(int)) );
+        connect( w->writerJob, SIGNAL(finished(bool)), this, SLOT(slotParallelWriterFinished(bool)) );
+        connect( w->writerJob, SIGNAL(debuggingOutput(QString,QString)),
+                 this, SIGNAL(debuggingOutput(QString,QString)) );
+    }
+
+    // the progress dialog only shows the buffers of one writer
+    K3b::AbstractWriter* firstWriter = d->parallelWriters.first()->writerJob;
+    connect( firstWriter, SIGNAL(buffer(int)), this, SIGNAL(bufferStatus(int)) );
+    connect( firstWriter, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
+    connect( firstWriter, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
+
+    if( m_simulate )
+        emit newTask( i18np("Simulating copy on 1 drive", "Simulating copies on %1 drives", writers.count()) );
+    else
+        emit newTask( i18np("Writing copy on 1 drive", "Writing copies on %1 drives", writers.count()) );
+
+    emit burning(true);
+
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        w->running = true;
+        w->writerJob->start();
+
+        // on-the-fly the reader feeds all writers through the fan-out buffer,
+        // otherwise every writer reads the image at its own pace
+        if( m_onTheFly ) {
+            d->fanOut.addSink( w->writerJob->ioDevice(), d->usedWritingApp == K3b::WritingAppGrowisofs );
+        }
+        else if( !d->writeImageDirectly ) {
+            w->imageFile.setName( m_imagePath );
+            w->outPipe.writeTo( w->writerJob->ioDevice(), d->usedWritingApp == K3b::WritingAppGrowisofs );
+            w->outPipe.open( true );
+        }
+    }
+
+    return true;
+}
+
+
+void K3b::DvdCopyJob::slotParallelWriterInfoMessage( const QString& message, int type )
+{
+    if( Private::ParallelWriter* w = d->parallelWriter( sender() ) )
+        emit infoMessage( QString( "%1: %2" ).arg( w->device->blockDeviceName() ).arg( message ), type );
+    else
+        emit infoMessage( message, type );
+}
+
+
+void K3b::DvdCopyJob::slotParallelWriterProgress( int p )
+{
+    if( Private::ParallelWriter* w = d->parallelWriter( sender() ) ) {
+        w->writerPercent = p;
+        updateParallelProgress();
+    }
+}
+
+
+void K3b::DvdCopyJob::slotParallelVerificationProgress( int p )
+{
+    if( Private::ParallelWriter* w = d->parallelWriter( sender() ) ) {
+        w->verificationPercent = p;
+        updateParallelProgress();
+    }
+}
+
+
+void K3b::DvdCopyJob::updateParallelProgress()
+{
+    if( d->parallelWriters.isEmpty() )
+        return;
+
+    int sum = 0;
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        if( d->verifyData && !m_simulate )
+            sum += ( w->writerPercent + w->verificationPercent )/2;
+        else
+            sum += w->writerPercent;
+    }
+    const int p = sum / d->parallelWriters.count();
+
+    // in image mode reading the source was the first half
+    emit subPercent( p );
+    emit percent( m_onTheFly ? p : 50 + p/2 );
+}
+
+
+void K3b::DvdCopyJob::slotParallelWriterFinished( bool success )
+{
+    Private::ParallelWriter* w = d->parallelWriter( sender() );
+    if( !w )
+        return;
+
+    w->running = false;
+    w->writerPercent = 100;
+
+    // a failed drive must not hold back the others
+    if( !success )
+        d->fanOut.dropSink( w->writerJob->ioDevice() );
+
+    // already finished?
+    if( !d->running )
+        return;
+
+    if( success && !d->canceled ) {
+        emit infoMessage( i18n("Successfully written copy on %1.", w->device->blockDeviceName()), MessageInfo );
+
+        if( d->verifyData && !m_simulate ) {
+            w->verificationJob = new K3b::VerificationJob( this, this );
+            connect( w->verificationJob, SIGNAL(infoMessage(QString,int)),
+                     this, SLOT(slotParallelWriterInfoMessage(QString,int)) );
+            connect( w->verificationJob, SIGNAL(percent(int)),
+                     this, SLOT(slotParallelVerificationProgress(int)) );
+            connect( w->verificationJob, SIGNAL(finished(bool)),
+                     this, SLOT(slotParallelVerificationFinished(bool)) );
+            connect( w->verificationJob, SIGNAL(debuggingOutput(QString,QString)),
+                     this, SIGNAL(debuggingOutput(QString,QString)) );
+
+            w->verificationJob->setDevice( w->device );
+            w->verificationJob->addTrack( 1, d->inPipe.checksum(),
+                                          d->inPipe.extentChecksums(), d->inPipe.extentSize(),
+                                          d->lastSector+1 );
+            w->verifying = true;
+            w->verificationJob->start();
+            return;
+        }
+
+        w->success = true;
+    }
+    else if( !d->canceled ) {
+        emit infoMessage( i18n("Writing the copy on %1 failed.", w->device->blockDeviceName()), MessageError );
+    }
+
+    finishParallelWriting();
+}
+
+
+void K3b::DvdCopyJob::slotParallelVerificationFinished( bool success )
+{
+    Private::ParallelWriter* w = d->parallelWriter( sender() );
+    if( !w )
+        return;
+
+    w->verifying = false;
+    w->verificationPercent = 100;
+    w->success = success;
+
+    finishParallelWriting();
+}
+
+
+void K3b::DvdCopyJob::finishParallelWriting()
+{
+    if( !d->running )
+        return;
+
+    int succeeded = 0;
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        if( w->running || w->verifying )
+            return;
+        if( w->success )
+            ++succeeded;
+    }
+
+    emit burning(false);
+
+    if( !d->canceled && k3bcore->globalSettings()->ejectMedia() ) {
+        Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters )
+            K3b::Device::eject( w->device );
+    }
+
+    if( m_removeImageFiles )
+        removeImageFiles();
+
+    d->running = false;
+
+    if( d->canceled ) {
+        emit canceled();
+        jobFinished( false );
+    }
+    else {
+        if( succeeded < d->parallelWriters.count() )
+            emit infoMessage( i18n("Only %1 of %2 copies have been written successfully.", succeeded, d->parallelWriters.count()), MessageError );
+        jobFinished( succeeded == d->parallelWriters.count() );
+    }
+}
+
+
 // this is basically the same code as in K3b::DvdJob... :(
 // perhaps this should be moved to some K3b::GrowisofsHandler which also parses the growisofs output?
-bool K3b::DvdCopyJob::waitForDvd()
+bool K3b::DvdCopyJob::waitForDvd( K3b::Device::Device* writerDevice )
 {
     if ( !K3b::Device::isDvdMedia( d->sourceDiskInfo.mediaType() ) &&
          !K3b::Device::isBdMedia( d->sourceDiskInfo.mediaType() ) ) {
@@ -791,7 +1164,7 @@ bool K3b::DvdCopyJob::waitForDvd()
         return false;
     }
 
-    Device::MediaType m = waitForMedium( m_writerDevice,
+    Device::MediaType m = waitForMedium( writerDevice,
                                          K3b::Device::STATE_EMPTY,
                                          Device::MEDIA_WRITABLE_DVD|Device::MEDIA_WRITABLE_BD,
                                          d->sourceDiskInfo.size() );
@@ -835,12 +1208,12 @@ bool K3b::DvdCopyJob::waitForDvd()
         // DVD Minus
         // -------------------------------
         else if ( m & K3b::Device::MEDIA_DVD_MINUS_ALL ) {
-            if( m_simulate && !m_writerDevice->dvdMinusTestwrite() ) {
+            if( m_simulate && !writerDevice->dvdMinusTestwrite() ) {
                 if( !questionYesNo( i18n("Your writer (%1 %2) does not support simulation with DVD-R(W) media. "
                                          "Do you really want to continue? The media will actually be "
                                          "written to.",
-                                         m_writerDevice->vendor(),
-                                         m_writerDevice->description()),
+                                         writerDevice->vendor(),
+                                         writerDevice->description()),
                                     i18n("No Simulation with DVD-R(W)") ) ) {
                     cancel();
                     return false;
@@ -933,6 +1306,7 @@ void K3b::DvdCopyJob::removeImageFiles()
         d->imageFile.remove();
         emit infoMessage( i18n("Removed image file %1",m_imagePath), K3b::Job::MessageSuccess );
     }
+    QFile::remove( m_imagePath + ".map" );
 }
 
 
@@ -952,6 +1326,11 @@ QString K3b::DvdCopyJob::jobDescription() const
 
 QString K3b::DvdCopyJob::jobDetails() const
 {
+    if( !d->additionalWriters.isEmpty() && !m_onlyCreateImage )
+        return i18np("Creating 1 copy",
+                     "Creating %1 copies",
+                     d->additionalWriters.count()+1 );
+
     return i18np("Creating 1 copy",
                  "Creating %1 copies",
                  (m_simulate||m_onlyCreateImage) ? 1 : m_copies );
@@ -981,4 +1360,10 @@ void K3b::DvdCopyJob::setVerifyData( bool b )
     d->verifyData = b;
 }
 
+
+void K3b::DvdCopyJob::setAdditionalWriterDevices( const QList<K3b::Device::Device*>& devs )
+{
+    d->additionalWriters = devs;
+}
+
 #include "moc_k3bdvdcopyjob.cpp"
@@ -11,6 +11,7 @@
 
 #include "k3bjob.h"
 #include "k3b_export.h"
+#include <QList>
 #include <QString>
 
 
@@ -20,6 +21,8 @@ namespace K3b {
         class DeviceHandler;
     }
 
+    class AbstractWriter;
+
 
     class LIBK3B_EXPORT DvdCopyJob : public BurnJob
     {
@@ -56,6 +59,26 @@ namespace K3b {
         void setReadRetries( int i ) { m_readRetries = i; }
         void setVerifyData( bool b );
 
+        /**
+         * Read the source medium in rescue mode (see DataTrackReader::setRescueMode()).
+         * Rescue mode always writes an image. If reading fails the image and its
+         * rescue map are kept and a new job with the same image path continues
+         * the rescue.
+         *
+         * There are no checksums of an image read in rescue mode, thus the copies
+         * cannot be verified.
+         */
+        void setRescueMode( bool b ) { m_rescueMode = b; }
+
+        /**
+         * Write a copy on each of these drives at the same time as on the writer
+         * device. All drives are fed from the same image or on-the-fly stream and
+         * every copy is verified on its own drive.
+         *
+         * In this mode every drive writes exactly one copy, setCopies() is ignored.
+         */
+        void setAdditionalWriterDevices( const QList<K3b::Device::Device*>& devs );
+
     private Q_SLOTS:
         void slotDiskInfoReady( K3b::Device::DeviceHandler* );
         void slotReaderProgress( int );
@@ -66,10 +89,20 @@ namespace K3b {
         void slotVerificationFinished( bool );
         void slotVerificationProgress( int p );
 
+        void slotParallelWriterInfoMessage( const QString& message, int type );
+        void slotParallelWriterProgress( int p );
+        void slotParallelWriterFinished( bool success );
+        void slotParallelVerificationProgress( int p );
+        void slotParallelVerificationFinished( bool success );
+
     private:
-        bool waitForDvd();
+        bool waitForDvd( Device::Device* writer );
         void prepareReader();
         void prepareWriter();
+        AbstractWriter* createWriter( Device::Device* writer );
+        bool startParallelWriters();
+        void updateParallelProgress();
+        void finishParallelWriting();
         void removeImageFiles();
 
         Device::Device* m_writerDevice;
@@ -84,6 +117,7 @@ namespace K3b {
         int m_copies;
         bool m_onlyCreateImage;
         bool m_ignoreReadErrors;
+        bool m_rescueMode;
         int m_readRetries;
 
         WritingMode m_writingMode;
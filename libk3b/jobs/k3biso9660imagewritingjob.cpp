@@ -36,6 +36,7 @@ public:
     K3b::FileSplitter imageFile;
 
     bool isDvdImage;
+    bool writeImageDirectly;
     int currentCopy;
     bool canceled;
     bool finished;
@@ -58,6 +59,7 @@ K3b::Iso9660ImageWritingJob::Iso9660ImageWritingJob( K3b::JobHandler* hdl )
     d = new Private;
     d->verifyJob = 0;
     d->writer = 0;
+    d->writeImageDirectly = false;
 }
 
 
@@ -124,7 +126,9 @@ void K3b::Iso9660ImageWritingJob::slotWriterJobFinished( bool success )
             }
             d->verifyJob->setDevice( m_device );
             d->verifyJob->clear();
-            d->verifyJob->addTrack( 1, d->checksumPipe.checksum(), K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048 );
+            d->verifyJob->addTrack( 1, d->checksumPipe.checksum(),
+                                    d->checksumPipe.extentChecksums(), d->checksumPipe.extentSize(),
+                                    K3b::imageFilesize( QUrl::fromLocalFile(m_imagePath) )/2048 );
 
             if( m_copies == 1 )
                 emit newTask( i18n("Verifying written data") );
@@ -265,21 +269,32 @@ void K3b::Iso9660ImageWritingJob::startWriting()
         return;
     }
 
-    // we simply always calculate the checksum, thus making the code simpler
+    // The checksum is only needed for the verification. Without it the writing
+    // application reads the image itself instead of us pumping it through its stdin.
+    // Split images have to be joined by the FileSplitter though.
+    d->writeImageDirectly = ( m_simulate || !m_verifyData ) && !K3b::FileSplitter( m_imagePath ).isSplit();
+
     d->imageFile.close();
-    d->imageFile.setName( m_imagePath );
-    d->imageFile.open( QIODevice::ReadOnly );
     d->checksumPipe.close();
-    d->checksumPipe.readFrom( &d->imageFile, true );
+    if( !d->writeImageDirectly ) {
+        d->imageFile.setName( m_imagePath );
+        d->imageFile.open( QIODevice::ReadOnly );
+        d->checksumPipe.readFrom( &d->imageFile, true );
+    }
 
     if( prepareWriter() ) {
         emit burning(true);
         d->writer->start();
+        if( !d->writeImageDirectly ) {
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
-        d->checksumPipe.writeTo( d->writer->ioDevice(), d->writer->usedWritingApp() == K3b::WritingAppGrowisofs );
-        d->checksumPipe.open( K3b::ChecksumPipe::MD5, true );
+            d->checksumPipe.writeTo( d->writer->ioDevice(),
+                                     d->writer->usedWritingApp() == K3b::WritingAppGrowisofs ||
+                                     d->writer->usedWritingApp() == K3b::WritingAppNative );
+            d->checksumPipe.setExtentSize( K3b::VerificationJob::defaultExtentSize() );
+            d->checksumPipe.open( K3b::ChecksumPipe::MD5, true );
+        }
     }
     else {
         d->finished = true;
@@ -308,7 +323,7 @@ bool K3b::Iso9660ImageWritingJob::prepareWriter()
                           m_dataMode == K3b::DataMode2
                           ? Device::Track::XA_FORM2
                           : Device::Track::MODE1 );
-    d->writer->setSessionToWrite( toc );
+    d->writer->setSessionToWrite( toc, d->writeImageDirectly ? QStringList() << m_imagePath : QStringList() );
 
     connect( d->writer, SIGNAL(infoMessage(QString,int)), this, SIGNAL(infoMessage(QString,int)) );
     connect( d->writer, SIGNAL(nextTrack(int,int)), this, SLOT(slotNextTrack(int,int)) );
@@ -10,6 +10,7 @@
 #include "k3bcdrskinwriter.h"
 #include "k3bcdrdaowriter.h"
 #include "k3bgrowisofswriter.h"
+#include "k3bmmcwriter.h"
 #include "k3btocfilewriter.h"
 #include "k3binffilewriter.h"
 
@@ -134,6 +135,12 @@ QIODevice* K3b::MetaWriter::ioDevice() const
 }
 
 
+bool K3b::MetaWriter::reduceWriteSpeed()
+{
+    return d->writingJob && d->writingJob->reduceWriteSpeed();
+}
+
+
 void K3b::MetaWriter::start()
 {
     jobStarted();
@@ -166,6 +173,9 @@ void K3b::MetaWriter::start()
     case K3b::WritingAppCdrskin:
         success = setupCdrskinJob();
         break;
+    case K3b::WritingAppNative:
+        success = setupMmcJob();
+        break;
     default:
         Q_ASSERT(false);
         break;
@@ -276,6 +286,18 @@ bool K3b::MetaWriter::determineUsedAppAndMode()
     // Determine writing app
     // =============================================
 
+    if( d->writingApp == K3b::WritingAppNative &&
+        ( !d->cueFile.isEmpty() ||
+          d->toc.count() != 1 ||
+          d->toc.first().mode() != Device::Track::MODE1 ||
+          d->images.count() > 1 ||
+          d->layerBreak > 0 ||
+          !K3b::MmcWriter::canWrite( medium.diskInfo(), d->multiSession ) ) ) {
+        emit infoMessage( i18n( "Cannot write %1 media using %2. Falling back to default application.",
+                                K3b::Device::mediaTypeString( mediaType, true ), QLatin1String("native") ), MessageWarning );
+        d->writingApp = K3b::WritingAppAuto;
+    }
+
     d->usedWritingApp = d->writingApp;
     if( d->writingApp == K3b::WritingAppAuto ) {
         if( mediaType & Device::MEDIA_CD_ALL ) {
@@ -723,6 +745,26 @@ bool K3b::MetaWriter::setupGrowisofsob()
 }
 
 
+bool K3b::MetaWriter::setupMmcJob()
+{
+    K3b::MmcWriter* writer = new K3b::MmcWriter( burnDevice(), this, this );
+
+    writer->setSimulate( simulate() );
+    writer->setBurnSpeed( burnSpeed() );
+    writer->setWritingMode( d->usedWritingMode );
+    writer->setMultiSession( d->multiSession );
+    writer->setCloseDvd( !d->multiSession );
+    writer->setTrackSize( d->toc.first().length().lba() );
+
+    if( !d->images.isEmpty() )
+        writer->setImageToWrite( d->images.first() );
+
+    d->writingJob = writer;
+
+    return true;
+}
+
+
 bool K3b::MetaWriter::setupCdrskinJob()
 {
     K3b::CdrskinWriter* writer = new K3b::CdrskinWriter( burnDevice(), this, this );
@@ -16,7 +16,7 @@
 
 namespace K3b {
     /**
-     * Meta writer which wraps around the cdrecord, cdrdao, and growisofs writers.
+     * Meta writer which wraps around the cdrecord, cdrdao, growisofs, and native writers.
      * Its main use is to provide one consistent interface and keep all writing mode
      * selection and media requesting in one class.
      *
@@ -36,6 +36,7 @@ namespace K3b {
         ~MetaWriter() override;
 
         QIODevice* ioDevice() const override;
+        bool reduceWriteSpeed() override;
 
         /**
          * \return The writing app used after starting the job.
@@ -76,6 +77,7 @@ namespace K3b {
         bool setupCdrskinJob();
         bool setupCdrdaoJob();
         bool setupGrowisofsob();
+        bool setupMmcJob();
         bool startTrackWriting();
 
         void informUser();
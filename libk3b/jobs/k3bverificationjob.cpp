@@ -10,7 +10,9 @@
 
 #include "k3bdevice.h"
 #include "k3bdevicehandler.h"
+#include "k3bcore.h"
 #include "k3bglobals.h"
+#include "k3bglobalsettings.h"
 #include "k3bdatatrackreader.h"
 #include "k3bchecksumpipe.h"
 #include "k3biso9660.h"
@@ -18,25 +20,46 @@
 
 #include <QDebug>
 #include <QList>
+#include <QPair>
+#include <QRandomGenerator>
+#include <QStringList>
+
+#include <cmath>
 
 
 namespace {
+    const qint64 s_defaultExtentSize = 32*1024*1024;
+
+    // sampling searches for damage which affects at least this fraction of the extents
+    const double s_damagedFraction = 0.01;
+
+    // a range of extents, first and last
+    typedef QPair<int, int> ExtentRange;
+
     class TrackEntry
     {
     public:
         TrackEntry()
-            : trackNumber(0) {
+            : trackNumber(0),
+              extentSize(0) {
         }
 
         TrackEntry( int tn, const QByteArray& cs, const K3b::Msf& msf )
             : trackNumber(tn),
               checksum(cs),
+              extentSize(0),
               length(msf) {
         }
 
+        int extentSectors() const { return extentSize / 2048; }
+
         int trackNumber;
         QByteArray checksum;
+        QList<QByteArray> extentChecksums;
+        qint64 extentSize;
         mutable K3b::Msf length; // it's a cache, let's make it modifiable
+        mutable K3b::Msf dataLength; // the length of the verified data
+        mutable QList<ExtentRange> extentRanges; // the extents to be read
     };
 
     typedef QList<TrackEntry> TrackEntries;
@@ -58,12 +81,19 @@ public:
     Private( VerificationJob* job )
         : device(0),
           dataTrackReader(0),
+          confidence(0),
           q(job){
     }
 
     void reloadMedium();
     Msf trackLength( const TrackEntry& trackEntry );
 
+    // determines the extents to read and returns the number of sectors they cover
+    Msf prepareExtents( const TrackEntry& trackEntry );
+    Msf rangeSectors( const TrackEntry& trackEntry, const ExtentRange& range ) const;
+    void readExtentRange();
+    QString differingSectors() const;
+
     bool canceled;
     K3b::Device::Device* device;
 
@@ -81,6 +111,13 @@ public:
     K3b::Msf totalSectors;
     K3b::Msf alreadyReadSectors;
 
+    // the sector the verified data starts at
+    K3b::Msf dataStart;
+
+    int currentExtentRange;
+    QList<int> differingExtents;
+    int confidence;
+
     NullSinkChecksumPipe pipe;
 
     bool readSuccessful;
@@ -151,11 +188,136 @@ K3b::Msf K3b::VerificationJob::Private::trackLength( const TrackEntry& trackEntr
 }
 
 
+K3b::Msf K3b::VerificationJob::Private::prepareExtents( const TrackEntry& trackEntry )
+{
+    trackEntry.extentRanges.clear();
+
+    // in case a session was grown only the new session is verified
+    K3b::Msf length = trackLength( trackEntry );
+    if( diskInfo.mediaType() & (K3b::Device::MEDIA_DVD_PLUS_RW|K3b::Device::MEDIA_DVD_RW_OVWR) &&
+        grownSessionSize > 0 )
+        length = grownSessionSize;
+    trackEntry.dataLength = length;
+
+    if( trackEntry.extentChecksums.isEmpty() || trackEntry.extentSectors() <= 0 || length == 0 )
+        return trackLength( trackEntry );
+
+    const int extents = ( length.lba() + trackEntry.extentSectors() - 1 ) / trackEntry.extentSectors();
+    const QList<int> sample = VerificationJob::sampleExtents( extents, confidence );
+
+    // neighbouring extents are read in one go
+    K3b::Msf sectors;
+    Q_FOREACH( int extent, sample ) {
+        if( !trackEntry.extentRanges.isEmpty() && trackEntry.extentRanges.last().second == extent - 1 )
+            trackEntry.extentRanges.last().second = extent;
+        else
+            trackEntry.extentRanges.append( ExtentRange( extent, extent ) );
+    }
+    Q_FOREACH( const ExtentRange& range, trackEntry.extentRanges )
+        sectors += rangeSectors( trackEntry, range );
+
+    qDebug() << "(K3b::VerificationJob) reading" << sample.count() << "of" << extents << "extents of track" << trackEntry.trackNumber;
+
+    return sectors;
+}
+
+
+K3b::Msf K3b::VerificationJob::Private::rangeSectors( const TrackEntry& trackEntry, const ExtentRange& range ) const
+{
+    const int first = range.first * trackEntry.extentSectors();
+    const int end = qMin( ( range.second + 1 ) * trackEntry.extentSectors(), trackEntry.dataLength.lba() );
+    return end - first;
+}
+
+
+void K3b::VerificationJob::Private::readExtentRange()
+{
+    const TrackEntry& trackEntry = *currentTrackEntry;
+
+    if( trackEntry.extentRanges.isEmpty() ) {
+        pipe.setExtentSize( 0 );
+        dataTrackReader->setSectorRange( dataStart, dataStart + currentTrackSize - 1 );
+    }
+    else {
+        const ExtentRange& range = trackEntry.extentRanges[currentExtentRange];
+        const K3b::Msf first = dataStart + range.first * trackEntry.extentSectors();
+        pipe.setExtentSize( trackEntry.extentSize );
+        dataTrackReader->setSectorRange( first, first + rangeSectors( trackEntry, range ) - 1 );
+        currentTrackSize = rangeSectors( trackEntry, range );
+    }
+
+    pipe.open();
+    dataTrackReader->start();
+}
+
+
+QString K3b::VerificationJob::Private::differingSectors() const
+{
+    const TrackEntry& trackEntry = *currentTrackEntry;
+
+    QStringList ranges;
+    for( int i = 0; i < differingExtents.count(); ++i ) {
+        int last = i;
+        while( last+1 < differingExtents.count() && differingExtents[last+1] == differingExtents[last] + 1 )
+            ++last;
+
+        const int first = dataStart.lba() + differingExtents[i] * trackEntry.extentSectors();
+        const int end = dataStart.lba() + qMin( ( differingExtents[last] + 1 ) * trackEntry.extentSectors(),
+                                                trackEntry.dataLength.lba() );
+        ranges << QString( "%1-%2" ).arg( first ).arg( end - 1 );
+
+        i = last;
+    }
+
+    return ranges.join( ", " );
+}
+
+
 K3b::VerificationJob::VerificationJob( K3b::JobHandler* hdl, QObject* parent )
     : K3b::Job( hdl, parent )
 {
     d = new Private( this );
     d->currentTrackEntry = d->trackEntries.constEnd();
+    if( k3bcore->globalSettings()->sampledVerification() )
+        d->confidence = k3bcore->globalSettings()->verificationConfidence();
+}
+
+
+qint64 K3b::VerificationJob::defaultExtentSize()
+{
+    return s_defaultExtentSize;
+}
+
+
+QList<int> K3b::VerificationJob::sampleExtents( int extents, int confidence )
+{
+    //
+    // The number of samples needed to hit at least one damaged extent with the
+    // requested confidence. One extent is picked randomly from each stratum.
+    //
+    int samples = extents;
+    if( confidence > 0 && confidence < 100 )
+        samples = qMin( extents, int( ::ceil( ::log( 1.0 - confidence/100.0 ) / ::log( 1.0 - s_damagedFraction ) ) ) );
+
+    QList<int> sample;
+    if( samples >= extents ) {
+        for( int i = 0; i < extents; ++i )
+            sample.append( i );
+    }
+    else {
+        sample.append( 0 );
+        for( int i = 0; i < samples; ++i ) {
+            const int first = qint64( extents ) * i / samples;
+            const int next = qint64( extents ) * ( i + 1 ) / samples;
+            const int extent = first + QRandomGenerator::global()->bounded( qMax( 1, next - first ) );
+            if( extent != sample.last() )
+                sample.append( extent );
+        }
+        if( sample.last() != extents - 1 )
+            sample.append( extents - 1 );
+    }
+
+    return sample;
 }
 
 
@@ -184,6 +346,23 @@ void K3b::VerificationJob::addTrack( int trackNum, const QByteArray& checksum, c
 }
 
 
+void K3b::VerificationJob::addTrack( int trackNum, const QByteArray& checksum,
+                                     const QList<QByteArray>& extentChecksums, qint64 extentSize,
+                                     const K3b::Msf& length )
+{
+    TrackEntry entry( trackNum, checksum, length );
+    entry.extentChecksums = extentChecksums;
+    entry.extentSize = extentSize;
+    d->trackEntries.append( entry );
+}
+
+
+void K3b::VerificationJob::setSampling( int confidence )
+{
+    d->confidence = confidence;
+}
+
+
 void K3b::VerificationJob::clear()
 {
     d->trackEntries.clear();
@@ -286,7 +465,7 @@ void K3b::VerificationJob::slotDiskInfoReady( K3b::Device::DeviceHandler* dh )
             }
         }
 
-        d->totalSectors += d->trackLength( *it );
+        d->totalSectors += d->prepareExtents( *it );
     }
 
     Q_ASSERT( d->currentTrackEntry != d->trackEntries.constEnd() );
@@ -324,8 +503,6 @@ void K3b::VerificationJob::readTrack()
 
     K3b::Device::Track& track = d->toc[ d->currentTrackEntry->trackNumber-1 ];
 
-    d->pipe.open();
-
     if( track.type() == K3b::Device::Track::TYPE_DATA ) {
         if( !d->dataTrackReader ) {
             d->dataTrackReader = new K3b::DataTrackReader( this );
@@ -347,9 +524,8 @@ void K3b::VerificationJob::readTrack()
             d->grownSessionSize > 0 ) {
             K3b::Iso9660 isoF( d->device );
             if( isoF.open() ) {
-                int firstSector = isoF.primaryDescriptor().volumeSpaceSize - d->grownSessionSize.lba();
-                d->dataTrackReader->setSectorRange( firstSector,
-                                                    isoF.primaryDescriptor().volumeSpaceSize -1 );
+                d->dataStart = isoF.primaryDescriptor().volumeSpaceSize - d->grownSessionSize.lba();
+                d->currentTrackSize = d->grownSessionSize;
             }
             else {
                 emit infoMessage( i18n("Unable to determine the ISO 9660 filesystem size."), MessageError );
@@ -358,11 +534,11 @@ void K3b::VerificationJob::readTrack()
             }
         }
         else
-            d->dataTrackReader->setSectorRange( track.firstSector(),
-                                                track.firstSector() + d->currentTrackSize -1 );
+            d->dataStart = track.firstSector();
 
-        d->pipe.open();
-        d->dataTrackReader->start();
+        d->currentExtentRange = 0;
+        d->differingExtents.clear();
+        d->readExtentRange();
     }
     else {
         // FIXME: handle audio tracks
@@ -381,7 +557,48 @@ void K3b::VerificationJob::slotReaderProgress( int p )
 void K3b::VerificationJob::slotReaderFinished( bool success )
 {
     d->readSuccessful = success;
-    if( d->readSuccessful && !d->canceled ) {
+    if( d->readSuccessful && !d->canceled && !d->currentTrackEntry->extentRanges.isEmpty() ) {
+        const TrackEntry& trackEntry = *d->currentTrackEntry;
+        const ExtentRange& range = trackEntry.extentRanges[d->currentExtentRange];
+
+        d->alreadyReadSectors += d->currentTrackSize;
+
+        d->pipe.close();
+
+        // compare the sums of the extents
+        const QList<QByteArray> checksums = d->pipe.extentChecksums();
+        for( int extent = range.first; extent <= range.second; ++extent ) {
+            if( checksums.value( extent - range.first ) != trackEntry.extentChecksums.value( extent ) )
+                d->differingExtents.append( extent );
+        }
+
+        if( ++d->currentExtentRange < trackEntry.extentRanges.count() ) {
+            d->readExtentRange();
+        }
+        else if( !d->differingExtents.isEmpty() ) {
+            emit infoMessage( i18n("Written data in track %1 differs from original in sectors %2.",
+                                   trackEntry.trackNumber, d->differingSectors() ), MessageError );
+            jobFinished(false);
+        }
+        else {
+            int extents = 0;
+            Q_FOREACH( const ExtentRange& r, trackEntry.extentRanges )
+                extents += r.second - r.first + 1;
+            if( extents < trackEntry.extentChecksums.count() )
+                emit infoMessage( i18np("Written data verified by a sample of 1 of %2 parts.",
+                                        "Written data verified by a sample of %1 of %2 parts.",
+                                        extents, trackEntry.extentChecksums.count() ), MessageSuccess );
+            else
+                emit infoMessage( i18n("Written data verified."), MessageSuccess );
+
+            ++d->currentTrackEntry;
+            if( d->currentTrackEntry != d->trackEntries.constEnd() )
+                readTrack();
+            else
+                jobFinished(true);
+        }
+    }
+    else if( d->readSuccessful && !d->canceled ) {
         d->alreadyReadSectors += d->trackLength( *d->currentTrackEntry );
 
         d->pipe.close();
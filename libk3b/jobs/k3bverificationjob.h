@@ -6,8 +6,10 @@
 #define _K3B_VERIFICATION_JOB_H_
 
 #include "k3bjob.h"
+#include "k3b_export.h"
 
 #include <QByteArray>
+#include <QList>
 
 namespace K3b {
     namespace Device {
@@ -33,8 +35,13 @@ namespace K3b {
      * i.e. Video CDs cannot be verified.
      *
      * TAO written tracks have two run-out sectors that are not read.
+     *
+     * If checksums of the extents of a data track are known only the
+     * extents are compared and differences are reported as sector ranges.
+     * In sampled mode only a stratified random sample of the extents is
+     * read (see setSampling()).
      */
-    class VerificationJob : public Job
+    class LIBK3B_EXPORT VerificationJob : public Job
     {
         Q_OBJECT
 
@@ -42,6 +49,24 @@ namespace K3b {
         explicit VerificationJob( JobHandler*, QObject* parent = 0 );
         ~VerificationJob() override;
 
+        /**
+         * The extent size used by the jobs which record extent checksums
+         * (see ChecksumPipe::setExtentSize).
+         */
+        static qint64 defaultExtentSize();
+
+        /**
+         * Picks the extents read in sampled mode: one random extent from each
+         * of the strata needed to find damage affecting 1% of the extents
+         * with a probability of @p confidence percent. The first and the last
+         * extent are always read.
+         *
+         * \return The sorted indexes of the extents to read, all of them if
+         *         @p confidence is not between 0 and 100 or the sample
+         *         would not be smaller.
+         */
+        static QList<int> sampleExtents( int extents, int confidence );
+
     public Q_SLOTS:
         void start() override;
         void cancel() override;
@@ -59,6 +84,28 @@ namespace K3b {
          */
         void addTrack( int tracknum, const QByteArray& checksum, const Msf& length = Msf() );
 
+        /**
+         * Add a data track to be verified by the checksums of its extents.
+         * \param extentSize The size of the extents in bytes. Needs to be a
+         *        multiple of 2048.
+         */
+        void addTrack( int tracknum, const QByteArray& checksum,
+                       const QList<QByteArray>& extentChecksums, qint64 extentSize,
+                       const Msf& length = Msf() );
+
+        /**
+         * Only read a sample of the extents of the tracks which have been
+         * added with extent checksums. The sample is big enough to find
+         * damage which affects at least one percent of the extents with a
+         * probability of @p confidence percent. The first and the last
+         * extent are always read.
+         *
+         * \param confidence 0 disables sampling and all extents are read.
+         *
+         * Defaults to the global settings.
+         */
+        void setSampling( int confidence );
+
         /**
          * Handle the special case of iso session growing
          */
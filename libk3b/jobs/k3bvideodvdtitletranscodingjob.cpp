@@ -14,6 +14,7 @@
 #include "k3bglobals.h"
 #include "k3bmediacache.h"
 #include "k3bmedium.h"
+#include "k3boutputparser.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -37,42 +38,9 @@ public:
 
     int lastProgress;
     int lastSubProgress;
-
-    bool getEncodedFrames( const QString& line, int& encodedFrames ) const;
 };
 
 
-bool K3b::VideoDVDTitleTranscodingJob::Private::getEncodedFrames( const QString& line, int& encodedFrames ) const
-{
-    int pos1 = 0;
-    int pos2 = 0;
-
-    if ( usedTranscodeBin->version() >= Version( 1, 1, 0 ) ) {
-        // encoding=1 frame=1491 first=0 last=-1 fps=14.815 done=-1.000000 timestamp=59.640 timeleft=-1 decodebuf=12 filterbuf=5 encodebuf=3
-        if( line.startsWith( "encoding=" ) ) {
-            pos1 = line.indexOf( '=', 9 );
-            pos2 = line.indexOf( ' ', pos1+1 );
-        }
-    }
-    else {
-        // encoding frames [000000-000144],  27.58 fps, EMT: 0:00:05, ( 0| 0| 0)
-        if( line.startsWith( "encoding frame" ) ) {
-            pos1 = line.indexOf( '-', 15 );
-            pos2 = line.indexOf( ']', pos1+1 );
-        }
-    }
-
-    if( pos1 > 0 && pos2 > 0 ) {
-        bool ok;
-        encodedFrames = line.mid( pos1+1, pos2-pos1-1 ).toInt( &ok );
-        return ok;
-    }
-    else {
-        return false;
-    }
-}
-
-
 K3b::VideoDVDTitleTranscodingJob::VideoDVDTitleTranscodingJob( K3b::JobHandler* hdl, QObject* parent )
     : K3b::Job( hdl, parent ),
       m_clippingTop( 0 ),
@@ -229,7 +197,7 @@ void K3b::VideoDVDTitleTranscodingJob::startTranscode( int pass )
     d->process = new K3b::Process();
     d->process->setSuppressEmptyLines(true);
     d->process->setSplitStdout(true);
-    connect( d->process, SIGNAL(stdoutLine(QString)), this, SLOT(slotTranscodeStderr(QString)) );
+    connect( d->process, SIGNAL(rawStdoutLine(QByteArray)), this, SLOT(slotTranscodeStderr(QByteArray)) );
     connect( d->process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(slotTranscodeExited(int,QProcess::ExitStatus)) );
 
     // the executable
@@ -412,17 +380,19 @@ void K3b::VideoDVDTitleTranscodingJob::cleanup( bool success )
 }
 
 
-void K3b::VideoDVDTitleTranscodingJob::slotTranscodeStderr( const QString& line )
+void K3b::VideoDVDTitleTranscodingJob::slotTranscodeStderr( const QByteArray& line )
 {
-    emit debuggingOutput( "transcode", line );
-
-    int encodedFrames;
+    emit debuggingOutput( "transcode", QString::fromLocal8Bit( line ) );
 
     // parse progress
-    if( d->getEncodedFrames( line, encodedFrames ) ) {
+    // encoding=1 frame=1491 first=0 last=-1 fps=14.815 done=-1.000000 timestamp=59.640 timeleft=-1 decodebuf=12 filterbuf=5 encodebuf=3
+    // or before transcode 1.1:
+    // encoding frames [000000-000144],  27.58 fps, EMT: 0:00:05, ( 0| 0| 0)
+    const K3b::ProgressEvent encoded = K3b::parseTranscodeProgress( line );
+    if( encoded.isValid() ) {
         int totalFrames = m_dvd[m_titleNumber-1].playbackTime().totalFrames();
         if( totalFrames > 0 ) {
-            int progress = 100 * encodedFrames / totalFrames;
+            int progress = int( 100 * encoded.done / totalFrames );
 
             if( progress > d->lastSubProgress ) {
                 d->lastSubProgress = progress;
@@ -219,7 +219,7 @@ namespace K3b {
         void setLowPriority( bool b ) { m_lowPriority = b; }
 
     private Q_SLOTS:
-        void slotTranscodeStderr( const QString& );
+        void slotTranscodeStderr( const QByteArray& );
         void slotTranscodeExited( int, QProcess::ExitStatus );
 
     private:
@@ -11,6 +11,8 @@
 #include "k3baudiotrack.h"
 #include "k3baudiotrackreader.h"
 #include "k3baudiodatasource.h"
+#include "k3baudiofile.h"
+#include "k3baudiocdtracksource.h"
 #include "k3bthread.h"
 #include "k3bwavefilewriter.h"
 #include "k3b_i18n.h"
@@ -18,24 +20,253 @@
 #include <QDebug>
 #include <QIODevice>
 #include <QFile>
-
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <string.h>
 #include <unistd.h>
 
 
+namespace {
+    const int s_blockSize = 2352 * 10;
+
+    // the number of tracks which are decoded ahead of the one being written
+    const int s_lookaheadTracks = 2;
+
+    // the decoded data buffered for each track, about 24 seconds of audio
+    const qint64 s_trackBufferSize = 4*1024*1024;
+
+    // all tracks read from an audio CD share the drive
+    const char s_audioCdResource = 0;
+}
+
+
 class K3b::AudioImager::Private
 {
 public:
+    /**
+     * Decodes a single track in its own thread into a bounded buffer. This
+     * way the startup of the decoders of the following tracks is hidden
+     * behind the writing of the current one.
+     */
+    class TrackDecoder : public QThread
+    {
+    public:
+        explicit TrackDecoder( AudioTrack* track );
+        ~TrackDecoder() override;
+
+        AudioTrack* track() const { return m_track; }
+        qint64 size() const { return m_size; }
+
+        /**
+         * The decoders and devices used by the track. Tracks sharing any of
+         * them cannot be decoded at the same time.
+         */
+        const QSet<const void*>& resources() const { return m_resources; }
+
+        /**
+         * Blocks until data is available.
+         * \return The number of bytes read, 0 at the end of the track, or -1
+         *         if the track could not be decoded.
+         */
+        qint64 read( char* data, qint64 maxlen );
+
+        bool isDecoded();
+
+        /**
+         * \return true if the track could not be opened. Only valid once
+         *         read() returned -1.
+         */
+        bool openFailed();
+
+        void cancel();
+
+    protected:
+        void run() override;
+
+    private:
+        AudioTrack* m_track;
+        qint64 m_size;
+        QSet<const void*> m_resources;
+
+        // everything below is protected by the mutex
+        QMutex m_mutex;
+        QWaitCondition m_dataAvailable;
+        QWaitCondition m_spaceAvailable;
+        QList<QByteArray> m_blocks;
+        qint64 m_blockPos;
+        qint64 m_buffered;
+        bool m_decoded;
+        bool m_failed;
+        bool m_openFailed;
+        bool m_canceled;
+    };
+
     Private()
-        : ioDev(0) {
+        : ioDev(0),
+          nextTrack(0) {
     }
 
+    // start decoding the following tracks as far as possible
+    void startDecoders();
+    void stopDecoders();
+
     QIODevice* ioDev;
     AudioImager::ErrorType lastError;
     AudioDoc* doc;
     AudioJobTempData* tempData;
+
+    // the track being written and the ones decoded ahead of it
+    QList<TrackDecoder*> decoders;
+    AudioTrack* nextTrack;
 };
 
 
+K3b::AudioImager::Private::TrackDecoder::TrackDecoder( AudioTrack* track )
+    : m_track( track ),
+      m_size( track->length().audioBytes() ),
+      m_blockPos( 0 ),
+      m_buffered( 0 ),
+      m_decoded( false ),
+      m_failed( false ),
+      m_openFailed( false ),
+      m_canceled( false )
+{
+    for( AudioDataSource* source = track->firstSource(); source != 0; source = source->next() ) {
+        if( AudioFile* file = dynamic_cast<AudioFile*>( source ) )
+            m_resources.insert( file->decoder() );
+        else if( dynamic_cast<AudioCdTrackSource*>( source ) )
+            m_resources.insert( &s_audioCdResource );
+    }
+}
+
+
+K3b::AudioImager::Private::TrackDecoder::~TrackDecoder()
+{
+    cancel();
+    wait();
+}
+
+
+qint64 K3b::AudioImager::Private::TrackDecoder::read( char* data, qint64 maxlen )
+{
+    QMutexLocker locker( &m_mutex );
+
+    while( m_blocks.isEmpty() && !m_decoded )
+        m_dataAvailable.wait( &m_mutex );
+
+    if( m_blocks.isEmpty() )
+        return m_failed ? -1 : 0;
+
+    const QByteArray& block = m_blocks.first();
+    const qint64 len = qMin( maxlen, qint64( block.size() ) - m_blockPos );
+    ::memcpy( data, block.constData() + m_blockPos, len );
+    m_blockPos += len;
+    m_buffered -= len;
+    if( m_blockPos >= block.size() ) {
+        m_blocks.removeFirst();
+        m_blockPos = 0;
+    }
+
+    m_spaceAvailable.wakeAll();
+
+    return len;
+}
+
+
+bool K3b::AudioImager::Private::TrackDecoder::isDecoded()
+{
+    QMutexLocker locker( &m_mutex );
+    return m_decoded;
+}
+
+
+bool K3b::AudioImager::Private::TrackDecoder::openFailed()
+{
+    QMutexLocker locker( &m_mutex );
+    return m_openFailed;
+}
+
+
+void K3b::AudioImager::Private::TrackDecoder::cancel()
+{
+    QMutexLocker locker( &m_mutex );
+    m_canceled = true;
+    m_spaceAvailable.wakeAll();
+}
+
+
+void K3b::AudioImager::Private::TrackDecoder::run()
+{
+    AudioTrackReader trackReader( *m_track );
+    bool success = trackReader.open();
+
+    qint64 read = 0;
+    while( success && !trackReader.atEnd() ) {
+        QByteArray block( s_blockSize, Qt::Uninitialized );
+        read = trackReader.read( block.data(), block.size() );
+        if( read <= 0 )
+            break;
+        block.resize( read );
+
+        QMutexLocker locker( &m_mutex );
+        while( m_buffered >= s_trackBufferSize && !m_canceled )
+            m_spaceAvailable.wait( &m_mutex );
+        if( m_canceled )
+            break;
+
+        m_blocks.append( block );
+        m_buffered += read;
+        m_dataAvailable.wakeAll();
+    }
+
+    if( read < 0 ) {
+        qDebug() << "(K3b::AudioImager::TrackDecoder) read error on track " << m_track->trackNumber()
+                 << " at pos " << K3b::Msf(trackReader.pos()/2352);
+    }
+
+    QMutexLocker locker( &m_mutex );
+    m_openFailed = !success;
+    m_failed = !success || read < 0;
+    m_decoded = true;
+    m_dataAvailable.wakeAll();
+}
+
+
+void K3b::AudioImager::Private::startDecoders()
+{
+    while( nextTrack && decoders.count() <= s_lookaheadTracks ) {
+        decoders.append( new TrackDecoder( nextTrack ) );
+        nextTrack = nextTrack->next();
+    }
+
+    //
+    // A track can only be decoded once all previous tracks sharing a
+    // decoder (e.g. tracks imported from a cue file) are done with it.
+    //
+    QSet<const void*> busy;
+    Q_FOREACH( TrackDecoder* decoder, decoders ) {
+        if( decoder->isDecoded() )
+            continue;
+        if( !decoder->isRunning() && !busy.intersects( decoder->resources() ) )
+            decoder->start();
+        busy.unite( decoder->resources() );
+    }
+}
+
+
+void K3b::AudioImager::Private::stopDecoders()
+{
+    qDeleteAll( decoders );
+    decoders.clear();
+    nextTrack = 0;
+}
+
+
 
 K3b::AudioImager::AudioImager( AudioDoc* doc, AudioJobTempData* tempData, JobHandler* jh, QObject* parent )
     : K3b::ThreadJob( jh, parent ),
@@ -68,24 +299,29 @@ bool K3b::AudioImager::run()
 {
     d->lastError = K3b::AudioImager::ERROR_UNKNOWN;
 
+    d->nextTrack = d->doc->firstTrack();
+    const bool success = writeTracks();
+    d->stopDecoders();
+
+    return success;
+}
+
+
+bool K3b::AudioImager::writeTracks()
+{
     K3b::WaveFileWriter waveFileWriter;
 
     qint64 totalSize = d->doc->length().audioBytes();
     qint64 totalRead = 0;
-    char buffer[2352 * 10];
+    char buffer[s_blockSize];
 
-    for( AudioTrack* track = d->doc->firstTrack(); track != 0; track = track->next() ) {
+    d->startDecoders();
 
-        emit nextTrack( track->trackNumber(), d->doc->numOfTracks() );
+    while( !d->decoders.isEmpty() ) {
+        Private::TrackDecoder* decoder = d->decoders.first();
+        AudioTrack* track = decoder->track();
 
-        //
-        // Create track reader
-        //
-        AudioTrackReader trackReader( *track );
-        if( !trackReader.open() ) {
-            emit infoMessage( i18n("Unable to read track %1.", track->trackNumber()), K3b::Job::MessageError );
-            return false;
-        }
+        emit nextTrack( track->trackNumber(), d->doc->numOfTracks() );
 
         //
         // Initialize the reading
@@ -107,7 +343,7 @@ bool K3b::AudioImager::run()
         //
         // Read data from the track
         //
-        while( !trackReader.atEnd() && (read = trackReader.read( buffer, sizeof(buffer) )) > 0 ) {
+        while( (read = decoder->read( buffer, sizeof(buffer) )) > 0 ) {
             if( !d->ioDev ) {
                 waveFileWriter.write( buffer, read, K3b::WaveFileWriter::BigEndian );
             }
@@ -130,19 +366,29 @@ bool K3b::AudioImager::run()
             totalRead += read;
             trackRead += read;
 
-            emit subPercent( 100LL*trackRead/trackReader.size() );
+            emit subPercent( 100LL*trackRead/decoder->size() );
             emit percent( 100LL*totalRead/totalSize );
-            emit processedSubSize( trackRead/1024LL/1024LL, trackReader.size()/1024LL/1024LL );
+            emit processedSubSize( trackRead/1024LL/1024LL, decoder->size()/1024LL/1024LL );
             emit processedSize( totalRead/1024LL/1024LL, totalSize/1024LL/1024LL );
+
+            // tracks waiting for a shared decoder may be started now
+            d->startDecoders();
         }
 
-        if( read < 0 ) {
+        if( read < 0 && decoder->openFailed() ) {
+            emit infoMessage( i18n("Unable to read track %1.", track->trackNumber()), K3b::Job::MessageError );
+            return false;
+        }
+        else if( read < 0 ) {
             emit infoMessage( i18n("Error while decoding track %1.", track->trackNumber()), K3b::Job::MessageError );
             qDebug() << "(K3b::AudioImager::WorkThread) read error on track " << track->trackNumber()
                      << " at pos " << K3b::Msf(trackRead/2352) << Qt::endl;
             d->lastError = K3b::AudioImager::ERROR_DECODING_TRACK;
             return false;
         }
+
+        delete d->decoders.takeFirst();
+        d->startDecoders();
     }
 
     return true;
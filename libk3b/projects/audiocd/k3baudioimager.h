@@ -39,6 +39,7 @@ namespace K3b {
 
     private:
         bool run() override;
+        bool writeTracks();
 
         class Private;
         Private* const d;
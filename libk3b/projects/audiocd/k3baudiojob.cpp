@@ -28,6 +28,7 @@
 #include "k3btocfilewriter.h"
 #include "k3binffilewriter.h"
 #include "k3bglobalsettings.h"
+#include "k3bprefetchbuffer.h"
 #include "k3b_i18n.h"
 
 #include <KStringHandler>
@@ -66,7 +67,12 @@ class K3b::AudioJob::Private
 public:
     Private()
         : copies(1),
-          copiesDone(0) {
+          copiesDone(0),
+          prefetchBuffer(0) {
+    }
+
+    ~Private() {
+        delete prefetchBuffer;
     }
 
     int copies;
@@ -78,6 +84,9 @@ public:
 
     bool zeroPregap;
     bool less4Sec;
+
+    // smoothes the decoded data when writing on-the-fly
+    K3b::PrefetchBuffer* prefetchBuffer;
 };
 
 
@@ -325,7 +334,7 @@ void K3b::AudioJob::start()
                 // we cannot easily change the audioDecode device while it's working
                 // which we would need to do since we write into several
                 // image files.
-                m_audioImager->writeTo( m_writer->ioDevice() );
+                m_audioImager->writeTo( onTheFlyDevice() );
             }
             else {
                 // startWriting() already did the cleanup
@@ -359,7 +368,7 @@ void K3b::AudioJob::slotMaxSpeedJobFinished( bool success )
     }
 
     if( startWriting() )
-        m_audioImager->writeTo( m_writer->ioDevice() );
+        m_audioImager->writeTo( onTheFlyDevice() );
 
     m_audioImager->start();
 }
@@ -375,6 +384,9 @@ void K3b::AudioJob::cancel()
     if( m_writer )
         m_writer->cancel();
 
+    if( d->prefetchBuffer )
+        d->prefetchBuffer->abort();
+
     m_audioImager->cancel();
     emit infoMessage( i18n("Writing canceled."), K3b::Job::MessageError );
     removeBufferFiles();
@@ -418,7 +430,7 @@ void K3b::AudioJob::slotWriterFinished( bool success )
                     // we cannot easily change the audioDecode fd while it's working
                     // which we would need to do since we write into several
                     // image files.
-                    m_audioImager->writeTo( m_writer->ioDevice() );
+                    m_audioImager->writeTo( onTheFlyDevice() );
                     m_audioImager->start();
                 }
             }
@@ -432,6 +444,14 @@ void K3b::AudioJob::slotAudioDecoderFinished( bool success )
     if( m_canceled || m_errorOccuredAndAlreadyReported )
         return;
 
+    // the writer gets the remaining data from the buffer
+    if( d->prefetchBuffer ) {
+        if( success )
+            d->prefetchBuffer->close();
+        else
+            d->prefetchBuffer->abort();
+    }
+
     if( !success ) {
         if( m_audioImager->lastErrorType() == K3b::AudioImager::ERROR_FD_WRITE ) {
             // this means that the writer job failed so let's use the error handling there.
@@ -668,9 +688,24 @@ bool K3b::AudioJob::startWriting()
 }
 
 
+QIODevice* K3b::AudioJob::onTheFlyDevice()
+{
+    delete d->prefetchBuffer;
+
+    // cdrecord and cdrdao know the size of the tracks, no need to close their stdin
+    d->prefetchBuffer = createPrefetchBuffer( m_writer, false );
+    if( d->prefetchBuffer && d->prefetchBuffer->open() )
+        return d->prefetchBuffer;
+
+    return m_writer->ioDevice();
+}
+
+
 void K3b::AudioJob::cleanupAfterError()
 {
     m_errorOccuredAndAlreadyReported = true;
+    if( d->prefetchBuffer )
+        d->prefetchBuffer->abort();
     m_audioImager->cancel();
 
     if( m_writer )
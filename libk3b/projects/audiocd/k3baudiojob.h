@@ -9,6 +9,7 @@
 #include "k3bjob.h"
 
 class QTemporaryFile;
+class QIODevice;
 
 namespace K3b {
     class AudioDoc;
@@ -63,6 +64,11 @@ namespace K3b {
     private:
         bool prepareWriter();
         bool startWriting();
+
+        /**
+         * The device the audio imager writes to when writing on-the-fly.
+         */
+        QIODevice* onTheFlyDevice();
         void cleanupAfterError();
         void removeBufferFiles();
         void normalizeFiles();
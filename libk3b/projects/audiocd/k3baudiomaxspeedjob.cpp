@@ -7,28 +7,119 @@
 #include "k3baudiotrack.h"
 #include "k3baudiodatasource.h"
 #include "k3baudiodoc.h"
+#include "k3baudiofile.h"
+#include "k3baudiodecoder.h"
 #include "k3baudiocdtracksource.h"
 #include "k3baudiodatasourceiterator.h"
 #include "k3bdevice.h"
+#include "k3bglobals.h"
 #include "k3bthread.h"
 #include "k3b_i18n.h"
 
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QAtomicInt>
+#include <QCryptographicHash>
 #include <QDateTime>
 #include <QDebug>
+#include <QFile>
 #include <QIODevice>
+#include <QMap>
 #include <QScopedPointer>
 #include <QElapsedTimer>
+#include <QSet>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QVector>
+
+
+namespace {
+    // the number of files remembered in the throughput cache
+    const int s_maxCachedFiles = 1000;
+
+    /**
+     * The measured decoding throughput of audio files is kept in a cache
+     * so later burns of the same files do not need to decode them again.
+     * A file is identified by its path, size, modification time, and inode
+     * together with the decoder plugin.
+     */
+    class ThroughputCache
+    {
+    public:
+        ThroughputCache()
+            : m_config( "k3baudiothroughputrc", KConfig::SimpleConfig, QStandardPaths::CacheLocation ) {
+        }
+
+        // \return the throughput in KB/sec or 0 if the file is not in the cache
+        int throughput( K3b::AudioFile* file ) {
+            KConfigGroup grp = m_config.group( groupName( file ) );
+            if( grp.readEntry( "Identity", QByteArray() ) != identity( file ) )
+                return 0;
+            grp.writeEntry( "Last used", QDateTime::currentDateTime() );
+            return grp.readEntry( "Throughput", 0 );
+        }
+
+        void setThroughput( K3b::AudioFile* file, int throughput ) {
+            const QByteArray id = identity( file );
+            if( id.isEmpty() )
+                return;
+            KConfigGroup grp = m_config.group( groupName( file ) );
+            grp.writeEntry( "Identity", id );
+            grp.writeEntry( "Throughput", throughput );
+            grp.writeEntry( "Last used", QDateTime::currentDateTime() );
+        }
+
+        // removes the least recently used files and saves the cache
+        void save() {
+            QStringList groups = m_config.groupList();
+            if( groups.count() > s_maxCachedFiles ) {
+                QMultiMap<QDateTime, QString> byUse;
+                Q_FOREACH( const QString& group, groups )
+                    byUse.insert( m_config.group( group ).readEntry( "Last used", QDateTime() ), group );
+                QMultiMap<QDateTime, QString>::const_iterator it = byUse.constBegin();
+                for( int i = groups.count(); i > s_maxCachedFiles; --i, ++it )
+                    m_config.deleteGroup( it.value() );
+            }
+            m_config.sync();
+        }
+
+    private:
+        static QString groupName( K3b::AudioFile* file ) {
+            return QString::fromLatin1( QCryptographicHash::hash( QFile::encodeName( file->filename() ),
+                                                                  QCryptographicHash::Sha1 ).toHex() );
+        }
+
+        static QByteArray identity( K3b::AudioFile* file ) {
+            k3b_struct_stat statBuf;
+            if( k3b_stat( QFile::encodeName( file->filename() ), &statBuf ) != 0 )
+                return QByteArray();
+            return QString( "%1:%2:%3:%4:%5" )
+                .arg( file->decoder()->metaObject()->className() )
+                .arg( quint64( statBuf.st_dev ) )
+                .arg( quint64( statBuf.st_ino ) )
+                .arg( qint64( statBuf.st_size ) )
+                .arg( qint64( statBuf.st_mtime ) ).toLatin1();
+        }
+
+        KConfig m_config;
+    };
+}
 
 
 class K3b::AudioMaxSpeedJob::Private
 {
 public:
     int speedTest( K3b::AudioDataSource* source, QIODevice& sourceReader );
+    int testSource( K3b::AudioDataSource* source );
     int maxSpeedByMedia() const;
 
     int maxSpeed;
     K3b::AudioDoc* doc;
-    char* buffer;
+    K3b::AudioMaxSpeedJob* q;
+
+    QAtomicInt sourcesDone;
+    int numSources;
 };
 
 
@@ -54,12 +145,13 @@ int K3b::AudioMaxSpeedJob::Private::speedTest( K3b::AudioDataSource* source, QIO
     QElapsedTimer t;
     qint64 dataRead = 0;
     qint64 r = 0;
+    QScopedArrayPointer<char> buffer( new char[2352*10] );
 
     // start the timer
     t.start();
 
     // read ten seconds of audio data. This is some value which seemed about right. :)
-    while( dataRead < 2352*75*10 && (r = sourceReader.read( buffer, 2352LL*10LL )) > 0 ) {
+    while( dataRead < 2352*75*10 && !q->canceled() && (r = sourceReader.read( buffer.data(), 2352LL*10LL )) > 0 ) {
         dataRead += r;
     }
 
@@ -81,6 +173,26 @@ int K3b::AudioMaxSpeedJob::Private::speedTest( K3b::AudioDataSource* source, QIO
 }
 
 
+// returns the throughput of the source, 0 if it has not been tested, or -1 on error
+int K3b::AudioMaxSpeedJob::Private::testSource( K3b::AudioDataSource* source )
+{
+    if( q->canceled() )
+        return 0;
+
+    QScopedPointer<QIODevice> sourceReader( source->createReader() );
+
+    int speed = -1;
+    if( !sourceReader->open( QIODevice::ReadOnly ) )
+        qDebug() << "Cannot open source reader!";
+    else
+        speed = speedTest( source, *sourceReader );
+
+    emit q->percent( 100*(sourcesDone.fetchAndAddOrdered( 1 ) + 1)/numSources );
+
+    return speed;
+}
+
+
 int K3b::AudioMaxSpeedJob::Private::maxSpeedByMedia() const
 {
     int s = 0;
@@ -110,13 +222,12 @@ K3b::AudioMaxSpeedJob::AudioMaxSpeedJob( K3b::AudioDoc* doc, K3b::JobHandler* jh
       d( new Private() )
 {
     d->doc = doc;
-    d->buffer = new char[2352*10];
+    d->q = this;
 }
 
 
 K3b::AudioMaxSpeedJob::~AudioMaxSpeedJob()
 {
-    delete [] d->buffer;
     delete d;
 }
 
@@ -131,46 +242,84 @@ bool K3b::AudioMaxSpeedJob::run()
 {
     qDebug();
 
-    K3b::AudioDataSourceIterator it( d->doc );
+    ThroughputCache cache;
 
-    // count sources for minimal progress info
-    int numSources = 0;
-    int sourcesDone = 0;
-    while( it.current() ) {
-        ++numSources;
-        it.next();
-    }
+    //
+    // Each audio file is only tested once even if it is split into several
+    // sources. Files whose throughput is known from earlier burns are not
+    // tested at all.
+    //
+    QVector<K3b::AudioDataSource*> sources;
+    QVector<K3b::AudioDataSource*> cdSources;
+    QSet<K3b::AudioDecoder*> decoders;
 
-    bool success = true;
     d->maxSpeed = 175*1000;
-    it.first();
-
-    while( it.current() && !canceled() ) {
-        QScopedPointer<QIODevice> sourceReader( it.current()->createReader() );
-
-        if( !sourceReader->open( QIODevice::ReadOnly ) ) {
-            qDebug() << "Cannot open source reader!";
-            success = false;
-            break;
+    d->sourcesDone = 0;
+
+    for( K3b::AudioDataSourceIterator it( d->doc ); it.current(); it.next() ) {
+        K3b::AudioDataSource* source = it.current();
+        if( K3b::AudioFile* file = dynamic_cast<K3b::AudioFile*>( source ) ) {
+            if( decoders.contains( file->decoder() ) )
+                continue;
+            decoders.insert( file->decoder() );
+
+            if( int speed = cache.throughput( file ) ) {
+                qDebug() << "(K3b::AudioMaxSpeedJob) cached throughput of" << file->filename() << ":" << speed;
+                d->maxSpeed = qMin( d->maxSpeed, speed );
+                continue;
+            }
         }
 
-        // read some data
-        int speed = d->speedTest( it.current(), *sourceReader );
+        // reading several tracks from the same cd in parallel only makes the drive seek
+        if( dynamic_cast<K3b::AudioCdTrackSource*>( source ) )
+            cdSources.append( source );
+        else
+            sources.append( source );
+    }
 
-        ++sourcesDone;
-        emit percent( 100*numSources/sourcesDone );
+    d->numSources = qMax( 1, sources.count() + cdSources.count() );
 
-        if( speed < 0 ) {
+    //
+    // The sources are decoded in parallel which is closer to the imager
+    // decoding several tracks ahead anyway.
+    //
+    QVector<int> speeds( sources.count() );
+    QVector<int> cdSpeeds( cdSources.count() );
+    QThreadPool pool;
+    pool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount(), 4 ) );
+    for( int i = 0; i < sources.count(); ++i ) {
+        pool.start( [&, i]() {
+            speeds[i] = d->testSource( sources[i] );
+        } );
+    }
+    if( !cdSources.isEmpty() ) {
+        pool.start( [&]() {
+            for( int i = 0; i < cdSources.count(); ++i )
+                cdSpeeds[i] = d->testSource( cdSources[i] );
+        } );
+    }
+    pool.waitForDone();
+
+    bool success = true;
+    for( int i = 0; i < sources.count(); ++i ) {
+        if( speeds[i] < 0 ) {
             success = false;
-            break;
         }
-        else if( speed > 0 ) {
+        else if( speeds[i] > 0 ) {
             // update the max speed
-            d->maxSpeed = qMin( d->maxSpeed, speed );
+            d->maxSpeed = qMin( d->maxSpeed, speeds[i] );
+            if( K3b::AudioFile* file = dynamic_cast<K3b::AudioFile*>( sources[i] ) )
+                cache.setThroughput( file, speeds[i] );
         }
-
-        it.next();
     }
+    Q_FOREACH( int speed, cdSpeeds ) {
+        if( speed < 0 )
+            success = false;
+        else if( speed > 0 )
+            d->maxSpeed = qMin( d->maxSpeed, speed );
+    }
+
+    cache.save();
 
     if( canceled() ) {
         success = false;
@@ -37,6 +37,7 @@
 #include <QDir>
 #include <QFile>
 #include <QFileInfo>
+#include <QSet>
 #include <QStringList>
 #include <QTimer>
 #include <QApplication>
@@ -60,7 +61,8 @@ public:
         bootCataloge( 0 ),
         bExistingItemsReplaceAll( false ),
         bExistingItemsIgnoreAll( false ),
-        needToCutFilenames( false )
+        needToCutFilenames( false ),
+        haveContentSources( false )
     {
         sizeHandler = new K3b::FileCompilationSizeHandler();
     }
@@ -72,6 +74,26 @@ public:
         //  delete oldSessionSizeHandler;
     }
 
+    /**
+     * Adds or removes all files below item to or from the size handler.
+     * Directories may be inserted or removed including their children
+     * (moving, copying, rescanning) so we need to handle them recursively.
+     */
+    void updateSizeHandler( DataItem* item, bool removed )
+    {
+        if( item->isDir() ) {
+            Q_FOREACH( DataItem* child, static_cast<DirItem*>( item )->children() ) {
+                updateSizeHandler( child, removed );
+            }
+        }
+        else if( !item->isFromOldSession() ) {
+            if( removed )
+                sizeHandler->removeFile( item );
+            else
+                sizeHandler->addFile( item );
+        }
+    }
+
     FileCompilationSizeHandler* sizeHandler;
 
     //  FileCompilationSizeHandler* oldSessionSizeHandler;
@@ -101,6 +123,9 @@ public:
 
     bool needToCutFilenames;
     QList<DataItem*> needToCutFilenameItems;
+
+    // true if some files use the contents of another file (see setContentSources())
+    bool haveContentSources;
 };
 
 
@@ -242,11 +267,14 @@ void K3b::DataDoc::addUrlsToDir( const QList<QUrl>& l, K3b::DirItem* dir )
             if( !newDirItem ) {
                 newDirItem = new K3b::DirItem( k3bname );
                 newDirItem->setLocalPath( url.toLocalFile() ); // HACK: see k3bdiritem.h
+                newDirItem->updateLocalTimestamps();
                 dir->addDataItem( newDirItem );
             }
 
             // recursively add all the files in the directory
             QStringList dlist = QDir( f.absoluteFilePath() ).entryList( QDir::AllEntries|QDir::System|QDir::Hidden|QDir::NoDotAndDotDot );
+            newDirItem->setLocalAddOptions( DirItem::AddHiddenFiles );
+            newDirItem->setLocalEntries( newDirItem->localEntries() + QSet<QString>( dlist.begin(), dlist.end() ) );
             QList<QUrl> newUrls;
             for( QStringList::ConstIterator it = dlist.constBegin(); it != dlist.constEnd(); ++it )
                 newUrls.append( QUrl::fromLocalFile( f.absoluteFilePath() + '/' + *it ) );
@@ -289,7 +317,8 @@ K3b::DirItem* K3b::DataDoc::addEmptyDir( const QString& name, K3b::DirItem* pare
 
 KIO::filesize_t K3b::DataDoc::size() const
 {
-    if( d->isoOptions.doNotCacheInodes() )
+    // deduplication relies on inode caching (see IsoImager::addMkisofsParameters)
+    if( d->isoOptions.doNotCacheInodes() && !d->isoOptions.deduplicateFiles() )
         return root()->blocks().mode1Bytes() + d->oldSessionSize;
     else
         return d->sizeHandler->blocks( d->isoOptions.followSymbolicLinks() ||
@@ -468,6 +497,12 @@ bool K3b::DataDoc::loadDocumentDataOptions( QDomElement elem )
         else if( e.nodeName() == "do_not_cache_inodes" )
             d->isoOptions.setDoNotCacheInodes( e.attributeNode( "activated" ).value() == "yes" );
 
+        else if( e.nodeName() == "optimize_layout" )
+            d->isoOptions.setOptimizeLayout( e.attributeNode( "activated" ).value() == "yes" );
+
+        else if( e.nodeName() == "deduplicate_files" )
+            d->isoOptions.setDeduplicateFiles( e.attributeNode( "activated" ).value() == "yes" );
+
         else if( e.nodeName() == "whitespace_treatment" ) {
             if( e.text() == "strip" )
                 d->isoOptions.setWhiteSpaceTreatment( K3b::IsoOptions::strip );
@@ -626,6 +661,22 @@ bool K3b::DataDoc::loadDataItem( QDomElement& elem, K3b::DirItem* parent )
 
         if( !newDirItem ) {
             newDirItem = new K3b::DirItem( elem.attributeNode( "name" ).value() );
+            newDirItem->setLocalPath( elem.attribute( "local_path" ) );
+            newDirItem->setLocalTimestamps( elem.attribute( "local_mtime", "0" ).toLongLong(),
+                                            elem.attribute( "local_ctime", "0" ).toLongLong() );
+            DirItem::LocalAddOptions addOptions;
+            if( elem.attribute( "add_hidden" ) == "yes" )
+                addOptions |= DirItem::AddHiddenFiles;
+            if( elem.attribute( "add_system" ) == "yes" )
+                addOptions |= DirItem::AddSystemFiles;
+            if( elem.attribute( "follow_folder_links" ) == "yes" )
+                addOptions |= DirItem::FollowFolderLinks;
+            newDirItem->setLocalAddOptions( addOptions );
+            if( elem.hasAttribute( "local_entries" ) ) {
+                // file names cannot contain slashes
+                const QStringList entries = elem.attribute( "local_entries" ).split( '/', Qt::SkipEmptyParts );
+                newDirItem->setLocalEntries( QSet<QString>( entries.begin(), entries.end() ) );
+            }
             parent->addDataItem( newDirItem );
         }
         QDomNodeList childNodes = elem.childNodes();
@@ -778,6 +829,14 @@ void K3b::DataDoc::saveDocumentDataOptions( QDomElement& optionsElem )
     topElem.setAttribute( "activated", isoOptions().doNotCacheInodes() ? "yes" : "no" );
     optionsElem.appendChild( topElem );
 
+    topElem = doc.createElement( "optimize_layout" );
+    topElem.setAttribute( "activated", isoOptions().optimizeLayout() ? "yes" : "no" );
+    optionsElem.appendChild( topElem );
+
+    topElem = doc.createElement( "deduplicate_files" );
+    topElem.setAttribute( "activated", isoOptions().deduplicateFiles() ? "yes" : "no" );
+    optionsElem.appendChild( topElem );
+
 
     topElem = doc.createElement( "whitespace_treatment" );
     switch( isoOptions().whiteSpaceTreatment() ) {
@@ -922,6 +981,20 @@ void K3b::DataDoc::saveDataItem( K3b::DataItem* item, QDomDocument* doc, QDomEle
         QDomElement topElem = doc->createElement( "directory" );
         topElem.setAttribute( "name", dirItem->k3bName() );
 
+        // remember where the folder came from to be able to rescan it later on
+        if( !dirItem->localPath().isEmpty() ) {
+            topElem.setAttribute( "local_path", dirItem->localPath() );
+            topElem.setAttribute( "local_mtime", QString::number( dirItem->localMTime() ) );
+            topElem.setAttribute( "local_ctime", QString::number( dirItem->localCTime() ) );
+            topElem.setAttribute( "add_hidden", dirItem->localAddOptions().testFlag( DirItem::AddHiddenFiles ) ? "yes" : "no" );
+            topElem.setAttribute( "add_system", dirItem->localAddOptions().testFlag( DirItem::AddSystemFiles ) ? "yes" : "no" );
+            topElem.setAttribute( "follow_folder_links", dirItem->localAddOptions().testFlag( DirItem::FollowFolderLinks ) ? "yes" : "no" );
+
+            QStringList entries( dirItem->localEntries().begin(), dirItem->localEntries().end() );
+            entries.sort();
+            topElem.setAttribute( "local_entries", entries.join( '/' ) );
+        }
+
         if( item->sortWeight() != 0 )
             topElem.setAttribute( "sort_weight", QString::number(item->sortWeight()) );
 
@@ -966,8 +1039,7 @@ void K3b::DataDoc::endInsertItems( DirItem* parent, int start, int end )
     for( int i = start; i <= end; ++i ) {
         DataItem* item = parent->children().at( i );
         // update the project size
-        if( !item->isFromOldSession() )
-            d->sizeHandler->addFile( item );
+        d->updateSizeHandler( item, false );
 
         // update the boot item list
         if( item->isBootItem() )
@@ -986,8 +1058,7 @@ void K3b::DataDoc::beginRemoveItems( DirItem* parent, int start, int end )
     for( int i = start; i <= end; ++i ) {
         DataItem* item = parent->children().at( i );
         // update the project size
-        if( !item->isFromOldSession() )
-            d->sizeHandler->removeFile( item );
+        d->updateSizeHandler( item, true );
 
         // update the boot item list
         if( item->isBootItem() ) {
@@ -1492,6 +1563,42 @@ K3b::DataItem* K3b::DataDoc::createBootCatalogeItem( K3b::DirItem* dir )
 }
 
 
+void K3b::DataDoc::setContentSources( const QHash<K3b::FileItem*, K3b::FileItem*>& sources )
+{
+    // nothing to reset, no need to walk the project
+    if( sources.isEmpty() && !d->haveContentSources )
+        return;
+
+    d->haveContentSources = !sources.isEmpty();
+
+    bool changedSize = false;
+
+    K3b::DataItem* item = root();
+    while( (item = item->nextSibling()) ) {
+        if( !item->isFile() || item->isSpecialFile() )
+            continue;
+
+        K3b::FileItem* fileItem = static_cast<K3b::FileItem*>( item );
+        K3b::FileItem* source = sources.value( fileItem, 0 );
+        if( !source && !fileItem->hasContentSource() )
+            continue;
+
+        // the size handler identifies the files by their content id
+        d->sizeHandler->removeFile( fileItem );
+        if( source )
+            fileItem->setContentSource( source->localId( false ), source->localPath() );
+        else
+            fileItem->clearContentSource();
+        d->sizeHandler->addFile( fileItem );
+
+        changedSize = true;
+    }
+
+    if( changedSize )
+        emit changed();
+}
+
+
 QList<K3b::DataItem*> K3b::DataDoc::findItemByLocalPath( const QString& path ) const
 {
     Q_UNUSED( path );
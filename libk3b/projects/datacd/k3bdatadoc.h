@@ -15,6 +15,7 @@
 #include "k3b_export.h"
 
 #include <KIO/Global>
+#include <QHash>
 
 class QString;
 class QDomDocument;
@@ -24,6 +25,7 @@ namespace K3b {
     class DataItem;
     class RootItem;
     class DirItem;
+    class FileItem;
     class Job;
     class BootItem;
     class Iso9660Directory;
@@ -190,6 +192,18 @@ namespace K3b {
          */
         int importedSession() const;
 
+        /**
+         * Lets the image use the contents of another file for each of the files in
+         * @p sources since both are identical. All other files in the project use
+         * their own contents again. The project size is updated accordingly.
+         *
+         * \param sources Maps files to the file to take the contents from.
+         *                An empty map resets all files.
+         *
+         * \see IsoOptions::deduplicateFiles()
+         */
+        void setContentSources( const QHash<FileItem*, FileItem*>& sources );
+
         /**
          * Searches for an item by it's local path.
          *
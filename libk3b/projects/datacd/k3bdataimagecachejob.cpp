@@ -0,0 +1,164 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdataimagecachejob.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bglobals.h"
+#include "k3bimagecache.h"
+#include "k3bisoimager.h"
+#include "k3bisooptions.h"
+#include "k3b_i18n.h"
+
+#include <KConfig>
+#include <KConfigGroup>
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QList>
+#include <QMap>
+
+
+class K3b::DataImageCacheJob::Private
+{
+public:
+    K3b::DataDoc* doc;
+    QByteArray imagerName;
+
+    QByteArray key;
+    QString imagePath;
+    QByteArray checksum;
+};
+
+
+K3b::DataImageCacheJob::DataImageCacheJob( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent )
+    : K3b::ThreadJob( hdl, parent ),
+      d( new Private() )
+{
+    d->doc = doc;
+}
+
+
+K3b::DataImageCacheJob::~DataImageCacheJob()
+{
+    delete d;
+}
+
+
+void K3b::DataImageCacheJob::setImager( K3b::IsoImager* imager )
+{
+    d->imagerName = imager->metaObject()->className();
+}
+
+
+QByteArray K3b::DataImageCacheJob::key() const
+{
+    return d->key;
+}
+
+
+QString K3b::DataImageCacheJob::imagePath() const
+{
+    return d->imagePath;
+}
+
+
+QByteArray K3b::DataImageCacheJob::checksum() const
+{
+    return d->checksum;
+}
+
+
+bool K3b::DataImageCacheJob::run()
+{
+    d->key.clear();
+    d->imagePath.clear();
+    d->checksum.clear();
+
+    K3b::ImageCache cache = K3b::ImageCache::fromSettings();
+    if( !cache.isEnabled() )
+        return true;
+
+    emit newSubTask( i18n("Searching the image cache") );
+
+    d->key = projectKey();
+    if( canceled() )
+        return false;
+
+    if( !d->key.isEmpty() )
+        d->imagePath = cache.lookup( d->key, &d->checksum );
+
+    return true;
+}
+
+
+QByteArray K3b::DataImageCacheJob::projectKey() const
+{
+    QCryptographicHash hash( QCryptographicHash::Sha1 );
+
+    // video DVDs are created with other options
+    hash.addData( d->imagerName );
+
+    KConfig options( QString(), KConfig::SimpleConfig );
+    KConfigGroup group = options.group( "ISO Options" );
+    K3b::IsoOptions isoOptions = d->doc->isoOptions();
+    isoOptions.save( group, true );
+    const QMap<QString, QString> entries = group.entryMap();
+    for( QMap<QString, QString>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it )
+        hash.addData( QString( "%1=%2\n" ).arg( it.key() ).arg( it.value() ).toUtf8() );
+
+    //
+    // Every item with its position in the project and the state of the
+    // local file. Boot images and imported sessions are not cached.
+    //
+    QList<K3b::DataItem*> items;
+    items << d->doc->root();
+    while( !items.isEmpty() ) {
+        if( canceled() )
+            return QByteArray();
+
+        K3b::DataItem* item = items.takeFirst();
+        if( item->isBootItem() || item->isFromOldSession() )
+            return QByteArray();
+
+        QByteArray entry;
+        QDataStream s( &entry, QIODevice::WriteOnly );
+        s << item->k3bPath() << item->localPath()
+          << item->hideOnRockRidge() << item->hideOnJoliet() << item->writeToCd()
+          << qint64( item->sortWeight() ) << quint64( item->size() );
+
+        if( !item->localPath().isEmpty() ) {
+            // mkisofs reads the targets of the links it follows
+            k3b_struct_stat statBuf;
+            const QByteArray localPath = QFile::encodeName( item->localPath() );
+            if( isoOptions.followSymbolicLinks() ) {
+                if( k3b_stat( localPath.constData(), &statBuf ) != 0 )
+                    return QByteArray();
+
+                // the contents of a linked folder are not part of the project
+                if( item->isSymLink() && S_ISDIR( statBuf.st_mode ) )
+                    return QByteArray();
+            }
+            else if( k3b_lstat( localPath.constData(), &statBuf ) != 0 ) {
+                return QByteArray();
+            }
+            s << quint64( statBuf.st_dev ) << quint64( statBuf.st_ino ) << qint64( statBuf.st_size )
+              << qint64( statBuf.st_mtime ) << qint64( statBuf.st_ctime );
+        }
+
+        hash.addData( entry );
+
+        if( item->isDir() )
+            items = static_cast<K3b::DirItem*>( item )->children() + items;
+    }
+
+    qDebug() << "(K3b::DataImageCacheJob) key" << hash.result().toHex();
+    return hash.result();
+}
+
+#include "moc_k3bdataimagecachejob.cpp"
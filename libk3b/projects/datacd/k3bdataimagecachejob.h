@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_DATA_IMAGE_CACHE_JOB_H_
+#define _K3B_DATA_IMAGE_CACHE_JOB_H_
+
+#include "k3bthreadjob.h"
+
+#include <QByteArray>
+#include <QString>
+
+
+namespace K3b {
+    class DataDoc;
+    class IsoImager;
+    class JobHandler;
+
+    /**
+     * The DataImageCacheJob hashes the options and the items of a data
+     * project and looks up the image of the project in the image cache
+     * (see ImageCache::fromSettings()). It is used by the DataJob.
+     *
+     * Hashing stats every local file of the project, thus it runs in a
+     * thread of its own.
+     */
+    class DataImageCacheJob : public ThreadJob
+    {
+        Q_OBJECT
+
+    public:
+        DataImageCacheJob( DataDoc* doc, JobHandler* hdl, QObject* parent );
+        ~DataImageCacheJob() override;
+
+        /**
+         * The imager which would create the image. Video DVDs are
+         * created with other options than plain data projects.
+         */
+        void setImager( IsoImager* imager );
+
+        /**
+         * \return The key of the project in the image cache or an empty
+         *         array if the image cannot be cached.
+         */
+        QByteArray key() const;
+
+        /**
+         * \return The path of the cached image or an empty string if the
+         *         cache does not contain it.
+         */
+        QString imagePath() const;
+
+        /**
+         * \return The md5 checksum of the cached image.
+         */
+        QByteArray checksum() const;
+
+    private:
+        bool run() override;
+        QByteArray projectKey() const;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
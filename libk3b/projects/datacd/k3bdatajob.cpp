@@ -7,6 +7,7 @@
 #include "k3bdatadoc.h"
 #include "k3bisoimager.h"
 #include "k3bdatamultisessionparameterjob.h"
+#include "k3bdataimagecachejob.h"
 #include "k3bchecksumpipe.h"
 #include "k3bcore.h"
 #include "k3bglobals.h"
@@ -20,6 +21,9 @@
 #include "k3bcdrdaowriter.h"
 #include "k3bglobalsettings.h"
 #include "k3bactivepipe.h"
+#include "k3bprefetchbuffer.h"
+#include "k3bfanoutbuffer.h"
+#include "k3bimagecache.h"
 #include "k3bfilesplitter.h"
 #include "k3bverificationjob.h"
 #include "k3biso9660.h"
@@ -35,6 +39,7 @@
 #include <QDateTime>
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QString>
 #include <QStringList>
 #include <QTemporaryFile>
@@ -47,7 +52,67 @@ public:
     Private()
         : usedWritingApp(K3b::WritingAppAuto),
           verificationJob( 0 ),
-          pipe( 0 ) {
+          pipe( 0 ),
+          prefetchBuffer( 0 ),
+          cachedImage( false ),
+          cachedImageSize( 0 ),
+          fanOut( 0 ),
+          parallel( false ) {
+    }
+
+    //
+    // One of the drives writing at the same time. When writing an image every drive
+    // reads it on its own, on-the-fly they share the fan-out buffer.
+    //
+    class ParallelWriter
+    {
+    public:
+        ParallelWriter( K3b::Device::Device* dev, K3b::AbstractWriter* writer, bool close )
+            : device( dev ),
+              writerJob( writer ),
+              verificationJob( 0 ),
+              closeWhenDone( close ),
+              running( false ),
+              written( false ),
+              verifying( false ),
+              success( false ),
+              writerPercent( 0 ),
+              verificationPercent( 0 ) {
+        }
+
+        ~ParallelWriter() {
+            delete verificationJob;
+            delete writerJob;
+        }
+
+        K3b::Device::Device* device;
+        K3b::AbstractWriter* writerJob;
+        K3b::VerificationJob* verificationJob;
+
+        // growisofs needs stdin to be closed in order to exit gracefully
+        bool closeWhenDone;
+
+        bool running;
+
+        // written successfully, the verification has not been started yet
+        bool written;
+
+        bool verifying;
+        bool success;
+        int writerPercent;
+        int verificationPercent;
+
+        K3b::FileSplitter imageFile;
+        QFile singleImageFile;
+        K3b::ActivePipe outPipe;
+    };
+
+    ParallelWriter* parallelWriter( QObject* job ) const {
+        Q_FOREACH( ParallelWriter* w, parallelWriters ) {
+            if( job && ( w->writerJob == job || w->verificationJob == job ) )
+                return w;
+        }
+        return 0;
     }
 
     K3b::DataDoc* doc;
@@ -68,11 +133,38 @@ public:
     K3b::VerificationJob* verificationJob;
 
     K3b::FileSplitter imageFile;
+    // a finished image consisting of a single file is read through a plain
+    // QFile which the ActivePipe can splice into the writer
+    QFile singleImageFile;
     K3b::ActivePipe* pipe;
 
+    // smoothes the data stream from the iso imager when writing on-the-fly
+    K3b::PrefetchBuffer* prefetchBuffer;
+
+    // the key of the project in the image cache, empty if the cache is not used
+    QByteArray cacheKey;
+
+    // the image found in the cache when the job was started
+    QString cachedImagePath;
+
+    // writing an image from the cache instead of creating it
+    bool cachedImage;
+    int cachedImageSize;
+
+    // copies the image into the cache and feeds the parallel writers
+    // while writing on-the-fly
+    K3b::FanOutBuffer* fanOut;
+    QFile cacheFile;
+
+    bool parallel;
+    QList<K3b::Device::Device*> additionalWriters;
+    QList<ParallelWriter*> parallelWriters;
+
     K3b::DataMultiSessionParameterJob* multiSessionParameterJob;
+    K3b::DataImageCacheJob* imageCacheJob;
 
     QByteArray checksumCache;
+    QList<QByteArray> extentChecksumCache;
 };
 
 
@@ -85,6 +177,11 @@ K3b::DataJob::DataJob( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent
                    SLOT(slotMultiSessionParamterSetupDone(bool)),
                    SIGNAL(newTask(QString)),
                    SIGNAL(newSubTask(QString)) );
+    d->imageCacheJob = new K3b::DataImageCacheJob( doc, this, this );
+    connectSubJob( d->imageCacheJob,
+                   SLOT(slotImageCacheLookupDone(bool)),
+                   SIGNAL(newTask(QString)),
+                   SIGNAL(newSubTask(QString)) );
 
     d->doc = doc;
     m_writerJob = 0;
@@ -97,6 +194,9 @@ K3b::DataJob::~DataJob()
 {
     qDebug();
     delete d->pipe;
+    delete d->prefetchBuffer;
+    delete d->fanOut;
+    qDeleteAll( d->parallelWriters );
     delete d->tocFile;
     delete d;
 }
@@ -126,6 +226,9 @@ void K3b::DataJob::start()
     d->imageFinished = false;
     d->copies = d->doc->copies();
     d->copiesDone = 0;
+    d->cacheKey.clear();
+    d->cachedImagePath.clear();
+    d->cachedImage = false;
 
     prepareImager();
 
@@ -147,7 +250,22 @@ void K3b::DataJob::slotMultiSessionParamterSetupDone( bool success )
 {
     qDebug() << success;
     if ( success ) {
-        prepareWriting();
+        //
+        // The image of a project which did not change since it has been written
+        // the last time is taken from the cache. It is looked up before the imager
+        // prepares the project which is not necessary in that case. The cache only
+        // holds images which start a new disc.
+        //
+        if( !d->doc->onlyCreateImages() &&
+            K3b::ImageCache::fromSettings().isEnabled() &&
+            ( usedMultiSessionMode() == K3b::DataDoc::NONE ||
+              usedMultiSessionMode() == K3b::DataDoc::START ) ) {
+            d->imageCacheJob->setImager( m_isoImager );
+            d->imageCacheJob->start();
+        }
+        else {
+            prepareWriting();
+        }
     }
     else {
         if ( d->multiSessionParameterJob->hasBeenCanceled() ) {
@@ -159,6 +277,26 @@ void K3b::DataJob::slotMultiSessionParamterSetupDone( bool success )
 }
 
 
+void K3b::DataJob::slotImageCacheLookupDone( bool success )
+{
+    qDebug() << success;
+    if ( success ) {
+        d->cacheKey = d->imageCacheJob->key();
+        d->cachedImagePath = d->imageCacheJob->imagePath();
+        if( !d->cachedImagePath.isEmpty() )
+            d->checksumCache = d->imageCacheJob->checksum();
+        prepareWriting();
+    }
+    else {
+        if ( d->imageCacheJob->hasBeenCanceled() ) {
+            emit canceled();
+        }
+        cleanup();
+        jobFinished( false );
+    }
+}
+
+
 void K3b::DataJob::prepareWriting()
 {
     qDebug();
@@ -179,11 +317,68 @@ void K3b::DataJob::prepareWriting()
         m_isoImager->setMultiSessionInfo( QString(), 0 );
     }
 
+    //
+    // Sessions which continue a disc depend on the disc in the burner,
+    // thus only a project without multisession is written on several
+    // drives at the same time.
+    //
+    d->parallel = !d->additionalWriters.isEmpty() && !d->doc->onlyCreateImages();
+    if( d->parallel && usedMultiSessionMode() != K3b::DataDoc::NONE ) {
+        emit infoMessage( i18n("Multisession projects cannot be written on several drives at the same time. "
+                               "Writing on %1 only.", d->doc->burner()->blockDeviceName() ), MessageWarning );
+        d->parallel = false;
+    }
+    if( d->parallel )
+        d->copies = 1;
+
+    if( !d->cachedImagePath.isEmpty() ) {
+        writeCachedImage( d->cachedImagePath );
+        return;
+    }
+
     d->initializingImager = true;
     m_isoImager->init();
 }
 
 
+void K3b::DataJob::writeCachedImage( const QString& path )
+{
+    qDebug() << path;
+    emit infoMessage( i18n("The project did not change since it was written the last time. Using the image from the cache."), MessageInfo );
+
+    d->initializingImager = false;
+    d->imageFinished = true;
+    d->cachedImage = true;
+    d->cacheKey.clear();
+    d->extentChecksumCache.clear();
+    d->cachedImageSize = QFileInfo( path ).size() / 2048;
+
+    d->imageFile.setName( path );
+    if( !d->imageFile.open( QIODevice::ReadOnly ) ) {
+        emit infoMessage( i18n("Could not open file %1", path ), MessageError );
+        cleanup();
+        jobFinished( false );
+    }
+    else if( d->parallel ) {
+        d->imageFile.close();
+        if( !startParallelWriters() ) {
+            cleanup();
+            jobFinished( false );
+        }
+    }
+    else if( prepareWriterJob() ) {
+        startWriterJob();
+        startPipe();
+    }
+}
+
+
+int K3b::DataJob::imageSize() const
+{
+    return d->cachedImage ? d->cachedImageSize : m_isoImager->size();
+}
+
+
 void K3b::DataJob::writeImage()
 {
     qDebug();
@@ -225,21 +420,69 @@ void K3b::DataJob::startPipe()
     //
     // Open the active pipe which does the streaming
     //
+    // images which are added to the cache need a checksum
+    const bool fillCache = ( !d->cacheKey.isEmpty() && !d->imageFinished && d->copiesDone == 0 );
+
     delete d->pipe;
-    if ( d->imageFinished || !d->doc->verifyData() )
+    if ( d->imageFinished || ( !d->doc->verifyData() && !fillCache ) )
         d->pipe = new K3b::ActivePipe();
-    else
-        d->pipe = new K3b::ChecksumPipe();
+    else {
+        K3b::ChecksumPipe* checksumPipe = new K3b::ChecksumPipe();
+        if( d->doc->verifyData() )
+            checksumPipe->setExtentSize( K3b::VerificationJob::defaultExtentSize() );
+        d->pipe = checksumPipe;
+    }
 
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
-    if( d->imageFinished || ( d->doc->onTheFly() && !d->doc->onlyCreateImages() ) )
+    const bool parallelOnTheFly = ( d->parallel && !d->imageFinished && d->doc->onTheFly() );
+
+    // the fan-out buffer already bridges a drive which pauses for a moment
+    delete d->prefetchBuffer;
+    d->prefetchBuffer = 0;
+    if( !d->imageFinished && d->doc->onTheFly() && !d->doc->onlyCreateImages() && !d->parallel )
+        d->prefetchBuffer = createPrefetchBuffer( m_writerJob, d->usedWritingApp != K3b::WritingAppCdrecord );
+
+    delete d->fanOut;
+    d->fanOut = 0;
+    if( fillCache && d->doc->onTheFly() ) {
+        d->cacheFile.setFileName( K3b::ImageCache::fromSettings().newImagePath( d->cacheKey ) );
+        if( d->cacheFile.fileName().isEmpty() )
+            d->cacheKey.clear();
+        else if( !parallelOnTheFly )
+            d->fanOut = new K3b::FanOutBuffer( 4*1024*1024 );
+    }
+    if( parallelOnTheFly )
+        d->fanOut = new K3b::FanOutBuffer();
+
+    if( d->fanOut ) {
+        if( fillCache && !d->cacheKey.isEmpty() )
+            d->fanOut->addSink( &d->cacheFile, true );
+
+        if( parallelOnTheFly ) {
+            Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters )
+                d->fanOut->addSink( w->writerJob->ioDevice(), w->closeWhenDone );
+        }
+        else if( d->prefetchBuffer )
+            d->fanOut->addSink( d->prefetchBuffer, true );
+        else
+            d->fanOut->addSink( m_writerJob->ioDevice(), d->usedWritingApp != K3b::WritingAppCdrecord );
+        d->pipe->writeTo( d->fanOut, true );
+    }
+    else if( d->prefetchBuffer )
+        d->pipe->writeTo( d->prefetchBuffer, true );
+    else if( d->imageFinished || ( d->doc->onTheFly() && !d->doc->onlyCreateImages() ) )
         d->pipe->writeTo( m_writerJob->ioDevice(), d->usedWritingApp != K3b::WritingAppCdrecord );
     else
         d->pipe->writeTo( &d->imageFile, true );
 
-    if ( d->imageFinished )
+    if ( d->imageFinished && !d->imageFile.isSplit() ) {
+        d->imageFile.close();
+        d->singleImageFile.setFileName( d->imageFile.name() );
+        d->pipe->readFrom( &d->singleImageFile, true );
+    }
+    else if ( d->imageFinished )
         d->pipe->readFrom( &d->imageFile, true );
     else
         d->pipe->readFrom( m_isoImager->ioDevice(), true );
@@ -251,7 +494,15 @@ void K3b::DataJob::startPipe()
 bool K3b::DataJob::startOnTheFlyWriting()
 {
     qDebug();
-    if( prepareWriterJob() ) {
+    if( d->parallel ) {
+        if( !startParallelWriters() )
+            return false;
+        d->initializingImager = false;
+        m_isoImager->start();
+        startPipe();
+        return true;
+    }
+    else if( prepareWriterJob() ) {
         if( startWriterJob() ) {
             d->initializingImager = false;
             m_isoImager->start();
@@ -287,6 +538,8 @@ bool K3b::DataJob::cancelAll()
 {
     qDebug();
     bool somethingCanceled = false;
+    if ( d->prefetchBuffer )
+        d->prefetchBuffer->abort();
     if ( m_isoImager->active() ) {
         qDebug() << "cancelling iso imager";
         m_isoImager->cancel();
@@ -297,6 +550,21 @@ bool K3b::DataJob::cancelAll()
         m_writerJob->cancel();
         somethingCanceled = true;
     }
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        if( w->running ) {
+            qDebug() << "cancelling writing job on" << w->device->blockDeviceName();
+            w->writerJob->cancel();
+            somethingCanceled = true;
+        }
+        if( w->verificationJob && w->verificationJob->active() ) {
+            qDebug() << "cancelling verification job on" << w->device->blockDeviceName();
+            w->verificationJob->cancel();
+            somethingCanceled = true;
+        }
+        if( d->fanOut )
+            d->fanOut->dropSink( w->writerJob->ioDevice() );
+        w->outPipe.close();
+    }
     if( d->verificationJob && d->verificationJob->active() ) {
         qDebug() << "cancelling verification job";
         d->verificationJob->cancel();
@@ -307,6 +575,11 @@ bool K3b::DataJob::cancelAll()
         d->multiSessionParameterJob->cancel();
         somethingCanceled = true;
     }
+    if ( d->imageCacheJob->active() ) {
+        qDebug() << "cancelling imageCacheJob";
+        d->imageCacheJob->cancel();
+        somethingCanceled = true;
+    }
 
     qDebug() << somethingCanceled;
     return somethingCanceled;
@@ -363,8 +636,10 @@ void K3b::DataJob::slotIsoImagerFinished( bool success )
     }
     else {
         // cache the calculated checksum since the ChecksumPipe may be deleted below
-        if ( ChecksumPipe* cp = qobject_cast<ChecksumPipe*>( d->pipe ) )
+        if ( ChecksumPipe* cp = qobject_cast<ChecksumPipe*>( d->pipe ) ) {
             d->checksumCache = cp->checksum();
+            d->extentChecksumCache = cp->extentChecksums();
+        }
 
         if( !d->doc->onTheFly() ||
             d->doc->onlyCreateImages() ) {
@@ -373,9 +648,31 @@ void K3b::DataJob::slotIsoImagerFinished( bool success )
                 emit infoMessage( i18n("Image successfully created in %1", d->doc->tempDir()), K3b::Job::MessageSuccess );
                 d->imageFinished = true;
 
+                if( !d->cacheKey.isEmpty() && !d->imageFile.isSplit() ) {
+                    d->imageFile.close();
+
+                    //
+                    // An image which would be removed after writing is moved
+                    // into the cache and written from there. Otherwise the cache
+                    // gets a clone since the user may overwrite the image.
+                    //
+                    K3b::ImageCache cache = K3b::ImageCache::fromSettings();
+                    const bool move = d->doc->removeImages();
+                    if( cache.insertFile( d->cacheKey, d->doc->tempDir(), d->checksumCache, move ) && move )
+                        d->imageFile.setName( cache.lookup( d->cacheKey ) );
+                    d->cacheKey.clear();
+                }
+
                 if( d->doc->onlyCreateImages() ) {
                     jobFinished( true );
                 }
+                else if( d->parallel ) {
+                    d->imageFile.close();
+                    if( !startParallelWriters() ) {
+                        cleanup();
+                        jobFinished( false );
+                    }
+                }
                 else if( !d->imageFile.open( QIODevice::ReadOnly ) ) {
                     emit infoMessage( i18n("Could not open file %1", d->doc->tempDir() ), MessageError );
                     cleanup();
@@ -397,6 +694,20 @@ void K3b::DataJob::slotIsoImagerFinished( bool success )
                 jobFinished( false );
             }
         }
+        else if( d->parallel ) {
+            if( !success ) {
+                Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+                    if( w->running )
+                        w->writerJob->setSourceUnreadable( true );
+                }
+
+                if( m_isoImager->hasBeenCanceled() && !this->hasBeenCanceled() )
+                    cancel();
+            }
+
+            // the writers might have finished before the imager
+            finishParallelWriting();
+        }
         else { // on-the-fly
             if( success ) {
                 if ( !m_writerJob->active() )
@@ -482,6 +793,8 @@ void K3b::DataJob::finishCopy()
 {
     // the writerJob should have emitted the "simulation/writing successful" signal
 
+    finishImageCache();
+
     if( d->doc->verifyData() ) {
         if( !d->verificationJob ) {
             d->verificationJob = new K3b::VerificationJob( this, this );
@@ -503,8 +816,10 @@ void K3b::DataJob::finishCopy()
         }
         d->verificationJob->clear();
         d->verificationJob->setDevice( d->doc->burner() );
-        d->verificationJob->setGrownSessionSize( m_isoImager->size() );
-        d->verificationJob->addTrack( 0, d->checksumCache, m_isoImager->size() );
+        d->verificationJob->setGrownSessionSize( imageSize() );
+        d->verificationJob->addTrack( 0, d->checksumCache,
+                                      d->extentChecksumCache, K3b::VerificationJob::defaultExtentSize(),
+                                      imageSize() );
 
         emit burning(false);
 
@@ -521,7 +836,7 @@ void K3b::DataJob::finishCopy()
             }
 
             bool failed = false;
-            if( d->doc->onTheFly() )
+            if( d->doc->onTheFly() && !d->cachedImage )
                 failed = !startOnTheFlyWriting();
             else
                 failed = !prepareWriterJob() || !startWriterJob();
@@ -529,7 +844,7 @@ void K3b::DataJob::finishCopy()
             if( failed ) {
                 cancel();
             }
-            else if( !d->doc->onTheFly() ) {
+            else if( !d->doc->onTheFly() || d->cachedImage ) {
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
@@ -548,6 +863,20 @@ void K3b::DataJob::finishCopy()
 }
 
 
+void K3b::DataJob::finishImageCache()
+{
+    // the image has also been written to the cache while writing on-the-fly
+    if( d->fanOut && !d->cacheKey.isEmpty() ) {
+        d->fanOut->waitForSinks();
+        if( !d->fanOut->sinkDropped( &d->cacheFile ) )
+            K3b::ImageCache::fromSettings().insert( d->cacheKey, d->checksumCache );
+        else
+            QFile::remove( d->cacheFile.fileName() );
+        d->cacheKey.clear();
+    }
+}
+
+
 void K3b::DataJob::slotVerificationProgress( int p )
 {
     double totalTasks = d->copies*2;
@@ -575,14 +904,14 @@ void K3b::DataJob::slotVerificationFinished( bool success )
 
     if( !d->canceled && d->copiesDone < d->copies ) {
         bool failed = false;
-        if( d->doc->onTheFly() )
+        if( d->doc->onTheFly() && !d->cachedImage )
             failed = !startOnTheFlyWriting();
         else
             failed = !prepareWriterJob() || !startWriterJob();
 
         if( failed )
             cancel();
-        else if( !d->doc->onTheFly() ) {
+        else if( !d->doc->onTheFly() || d->cachedImage ) {
 #ifdef __GNUC__
 #warning Growisofs needs stdin to be closed in order to exit gracefully. Cdrecord does not. However,  if closed with cdrecord we loose parts of stderr. Why?
 #endif
@@ -597,6 +926,242 @@ void K3b::DataJob::slotVerificationFinished( bool success )
 }
 
 
+bool K3b::DataJob::startParallelWriters()
+{
+    qDebug();
+    qDeleteAll( d->parallelWriters );
+    d->parallelWriters.clear();
+
+    delete d->tocFile;
+    d->tocFile = 0;
+
+    const QList<K3b::Device::Device*> writers = QList<K3b::Device::Device*>() << d->doc->burner() << d->additionalWriters;
+
+    //
+    // Wait for all media before starting any of the writers. Otherwise the first
+    // drives might run out of data while the user is still inserting discs.
+    //
+    Q_FOREACH( K3b::Device::Device* dev, writers ) {
+        if( !waitForBurnMedium( dev ) )
+            return false;
+
+        Private::ParallelWriter* w = new Private::ParallelWriter( dev, createWriter( dev ),
+                                                                  d->usedWritingApp != K3b::WritingAppCdrecord );
+        d->parallelWriters.append( w );
+
+        connect( w->writerJob, SIGNAL(infoMessage(QString,int)), this, SLOT(slotParallelWriterInfoMessage(QString,int)) );
+        connect( w->writerJob, SIGNAL(percent(int)), this, SLOT(slotParallelWriterProgress(int)) );
+        connect( w->writerJob, SIGNAL(finished(bool)), this, SLOT(slotParallelWriterFinished(bool)) );
+        connect( w->writerJob, SIGNAL(debuggingOutput(QString,QString)),
+                 this, SIGNAL(debuggingOutput(QString,QString)) );
+    }
+
+    // the progress dialog only shows the buffers of one writer
+    K3b::AbstractWriter* firstWriter = d->parallelWriters.first()->writerJob;
+    connect( firstWriter, SIGNAL(buffer(int)), this, SIGNAL(bufferStatus(int)) );
+    connect( firstWriter, SIGNAL(deviceBuffer(int)), this, SIGNAL(deviceBuffer(int)) );
+    connect( firstWriter, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)) );
+
+    if( d->doc->dummy() )
+        emit newTask( i18np("Simulating on 1 drive", "Simulating on %1 drives", writers.count()) );
+    else
+        emit newTask( i18np("Writing on 1 drive", "Writing on %1 drives", writers.count()) );
+
+    emit burning(true);
+
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        w->running = true;
+        w->writerJob->start();
+
+        // on-the-fly the imager feeds all writers through the fan-out buffer
+        // (see startPipe()), otherwise every writer reads the image at its own pace
+        if( d->imageFinished ) {
+            if( d->imageFile.isSplit() ) {
+                w->imageFile.setName( d->imageFile.name() );
+                w->outPipe.readFrom( &w->imageFile, true );
+            }
+            else {
+                w->singleImageFile.setFileName( d->imageFile.name() );
+                w->outPipe.readFrom( &w->singleImageFile, true );
+            }
+            w->outPipe.writeTo( w->writerJob->ioDevice(), w->closeWhenDone );
+            w->outPipe.open( true );
+        }
+    }
+
+    return true;
+}
+
+
+void K3b::DataJob::slotParallelWriterInfoMessage( const QString& message, int type )
+{
+    if( Private::ParallelWriter* w = d->parallelWriter( sender() ) )
+        emit infoMessage( QString( "%1: %2" ).arg( w->device->blockDeviceName() ).arg( message ), type );
+    else
+        emit infoMessage( message, type );
+}
+
+
+void K3b::DataJob::slotParallelWriterProgress( int p )
+{
+    if( Private::ParallelWriter* w = d->parallelWriter( sender() ) ) {
+        w->writerPercent = p;
+        updateParallelProgress();
+    }
+}
+
+
+void K3b::DataJob::slotParallelVerificationProgress( int p )
+{
+    if( Private::ParallelWriter* w = d->parallelWriter( sender() ) ) {
+        w->verificationPercent = p;
+        updateParallelProgress();
+    }
+}
+
+
+void K3b::DataJob::updateParallelProgress()
+{
+    if( d->parallelWriters.isEmpty() )
+        return;
+
+    int sum = 0;
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        if( d->doc->verifyData() )
+            sum += ( w->writerPercent + w->verificationPercent )/2;
+        else
+            sum += w->writerPercent;
+    }
+    const int p = sum / d->parallelWriters.count();
+
+    // every drive writes one copy at the same time
+    double totalTasks = 1.0;
+    double tasksDone = 0.0;
+    if( d->doc->verifyData() )
+        totalTasks*=2;
+    if( !d->doc->onTheFly() ) {
+        totalTasks+=1.0;
+        tasksDone+=1.0;
+    }
+
+    emit subPercent( p );
+    emit percent( (int)((100.0*tasksDone + (double)p*(totalTasks-tasksDone)) / totalTasks) );
+}
+
+
+void K3b::DataJob::slotParallelWriterFinished( bool success )
+{
+    qDebug() << success;
+    Private::ParallelWriter* w = d->parallelWriter( sender() );
+    if( !w )
+        return;
+
+    w->running = false;
+    w->writerPercent = 100;
+
+    // a failed drive must not hold back the others
+    if( !success && d->fanOut )
+        d->fanOut->dropSink( w->writerJob->ioDevice() );
+
+    if( success && !d->canceled ) {
+        emit infoMessage( i18n("Successfully written copy on %1.", w->device->blockDeviceName()), MessageInfo );
+        w->written = true;
+    }
+    else if( !d->canceled ) {
+        emit infoMessage( i18n("Writing the copy on %1 failed.", w->device->blockDeviceName()), MessageError );
+    }
+
+    finishParallelWriting();
+}
+
+
+void K3b::DataJob::slotParallelVerificationFinished( bool success )
+{
+    Private::ParallelWriter* w = d->parallelWriter( sender() );
+    if( !w )
+        return;
+
+    w->verifying = false;
+    w->verificationPercent = 100;
+    w->success = success;
+
+    finishParallelWriting();
+}
+
+
+void K3b::DataJob::finishParallelWriting()
+{
+    qDebug();
+    if( !active() )
+        return;
+
+    // on-the-fly the checksums of the image are only known once the imager finished
+    if( m_isoImager->active() )
+        return;
+
+    bool writing = false;
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        if( w->running ) {
+            writing = true;
+        }
+        else if( w->written ) {
+            w->written = false;
+            if( d->doc->verifyData() && !d->canceled ) {
+                w->verificationJob = new K3b::VerificationJob( this, this );
+                connect( w->verificationJob, SIGNAL(infoMessage(QString,int)),
+                         this, SLOT(slotParallelWriterInfoMessage(QString,int)) );
+                connect( w->verificationJob, SIGNAL(percent(int)),
+                         this, SLOT(slotParallelVerificationProgress(int)) );
+                connect( w->verificationJob, SIGNAL(finished(bool)),
+                         this, SLOT(slotParallelVerificationFinished(bool)) );
+                connect( w->verificationJob, SIGNAL(debuggingOutput(QString,QString)),
+                         this, SIGNAL(debuggingOutput(QString,QString)) );
+
+                w->verificationJob->setDevice( w->device );
+                w->verificationJob->setGrownSessionSize( imageSize() );
+                w->verificationJob->addTrack( 0, d->checksumCache,
+                                              d->extentChecksumCache, K3b::VerificationJob::defaultExtentSize(),
+                                              imageSize() );
+                w->verifying = true;
+                w->verificationJob->start();
+            }
+            else {
+                w->success = !d->canceled;
+            }
+        }
+    }
+
+    if( !writing )
+        finishImageCache();
+
+    int succeeded = 0;
+    Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters ) {
+        if( w->running || w->verifying )
+            return;
+        if( w->success )
+            ++succeeded;
+    }
+
+    emit burning(false);
+
+    if( !d->canceled && k3bcore->globalSettings()->ejectMedia() ) {
+        Q_FOREACH( Private::ParallelWriter* w, d->parallelWriters )
+            K3b::Device::eject( w->device );
+    }
+
+    cleanup();
+
+    if( d->canceled ) {
+        jobFinished( false );
+    }
+    else {
+        if( succeeded < d->parallelWriters.count() )
+            emit infoMessage( i18n("Only %1 of %2 copies have been written successfully.", succeeded, d->parallelWriters.count()), MessageError );
+        jobFinished( succeeded == d->parallelWriters.count() );
+    }
+}
+
+
 void K3b::DataJob::setWriterJob( K3b::AbstractWriter* writer )
 {
     qDebug();
@@ -631,6 +1196,12 @@ void K3b::DataJob::setImager( K3b::IsoImager* imager )
 }
 
 
+void K3b::DataJob::setAdditionalWriterDevices( const QList<K3b::Device::Device*>& devs )
+{
+    d->additionalWriters = devs;
+}
+
+
 void K3b::DataJob::connectImager()
 {
     qDebug();
@@ -660,35 +1231,35 @@ bool K3b::DataJob::prepareWriterJob()
     }
 
     // if we append a new session we asked for an appendable cd already
-    if( !waitForBurnMedium() ) {
+    if( !waitForBurnMedium( d->doc->burner() ) ) {
         return false;
     }
 
-    // It seems as if cdrecord is not able to append sessions in dao mode whereas cdrdao is
-    if( d->usedWritingApp == K3b::WritingAppCdrecord )  {
-        if( !setupCdrecordJob() ) {
-            return false;
-        }
-    }
-    else if ( d->usedWritingApp == K3b::WritingAppCdrdao ) {
-        if ( !setupCdrdaoJob() ) {
-            return false;
-        }
-    }
-    else {
-        if ( !setupGrowisofsJob() ) {
-            return false;
-        }
-    }
+    delete d->tocFile;
+    d->tocFile = 0;
+
+    setWriterJob( createWriter( d->doc->burner() ) );
 
     return true;
 }
 
 
-bool K3b::DataJob::waitForBurnMedium()
+K3b::AbstractWriter* K3b::DataJob::createWriter( K3b::Device::Device* dev )
+{
+    // It seems as if cdrecord is not able to append sessions in dao mode whereas cdrdao is
+    if( d->usedWritingApp == K3b::WritingAppCdrecord )
+        return createCdrecordWriter( dev );
+    else if ( d->usedWritingApp == K3b::WritingAppCdrdao )
+        return createCdrdaoWriter( dev );
+    else
+        return createGrowisofsWriter( dev );
+}
+
+
+bool K3b::DataJob::waitForBurnMedium( K3b::Device::Device* dev )
 {
     // start with all media types supported by the writer
-    Device::MediaTypes m  = d->doc->supportedMediaTypes() & d->doc->burner()->writeCapabilities();
+    Device::MediaTypes m  = d->doc->supportedMediaTypes() & dev->writeCapabilities();
     // if everything goes wrong we are left with no possible media to request
     if ( !m ) {
         emit infoMessage( i18n( "Internal Error: No medium type fits. This project cannot be burned." ), MessageError );
@@ -696,7 +1267,7 @@ bool K3b::DataJob::waitForBurnMedium()
     }
     const K3b::ExternalBin* cdrecordBin = k3bcore->externalBinManager()->binObject("cdrecord");
     emit newSubTask( i18n("Waiting for a medium") );
-    Device::MediaType foundMedium = waitForMedium( d->doc->burner(),
+    Device::MediaType foundMedium = waitForMedium( dev,
                                                    usedMultiSessionMode() == K3b::DataDoc::CONTINUE ||
                                                    usedMultiSessionMode() == K3b::DataDoc::FINISH ?
                                                    K3b::Device::STATE_INCOMPLETE :
@@ -726,7 +1297,7 @@ bool K3b::DataJob::waitForBurnMedium()
                 qDebug() << "(K3b::DataJob) determining last track's datamode...";
 
                 // FIXME: use the DeviceHandler
-                K3b::Device::Toc toc = d->doc->burner()->readToc();
+                K3b::Device::Toc toc = dev->readToc();
                 if( toc.isEmpty() ) {
                     qDebug() << "(K3b::DataJob) could not retrieve toc.";
                     emit infoMessage( i18n("Unable to determine the last track's datamode. Using default."), MessageError );
@@ -755,7 +1326,7 @@ bool K3b::DataJob::waitForBurnMedium()
         if( d->doc->writingMode() == K3b::WritingModeAuto ) {
             // TODO: put this into the cdreocrdwriter and decide based on the size of the
             // track
-            if( writer()->dao() && d->usedDataMode == K3b::DataMode1 &&
+            if( dev->dao() && d->usedDataMode == K3b::DataMode1 &&
                 usedMultiSessionMode() == K3b::DataDoc::NONE )
                 d->usedWritingMode = K3b::WritingModeSao;
             else
@@ -844,12 +1415,12 @@ bool K3b::DataJob::waitForBurnMedium()
         // DVD Minus
         // -------------------------------
         else if ( foundMedium & K3b::Device::MEDIA_DVD_MINUS_ALL ) {
-            if( d->doc->dummy() && !d->doc->burner()->dvdMinusTestwrite() ) {
+            if( d->doc->dummy() && !dev->dvdMinusTestwrite() ) {
                 if( !questionYesNo( i18n("Your writer (%1 %2) does not support simulation with DVD-R(W) media. "
                                          "Do you really want to continue? The media will actually be "
                                          "written to.",
-                                         d->doc->burner()->vendor(),
-                                         d->doc->burner()->description()),
+                                         dev->vendor(),
+                                         dev->description()),
                                     i18n("No Simulation with DVD-R(W)") ) ) {
                     return false;
                 }
@@ -887,11 +1458,11 @@ bool K3b::DataJob::waitForBurnMedium()
                 else {
                     // check if the writer supports writing sequential and thus multisession (on -1 the burner cannot handle
                     // features and we simply ignore it and hope for the best)
-                    if( d->doc->burner()->featureCurrent( K3b::Device::FEATURE_INCREMENTAL_STREAMING_WRITABLE ) == 0 ) {
+                    if( dev->featureCurrent( K3b::Device::FEATURE_INCREMENTAL_STREAMING_WRITABLE ) == 0 ) {
                         if( !questionYesNo( i18n("Your writer (%1 %2) does not support Incremental Streaming with %3 "
                                                  "media. Multisession will not be possible. Continue anyway?",
-                                                 d->doc->burner()->vendor(),
-                                                 d->doc->burner()->description(),
+                                                 dev->vendor(),
+                                                 dev->description(),
                                                  K3b::Device::mediaTypeString(foundMedium, true) ),
                                             i18n("No Incremental Streaming") ) ) {
                             return false;
@@ -988,7 +1559,15 @@ QString K3b::DataJob::jobDescription() const
 
 QString K3b::DataJob::jobDetails() const
 {
-    if( d->doc->copies() > 1 &&
+    // every drive writes one copy
+    if( !d->additionalWriters.isEmpty() &&
+        !d->doc->onlyCreateImages() &&
+        d->doc->multiSessionMode() == K3b::DataDoc::NONE )
+        return i18np("ISO 9660 Filesystem (Size: %2) – One copy",
+                     "ISO 9660 Filesystem (Size: %2) – %1 copies",
+                     d->additionalWriters.count()+1,
+                     KIO::convertSize( d->doc->size() ) );
+    else if( d->doc->copies() > 1 &&
         !d->doc->dummy() &&
         !(d->doc->multiSessionMode() == K3b::DataDoc::CONTINUE ||
           d->doc->multiSessionMode() == K3b::DataDoc::FINISH) )
@@ -1011,13 +1590,17 @@ K3b::DataDoc::MultiSessionMode K3b::DataJob::usedMultiSessionMode() const
 void K3b::DataJob::cleanup()
 {
     qDebug();
-    if( !d->doc->onTheFly() && ( d->doc->removeImages() || d->canceled ) ) {
+    if( !d->doc->onTheFly() && !d->cachedImage && ( d->doc->removeImages() || d->canceled ) ) {
         if( QFile::exists( d->doc->tempDir() ) ) {
             d->imageFile.remove();
             emit infoMessage( i18n("Removed image file %1",d->doc->tempDir()), K3b::Job::MessageSuccess );
         }
     }
 
+    // an image which did not make it into the cache
+    if( d->fanOut && !d->cacheKey.isEmpty() )
+        QFile::remove( d->cacheFile.fileName() );
+
     if( d->tocFile ) {
         delete d->tocFile;
         d->tocFile = 0;
@@ -1031,10 +1614,10 @@ bool K3b::DataJob::hasBeenCanceled() const
 }
 
 
-bool K3b::DataJob::setupCdrecordJob()
+K3b::AbstractWriter* K3b::DataJob::createCdrecordWriter( K3b::Device::Device* dev )
 {
     qDebug();
-    K3b::CdrecordWriter* writer = new K3b::CdrecordWriter( d->doc->burner(), this, this );
+    K3b::CdrecordWriter* writer = new K3b::CdrecordWriter( dev, this, this );
 
     // cdrecord manpage says that "not all" writers are able to write
     // multisession disks in dao mode. That means there are writers that can.
@@ -1070,18 +1653,16 @@ bool K3b::DataJob::setupCdrecordJob()
             writer->addArgument( "-xa1" );
     }
 
-    writer->addArgument( QString("-tsize=%1s").arg(m_isoImager->size()) )->addArgument("-");
+    writer->addArgument( QString("-tsize=%1s").arg(imageSize()) )->addArgument("-");
 
-    setWriterJob( writer );
-
-    return true;
+    return writer;
 }
 
 
-bool K3b::DataJob::setupCdrdaoJob()
+K3b::AbstractWriter* K3b::DataJob::createCdrdaoWriter( K3b::Device::Device* dev )
 {
     // create cdrdao job
-    K3b::CdrdaoWriter* writer = new K3b::CdrdaoWriter( d->doc->burner(), this, this );
+    K3b::CdrdaoWriter* writer = new K3b::CdrdaoWriter( dev, this, this );
     writer->setCommand( K3b::CdrdaoWriter::WRITE );
     writer->setSimulate( d->doc->dummy() );
     writer->setBurnSpeed( d->doc->speed() );
@@ -1089,38 +1670,37 @@ bool K3b::DataJob::setupCdrdaoJob()
     writer->setMulti( usedMultiSessionMode() == K3b::DataDoc::START ||
                       usedMultiSessionMode() == K3b::DataDoc::CONTINUE );
 
-    // now write the tocfile
-    if( d->tocFile ) delete d->tocFile;
-    d->tocFile = new QTemporaryFile( "XXXXXX.toc" );
-    d->tocFile->open();
+    // now write the tocfile which is shared by all writers of the same copy
+    if( !d->tocFile ) {
+        d->tocFile = new QTemporaryFile( "XXXXXX.toc" );
+        d->tocFile->open();
 
-    QTextStream s( d->tocFile );
-    if( d->usedDataMode == K3b::DataMode1 ) {
-        s << "CD_ROM" << "\n";
-        s << "\n";
-        s << "TRACK MODE1" << "\n";
-    }
-    else {
-        s << "CD_ROM_XA" << "\n";
-        s << "\n";
-        s << "TRACK MODE2_FORM1" << "\n";
-    }
+        QTextStream s( d->tocFile );
+        if( d->usedDataMode == K3b::DataMode1 ) {
+            s << "CD_ROM" << "\n";
+            s << "\n";
+            s << "TRACK MODE1" << "\n";
+        }
+        else {
+            s << "CD_ROM_XA" << "\n";
+            s << "\n";
+            s << "TRACK MODE2_FORM1" << "\n";
+        }
 
-    s << "DATAFILE \"-\" " << m_isoImager->size()*2048 << "\n";
+        s << "DATAFILE \"-\" " << imageSize()*2048 << "\n";
 
-    d->tocFile->close();
+        d->tocFile->close();
+    }
 
     writer->setTocFile( d->tocFile->fileName() );
 
-    setWriterJob( writer );
-
-    return true;
+    return writer;
 }
 
 
-bool K3b::DataJob::setupGrowisofsJob()
+K3b::AbstractWriter* K3b::DataJob::createGrowisofsWriter( K3b::Device::Device* dev )
 {
-    K3b::GrowisofsWriter* writer = new K3b::GrowisofsWriter( d->doc->burner(), this, this );
+    K3b::GrowisofsWriter* writer = new K3b::GrowisofsWriter( dev, this, this );
 
     // these do only make sense with DVD-R(W)
     writer->setSimulate( d->doc->dummy() );
@@ -1140,7 +1720,7 @@ bool K3b::DataJob::setupGrowisofsJob()
                          usedMultiSessionMode() == K3b::DataDoc::FINISH );
 
     writer->setImageToWrite( QString() );  // read from stdin
-    writer->setTrackSize( m_isoImager->size() );
+    writer->setTrackSize( imageSize() );
 
     if( usedMultiSessionMode() != K3b::DataDoc::NONE ) {
         //
@@ -1150,9 +1730,7 @@ bool K3b::DataJob::setupGrowisofsJob()
         writer->setMultiSessionInfo( m_isoImager->multiSessionInfo() );
     }
 
-    setWriterJob( writer );
-
-    return true;
+    return writer;
 }
 
 #include "moc_k3bdatajob.cpp"
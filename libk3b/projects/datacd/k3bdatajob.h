@@ -8,8 +8,10 @@
 
 #include "k3bjob.h"
 #include "k3bdatadoc.h"
+#include "k3b_export.h"
 
 #include <QFile>
+#include <QList>
 
 class QString;
 
@@ -22,7 +24,7 @@ namespace K3b {
         class Device;
     }
 
-    class DataJob : public BurnJob
+    class LIBK3B_EXPORT DataJob : public BurnJob
     {
         Q_OBJECT
 
@@ -50,6 +52,17 @@ namespace K3b {
         void setWriterJob( AbstractWriter* );
         void setImager( IsoImager* );
 
+        /**
+         * Write the project on each of these drives at the same time as on
+         * the burner of the project. All drives are fed from the same image
+         * or on-the-fly stream and every copy is verified on its own drive.
+         *
+         * This is only possible for projects which are not written as
+         * multisession. In this mode every drive writes exactly one copy,
+         * the copies of the project are ignored.
+         */
+        void setAdditionalWriterDevices( const QList<K3b::Device::Device*>& devs );
+
     protected Q_SLOTS:
         void slotIsoImagerFinished( bool success );
         void slotIsoImagerPercent(int);
@@ -69,6 +82,13 @@ namespace K3b {
 
     private Q_SLOTS:
         void slotMultiSessionParamterSetupDone( bool );
+        void slotImageCacheLookupDone( bool );
+
+        void slotParallelWriterInfoMessage( const QString& message, int type );
+        void slotParallelWriterProgress( int p );
+        void slotParallelWriterFinished( bool success );
+        void slotParallelVerificationProgress( int p );
+        void slotParallelVerificationFinished( bool success );
 
     protected:
         virtual bool prepareWriterJob();
@@ -81,16 +101,32 @@ namespace K3b {
         IsoImager* m_isoImager;
 
     private:
-        bool waitForBurnMedium();
+        bool waitForBurnMedium( Device::Device* dev );
         bool startWriterJob();
         bool startOnTheFlyWriting();
         void prepareWriting();
+        void writeCachedImage( const QString& path );
         void connectImager();
-        bool setupCdrecordJob();
-        bool setupCdrdaoJob();
-        bool setupGrowisofsJob();
+
+        /**
+         * Creates the writer for @p dev. Call waitForBurnMedium() for the
+         * device first, it determines the writing application and mode.
+         */
+        AbstractWriter* createWriter( Device::Device* dev );
+        AbstractWriter* createCdrecordWriter( Device::Device* dev );
+        AbstractWriter* createCdrdaoWriter( Device::Device* dev );
+        AbstractWriter* createGrowisofsWriter( Device::Device* dev );
         void startPipe();
         void finishCopy();
+        void finishImageCache();
+        bool startParallelWriters();
+        void updateParallelProgress();
+        void finishParallelWriting();
+
+        /**
+         * The size of the image in sectors.
+         */
+        int imageSize() const;
 
         class Private;
         Private* d;
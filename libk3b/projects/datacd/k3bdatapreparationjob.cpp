@@ -15,9 +15,16 @@
 
 #include <KStringHandler>
 
+#include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
+#include <QHash>
 #include <QList>
+#include <QMap>
+#include <QPair>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
 
 namespace {
     QString createItemsString( const QList<K3b::DataItem*>& items, int max )
@@ -41,6 +48,70 @@ namespace {
 
         return s;
     }
+
+
+    // files up to twice this size are completely covered by the partial hash
+    const qint64 s_partialHashSize = 64*1024;
+
+    /**
+     * Hashes the first and the last block of a file or the complete
+     * file if it is small.
+     */
+    QByteArray partialHash( const QString& path, KIO::filesize_t size )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return QByteArray();
+
+        QCryptographicHash hash( QCryptographicHash::Sha1 );
+        if( size <= KIO::filesize_t( 2*s_partialHashSize ) ) {
+            if( !hash.addData( &f ) )
+                return QByteArray();
+        }
+        else {
+            hash.addData( f.read( s_partialHashSize ) );
+            if( !f.seek( size - s_partialHashSize ) )
+                return QByteArray();
+            hash.addData( f.read( s_partialHashSize ) );
+        }
+        return hash.result();
+    }
+
+
+    QByteArray fullHash( const QString& path )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return QByteArray();
+
+        QCryptographicHash hash( QCryptographicHash::Sha256 );
+        if( !hash.addData( &f ) )
+            return QByteArray();
+        return hash.result();
+    }
+
+
+    /**
+     * Hashes the files on a thread pool. Only a few threads are used since
+     * the hashing is mostly bound by the disk.
+     */
+    template<typename HashFunction>
+    QVector<QByteArray> hashFiles( const QVector<K3b::FileItem*>& files, HashFunction hashFunction )
+    {
+        QVector<QByteArray> hashes( files.count() );
+        QThreadPool pool;
+        pool.setMaxThreadCount( qBound( 1, QThread::idealThreadCount(), 4 ) );
+        for( int i = 0; i < files.count(); ++i ) {
+            pool.start( [&, i]() {
+                hashes[i] = hashFunction( files[i] );
+            } );
+        }
+        pool.waitForDone();
+        return hashes;
+    }
+
+
+    typedef QPair<KIO::filesize_t, QByteArray> ContentKey;
 }
 
 
@@ -52,6 +123,9 @@ public:
     QList<K3b::DataItem*> nonExistingItems;
     QString listOfRenamedItems;
     QList<K3b::DataItem*> folderSymLinkItems;
+
+    // applied to the project on the GUI thread once the job is done
+    QHash<K3b::FileItem*, K3b::FileItem*> contentSources;
 };
 
 
@@ -76,6 +150,7 @@ bool K3b::DataPreparationJob::run()
     d->nonExistingItems.clear();
     d->listOfRenamedItems.truncate(0);
     d->folderSymLinkItems.clear();
+    d->contentSources.clear();
 
     // initialize filenames in the project
     d->doc->prepareFilenames();
@@ -204,6 +279,132 @@ bool K3b::DataPreparationJob::run()
         }
     }
 
+    //
+    // Search for files with identical contents. Without the option the results
+    // of the last search are reset in jobFinished().
+    //
+    if( d->doc->isoOptions().deduplicateFiles() ) {
+        if( !findDuplicateFiles() )
+            return false;
+    }
+
+    return true;
+}
+
+
+void K3b::DataPreparationJob::jobFinished( bool success )
+{
+    // the project must only be changed on the GUI thread
+    if( success )
+        d->doc->setContentSources( d->contentSources );
+    d->contentSources.clear();
+
+    K3b::ThreadJob::jobFinished( success );
+}
+
+
+bool K3b::DataPreparationJob::findDuplicateFiles()
+{
+    //
+    // Hardlinks share their data anyway, so only one file per inode is compared.
+    // The candidates are grouped by size, then by a hash of their first and last
+    // block, and only then by a hash of the complete contents.
+    //
+    QMap<K3b::FileItem::Id, QVector<K3b::FileItem*> > inodeItems;
+    QMap<KIO::filesize_t, QVector<K3b::FileItem*> > sizeGroups;
+
+    K3b::DataItem* item = d->doc->root();
+    while( (item = item->nextSibling()) ) {
+        if( !item->isFile() || item->isSymLink() || item->isBootItem() || !item->writeToCd() )
+            continue;
+
+        K3b::FileItem* fileItem = static_cast<K3b::FileItem*>( item );
+        const K3b::FileItem::Id id = fileItem->localId( false );
+        if( fileItem->itemSize( false ) == 0 || ( id.device == 0 && id.inode == 0 ) )
+            continue;
+
+        QVector<K3b::FileItem*>& items = inodeItems[id];
+        if( items.isEmpty() )
+            sizeGroups[fileItem->itemSize( false )].append( fileItem );
+        items.append( fileItem );
+    }
+
+    QVector<K3b::FileItem*> candidates;
+    for( QMap<KIO::filesize_t, QVector<K3b::FileItem*> >::const_iterator it = sizeGroups.constBegin();
+         it != sizeGroups.constEnd(); ++it ) {
+        if( it.value().count() > 1 )
+            candidates += it.value();
+    }
+
+    QList<QVector<K3b::FileItem*> > duplicates;
+
+    if( !candidates.isEmpty() ) {
+        const QVector<QByteArray> partialHashes = hashFiles( candidates, [this]( K3b::FileItem* f ) {
+            return canceled() ? QByteArray() : partialHash( f->localPath(), f->itemSize( false ) );
+        } );
+        if( canceled() )
+            return false;
+
+        QMap<ContentKey, QVector<K3b::FileItem*> > partialGroups;
+        for( int i = 0; i < candidates.count(); ++i ) {
+            if( !partialHashes[i].isEmpty() )
+                partialGroups[ContentKey( candidates[i]->itemSize( false ), partialHashes[i] )].append( candidates[i] );
+        }
+
+        QVector<K3b::FileItem*> fullCandidates;
+        for( QMap<ContentKey, QVector<K3b::FileItem*> >::const_iterator it = partialGroups.constBegin();
+             it != partialGroups.constEnd(); ++it ) {
+            if( it.value().count() > 1 ) {
+                // small files have been hashed completely already
+                if( it.key().first <= KIO::filesize_t( 2*s_partialHashSize ) )
+                    duplicates.append( it.value() );
+                else
+                    fullCandidates += it.value();
+            }
+        }
+
+        const QVector<QByteArray> fullHashes = hashFiles( fullCandidates, [this]( K3b::FileItem* f ) {
+            return canceled() ? QByteArray() : fullHash( f->localPath() );
+        } );
+        if( canceled() )
+            return false;
+
+        QMap<ContentKey, QVector<K3b::FileItem*> > fullGroups;
+        for( int i = 0; i < fullCandidates.count(); ++i ) {
+            if( !fullHashes[i].isEmpty() )
+                fullGroups[ContentKey( fullCandidates[i]->itemSize( false ), fullHashes[i] )].append( fullCandidates[i] );
+        }
+        for( QMap<ContentKey, QVector<K3b::FileItem*> >::const_iterator it = fullGroups.constBegin();
+             it != fullGroups.constEnd(); ++it ) {
+            if( it.value().count() > 1 )
+                duplicates.append( it.value() );
+        }
+    }
+
+    //
+    // The first file of each group provides the contents for all others (including their hardlinks)
+    //
+    QHash<K3b::FileItem*, K3b::FileItem*> sources;
+    KIO::filesize_t savedSize = 0;
+    Q_FOREACH( const QVector<K3b::FileItem*>& group, duplicates ) {
+        K3b::FileItem* source = group.first();
+        for( int i = 1; i < group.count(); ++i ) {
+            Q_FOREACH( K3b::FileItem* fileItem, inodeItems.value( group[i]->localId( false ) ) ) {
+                sources.insert( fileItem, source );
+            }
+            savedSize += source->itemSize( false );
+        }
+    }
+
+    d->contentSources = sources;
+
+    if( !sources.isEmpty() ) {
+        emit infoMessage( i18np( "Found %1 file with the same contents as another file. It will be stored only once (%2 saved).",
+                                 "Found %1 files with the same contents as other files. They will be stored only once (%2 saved).",
+                                 sources.count(), KIO::convertSize( savedSize ) ),
+                          MessageInfo );
+    }
+
     return true;
 }
 
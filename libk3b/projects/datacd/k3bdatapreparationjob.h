@@ -16,6 +16,9 @@ namespace K3b {
     /**
      * The DataPreparationJob performs some checks on the data in a data project
      * It is used by th IsoImager.
+     *
+     * If IsoOptions::deduplicateFiles() is enabled it also searches for files
+     * with identical contents (see DataDoc::setContentSources()).
      */
     class DataPreparationJob : public ThreadJob
     {
@@ -25,8 +28,12 @@ namespace K3b {
         DataPreparationJob( DataDoc* doc, JobHandler* hdl, QObject* parent );
         ~DataPreparationJob() override;
 
+    protected:
+        void jobFinished( bool success ) override;
+
     private:
         bool run() override;
+        bool findDuplicateFiles();
 
         class Private;
         Private* const d;
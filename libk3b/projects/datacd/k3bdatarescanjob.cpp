@@ -0,0 +1,524 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdatarescanjob.h"
+#include "k3bdatadoc.h"
+#include "k3bdiritem.h"
+#include "k3bfileitem.h"
+#include "k3bisooptions.h"
+#include "k3bsimplejobhandler.h"
+#include "k3bglobals.h"
+#include "k3b_i18n.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QStringList>
+
+
+namespace {
+    /**
+     * One entry of a local directory as seen by the rescan thread.
+     */
+    struct LocalEntry
+    {
+        LocalEntry()
+            : followed( false ),
+              isDir( false ),
+              add( false ),
+              subScan( -1 ) {
+        }
+
+        QString name;
+        k3b_struct_stat statBuf;
+        k3b_struct_stat followedStatBuf;
+        bool followed;
+
+        // the entry becomes a DirItem if it is added
+        bool isDir;
+
+        // the entry is new and accepted by the add options of the directory
+        bool add;
+
+        // the index of the scan of the entry's contents if it becomes a new DirItem
+        int subScan;
+    };
+
+
+    struct LocalDirScan
+    {
+        LocalDirScan()
+            : dir( 0 ),
+              mtime( 0 ),
+              ctime( 0 ),
+              changed( false ) {
+        }
+
+        // set on the GUI thread. dir is 0 for folders which are not part of the project yet.
+        K3b::DirItem* dir;
+        QString localPath;
+        qint64 mtime;
+        qint64 ctime;
+        K3b::DirItem::LocalAddOptions options;
+        QSet<QString> knownEntries;
+        QHash<QString, bool> itemPaths; // local path -> is a folder
+
+        // set by the rescan thread
+        bool changed;
+        QString resolvedPath;
+        QSet<QString> entryNames;
+        QList<LocalEntry> entries;
+    };
+
+
+    /**
+     * Removes trailing backslashes from a local file name.
+     * See comments in k3bisoimager.cpp (escapeGraftPoint()).
+     */
+    QString localItemName( const QString& fileName )
+    {
+        QString name( fileName );
+        while( !name.isEmpty() && name[name.length()-1] == '\\' )
+            name.truncate( name.length()-1 );
+
+        // backup dummy name
+        if( name.isEmpty() )
+            name = '1';
+
+        return name;
+    }
+
+
+    bool isSystemFile( mode_t mode )
+    {
+        return( S_ISCHR( mode ) || S_ISBLK( mode ) || S_ISFIFO( mode ) || S_ISSOCK( mode ) );
+    }
+
+
+    /**
+     * Items added from elsewhere, special items like boot images and old session
+     * items are not backed by a local entry and left alone by the rescan.
+     */
+    bool isLocalItem( const K3b::DataItem* item )
+    {
+        return !( item->isFromOldSession() || item->isBootItem() || item->isSpecialFile() || item->localPath().isEmpty() );
+    }
+
+
+    void collectDirs( K3b::DirItem* dir, QSet<K3b::DirItem*>& dirs )
+    {
+        dirs.insert( dir );
+        Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+            if( item->isDir() )
+                collectDirs( static_cast<K3b::DirItem*>( item ), dirs );
+        }
+    }
+}
+
+
+class K3b::DataRescanJob::Private
+{
+public:
+    Private()
+        : doc( 0 ),
+          dir( 0 ),
+          followLinks( false ),
+          changes( 0 ) {
+    }
+
+    void collect( DirItem* dir );
+    void scan( int index );
+    void apply( int index );
+    DataItem* createItem( LocalDirScan& scan, const LocalEntry& entry, const QString& name );
+
+    DataDoc* doc;
+    DirItem* dir;
+    bool followLinks;
+    int changes;
+
+    QList<LocalDirScan> scans;
+
+    // the folders of the project while applying the changes
+    QSet<DirItem*> dirs;
+};
+
+
+void K3b::DataRescanJob::Private::collect( DirItem* dirItem )
+{
+    if( !dirItem->localPath().isEmpty() ) {
+        LocalDirScan s;
+        s.dir = dirItem;
+        s.localPath = dirItem->localPath();
+        s.mtime = dirItem->localMTime();
+        s.ctime = dirItem->localCTime();
+        s.options = dirItem->localAddOptions();
+        s.knownEntries = dirItem->localEntries();
+        Q_FOREACH( DataItem* item, dirItem->children() ) {
+            if( isLocalItem( item ) )
+                s.itemPaths.insert( item->localPath(), item->isDir() );
+        }
+        scans.append( s );
+    }
+
+    // changes deeper in the tree do not touch the parent's timestamps, thus we always descend
+    Q_FOREACH( DataItem* item, dirItem->children() ) {
+        if( item->isDir() )
+            collect( static_cast<DirItem*>( item ) );
+    }
+}
+
+
+//
+// Runs in the rescan thread. Only touches the snapshot, never the project.
+//
+void K3b::DataRescanJob::Private::scan( int index )
+{
+    LocalDirScan s = scans.at( index );
+
+    QFileInfo info( s.localPath );
+    const qint64 mtime = info.isDir() ? info.lastModified().toMSecsSinceEpoch() : 0;
+    const qint64 ctime = info.isDir() ? info.metadataChangeTime().toMSecsSinceEpoch() : 0;
+
+    // only folders which changed on disk need to be listed
+    if( ( s.mtime != 0 || s.ctime != 0 ) && info.isDir() && mtime == s.mtime && ctime == s.ctime )
+        return;
+
+    // the timestamps are recorded before reading so changes made meanwhile are caught next time
+    s.changed = true;
+    s.mtime = mtime;
+    s.ctime = ctime;
+
+    const QString localDir = QDir::cleanPath( s.localPath );
+    s.resolvedPath = QDir::cleanPath( K3b::resolveLink( localDir ) );
+
+    // the local names of the items created from this folder
+    QHash<QString, bool> items;
+    for( QHash<QString, bool>::const_iterator it = s.itemPaths.constBegin(); it != s.itemPaths.constEnd(); ++it ) {
+        const QString path = QDir::cleanPath( it.key() );
+        const QString parentPath = path.section( '/', 0, -2 );
+        if( parentPath == localDir || parentPath == s.resolvedPath )
+            items.insert( path.section( '/', -1 ), it.value() );
+    }
+
+    QList<LocalDirScan> subScans;
+    const QStringList entryList = QDir( s.resolvedPath ).entryList( QDir::AllEntries|QDir::System|QDir::Hidden|QDir::NoDotAndDotDot );
+    for( QStringList::const_iterator it = entryList.constBegin(); it != entryList.constEnd(); ++it ) {
+        s.entryNames.insert( *it );
+
+        // the user did not add the entry or removed it from the project
+        const bool isItem = items.contains( *it );
+        if( !isItem && s.knownEntries.contains( *it ) )
+            continue;
+
+        LocalEntry entry;
+        entry.name = *it;
+        const QString path = s.resolvedPath + '/' + *it;
+        const QByteArray encodedPath = QFile::encodeName( path );
+        if( k3b_lstat( encodedPath, &entry.statBuf ) != 0 )
+            continue;
+        entry.followed = ( k3b_stat( encodedPath, &entry.followedStatBuf ) == 0 );
+
+        bool systemFile = false;
+        if( S_ISLNK( entry.statBuf.st_mode ) ) {
+            systemFile = ( !entry.followed || isSystemFile( entry.followedStatBuf.st_mode ) );
+
+            // a link which points to some folder above itself starts a loop and cannot be followed
+            if( entry.followed && S_ISDIR( entry.followedStatBuf.st_mode ) &&
+                ( followLinks || s.options.testFlag( DirItem::FollowFolderLinks ) ) &&
+                !path.startsWith( K3b::resolveLink( path ) ) )
+                entry.isDir = true;
+        }
+        else {
+            systemFile = isSystemFile( entry.statBuf.st_mode );
+            entry.isDir = S_ISDIR( entry.statBuf.st_mode );
+        }
+
+        if( !isItem ) {
+            if( it->startsWith( '.' ) && !s.options.testFlag( DirItem::AddHiddenFiles ) )
+                continue;
+            if( systemFile && !s.options.testFlag( DirItem::AddSystemFiles ) )
+                continue;
+            entry.add = true;
+        }
+
+        // new folders and files which have been replaced by a folder are read completely
+        if( ( entry.add && entry.isDir ) ||
+            ( isItem && !items.value( *it ) && S_ISDIR( entry.statBuf.st_mode ) ) ) {
+            LocalDirScan subScan;
+            subScan.localPath = path;
+            subScan.options = s.options;
+            entry.subScan = scans.count() + subScans.count();
+            subScans.append( subScan );
+        }
+
+        s.entries.append( entry );
+    }
+
+    scans[index] = s;
+    scans.append( subScans );
+}
+
+
+//
+// Runs on the GUI thread once the rescan thread is done.
+//
+void K3b::DataRescanJob::Private::apply( int index )
+{
+    LocalDirScan& s = scans[index];
+    DirItem* dirItem = s.dir;
+
+    dirItem->setLocalTimestamps( s.mtime, s.ctime );
+    dirItem->setLocalEntries( s.entryNames );
+
+    const QString localDir = QDir::cleanPath( s.localPath );
+    QHash<QString, int> entryIndex;
+    for( int i = 0; i < s.entries.count(); ++i )
+        entryIndex.insert( s.entries.at( i ).name, i );
+
+    //
+    // Compare the items which have been created from this folder with its current contents.
+    //
+    QList<int> staleRows;
+    QHash<DataItem*, int> updatedItems;
+    QSet<int> recreatedEntries;
+    const DirItem::Children& children = dirItem->children();
+    for( int i = 0; i < children.count(); ++i ) {
+        DataItem* item = children.at( i );
+        if( !isLocalItem( item ) )
+            continue;
+
+        const QString path = QDir::cleanPath( item->localPath() );
+        const QString parentPath = path.section( '/', 0, -2 );
+        if( parentPath != localDir && parentPath != s.resolvedPath )
+            continue;
+
+        const int entry = entryIndex.value( path.section( '/', -1 ), -1 );
+        if( entry < 0 ) {
+            staleRows.append( i );
+            continue;
+        }
+
+        const LocalEntry& e = s.entries.at( entry );
+        if( item->isDir() ) {
+            if( !S_ISDIR( e.statBuf.st_mode ) && !( e.followed && S_ISDIR( e.followedStatBuf.st_mode ) ) ) {
+                // replaced by a file: recreate it
+                staleRows.append( i );
+                recreatedEntries.insert( entry );
+            }
+        }
+        else if( item->isFile() ) {
+            if( S_ISDIR( e.statBuf.st_mode ) ) {
+                // replaced by a folder: recreate it
+                staleRows.append( i );
+                recreatedEntries.insert( entry );
+                continue;
+            }
+
+            FileItem* fileItem = static_cast<FileItem*>( item );
+            const FileItem::Id id = fileItem->localId( false );
+            if( fileItem->itemSize( false ) != (KIO::filesize_t)e.statBuf.st_size ||
+                id.device != e.statBuf.st_dev ||
+                id.inode != e.statBuf.st_ino ||
+                fileItem->isSymLink() != ( S_ISLNK( e.statBuf.st_mode ) != 0 ) ||
+                ( e.followed && fileItem->itemSize( true ) != (KIO::filesize_t)e.followedStatBuf.st_size ) ) {
+                // the item is taken out and reinserted with the new size to keep the size accounting correct
+                staleRows.append( i );
+                updatedItems.insert( item, entry );
+            }
+        }
+    }
+
+    DirItem::Children newItems;
+
+    //
+    // Remove the stale items in contiguous chunks. We go back to front to keep
+    // the row numbers valid.
+    //
+    int end = staleRows.count() - 1;
+    while( end >= 0 ) {
+        int start = end;
+        while( start > 0 && staleRows.at( start-1 ) == staleRows.at( start ) - 1 )
+            --start;
+
+        const DirItem::Children takenItems = dirItem->takeDataItems( staleRows.at( start ), end - start + 1 );
+        for( DirItem::Children::const_iterator it = takenItems.constBegin(); it != takenItems.constEnd(); ++it ) {
+            if( updatedItems.contains( *it ) ) {
+                const LocalEntry& e = s.entries.at( updatedItems.value( *it ) );
+                FileItem* fileItem = static_cast<FileItem*>( *it );
+                fileItem->updateLocalStat( *doc, &e.statBuf, e.followed ? &e.followedStatBuf : 0 );
+                newItems.append( fileItem );
+            }
+            else {
+                if( (*it)->isDir() ) {
+                    QSet<DirItem*> removedDirs;
+                    collectDirs( static_cast<DirItem*>( *it ), removedDirs );
+                    dirs.subtract( removedDirs );
+                }
+                delete *it;
+            }
+            ++changes;
+        }
+
+        end = start - 1;
+    }
+
+    //
+    // Create the items for the new entries. Files are renamed in DirItem if their name
+    // is already taken, folders need to be handled here.
+    //
+    for( int i = 0; i < s.entries.count(); ++i ) {
+        const LocalEntry& e = s.entries.at( i );
+        if( !e.add && !recreatedEntries.contains( i ) )
+            continue;
+
+        QString name = localItemName( e.name );
+        if( e.isDir ) {
+            const QString baseName( name );
+            int cnt = 0;
+            bool taken = true;
+            while( taken ) {
+                taken = ( dirItem->find( name ) != 0 );
+                for( DirItem::Children::const_iterator newIt = newItems.constBegin();
+                     !taken && newIt != newItems.constEnd(); ++newIt ) {
+                    taken = ( (*newIt)->k3bName() == name );
+                }
+                if( taken )
+                    name = baseName + QString("_%1").arg(++cnt);
+            }
+        }
+
+        if( DataItem* item = createItem( s, e, name ) ) {
+            newItems.append( item );
+            ++changes;
+        }
+    }
+
+    if( !newItems.isEmpty() )
+        dirItem->addDataItems( newItems );
+}
+
+
+/**
+ * Creates a new item for a local entry which is not yet part of the project.
+ * Symlinks to folders are added as files unless they are followed.
+ */
+K3b::DataItem* K3b::DataRescanJob::Private::createItem( LocalDirScan& s, const LocalEntry& e, const QString& name )
+{
+    const QString path = s.resolvedPath + '/' + e.name;
+
+    if( e.isDir ) {
+        DirItem* dirItem = new DirItem( name );
+        dirItem->setLocalPath( path ); // HACK: see k3bdiritem.h
+        dirItem->setLocalAddOptions( s.options );
+        if( e.subScan >= 0 )
+            scans[e.subScan].dir = dirItem;
+        dirs.insert( dirItem );
+        return dirItem;
+    }
+    else if( S_ISREG( e.statBuf.st_mode ) ||
+             S_ISLNK( e.statBuf.st_mode ) ||
+             ( isSystemFile( e.statBuf.st_mode ) && s.options.testFlag( DirItem::AddSystemFiles ) ) ) {
+        return new FileItem( &e.statBuf, e.followed ? &e.followedStatBuf : 0, path, *doc, name );
+    }
+    else {
+        return 0;
+    }
+}
+
+
+K3b::DataRescanJob::DataRescanJob( K3b::DataDoc* doc, QObject* parent )
+    : K3b::ThreadJob( new K3b::SimpleJobHandler(), parent ),
+      d( new Private() )
+{
+    d->doc = doc;
+}
+
+
+K3b::DataRescanJob::~DataRescanJob()
+{
+    // the thread checks for cancellation after each folder
+    if( active() ) {
+        cancel();
+        wait();
+    }
+    delete d;
+    delete jobHandler();
+}
+
+
+QString K3b::DataRescanJob::jobDescription() const
+{
+    return i18n("Rescanning local folders");
+}
+
+
+void K3b::DataRescanJob::setDir( K3b::DirItem* dir )
+{
+    d->dir = dir;
+}
+
+
+int K3b::DataRescanJob::changes() const
+{
+    return d->changes;
+}
+
+
+void K3b::DataRescanJob::jobStarted()
+{
+    d->changes = 0;
+    d->scans.clear();
+    d->followLinks = d->doc->isoOptions().followSymbolicLinks();
+    d->collect( d->dir ? d->dir : d->doc->root() );
+
+    K3b::ThreadJob::jobStarted();
+}
+
+
+bool K3b::DataRescanJob::run()
+{
+    // new folders are appended while scanning
+    for( int i = 0; i < d->scans.count(); ++i ) {
+        if( canceled() )
+            return false;
+        d->scan( i );
+    }
+    return true;
+}
+
+
+void K3b::DataRescanJob::jobFinished( bool success )
+{
+    if( success ) {
+        //
+        // The project may have been changed while the thread was running.
+        // Folders which have been removed in the meantime are skipped.
+        //
+        collectDirs( d->doc->root(), d->dirs );
+
+        for( int i = 0; i < d->scans.count(); ++i ) {
+            const LocalDirScan& s = d->scans.at( i );
+            if( s.changed && d->dirs.contains( s.dir ) && s.dir->localPath() == s.localPath )
+                d->apply( i );
+        }
+
+        if( d->changes > 0 )
+            d->doc->setModified( true );
+
+        qDebug() << "(K3b::DataRescanJob) applied" << d->changes << "changes.";
+    }
+
+    d->scans.clear();
+    d->dirs.clear();
+
+    K3b::ThreadJob::jobFinished( success );
+}
+
+#include "moc_k3bdatarescanjob.cpp"
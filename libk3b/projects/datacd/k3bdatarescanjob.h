@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_DATA_RESCAN_JOB_H_
+#define _K3B_DATA_RESCAN_JOB_H_
+
+#include "k3bthreadjob.h"
+#include "k3b_export.h"
+
+
+namespace K3b {
+    class DataDoc;
+    class DirItem;
+
+    /**
+     * Brings a data project in sync with the local directories it has been
+     * created from. Only directories whose modification or status change
+     * time differs from the one recorded when they were last read are
+     * listed again. Items which vanished from such a directory are removed
+     * and files whose size or inode changed are updated in place.
+     *
+     * Entries which did not exist when the directory was last read are added
+     * following the choices made when it was added (see DirItem::localAddOptions()).
+     * Entries the user did not add or removed from the project later on stay out.
+     * Items which have been added from elsewhere, created in the project
+     * or imported from an old session are never touched.
+     *
+     * The local directories are read in a separate thread. The project itself
+     * is only changed once the thread has finished, thus it must not be
+     * deleted while the job is running.
+     */
+    class LIBK3B_EXPORT DataRescanJob : public ThreadJob
+    {
+        Q_OBJECT
+
+    public:
+        explicit DataRescanJob( DataDoc* doc, QObject* parent = 0 );
+        ~DataRescanJob() override;
+
+        QString jobDescription() const override;
+
+        /**
+         * \param dir The directory to rescan. If 0 (the default) the whole
+         *            project is rescanned.
+         */
+        void setDir( DirItem* dir );
+
+        /**
+         * \return The number of items which have been added, removed or updated
+         *         by the last run.
+         */
+        int changes() const;
+
+    protected:
+        void jobStarted() override;
+        void jobFinished( bool success ) override;
+
+    private:
+        bool run() override;
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -13,7 +13,9 @@
 #include "k3bisooptions.h"
 #include "k3b_i18n.h"
 
+#include <QDateTime>
 #include <QDebug>
+#include <QFileInfo>
 #include <QMimeDatabase>
 
 
@@ -24,7 +26,9 @@ K3b::DirItem::DirItem(const QString& name, const ItemFlags& flags)
       m_blocks(0),
       m_followSymlinksBlocks(0),
       m_files(0),
-      m_dirs(0)
+      m_dirs(0),
+      m_localMTime(0),
+      m_localCTime(0)
 {
     m_k3bName = name;
 }
@@ -38,7 +42,11 @@ K3b::DirItem::DirItem( const K3b::DirItem& item )
       m_followSymlinksBlocks(0),
       m_files(0),
       m_dirs(0),
-      m_localPath( item.m_localPath )
+      m_localPath( item.m_localPath ),
+      m_localMTime( item.m_localMTime ),
+      m_localCTime( item.m_localCTime ),
+      m_localAddOptions( item.m_localAddOptions ),
+      m_localEntries( item.m_localEntries )
 {
     Q_FOREACH( K3b::DataItem* _item, item.children() ) {
         addDataItem( _item->copy() );
@@ -425,6 +433,19 @@ bool K3b::DirItem::writeToCd() const
 }
 
 
+void K3b::DirItem::updateLocalTimestamps()
+{
+    QFileInfo info( m_localPath );
+    if( !m_localPath.isEmpty() && info.isDir() ) {
+        m_localMTime = info.lastModified().toMSecsSinceEpoch();
+        m_localCTime = info.metadataChangeTime().toMSecsSinceEpoch();
+    }
+    else {
+        m_localMTime = m_localCTime = 0;
+    }
+}
+
+
 QMimeType K3b::DirItem::mimeType() const
 {
     return QMimeDatabase().mimeTypeForName( "inode/directory" );
@@ -14,6 +14,7 @@
 #include <KIO/Global>
 
 #include <QList>
+#include <QSet>
 #include <QString>
 
 namespace K3b {
@@ -24,6 +25,17 @@ namespace K3b {
     public:
         typedef QList<DataItem*> Children;
 
+        /**
+         * The choices made when the local directory was added to the project.
+         * They are applied again to entries found by DataRescanJob.
+         */
+        enum LocalAddOption {
+            AddHiddenFiles = 0x1,
+            AddSystemFiles = 0x2,   /**< FIFOs, sockets, device files, and broken symlinks */
+            FollowFolderLinks = 0x4
+        };
+        Q_DECLARE_FLAGS( LocalAddOptions, LocalAddOption )
+
     public:
         explicit DirItem( const QString& name, const ItemFlags& flags = ItemFlags() );
 
@@ -75,6 +87,40 @@ namespace K3b {
         void setLocalPath( const QString& p ) { m_localPath = p; }
         QString localPath() const override { return m_localPath; }
 
+        /**
+         * Remembers the modification and status change time of the local
+         * directory. Call this right before reading the directory contents
+         * so that changes made while reading are detected by the next rescan.
+         *
+         * \see DataRescanJob
+         */
+        void updateLocalTimestamps();
+        void setLocalTimestamps( qint64 mtime, qint64 ctime ) { m_localMTime = mtime; m_localCTime = ctime; }
+
+        /**
+         * Modification time of the local directory in milliseconds since epoch
+         * as recorded by updateLocalTimestamps() or 0 if unknown.
+         */
+        qint64 localMTime() const { return m_localMTime; }
+
+        /**
+         * Status change time of the local directory in milliseconds since epoch
+         * as recorded by updateLocalTimestamps() or 0 if unknown.
+         */
+        qint64 localCTime() const { return m_localCTime; }
+
+        void setLocalAddOptions( LocalAddOptions options ) { m_localAddOptions = options; }
+        LocalAddOptions localAddOptions() const { return m_localAddOptions; }
+
+        /**
+         * The names of all entries the local directory contained when it was
+         * last read, including those which have not been added to the project
+         * or have been removed from it since. Only entries not listed here
+         * are added by the next rescan.
+         */
+        void setLocalEntries( const QSet<QString>& names ) { m_localEntries = names; }
+        QSet<QString> const& localEntries() const { return m_localEntries; }
+
         QMimeType mimeType() const override;
 
         /**
@@ -134,6 +180,11 @@ namespace K3b {
         // HACK: store the original path to be able to use it's permissions
         //       remove this once we have a backup project
         QString m_localPath;
+
+        qint64 m_localMTime;
+        qint64 m_localCTime;
+        LocalAddOptions m_localAddOptions;
+        QSet<QString> m_localEntries;
     };
 
 
@@ -154,4 +205,7 @@ namespace K3b {
         DataDoc& m_doc;
     };
 }
+
+Q_DECLARE_OPERATORS_FOR_FLAGS( K3b::DirItem::LocalAddOptions )
+
 #endif
@@ -78,7 +78,7 @@ public:
     }
 
     void addFile( K3b::FileItem* item, bool followSymlinks ) {
-        InodeInfo& inodeInfo = inodeMap[item->localId(followSymlinks)];
+        InodeInfo& inodeInfo = inodeMap[item->contentId(followSymlinks)];
 
         inodeInfo.items.append( item );
 
@@ -101,7 +101,7 @@ public:
     }
 
     void removeFile( K3b::FileItem* item, bool followSymlinks ) {
-        InodeInfo& inodeInfo = inodeMap[item->localId(followSymlinks)];
+        InodeInfo& inodeInfo = inodeMap[item->contentId(followSymlinks)];
 
         if( !inodeInfo.items.contains( item ) ) {
             qCritical() << "(K3b::FileCompilationSizeHandler) "
@@ -17,6 +17,9 @@ namespace K3b {
      * of files in the doc that belong to that inode.
      * This way a more accurate size calculation is possible
      *
+     * Files with a content source (see FileItem::contentId())
+     * are counted with the inode of their source.
+     *
      * It has to be noted that the sizes of the directories
      * are only locally true. That means that in some cases
      * the root directory of the project may show a much
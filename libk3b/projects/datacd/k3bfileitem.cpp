@@ -50,7 +50,8 @@ bool K3b::operator>( const K3b::FileItem::Id& id1, const K3b::FileItem::Id& id2
 K3b::FileItem::FileItem( const QString& filePath, K3b::DataDoc& doc, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
       m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_localPath(filePath),
+      m_hasContentSource(false)
 {
     k3b_struct_stat statBuf;
     k3b_struct_stat followedStatBuf;
@@ -84,7 +85,8 @@ K3b::FileItem::FileItem( const k3b_struct_stat* stat,
                           const QString& filePath, K3b::DataDoc& doc, const QString& k3bName, const ItemFlags& flags )
     : K3b::DataItem( flags | FILE ),
       m_replacedItemFromOldSession(0),
-      m_localPath(filePath)
+      m_localPath(filePath),
+      m_hasContentSource(false)
 {
     init( filePath, k3bName, doc, stat, followedStat );
 }
@@ -98,6 +100,9 @@ K3b::FileItem::FileItem( const K3b::FileItem& item )
       m_id( item.m_id ),
       m_idFollowed( item.m_idFollowed ),
       m_localPath( item.m_localPath ),
+      m_hasContentSource( item.m_hasContentSource ),
+      m_contentSourceId( item.m_contentSourceId ),
+      m_contentSourcePath( item.m_contentSourcePath ),
       m_mimeType( item.m_mimeType )
 {
 }
@@ -149,6 +154,30 @@ K3b::FileItem::Id K3b::FileItem::localId( bool followSymlinks ) const
 }
 
 
+K3b::FileItem::Id K3b::FileItem::contentId( bool followSymlinks ) const
+{
+    if( m_hasContentSource )
+        return m_contentSourceId;
+    else
+        return localId( followSymlinks );
+}
+
+
+void K3b::FileItem::setContentSource( const Id& id, const QString& localPath )
+{
+    m_hasContentSource = true;
+    m_contentSourceId = id;
+    m_contentSourcePath = localPath;
+}
+
+
+void K3b::FileItem::clearContentSource()
+{
+    m_hasContentSource = false;
+    m_contentSourcePath.clear();
+}
+
+
 bool K3b::FileItem::exists() const
 {
     return true;
@@ -252,6 +281,22 @@ void K3b::FileItem::init( const QString& filePath,
     else
         m_k3bName = k3bName;
 
+    updateLocalStat( doc, stat, followedStat );
+
+    m_mimeType = QMimeDatabase().mimeTypeForFile( filePath );
+
+    // add automagically like a qlistviewitem
+    if( parent() )
+        parent()->addDataItem( this );
+}
+
+
+void K3b::FileItem::updateLocalStat( DataDoc& doc,
+                                     const k3b_struct_stat* stat,
+                                     const k3b_struct_stat* followedStat )
+{
+    setFlags( flags() & ~SYMLINK );
+
     if( stat != 0 ) {
         m_size = (KIO::filesize_t)stat->st_size;
         if( S_ISLNK(stat->st_mode) )
@@ -265,7 +310,7 @@ void K3b::FileItem::init( const QString& filePath,
         m_id.device = stat->st_dev;
     }
     else {
-        m_size = QFileInfo(filePath).size();
+        m_size = QFileInfo(m_localPath).size();
         m_id.inode = 0;
         m_id.device = 0;
 
@@ -276,7 +321,7 @@ void K3b::FileItem::init( const QString& filePath,
     }
 
     if( isSymLink() ) {
-        if( QFile::exists( K3b::resolveLink( filePath ) ) && followedStat != 0 ) {
+        if( QFile::exists( K3b::resolveLink( m_localPath ) ) && followedStat != 0 ) {
             m_sizeFollowed = (KIO::filesize_t)followedStat->st_size;
             m_idFollowed.inode = followedStat->st_ino;
             m_idFollowed.device = followedStat->st_dev;
@@ -295,10 +340,4 @@ void K3b::FileItem::init( const QString& filePath,
         m_sizeFollowed = m_size;
         m_idFollowed = m_id;
     }
-
-    m_mimeType = QMimeDatabase().mimeTypeForFile( filePath );
-
-    // add automagically like a qlistviewitem
-    if( parent() )
-        parent()->addDataItem( this );
 }
@@ -75,6 +75,25 @@ namespace K3b {
          */
         Id localId( bool followSymlinks ) const;
 
+        /**
+         * The id used for the size calculation. This equals localId() unless
+         * a content source has been set.
+         */
+        Id contentId( bool followSymlinks ) const;
+
+        /**
+         * Set by the duplicate file search if the contents of this file equal the
+         * contents of another local file. The image will then use the data of
+         * @p localPath for this file, too, and thus contain it only once.
+         *
+         * Do not call this directly on items in a project. Use DataDoc::setContentSource()
+         * which keeps the project size in sync.
+         */
+        void setContentSource( const Id& id, const QString& localPath );
+        void clearContentSource();
+        bool hasContentSource() const { return m_hasContentSource; }
+        QString contentSourcePath() const { return m_contentSourcePath; }
+
         DirItem* getDirItem() const override;
 
         QString linkDest() const;
@@ -92,6 +111,19 @@ namespace K3b {
          * Normally one does not use this method but DataItem::size()
          */
         KIO::filesize_t itemSize( bool followSymlinks ) const override;
+
+        /**
+         * Updates size and inode information from freshly read stat buffers,
+         * for example after the local file changed.
+         *
+         * The item must not be part of a directory while calling this since
+         * the sizes of the parent directories would get out of sync.
+         *
+         * \see DataRescanJob
+         */
+        void updateLocalStat( DataDoc& doc,
+                              const k3b_struct_stat* stat,
+                              const k3b_struct_stat* followedStat );
         
     private:
         void init( const QString& filePath,
@@ -110,6 +142,10 @@ namespace K3b {
 
         QString m_localPath;
 
+        bool m_hasContentSource;
+        Id m_contentSourceId;
+        QString m_contentSourcePath;
+
         QMimeType m_mimeType;
     };
 
@@ -19,6 +19,7 @@
 #include "k3bversion.h"
 #include "k3bfilesplitter.h"
 #include "k3bisooptions.h"
+#include "k3boutputparser.h"
 #include "k3b_i18n.h"
 
 #include <KIO/CopyJob>
@@ -29,12 +30,17 @@
 #include <QDebug>
 #include <QDir>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSet>
 #include <QStandardPaths>
 #include <QTemporaryFile>
+#include <QTextStream>
 #include <QApplication>
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <errno.h>
 #include <unistd.h>
 #include <utime.h>
 
@@ -42,6 +48,70 @@
 int K3b::IsoImager::s_imagerSessionCounter = 0;
 
 
+namespace {
+    //
+    // Weights used by the automatic layout (IsoOptions::optimizeLayout). They are
+    // kept small so manually set sort weights (which always win) still
+    // move items before or after the automatically sorted ones.
+    //
+    const long s_bootImageWeight = 3;
+    const long s_autostartWeight = 2;
+    const long s_smallFileWeight = 1;
+
+    // folders with files up to this size only are moved near the directory records
+    const KIO::filesize_t s_smallFileSize = 64*1024;
+
+    bool isAutostartFile( const K3b::DataItem* item )
+    {
+        static const char* const s_names[] = {
+            "autorun.inf", "autorun", "autorun.sh", ".autorun",
+            "autostart", "autostart.sh", ".autostart",
+            "index.html", "index.htm", "readme", "readme.txt",
+            0
+        };
+
+        const QString name = item->k3bName().toLower();
+        for( int i = 0; s_names[i]; ++i ) {
+            if( name == QLatin1String( s_names[i] ) )
+                return true;
+        }
+        return false;
+    }
+
+    /**
+     * Determines the sort weight of a file. User-set weights take precedence.
+     * A weight of 0 means the file uses the weight of its folder.
+     */
+    long fileSortWeight( const K3b::DataItem* item, bool optimizeLayout )
+    {
+        if( item->sortWeight() != 0 || !optimizeLayout )
+            return item->sortWeight();
+
+        if( item->isBootItem() )
+            return s_bootImageWeight;
+        else if( item->isFile() && !item->isSymLink() &&
+                 item->parent() && !item->parent()->parent() && isAutostartFile( item ) )
+            return s_autostartWeight;
+        else
+            return 0;
+    }
+
+
+    bool containsSmallFilesOnly( const K3b::DirItem* dir )
+    {
+        bool haveFiles = false;
+        Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+            if( item->isFile() && !item->isSymLink() ) {
+                if( item->size() > s_smallFileSize )
+                    return false;
+                haveFiles = true;
+            }
+        }
+        return haveFiles;
+    }
+}
+
+
 class K3b::IsoImager::Private
 {
 public:
@@ -59,12 +129,69 @@ public:
     bool knownError;
 
     K3b::DataPreparationJob* dataPreparationJob;
+
+    // the next item to be written to the streamed path spec
+    K3b::DataItem* pathSpecItem;
+
+    // the number of entries streamed so far
+    int pathSpecEntries;
+
+    // set if all entries have been skipped while streaming
+    bool pathSpecEmpty;
+
+    /**
+     * \return true if @p item is a symlink which is not written according
+     * to the link handling. Links which are followed are checked while
+     * streaming the path spec.
+     */
+    bool discardLink( const K3b::DataItem* item ) const;
+
+    // keeps the progress lines from flooding the debugging output
+    K3b::ProgressLineFilter progressFilter;
+
+    /**
+     * mkisofs places files with higher weights first and keeps its default
+     * order (which groups the files by folder) for files with the same weight.
+     * Files inherit the weight of their folder, thus small files are not
+     * weighted one by one (every line of the sort file is matched against
+     * every file in the image) but through folders which only contain small
+     * files. Those are moved in one piece.
+     *
+     * User-set weights take precedence and are inherited by the subfolders.
+     */
+    void calculateDirSortWeights( const K3b::DirItem* dir, long userWeight, bool optimizeLayout );
+    QHash<const K3b::DirItem*, long> dirSortWeights;
 };
 
 
+bool K3b::IsoImager::Private::discardLink( const K3b::DataItem* item ) const
+{
+    return( item->isSymLink() &&
+            ( usedLinkHandling == DISCARD_ALL ||
+              ( usedLinkHandling == DISCARD_BROKEN && !item->isValid() ) ) );
+}
+
+
+void K3b::IsoImager::Private::calculateDirSortWeights( const K3b::DirItem* dir, long userWeight, bool optimizeLayout )
+{
+    Q_FOREACH( K3b::DataItem* item, dir->children() ) {
+        if( !item->isDir() )
+            continue;
+
+        const K3b::DirItem* subDir = static_cast<K3b::DirItem*>( item );
+        long subUserWeight = ( subDir->sortWeight() != 0 ? subDir->sortWeight() : userWeight );
+        long weight = subUserWeight;
+        if( weight == 0 && optimizeLayout && containsSmallFilesOnly( subDir ) )
+            weight = s_smallFileWeight;
+
+        dirSortWeights.insert( subDir, weight );
+        calculateDirSortWeights( subDir, subUserWeight, optimizeLayout );
+    }
+}
+
+
 K3b::IsoImager::IsoImager( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* parent )
     : K3b::Job( hdl, parent ),
-      m_pathSpecFile(0),
       m_rrHideFile(0),
       m_jolietHideFile(0),
       m_sortWeightFile(0),
@@ -76,6 +203,9 @@ K3b::IsoImager::IsoImager( K3b::DataDoc* doc, K3b::JobHandler* hdl, QObject* par
       m_mkisofsPrintSizeResult( 0 )
 {
     d = new Private();
+    d->pathSpecItem = 0;
+    d->pathSpecEntries = 0;
+    d->pathSpecEmpty = false;
     d->dataPreparationJob = new K3b::DataPreparationJob( doc, this, this );
     connectSubJob( d->dataPreparationJob,
                    SLOT(slotDataPreparationDone(bool)),
@@ -104,6 +234,28 @@ void K3b::IsoImager::slotReceivedStderr( const QString& line )
 }
 
 
+void K3b::IsoImager::slotReceivedRawStderr( const QByteArray& line )
+{
+    // progress lines are handled without decoding them
+    if( parseMkisofsProgressLine( line ) ) {
+        if( d->progressFilter.accept( line ) )
+            emit debuggingOutput( "mkisofs", QString::fromLatin1( line ) );
+    }
+    else {
+        logSkippedProgress();
+        slotReceivedStderr( QString::fromLocal8Bit( line ) );
+    }
+}
+
+
+void K3b::IsoImager::logSkippedProgress()
+{
+    const QByteArray line = d->progressFilter.takeSkipped();
+    if( !line.isEmpty() )
+        emit debuggingOutput( "mkisofs", QString::fromLatin1( line ) );
+}
+
+
 void K3b::IsoImager::handleMkisofsProgress( int p )
 {
     emit percent( p );
@@ -122,12 +274,17 @@ void K3b::IsoImager::slotProcessExited( int exitCode, QProcess::ExitStatus exitS
 {
     qDebug();
 
+    logSkippedProgress();
+
     cleanup();
 
     if( m_canceled ) {
         emit canceled();
         jobFinished(false);
     }
+    else if( d->pathSpecEmpty ) {
+        jobFinished( false );
+    }
     else {
         if( exitStatus == QProcess::NormalExit ) {
             if( exitCode == 0 ) {
@@ -179,8 +336,10 @@ void K3b::IsoImager::cleanup()
 {
     qDebug();
 
+    // stop streaming the path spec
+    d->pathSpecItem = 0;
+
     // remove all temp files
-    delete m_pathSpecFile;
     delete m_rrHideFile;
     delete m_jolietHideFile;
     delete m_sortWeightFile;
@@ -191,7 +350,7 @@ void K3b::IsoImager::cleanup()
         QFile::remove( *it );
     m_tempFiles.clear();
 
-    m_pathSpecFile = m_jolietHideFile = m_rrHideFile = m_sortWeightFile = 0;
+    m_jolietHideFile = m_rrHideFile = m_sortWeightFile = 0;
 
     clearDummyDirs();
 }
@@ -300,6 +459,8 @@ void K3b::IsoImager::startSizeCalculation()
         jobFinished( false );
         return;
     }
+
+    startWritingPathSpec();
 }
 
 
@@ -326,6 +487,12 @@ void K3b::IsoImager::slotMkisofsPrintSizeFinished()
         return;
     }
 
+    if( d->pathSpecEmpty ) {
+        cleanup();
+        jobFinished( false );
+        return;
+    }
+
     bool success = true;
 
     // if m_collectedMkisofsPrintSizeStdout is not empty we have a recent version of
@@ -405,6 +572,7 @@ void K3b::IsoImager::start()
     }
 
     initVariables();
+    d->progressFilter.reset();
 
     delete m_process;
     m_process = new K3b::Process( this );
@@ -424,8 +592,8 @@ void K3b::IsoImager::start()
 
     connect( m_process, SIGNAL(finished(int,QProcess::ExitStatus)),
              this, SLOT(slotProcessExited(int,QProcess::ExitStatus)) );
-    connect( m_process, SIGNAL(stderrLine(QString)),
-             this, SLOT(slotReceivedStderr(QString)) );
+    connect( m_process, SIGNAL(rawStderrLine(QByteArray)),
+             this, SLOT(slotReceivedRawStderr(QByteArray)) );
 
     qDebug() << "***** mkisofs parameters:\n";
     QString s = m_process->joinedArgs();
@@ -440,6 +608,9 @@ void K3b::IsoImager::start()
         jobFinished( false );
         cleanup();
     }
+    else {
+        startWritingPathSpec();
+    }
 }
 
 
@@ -582,7 +753,9 @@ bool K3b::IsoImager::addMkisofsParameters( bool printSize )
             *m_process << "-hide-joliet-list" << m_jolietHideFile->fileName();
     }
 
-    if( m_doc->isoOptions().doNotCacheInodes() )
+    // files with identical contents are mapped to the same local file and
+    // only mkisofs' inode cache makes them share the data
+    if( m_doc->isoOptions().doNotCacheInodes() && !m_doc->isoOptions().deduplicateFiles() )
         *m_process << "-no-cache-inodes";
 
     //
@@ -671,7 +844,8 @@ bool K3b::IsoImager::addMkisofsParameters( bool printSize )
     }
     *m_process << "-iso-level" << QString::number( isoLevel );
 
-    *m_process << "-path-list" << m_pathSpecFile->fileName();
+    // the path spec is streamed to mkisofs' stdin (see startWritingPathSpec())
+    *m_process << "-path-list" << "-";
 
 
     // boot stuff
@@ -722,100 +896,173 @@ bool K3b::IsoImager::addMkisofsParameters( bool printSize )
 
 int K3b::IsoImager::writePathSpec()
 {
-    delete m_pathSpecFile;
-    m_pathSpecFile = new QTemporaryFile();
-    if ( m_pathSpecFile->open() ) {
-        qDebug() << "Opened path spec file" << m_pathSpecFile->fileName();
-        QTextStream s( m_pathSpecFile );
-
-        // recursive path spec writing
-        return writePathSpecForDir( m_doc->root(), s );
-    }
-    else {
-        return -1;
+    //
+    // The path spec itself is not written here but streamed to mkisofs once it
+    // has been started (see slotWritePathSpecChunk()). Here we only determine
+    // what needs to be known before mkisofs is started.
+    //
+    int num = 0;
+    K3b::DataItem* item = m_doc->root()->nextSibling();
+    while( item ) {
+        if( item->writeToCd() && !d->discardLink( item ) ) {
+            ++num;
+            if( !m_noDeepDirectoryRelocation && item->isDir() && item->depth() > 7 ) {
+                qDebug() << "(K3b::IsoImager) found directory depth > 7. Enabling no deep directory relocation.";
+                m_noDeepDirectoryRelocation = true;
+            }
+            item = item->nextSibling();
+        }
+        else {
+            item = item->K3b::DataItem::nextSibling(); // skip the children
+        }
     }
+
+    // start with the first child of the root (or nothing at all)
+    d->pathSpecItem = m_doc->root()->nextSibling();
+    d->pathSpecEntries = 0;
+    d->pathSpecEmpty = false;
+
+    return num;
 }
 
 
-int K3b::IsoImager::writePathSpecForDir( K3b::DirItem* dirItem, QTextStream& stream )
+void K3b::IsoImager::startWritingPathSpec()
 {
-    if( !m_noDeepDirectoryRelocation && dirItem->depth() > 7 ) {
-        qDebug() << "(K3b::IsoImager) found directory depth > 7. Enabling no deep directory relocation.";
-        m_noDeepDirectoryRelocation = true;
-    }
+    connect( m_process, SIGNAL(bytesWritten(qint64)),
+             this, SLOT(slotWritePathSpecChunk()) );
+    slotWritePathSpecChunk();
+}
 
-    // now create the graft points
-    int num = 0;
-    Q_FOREACH( K3b::DataItem* item, dirItem->children() ) {
-        bool writeItem = item->writeToCd();
-
-        if( item->isSymLink() ) {
-            if( d->usedLinkHandling == Private::DISCARD_ALL ||
-                ( d->usedLinkHandling == Private::DISCARD_BROKEN &&
-                  !item->isValid() ) )
-                writeItem = false;
-
-            else if( d->usedLinkHandling == Private::FOLLOW ) {
-                QFileInfo f( K3b::resolveLink( item->localPath() ) );
-                if( !f.exists() ) {
-                    emit infoMessage( i18n("Could not follow link %1 to non-existing file %2. Skipping...", item->k3bName(), f.filePath()), MessageWarning );
-                    writeItem = false;
-                }
-                else if( f.isDir() ) {
-                    emit infoMessage( i18n("Ignoring link %1 to folder %2. K3b is unable to follow links to folders.", item->k3bName(), f.filePath()), MessageWarning );
-                    writeItem = false;
-                }
+
+void K3b::IsoImager::slotWritePathSpecChunk()
+{
+    //
+    // We only keep a few kilobytes in the process' write buffer and create the next
+    // chunk once mkisofs has read them. That way we never hold the complete path spec
+    // in memory and mkisofs can start scanning while we are still writing.
+    //
+    if( !m_process || m_process->bytesToWrite() > 32*1024 )
+        return;
+
+    if( d->pathSpecItem ) {
+        //
+        // Skipped items do not end up in the chunk. We keep going until something
+        // has been written since only that results in another bytesWritten signal.
+        //
+        QByteArray chunk;
+        QTextStream stream( &chunk, QIODevice::WriteOnly );
+        int written = 0;
+        while( d->pathSpecItem && written < 256 ) {
+            K3b::DataItem* item = d->pathSpecItem;
+            if( writePathSpecForItem( item, stream ) ) {
+                ++written;
+                d->pathSpecItem = item->nextSibling();
             }
-        }
-        else if( item->isFile() ) {
-            QFileInfo f( item->localPath() );
-            if( !f.exists() ) {
-                emit infoMessage( i18n("Could not find file %1. Skipping...",item->localPath()), MessageWarning );
-                writeItem = false;
+            else {
+                d->pathSpecItem = item->K3b::DataItem::nextSibling(); // skip the children
             }
-            else if( !f.isReadable() ) {
-                emit infoMessage( i18n("Could not read file %1. Skipping...",item->localPath()), MessageWarning );
-                writeItem = false;
+        }
+        stream.flush();
+        d->pathSpecEntries += written;
+        if( !chunk.isEmpty() )
+            m_process->write( chunk );
+
+        if( !d->pathSpecItem ) {
+            qDebug() << "(K3b::IsoImager) path spec written:" << d->pathSpecEntries << "entries";
+            if( d->pathSpecEntries == 0 ) {
+                emit infoMessage( i18n("No files to be written."), K3b::Job::MessageError );
+                d->knownError = true;
+                d->pathSpecEmpty = true;
             }
+            m_process->closeWriteChannel();
         }
+    }
+}
 
-        if( writeItem ) {
-            num++;
-
-            // some versions of mkisofs seem to have a bug that prevents to use filenames
-            // that contain one or more backslashes
-            if( item->writtenPath().contains("\\") )
-                m_containsFilesWithMultibleBackslashes = true;
 
+bool K3b::IsoImager::writePathSpecForItem( K3b::DataItem* item, QTextStream& stream )
+{
+    if( !item->writeToCd() )
+        return false;
 
-            if( item->isDir() ) {
-                stream << escapeGraftPoint( item->writtenPath() )
-                       << "="
-                       << escapeGraftPoint( dummyDir( static_cast<K3b::DirItem*>(item) ) ) << "\n";
+    QString linkTarget;
+    if( item->isSymLink() ) {
+        if( d->discardLink( item ) )
+            return false;
 
-                int x = writePathSpecForDir( dynamic_cast<K3b::DirItem*>(item), stream );
-                if( x >= 0 )
-                    num += x;
-                else
-                    return -1;
+        else if( d->usedLinkHandling == Private::FOLLOW ) {
+            linkTarget = K3b::resolveLink( item->localPath() );
+            QFileInfo f( linkTarget );
+            if( !f.exists() ) {
+                emit infoMessage( i18n("Could not follow link %1 to non-existing file %2. Skipping...", item->k3bName(), f.filePath()), MessageWarning );
+                return false;
             }
-            else {
-                writePathSpecForFile( static_cast<K3b::FileItem*>(item), stream );
+            else if( f.isDir() ) {
+                emit infoMessage( i18n("Ignoring link %1 to folder %2. K3b is unable to follow links to folders.", item->k3bName(), f.filePath()), MessageWarning );
+                return false;
             }
         }
     }
+    else if( item->isFile() ) {
+        // a single access() tells us if the file exists and is readable
+        if( ::access( QFile::encodeName( item->localPath() ), R_OK ) != 0 ) {
+            if( errno == EACCES )
+                emit infoMessage( i18n("Could not read file %1. Skipping...",item->localPath()), MessageWarning );
+            else
+                emit infoMessage( i18n("Could not find file %1. Skipping...",item->localPath()), MessageWarning );
+            return false;
+        }
+    }
 
-    return num;
+    if( item->isDir() ) {
+        const QString writtenPath = item->writtenPath();
+
+        // some versions of mkisofs seem to have a bug that prevents to use filenames
+        // that contain one or more backslashes
+        if( writtenPath.contains('\\') )
+            m_containsFilesWithMultibleBackslashes = true;
+
+        stream << escapeGraftPoint( writtenPath )
+               << '='
+               << escapeGraftPoint( dummyDir( static_cast<K3b::DirItem*>(item) ) ) << '\n';
+    }
+    else {
+        writePathSpecForFile( static_cast<K3b::FileItem*>(item), stream, linkTarget );
+    }
+
+    return true;
 }
 
 
-void K3b::IsoImager::writePathSpecForFile( K3b::FileItem* item, QTextStream& stream )
+void K3b::IsoImager::writePathSpecForFile( K3b::FileItem* item, QTextStream& stream, const QString& linkTarget )
 {
-    stream << escapeGraftPoint( item->writtenPath() )
-           << "=";
+    const QString writtenPath = item->writtenPath();
 
-    if( m_doc->bootImages().contains( dynamic_cast<K3b::BootItem*>(item) ) ) { // boot-image-backup-hack
+    // some versions of mkisofs seem to have a bug that prevents to use filenames
+    // that contain one or more backslashes
+    if( writtenPath.contains('\\') )
+        m_containsFilesWithMultibleBackslashes = true;
 
+    stream << escapeGraftPoint( writtenPath ) << '=';
+
+    if( item->isBootItem() ) // boot-image-backup-hack (see backupBootImages())
+        stream << escapeGraftPoint( static_cast<K3b::BootItem*>(item)->tempPath() ) << '\n';
+    else if( item->isSymLink() && d->usedLinkHandling == Private::FOLLOW )
+        stream << escapeGraftPoint( linkTarget.isEmpty() ? K3b::resolveLink( item->localPath() ) : linkTarget ) << '\n';
+    else if( item->hasContentSource() && m_doc->isoOptions().deduplicateFiles() )
+        stream << escapeGraftPoint( item->contentSourcePath() ) << '\n';
+    else
+        stream << escapeGraftPoint( item->localPath() ) << '\n';
+}
+
+
+bool K3b::IsoImager::backupBootImages()
+{
+    //
+    // mkisofs modifies the boot images (boot info table). Thus, we write a copy of them
+    // which needs to exist before we start streaming the path spec.
+    //
+    Q_FOREACH( K3b::BootItem* bootItem, m_doc->bootImages() ) {
         // create temp file
         QTemporaryFile temp;
         temp.setAutoRemove( false );
@@ -823,43 +1070,47 @@ void K3b::IsoImager::writePathSpecForFile( K3b::FileItem* item, QTextStream& str
         QString tempPath = temp.fileName();
         temp.remove();
 
-        KIO::CopyJob* copyJob = KIO::copyAs(QUrl::fromLocalFile(item->localPath()), QUrl::fromLocalFile(tempPath), KIO::HideProgressInfo);
+        KIO::CopyJob* copyJob = KIO::copyAs(QUrl::fromLocalFile(bootItem->localPath()), QUrl::fromLocalFile(tempPath), KIO::HideProgressInfo);
         bool copyJobSucceed = true;
         connect(copyJob, &KJob::result, [&](KJob*) {
             if( copyJob->error() != KJob::NoError ) {
-                emit infoMessage( i18n("Failed to backup boot image file %1",item->localPath()), MessageError );
+                emit infoMessage( i18n("Failed to backup boot image file %1",bootItem->localPath()), MessageError );
                 copyJobSucceed = false;
             }
         } );
         if( !copyJob->exec() || !copyJobSucceed ) {
-            return;
+            return false;
         }
 
-        static_cast<K3b::BootItem*>(item)->setTempPath( tempPath );
+        bootItem->setTempPath( tempPath );
 
         m_tempFiles.append(tempPath);
-        stream << escapeGraftPoint( tempPath ) << "\n";
     }
-    else if( item->isSymLink() && d->usedLinkHandling == Private::FOLLOW )
-        stream << escapeGraftPoint( K3b::resolveLink( item->localPath() ) ) << "\n";
-    else
-        stream << escapeGraftPoint( item->localPath() ) << "\n";
+
+    return true;
 }
 
 
 bool K3b::IsoImager::writeRRHideFile()
 {
     delete m_rrHideFile;
-    m_rrHideFile = new QTemporaryFile();
-    m_rrHideFile->open();
+    m_rrHideFile = 0;
 
-    QTextStream s( m_rrHideFile );
+    QTextStream s;
 
     K3b::DataItem* item = m_doc->root();
     while( item ) {
         if( item->hideOnRockRidge() ) {
-            if( !item->isDir() )  // hiding directories does not work (all dirs point to the dummy-dir)
-                s << escapeGraftPoint( item->localPath() ) << Qt::endl;
+            if( !item->isDir() ) { // hiding directories does not work (all dirs point to the dummy-dir)
+                // only create the file if there is something to hide
+                if( !m_rrHideFile ) {
+                    m_rrHideFile = new QTemporaryFile();
+                    if( !m_rrHideFile->open() )
+                        return false;
+                    s.setDevice( m_rrHideFile );
+                }
+                s << escapeGraftPoint( item->localPath() ) << '\n';
+            }
         }
         item = item->nextSibling();
     }
@@ -871,16 +1122,23 @@ bool K3b::IsoImager::writeRRHideFile()
 bool K3b::IsoImager::writeJolietHideFile()
 {
     delete m_jolietHideFile;
-    m_jolietHideFile = new QTemporaryFile();
-    m_jolietHideFile->open();
+    m_jolietHideFile = 0;
 
-    QTextStream s( m_jolietHideFile );
+    QTextStream s;
 
     K3b::DataItem* item = m_doc->root();
     while( item ) {
-        if( item->hideOnRockRidge() ) {
-            if( !item->isDir() )  // hiding directories does not work (all dirs point to the dummy-dir but we could introduce a second hidden dummy dir)
-                s << escapeGraftPoint( item->localPath() ) << Qt::endl;
+        if( item->hideOnJoliet() ) {
+            if( !item->isDir() ) { // hiding directories does not work (all dirs point to the dummy-dir but we could introduce a second hidden dummy dir)
+                // only create the file if there is something to hide
+                if( !m_jolietHideFile ) {
+                    m_jolietHideFile = new QTemporaryFile();
+                    if( !m_jolietHideFile->open() )
+                        return false;
+                    s.setDevice( m_jolietHideFile );
+                }
+                s << escapeGraftPoint( item->localPath() ) << '\n';
+            }
         }
         item = item->nextSibling();
     }
@@ -892,31 +1150,54 @@ bool K3b::IsoImager::writeJolietHideFile()
 bool K3b::IsoImager::writeSortWeightFile()
 {
     delete m_sortWeightFile;
-    m_sortWeightFile = new QTemporaryFile();
-    m_sortWeightFile->open();
+    m_sortWeightFile = 0;
 
-    QTextStream s( m_sortWeightFile );
+    QTextStream s;
+    QSet<QString> writtenDummyDirs;
 
     //
     // We need to write the local path in combination with the sort weight
     // mkisofs will take care of multiple entries for one local file and always
     // use the highest weight
     //
+    // Only items which do not simply use the weight of their folder are written.
+    //
+    const bool optimizeLayout = m_doc->isoOptions().optimizeLayout();
     K3b::DataItem* item = m_doc->root();
     while( (item = item->nextSibling()) ) {  // we skip the root here
-        if( item->sortWeight() != 0 ) {
-            if( m_doc->bootImages().contains( dynamic_cast<K3b::BootItem*>(item) ) ) { // boot-image-backup-hack
-                s << escapeGraftPoint( static_cast<K3b::BootItem*>(item)->tempPath() ) << " " << item->sortWeight() << Qt::endl;
+        const long parentWeight = d->dirSortWeights.value( item->parent(), 0 );
+        long weight = 0;
+        if( item->isDir() )
+            weight = d->dirSortWeights.value( static_cast<K3b::DirItem*>(item), item->sortWeight() );
+        else
+            weight = fileSortWeight( item, optimizeLayout );
+
+        const bool inherited = ( weight == parentWeight || ( !item->isDir() && weight == 0 ) );
+        if( !inherited ) {
+            // only create the file if there is something to sort
+            if( !m_sortWeightFile ) {
+                m_sortWeightFile = new QTemporaryFile();
+                if( !m_sortWeightFile->open() )
+                    return false;
+                s.setDevice( m_sortWeightFile );
+            }
+
+            if( item->isBootItem() ) { // boot-image-backup-hack
+                s << escapeGraftPoint( static_cast<K3b::BootItem*>(item)->tempPath() ) << " " << weight << Qt::endl;
             }
             else if( item->isDir() ) {
                 //
                 // Since we use dummy dirs for all directories in the filesystem and mkisofs uses the local path
                 // for sorting we need to create a different dummy dir for every sort weight value.
                 //
-                s << escapeGraftPoint( dummyDir( static_cast<K3b::DirItem*>(item) ) ) << " " << item->sortWeight() << Qt::endl;
+                const QString dir = dummyDir( static_cast<K3b::DirItem*>(item) );
+                if( !writtenDummyDirs.contains( dir ) ) {
+                    writtenDummyDirs.insert( dir );
+                    s << escapeGraftPoint( dir ) << " " << weight << Qt::endl;
+                }
             }
             else
-                s << escapeGraftPoint( item->localPath() ) << " " << item->sortWeight() << Qt::endl;
+                s << escapeGraftPoint( item->localPath() ) << " " << weight << Qt::endl;
         }
     }
 
@@ -926,8 +1207,6 @@ bool K3b::IsoImager::writeSortWeightFile()
 
 QString K3b::IsoImager::escapeGraftPoint( const QString& str )
 {
-    QString enc = str;
-
     //
     // mkisofs manpage (-graft-points) is incorrect (as of mkisofs 2.01.01)
     //
@@ -942,48 +1221,63 @@ QString K3b::IsoImager::escapeGraftPoint( const QString& str )
     // that in K3b::DataDoc::addUrls)
     //
 
+    //
+    // Most names do not contain any special character at all. In that case we
+    // simply return the (implicitly shared) string without copying anything.
+    //
+    if( !str.contains( '=' ) && !str.contains( '\\' ) )
+        return str;
+
     //
     // we do not use QString::replace to have full control
-    // this might be slow since QString::insert is slow but we don't care
-    // since this is only called to prepare the iso creation which is not
-    // time critical. :)
     //
+    QString enc;
+    enc.reserve( str.length() + 8 );
+
+    const int len = str.length();
+    for( int pos = 0; pos < len; ++pos ) {
+        const QChar c = str[pos];
 
-    int pos = 0;
-    while( pos < enc.length() ) {
         // escape every equal sign with one backslash
-        if( enc[pos] == '=' ) {
-            enc.insert( pos, "\\" );
-            pos += 2;
+        if( c == '=' ) {
+            enc += '\\';
+            enc += c;
         }
-        else if( enc[pos] == '\\' ) {
+        else if( c == '\\' ) {
             // escape every occurrence of two backslashes with two backslashes
-            if( pos+1 < enc.length() && enc[pos+1] == '\\' ) {
-                enc.insert( pos, "\\\\" );
-                pos += 4;
+            if( pos+1 < len && str[pos+1] == '\\' ) {
+                enc += "\\\\\\\\";
+                ++pos;
             }
             // escape the last single backslash in the filename (see above)
-            else if( pos == enc.length()-1 ) {
-                enc.insert( pos, "\\" );
-                pos += 2;
+            else if( pos == len-1 ) {
+                enc += "\\\\";
             }
             else
-                ++pos;
+                enc += c;
         }
         else
-            ++pos;
+            enc += c;
     }
 
-//   enc.replace( "\\\\", "\\\\\\\\" );
-//   enc.replace( "=", "\\=" );
-
     return enc;
 }
 
 
 bool K3b::IsoImager::prepareMkisofsFiles()
 {
-    // write path spec file
+    // the boot images need to be copied before the path spec is written
+    // ----------------------------------------------------
+    if( !backupBootImages() )
+        return false;
+
+    // the dummy dirs depend on the sort weights
+    // ----------------------------------------------------
+    d->dirSortWeights.clear();
+    d->dirSortWeights.insert( m_doc->root(), 0 );
+    d->calculateDirSortWeights( m_doc->root(), 0, m_doc->isoOptions().optimizeLayout() );
+
+    // prepare the path spec
     // ----------------------------------------------------
     int num = writePathSpec();
     if( num < 0 ) {
@@ -1042,7 +1336,7 @@ QString K3b::IsoImager::dummyDir( K3b::DirItem* dir )
     }
 
     QString name( "dummydir_" );
-    name += QString::number( dir->sortWeight() );
+    name += QString::number( d->dirSortWeights.value( dir, dir->sortWeight() ) );
 
     bool perm = false;
     k3b_struct_stat statBuf;
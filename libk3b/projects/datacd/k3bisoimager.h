@@ -18,6 +18,7 @@ class QTemporaryFile;
 
 namespace K3b {
     class DataDoc;
+    class DataItem;
     class DirItem;
     class FileItem;
 
@@ -82,7 +83,7 @@ namespace K3b {
         virtual bool addMkisofsParameters( bool printSize = false );
 
         /**
-         * calls writePathSpec, writeRRHideFile, and writeJolietHideFile
+         * calls writePathSpec, writeRRHideFile, writeJolietHideFile, and writeSortWeightFile
          */
         bool prepareMkisofsFiles();
 
@@ -99,19 +100,33 @@ namespace K3b {
         void clearDummyDirs();
 
         /**
-         * @returns The number of entries written or -1 on error
+         * Prepares the path spec which is not written to a file but streamed
+         * to mkisofs' stdin while it is running (mkisofs is called with
+         * -path-list -).
+         *
+         * @returns The number of entries to be written or -1 on error. Files
+         *          which turn out to be unreadable while streaming are included.
          */
         virtual int writePathSpec();
         bool writeRRHideFile();
         bool writeJolietHideFile();
         bool writeSortWeightFile();
 
-        // used by writePathSpec
-        virtual int writePathSpecForDir( DirItem* dirItem, QTextStream& stream );
-        virtual void writePathSpecForFile( FileItem*, QTextStream& stream );
+        /**
+         * Used while streaming the path spec. Called for every item in the project
+         * (depth first).
+         *
+         * @returns false if the item and all its children should not be written.
+         */
+        virtual bool writePathSpecForItem( DataItem* item, QTextStream& stream );
+
+        /**
+         * @param linkTarget The already resolved link target in case item is a symlink
+         *                   which is followed. If empty the link is resolved as needed.
+         */
+        virtual void writePathSpecForFile( FileItem*, QTextStream& stream, const QString& linkTarget = QString() );
         QString escapeGraftPoint( const QString& str );
 
-        QTemporaryFile* m_pathSpecFile;
         QTemporaryFile* m_rrHideFile;
         QTemporaryFile* m_jolietHideFile;
         QTemporaryFile* m_sortWeightFile;
@@ -125,13 +140,18 @@ namespace K3b {
         virtual void slotProcessExited( int, QProcess::ExitStatus );
 
     private Q_SLOTS:
+        void slotReceivedRawStderr( const QByteArray& );
         void slotCollectMkisofsPrintSizeStderr( const QString& );
         void slotCollectMkisofsPrintSizeStdout( const QString& );
         void slotMkisofsPrintSizeFinished();
         void slotDataPreparationDone( bool success );
+        void slotWritePathSpecChunk();
 
     private:
         void startSizeCalculation();
+        void startWritingPathSpec();
+        bool backupBootImages();
+        void logSkippedProgress();
 
         class Private;
         Private* d;
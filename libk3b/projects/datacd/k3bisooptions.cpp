@@ -41,6 +41,8 @@ K3b::IsoOptions::IsoOptions()
 
     m_doNotCacheInodes = true;
     m_doNotImportSession = false;
+    m_optimizeLayout = false;
+    m_deduplicateFiles = false;
 
     m_isoLevel = 3;
 
@@ -113,6 +115,8 @@ void K3b::IsoOptions::save( KConfigGroup c, bool saveVolumeDesc )
 
     c.writeEntry( "do not cache inodes", m_doNotCacheInodes );
     c.writeEntry( "do not import last session", m_doNotImportSession );
+    c.writeEntry( "optimize layout", m_optimizeLayout );
+    c.writeEntry( "deduplicate files", m_deduplicateFiles );
 
     // save whitespace-treatment
     switch( m_whiteSpaceTreatment ) {
@@ -188,6 +192,8 @@ K3b::IsoOptions K3b::IsoOptions::load( const KConfigGroup& c, bool loadVolumeDes
 
     options.setDoNotCacheInodes( c.readEntry( "do not cache inodes", options.doNotCacheInodes() ) );
     options.setDoNotImportSession( c.readEntry( "no not import last session", options.doNotImportSession() ) );
+    options.setOptimizeLayout( c.readEntry( "optimize layout", options.optimizeLayout() ) );
+    options.setDeduplicateFiles( c.readEntry( "deduplicate files", options.deduplicateFiles() ) );
 
     QString w = c.readEntry( "white_space_treatment", "noChange" );
     if( w == "replace" )
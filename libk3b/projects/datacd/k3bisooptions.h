@@ -110,6 +110,23 @@ namespace K3b {
         bool doNotImportSession() const { return m_doNotImportSession; }
         void setDoNotImportSession( bool b ) { m_doNotImportSession = b; }
 
+        /**
+         * If true K3b assigns sort weights to the files which have none
+         * in order to speed up reading the burned medium: boot images and
+         * autostart/index files are placed first, folders which only contain
+         * small files are moved near the directory records as a whole.
+         * User-set sort weights always win.
+         */
+        bool optimizeLayout() const { return m_optimizeLayout; }
+        void setOptimizeLayout( bool b ) { m_optimizeLayout = b; }
+
+        /**
+         * If true files with identical contents are searched before writing the
+         * image and stored only once. This forces inode caching in mkisofs.
+         */
+        bool deduplicateFiles() const { return m_deduplicateFiles; }
+        void setDeduplicateFiles( bool b ) { m_deduplicateFiles = b; }
+
         void save( KConfigGroup c, bool saveVolumeDesc = true );
 
         static IsoOptions load( const KConfigGroup& c, bool loadVolumeDesc = true );
@@ -159,6 +176,8 @@ namespace K3b {
 
         bool m_doNotCacheInodes;
         bool m_doNotImportSession;
+        bool m_optimizeLayout;
+        bool m_deduplicateFiles;
 
         int m_isoLevel;
 
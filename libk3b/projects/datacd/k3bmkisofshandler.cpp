@@ -8,6 +8,7 @@
 #include "k3bexternalbinmanager.h"
 #include "k3bcore.h"
 #include "k3bjob.h"
+#include "k3boutputparser.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -20,12 +21,28 @@
 class K3b::MkisofsHandler::Private
 {
 public:
+    int progress(double p);
+
     const K3b::ExternalBin* mkisofsBin;
     double firstProgressValue;
     bool readError;
 };
 
 
+int K3b::MkisofsHandler::Private::progress(double p)
+{
+    // in multisession mode mkisofs' progress does not start at 0 but at (X+Y)/X
+    // where X is the data already on the cd and Y the data to create
+    // This is not very dramatic but kind or ugly.
+    // We just save the first emitted progress value and to some math ;)
+    if (firstProgressValue < 0)
+        firstProgressValue = p;
+
+    return((int)::ceil((p - firstProgressValue) * 100.0 /
+                (100.0 - firstProgressValue)));
+}
+
+
 K3b::MkisofsHandler::MkisofsHandler()
 {
     d = new Private;
@@ -125,34 +142,21 @@ void K3b::MkisofsHandler::parseMkisofsOutput( const QString& line )
 
 int K3b::MkisofsHandler::parseMkisofsProgress(const QString& line)
 {
-    // in multisession mode mkisofs' progress does not start at 0 but at (X+Y)/X
-    // where X is the data already on the cd and Y the data to create
-    // This is not very dramatic but kind or ugly.
-    // We just save the first emitted progress value and to some math ;)
-
-    QString perStr = line;
-    perStr.truncate(perStr.indexOf('%'));
-    // FIXME: how to support Inuit or Samaritan Aramaic format or cover all
-    // formats? right now it only support, for example: 0.52 and 0,52
-    static const QRegularExpression rx("(\\d+.|,+\\d)");
-    QStringList list;
-    for (auto it = rx.globalMatch(perStr); it.hasNext();) {
-        const auto match = it.next();
-        list << match.captured(1);
-    }
-    if (list.size() < 2)
-        return -1;
-    // FIXME: the same story
-    bool ok;
-    double p = (list[0].replace(',', '.') + list[1]).toDouble(&ok);
-    if (!ok) {
-        qDebug() << "(K3b::MkisofsHandler) Parsing did not work for " << perStr;
+    const K3b::ProgressEvent progress = K3b::parseMkisofsProgress(line.toLatin1());
+    if (!progress.isValid()) {
+        qDebug() << "(K3b::MkisofsHandler) Parsing did not work for " << line;
         return -1;
-    } else {
-        if (d->firstProgressValue < 0)
-            d->firstProgressValue = p;
-
-        return((int)::ceil((p - d->firstProgressValue) * 100.0 /
-                    (100.0 - d->firstProgressValue)));
     }
+    return d->progress(progress.percent);
+}
+
+
+bool K3b::MkisofsHandler::parseMkisofsProgressLine(const QByteArray& line)
+{
+    const K3b::ProgressEvent progress = K3b::parseMkisofsProgress(line);
+    if (!progress.isValid())
+        return false;
+
+    handleMkisofsProgress(d->progress(progress.percent));
+    return true;
 }
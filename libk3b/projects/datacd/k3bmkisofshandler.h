@@ -6,6 +6,7 @@
 #ifndef _K3B_MKISOfS_HANDLER_H_
 #define _K3B_MKISOfS_HANDLER_H_
 
+#include <QByteArray>
 #include <QString>
 
 namespace K3b {
@@ -43,6 +44,15 @@ namespace K3b {
          */
         int parseMkisofsProgress( const QString& line );
 
+        /**
+         * Handles @p line through handleMkisofsProgress if it is a progress
+         * line without decoding it. Progress lines make up most of the output.
+         *
+         * \return false if @p line is no progress line and should be passed
+         *         on to parseMkisofsOutput.
+         */
+        bool parseMkisofsProgressLine( const QByteArray& line );
+
         /**
          * Called by handleMkisofsOutput
          */
@@ -36,6 +36,15 @@ namespace K3b {
          */
         virtual QIODevice* ioDevice() const { return 0; }
 
+        /**
+         * Lower the writing speed while writing, for example because the
+         * source cannot keep up. Only writers which talk to the drive
+         * themselves can do this.
+         *
+         * \return true if the speed has been lowered.
+         */
+        virtual bool reduceWriteSpeed() { return false; }
+
     public Q_SLOTS:
         /**
          * If the burnDevice is set this will try to unlock the drive and
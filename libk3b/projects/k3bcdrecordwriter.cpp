@@ -18,6 +18,7 @@
 #include "k3bglobals.h"
 #include "k3bthroughputestimator.h"
 #include "k3bglobalsettings.h"
+#include "k3boutputparser.h"
 
 #include <QDebug>
 #include <QString>
@@ -42,6 +43,9 @@ public:
     const ExternalBin* cdrecordBinObject;
     Process process;
 
+    // keeps the progress lines from flooding the debugging output
+    ProgressLineFilter progressFilter;
+
     WritingMode writingMode;
     FormattingMode formattingMode;
     bool totalTracksParsed;
@@ -105,7 +109,7 @@ K3b::CdrecordWriter::CdrecordWriter( K3b::Device::Device* dev, K3b::JobHandler*
     d->process.setSplitStdout(true);
     d->process.setSuppressEmptyLines(true);
     d->process.setFlags( K3bQProcess::RawStdin );
-    connect( &d->process, SIGNAL(stdoutLine(QString)), this, SLOT(slotStdLine(QString)) );
+    connect( &d->process, SIGNAL(rawStdoutLine(QByteArray)), this, SLOT(slotRawStdLine(QByteArray)) );
 
     // we use a queued connection to give the process object time to wrap up and return to a correct state
     qRegisterMetaType<QProcess::ExitStatus>();
@@ -383,6 +387,7 @@ void K3b::CdrecordWriter::start()
     d->canceled = false;
     d->speedEst->reset();
     d->writingStarted = false;
+    d->progressFilter.reset();
 
     if ( !prepareProcess() ) {
         jobFinished(false);
@@ -467,18 +472,29 @@ void K3b::CdrecordWriter::cancel()
 }
 
 
+void K3b::CdrecordWriter::slotRawStdLine( const QByteArray& line )
+{
+    // the progress lines make up most of the output and are parsed without decoding them
+    if( d->totalTracksParsed ) {
+        const ProgressEvent progress = K3b::parseCdrecordProgress( line );
+        if( progress.isValid() ) {
+            if( d->progressFilter.accept( line ) )
+                emit debuggingOutput( d->cdrecordBinObject->name(), QString::fromLatin1( line ) );
+            handleTrackProgress( progress );
+            return;
+        }
+    }
+
+    logSkippedProgress();
+    slotStdLine( QString::fromLocal8Bit( line ) );
+}
+
+
 void K3b::CdrecordWriter::slotStdLine( const QString& line )
 {
     static const QRegularExpression s_burnfreeCounterRx( "^BURN\\-Free\\swas\\s(\\d+)\\stimes\\sused" );
     static const QRegularExpression s_burnfreeCounterRxPredict( "^Total\\sof\\s(\\d+)\\s\\spossible\\sbuffer\\sunderruns\\spredicted" );
 
-    // tracknumber: cap(1)
-    // done: cap(2)
-    // complete: cap(3)
-    // fifo: cap(4)  (it seems as if some patched cdrecord versions do not emit the fifo info but only the buf... :(
-    // buffer: cap(5)
-    static const QRegularExpression s_progressRx( QRegularExpression::anchoredPattern( "Track\\s(\\d\\d)\\:\\s*(\\d*)\\sof\\s*(\\d*)\\sMB\\swritten\\s(?:\\(fifo\\s*(\\d*)\\%\\)\\s*)?(?:\\[buf\\s*(\\d*)\\%\\])?.*" ) );
-
     emit debuggingOutput( d->cdrecordBinObject->name(), line );
 
     //
@@ -516,50 +532,8 @@ void K3b::CdrecordWriter::slotStdLine( const QString& line )
                          << line.mid( 6, 2 );
         }
 
-        else if( const auto progressMatch = s_progressRx.match( line ); progressMatch.hasMatch() ) {
-            //      int num = s_progressRx.cap(1).toInt();
-            int made = progressMatch.capturedView(2).toInt();
-            int size = progressMatch.capturedView(3).toInt();
-            int fifo = progressMatch.capturedView(4).toInt();
-
-            emit buffer( fifo );
-            d->lastFifoValue = fifo;
-
-            if( progressMatch.lastCapturedIndex() > 4 )
-                emit deviceBuffer( progressMatch.capturedView(5).toInt() );
-
-            //
-            // cdrecord's output sucks a bit.
-            // we get track sizes that differ from the sizes in the progress
-            // info since these are dependent on the writing mode.
-            // so we just use the track sizes and do a bit of math...
-            //
-
-            if( d->tracks.count() > d->currentTrack-1 && size > 0 ) {
-                double convV = (double)d->tracks[d->currentTrack-1].size/(double)size;
-                made = (int)((double)made * convV);
-                size = d->tracks[d->currentTrack-1].size;
-            }
-            else {
-                qCritical() << "(K3b::CdrecordWriter) Did not parse all tracks sizes!" << Qt::endl;
-            }
-
-            if( !d->writingStarted ) {
-                d->writingStarted = true;
-                emit newSubTask( i18n("Writing data") );
-            }
-
-            if( size > 0 ) {
-                emit processedSubSize( made, size );
-                emit subPercent( 100*made/size );
-            }
-
-            if( d->totalSize > 0 ) {
-                emit processedSize( d->alreadyWritten+made, d->totalSize );
-                emit percent( 100*(d->alreadyWritten+made)/d->totalSize );
-            }
-
-            d->speedEst->dataWritten( (d->alreadyWritten+made)*1024 );
+        else {
+            handleTrackProgress( K3b::parseCdrecordProgress( line.toLatin1() ) );
         }
     }
 
@@ -758,8 +732,68 @@ void K3b::CdrecordWriter::slotStdLine( const QString& line )
 }
 
 
+void K3b::CdrecordWriter::handleTrackProgress( const ProgressEvent& progress )
+{
+    if( progress.type != ProgressEvent::TrackWritten )
+        return;
+
+    int made = progress.done;
+    int size = progress.total;
+    int fifo = qMax( 0, progress.fifo );
+
+    emit buffer( fifo );
+    d->lastFifoValue = fifo;
+
+    if( progress.deviceBuffer >= 0 )
+        emit deviceBuffer( progress.deviceBuffer );
+
+    //
+    // cdrecord's output sucks a bit.
+    // we get track sizes that differ from the sizes in the progress
+    // info since these are dependent on the writing mode.
+    // so we just use the track sizes and do a bit of math...
+    //
+
+    if( d->tracks.count() > d->currentTrack-1 && size > 0 ) {
+        double convV = (double)d->tracks[d->currentTrack-1].size/(double)size;
+        made = (int)((double)made * convV);
+        size = d->tracks[d->currentTrack-1].size;
+    }
+    else {
+        qCritical() << "(K3b::CdrecordWriter) Did not parse all tracks sizes!" << Qt::endl;
+    }
+
+    if( !d->writingStarted ) {
+        d->writingStarted = true;
+        emit newSubTask( i18n("Writing data") );
+    }
+
+    if( size > 0 ) {
+        emit processedSubSize( made, size );
+        emit subPercent( 100*made/size );
+    }
+
+    if( d->totalSize > 0 ) {
+        emit processedSize( d->alreadyWritten+made, d->totalSize );
+        emit percent( 100*(d->alreadyWritten+made)/d->totalSize );
+    }
+
+    d->speedEst->dataWritten( (d->alreadyWritten+made)*1024 );
+}
+
+
+void K3b::CdrecordWriter::logSkippedProgress()
+{
+    const QByteArray line = d->progressFilter.takeSkipped();
+    if( !line.isEmpty() )
+        emit debuggingOutput( d->cdrecordBinObject->name(), QString::fromLatin1( line ) );
+}
+
+
 void K3b::CdrecordWriter::slotProcessExited( int exitCode, QProcess::ExitStatus exitStatus )
 {
+    logSkippedProgress();
+
     // remove temporary cdtext file
     delete d->cdTextFile;
     d->cdTextFile = 0;
@@ -15,6 +15,7 @@
 namespace K3b {
     class ExternalBin;
     class Process;
+    struct ProgressEvent;
     namespace Device {
         class Device;
     }
@@ -61,6 +62,7 @@ namespace K3b {
 
     protected Q_SLOTS:
         void slotStdLine( const QString& line );
+        void slotRawStdLine( const QByteArray& line );
         void slotProcessExited( int exitCode, QProcess::ExitStatus exitStatus );
         void slotThroughput( int t );
 
@@ -87,6 +89,9 @@ namespace K3b {
                              SHORT_READ };
 
     private:
+        void handleTrackProgress( const ProgressEvent& progress );
+        void logSkippedProgress();
+
         class Private;
         Private* d;
     };
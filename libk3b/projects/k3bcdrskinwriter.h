@@ -19,6 +19,7 @@
 namespace K3b {
     class ExternalBin;
     class Process;
+    struct ProgressEvent;
     namespace Device {
         class Device;
     }
@@ -65,6 +66,7 @@ namespace K3b {
 
     protected Q_SLOTS:
         void slotStdLine( const QString& line );
+        void slotRawStdLine( const QByteArray& line );
         void slotProcessExited( int exitCode, QProcess::ExitStatus exitStatus );
         void slotThroughput( int t );
 
@@ -91,6 +93,9 @@ namespace K3b {
                              SHORT_READ };
 
     private:
+        void handleTrackProgress( const ProgressEvent& progress );
+        void logSkippedProgress();
+
         class Private;
         Private* d;
     };
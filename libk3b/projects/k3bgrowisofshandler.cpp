@@ -8,6 +8,7 @@
 #include "k3bcore.h"
 #include "k3bglobalsettings.h"
 #include "k3bdevicehandler.h"
+#include "k3boutputparser.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -208,6 +209,19 @@ void K3b::GrowisofsHandler::handleLine( const QString& line )
 }
 
 
+void K3b::GrowisofsHandler::handleProgress( const ProgressEvent& progress )
+{
+    if( progress.fifo >= 0 && progress.fifo != d->lastBuffer ) {
+        d->lastBuffer = progress.fifo;
+        emit buffer( progress.fifo );
+    }
+    if( progress.deviceBuffer >= 0 && progress.deviceBuffer != d->lastDeviceBuffer ) {
+        d->lastDeviceBuffer = progress.deviceBuffer;
+        emit deviceBuffer( progress.deviceBuffer );
+    }
+}
+
+
 void K3b::GrowisofsHandler::handleExit( int exitCode )
 {
     switch( m_error ) {
@@ -14,6 +14,7 @@ namespace K3b {
         class Device;
         class DeviceHandler;
     }
+    struct ProgressEvent;
 
 
     /**
@@ -43,6 +44,12 @@ namespace K3b {
 
         void setMediaType(Device::MediaType mediaType);
 
+        /**
+         * Handles the buffer fill levels of a progress line which has
+         * been parsed without passing it to handleLine().
+         */
+        void handleProgress( const ProgressEvent& progress );
+
     public Q_SLOTS:
         /**
          * This will basically reset the error type
@@ -16,6 +16,7 @@
 #include "k3bgrowisofshandler.h"
 #include "k3bglobalsettings.h"
 #include "k3bdeviceglobals.h"
+#include "k3boutputparser.h"
 #include "k3b_i18n.h"
 
 #include <QDebug>
@@ -42,6 +43,9 @@ public:
     bool multiSession;
     K3b::Process process;
     const K3b::ExternalBin* growisofsBin;
+
+    // keeps the progress lines from flooding the debugging output
+    K3b::ProgressLineFilter progressFilter;
     QString image;
 
     bool success;
@@ -103,8 +107,8 @@ K3b::GrowisofsWriter::GrowisofsWriter( K3b::Device::Device* dev, K3b::JobHandler
     d->process.setSplitStdout(true);
     d->process.setSuppressEmptyLines(true);
     d->process.setFlags( K3bQProcess::RawStdin );
-    connect( &d->process, SIGNAL(stdoutLine(QString)), this, SLOT(slotReceivedStderr(QString)) );
-    connect( &d->process, SIGNAL(stderrLine(QString)), this, SLOT(slotReceivedStderr(QString)) );
+    connect( &d->process, SIGNAL(rawStdoutLine(QByteArray)), this, SLOT(slotReceivedRawStderr(QByteArray)) );
+    connect( &d->process, SIGNAL(rawStderrLine(QByteArray)), this, SLOT(slotReceivedRawStderr(QByteArray)) );
     connect( &d->process, SIGNAL(finished(int,QProcess::ExitStatus)), this, SLOT(slotProcessExited(int,QProcess::ExitStatus)) );
 }
 
@@ -317,6 +321,7 @@ void K3b::GrowisofsWriter::start()
     d->canceled = false;
     d->speedEst->reset();
     d->finished = false;
+    d->progressFilter.reset();
 
     if( !prepareProcess() ) {
         jobFinished( false );
@@ -417,62 +422,37 @@ void K3b::GrowisofsWriter::setImageToWrite( const QString& filename )
 }
 
 
-void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
+void K3b::GrowisofsWriter::slotReceivedRawStderr( const QByteArray& line )
 {
-    emit debuggingOutput( d->growisofsBin->name(), line );
+    // the progress lines make up most of the output and are parsed without decoding them
+    const ProgressEvent progress = K3b::parseGrowisofsProgress( line );
+    if( progress.isValid() ) {
+        if( d->progressFilter.accept( line ) )
+            emit debuggingOutput( d->growisofsBin->name(), QString::fromLatin1( line ) );
+        handleProgress( progress );
+        d->gh->handleProgress( progress );
+    }
+    else {
+        logSkippedProgress();
+        slotReceivedStderr( QString::fromLocal8Bit( line ) );
+    }
+}
 
-    if( line.contains( "remaining" ) ) {
 
-        if( !d->writingStarted ) {
-            d->writingStarted = true;
-            emit newSubTask( i18n("Writing data") );
-        }
+void K3b::GrowisofsWriter::logSkippedProgress()
+{
+    const QByteArray line = d->progressFilter.takeSkipped();
+    if( !line.isEmpty() )
+        emit debuggingOutput( d->growisofsBin->name(), QString::fromLatin1( line ) );
+}
 
-        // parse progress
-        int pos = line.indexOf( '/' );
-        unsigned long long done = line.left( pos ).toULongLong();
-        bool ok = true;
-        d->overallSizeFromOutput = line.mid( pos+1, line.indexOf( '(', pos ) - pos - 1 ).toULongLong( &ok );
-        if( d->firstSizeFromOutput == -1 )
-            d->firstSizeFromOutput = done;
-        done -= d->firstSizeFromOutput;
-        d->overallSizeFromOutput -= d->firstSizeFromOutput;
-        if( ok ) {
-            int p = (int)(100 * done / d->overallSizeFromOutput);
-            if( p > d->lastProgress ) {
-                emit percent( p );
-                emit subPercent( p );
-                d->lastProgress = p;
-            }
-            if( (unsigned int)(done/1024/1024) > d->lastProgressed ) {
-                d->lastProgressed = (unsigned int)(done/1024/1024);
-                emit processedSize( d->lastProgressed, (int)(d->overallSizeFromOutput/1024/1024)  );
-                emit processedSubSize( d->lastProgressed, (int)(d->overallSizeFromOutput/1024/1024)  );
-            }
 
-            // try parsing write speed (since growisofs 5.11)
-            pos = line.indexOf( '@' );
-            if( pos != -1 ) {
-                pos += 1;
-                double speed = line.mid( pos, line.indexOf( 'x', pos ) - pos ).toDouble(&ok);
-                if (ok) {
-                    if (d->lastWritingSpeed != speed) {
-                        emit writeSpeed((int)(speed * d->speedMultiplicator()), d->speedMultiplicator());
-                    }
-                    d->lastWritingSpeed = speed;
-                }
-                else
-                    qDebug() << "(K3b::GrowisofsWriter) speed parsing failed: '"
-                             << line.mid( pos, line.indexOf( 'x', pos ) - pos ) << "'" << Qt::endl;
-            }
-            else {
-                d->speedEst->dataWritten( done/1024 );
-            }
-        }
-        else
-            qDebug() << "(K3b::GrowisofsWriter) progress parsing failed: '"
-                     << line.mid( pos+1, line.indexOf( '(', pos ) - pos - 1 ).trimmed() << "'" << Qt::endl;
-    }
+void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
+{
+    emit debuggingOutput( d->growisofsBin->name(), line );
+
+    if( line.contains( "remaining" ) )
+        handleProgress( K3b::parseGrowisofsProgress( line.toLatin1() ) );
 
     //  else
     // to be able to parse the ring buffer fill in growisofs 6.0 we need to do this all the time
@@ -481,8 +461,56 @@ void K3b::GrowisofsWriter::slotReceivedStderr( const QString& line )
 }
 
 
+void K3b::GrowisofsWriter::handleProgress( const ProgressEvent& progress )
+{
+    if( progress.type != ProgressEvent::DataWritten ) {
+        qDebug() << "(K3b::GrowisofsWriter) progress parsing failed.";
+        return;
+    }
+
+    if( !d->writingStarted ) {
+        d->writingStarted = true;
+        emit newSubTask( i18n("Writing data") );
+    }
+
+    unsigned long long done = progress.done;
+    d->overallSizeFromOutput = progress.total;
+    if( d->firstSizeFromOutput == -1 )
+        d->firstSizeFromOutput = done;
+    done -= d->firstSizeFromOutput;
+    d->overallSizeFromOutput -= d->firstSizeFromOutput;
+    if( d->overallSizeFromOutput == 0 )
+        return;
+
+    int p = (int)(100 * done / d->overallSizeFromOutput);
+    if( p > d->lastProgress ) {
+        emit percent( p );
+        emit subPercent( p );
+        d->lastProgress = p;
+    }
+    if( (unsigned int)(done/1024/1024) > d->lastProgressed ) {
+        d->lastProgressed = (unsigned int)(done/1024/1024);
+        emit processedSize( d->lastProgressed, (int)(d->overallSizeFromOutput/1024/1024)  );
+        emit processedSubSize( d->lastProgressed, (int)(d->overallSizeFromOutput/1024/1024)  );
+    }
+
+    // the writing speed is printed since growisofs 5.11
+    if( progress.speed >= 0.0 ) {
+        if (d->lastWritingSpeed != progress.speed) {
+            emit writeSpeed((int)(progress.speed * d->speedMultiplicator()), d->speedMultiplicator());
+        }
+        d->lastWritingSpeed = progress.speed;
+    }
+    else {
+        d->speedEst->dataWritten( done/1024 );
+    }
+}
+
+
 void K3b::GrowisofsWriter::slotProcessExited( int exitCode, QProcess::ExitStatus )
 {
+    logSkippedProgress();
+
     d->inputFile.close();
 
     // release the device within this process
@@ -14,6 +14,7 @@ namespace K3b {
     namespace Device {
         class Device;
     }
+    struct ProgressEvent;
 
     class GrowisofsWriter : public AbstractWriter
     {
@@ -83,11 +84,15 @@ namespace K3b {
 
     protected Q_SLOTS:
         void slotReceivedStderr( const QString& );
+        void slotReceivedRawStderr( const QByteArray& );
         void slotProcessExited( int, QProcess::ExitStatus );
         void slotThroughput( int t );
         void slotFlushingCache();
 
     private:
+        void handleProgress( const ProgressEvent& progress );
+        void logSkippedProgress();
+
         class Private;
         Private* d;
     };
@@ -0,0 +1,824 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "k3bmmcwriter.h"
+
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3bdiskinfo.h"
+#include "k3bdeviceglobals.h"
+#include "k3bmediacache.h"
+#include "k3bmedium.h"
+#include "k3bglobalsettings.h"
+#include "k3bactivepipe.h"
+#include "k3bfanoutbuffer.h"
+#include "k3bthroughputestimator.h"
+#include "k3b_i18n.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <QTimer>
+
+#include <string.h>
+
+
+namespace {
+    const int s_sectorSize = 2048;
+
+    // 32 sectors are one ECC block on Blu-ray and two on DVD
+    const int s_blockSectors = 32;
+
+    // a drive may report a long write in progress while it is busy with
+    // a layer jump or its power calibration
+    const int s_busyRetryDelay = 10;      // msecs
+    const int s_maxBusyRetries = 6000;
+
+    // how long we wait for the drive buffer to drain
+    const int s_bufferPollDelay = 2;      // msecs
+    const int s_maxBufferPolls = 5000;
+
+    // read the drive buffer capacity at least every that many writes
+    const int s_bufferPollInterval = 16;
+
+    // closing a session or finalizing may take a while
+    const int s_maxFinalizeTime = 30*60;  // secs
+
+    bool longWriteInProgress( int transportResult )
+    {
+        // NOT READY, LOGICAL UNIT NOT READY, OPERATION or LONG WRITE IN PROGRESS
+        const int senseKey = ( transportResult >> 16 ) & 0xF;
+        const int asc = ( transportResult >> 8 ) & 0xFF;
+        const int ascq = transportResult & 0xFF;
+        return ( senseKey == 0x2 && asc == 0x04 && ( ascq == 0x07 || ascq == 0x08 ) );
+    }
+}
+
+
+class K3b::MmcWriter::Private
+{
+public:
+    /**
+     * The sink of the ring buffer. Its writeData is called from the
+     * thread the FanOutBuffer uses to feed it.
+     */
+    class DriveStream : public QIODevice
+    {
+    public:
+        DriveStream()
+            : device( 0 ),
+              lba( 0 ),
+              fill( 0 ),
+              writes( 0 ),
+              bufferLength( 0 ),
+              bufferAvail( 0 ),
+              bufferCapacitySupported( true ) {
+        }
+
+        void reset( Device::Device* dev, unsigned long startLba ) {
+            device = dev;
+            lba = startLba;
+            block.resize( s_blockSectors*s_sectorSize );
+            fill = 0;
+            writes = 0;
+            bufferLength = bufferAvail = 0;
+            bufferCapacitySupported = true;
+            sectorsWritten.storeRelaxed( 0 );
+            deviceBufferFill.storeRelaxed( -1 );
+            error.storeRelaxed( 0 );
+            errorLba.storeRelaxed( 0 );
+            requestedSpeed.storeRelaxed( 0 );
+            canceled.storeRelaxed( 0 );
+        }
+
+        /**
+         * Writes the remaining data padded to full sectors. If @p trackSize
+         * is bigger than the number of written sectors the track is padded
+         * with zeros (the size of DAO tracks has been reserved before).
+         */
+        bool flush( qint64 trackSize );
+
+        Device::Device* device;
+        unsigned long lba;
+        QByteArray block;
+        int fill;
+
+        QAtomicInteger<qint64> sectorsWritten;
+        QAtomicInt deviceBufferFill;
+        QAtomicInt error;
+        QAtomicInt errorLba;
+
+        // a new writing speed which is set before the next block is written
+        QAtomicInt requestedSpeed;
+
+        // stops waiting for a busy drive, set from the GUI thread
+        QAtomicInt canceled;
+
+    protected:
+        qint64 readData( char*, qint64 ) override { return -1; }
+        qint64 writeData( const char* data, qint64 len ) override;
+
+    private:
+        bool writeBlock( int sectors );
+        bool waitForDeviceBuffer( int bytes );
+
+        int writes;
+        long long bufferLength;
+        long long bufferAvail;
+        bool bufferCapacitySupported;
+    };
+
+    class Finalizer : public QThread
+    {
+    public:
+        explicit Finalizer( MmcWriter* writer )
+            : success( false ),
+              m_writer( writer ) {
+        }
+
+        void run() override;
+
+        bool success;
+
+    private:
+        bool waitForDevice();
+
+        MmcWriter* m_writer;
+    };
+
+    explicit Private( MmcWriter* writer )
+        : writingMode( K3b::WritingModeAuto ),
+          multiSession( false ),
+          closeDvd( false ),
+          trackSize( -1 ),
+          buffer( 0 ),
+          finalizer( writer ),
+          running( false ),
+          canceled( false ),
+          haveHandle( false ),
+          startLba( 0 ),
+          trackNumber( 1 ),
+          closeTrack( false ),
+          closeFunction( 0 ),
+          padTrack( false ),
+          lastProgress( 0 ),
+          lastProcessed( 0 ),
+          currentSpeed( 0 ),
+          burnedMediumType( Device::MEDIA_UNKNOWN ) {
+    }
+
+    K3b::WritingMode writingMode;
+    bool multiSession;
+    bool closeDvd;
+    long trackSize;
+    QString image;
+
+    FanOutBuffer* buffer;
+    DriveStream stream;
+    Finalizer finalizer;
+    ActivePipe imagePipe;
+    QFile imageFile;
+    QTimer progressTimer;
+    ThroughputEstimator* speedEst;
+
+    bool running;
+    bool canceled;
+    bool haveHandle;
+
+    // the way the medium is written, determined in prepareMedium()
+    unsigned long startLba;
+    int trackNumber;
+    bool closeTrack;
+    int closeFunction;
+    bool padTrack;
+
+    int lastProgress;
+    int lastProcessed;
+
+    // the writing speed set in prepareMedium() and the ones the medium supports
+    int currentSpeed;
+    QList<int> writingSpeeds;
+
+    Device::MediaType burnedMediumType;
+
+    K3b::Device::SpeedMultiplicator speedMultiplicator() const {
+        return K3b::speedMultiplicatorForMediaType( burnedMediumType );
+    }
+};
+
+
+qint64 K3b::MmcWriter::Private::DriveStream::writeData( const char* data, qint64 len )
+{
+    qint64 done = 0;
+    while( done < len ) {
+        const qint64 n = qMin( len - done, qint64( block.size() - fill ) );
+        ::memcpy( block.data() + fill, data + done, n );
+        fill += n;
+        done += n;
+
+        if( fill == block.size() && !writeBlock( s_blockSectors ) )
+            return -1;
+    }
+
+    return done;
+}
+
+
+bool K3b::MmcWriter::Private::DriveStream::flush( qint64 trackSize )
+{
+    if( fill % s_sectorSize ) {
+        const int pad = s_sectorSize - fill % s_sectorSize;
+        ::memset( block.data() + fill, 0, pad );
+        fill += pad;
+    }
+
+    while( sectorsWritten.loadRelaxed() + fill/s_sectorSize < trackSize ) {
+        const qint64 missing = ( trackSize - sectorsWritten.loadRelaxed() ) * s_sectorSize - fill;
+        const int pad = qMin( qint64( block.size() - fill ), missing );
+        ::memset( block.data() + fill, 0, pad );
+        fill += pad;
+
+        if( fill == block.size() && !writeBlock( s_blockSectors ) )
+            return false;
+    }
+
+    if( fill > 0 )
+        return writeBlock( fill/s_sectorSize );
+    else
+        return true;
+}
+
+
+bool K3b::MmcWriter::Private::DriveStream::writeBlock( int sectors )
+{
+    const int bytes = sectors*s_sectorSize;
+
+    const int speed = requestedSpeed.fetchAndStoreRelaxed( 0 );
+    if( speed > 0 && !device->setSpeed( 0xFFFF, speed ) )
+        qDebug() << "(K3b::MmcWriter) changing the speed to" << speed << "failed.";
+
+    if( !waitForDeviceBuffer( bytes ) )
+        return false;
+
+    int retries = 0;
+    Q_FOREVER {
+        const int r = device->write10( reinterpret_cast<const unsigned char*>( block.constData() ), bytes, lba, sectors );
+        if( r == 0 )
+            break;
+
+        if( canceled.loadRelaxed() )
+            return false;
+
+        if( longWriteInProgress( r ) && ++retries < s_maxBusyRetries ) {
+            QThread::msleep( s_busyRetryDelay );
+            continue;
+        }
+
+        qDebug() << "(K3b::MmcWriter) WRITE 10 failed at sector" << lba << "error:" << Qt::hex << r;
+        errorLba.storeRelaxed( lba );
+        error.storeRelaxed( r );
+        return false;
+    }
+
+    lba += sectors;
+    sectorsWritten.fetchAndAddRelaxed( sectors );
+    bufferAvail -= bytes;
+    fill = 0;
+
+    return true;
+}
+
+
+bool K3b::MmcWriter::Private::DriveStream::waitForDeviceBuffer( int bytes )
+{
+    if( !bufferCapacitySupported )
+        return true;
+
+    //
+    // Only ask the drive once our estimation says its buffer is full. Sending
+    // a WRITE while the buffer is full keeps the drive busy with the command
+    // until the buffer has drained which may take longer than the transport
+    // timeout.
+    //
+    if( bufferAvail >= bytes && ++writes % s_bufferPollInterval )
+        return true;
+
+    for( int i = 0; i < s_maxBufferPolls && !canceled.loadRelaxed(); ++i ) {
+        if( device->readBufferCapacity( bufferLength, bufferAvail ) || bufferLength <= 0 ) {
+            qDebug() << "(K3b::MmcWriter) drive does not report its buffer capacity.";
+            bufferCapacitySupported = false;
+            return true;
+        }
+
+        deviceBufferFill.storeRelaxed( 100 * ( bufferLength - bufferAvail ) / bufferLength );
+
+        if( bufferAvail >= bytes )
+            return true;
+
+        QThread::msleep( s_bufferPollDelay );
+    }
+
+    // the drive gets the block anyway once the buffer did not drain in time
+    return !canceled.loadRelaxed();
+}
+
+
+void K3b::MmcWriter::Private::Finalizer::run()
+{
+    success = false;
+
+    Private* d = m_writer->d;
+    Device::Device* dev = d->stream.device;
+
+    if( !d->stream.flush( d->padTrack ? d->trackSize : 0 ) )
+        return;
+
+    emit m_writer->newSubTask( i18n("Flushing cache") );
+    if( !dev->synchronizeCache( true ) || !waitForDevice() ) {
+        emit m_writer->infoMessage( i18n("Could not flush the drive cache."), MessageError );
+        return;
+    }
+
+    if( d->closeTrack ) {
+        emit m_writer->newSubTask( i18n("Closing track") );
+        if( !dev->closeTrackSession( 0x1, d->trackNumber, true ) || !waitForDevice() ) {
+            emit m_writer->infoMessage( i18n("Could not close the track."), MessageError );
+            return;
+        }
+    }
+
+    if( d->closeFunction ) {
+        if( d->closeFunction == 0x6 )
+            emit m_writer->newSubTask( i18n("Finalizing disc") );
+        else
+            emit m_writer->newSubTask( i18n("Closing session") );
+
+        if( !dev->closeTrackSession( d->closeFunction, 0, true ) || !waitForDevice() ) {
+            emit m_writer->infoMessage( i18n("Could not close the session."), MessageError );
+            return;
+        }
+    }
+
+    success = true;
+}
+
+
+bool K3b::MmcWriter::Private::Finalizer::waitForDevice()
+{
+    // the commands have been sent with the immediate bit set, the drive
+    // reports not to be ready until it is done
+    QElapsedTimer timer;
+    timer.start();
+    while( !m_writer->d->stream.device->testUnitReady() ) {
+        if( timer.elapsed() > s_maxFinalizeTime*1000 )
+            return false;
+        QThread::msleep( 500 );
+    }
+    return true;
+}
+
+
+K3b::MmcWriter::MmcWriter( K3b::Device::Device* dev, K3b::JobHandler* hdl,
+                           QObject* parent )
+    : K3b::AbstractWriter( dev, hdl, parent ),
+      d( new Private( this ) )
+{
+    d->speedEst = new K3b::ThroughputEstimator( this );
+    connect( d->speedEst, SIGNAL(throughput(int)),
+             this, SLOT(slotThroughput(int)) );
+
+    d->progressTimer.setInterval( 500 );
+    connect( &d->progressTimer, SIGNAL(timeout()), this, SLOT(slotUpdateProgress()) );
+    connect( &d->finalizer, SIGNAL(finished()), this, SLOT(slotFinalizingFinished()) );
+}
+
+
+K3b::MmcWriter::~MmcWriter()
+{
+    d->finalizer.wait();
+    if( d->running )
+        cleanup();
+    delete d->buffer;
+    delete d;
+}
+
+
+bool K3b::MmcWriter::active() const
+{
+    return d->running;
+}
+
+
+QIODevice* K3b::MmcWriter::ioDevice() const
+{
+    return d->buffer;
+}
+
+
+bool K3b::MmcWriter::reduceWriteSpeed()
+{
+    if( !d->running || d->currentSpeed <= 0 )
+        return false;
+
+    // the next lower speed the medium supports or half the speed
+    int speed = 0;
+    Q_FOREACH( int s, d->writingSpeeds ) {
+        if( s < d->currentSpeed && s > speed )
+            speed = s;
+    }
+    if( speed == 0 && d->writingSpeeds.isEmpty() )
+        speed = d->currentSpeed / 2;
+
+    if( speed < d->speedMultiplicator() )
+        return false;
+
+    qDebug() << "(K3b::MmcWriter) reducing the speed from" << d->currentSpeed << "to" << speed;
+    d->currentSpeed = speed;
+    d->stream.requestedSpeed.storeRelaxed( speed );
+
+    emit infoMessage( i18n("Reducing the writing speed to %1x.",
+                           QString::number( double( speed ) / double( d->speedMultiplicator() ), 'g', 2 ) ),
+                      MessageWarning );
+    return true;
+}
+
+
+bool K3b::MmcWriter::canWrite( const Device::DiskInfo& info, bool multiSession )
+{
+    const Device::MediaType mt = info.mediaType();
+
+    if( mt & ( Device::MEDIA_DVD_PLUS_RW|Device::MEDIA_DVD_RW_OVWR|Device::MEDIA_BD_RE ) ) {
+        // growisofs grows the file system for us, unformatted media need to be formatted
+        return !multiSession && info.bgFormatState() != Device::BG_FORMAT_NONE;
+    }
+    else if( mt & ( Device::MEDIA_DVD_R|Device::MEDIA_DVD_R_SEQ|Device::MEDIA_DVD_RW_SEQ|
+                    Device::MEDIA_DVD_R_DL_SEQ|Device::MEDIA_DVD_PLUS_R|Device::MEDIA_DVD_PLUS_R_DL|
+                    Device::MEDIA_BD_R_SRM ) ) {
+        return info.empty() || info.appendable();
+    }
+    else {
+        return false;
+    }
+}
+
+
+bool K3b::MmcWriter::prepareMedium()
+{
+    Device::Device* dev = burnDevice();
+    const Medium medium = k3bcore->mediaCache()->medium( dev );
+    const Device::DiskInfo info = medium.diskInfo();
+    const Device::MediaType mt = info.mediaType();
+
+    d->burnedMediumType = mt;
+    d->writingSpeeds = medium.writingSpeeds();
+    d->currentSpeed = 0;
+
+    if( !canWrite( info, d->multiSession ) ) {
+        emit infoMessage( i18n("Cannot write %1 media.", Device::mediaTypeString( mt, true ) ), MessageError );
+        return false;
+    }
+
+    const bool overwrite = ( mt & ( Device::MEDIA_DVD_PLUS_RW|Device::MEDIA_DVD_RW_OVWR|Device::MEDIA_BD_RE ) );
+
+    if( simulate() && !( mt & Device::MEDIA_DVD_MINUS_ALL && !overwrite ) ) {
+        emit infoMessage( i18n("%1 media do not support write simulation.", Device::mediaTypeString( mt, true ) ), MessageError );
+        return false;
+    }
+
+    d->trackNumber = info.numTracks() + 1;
+    d->closeTrack = false;
+    d->closeFunction = 0;
+    d->padTrack = false;
+
+    if( overwrite ) {
+        d->startLba = 0;
+
+        // stop the background formatting to make the disc readable in other drives
+        if( mt & Device::MEDIA_DVD_PLUS_RW && d->closeDvd &&
+            info.bgFormatState() & ( Device::BG_FORMAT_INCOMPLETE|Device::BG_FORMAT_IN_PROGRESS ) )
+            d->closeFunction = 0x2;
+    }
+    else {
+        const int nwa = dev->nextWritableAddress();
+        if( nwa < 0 ) {
+            emit infoMessage( i18n("Could not determine the next writable address."), MessageError );
+            return false;
+        }
+        d->startLba = nwa;
+
+        if( mt & Device::MEDIA_DVD_MINUS_ALL ) {
+            // in DAO mode the drive closes the disc once the cache has been flushed
+            const bool dao = ( d->writingMode == K3b::WritingModeSao &&
+                               d->trackSize > 0 &&
+                               !d->multiSession &&
+                               info.empty() );
+
+            if( !dev->setDvdWriteParameters( dao ? 0x2 : 0x0, simulate(), d->multiSession ) ) {
+                emit infoMessage( i18n("Could not set the write parameters."), MessageError );
+                return false;
+            }
+
+            if( dao ) {
+                if( !dev->reserveTrack( d->trackSize ) ) {
+                    emit infoMessage( i18n("Could not reserve a track of %1 sectors.", d->trackSize ), MessageError );
+                    return false;
+                }
+                d->padTrack = true;
+            }
+            else {
+                d->closeTrack = true;
+                d->closeFunction = 0x2;
+            }
+        }
+        else {
+            d->closeTrack = true;
+            d->closeFunction = ( d->closeDvd && !d->multiSession ? 0x6 : 0x2 );
+        }
+    }
+
+    //
+    // Some DVD writers do not allow changing the writing speed so we allow
+    // the user to ignore the speed setting
+    //
+    int speed = burnSpeed();
+    if( speed >= 0 ) {
+        if( speed == 0 )
+            speed = dev->determineMaximalWriteSpeed();
+        if( speed > 0 && !dev->setSpeed( 0xFFFF, speed ) )
+            qDebug() << "(K3b::MmcWriter) setting the speed to" << speed << "failed.";
+        else
+            d->currentSpeed = speed;
+    }
+
+    emit debuggingOutput( "Burned media", K3b::Device::mediaTypeString( mt ) );
+    emit debuggingOutput( "Write parameters",
+                          QString::fromLatin1( "start: %1, track: %2, close track: %3, close function: %4, pad: %5" )
+                          .arg( d->startLba ).arg( d->trackNumber ).arg( d->closeTrack ).arg( d->closeFunction ).arg( d->padTrack ) );
+
+    return true;
+}
+
+
+void K3b::MmcWriter::start()
+{
+    jobStarted();
+
+    d->running = true;
+    d->canceled = false;
+    d->lastProgress = 0;
+    d->lastProcessed = 0;
+    d->speedEst->reset();
+
+    emit newSubTask( i18n("Preparing write process...") );
+
+    // writing behind the back of a mounted filesystem corrupts the medium
+    if( K3b::isMounted( burnDevice() ) ) {
+        emit infoMessage( i18n("Unmounting medium"), MessageInfo );
+        if( !K3b::unmount( burnDevice() ) ) {
+            emit infoMessage( i18n("Could not unmount the medium in %1.", burnDevice()->blockDeviceName() ), MessageError );
+            d->running = false;
+            jobFinished( false );
+            return;
+        }
+    }
+
+    // block the device (including certain checks)
+    k3bcore->blockDevice( burnDevice() );
+
+    // keep the device open instead of opening it for every command
+    d->haveHandle = burnDevice()->acquireHandle( true );
+
+    if( !prepareMedium() ) {
+        finishWriting( false );
+        return;
+    }
+
+    const bool manualBufferSize = k3bcore->globalSettings()->useManualBufferSize();
+    const qint64 bufSize = qint64( manualBufferSize ? k3bcore->globalSettings()->bufferSize() : 32 ) * 1024 * 1024;
+
+    delete d->buffer;
+    d->buffer = new FanOutBuffer( bufSize );
+    d->stream.reset( burnDevice(), d->startLba );
+    d->buffer->addSink( &d->stream );
+    connect( d->buffer, SIGNAL(aboutToClose()), this, SLOT(slotBufferClosed()) );
+    d->buffer->open();
+
+    if( !d->image.isEmpty() ) {
+        d->imageFile.setFileName( d->image );
+        if( !d->imageFile.open( QIODevice::ReadOnly ) ) {
+            emit infoMessage( i18n("Could not open file %1.", d->image ), MessageError );
+            finishWriting( false );
+            return;
+        }
+        if( d->trackSize <= 0 )
+            d->trackSize = ( d->imageFile.size() + s_sectorSize - 1 ) / s_sectorSize;
+
+        d->imagePipe.readFrom( &d->imageFile, true );
+        d->imagePipe.writeTo( d->buffer, true );
+        d->imagePipe.open( true );
+    }
+
+    if( simulate() ) {
+        emit newTask( i18n("Simulating") );
+        emit infoMessage( i18n("Starting simulation..."),
+                          K3b::Job::MessageInfo );
+    }
+    else {
+        emit newTask( i18n("Writing") );
+        emit infoMessage( i18n("Starting disc write..."), K3b::Job::MessageInfo );
+    }
+
+    emit newSubTask( i18n("Writing data") );
+
+    d->progressTimer.start();
+}
+
+
+void K3b::MmcWriter::cancel()
+{
+    if( active() ) {
+        d->canceled = true;
+
+        // closing the track cannot be interrupted, slotFinalizingFinished takes care of the rest
+        if( d->finalizer.isRunning() )
+            return;
+
+        cleanup();
+
+        // this will unblock and eject the drive and emit the finished/canceled signals
+        K3b::AbstractWriter::cancel();
+    }
+}
+
+
+void K3b::MmcWriter::setWritingMode( K3b::WritingMode m )
+{
+    d->writingMode = m;
+}
+
+
+void K3b::MmcWriter::setMultiSession( bool b )
+{
+    d->multiSession = b;
+}
+
+
+void K3b::MmcWriter::setTrackSize( long size )
+{
+    d->trackSize = size;
+}
+
+
+void K3b::MmcWriter::setCloseDvd( bool b )
+{
+    d->closeDvd = b;
+}
+
+
+void K3b::MmcWriter::setImageToWrite( const QString& filename )
+{
+    d->image = filename;
+}
+
+
+void K3b::MmcWriter::slotBufferClosed()
+{
+    // the buffer emits aboutToClose once all data has been handed to the drive
+    if( !d->running || d->canceled || d->stream.error.loadRelaxed() )
+        return;
+
+    d->progressTimer.stop();
+    slotUpdateProgress();
+
+    d->finalizer.start();
+}
+
+
+void K3b::MmcWriter::slotFinalizingFinished()
+{
+    if( !d->running )
+        return;
+
+    if( d->canceled ) {
+        cleanup();
+        K3b::AbstractWriter::cancel();
+        return;
+    }
+
+    if( d->finalizer.success ) {
+        emit percent( 100 );
+        emit subPercent( 100 );
+
+        int s = d->speedEst->average();
+        if( s > 0 )
+            emit infoMessage( ki18n("Average overall write speed: %1 KB/s (%2x)")
+                              .subs( s )
+                              .subs( ( double )s/( double )d->speedMultiplicator(), 0, 'g', 2 ).toString(), MessageInfo );
+
+        if( simulate() )
+            emit infoMessage( i18n("Simulation successfully completed"), K3b::Job::MessageSuccess );
+        else
+            emit infoMessage( i18n("Writing successfully completed"), K3b::Job::MessageSuccess );
+    }
+    else if( d->stream.error.loadRelaxed() ) {
+        slotUpdateProgress();
+        return;
+    }
+
+    finishWriting( d->finalizer.success );
+}
+
+
+void K3b::MmcWriter::slotUpdateProgress()
+{
+    if( !d->running || !d->buffer )
+        return;
+
+    if( const int error = d->stream.error.loadRelaxed() ) {
+        emit infoMessage( i18n("Write error at sector %1 (sense key 0x%2, ASC 0x%3, ASCQ 0x%4).",
+                               d->stream.errorLba.loadRelaxed(),
+                               QString::number( ( error >> 16 ) & 0xF, 16 ),
+                               QString::number( ( error >> 8 ) & 0xFF, 16 ),
+                               QString::number( error & 0xFF, 16 ) ),
+                          MessageError );
+        finishWriting( false );
+        return;
+    }
+
+    const qint64 sectors = d->stream.sectorsWritten.loadRelaxed();
+
+    emit buffer( d->buffer->fillLevel() );
+    const int deviceBufferFill = d->stream.deviceBufferFill.loadRelaxed();
+    if( deviceBufferFill >= 0 )
+        emit deviceBuffer( deviceBufferFill );
+
+    d->speedEst->dataWritten( sectors*s_sectorSize/1024 );
+
+    if( d->trackSize > 0 ) {
+        const int p = qMin( qint64( 100 ), 100 * sectors / d->trackSize );
+        if( p > d->lastProgress ) {
+            d->lastProgress = p;
+            emit percent( p );
+            emit subPercent( p );
+        }
+
+        const int processed = sectors*s_sectorSize/1024/1024;
+        if( processed > d->lastProcessed ) {
+            d->lastProcessed = processed;
+            const int overall = qint64( d->trackSize )*s_sectorSize/1024/1024;
+            emit processedSize( processed, overall );
+            emit processedSubSize( processed, overall );
+        }
+    }
+}
+
+
+void K3b::MmcWriter::slotThroughput( int t )
+{
+    emit writeSpeed( t, d->speedMultiplicator() );
+}
+
+
+void K3b::MmcWriter::cleanup()
+{
+    d->progressTimer.stop();
+
+    if( d->buffer ) {
+        disconnect( d->buffer, SIGNAL(aboutToClose()), this, SLOT(slotBufferClosed()) );
+
+        // Stop the stream from waiting for a busy drive so the sink thread
+        // returns after the current command instead of blocking us.
+        d->stream.canceled.storeRelaxed( 1 );
+
+        // the producer's writes fail from now on
+        d->buffer->dropSink( &d->stream );
+        d->imagePipe.close();
+        d->buffer->waitForSinks();
+    }
+    d->imageFile.close();
+
+    if( d->stream.isOpen() )
+        d->stream.close();
+
+    if( d->haveHandle ) {
+        burnDevice()->releaseHandle();
+        d->haveHandle = false;
+    }
+
+    k3bcore->unblockDevice( burnDevice() );
+
+    d->running = false;
+}
+
+
+void K3b::MmcWriter::finishWriting( bool success )
+{
+    cleanup();
+    jobFinished( success );
+}
+
+#include "moc_k3bmmcwriter.cpp"
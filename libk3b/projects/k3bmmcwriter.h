@@ -0,0 +1,111 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef _K3B_MMC_WRITER_H_
+#define _K3B_MMC_WRITER_H_
+
+#include "k3babstractwriter.h"
+#include "k3bglobals.h"
+#include "k3b_export.h"
+
+
+namespace K3b {
+    namespace Device {
+        class Device;
+        class DiskInfo;
+    }
+
+    /**
+     * Writes a single data track to DVD and Blu-ray media without an external
+     * program. The data written to ioDevice() is collected in a ring buffer
+     * and sent to the drive with WRITE 10 commands from a thread of its own.
+     *
+     * The fill level of the drive buffer is read with READ BUFFER CAPACITY.
+     * Once the drive buffer is full the writer waits for it to drain instead
+     * of sending commands which the drive would keep busy until they run into
+     * a timeout.
+     *
+     * Supported are DVD-R(W) in sequential mode, DVD+R, and BD-R (SRM) which
+     * are written at the next writable address as well as formatted DVD+RW,
+     * DVD-RW in restricted overwrite mode, and BD-RE which are overwritten
+     * from the beginning. Use canWrite() to check a medium.
+     */
+    class LIBK3B_EXPORT MmcWriter : public AbstractWriter
+    {
+        Q_OBJECT
+
+    public:
+        MmcWriter( Device::Device*, JobHandler*,
+                   QObject* parent = 0 );
+        ~MmcWriter() override;
+
+        bool active() const override;
+
+        QIODevice* ioDevice() const override;
+
+        /**
+         * Switches to the next lower speed supported by the medium before
+         * the next block is written.
+         */
+        bool reduceWriteSpeed() override;
+
+        /**
+         * \return true if the medium described by @p info can be written
+         *         by the MmcWriter.
+         *
+         * Growing the file system on overwrite media (multisession) is not
+         * supported.
+         */
+        static bool canWrite( const Device::DiskInfo& info, bool multiSession );
+
+    public Q_SLOTS:
+        void start() override;
+        void cancel() override;
+
+        /**
+         * Only used with DVD-R(W) media. WritingModeSao results in
+         * disc-at-once writing if the track size is known.
+         */
+        void setWritingMode( K3b::WritingMode mode );
+
+        /**
+         * Keep the medium appendable.
+         */
+        void setMultiSession( bool b );
+
+        /**
+         * @param size size in blocks
+         */
+        void setTrackSize( long size );
+
+        /**
+         * Finalize DVD+R and BD-R media and stop the background formatting of
+         * DVD+RW media for maximum compatibility.
+         */
+        void setCloseDvd( bool );
+
+        /**
+         * set this to QString() or an empty string to let the writer
+         * read its data from ioDevice()
+         */
+        void setImageToWrite( const QString& );
+
+    private Q_SLOTS:
+        void slotBufferClosed();
+        void slotFinalizingFinished();
+        void slotUpdateProgress();
+        void slotThroughput( int t );
+
+    private:
+        bool prepareMedium();
+        void cleanup();
+        void finishWriting( bool success );
+
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -132,40 +132,26 @@ int K3b::VideoDvdImager::writePathSpec()
 }
 
 
-int K3b::VideoDvdImager::writePathSpecForDir( K3b::DirItem* dirItem, QTextStream& stream )
+bool K3b::VideoDvdImager::writePathSpecForItem( K3b::DataItem* item, QTextStream& stream )
 {
     //
     // We handle the VIDEO_TS dir differently since otherwise mkisofs is not able to
     // open the VideoDVD structures (see addMkisofsParameters)
     //
-    if( dirItem == d->doc->videoTsDir() ) {
-        return 0;
+    if( item == d->doc->videoTsDir() ) {
+        return false;
     }
 
-    int num = 0;
-    Q_FOREACH( K3b::DataItem* item, dirItem->children() ) {
-        num++;
-
-        if( item->isDir() ) {
-            // we cannot add the video_ts dir twice
-            if( item != d->doc->videoTsDir() ) {
-                stream << escapeGraftPoint( item->writtenPath() )
-                       << "="
-                       << escapeGraftPoint( dummyDir( static_cast<K3b::DirItem*>(item) ) ) << "\n";
-            }
-
-            int x = writePathSpecForDir( dynamic_cast<K3b::DirItem*>(item), stream );
-            if( x >= 0 )
-                num += x;
-            else
-                return -1;
-        }
-        else {
-            writePathSpecForFile( static_cast<K3b::FileItem*>(item), stream );
-        }
+    if( item->isDir() ) {
+        stream << escapeGraftPoint( item->writtenPath() )
+               << "="
+               << escapeGraftPoint( dummyDir( static_cast<K3b::DirItem*>(item) ) ) << "\n";
+    }
+    else {
+        writePathSpecForFile( static_cast<K3b::FileItem*>(item), stream );
     }
 
-    return num;
+    return true;
 }
 
 
@@ -38,7 +38,7 @@ namespace K3b {
         bool addMkisofsParameters( bool printSize = false ) override;
         int writePathSpec() override;
         void cleanup() override;
-        int writePathSpecForDir( DirItem* dirItem, QTextStream& stream ) override;
+        bool writePathSpecForItem( DataItem* item, QTextStream& stream ) override;
 
     protected Q_SLOTS:
         void slotReceivedStderr( const QString& ) override;
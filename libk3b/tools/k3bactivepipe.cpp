@@ -6,11 +6,31 @@
 */
 
 #include "k3bactivepipe.h"
+#include "k3bqprocess.h"
 
 #include <QDebug>
+#include <QFile>
 #include <QIODevice>
 #include <QThread>
 
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+
+namespace {
+    // the amount of data moved with one splice(), copy_file_range() or sendfile() call
+    const size_t s_transferChunkSize = 1024*1024;
+
+    // how far ahead of the writing the source is read into the page cache
+    const loff_t s_readAhead = 16*1024*1024;
+}
+#endif
+
 
 class K3b::ActivePipe::Private : public QThread
 {
@@ -27,6 +47,32 @@ public:
         qDebug() << "(K3b::ActivePipe) writing from" << sourceIODevice << "to" << sinkIODevice;
 
         bytesRead = bytesWritten = 0;
+
+#ifdef Q_OS_LINUX
+        if( canTransferDirectly() ) {
+            QFile* sourceFile = qobject_cast<QFile*>( sourceIODevice );
+            K3bQProcess* sinkProcess = qobject_cast<K3bQProcess*>( sinkIODevice );
+            QFile* sinkFile = qobject_cast<QFile*>( sinkIODevice );
+            if( sourceFile && sourceFile->handle() != -1 ) {
+                if( sinkProcess && sinkProcess->rawStdinHandle() != -1 &&
+                    transferDirectly( sourceFile->handle(), sourceFile->pos(), sinkProcess->rawStdinHandle(), 0 ) )
+                    return;
+
+                // copy_file_range() does not support appending
+                if( sinkFile && sinkFile->handle() != -1 &&
+                    !( sinkFile->openMode() & QIODevice::Append ) &&
+                    sinkFile->flush() ) {
+                    loff_t sinkPos = sinkFile->pos();
+                    if( transferDirectly( sourceFile->handle(), sourceFile->pos(), sinkFile->handle(), &sinkPos ) ) {
+                        // QFile does not know about the data written behind its back
+                        sinkFile->seek( sinkPos );
+                        return;
+                    }
+                }
+            }
+        }
+#endif
+
         buffer.resize( 10*2048 );
 
         bool fail = false;
@@ -59,6 +105,85 @@ public:
                  << "(total bytes read/written:" << bytesRead << "/" << bytesWritten << ")";
     }
 
+#ifdef Q_OS_LINUX
+    /**
+     * Subclasses may process the data in readData() and writeData()
+     * which the in-kernel transfer would bypass.
+     */
+    bool canTransferDirectly() const {
+        return m_pipe->metaObject() == &K3b::ActivePipe::staticMetaObject;
+    }
+
+    /**
+     * Moves the data from \p in starting at \p offset to \p out inside the
+     * kernel. If \p outOffset is 0 \p out is a pipe and the data is moved
+     * with splice(), otherwise \p out is a file which is written at
+     * \p outOffset with copy_file_range(). Falls back to sendfile() if the
+     * file systems do not support either.
+     *
+     * \return false if none is supported, i.e. nothing has been moved and
+     *         the data has to be copied the usual way.
+     */
+    bool transferDirectly( int in, loff_t offset, int out, loff_t* outOffset ) {
+        // a reader which went away has to result in EPIPE instead of SIGPIPE
+        sigset_t sigPipe;
+        ::sigemptyset( &sigPipe );
+        ::sigaddset( &sigPipe, SIGPIPE );
+        ::pthread_sigmask( SIG_BLOCK, &sigPipe, 0 );
+
+        ::posix_fadvise( in, offset, 0, POSIX_FADV_SEQUENTIAL );
+        loff_t readAheadPos = offset;
+
+        bool useSendfile = false;
+        forever {
+            // keep the kernel reading ahead of us so the writer never waits for the disk
+            if( offset + s_readAhead/2 >= readAheadPos ) {
+                ::posix_fadvise( in, readAheadPos, s_readAhead, POSIX_FADV_WILLNEED );
+                readAheadPos += s_readAhead;
+            }
+
+            ssize_t r = 0;
+            if( useSendfile )
+                r = ::sendfile64( out, in, &offset, s_transferChunkSize );
+            else if( outOffset )
+                r = ::copy_file_range( in, &offset, out, outOffset, s_transferChunkSize, 0 );
+            else
+                r = ::splice( in, &offset, out, 0, s_transferChunkSize, SPLICE_F_MOVE|SPLICE_F_MORE );
+
+            if( r > 0 ) {
+                bytesRead += r;
+                bytesWritten += r;
+                if( useSendfile && outOffset )
+                    *outOffset += r;
+            }
+            else if( r == 0 ) {
+                break;
+            }
+            else if( errno == EINTR ) {
+                continue;
+            }
+            else if( ( errno == EINVAL || errno == ENOSYS || errno == EXDEV || errno == EOPNOTSUPP ) && bytesWritten == 0 ) {
+                if( !useSendfile ) {
+                    // sendfile() writes at the file position of the sink
+                    if( outOffset && ::lseek64( out, *outOffset, SEEK_SET ) < 0 )
+                        return false;
+                    useSendfile = true;
+                    continue;
+                }
+                qDebug() << "(K3b::ActivePipe) in-kernel transfer not supported. Copying the data.";
+                return false;
+            }
+            else {
+                qDebug() << "(K3b::ActivePipe) in-kernel transfer failed:" << ::strerror( errno );
+                break;
+            }
+        }
+
+        qDebug() << "(K3b::ActivePipe) Done: moved" << bytesWritten << "bytes inside the kernel.";
+        return true;
+    }
+#endif
+
     void _k3b_close() {
         qDebug();
         if ( closeWhenDone )
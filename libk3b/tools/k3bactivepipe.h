@@ -20,6 +20,13 @@ namespace K3b {
      * QIODevices are set. Otherwise the pipe only serves as a conduit for
      * data streams. The latter is mostly interesting when using the ChecksumPipe
      * in combination with a Job that can only push data (like the DataTrackReader).
+     *
+     * On Linux the data is moved inside the kernel if the source is a QFile
+     * and the sink is a process reading its raw stdin (splice()) or another
+     * QFile (copy_file_range()), falling back to sendfile() where these are
+     * not supported. This saves a copy through user space per byte when
+     * feeding image files to the writing programs. Subclasses always get the
+     * data through readData() and writeData() since they may process it.
      */
     class LIBK3B_EXPORT ActivePipe : public QIODevice
     {
@@ -0,0 +1,420 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bburntelemetry.h"
+#include "k3bjob.h"
+
+#include <QDataStream>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QPointer>
+#include <QStringList>
+#include <QTimer>
+
+#ifndef Q_OS_LINUX
+#include <sys/resource.h>
+#endif
+
+
+namespace {
+    const quint32 s_telemetryMagic = 0x4b334254; // K3BT
+    const quint16 s_telemetryVersion = 1;
+
+    const int s_sampleInterval = 500; // msecs
+
+    // the writer fifo and the drive buffer are considered low below this level
+    const int s_lowLevel = 20;
+
+    const char* const s_columnNames[] = {
+        "source",
+        "prefetch",
+        "fifo",
+        "device",
+        "speed",
+        "cpu"
+    };
+}
+
+
+class K3b::BurnTelemetry::Private
+{
+public:
+    Private()
+        : speedMultiplicator( K3b::Device::SPEED_FACTOR_CD ),
+          lastCpuBusy( 0 ),
+          lastCpuTotal( 0 ) {
+    }
+
+    void resetValues() {
+        for( int i = 0; i < NumColumns; ++i )
+            current[i] = -1;
+    }
+
+    // the CPU usage since the last call in percent
+    int cpuUsage();
+
+    QPointer<K3b::BurnJob> job;
+    QString description;
+    int speedMultiplicator;
+
+    QVector<Sample> samples;
+    qint32 current[NumColumns];
+
+    QTimer sampleTimer;
+    QElapsedTimer clock;
+
+    quint64 lastCpuBusy;
+    quint64 lastCpuTotal;
+};
+
+
+int K3b::BurnTelemetry::Private::cpuUsage()
+{
+    quint64 busy = 0;
+    quint64 total = 0;
+
+#ifdef Q_OS_LINUX
+    //
+    // The external programs doing most of the work are not our children in
+    // terms of getrusage() until they exited. Thus we use the load of the
+    // whole system: cpu user nice system idle iowait irq softirq steal
+    //
+    QFile f( "/proc/stat" );
+    if( !f.open( QIODevice::ReadOnly ) )
+        return -1;
+    const QStringList fields = QString::fromLatin1( f.readLine() ).simplified().split( ' ' );
+    if( fields.count() < 5 || fields[0] != QLatin1String( "cpu" ) )
+        return -1;
+    for( int i = 1; i < fields.count() && i <= 8; ++i ) {
+        const quint64 v = fields[i].toULongLong();
+        total += v;
+        if( i != 4 && i != 5 )
+            busy += v;
+    }
+#else
+    // on other systems only our own usage is known
+    struct rusage ru;
+    if( ::getrusage( RUSAGE_SELF, &ru ) )
+        return -1;
+    busy = quint64( ru.ru_utime.tv_sec + ru.ru_stime.tv_sec ) * 1000000ULL
+           + ru.ru_utime.tv_usec + ru.ru_stime.tv_usec;
+    total = quint64( clock.nsecsElapsed() / 1000 );
+#endif
+
+    int usage = -1;
+    if( lastCpuTotal > 0 && total > lastCpuTotal )
+        usage = qBound( 0, int( 100 * ( busy - lastCpuBusy ) / ( total - lastCpuTotal ) ), 100 );
+
+    lastCpuBusy = busy;
+    lastCpuTotal = total;
+
+    return usage;
+}
+
+
+K3b::BurnTelemetry::Statistics::Statistics()
+    : count( 0 ),
+      min( 0 ),
+      max( 0 ),
+      average( 0.0 )
+{
+}
+
+
+K3b::BurnTelemetry::BurnTelemetry( QObject* parent )
+    : QObject( parent ),
+      d( new Private() )
+{
+    d->resetValues();
+    d->sampleTimer.setInterval( s_sampleInterval );
+    connect( &d->sampleTimer, SIGNAL(timeout()), this, SLOT(slotSample()) );
+}
+
+
+K3b::BurnTelemetry::~BurnTelemetry()
+{
+    delete d;
+}
+
+
+void K3b::BurnTelemetry::setJob( K3b::BurnJob* job )
+{
+    if( d->job )
+        d->job->disconnect( this );
+
+    d->sampleTimer.stop();
+    clear();
+
+    d->job = job;
+    if( job ) {
+        d->description = job->jobDescription();
+        connect( job, SIGNAL(started()), this, SLOT(slotStarted()) );
+        connect( job, SIGNAL(finished(bool)), this, SLOT(slotFinished()) );
+        connect( job, SIGNAL(sourceThroughput(int)), this, SLOT(slotSourceThroughput(int)) );
+        connect( job, SIGNAL(prefetchBuffer(int)), this, SLOT(slotPrefetchBuffer(int)) );
+        connect( job, SIGNAL(bufferStatus(int)), this, SLOT(slotBufferStatus(int)) );
+        connect( job, SIGNAL(deviceBuffer(int)), this, SLOT(slotDeviceBuffer(int)) );
+        connect( job, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)),
+                 this, SLOT(slotWriteSpeed(int,K3b::Device::SpeedMultiplicator)) );
+    }
+}
+
+
+QString K3b::BurnTelemetry::description() const
+{
+    return d->description;
+}
+
+
+int K3b::BurnTelemetry::speedMultiplicator() const
+{
+    return d->speedMultiplicator;
+}
+
+
+QVector<K3b::BurnTelemetry::Sample> K3b::BurnTelemetry::samples() const
+{
+    return d->samples;
+}
+
+
+void K3b::BurnTelemetry::clear()
+{
+    d->samples.clear();
+    d->resetValues();
+}
+
+
+K3b::BurnTelemetry::Statistics K3b::BurnTelemetry::statistics( Column column ) const
+{
+    Statistics s;
+    qint64 sum = 0;
+    Q_FOREACH( const Sample& sample, d->samples ) {
+        const int v = sample.values[column];
+        if( v < 0 )
+            continue;
+        if( s.count == 0 || v < s.min )
+            s.min = v;
+        if( s.count == 0 || v > s.max )
+            s.max = v;
+        sum += v;
+        ++s.count;
+    }
+    if( s.count > 0 )
+        s.average = double( sum ) / double( s.count );
+    return s;
+}
+
+
+quint32 K3b::BurnTelemetry::timeBelow( Column column, int level ) const
+{
+    quint32 time = 0;
+    for( int i = 1; i < d->samples.count(); ++i ) {
+        const int v = d->samples[i].values[column];
+        if( v >= 0 && v < level )
+            time += d->samples[i].time - d->samples[i-1].time;
+    }
+    return time;
+}
+
+
+QString K3b::BurnTelemetry::summary() const
+{
+    QStringList lines;
+
+    const quint32 duration = d->samples.isEmpty() ? 0 : d->samples.last().time;
+    lines << QString( "%1, %2 samples over %3 seconds" )
+        .arg( d->description )
+        .arg( d->samples.count() )
+        .arg( duration / 1000 );
+
+    lines << QString( "%1 %2 %3 %4 %5" )
+        .arg( QString(), -10 )
+        .arg( "min", 8 )
+        .arg( "avg", 8 )
+        .arg( "max", 8 )
+        .arg( "low (s)", 8 );
+
+    for( int i = 0; i < NumColumns; ++i ) {
+        const Column c = Column( i );
+        const Statistics s = statistics( c );
+        if( s.count == 0 )
+            continue;
+
+        const bool level = ( c == PrefetchBuffer || c == WriterBuffer || c == DeviceBuffer );
+        lines << QString( "%1 %2 %3 %4 %5" )
+            .arg( columnName( c ), -10 )
+            .arg( s.min, 8 )
+            .arg( s.average, 8, 'f', 1 )
+            .arg( s.max, 8 )
+            .arg( level ? QString::number( timeBelow( c, s_lowLevel ) / 1000 ) : QString( "-" ), 8 );
+    }
+
+    const Statistics speed = statistics( WriteSpeed );
+    if( speed.count > 0 && d->speedMultiplicator > 0 )
+        lines << QString( "Average write speed: %1x" )
+            .arg( speed.average / double( d->speedMultiplicator ), 0, 'f', 2 );
+
+    return lines.join( "\n" );
+}
+
+
+QString K3b::BurnTelemetry::toCsv() const
+{
+    QStringList lines;
+
+    QStringList header;
+    header << "time";
+    for( int i = 0; i < NumColumns; ++i )
+        header << columnName( Column( i ) );
+    lines << header.join( ',' );
+
+    Q_FOREACH( const Sample& sample, d->samples ) {
+        QString line = QString::number( sample.time );
+        for( int i = 0; i < NumColumns; ++i ) {
+            line += ',';
+            if( sample.values[i] >= 0 )
+                line += QString::number( sample.values[i] );
+        }
+        lines << line;
+    }
+
+    return lines.join( "\n" );
+}
+
+
+bool K3b::BurnTelemetry::save( QIODevice* dev ) const
+{
+    QDataStream s( dev );
+    s.setVersion( QDataStream::Qt_5_15 );
+    s << s_telemetryMagic << s_telemetryVersion
+      << d->description << qint32( d->speedMultiplicator )
+      << quint8( NumColumns ) << quint32( d->samples.count() );
+    Q_FOREACH( const Sample& sample, d->samples ) {
+        s << sample.time;
+        for( int i = 0; i < NumColumns; ++i )
+            s << sample.values[i];
+    }
+
+    return s.status() == QDataStream::Ok;
+}
+
+
+bool K3b::BurnTelemetry::load( QIODevice* dev )
+{
+    QDataStream s( dev );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    QString description;
+    qint32 multiplicator = 0;
+    quint8 columns = 0;
+    quint32 count = 0;
+    s >> magic >> version >> description >> multiplicator >> columns >> count;
+    if( s.status() != QDataStream::Ok || magic != s_telemetryMagic || version != s_telemetryVersion )
+        return false;
+
+    QVector<Sample> samples;
+    for( quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i ) {
+        Sample sample;
+        s >> sample.time;
+
+        // newer versions may record more columns
+        for( int c = 0; c < columns; ++c ) {
+            qint32 v;
+            s >> v;
+            if( c < NumColumns )
+                sample.values[c] = v;
+        }
+        for( int c = columns; c < NumColumns; ++c )
+            sample.values[c] = -1;
+
+        samples.append( sample );
+    }
+
+    if( s.status() != QDataStream::Ok )
+        return false;
+
+    d->description = description;
+    d->speedMultiplicator = multiplicator;
+    d->samples = samples;
+
+    return true;
+}
+
+
+QString K3b::BurnTelemetry::columnName( Column column )
+{
+    if( column >= 0 && column < NumColumns )
+        return QString::fromLatin1( s_columnNames[column] );
+    return QString();
+}
+
+
+void K3b::BurnTelemetry::slotStarted()
+{
+    clear();
+    d->clock.start();
+    d->lastCpuBusy = d->lastCpuTotal = 0;
+    d->cpuUsage();
+    d->sampleTimer.start();
+}
+
+
+void K3b::BurnTelemetry::slotFinished()
+{
+    if( d->sampleTimer.isActive() ) {
+        slotSample();
+        d->sampleTimer.stop();
+    }
+    qDebug() << "(K3b::BurnTelemetry) recorded" << d->samples.count() << "samples.";
+}
+
+
+void K3b::BurnTelemetry::slotSample()
+{
+    Sample sample;
+    sample.time = quint32( d->clock.elapsed() );
+    d->current[CpuUsage] = d->cpuUsage();
+    for( int i = 0; i < NumColumns; ++i )
+        sample.values[i] = d->current[i];
+    d->samples.append( sample );
+}
+
+
+void K3b::BurnTelemetry::slotSourceThroughput( int kbs )
+{
+    d->current[SourceRate] = kbs;
+}
+
+
+void K3b::BurnTelemetry::slotPrefetchBuffer( int level )
+{
+    d->current[PrefetchBuffer] = level;
+}
+
+
+void K3b::BurnTelemetry::slotBufferStatus( int level )
+{
+    d->current[WriterBuffer] = level;
+}
+
+
+void K3b::BurnTelemetry::slotDeviceBuffer( int level )
+{
+    d->current[DeviceBuffer] = level;
+}
+
+
+void K3b::BurnTelemetry::slotWriteSpeed( int kbs, K3b::Device::SpeedMultiplicator multiplicator )
+{
+    d->current[WriteSpeed] = kbs;
+    d->speedMultiplicator = multiplicator;
+}
+
+#include "moc_k3bburntelemetry.cpp"
@@ -0,0 +1,133 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_BURN_TELEMETRY_H_
+#define _K3B_BURN_TELEMETRY_H_
+
+#include "k3b_export.h"
+#include "k3bdevicetypes.h"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+
+namespace K3b {
+    class BurnJob;
+
+    /**
+     * The BurnTelemetry records the state of a BurnJob twice a second:
+     * the rate at which the source delivers its data, the fill levels of
+     * the prefetch buffer, the writer fifo and the drive buffer, the writing
+     * speed, and the CPU usage of the system.
+     *
+     * The samples can be exported as CSV or saved in a compact binary format
+     * which is read by load(). The k3btelemetry tool summarizes and compares
+     * saved logs.
+     */
+    class LIBK3B_EXPORT BurnTelemetry : public QObject
+    {
+        Q_OBJECT
+
+    public:
+        enum Column {
+            SourceRate,        /**< KB/s */
+            PrefetchBuffer,    /**< percent */
+            WriterBuffer,      /**< percent */
+            DeviceBuffer,      /**< percent */
+            WriteSpeed,        /**< KB/s */
+            CpuUsage,          /**< percent */
+            NumColumns
+        };
+
+        /**
+         * Values which have not been reported (yet) are -1.
+         */
+        struct Sample {
+            quint32 time;      /**< msecs since the job started */
+            qint32 values[NumColumns];
+        };
+
+        struct Statistics {
+            Statistics();
+
+            int count;         /**< the number of samples which have a value */
+            int min;
+            int max;
+            double average;
+        };
+
+        explicit BurnTelemetry( QObject* parent = 0 );
+        ~BurnTelemetry() override;
+
+        /**
+         * Record the given job. Recording starts once the job has been
+         * started and stops when it finished. Previous samples are dropped.
+         */
+        void setJob( BurnJob* job );
+
+        QString description() const;
+
+        /**
+         * Used to display the writing speed as a factor.
+         */
+        int speedMultiplicator() const;
+
+        QVector<Sample> samples() const;
+        void clear();
+
+        /**
+         * \return The statistics of @p column over all samples.
+         */
+        Statistics statistics( Column column ) const;
+
+        /**
+         * \return The time in msecs during which the value of @p column was
+         *         below @p level.
+         */
+        quint32 timeBelow( Column column, int level ) const;
+
+        /**
+         * \return A short human readable summary of the recorded samples.
+         */
+        QString summary() const;
+
+        /**
+         * \return All samples as comma separated values with a header line.
+         */
+        QString toCsv() const;
+
+        /**
+         * Write the samples to @p dev in the binary telemetry format.
+         */
+        bool save( QIODevice* dev ) const;
+
+        /**
+         * Replace the samples with the ones written by save().
+         */
+        bool load( QIODevice* dev );
+
+        static QString columnName( Column column );
+
+    private Q_SLOTS:
+        void slotStarted();
+        void slotFinished();
+        void slotSample();
+        void slotSourceThroughput( int );
+        void slotPrefetchBuffer( int );
+        void slotBufferStatus( int );
+        void slotDeviceBuffer( int );
+        void slotWriteSpeed( int, K3b::Device::SpeedMultiplicator );
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -17,7 +17,8 @@ class K3b::ChecksumPipe::Private
 {
 public:
     Private()
-		: checksumType(MD5), md5(QCryptographicHash::Md5) {
+		: checksumType(MD5), md5(QCryptographicHash::Md5),
+          extentSize(0), extentFill(0), extentMd5(QCryptographicHash::Md5) {
     }
 
     void update( const char* in, qint64 len ) {
@@ -26,6 +27,19 @@ public:
 			md5.addData( in, len );
             break;
         }
+
+        while( extentSize > 0 && len > 0 ) {
+            const qint64 l = qMin( len, extentSize - extentFill );
+            extentMd5.addData( in, l );
+            extentFill += l;
+            in += l;
+            len -= l;
+            if( extentFill == extentSize ) {
+                extentChecksums.append( extentMd5.result().toHex() );
+                extentMd5.reset();
+                extentFill = 0;
+            }
+        }
     }
 
     void reset() {
@@ -34,11 +48,20 @@ public:
             md5.reset();
             break;
         }
+
+        extentChecksums.clear();
+        extentMd5.reset();
+        extentFill = 0;
     }
 
     int checksumType;
 
 	QCryptographicHash md5;
+
+    qint64 extentSize;
+    qint64 extentFill;
+    QCryptographicHash extentMd5;
+    QList<QByteArray> extentChecksums;
 };
 
 
@@ -80,6 +103,27 @@ QByteArray K3b::ChecksumPipe::checksum() const
 }
 
 
+void K3b::ChecksumPipe::setExtentSize( qint64 size )
+{
+    d->extentSize = size;
+}
+
+
+qint64 K3b::ChecksumPipe::extentSize() const
+{
+    return d->extentSize;
+}
+
+
+QList<QByteArray> K3b::ChecksumPipe::extentChecksums() const
+{
+    QList<QByteArray> checksums = d->extentChecksums;
+    if( d->extentFill > 0 )
+        checksums.append( d->extentMd5.result().toHex() );
+    return checksums;
+}
+
+
 qint64 K3b::ChecksumPipe::writeData( const char* data, qint64 max )
 {
     d->update( data, max );
@@ -12,6 +12,8 @@
 
 #include "k3b_export.h"
 
+#include <QList>
+
 
 namespace K3b {
     /**
@@ -50,6 +52,22 @@ namespace K3b {
          */
         QByteArray checksum() const;
 
+        /**
+         * Additionally calculate a checksum for every @p size bytes of the
+         * data. This allows to verify parts of the data and to locate
+         * differences. Needs to be set before opening the pipe.
+         *
+         * Default is 0 which disables the extent checksums.
+         */
+        void setExtentSize( qint64 size );
+        qint64 extentSize() const;
+
+        /**
+         * Get the checksums of the extents. The last one covers the
+         * remaining data which may be less than the extent size.
+         */
+        QList<QByteArray> extentChecksums() const;
+
     protected:
         qint64 writeData( const char* data, qint64 max ) override;
 
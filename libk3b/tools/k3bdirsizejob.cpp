@@ -12,20 +12,425 @@
 
 #include <QDebug>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPair>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#endif
+
+
+namespace {
+    struct DirTotals
+    {
+        DirTotals()
+            : size(0),
+              files(0),
+              dirs(0),
+              symlinks(0) {
+        }
+
+        DirTotals& operator+=( const DirTotals& other ) {
+            size += other.size;
+            files += other.files;
+            dirs += other.dirs;
+            symlinks += other.symlinks;
+            return *this;
+        }
+
+        KIO::filesize_t size;
+        KIO::filesize_t files;
+        KIO::filesize_t dirs;
+        KIO::filesize_t symlinks;
+    };
+
+    // device and inode
+    typedef QPair<quint64, quint64> DirKey;
+
+    DirKey dirKey( const k3b_struct_stat& s )
+    {
+        return DirKey( s.st_dev, s.st_ino );
+    }
+
+
+    //
+    // The process-wide cache of folder totals. An entry is valid as long as the
+    // modification time of the folder did not change and inotify did not report
+    // any change in the folder or one of its subfolders.
+    // Folders which cannot be watched are never cached (and neither are their parents).
+    // Only cached folders and those being counted keep their watch.
+    //
+    // Each folder has a generation which is increased whenever the folder or one of
+    // its cached subfolders is invalidated. A folder is only inserted if its generation
+    // did not change while it was counted. Otherwise its totals might include the
+    // stale total of a subfolder.
+    //
+    class DirSizeCache
+    {
+    public:
+        struct Watch
+        {
+            Watch()
+                : wd(-1),
+                  generation(0),
+                  keyGeneration(0) {
+            }
+
+            int wd;
+            quint64 generation;
+            quint64 keyGeneration;
+        };
+
+        DirSizeCache();
+        ~DirSizeCache();
+
+        /**
+         * Start watching a folder. This needs to be done before reading the folder
+         * to make sure that no change is lost.
+         */
+        Watch watch( const QByteArray& path, const DirKey& key );
+
+        bool find( const k3b_struct_stat& s, const DirKey* parent, DirTotals& totals );
+
+        /**
+         * \return false if the totals could not be cached since something
+         *         changed while counting. In that case the parent folders
+         *         must not be cached either.
+         */
+        bool insert( const k3b_struct_stat& s, const DirKey* parent, const Watch& watch, const DirTotals& totals );
+
+        /**
+         * Stop watching a folder which has not been cached.
+         */
+        void release( const Watch& watch );
+
+    private:
+        struct Entry
+        {
+            qint64 mtime;
+            qint64 ctime;
+            DirKey parent;
+            bool hasParent;
+            int wd;
+            quint64 lastUsed;
+            DirTotals totals;
+        };
+
+        void processEvents();
+        void invalidate( DirKey key );
+        void removeWatch( int wd );
+        bool usesWatch( const DirKey& key, int wd ) const;
+        void touch( QHash<DirKey, Entry>::iterator it );
+        void evictLeastRecentlyUsed();
+        void clear();
+
+        QMutex m_mutex;
+        int m_inotifyFd;
+        int m_maxWatches;
+        QHash<DirKey, Entry> m_entries;
+        QHash<int, DirKey> m_watchedDirs;
+        QHash<int, quint64> m_generations;
+        QHash<DirKey, quint64> m_keyGenerations;
+
+        // Entry::lastUsed -> key
+        QMap<quint64, DirKey> m_lru;
+        quint64 m_clock;
+    };
+
+    // bound the memory used by the cache
+    const int s_maxCacheEntries = 50000;
+
+    // the share of the user's inotify watches we use at most
+    const int s_inotifyWatchShare = 8;
+
+    Q_GLOBAL_STATIC( DirSizeCache, s_dirSizeCache )
+
+
+    DirSizeCache::DirSizeCache()
+        : m_inotifyFd( -1 ),
+          m_maxWatches( 0 ),
+          m_clock( 0 )
+    {
+#ifdef Q_OS_LINUX
+        m_inotifyFd = ::inotify_init1( IN_NONBLOCK|IN_CLOEXEC );
+        if( m_inotifyFd < 0 )
+            qDebug() << "(K3b::DirSizeJob) unable to initialize inotify. Folder sizes will not be cached.";
+
+        // the watches are shared with all other applications of the user
+        int maxUserWatches = 8192;
+        QFile f( QLatin1String( "/proc/sys/fs/inotify/max_user_watches" ) );
+        if( f.open( QIODevice::ReadOnly ) ) {
+            bool ok = false;
+            const int i = f.readAll().trimmed().toInt( &ok );
+            if( ok && i > 0 )
+                maxUserWatches = i;
+        }
+        m_maxWatches = qMin( maxUserWatches / s_inotifyWatchShare, s_maxCacheEntries );
+#endif
+    }
+
+
+    DirSizeCache::~DirSizeCache()
+    {
+        if( m_inotifyFd >= 0 )
+            ::close( m_inotifyFd );
+    }
+
+
+    DirSizeCache::Watch DirSizeCache::watch( const QByteArray& path, const DirKey& key )
+    {
+        Watch w;
+#ifdef Q_OS_LINUX
+        QMutexLocker locker( &m_mutex );
+        if( m_inotifyFd < 0 )
+            return w;
+
+        processEvents();
+
+        // make room by dropping the least recently used folders
+        while( m_watchedDirs.count() >= m_maxWatches && !m_lru.isEmpty() )
+            evictLeastRecentlyUsed();
+        if( m_watchedDirs.count() >= m_maxWatches )
+            return w;
+
+        w.wd = ::inotify_add_watch( m_inotifyFd, path.constData(),
+                                    IN_MODIFY|IN_CREATE|IN_DELETE|IN_MOVE|IN_DELETE_SELF|IN_MOVE_SELF|IN_ONLYDIR );
+        if( w.wd >= 0 ) {
+            m_watchedDirs.insert( w.wd, key );
+            w.generation = m_generations.value( w.wd, 0 );
+            w.keyGeneration = m_keyGenerations.value( key, 0 );
+        }
+#else
+        Q_UNUSED( path );
+        Q_UNUSED( key );
+#endif
+        return w;
+    }
+
+
+    bool DirSizeCache::find( const k3b_struct_stat& s, const DirKey* parent, DirTotals& totals )
+    {
+        QMutexLocker locker( &m_mutex );
+        if( m_inotifyFd < 0 )
+            return false;
+
+        processEvents();
+
+        QHash<DirKey, Entry>::iterator it = m_entries.find( dirKey( s ) );
+        if( it == m_entries.end() )
+            return false;
+
+        if( it->mtime != qint64( s.st_mtime ) || it->ctime != qint64( s.st_ctime ) ) {
+            invalidate( it.key() );
+            return false;
+        }
+
+        // the folder might have been cached as a top level folder before
+        if( parent ) {
+            it->parent = *parent;
+            it->hasParent = true;
+        }
+
+        touch( it );
+        totals = it->totals;
+        return true;
+    }
+
+
+    bool DirSizeCache::insert( const k3b_struct_stat& s, const DirKey* parent, const Watch& watch, const DirTotals& totals )
+    {
+        QMutexLocker locker( &m_mutex );
+
+        processEvents();
+
+        // something changed in the folder or one of its subfolders while we were counting
+        const DirKey key = dirKey( s );
+        if( watch.wd < 0 ||
+            !m_watchedDirs.contains( watch.wd ) ||
+            m_generations.value( watch.wd, 0 ) != watch.generation ||
+            m_keyGenerations.value( key, 0 ) != watch.keyGeneration ) {
+            if( !usesWatch( key, watch.wd ) )
+                removeWatch( watch.wd );
+            return false;
+        }
+
+        while( m_entries.count() >= s_maxCacheEntries && !m_lru.isEmpty() )
+            evictLeastRecentlyUsed();
+
+        Entry e;
+        e.mtime = s.st_mtime;
+        e.ctime = s.st_ctime;
+        e.hasParent = ( parent != 0 );
+        if( parent )
+            e.parent = *parent;
+        e.wd = watch.wd;
+        e.lastUsed = 0;
+        e.totals = totals;
+        touch( m_entries.insert( key, e ) );
+        return true;
+    }
+
+
+    void DirSizeCache::release( const Watch& watch )
+    {
+        QMutexLocker locker( &m_mutex );
+
+        // the folder might have been cached by another job using the same watch
+        QHash<int, DirKey>::const_iterator it = m_watchedDirs.constFind( watch.wd );
+        if( it != m_watchedDirs.constEnd() && !usesWatch( it.value(), watch.wd ) )
+            removeWatch( watch.wd );
+    }
+
+
+    void DirSizeCache::processEvents()
+    {
+#ifdef Q_OS_LINUX
+        alignas( struct inotify_event ) char buf[4096];
+        ssize_t len = 0;
+        while( ( len = ::read( m_inotifyFd, buf, sizeof( buf ) ) ) > 0 ) {
+            for( char* p = buf; p < buf + len; ) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>( p );
+                p += sizeof( struct inotify_event ) + event->len;
+
+                if( event->mask & IN_Q_OVERFLOW ) {
+                    // we lost events. No way to know what changed.
+                    clear();
+                }
+                else {
+                    QHash<int, DirKey>::const_iterator it = m_watchedDirs.constFind( event->wd );
+                    if( it != m_watchedDirs.constEnd() ) {
+                        ++m_generations[event->wd];
+                        invalidate( it.value() );
+                        if( event->mask & IN_IGNORED ) {
+                            m_watchedDirs.remove( event->wd );
+                            m_generations.remove( event->wd );
+                        }
+                    }
+                }
+            }
+        }
+#endif
+    }
+
+
+    void DirSizeCache::invalidate( DirKey key )
+    {
+        //
+        // The totals of all parent folders include the changed folder. The generation
+        // of the first parent which is not cached (yet) is increased as well since it
+        // might be in the middle of being counted.
+        //
+        QHash<DirKey, Entry>::iterator it;
+        while( true ) {
+            ++m_keyGenerations[key];
+            it = m_entries.find( key );
+            if( it == m_entries.end() )
+                break;
+
+            const bool hasParent = it->hasParent;
+            key = it->parent;
+            removeWatch( it->wd );
+            m_lru.remove( it->lastUsed );
+            m_entries.erase( it );
+            if( !hasParent )
+                break;
+        }
+    }
+
+
+    void DirSizeCache::touch( QHash<DirKey, Entry>::iterator it )
+    {
+        m_lru.remove( it->lastUsed );
+        it->lastUsed = ++m_clock;
+        m_lru.insert( it->lastUsed, it.key() );
+    }
+
+
+    void DirSizeCache::removeWatch( int wd )
+    {
+#ifdef Q_OS_LINUX
+        if( wd >= 0 && m_watchedDirs.remove( wd ) ) {
+            ::inotify_rm_watch( m_inotifyFd, wd );
+            m_generations.remove( wd );
+        }
+#else
+        Q_UNUSED( wd );
+#endif
+    }
+
+
+    bool DirSizeCache::usesWatch( const DirKey& key, int wd ) const
+    {
+        QHash<DirKey, Entry>::const_iterator it = m_entries.constFind( key );
+        return( it != m_entries.constEnd() && it->wd == wd );
+    }
+
+
+    void DirSizeCache::evictLeastRecentlyUsed()
+    {
+        // without the watch changes would go unnoticed, thus the parents need to go as well
+        invalidate( m_lru.first() );
+    }
+
+
+    void DirSizeCache::clear()
+    {
+#ifdef Q_OS_LINUX
+        for( QHash<int, DirKey>::const_iterator it = m_watchedDirs.constBegin();
+             it != m_watchedDirs.constEnd(); ++it )
+            ::inotify_rm_watch( m_inotifyFd, it.key() );
+#endif
+        m_entries.clear();
+        m_watchedDirs.clear();
+        m_generations.clear();
+        m_keyGenerations.clear();
+        m_lru.clear();
+    }
+
+
+    bool isDotOrDotDot( const char* name )
+    {
+        return ( name[0] == '.' && ( name[1] == '\0' || ( name[1] == '.' && name[2] == '\0' ) ) );
+    }
+}
 
 
 class K3b::DirSizeJob::Private
 {
 public:
-    Private()
-        : followSymlinks(false),
+    Private( K3b::DirSizeJob* job )
+        : q(job),
+          followSymlinks(false),
           totalSize(0),
           totalFiles(0),
           totalDirs(0),
           totalSymlinks(0) {
+        pool.setMaxThreadCount( QThread::idealThreadCount() );
     }
 
+    /**
+     * Count the contents of folder \p path, all subfolders included.
+     * If \p parallel is true the subfolders are counted on a thread pool.
+     */
+    bool countDir( const QByteArray& path, const k3b_struct_stat& dirStat, const DirKey* parent,
+                   DirTotals& totals, bool& cacheable, bool parallel );
+
+    K3b::DirSizeJob* q;
+
     QList<QUrl> urls;
     bool followSymlinks;
 
@@ -33,13 +438,149 @@ public:
     KIO::filesize_t totalFiles;
     KIO::filesize_t totalDirs;
     KIO::filesize_t totalSymlinks;
+
+    // only the top level folders are counted in parallel, thus one pool is enough
+    QThreadPool pool;
 };
 
 
+bool K3b::DirSizeJob::Private::countDir( const QByteArray& path, const k3b_struct_stat& dirStat, const DirKey* parent,
+                                         DirTotals& totals, bool& cacheable, bool parallel )
+{
+    totals = DirTotals();
+
+    // following symlinks might lead us into folders we do not watch
+    const bool useCache = !followSymlinks;
+    cacheable = false;
+
+    if( useCache && s_dirSizeCache()->find( dirStat, parent, totals ) ) {
+        cacheable = true;
+        return true;
+    }
+
+    const DirKey key = dirKey( dirStat );
+    DirSizeCache::Watch watch;
+    if( useCache ) {
+        watch = s_dirSizeCache()->watch( path, key );
+        cacheable = ( watch.wd >= 0 );
+    }
+
+    // unreadable folders are counted as empty like QDir::entryList() does
+    DIR* dir = ::opendir( path.constData() );
+    if( !dir ) {
+        qDebug() << "(K3b::DirSizeJob) unable to read" << path << ::strerror( errno );
+        if( cacheable )
+            s_dirSizeCache()->release( watch );
+        cacheable = false;
+        return true;
+    }
+
+    //
+    // We only remember the subfolders and count them after closing this folder. That way we
+    // never have more than one folder open per thread.
+    //
+    QVector<QByteArray> subDirs;
+    QVector<k3b_struct_stat> subDirStats;
+
+    bool success = true;
+    while( struct dirent* entry = ::readdir( dir ) ) {
+        if( q->canceled() ) {
+            success = false;
+            break;
+        }
+
+        if( isDotOrDotDot( entry->d_name ) )
+            continue;
+
+        k3b_struct_stat s;
+        if( k3b_fstatat( ::dirfd( dir ), entry->d_name, &s, AT_SYMLINK_NOFOLLOW ) ) {
+            success = false;
+            break;
+        }
+
+        if( S_ISLNK( s.st_mode ) ) {
+            ++totals.symlinks;
+            if( followSymlinks ) {
+                if( k3b_fstatat( ::dirfd( dir ), entry->d_name, &s, 0 ) ) {
+                    success = false;
+                    break;
+                }
+            }
+        }
+
+        if( S_ISDIR( s.st_mode ) ) {
+            ++totals.dirs;
+            QByteArray subDir( path );
+            if( !subDir.endsWith( '/' ) )
+                subDir += '/';
+            subDir += entry->d_name;
+            subDirs.append( subDir );
+            subDirStats.append( s );
+        }
+        else if( !S_ISLNK( s.st_mode ) ) {
+            ++totals.files;
+            totals.size += (KIO::filesize_t)s.st_size;
+        }
+    }
+
+    ::closedir( dir );
+
+    if( !success ) {
+        if( cacheable )
+            s_dirSizeCache()->release( watch );
+        return false;
+    }
+
+    QVector<DirTotals> subDirTotals( subDirs.count() );
+    QVector<char> subDirResults( subDirs.count(), 0 );
+    QVector<char> subDirCacheable( subDirs.count(), 0 );
+
+    if( parallel && subDirs.count() > 1 ) {
+        for( int i = 0; i < subDirs.count(); ++i ) {
+            pool.start( [&, i]() {
+                bool c = false;
+                subDirResults[i] = countDir( subDirs[i], subDirStats[i], &key, subDirTotals[i], c, false );
+                subDirCacheable[i] = c;
+            } );
+        }
+        pool.waitForDone();
+    }
+    else {
+        for( int i = 0; i < subDirs.count(); ++i ) {
+            bool c = false;
+            subDirResults[i] = countDir( subDirs[i], subDirStats[i], &key, subDirTotals[i], c, false );
+            subDirCacheable[i] = c;
+            if( !subDirResults[i] )
+                break;
+        }
+    }
+
+    bool subDirsCacheable = true;
+    for( int i = 0; i < subDirs.count(); ++i ) {
+        if( !subDirResults[i] ) {
+            if( cacheable )
+                s_dirSizeCache()->release( watch );
+            return false;
+        }
+        totals += subDirTotals[i];
+        subDirsCacheable = subDirsCacheable && subDirCacheable[i];
+    }
+
+    if( cacheable && !subDirsCacheable ) {
+        s_dirSizeCache()->release( watch );
+        cacheable = false;
+    }
+    else if( cacheable ) {
+        cacheable = s_dirSizeCache()->insert( dirStat, parent, watch, totals );
+    }
+
+    return true;
+}
+
 
 K3b::DirSizeJob::DirSizeJob( QObject* parent )
     : K3b::ThreadJob( new K3b::SimpleJobHandler(), parent ),
-      d( new Private() )
+      d( new Private( this ) )
 {
 }
 
@@ -93,7 +634,7 @@ bool K3b::DirSizeJob::run()
     d->totalDirs = 0;
     d->totalSymlinks = 0;
 
-    QStringList l;
+    QList<QByteArray> l;
     for( QList<QUrl>::const_iterator it = d->urls.constBegin();
          it != d->urls.constEnd(); ++it ) {
         const QUrl& url = *it;
@@ -103,44 +644,39 @@ bool K3b::DirSizeJob::run()
             return false;
         }
 
-        l.append( url.toLocalFile() );
+        l.append( QFile::encodeName( url.toLocalFile() ) );
     }
 
-    return countFiles( l, QString() );
-}
-
-
-bool K3b::DirSizeJob::countDir( const QString& dir )
-{
-    QStringList l = QDir(dir).entryList( QDir::AllEntries|QDir::Hidden|QDir::System|QDir::NoDotAndDotDot );
-    return countFiles( l, dir );
-}
-
-
-bool K3b::DirSizeJob::countFiles( const QStringList& l, const QString& dir )
-{
-    for( QStringList::const_iterator it = l.begin();
-         it != l.end(); ++it ) {
+    for( QList<QByteArray>::const_iterator it = l.constBegin();
+         it != l.constEnd(); ++it ) {
 
         if( canceled() )
             return false;
 
         k3b_struct_stat s;
-        if( k3b_lstat( QFile::encodeName( dir + *it ), &s ) )
+        if( k3b_lstat( it->constData(), &s ) )
             return false;
 
         if( S_ISLNK( s.st_mode ) ) {
             ++d->totalSymlinks;
             if( d->followSymlinks ) {
-                if( k3b_stat( QFile::encodeName( dir + *it ), &s ) )
+                if( k3b_stat( it->constData(), &s ) )
                     return false;
             }
         }
 
         if( S_ISDIR( s.st_mode ) ) {
             ++d->totalDirs;
-            if( !countDir( dir + *it + '/' ) )
+
+            DirTotals totals;
+            bool cacheable = false;
+            if( !d->countDir( *it, s, 0, totals, cacheable, true ) )
                 return false;
+
+            d->totalSize += totals.size;
+            d->totalFiles += totals.files;
+            d->totalDirs += totals.dirs;
+            d->totalSymlinks += totals.symlinks;
         }
         else if( !S_ISLNK( s.st_mode ) ) {
             ++d->totalFiles;
@@ -151,4 +687,5 @@ bool K3b::DirSizeJob::countFiles( const QStringList& l, const QString& dir )
     return true;
 }
 
+
 #include "moc_k3bdirsizejob.cpp"
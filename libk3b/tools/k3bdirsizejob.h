@@ -16,7 +16,13 @@ namespace K3b {
     /**
      * DirSizeJob is a replacement for KDirSize which allows
      * a much finer grained control over what is counted and how.
-     * Additionally it uses threading for enhanced speed.
+     * Additionally it uses threading for enhanced speed: the folders
+     * are counted in parallel on a thread pool.
+     *
+     * The totals of counted folders are cached process-wide (keyed by
+     * device, inode, and modification time) and invalidated through
+     * inotify. Thus, counting an unchanged tree again is almost free.
+     * The cache is not used when following symlinks.
      *
      * For now DirSizeJob only works on local urls.
      */
@@ -53,8 +59,6 @@ namespace K3b {
 
     private:
         bool run() override;
-        bool countDir( const QString& dir );
-        bool countFiles( const QStringList& l, const QString& dir );
 
         class Private;
         Private* const d;
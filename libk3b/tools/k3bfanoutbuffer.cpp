@@ -0,0 +1,377 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bfanoutbuffer.h"
+
+#include <QAtomicInt>
+#include <QDebug>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QWaitCondition>
+
+#include <string.h>
+
+
+namespace {
+    // the amount of data handed to a sink in one write call
+    const qint64 s_maxChunkSize = 32*2048;
+
+    // the time a dropped sink gets to return from its current write
+    const unsigned long s_droppedSinkTimeout = 2000;
+}
+
+
+class K3b::FanOutBuffer::Private
+{
+public:
+    class Sink : public QThread
+    {
+    public:
+        Sink( Private* buffer, QIODevice* dev, bool close )
+            : m_buffer( buffer ),
+              device( dev ),
+              closeDevice( close ),
+              position( 0 ),
+              active( true ),
+              done( false ) {
+        }
+
+        void run() override;
+
+    private:
+        Private* m_buffer;
+
+    public:
+        QIODevice* device;
+        bool closeDevice;
+
+        // keeps the ring alive while a dropped sink is stuck in a write
+        QByteArray ring;
+
+        // protected by the buffer mutex
+        qint64 position;
+        bool active;
+        bool done;
+    };
+
+    Private( qint64 s )
+        : size( s ),
+          data( 0 ),
+          head( 0 ),
+          closing( false ),
+          ref( 1 ) {
+    }
+
+    Sink* sink( QIODevice* dev ) const {
+        Q_FOREACH( Sink* sink, sinks ) {
+            if( sink->device == dev )
+                return sink;
+        }
+        return 0;
+    }
+
+    bool haveActiveSinks() const {
+        Q_FOREACH( Sink* sink, sinks ) {
+            if( sink->active )
+                return true;
+        }
+        return false;
+    }
+
+    // the data before this position has been taken by all active sinks
+    qint64 tail() const {
+        qint64 pos = head;
+        Q_FOREACH( Sink* sink, sinks ) {
+            if( sink->active )
+                pos = qMin( pos, sink->position );
+        }
+        return pos;
+    }
+
+    const qint64 size;
+    QByteArray ring;
+    char* data;
+
+    // the number of bytes written to the buffer
+    qint64 head;
+    bool closing;
+
+    QList<Sink*> sinks;
+
+    // the buffer and every running sink hold a reference since a sink
+    // which is left behind might only return from its write after the
+    // buffer has been deleted
+    QAtomicInt ref;
+
+    mutable QMutex mutex;
+    QWaitCondition dataAvailable;
+    QWaitCondition spaceAvailable;
+};
+
+
+void K3b::FanOutBuffer::Private::Sink::run()
+{
+    QMutexLocker locker( &m_buffer->mutex );
+
+    while( active ) {
+        while( active && position == m_buffer->head && !m_buffer->closing )
+            m_buffer->dataAvailable.wait( &m_buffer->mutex );
+
+        // dropped or done
+        if( !active || position == m_buffer->head )
+            break;
+
+        // the writer never touches the data between the tail and the head
+        const qint64 offset = position % m_buffer->size;
+        const qint64 len = qMin( qMin( m_buffer->head - position, m_buffer->size - offset ), s_maxChunkSize );
+        const char* chunk = ring.constData() + offset;
+
+        locker.unlock();
+        const qint64 written = device->write( chunk, len );
+        locker.relock();
+
+        if( written > 0 ) {
+            position += written;
+        }
+        else if( active ) {
+            qDebug() << "(K3b::FanOutBuffer) write to" << device << "failed:" << device->errorString();
+            active = false;
+        }
+
+        m_buffer->spaceAvailable.wakeAll();
+    }
+
+    qDebug() << "(K3b::FanOutBuffer) done with" << device << "after" << position << "bytes";
+    done = true;
+
+    locker.unlock();
+    if( !m_buffer->ref.deref() )
+        delete m_buffer;
+}
+
+
+K3b::FanOutBuffer::FanOutBuffer( qint64 size )
+    : d( new Private( size ) )
+{
+}
+
+
+K3b::FanOutBuffer::~FanOutBuffer()
+{
+    waitForSinks();
+    qDeleteAll( d->sinks );
+    d->sinks.clear();
+    if( !d->ref.deref() )
+        delete d;
+}
+
+
+void K3b::FanOutBuffer::addSink( QIODevice* dev, bool close )
+{
+    if( isOpen() || d->sink( dev ) )
+        return;
+
+    Private::Sink* sink = new Private::Sink( d, dev, close );
+    connect( sink, SIGNAL(finished()), this, SLOT(slotSinkFinished()) );
+    d->sinks.append( sink );
+}
+
+
+void K3b::FanOutBuffer::clearSinks()
+{
+    if( isOpen() )
+        return;
+
+    qDeleteAll( d->sinks );
+    d->sinks.clear();
+}
+
+
+void K3b::FanOutBuffer::dropSink( QIODevice* dev )
+{
+    QMutexLocker locker( &d->mutex );
+    if( Private::Sink* sink = d->sink( dev ) ) {
+        sink->active = false;
+        d->dataAvailable.wakeAll();
+        d->spaceAvailable.wakeAll();
+    }
+}
+
+
+bool K3b::FanOutBuffer::sinkDropped( QIODevice* dev ) const
+{
+    QMutexLocker locker( &d->mutex );
+    Private::Sink* sink = d->sink( dev );
+    return sink && !sink->active;
+}
+
+
+quint64 K3b::FanOutBuffer::sinkBytesWritten( QIODevice* dev ) const
+{
+    QMutexLocker locker( &d->mutex );
+    Private::Sink* sink = d->sink( dev );
+    return sink ? sink->position : 0;
+}
+
+
+int K3b::FanOutBuffer::fillLevel() const
+{
+    QMutexLocker locker( &d->mutex );
+    if( d->size <= 0 )
+        return 0;
+    return 100 * ( d->head - d->tail() ) / d->size;
+}
+
+
+bool K3b::FanOutBuffer::open( OpenMode mode )
+{
+    if( isOpen() || d->sinks.isEmpty() || !( mode & WriteOnly ) )
+        return false;
+
+    Q_FOREACH( Private::Sink* sink, d->sinks ) {
+        if( !sink->device->isOpen() && !sink->device->open( QIODevice::WriteOnly ) ) {
+            qDebug() << "(K3b::FanOutBuffer) unable to open" << sink->device;
+            return false;
+        }
+    }
+
+    d->ring.resize( d->size );
+    d->data = d->ring.data();
+    d->head = 0;
+    d->closing = false;
+
+    QIODevice::open( WriteOnly|Unbuffered );
+
+    Q_FOREACH( Private::Sink* sink, d->sinks ) {
+        sink->wait();
+        sink->position = 0;
+        sink->active = true;
+        sink->done = false;
+        sink->ring = d->ring;
+        d->ref.ref();
+        sink->start();
+    }
+
+    return true;
+}
+
+
+void K3b::FanOutBuffer::close()
+{
+    if( !isOpen() )
+        return;
+
+    QMutexLocker locker( &d->mutex );
+    d->closing = true;
+    d->dataAvailable.wakeAll();
+
+    // the sinks are closed in slotSinkFinished once they took the remaining data
+}
+
+
+void K3b::FanOutBuffer::slotSinkFinished()
+{
+    if( !isOpen() )
+        return;
+
+    Private::Sink* finishedSink = static_cast<Private::Sink*>( sender() );
+    if( finishedSink->closeDevice && finishedSink->device->isOpen() )
+        finishedSink->device->close();
+
+    QMutexLocker locker( &d->mutex );
+    if( !d->closing )
+        return;
+
+    Q_FOREACH( Private::Sink* sink, d->sinks ) {
+        if( !sink->done )
+            return;
+    }
+
+    locker.unlock();
+    waitForSinks();
+}
+
+
+void K3b::FanOutBuffer::waitForSinks()
+{
+    if( !isOpen() )
+        return;
+
+    d->mutex.lock();
+    d->closing = true;
+    d->dataAvailable.wakeAll();
+    d->mutex.unlock();
+
+    Q_FOREACH( Private::Sink* sink, d->sinks ) {
+        d->mutex.lock();
+        const bool dropped = !sink->active;
+        d->mutex.unlock();
+
+        if( dropped && !sink->wait( s_droppedSinkTimeout ) ) {
+            // The device does not return from its write. Leave the thread
+            // behind instead of blocking, it cleans up once the write returns.
+            qDebug() << "(K3b::FanOutBuffer) giving up on" << sink->device;
+            sink->disconnect( this );
+            connect( sink, SIGNAL(finished()), sink, SLOT(deleteLater()) );
+            if( sink->isFinished() )
+                delete sink;
+            d->sinks.removeAll( sink );
+            continue;
+        }
+
+        sink->wait();
+        sink->ring = QByteArray();
+        if( sink->closeDevice && sink->device->isOpen() )
+            sink->device->close();
+    }
+
+    // the buffer may be huge
+    d->data = 0;
+    d->ring = QByteArray();
+
+    QIODevice::close();
+}
+
+
+qint64 K3b::FanOutBuffer::readData( char*, qint64 )
+{
+    return -1;
+}
+
+
+qint64 K3b::FanOutBuffer::writeData( const char* data, qint64 max )
+{
+    QMutexLocker locker( &d->mutex );
+
+    qint64 written = 0;
+    while( written < max ) {
+        qint64 space = 0;
+        while( d->haveActiveSinks() && ( space = d->size - ( d->head - d->tail() ) ) == 0 )
+            d->spaceAvailable.wait( &d->mutex );
+
+        if( !d->haveActiveSinks() ) {
+            qDebug() << "(K3b::FanOutBuffer) no sinks left.";
+            return written > 0 ? written : -1;
+        }
+
+        // only this thread moves the head, the sinks never read beyond it
+        const qint64 offset = d->head % d->size;
+        const qint64 len = qMin( qMin( space, max - written ), d->size - offset );
+
+        locker.unlock();
+        ::memcpy( d->data + offset, data + written, len );
+        locker.relock();
+
+        d->head += len;
+        written += len;
+        d->dataAvailable.wakeAll();
+    }
+
+    return written;
+}
+
+#include "moc_k3bfanoutbuffer.cpp"
@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_FAN_OUT_BUFFER_H_
+#define _K3B_FAN_OUT_BUFFER_H_
+
+#include "k3b_export.h"
+
+#include <QIODevice>
+
+
+namespace K3b {
+    /**
+     * The FanOutBuffer passes the data written to it on to several sinks,
+     * for example the writers of several drives burning the same image.
+     *
+     * The data is kept in a ring buffer shared by all sinks. Every sink is
+     * fed from a thread of its own so a sink which is busy for a moment (a
+     * drive doing its power calibration or a layer jump) does not hold back
+     * the others. Writing to the buffer only blocks once the slowest sink
+     * lags behind by the whole buffer size.
+     *
+     * A sink which fails to take data is dropped and does not block the
+     * others any longer. Writing fails once all sinks have been dropped.
+     *
+     * Like the ActivePipe the buffer can be used as the sink of a Job which
+     * can only push data, e.g. the DataTrackReader.
+     */
+    class LIBK3B_EXPORT FanOutBuffer : public QIODevice
+    {
+        Q_OBJECT
+
+    public:
+        /**
+         * \param size The size of the ring buffer in bytes.
+         */
+        explicit FanOutBuffer( qint64 size = 64*1024*1024 );
+        ~FanOutBuffer() override;
+
+        /**
+         * Add a sink. Sinks can only be added while the buffer is closed.
+         * The device will be opened QIODevice::WriteOnly if necessary.
+         *
+         * \param close If true the device will be closed once close() is called.
+         */
+        void addSink( QIODevice* dev, bool close = false );
+
+        /**
+         * Remove all sinks. Only possible while the buffer is closed.
+         */
+        void clearSinks();
+
+        /**
+         * Stop feeding @p dev. Data which has not been taken by it yet
+         * does not block writing any longer.
+         */
+        void dropSink( QIODevice* dev );
+
+        /**
+         * \return true if @p dev has been dropped, either by dropSink() or
+         *         because writing to it failed.
+         */
+        bool sinkDropped( QIODevice* dev ) const;
+
+        /**
+         * The number of bytes which have been written to @p dev.
+         */
+        quint64 sinkBytesWritten( QIODevice* dev ) const;
+
+        /**
+         * \return The fill level of the ring buffer in percent, i.e. how
+         *         far the slowest sink lags behind.
+         */
+        int fillLevel() const;
+
+        /**
+         * Opens the buffer and starts feeding the sinks.
+         */
+        bool open( OpenMode mode = WriteOnly ) override;
+
+        /**
+         * Signals the end of the data. Returns immediately, every sink is
+         * closed (if requested) once it took the remaining data. The buffer
+         * itself is closed once all sinks are done.
+         */
+        void close() override;
+
+        /**
+         * Closes the buffer and blocks until all sinks took the remaining data.
+         *
+         * A dropped sink which does not return from its current write within
+         * a few seconds is left behind. It is not closed and must not be
+         * deleted before that write returns.
+         */
+        void waitForSinks();
+
+    private Q_SLOTS:
+        void slotSinkFinished();
+
+    protected:
+        qint64 readData( char* data, qint64 max ) override;
+        qint64 writeData( const char* data, qint64 max ) override;
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -117,6 +117,12 @@ void K3b::FileSplitter::setName( const QString& filename )
 }
 
 
+bool K3b::FileSplitter::isSplit() const
+{
+    return QFile::exists( d->buildFileName( 1 ) );
+}
+
+
 bool K3b::FileSplitter::open( OpenMode mode )
 {
     qDebug() << mode;
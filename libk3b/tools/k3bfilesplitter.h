@@ -52,6 +52,12 @@ namespace K3b {
 
         void setName( const QString& filename );
 
+        /**
+         * \return true if the data is spread over several files, i.e. it
+         * cannot be read from name() alone.
+         */
+        bool isSplit() const;
+
         bool open( OpenMode mode ) override;
 
         void close() override;
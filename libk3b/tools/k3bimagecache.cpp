@@ -0,0 +1,269 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bimagecache.h"
+#include "k3bcore.h"
+#include "k3bglobalsettings.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#ifdef Q_OS_LINUX
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+    const char* const s_imageSuffix = ".iso";
+    const char* const s_checksumSuffix = ".md5";
+    const char* const s_newSuffix = ".part";
+}
+
+
+K3b::ImageCache::ImageCache( const QString& dir, qint64 maxSize )
+    : m_dir( dir ),
+      m_maxSize( maxSize )
+{
+}
+
+
+K3b::ImageCache::~ImageCache()
+{
+}
+
+
+K3b::ImageCache K3b::ImageCache::fromSettings()
+{
+    const K3b::GlobalSettings* settings = k3bcore->globalSettings();
+    return ImageCache( QDir( settings->defaultTempPath() ).filePath( "k3bimagecache" ),
+                       qint64( settings->imageCacheSize() ) * 1024 * 1024 * 1024 );
+}
+
+
+bool K3b::ImageCache::isEnabled() const
+{
+    return !m_dir.isEmpty() && m_maxSize > 0;
+}
+
+
+QString K3b::ImageCache::directory() const
+{
+    return m_dir;
+}
+
+
+qint64 K3b::ImageCache::maxSize() const
+{
+    return m_maxSize;
+}
+
+
+QString K3b::ImageCache::lookup( const QByteArray& key, QByteArray* checksum ) const
+{
+    if( !isEnabled() )
+        return QString();
+
+    const QString path = imagePath( key );
+    QFile image( path );
+    QFile checksumFile( checksumPath( key ) );
+    if( !image.exists() || !checksumFile.open( QIODevice::ReadOnly ) )
+        return QString();
+
+    if( checksum )
+        *checksum = checksumFile.readAll().trimmed();
+
+    // the modification time is the time of the last use
+    if( image.open( QIODevice::ReadOnly ) ) {
+        image.setFileTime( QDateTime::currentDateTime(), QFileDevice::FileModificationTime );
+        image.close();
+    }
+
+    qDebug() << "(K3b::ImageCache) found" << path;
+    return path;
+}
+
+
+QString K3b::ImageCache::newImagePath( const QByteArray& key ) const
+{
+    if( !isEnabled() || !QDir().mkpath( m_dir ) )
+        return QString();
+
+    return imagePath( key ) + s_newSuffix;
+}
+
+
+bool K3b::ImageCache::insert( const QByteArray& key, const QByteArray& checksum )
+{
+    const QString path = imagePath( key );
+    const QString newPath = path + s_newSuffix;
+    if( !QFile::exists( newPath ) )
+        return false;
+
+    // an image larger than the cache must not evict the others
+    if( QFileInfo( newPath ).size() > m_maxSize ) {
+        qDebug() << "(K3b::ImageCache)" << newPath << "exceeds the cache size.";
+        remove( key );
+        return false;
+    }
+
+    if( !writeChecksum( key, checksum ) ) {
+        remove( key );
+        return false;
+    }
+
+    QFile::remove( path );
+    if( !QFile::rename( newPath, path ) ) {
+        qDebug() << "(K3b::ImageCache) unable to move" << newPath << "to" << path;
+        remove( key );
+        return false;
+    }
+
+    qDebug() << "(K3b::ImageCache) added" << path;
+    evict( key );
+
+    return QFile::exists( path );
+}
+
+
+bool K3b::ImageCache::insertFile( const QByteArray& key, const QString& path, const QByteArray& checksum, bool move )
+{
+    const QString newPath = newImagePath( key );
+    if( newPath.isEmpty() )
+        return false;
+
+    // an image larger than the cache would be evicted right away
+    if( QFileInfo( path ).size() > m_maxSize ) {
+        qDebug() << "(K3b::ImageCache)" << path << "exceeds the cache size.";
+        return false;
+    }
+
+    if( move ) {
+        // nothing may remove the image once it has been moved
+        const QString cachePath = imagePath( key );
+        if( !writeChecksum( key, checksum ) )
+            return false;
+        QFile::remove( cachePath );
+        if( !QFile::rename( path, cachePath ) ) {
+            qDebug() << "(K3b::ImageCache) unable to move" << path << "to" << cachePath;
+            QFile::remove( checksumPath( key ) );
+            return false;
+        }
+
+        qDebug() << "(K3b::ImageCache) added" << cachePath;
+        evict( key );
+        return true;
+    }
+
+    QFile::remove( newPath );
+    if( !clone( path, newPath ) ) {
+        qDebug() << "(K3b::ImageCache) unable to clone" << path << "to" << newPath;
+        QFile::remove( newPath );
+        return false;
+    }
+
+    return insert( key, checksum );
+}
+
+
+bool K3b::ImageCache::writeChecksum( const QByteArray& key, const QByteArray& checksum ) const
+{
+    QFile checksumFile( checksumPath( key ) );
+    if( !checksumFile.open( QIODevice::WriteOnly ) ||
+        checksumFile.write( checksum ) != checksum.size() ) {
+        qDebug() << "(K3b::ImageCache) unable to write" << checksumFile.fileName();
+        return false;
+    }
+    return true;
+}
+
+
+bool K3b::ImageCache::clone( const QString& from, const QString& to ) const
+{
+#if defined(Q_OS_LINUX) && defined(FICLONE)
+    const int in = ::open( QFile::encodeName( from ).constData(), O_RDONLY|O_CLOEXEC );
+    if( in < 0 )
+        return false;
+    const int out = ::open( QFile::encodeName( to ).constData(), O_WRONLY|O_CREAT|O_EXCL|O_CLOEXEC, 0644 );
+    if( out < 0 ) {
+        ::close( in );
+        return false;
+    }
+    const bool success = ( ::ioctl( out, FICLONE, in ) == 0 );
+    ::close( out );
+    ::close( in );
+    return success;
+#else
+    Q_UNUSED( from );
+    Q_UNUSED( to );
+    return false;
+#endif
+}
+
+
+void K3b::ImageCache::remove( const QByteArray& key )
+{
+    const QString path = imagePath( key );
+    QFile::remove( path );
+    QFile::remove( path + s_newSuffix );
+    QFile::remove( checksumPath( key ) );
+}
+
+
+qint64 K3b::ImageCache::size() const
+{
+    qint64 size = 0;
+    const QFileInfoList images = QDir( m_dir ).entryInfoList( QStringList() << QString( "*" ) + s_imageSuffix, QDir::Files );
+    Q_FOREACH( const QFileInfo& fi, images )
+        size += fi.size();
+    return size;
+}
+
+
+QString K3b::ImageCache::imagePath( const QByteArray& key ) const
+{
+    return QDir( m_dir ).filePath( QString::fromLatin1( key.toHex() ) + s_imageSuffix );
+}
+
+
+QString K3b::ImageCache::checksumPath( const QByteArray& key ) const
+{
+    return QDir( m_dir ).filePath( QString::fromLatin1( key.toHex() ) + s_checksumSuffix );
+}
+
+
+void K3b::ImageCache::evict( const QByteArray& keep )
+{
+    // least recently used first
+    QFileInfoList images = QDir( m_dir ).entryInfoList( QStringList() << QString( "*" ) + s_imageSuffix,
+                                                        QDir::Files, QDir::Time|QDir::Reversed );
+    qint64 total = 0;
+    Q_FOREACH( const QFileInfo& fi, images )
+        total += fi.size();
+
+    const QString keepName = QString::fromLatin1( keep.toHex() ) + s_imageSuffix;
+    Q_FOREACH( const QFileInfo& fi, images ) {
+        if( total <= m_maxSize )
+            break;
+        if( fi.fileName() == keepName )
+            continue;
+
+        qDebug() << "(K3b::ImageCache) evicting" << fi.filePath();
+        remove( QByteArray::fromHex( fi.completeBaseName().toLatin1() ) );
+        total -= fi.size();
+    }
+
+    // an image which does not fit at all is not kept either
+    if( total > m_maxSize ) {
+        qDebug() << "(K3b::ImageCache) image exceeds the cache size.";
+        remove( keep );
+    }
+}
@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_IMAGE_CACHE_H_
+#define _K3B_IMAGE_CACHE_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QString>
+
+
+namespace K3b {
+    /**
+     * A folder of images addressed by a key which is derived from the
+     * contents of the image, for example a hash of the project which
+     * created it. Each image is stored together with its md5 checksum.
+     *
+     * The modification time of the images is used as the time of their
+     * last use. Once the images exceed the size of the cache the least
+     * recently used ones are removed.
+     *
+     * The cache does not keep any state besides the folder so several
+     * instances may be used on the same folder.
+     */
+    class LIBK3B_EXPORT ImageCache
+    {
+    public:
+        /**
+         * @param maxSize The size of the cache in bytes.
+         */
+        ImageCache( const QString& dir, qint64 maxSize );
+        ~ImageCache();
+
+        /**
+         * The cache as configured in the global settings. Check isEnabled()
+         * before using it.
+         */
+        static ImageCache fromSettings();
+
+        bool isEnabled() const;
+
+        QString directory() const;
+        qint64 maxSize() const;
+
+        /**
+         * \return The path of the image stored under @p key or an empty
+         *         string. The image is marked as used.
+         *
+         * @param checksum If not 0 the md5 checksum of the image is stored
+         *                 here.
+         */
+        QString lookup( const QByteArray& key, QByteArray* checksum = 0 ) const;
+
+        /**
+         * \return The path to create a new image for @p key in. The image is
+         *         not visible to lookup() until insert() has been called.
+         */
+        QString newImagePath( const QByteArray& key ) const;
+
+        /**
+         * Moves the image created in newImagePath() into the cache and
+         * removes the least recently used images until the cache fits its size.
+         * An image larger than the cache is removed instead.
+         *
+         * @param checksum The md5 checksum of the image.
+         */
+        bool insert( const QByteArray& key, const QByteArray& checksum );
+
+        /**
+         * Put an existing image into the cache without copying its data.
+         *
+         * @param move If true the image is moved into the cache which only
+         *             works on the same file system. Otherwise a copy-on-write
+         *             clone is created which only some file systems support.
+         *             The image never shares its data with the cached one, so
+         *             overwriting it later does not change the cache.
+         *
+         * \return false if the image could not be put into the cache. In that
+         *         case a moved image is left in place.
+         */
+        bool insertFile( const QByteArray& key, const QString& path, const QByteArray& checksum, bool move );
+
+        /**
+         * Removes the image stored under @p key and any unfinished image
+         * created in newImagePath().
+         */
+        void remove( const QByteArray& key );
+
+        /**
+         * \return The size of all images in the cache in bytes.
+         */
+        qint64 size() const;
+
+    private:
+        QString imagePath( const QByteArray& key ) const;
+        QString checksumPath( const QByteArray& key ) const;
+        bool writeChecksum( const QByteArray& key, const QByteArray& checksum ) const;
+        bool clone( const QString& from, const QString& to ) const;
+        void evict( const QByteArray& keep );
+
+        QString m_dir;
+        qint64 m_maxSize;
+    };
+}
+
+#endif
@@ -61,22 +61,27 @@ int K3b::Iso9660DeviceBackend::read( unsigned int sector, char* data, int len )
 {
     if( isOpen() ) {
         //
-        // split the number of sectors to be read
-        // FIXME: use a "real" value, not some arbitrary one
+        // split the number of sectors to be read. The parts get smaller
+        // around read errors and grow back afterwards.
         //
-        static const int maxReadSectors = 20;
+        const int maxReadSectors = qMax( 1, m_device->maxTransferLength() / 2048 );
+        int readSectors = maxReadSectors;
         int sectorsRead = 0;
         int retries = 10;  // TODO: no fixed value
         while( retries ) {
-            int read = qMin(len-sectorsRead, maxReadSectors);
+            int read = qMin(len-sectorsRead, readSectors);
             if( !m_device->read10( (unsigned char*)(data+sectorsRead*2048),
                                    read*2048,
                                    sector+sectorsRead,
                                    read ) ) {
-                retries--;
+                if( readSectors > 1 )
+                    readSectors /= 2;
+                else
+                    retries--;
             }
             else {
                 sectorsRead += read;
+                readSectors = qMin( 2*readSectors, maxReadSectors );
                 retries = 10; // new retires for every read part
                 if( sectorsRead == len )
                     return len;
@@ -22,6 +22,10 @@
 #include <KCDDB/Client>
 
 
+namespace {
+    const int s_maxKnownMedia = 8;
+}
+
 
 K3b::MediaCache::DeviceEntry::DeviceEntry( K3b::MediaCache* c, K3b::Device::Device* dev )
     : medium(dev),
@@ -71,7 +75,15 @@ void K3b::MediaCache::PollThread::run()
             // The medium has changed. We need to update the information.
             //
             K3b::Medium m( m_deviceEntry->medium.device() );
-            m.update();
+            if( m.update( m_deviceEntry->knownMedia ) ) {
+                m_deviceEntry->knownMedia.removeAll( m );
+                m_deviceEntry->knownMedia.prepend( m );
+            }
+            else if( !m.fingerprint().isEmpty() ) {
+                m_deviceEntry->knownMedia.prepend( m );
+                while( m_deviceEntry->knownMedia.count() > s_maxKnownMedia )
+                    m_deviceEntry->knownMedia.removeLast();
+            }
 
             // block the info since it is not valid anymore
             m_deviceEntry->readMutex.lock();
@@ -119,7 +131,10 @@ public:
 // called from the device thread which updated the medium
 void K3b::MediaCache::Private::_k_mediumChanged( K3b::Device::Device* dev )
 {
-    if ( q->medium( dev ).content() & K3b::Medium::ContentAudio ) {
+    const K3b::Medium medium = q->medium( dev );
+
+    // a known medium comes with the CDDB info from its last lookup
+    if ( medium.content() & K3b::Medium::ContentAudio && !medium.cddbInfo().isValid() ) {
         K3b::CDDB::CDDBJob* job = K3b::CDDB::CDDBJob::queryCddb( q->medium( dev ) );
         connect( job, SIGNAL(result(KJob*)),
                  q, SLOT(_k_cddbJobFinished(KJob*)) );
@@ -140,8 +155,19 @@ void K3b::MediaCache::Private::_k_cddbJobFinished( KJob* job )
     // make sure the medium did not change during the job
     if ( oldMedium.sameMedium( q->medium( oldMedium.device() ) ) ) {
         if ( !job->error() ) {
-            // update it
-            deviceMap[oldMedium.device()]->medium.d->cddbInfo = cddbJob->cddbResult();
+            // update it and the known medium which shares the data no more
+            DeviceEntry* e = deviceMap[oldMedium.device()];
+            e->writeMutex.lock();
+            e->medium.d->cddbInfo = cddbJob->cddbResult();
+            if( !e->medium.fingerprint().isEmpty() ) {
+                for( QList<K3b::Medium>::iterator it = e->knownMedia.begin(); it != e->knownMedia.end(); ++it ) {
+                    if( it->fingerprint() == e->medium.fingerprint() ) {
+                        *it = e->medium;
+                        break;
+                    }
+                }
+            }
+            e->writeMutex.unlock();
             emit q->mediumCddbChanged( oldMedium.device() );
         }
 
@@ -201,6 +227,8 @@ bool K3b::MediaCache::unblockDevice( K3b::Device::Device* dev, int id )
     if( e && e->blockedId && e->blockedId == id ) {
         e->blockedId = 0;
 
+        // the blocking job may have changed the medium without changing its fingerprint
+        e->knownMedia.clear();
         e->medium = K3b::Medium( dev );
 
         // restart the poll thread
@@ -377,6 +405,7 @@ void K3b::MediaCache::resetDevice( K3b::Device::Device* dev )
         e->readMutex.lock();
         e->medium.reset();
         e->readMutex.unlock();
+        e->knownMedia.clear();
         e->writeMutex.unlock();
         // no need to emit mediumChanged here. The poll thread will act on it soon
     }
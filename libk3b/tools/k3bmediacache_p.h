@@ -19,6 +19,13 @@ public:
 
     Medium medium;
 
+    /**
+     * The media recently seen in the device, most recent first. Reinserting
+     * one of them only costs the queries for the fingerprint.
+     * Protected by the writeMutex.
+     */
+    QList<Medium> knownMedia;
+
     int blockedId;
 
     QMutex readMutex;
@@ -16,12 +16,65 @@
 
 #include <KIO/Global>
 
+#include <QCryptographicHash>
+#include <QDataStream>
 #include <QList>
 #include <QSharedData>
 
 #include <KCDDB/CDInfo>
 
 
+namespace {
+    //
+    // The fingerprint identifies a medium with as few commands as possible:
+    // the disk info (which includes the media id of DVD and BD media), the raw
+    // TOC of CDs, and the primary volume descriptor of data media which changes
+    // whenever a rewritable medium gets a new filesystem.
+    //
+    // Blank media have no fingerprint. All blank media of one type and capacity
+    // look the same but may differ in their writing speeds.
+    //
+    QByteArray mediumFingerprint( K3b::Device::Device* dev, const K3b::Device::DiskInfo& di )
+    {
+        if( di.diskState() == K3b::Device::STATE_NO_MEDIA ||
+            di.diskState() == K3b::Device::STATE_EMPTY ||
+            di.diskState() == K3b::Device::STATE_UNKNOWN )
+            return QByteArray();
+
+        QByteArray info;
+        QDataStream s( &info, QIODevice::WriteOnly );
+        s << qint32( di.mediaType() ) << qint32( di.diskState() )
+          << qint32( di.numSessions() ) << qint32( di.numTracks() )
+          << qint32( di.size().lba() ) << qint32( di.remainingSize().lba() ) << qint32( di.capacity().lba() )
+          << di.mediaId();
+
+        QCryptographicHash hash( QCryptographicHash::Sha1 );
+        hash.addData( info );
+
+        if( di.diskState() == K3b::Device::STATE_COMPLETE ||
+            di.diskState() == K3b::Device::STATE_INCOMPLETE ) {
+            bool dataMedium = true;
+            if( K3b::Device::isCdMedia( di.mediaType() ) ) {
+                K3b::Device::UByteArray toc;
+                if( !dev->readTocPmaAtip( toc, 0, false, 0 ) )
+                    return QByteArray();
+                hash.addData( reinterpret_cast<const char*>( toc.data() ), toc.size() );
+
+                // control field of the first track
+                dataMedium = ( toc.size() > 5 && ( toc[5] & 0x4 ) );
+            }
+
+            if( dataMedium ) {
+                unsigned char pvd[2048];
+                if( dev->read10( pvd, 2048, 16, 1 ) )
+                    hash.addData( reinterpret_cast<const char*>( pvd ), 2048 );
+            }
+        }
+
+        return hash.result();
+    }
+}
+
 
 K3b::MediumPrivate::MediumPrivate()
     : device( 0 ),
@@ -160,6 +213,7 @@ void K3b::Medium::reset()
     d->writingSpeeds.clear();
     d->content = ContentNone;
     d->cddbInfo.clear();
+    d->fingerprint.clear();
 
     // clear the desc
     d->isoDesc = K3b::Iso9660SimplePrimaryDescriptor();
@@ -167,6 +221,12 @@ void K3b::Medium::reset()
 
 
 void K3b::Medium::update()
+{
+    update( QList<K3b::Medium>() );
+}
+
+
+bool K3b::Medium::update( const QList<K3b::Medium>& knownMedia )
 {
     if( d->device ) {
         reset();
@@ -183,6 +243,17 @@ void K3b::Medium::update()
             qDebug() << "no medium found";
         }
 
+        d->fingerprint = mediumFingerprint( d->device, d->diskInfo );
+        if( !d->fingerprint.isEmpty() ) {
+            Q_FOREACH( const K3b::Medium& known, knownMedia ) {
+                if( known.d->device == d->device && known.d->fingerprint == d->fingerprint ) {
+                    qDebug() << "(K3b::Medium) known medium in" << d->device->blockDeviceName();
+                    d = known.d;
+                    return true;
+                }
+            }
+        }
+
         if( diskInfo().diskState() == K3b::Device::STATE_COMPLETE ||
             diskInfo().diskState() == K3b::Device::STATE_INCOMPLETE ) {
             d->toc = d->device->readToc();
@@ -200,6 +271,14 @@ void K3b::Medium::update()
 
         analyseContent();
     }
+
+    return false;
+}
+
+
+QByteArray K3b::Medium::fingerprint() const
+{
+    return d->fingerprint;
 }
 
 
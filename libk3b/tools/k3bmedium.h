@@ -64,6 +64,23 @@ namespace K3b {
          */
         void update();
 
+        /**
+         * Like update() but takes the contents from one of @p knownMedia
+         * if it holds the same medium. Only the disk info and a fingerprint
+         * of the medium (the raw TOC and the primary volume descriptor)
+         * are read in that case.
+         *
+         * \return true if one of @p knownMedia has been reused.
+         */
+        bool update( const QList<Medium>& knownMedia );
+
+        /**
+         * \return A cheap identity of the medium determined in update()
+         *         or an empty array if there is no medium or it is blank.
+         *         Blank media are never taken from the known media.
+         */
+        QByteArray fingerprint() const;
+
         Device::Device* device() const;
         Device::DiskInfo diskInfo() const;
         Device::Toc toc() const;
@@ -13,6 +13,7 @@
 #include "k3bcdtext.h"
 #include "k3biso9660.h"
 
+#include <QByteArray>
 #include <QSharedData>
 #include <QList>
 
@@ -35,6 +36,7 @@ namespace K3b {
         QList<int> writingSpeeds;
         Iso9660SimplePrimaryDescriptor isoDesc;
         Medium::MediumContents content;
+        QByteArray fingerprint;
 
         KCDDB::CDInfo cddbInfo;
     };
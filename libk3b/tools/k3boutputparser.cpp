@@ -0,0 +1,332 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3boutputparser.h"
+
+#include <cstring>
+
+
+K3b::LineScanner::LineScanner( const QByteArray& line )
+    : m_data( line.constData() ),
+      m_len( line.size() ),
+      m_pos( 0 )
+{
+}
+
+
+K3b::LineScanner::LineScanner( const char* data, int len )
+    : m_data( data ),
+      m_len( len ),
+      m_pos( 0 )
+{
+}
+
+
+void K3b::LineScanner::skipSpaces()
+{
+    while( m_pos < m_len && m_data[m_pos] == ' ' )
+        ++m_pos;
+}
+
+
+bool K3b::LineScanner::skip( char c )
+{
+    if( m_pos < m_len && m_data[m_pos] == c ) {
+        ++m_pos;
+        return true;
+    }
+    return false;
+}
+
+
+bool K3b::LineScanner::skip( const char* s )
+{
+    const int len = ::strlen( s );
+    if( m_len - m_pos >= len && ::memcmp( m_data + m_pos, s, len ) == 0 ) {
+        m_pos += len;
+        return true;
+    }
+    return false;
+}
+
+
+bool K3b::LineScanner::skipPast( const char* s )
+{
+    const int len = ::strlen( s );
+    const int pos = find( s, len );
+    if( pos >= 0 ) {
+        m_pos = pos + len;
+        return true;
+    }
+    return false;
+}
+
+
+bool K3b::LineScanner::startsWith( const char* s ) const
+{
+    const int len = ::strlen( s );
+    return m_len - m_pos >= len && ::memcmp( m_data + m_pos, s, len ) == 0;
+}
+
+
+bool K3b::LineScanner::contains( const char* s ) const
+{
+    return find( s, ::strlen( s ) ) >= 0;
+}
+
+
+bool K3b::LineScanner::readInt( qint64& value )
+{
+    int pos = m_pos;
+    qint64 v = 0;
+    while( pos < m_len && m_data[pos] >= '0' && m_data[pos] <= '9' )
+        v = v*10 + ( m_data[pos++] - '0' );
+
+    if( pos == m_pos )
+        return false;
+
+    value = v;
+    m_pos = pos;
+    return true;
+}
+
+
+bool K3b::LineScanner::readDouble( double& value )
+{
+    qint64 i = 0;
+    if( !readInt( i ) )
+        return false;
+
+    double v = i;
+    if( m_pos + 1 < m_len &&
+        ( m_data[m_pos] == '.' || m_data[m_pos] == ',' ) &&
+        m_data[m_pos+1] >= '0' && m_data[m_pos+1] <= '9' ) {
+        ++m_pos;
+        double factor = 0.1;
+        while( m_pos < m_len && m_data[m_pos] >= '0' && m_data[m_pos] <= '9' ) {
+            v += factor * ( m_data[m_pos++] - '0' );
+            factor /= 10.0;
+        }
+    }
+
+    value = v;
+    return true;
+}
+
+
+int K3b::LineScanner::find( const char* s, int len ) const
+{
+    if( len == 0 )
+        return m_pos;
+
+    const char* p = m_data + m_pos;
+    const char* end = m_data + m_len - len + 1;
+    while( p < end ) {
+        p = static_cast<const char*>( ::memchr( p, s[0], end - p ) );
+        if( !p )
+            break;
+        if( ::memcmp( p, s, len ) == 0 )
+            return p - m_data;
+        ++p;
+    }
+    return -1;
+}
+
+
+K3b::ProgressLineFilter::ProgressLineFilter( int interval )
+    : m_interval( interval ),
+      m_hasSkipped( false ),
+      m_skippedLines( 0 )
+{
+}
+
+
+void K3b::ProgressLineFilter::reset()
+{
+    m_timer.invalidate();
+    m_skipped.clear();
+    m_hasSkipped = false;
+    m_skippedLines = 0;
+}
+
+
+bool K3b::ProgressLineFilter::accept( const QByteArray& line )
+{
+    if( !m_timer.isValid() || m_timer.elapsed() >= m_interval ) {
+        m_timer.start();
+        m_hasSkipped = false;
+        return true;
+    }
+
+    // a deep copy since the process reuses the buffer of the line
+    m_skipped.resize( 0 );
+    m_skipped.append( line );
+    m_hasSkipped = true;
+    ++m_skippedLines;
+    return false;
+}
+
+
+QByteArray K3b::ProgressLineFilter::takeSkipped()
+{
+    if( !m_hasSkipped )
+        return QByteArray();
+
+    m_hasSkipped = false;
+    return m_skipped;
+}
+
+
+K3b::ProgressEvent::ProgressEvent()
+    : type( NoProgress ),
+      track( -1 ),
+      done( -1 ),
+      total( -1 ),
+      percent( -1.0 ),
+      speed( -1.0 ),
+      fifo( -1 ),
+      deviceBuffer( -1 )
+{
+}
+
+
+K3b::ProgressEvent K3b::parseCdrecordProgress( const QByteArray& line )
+{
+    ProgressEvent event;
+    LineScanner s( line );
+
+    qint64 track = 0, done = 0, total = 0;
+    if( !s.skip( "Track " ) || !s.readInt( track ) || !s.skip( ':' ) )
+        return event;
+    s.skipSpaces();
+    if( !s.readInt( done ) )
+        return event;
+    s.skipSpaces();
+    if( !s.skip( "of" ) )
+        return event;
+    s.skipSpaces();
+    if( !s.readInt( total ) )
+        return event;
+    s.skipSpaces();
+    if( !s.skip( "MB written" ) )
+        return event;
+
+    event.type = ProgressEvent::TrackWritten;
+    event.track = track;
+    event.done = done;
+    event.total = total;
+
+    // some patched cdrecord versions do not print the fifo but only the buffer
+    qint64 level = 0;
+    s.skipSpaces();
+    if( s.skip( "(fifo" ) ) {
+        s.skipSpaces();
+        if( s.readInt( level ) && s.skip( "%)" ) )
+            event.fifo = level;
+        s.skipSpaces();
+    }
+    if( s.skip( "[buf" ) ) {
+        s.skipSpaces();
+        if( s.readInt( level ) && s.skip( "%]" ) )
+            event.deviceBuffer = level;
+        s.skipSpaces();
+    }
+
+    double speed = 0.0;
+    if( s.readDouble( speed ) && s.skip( 'x' ) )
+        event.speed = speed;
+
+    return event;
+}
+
+
+K3b::ProgressEvent K3b::parseGrowisofsProgress( const QByteArray& line )
+{
+    ProgressEvent event;
+    LineScanner s( line );
+
+    qint64 done = 0, total = 0;
+    s.skipSpaces();
+    if( !s.readInt( done ) || !s.skip( '/' ) || !s.readInt( total ) || !s.contains( "remaining" ) )
+        return event;
+
+    event.type = ProgressEvent::DataWritten;
+    event.done = done;
+    event.total = total;
+
+    double value = 0.0;
+    s.skipSpaces();
+    if( s.skip( '(' ) ) {
+        s.skipSpaces();
+        if( s.readDouble( value ) && s.skip( "%)" ) )
+            event.percent = value;
+        s.skipSpaces();
+    }
+
+    // the writing speed is printed since growisofs 5.11
+    if( s.skip( '@' ) && s.readDouble( value ) && s.skip( 'x' ) )
+        event.speed = value;
+
+    // the ring buffer since growisofs 6.0, the drive buffer since 7.0
+    if( s.skipPast( "RBU" ) ) {
+        s.skipSpaces();
+        if( s.readDouble( value ) && s.skip( '%' ) )
+            event.fifo = int( value + 0.5 );
+    }
+    if( s.skipPast( "UBU" ) ) {
+        s.skipSpaces();
+        if( s.readDouble( value ) && s.skip( '%' ) )
+            event.deviceBuffer = int( value + 0.5 );
+    }
+
+    return event;
+}
+
+
+K3b::ProgressEvent K3b::parseMkisofsProgress( const QByteArray& line )
+{
+    ProgressEvent event;
+    LineScanner s( line );
+
+    double percent = 0.0;
+    s.skipSpaces();
+    if( s.readDouble( percent ) && s.skip( '%' ) ) {
+        s.skipSpaces();
+        if( s.skip( "done, estimate" ) ) {
+            event.type = ProgressEvent::ImageCreated;
+            event.percent = percent;
+        }
+    }
+
+    return event;
+}
+
+
+K3b::ProgressEvent K3b::parseTranscodeProgress( const QByteArray& line )
+{
+    ProgressEvent event;
+    LineScanner s( line );
+
+    qint64 pass = 0, first = 0, frames = 0;
+    if( s.skip( "encoding=" ) ) {
+        if( !s.readInt( pass ) )
+            return event;
+        s.skipSpaces();
+        if( !s.skip( "frame=" ) || !s.readInt( frames ) )
+            return event;
+    }
+    else if( s.skip( "encoding frames [" ) ) {
+        if( !s.readInt( first ) || !s.skip( '-' ) || !s.readInt( frames ) || !s.skip( ']' ) )
+            return event;
+    }
+    else {
+        return event;
+    }
+
+    event.type = ProgressEvent::FramesEncoded;
+    event.done = frames;
+    return event;
+}
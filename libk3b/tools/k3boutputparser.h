@@ -0,0 +1,173 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_OUTPUT_PARSER_H_
+#define _K3B_OUTPUT_PARSER_H_
+
+#include "k3b_export.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+
+
+namespace K3b {
+    /**
+     * A cursor over one line of the raw output of an external program.
+     * The line is neither copied nor decoded, numbers are read from the
+     * bytes directly.
+     *
+     * All methods which return false leave the position untouched.
+     */
+    class LIBK3B_EXPORT LineScanner
+    {
+    public:
+        explicit LineScanner( const QByteArray& line );
+        LineScanner( const char* data, int len );
+
+        bool atEnd() const { return m_pos >= m_len; }
+        int pos() const { return m_pos; }
+
+        void skipSpaces();
+
+        /**
+         * Skips @p c if it is the next character.
+         */
+        bool skip( char c );
+
+        /**
+         * Skips @p s if the remaining line starts with it.
+         */
+        bool skip( const char* s );
+
+        /**
+         * Moves the position behind the next occurrence of @p s.
+         */
+        bool skipPast( const char* s );
+
+        bool startsWith( const char* s ) const;
+        bool contains( const char* s ) const;
+
+        /**
+         * Reads an unsigned decimal number.
+         */
+        bool readInt( qint64& value );
+
+        /**
+         * Reads an unsigned decimal number with an optional fraction. Both
+         * the point and the comma are accepted as decimal separator since
+         * some programs use the locale to print their progress.
+         */
+        bool readDouble( double& value );
+
+    private:
+        int find( const char* s, int len ) const;
+
+        const char* m_data;
+        int m_len;
+        int m_pos;
+    };
+
+
+    /**
+     * The progress reported in one line of output. Fields which are not
+     * part of the line are -1.
+     */
+    struct LIBK3B_EXPORT ProgressEvent
+    {
+        ProgressEvent();
+
+        enum Type {
+            NoProgress,
+            TrackWritten,    /**< cdrecord, done and total in MB */
+            DataWritten,     /**< growisofs, done and total in bytes */
+            ImageCreated,    /**< mkisofs, percent */
+            FramesEncoded    /**< transcode, done in frames */
+        };
+
+        bool isValid() const { return type != NoProgress; }
+
+        Type type;
+        int track;
+        qint64 done;
+        qint64 total;
+        double percent;
+        double speed;        /**< the writing speed as a factor */
+        int fifo;            /**< the fill level of the program's fifo in percent */
+        int deviceBuffer;    /**< the fill level of the drive buffer in percent */
+    };
+
+    /**
+     * Decides which progress lines of an external program go to the
+     * debugging output. The programs print their progress several times a
+     * second which makes up most of their output. Only one progress line per
+     * interval is logged, the ones in between are dropped without decoding
+     * them.
+     *
+     * The last dropped line is kept for takeSkipped() which is called before
+     * logging any other output and once the program exited. That way the log
+     * still shows the progress right before an error.
+     */
+    class LIBK3B_EXPORT ProgressLineFilter
+    {
+    public:
+        /**
+         * @param interval The time between two logged progress lines in msecs.
+         */
+        explicit ProgressLineFilter( int interval = 1000 );
+
+        /**
+         * Starts over for a new run of the program.
+         */
+        void reset();
+
+        /**
+         * \return true if the progress line @p line is to be logged.
+         */
+        bool accept( const QByteArray& line );
+
+        /**
+         * \return The last progress line dropped since the last one which was
+         *         logged, or an empty array. The line is only returned once.
+         */
+        QByteArray takeSkipped();
+
+        /**
+         * \return The number of progress lines dropped since reset().
+         */
+        int skippedLines() const { return m_skippedLines; }
+
+    private:
+        int m_interval;
+        QElapsedTimer m_timer;
+        QByteArray m_skipped;
+        bool m_hasSkipped;
+        int m_skippedLines;
+    };
+
+
+    /**
+     * Track 01:   12 of  345 MB written (fifo 100%) [buf  99%]  16.2x.
+     */
+    LIBK3B_EXPORT ProgressEvent parseCdrecordProgress( const QByteArray& line );
+
+    /**
+     * 1234567168/4700000000 (26.3%) @3.9x, remaining 5:42 RBU 100.0% UBU  98.2%
+     */
+    LIBK3B_EXPORT ProgressEvent parseGrowisofsProgress( const QByteArray& line );
+
+    /**
+     * 52.31% done, estimate finish Mon Oct 19 12:00:00 2026
+     */
+    LIBK3B_EXPORT ProgressEvent parseMkisofsProgress( const QByteArray& line );
+
+    /**
+     * encoding=1 frame=1491 first=0 last=-1 fps=14.815 ...      (transcode >= 1.1)
+     * encoding frames [000000-000144],  27.58 fps, EMT: 0:00:05  (older versions)
+     */
+    LIBK3B_EXPORT ProgressEvent parseTranscodeProgress( const QByteArray& line );
+}
+
+#endif
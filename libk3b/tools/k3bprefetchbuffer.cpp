@@ -0,0 +1,638 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bprefetchbuffer.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QTimer>
+#include <QWaitCondition>
+
+#include <math.h>
+#include <string.h>
+
+
+namespace {
+    // the data is kept in chunks of this size which are spilled as a whole
+    const qint64 s_chunkSize = 1024*1024;
+
+    // the amount of data handed to the sink in one write call
+    const qint64 s_maxWriteSize = 32*2048;
+
+    // interval of the fill level updates and throughput samples
+    const int s_updateInterval = 500;        // msecs
+
+    // the variance of the source is determined over the last 10 seconds
+    const int s_varianceSamples = 20;
+
+    // the prediction of underruns uses the last 2 seconds
+    const int s_predictionSamples = 4;
+
+    // two minutes of fill levels
+    const int s_historySize = 240;
+
+    // the buffer covers this many seconds of writing, a source which varies
+    // by its average rate gets s_varianceCoverage seconds more
+    const double s_baseCoverage = 4.0;
+    const double s_varianceCoverage = 8.0;
+
+    const int s_underrunWarningTime = 5;     // secs
+
+    double average( const QList<double>& samples, int count )
+    {
+        const int n = qMin( count, samples.count() );
+        if( n == 0 )
+            return 0.0;
+        double sum = 0.0;
+        for( int i = samples.count() - n; i < samples.count(); ++i )
+            sum += samples[i];
+        return sum / n;
+    }
+
+    double standardDeviation( const QList<double>& samples, double mean )
+    {
+        if( samples.count() < 2 )
+            return 0.0;
+        double sum = 0.0;
+        Q_FOREACH( double s, samples )
+            sum += ( s - mean ) * ( s - mean );
+        return ::sqrt( sum / ( samples.count() - 1 ) );
+    }
+}
+
+
+class K3b::PrefetchBuffer::Private
+{
+public:
+    struct Chunk
+    {
+        Chunk()
+            : filled( 0 ),
+              readPos( 0 ),
+              spillOffset( -1 ),
+              spilling( false ) {
+            data.resize( s_chunkSize );
+        }
+
+        bool spilled() const { return spillOffset >= 0 && !spilling; }
+
+        // empty while the chunk is spilled, never reallocated otherwise
+        QByteArray data;
+        qint64 filled;
+        qint64 readPos;
+        qint64 spillOffset;
+        bool spilling;
+    };
+
+    class Feeder : public QThread
+    {
+    public:
+        explicit Feeder( Private* buffer )
+            : m_buffer( buffer ) {
+        }
+
+        void run() override;
+
+    private:
+        Private* m_buffer;
+    };
+
+    Private()
+        : minSize( 16*1024*1024 ),
+          maxSize( 64*1024*1024 ),
+          capacity( minSize ),
+          maxSpillSize( 0 ),
+          prefillLevel( 80 ),
+          sink( 0 ),
+          closeSink( false ),
+          feeder( this ),
+          ramChunks( 0 ),
+          spillChunks( 0 ),
+          spillEnd( 0 ),
+          spillFile( 0 ),
+          buffered( 0 ),
+          bytesIn( 0 ),
+          bytesOut( 0 ),
+          prefilled( false ),
+          closing( false ),
+          active( false ),
+          generation( 0 ),
+          lastIn( 0 ),
+          lastOut( 0 ),
+          warned( false ) {
+    }
+
+    ~Private() {
+        qDeleteAll( chunks );
+        delete spillFile;
+    }
+
+    bool prefillReached() const {
+        return buffered >= capacity * prefillLevel / 100 || !canAllocate();
+    }
+
+    bool canAllocate() const {
+        const qint64 ram = ramChunks * s_chunkSize;
+        if( ram < capacity )
+            return true;
+
+        // one chunk beyond the capacity is collected in memory and spilled once full
+        return ( !spillDir.isEmpty() &&
+                 ram < capacity + s_chunkSize &&
+                 spillEnd + s_chunkSize <= maxSpillSize );
+    }
+
+    // to be called with the mutex locked
+    void clear() {
+        qDeleteAll( chunks );
+        chunks.clear();
+        ramChunks = spillChunks = 0;
+        spillEnd = 0;
+        buffered = 0;
+        ++generation;
+
+        // wait for a spill in progress
+        spillMutex.lock();
+        delete spillFile;
+        spillFile = 0;
+        spillMutex.unlock();
+    }
+
+    // both are called with the mutex locked which they release during the file access
+    void spill( Chunk* chunk );
+    bool load( Chunk* chunk );
+
+    qint64 minSize;
+    qint64 maxSize;
+    qint64 capacity;
+
+    QString spillDir;
+    qint64 maxSpillSize;
+
+    int prefillLevel;
+
+    QIODevice* sink;
+    bool closeSink;
+
+    Feeder feeder;
+
+    // everything below is protected by the mutex
+    QList<Chunk*> chunks;
+    int ramChunks;
+    int spillChunks;
+    qint64 spillEnd;
+    QTemporaryFile* spillFile;
+    int generation;
+
+    qint64 buffered;
+    quint64 bytesIn;
+    quint64 bytesOut;
+
+    bool prefilled;
+    bool closing;
+    bool active;
+
+    mutable QMutex mutex;
+    QWaitCondition dataAvailable;
+    QWaitCondition spaceAvailable;
+
+    // only the spill file access is protected by this one
+    QMutex spillMutex;
+
+    // statistics, only used in the thread the buffer lives in
+    QTimer updateTimer;
+    QElapsedTimer clock;
+    quint64 lastIn;
+    quint64 lastOut;
+    QList<double> inRates;
+    QList<double> outRates;
+    QList<int> history;
+    bool warned;
+};
+
+
+void K3b::PrefetchBuffer::Private::spill( Chunk* chunk )
+{
+    chunk->spilling = true;
+    chunk->spillOffset = spillEnd;
+    spillEnd += s_chunkSize;
+    ++spillChunks;
+
+    // the chunk might be dropped by clear() while we are writing
+    const QByteArray data = chunk->data;
+    const qint64 offset = chunk->spillOffset;
+    const int gen = generation;
+
+    mutex.unlock();
+
+    bool success = false;
+    spillMutex.lock();
+    if( !spillFile ) {
+        spillFile = new QTemporaryFile( QDir( spillDir ).filePath( "k3bprefetch_XXXXXX" ) );
+        if( !spillFile->open() )
+            qDebug() << "(K3b::PrefetchBuffer) unable to create spill file in" << spillDir;
+    }
+    if( spillFile->isOpen() && spillFile->seek( offset ) )
+        success = ( spillFile->write( data ) == data.size() );
+    spillMutex.unlock();
+
+    mutex.lock();
+
+    if( gen != generation )
+        return;
+
+    chunk->spilling = false;
+    if( success ) {
+        chunk->data = QByteArray();
+        --ramChunks;
+    }
+    else {
+        // keep the chunk in memory and do not try again
+        qDebug() << "(K3b::PrefetchBuffer) spilling failed. Disabling it.";
+        chunk->spillOffset = -1;
+        --spillChunks;
+        maxSpillSize = 0;
+    }
+
+    dataAvailable.wakeAll();
+}
+
+
+bool K3b::PrefetchBuffer::Private::load( Chunk* chunk )
+{
+    const qint64 offset = chunk->spillOffset;
+    const qint64 size = chunk->filled;
+
+    mutex.unlock();
+
+    // only the feeder loads chunks and clear() is not called while it is running
+    QByteArray data( s_chunkSize, Qt::Uninitialized );
+    spillMutex.lock();
+    const bool success = ( spillFile->seek( offset ) &&
+                           spillFile->read( data.data(), size ) == size );
+    spillMutex.unlock();
+
+    mutex.lock();
+
+    if( !success ) {
+        qDebug() << "(K3b::PrefetchBuffer) reading from the spill file failed.";
+        return false;
+    }
+
+    chunk->data = data;
+    chunk->spillOffset = -1;
+    ++ramChunks;
+
+    // the spill file can be reused from the start once it is empty
+    if( --spillChunks == 0 )
+        spillEnd = 0;
+
+    return true;
+}
+
+
+void K3b::PrefetchBuffer::Private::Feeder::run()
+{
+    QMutexLocker locker( &m_buffer->mutex );
+
+    while( m_buffer->active ) {
+        Chunk* head = m_buffer->chunks.isEmpty() ? 0 : m_buffer->chunks.first();
+        if( !head && m_buffer->closing )
+            break;
+
+        if( !head ||
+            head->spilling ||
+            ( !m_buffer->prefilled && !m_buffer->closing ) ||
+            ( head->readPos == head->filled && !m_buffer->closing ) ) {
+            m_buffer->dataAvailable.wait( &m_buffer->mutex );
+            continue;
+        }
+
+        // the source is done with this one
+        if( head->readPos == head->filled ) {
+            m_buffer->chunks.removeFirst();
+            --m_buffer->ramChunks;
+            delete head;
+            continue;
+        }
+
+        if( head->spilled() && !m_buffer->load( head ) ) {
+            m_buffer->active = false;
+            break;
+        }
+
+        // the source only writes beyond head->filled and never reallocates the data
+        const char* data = head->data.constData() + head->readPos;
+        const qint64 len = qMin( head->filled - head->readPos, s_maxWriteSize );
+
+        locker.unlock();
+        const qint64 written = m_buffer->sink->write( data, len );
+        locker.relock();
+
+        if( written > 0 ) {
+            head->readPos += written;
+            m_buffer->buffered -= written;
+            m_buffer->bytesOut += written;
+
+            if( head->readPos == s_chunkSize ) {
+                m_buffer->chunks.removeFirst();
+                --m_buffer->ramChunks;
+                delete head;
+            }
+        }
+        else if( m_buffer->active ) {
+            qDebug() << "(K3b::PrefetchBuffer) write to" << m_buffer->sink << "failed:" << m_buffer->sink->errorString();
+            m_buffer->active = false;
+        }
+
+        m_buffer->spaceAvailable.wakeAll();
+    }
+
+    qDebug() << "(K3b::PrefetchBuffer) done after" << m_buffer->bytesOut << "bytes.";
+
+    // the source must not block on a buffer nobody reads from any longer
+    m_buffer->active = false;
+    m_buffer->spaceAvailable.wakeAll();
+}
+
+
+K3b::PrefetchBuffer::PrefetchBuffer( QObject* parent )
+    : QIODevice( parent ),
+      d( new Private() )
+{
+    d->updateTimer.setInterval( s_updateInterval );
+    connect( &d->updateTimer, SIGNAL(timeout()), this, SLOT(slotUpdate()) );
+    connect( &d->feeder, SIGNAL(finished()), this, SLOT(slotFeederFinished()) );
+}
+
+
+K3b::PrefetchBuffer::~PrefetchBuffer()
+{
+    abort();
+    d->feeder.wait();
+    delete d;
+}
+
+
+void K3b::PrefetchBuffer::setSize( qint64 minSize, qint64 maxSize )
+{
+    QMutexLocker locker( &d->mutex );
+    d->minSize = qMax( minSize, s_chunkSize );
+    d->maxSize = qMax( maxSize, d->minSize );
+    d->capacity = d->minSize;
+}
+
+
+void K3b::PrefetchBuffer::setSpillDirectory( const QString& dir, qint64 maxSize )
+{
+    QMutexLocker locker( &d->mutex );
+    d->spillDir = dir;
+    d->maxSpillSize = dir.isEmpty() ? 0 : maxSize;
+}
+
+
+void K3b::PrefetchBuffer::setPrefillLevel( int percent )
+{
+    QMutexLocker locker( &d->mutex );
+    d->prefillLevel = qBound( 0, percent, 100 );
+}
+
+
+void K3b::PrefetchBuffer::writeTo( QIODevice* dev, bool close )
+{
+    if( isOpen() )
+        return;
+
+    d->sink = dev;
+    d->closeSink = close;
+}
+
+
+bool K3b::PrefetchBuffer::open( OpenMode mode )
+{
+    if( isOpen() || !d->sink || !( mode & WriteOnly ) )
+        return false;
+
+    // a previous run might still be busy closing
+    d->feeder.wait();
+
+    if( !d->sink->isOpen() && !d->sink->open( QIODevice::WriteOnly ) ) {
+        qDebug() << "(K3b::PrefetchBuffer) unable to open" << d->sink;
+        return false;
+    }
+
+    d->clear();
+    d->capacity = d->minSize;
+    d->bytesIn = d->bytesOut = 0;
+    d->prefilled = ( d->prefillLevel == 0 );
+    d->closing = false;
+    d->active = true;
+
+    d->lastIn = d->lastOut = 0;
+    d->inRates.clear();
+    d->outRates.clear();
+    d->history.clear();
+    d->warned = false;
+
+    QIODevice::open( WriteOnly|Unbuffered );
+
+    d->clock.start();
+    d->updateTimer.start();
+    d->feeder.start();
+
+    return true;
+}
+
+
+void K3b::PrefetchBuffer::close()
+{
+    if( !isOpen() )
+        return;
+
+    QMutexLocker locker( &d->mutex );
+    d->closing = true;
+    d->dataAvailable.wakeAll();
+
+    // the buffer is closed in slotFeederFinished once the sink took the remaining data
+}
+
+
+void K3b::PrefetchBuffer::abort()
+{
+    QMutexLocker locker( &d->mutex );
+    d->active = false;
+    d->closing = true;
+    d->dataAvailable.wakeAll();
+    d->spaceAvailable.wakeAll();
+}
+
+
+qint64 K3b::PrefetchBuffer::capacity() const
+{
+    QMutexLocker locker( &d->mutex );
+    return d->capacity;
+}
+
+
+int K3b::PrefetchBuffer::fillLevel() const
+{
+    QMutexLocker locker( &d->mutex );
+    return qMin( 100, int( 100 * d->buffered / d->capacity ) );
+}
+
+
+QList<int> K3b::PrefetchBuffer::fillHistory() const
+{
+    return d->history;
+}
+
+
+void K3b::PrefetchBuffer::slotUpdate()
+{
+    d->mutex.lock();
+    const quint64 in = d->bytesIn;
+    const quint64 out = d->bytesOut;
+    const qint64 buffered = d->buffered;
+    const bool feeding = d->prefilled && !d->closing;
+    d->mutex.unlock();
+
+    const double secs = double( d->clock.restart() ) / 1000.0;
+    if( secs <= 0.0 )
+        return;
+
+    d->inRates.append( double( in - d->lastIn ) / secs );
+    d->outRates.append( double( out - d->lastOut ) / secs );
+    d->lastIn = in;
+    d->lastOut = out;
+    while( d->inRates.count() > s_varianceSamples ) {
+        d->inRates.removeFirst();
+        d->outRates.removeFirst();
+    }
+
+    const int level = fillLevel();
+    d->history.append( level );
+    while( d->history.count() > s_historySize )
+        d->history.removeFirst();
+
+    emit fillLevelChanged( level );
+    emit sourceRate( int( d->inRates.last() / 1024.0 ) );
+
+    // nothing to adapt to before the sink has been fed or after the source finished
+    if( !feeding )
+        return;
+
+    const double outRate = average( d->outRates, s_varianceSamples );
+    if( outRate <= 0.0 )
+        return;
+
+    //
+    // Adapt the size to the variance of the source: a steady source only
+    // needs to cover short hiccups, a bursty one needs to cover long gaps.
+    //
+    const double inMean = average( d->inRates, s_varianceSamples );
+    const double variation = ( inMean > 0.0 ? qMin( 2.0, standardDeviation( d->inRates, inMean ) / inMean ) : 2.0 );
+    qint64 size = qint64( outRate * ( s_baseCoverage + s_varianceCoverage * variation ) );
+    size = qBound( d->minSize, ( size + s_chunkSize - 1 ) / s_chunkSize * s_chunkSize, d->maxSize );
+
+    d->mutex.lock();
+    if( size != d->capacity ) {
+        qDebug() << "(K3b::PrefetchBuffer) resizing from" << d->capacity << "to" << size << "bytes.";
+        d->capacity = size;
+        d->spaceAvailable.wakeAll();
+    }
+    d->mutex.unlock();
+
+    //
+    // Predict when the buffer runs empty if the source stays slower than the sink
+    //
+    const double drain = average( d->outRates, s_predictionSamples ) - average( d->inRates, s_predictionSamples );
+    if( drain > 0.0 && !d->warned ) {
+        const double left = double( buffered ) / drain;
+        if( left < s_underrunWarningTime ) {
+            qDebug() << "(K3b::PrefetchBuffer) buffer will run empty in" << left << "seconds.";
+            d->warned = true;
+            emit underrunImminent( int( left ) );
+        }
+    }
+    else if( d->warned && level >= 50 ) {
+        d->warned = false;
+    }
+}
+
+
+void K3b::PrefetchBuffer::slotFeederFinished()
+{
+    d->updateTimer.stop();
+
+    if( d->closeSink && d->sink->isOpen() )
+        d->sink->close();
+
+    d->mutex.lock();
+    d->clear();
+    d->mutex.unlock();
+
+    QIODevice::close();
+}
+
+
+qint64 K3b::PrefetchBuffer::readData( char*, qint64 )
+{
+    return -1;
+}
+
+
+qint64 K3b::PrefetchBuffer::writeData( const char* data, qint64 max )
+{
+    QMutexLocker locker( &d->mutex );
+
+    qint64 written = 0;
+    while( written < max ) {
+        Private::Chunk* tail = d->chunks.isEmpty() ? 0 : d->chunks.last();
+        if( d->active && ( !tail || tail->filled == s_chunkSize ) ) {
+            while( d->active && !d->canAllocate() )
+                d->spaceAvailable.wait( &d->mutex );
+
+            if( d->active ) {
+                tail = new Private::Chunk();
+                d->chunks.append( tail );
+                ++d->ramChunks;
+            }
+        }
+
+        if( !d->active ) {
+            qDebug() << "(K3b::PrefetchBuffer) the sink is gone.";
+            return written > 0 ? written : -1;
+        }
+
+        // the feeder might be writing the data before tail->filled to the sink
+        const qint64 len = qMin( max - written, s_chunkSize - tail->filled );
+        ::memcpy( tail->data.data() + tail->filled, data + written, len );
+        tail->filled += len;
+        written += len;
+        d->buffered += len;
+        d->bytesIn += len;
+
+        if( !d->prefilled && d->prefillReached() )
+            d->prefilled = true;
+
+        // keep the chunks next in line in memory
+        if( tail->filled == s_chunkSize &&
+            tail != d->chunks.first() &&
+            d->ramChunks * s_chunkSize > d->capacity )
+            d->spill( tail );
+
+        d->dataAvailable.wakeAll();
+    }
+
+    return written;
+}
+
+#include "moc_k3bprefetchbuffer.cpp"
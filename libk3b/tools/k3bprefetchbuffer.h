@@ -0,0 +1,138 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_PREFETCH_BUFFER_H_
+#define _K3B_PREFETCH_BUFFER_H_
+
+#include "k3b_export.h"
+
+#include <QIODevice>
+#include <QList>
+
+
+namespace K3b {
+    /**
+     * The PrefetchBuffer is put between the source and the writer when
+     * writing on-the-fly. It holds back the data until it has been filled
+     * to the prefill level and then feeds the sink from a thread of its own.
+     * Thus short stalls of the source (a slow file system, a busy decoder,
+     * a hard to read sector) do not reach the writer.
+     *
+     * The size of the buffer adapts to the data rate of the sink and the
+     * variance of the data rate of the source. It starts with the minimum
+     * size and grows up to the maximum size if the source is unsteady.
+     * Optionally data which does not fit into memory is spilled to a
+     * temporary file.
+     *
+     * Once the buffer is predicted to run empty within a few seconds the
+     * underrunImminent() signal is emitted which gives the job the chance
+     * to lower the writing speed.
+     */
+    class LIBK3B_EXPORT PrefetchBuffer : public QIODevice
+    {
+        Q_OBJECT
+
+    public:
+        explicit PrefetchBuffer( QObject* parent = 0 );
+        ~PrefetchBuffer() override;
+
+        /**
+         * Set the bounds of the memory used for buffering in bytes.
+         * Defaults to 16 MB and 64 MB.
+         */
+        void setSize( qint64 minSize, qint64 maxSize );
+
+        /**
+         * Spill the data which does not fit into memory to a temporary
+         * file in @p dir using at most @p maxSize bytes. An empty
+         * directory disables spilling (the default).
+         */
+        void setSpillDirectory( const QString& dir, qint64 maxSize );
+
+        /**
+         * The sink is only fed once the buffer has been filled to this level
+         * (or the end of the data has been reached). Defaults to 80 percent.
+         */
+        void setPrefillLevel( int percent );
+
+        /**
+         * Set the sink. The device will be opened QIODevice::WriteOnly if
+         * necessary.
+         *
+         * \param close If true the device will be closed once all data has
+         *              been written to it.
+         */
+        void writeTo( QIODevice* dev, bool close = false );
+
+        /**
+         * Opens the buffer and starts the feeding thread.
+         */
+        bool open( OpenMode mode = WriteOnly ) override;
+
+        /**
+         * Signals the end of the data. Returns immediately, the buffer is
+         * closed once the remaining data has been written to the sink.
+         */
+        void close() override;
+
+        /**
+         * Drops the buffered data and stops feeding the sink. Writing to
+         * the buffer fails afterwards.
+         */
+        void abort();
+
+        bool isSequential() const override { return true; }
+
+        /**
+         * The current size of the memory buffer in bytes.
+         */
+        qint64 capacity() const;
+
+        /**
+         * \return The fill level of the memory buffer in percent.
+         */
+        int fillLevel() const;
+
+        /**
+         * The fill levels of the last two minutes, one value for every
+         * fillLevelChanged() signal.
+         */
+        QList<int> fillHistory() const;
+
+    Q_SIGNALS:
+        /**
+         * Emitted every half second while the buffer is open.
+         */
+        void fillLevelChanged( int level );
+
+        /**
+         * The rate at which the source delivered its data during the last
+         * half second in KB/s. Emitted along with fillLevelChanged().
+         */
+        void sourceRate( int kbs );
+
+        /**
+         * Emitted once the buffer is predicted to run empty within
+         * @p seconds because the source is slower than the sink. It is
+         * emitted again only after the buffer recovered.
+         */
+        void underrunImminent( int seconds );
+
+    private Q_SLOTS:
+        void slotUpdate();
+        void slotFeederFinished();
+
+    protected:
+        qint64 readData( char* data, qint64 max ) override;
+        qint64 writeData( const char* data, qint64 max ) override;
+
+    private:
+        class Private;
+        Private* const d;
+    };
+}
+
+#endif
@@ -11,67 +11,64 @@
 
 #include <QByteArray>
 #include <QDebug>
+#include <QMetaMethod>
 #include <QStringList>
 
 
 namespace {
-    QStringList splitOutput( const QByteArray& data,
-                             QString& unfinishedLine,
-                             bool suppressEmptyLines )
+    //
+    // The stderr splitting is mainly used for parsing of messages
+    // That's why we simplify the data before proceeding:
+    // backspaces and carriage returns end a line and tabs are replaced with a space.
+    //
+    // This is done in a single pass over the raw data, lines are only decoded
+    // once somebody wants them as strings.
+    //
+    template<typename LineHandler>
+    void splitOutput( const QByteArray& data,
+                      QByteArray& unfinishedLine,
+                      bool suppressEmptyLines,
+                      LineHandler handleLine )
     {
-        //
-        // The stderr splitting is mainly used for parsing of messages
-        // That's why we simplify the data before proceeding
-        //
-        int len = data.length();
-
-        QByteArray buffer;
-        for( int i = 0; i < len; i++ ) {
-            if( data[i] == '\b' ) {
-                while( i < len &&
-                       data[i] == '\b' )  // we replace multiple backspaces with a single line feed
-                    i++;
-                buffer += '\n';
-            }
-            if ( i < len ) {
-                if( data[i] == '\r' )
-                    buffer += '\n';
-                else if( data[i] == '\t' )  // replace tabs with a single space
-                    buffer += ' ';
-                else
-                    buffer += data[i];
-            }
-        }
+        const char* p = data.constData();
+        const char* end = p + data.size();
 
-        QStringList lines = QString::fromLocal8Bit( buffer ).split( '\n', suppressEmptyLines ? Qt::SkipEmptyParts : Qt::KeepEmptyParts );
+        while( p < end ) {
+            const char* start = p;
+            while( p < end && *p != '\n' && *p != '\r' && *p != '\b' && *p != '\t' )
+                ++p;
+            unfinishedLine.append( start, p - start );
 
-        // in case we suppress empty lines we need to handle the following separately
-        // to make sure we join unfinished lines correctly
-        if( suppressEmptyLines && buffer.startsWith( '\n' ) )
-            lines.prepend( QString() );
-
-        if( !unfinishedLine.isEmpty() ) {
-            lines.first().prepend( unfinishedLine );
-            unfinishedLine.truncate(0);
+            if( p == end )
+                break;
 
-            qDebug() << "(K3b::Process)           joined line: '" << (lines.first()) << "'";
+            const char c = *p++;
+            if( c == '\t' ) {
+                unfinishedLine.append( ' ' );
+            }
+            else {
+                // we replace multiple backspaces with a single line feed
+                if( c == '\b' ) {
+                    while( p < end && *p == '\b' )
+                        ++p;
+                }
+
+                if( !suppressEmptyLines || !unfinishedLine.isEmpty() )
+                    handleLine( unfinishedLine );
+                unfinishedLine.resize( 0 );
+            }
         }
 
-        QStringList::iterator it;
-
-        // check if line ends with a newline
-        // if not save the last line because it is not finished
-        if ( !buffer.isEmpty() ) {
-            const auto c = buffer[buffer.length()-1];
-            bool hasUnfinishedLine = ( c != '\n' && c != '\r' && QChar( c ) != QChar(46) );  // What is unicode 46?? It is printed as a point
-            if( hasUnfinishedLine ) {
-                qDebug() << "(K3b::Process) found unfinished line: '" << lines.last() << "'";
-                qDebug() << "(K3b::Process)             last char: '" << buffer.right(1) << "'";
-                unfinishedLine = lines.takeLast();
+        // a line which ends in a point is considered finished
+        if( !unfinishedLine.isEmpty() ) {
+            if( unfinishedLine.endsWith( '.' ) ) {
+                handleLine( unfinishedLine );
+                unfinishedLine.resize( 0 );
+            }
+            else {
+                qDebug() << "(K3b::Process) found unfinished line: '" << unfinishedLine << "'";
             }
         }
-
-        return lines;
     }
 }
 
@@ -79,8 +76,8 @@ namespace {
 class K3b::Process::Private
 {
 public:
-    QString unfinishedStdoutLine;
-    QString unfinishedStderrLine;
+    QByteArray unfinishedStdoutLine;
+    QByteArray unfinishedStderrLine;
 
     bool suppressEmptyLines;
 
@@ -142,34 +139,26 @@ void K3b::Process::setSplitStdout( bool b )
 void K3b::Process::slotReadyReadStandardOutput()
 {
     if( d->bSplitStdout ) {
-        QStringList lines = splitOutput( readAllStandardOutput(), d->unfinishedStdoutLine, d->suppressEmptyLines );
-
-        for( QStringList::iterator it = lines.begin(); it != lines.end(); ++it ) {
-            QString& str = *it;
-
-            // just to be sure since something in splitOutput does not do this right
-            if( d->suppressEmptyLines && str.isEmpty() )
-                continue;
-
-            emit stdoutLine( str );
-        }
+        const bool decode = isSignalConnected( QMetaMethod::fromSignal( &K3b::Process::stdoutLine ) );
+        splitOutput( readAllStandardOutput(), d->unfinishedStdoutLine, d->suppressEmptyLines,
+                     [this,decode]( const QByteArray& line ) {
+                         emit rawStdoutLine( line );
+                         if( decode )
+                             emit stdoutLine( QString::fromLocal8Bit( line ) );
+                     } );
     }
 }
 
 
 void K3b::Process::slotReadyReadStandardError()
 {
-    QStringList lines = splitOutput( readAllStandardError(), d->unfinishedStderrLine, d->suppressEmptyLines );
-
-    for( QStringList::iterator it = lines.begin(); it != lines.end(); ++it ) {
-        QString& str = *it;
-
-        // just to be sure since something in splitOutput does not do this right
-        if( d->suppressEmptyLines && str.isEmpty() )
-            continue;
-
-        emit stderrLine( str );
-    }
+    const bool decode = isSignalConnected( QMetaMethod::fromSignal( &K3b::Process::stderrLine ) );
+    splitOutput( readAllStandardError(), d->unfinishedStderrLine, d->suppressEmptyLines,
+                 [this,decode]( const QByteArray& line ) {
+                     emit rawStderrLine( line );
+                     if( decode )
+                         emit stderrLine( QString::fromLocal8Bit( line ) );
+                 } );
 }
 
 
@@ -80,6 +80,14 @@ namespace K3b {
         void stderrLine( const QString& line );
         void stdoutLine( const QString& line );
 
+        /**
+         * The lines of stderrLine() and stdoutLine() before they are decoded.
+         * Lines are only decoded if stderrLine() or stdoutLine() are connected,
+         * thus parsers of frequent output like progress lines should use these.
+         */
+        void rawStderrLine( const QByteArray& line );
+        void rawStdoutLine( const QByteArray& line );
+
     private:
         class Private;
         Private* const d;
@@ -913,6 +913,18 @@ void K3bQProcess::setFlags( K3bQProcess::ProcessFlags flags )
     d->processFlags = flags;
 }
 
+int K3bQProcess::rawStdinHandle() const
+{
+#ifdef Q_OS_UNIX
+    Q_D(const K3bQProcess);
+    if ((d->processFlags & K3bQProcess::RawStdin)
+        && d->processState == ::QProcess::Running
+        && !d->stdinChannel.closed)
+        return d->stdinChannel.pipe[1];
+#endif
+    return -1;
+}
+
 /*!
     \obsolete
     Returns the read channel mode of the QProcess. This function is
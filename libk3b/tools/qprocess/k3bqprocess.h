@@ -163,6 +163,13 @@ public:
 
     bool isReadyWrite() const;
 
+    /**
+     * The write end of the stdin pipe of the running process if the RawStdin
+     * flag is set, -1 otherwise. Allows to move data into the process
+     * without copying it through user space.
+     */
+    int rawStdinHandle() const;
+
     static bool startDetached(const QString &program, const QStringList &arguments, const QString &workingDirectory,
                               qint64 *pid = 0);
     static bool startDetached(const QString &program, const QStringList &arguments);
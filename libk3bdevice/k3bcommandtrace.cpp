@@ -0,0 +1,347 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "k3bcommandtrace.h"
+#include "k3bscsicommand.h"
+
+#include <QAtomicInteger>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QStringList>
+#include <QtAlgorithms>
+
+#include <atomic>
+
+
+namespace {
+    const quint32 s_traceMagic = 0x4b334254; // "K3BT"
+    const quint16 s_traceVersion = 1;
+
+    QAtomicInt s_enabled( 1 );
+
+    int histogramBucket( quint32 duration )
+    {
+        // the number of significant bits is the (rounded up) log2 of the duration
+        const int bits = 32 - qCountLeadingZeroBits( duration );
+        return qMin( bits, int( K3b::Device::CommandTrace::HistogramBuckets - 1 ) );
+    }
+}
+
+
+class K3b::Device::CommandTrace::Private
+{
+public:
+    //
+    // The slots are written like a seqlock: the sequence is odd while the
+    // record is being written and 2n+2 once the n-th command is complete.
+    // Readers drop slots whose sequence changed while copying them.
+    //
+    struct Slot {
+        QAtomicInteger<quint64> sequence;
+        QAtomicInteger<qint64> timestamp;
+        QAtomicInteger<quint32> duration;
+        QAtomicInteger<quint32> transferLength;
+        QAtomicInteger<qint32> result;
+        QAtomicInteger<quint32> opcodeAndSense;
+    };
+
+    struct Counter {
+        QAtomicInteger<quint64> count;
+        QAtomicInteger<quint64> failures;
+        QAtomicInteger<quint64> bytes;
+        QAtomicInteger<quint64> totalDuration;
+        QAtomicInteger<quint32> maxDuration;
+        QAtomicInteger<quint32> histogram[HistogramBuckets];
+    };
+
+    QElapsedTimer clock;
+    QAtomicInteger<quint64> next;
+    Slot ring[RingSize];
+    Counter counters[256];
+};
+
+
+K3b::Device::CommandTrace::Statistics::Statistics()
+    : count( 0 ),
+      failures( 0 ),
+      bytes( 0 ),
+      totalDuration( 0 ),
+      maxDuration( 0 ),
+      histogram( HistogramBuckets, 0 )
+{
+}
+
+
+quint32 K3b::Device::CommandTrace::Statistics::percentile( int percent ) const
+{
+    quint64 sum = 0;
+    for( int i = 0; i < histogram.count() - 1; ++i ) {
+        sum += histogram[i];
+        if( sum*100 >= count*quint64( percent ) )
+            return qMin( quint32( 1 ) << i, maxDuration );
+    }
+    return maxDuration;
+}
+
+
+K3b::Device::CommandTrace::Snapshot::Snapshot()
+    : sequence( 0 )
+{
+}
+
+
+K3b::Device::CommandTrace::CommandTrace()
+    : d( new Private )
+{
+    d->clock.start();
+}
+
+
+K3b::Device::CommandTrace::~CommandTrace()
+{
+    delete d;
+}
+
+
+void K3b::Device::CommandTrace::record( unsigned char opcode,
+                                        quint32 transferLength,
+                                        quint32 duration,
+                                        int result,
+                                        unsigned char senseKey,
+                                        unsigned char asc,
+                                        unsigned char ascq )
+{
+    if( !s_enabled.loadRelaxed() )
+        return;
+
+    if( result == 0 )
+        senseKey = asc = ascq = 0;
+
+    Private::Counter& counter = d->counters[opcode];
+    counter.count.fetchAndAddRelaxed( 1 );
+    if( result != 0 )
+        counter.failures.fetchAndAddRelaxed( 1 );
+    else
+        counter.bytes.fetchAndAddRelaxed( transferLength );
+    counter.totalDuration.fetchAndAddRelaxed( duration );
+    counter.histogram[histogramBucket( duration )].fetchAndAddRelaxed( 1 );
+    quint32 max = counter.maxDuration.loadRelaxed();
+    while( duration > max && !counter.maxDuration.testAndSetRelaxed( max, duration, max ) ) {}
+
+    const quint64 n = d->next.fetchAndAddRelaxed( 1 );
+    Private::Slot& slot = d->ring[n % RingSize];
+    slot.sequence.storeRelaxed( 2*n + 1 );
+    std::atomic_thread_fence( std::memory_order_release );
+    slot.timestamp.storeRelaxed( d->clock.nsecsElapsed()/1000 - duration );
+    slot.duration.storeRelaxed( duration );
+    slot.transferLength.storeRelaxed( transferLength );
+    slot.result.storeRelaxed( result );
+    slot.opcodeAndSense.storeRelaxed( quint32( opcode ) << 24 | quint32( senseKey ) << 16 | quint32( asc ) << 8 | ascq );
+    slot.sequence.storeRelease( 2*n + 2 );
+}
+
+
+K3b::Device::CommandTrace::Snapshot K3b::Device::CommandTrace::snapshot() const
+{
+    Snapshot s;
+    s.sequence = d->next.loadAcquire();
+    for( int i = 0; i < 256; ++i ) {
+        if( d->counters[i].count.loadRelaxed() > 0 )
+            s.statistics.insert( i, statistics( i ) );
+    }
+    return s;
+}
+
+
+QList<K3b::Device::CommandTrace::Record> K3b::Device::CommandTrace::records( const Snapshot& since ) const
+{
+    QList<Record> records;
+
+    const quint64 next = d->next.loadAcquire();
+    const quint64 first = qMax( since.sequence, next > quint64( RingSize ) ? next - RingSize : 0 );
+    for( quint64 n = first; n < next; ++n ) {
+        const Private::Slot& slot = d->ring[n % RingSize];
+        const quint64 sequence = slot.sequence.loadAcquire();
+        if( sequence != 2*n + 2 )
+            continue;
+
+        Record r;
+        r.timestamp = slot.timestamp.loadRelaxed();
+        r.duration = slot.duration.loadRelaxed();
+        r.transferLength = slot.transferLength.loadRelaxed();
+        r.result = slot.result.loadRelaxed();
+        const quint32 opcodeAndSense = slot.opcodeAndSense.loadRelaxed();
+        r.opcode = opcodeAndSense >> 24;
+        r.senseKey = opcodeAndSense >> 16;
+        r.asc = opcodeAndSense >> 8;
+        r.ascq = opcodeAndSense;
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+        if( slot.sequence.loadRelaxed() == sequence )
+            records.append( r );
+    }
+
+    return records;
+}
+
+
+QList<unsigned char> K3b::Device::CommandTrace::opcodes( const Snapshot& since ) const
+{
+    QList<unsigned char> list;
+    for( int i = 0; i < 256; ++i ) {
+        if( d->counters[i].count.loadRelaxed() > since.statistics.value( i ).count )
+            list.append( i );
+    }
+    return list;
+}
+
+
+K3b::Device::CommandTrace::Statistics K3b::Device::CommandTrace::statistics( unsigned char opcode, const Snapshot& since ) const
+{
+    const Private::Counter& counter = d->counters[opcode];
+
+    Statistics s;
+    s.count = counter.count.loadRelaxed();
+    s.failures = counter.failures.loadRelaxed();
+    s.bytes = counter.bytes.loadRelaxed();
+    s.totalDuration = counter.totalDuration.loadRelaxed();
+    s.maxDuration = counter.maxDuration.loadRelaxed();
+    for( int i = 0; i < HistogramBuckets; ++i )
+        s.histogram[i] = counter.histogram[i].loadRelaxed();
+
+    QHash<unsigned char, Statistics>::const_iterator it = since.statistics.constFind( opcode );
+    if( it != since.statistics.constEnd() && it->count <= s.count ) {
+        s.count -= it->count;
+        s.failures -= qMin( it->failures, s.failures );
+        s.bytes -= qMin( it->bytes, s.bytes );
+        s.totalDuration -= qMin( it->totalDuration, s.totalDuration );
+        for( int i = 0; i < HistogramBuckets; ++i )
+            s.histogram[i] -= qMin( it->histogram[i], s.histogram[i] );
+    }
+    if( since.sequence > 0 ) {
+        s.maxDuration = 0;
+        Q_FOREACH( const Record& r, records( since ) ) {
+            if( r.opcode == opcode )
+                s.maxDuration = qMax( s.maxDuration, r.duration );
+        }
+    }
+
+    return s;
+}
+
+
+quint64 K3b::Device::CommandTrace::commands( const Snapshot& since ) const
+{
+    quint64 count = 0;
+    for( int i = 0; i < 256; ++i )
+        count += d->counters[i].count.loadRelaxed();
+
+    quint64 before = 0;
+    Q_FOREACH( const Statistics& s, since.statistics )
+        before += s.count;
+
+    return count - qMin( before, count );
+}
+
+
+void K3b::Device::CommandTrace::reset()
+{
+    for( int i = 0; i < 256; ++i ) {
+        Private::Counter& counter = d->counters[i];
+        counter.count.storeRelaxed( 0 );
+        counter.failures.storeRelaxed( 0 );
+        counter.bytes.storeRelaxed( 0 );
+        counter.totalDuration.storeRelaxed( 0 );
+        counter.maxDuration.storeRelaxed( 0 );
+        for( int j = 0; j < HistogramBuckets; ++j )
+            counter.histogram[j].storeRelaxed( 0 );
+    }
+    for( int i = 0; i < RingSize; ++i )
+        d->ring[i].sequence.storeRelaxed( 0 );
+    d->next.storeRelease( 0 );
+}
+
+
+QString K3b::Device::CommandTrace::toString( const Snapshot& since ) const
+{
+    QStringList lines;
+    lines << QString( "%1 %2 %3 %4 %5 %6 %7 %8" )
+        .arg( "Command", -30 )
+        .arg( "Count", 8 )
+        .arg( "Failed", 7 )
+        .arg( "KiB", 10 )
+        .arg( "Avg us", 9 )
+        .arg( "p50 us", 9 )
+        .arg( "p99 us", 9 )
+        .arg( "Max us", 9 );
+
+    Q_FOREACH( unsigned char opcode, opcodes( since ) ) {
+        const Statistics s = statistics( opcode, since );
+        lines << QString( "%1 %2 %3 %4 %5 %6 %7 %8" )
+            .arg( QString( "%1 (%2)" ).arg( commandString( opcode ) ).arg( QString::number( opcode, 16 ) ), -30 )
+            .arg( s.count, 8 )
+            .arg( s.failures, 7 )
+            .arg( s.bytes/1024, 10 )
+            .arg( s.count > 0 ? s.totalDuration/s.count : 0, 9 )
+            .arg( s.percentile( 50 ), 9 )
+            .arg( s.percentile( 99 ), 9 )
+            .arg( s.maxDuration, 9 );
+    }
+
+    return lines.join( "\n" );
+}
+
+
+bool K3b::Device::CommandTrace::save( QIODevice* dev, const Snapshot& since ) const
+{
+    const QList<Record> list = records( since );
+
+    QDataStream s( dev );
+    s.setVersion( QDataStream::Qt_5_15 );
+    s << s_traceMagic << s_traceVersion << quint32( list.count() );
+    Q_FOREACH( const Record& r, list ) {
+        s << r.timestamp << r.duration << r.transferLength << r.result
+          << r.opcode << r.senseKey << r.asc << r.ascq;
+    }
+
+    return s.status() == QDataStream::Ok;
+}
+
+
+bool K3b::Device::CommandTrace::load( QIODevice* dev, QList<Record>& records )
+{
+    QDataStream s( dev );
+    s.setVersion( QDataStream::Qt_5_15 );
+
+    quint32 magic = 0;
+    quint16 version = 0;
+    quint32 count = 0;
+    s >> magic >> version >> count;
+    if( s.status() != QDataStream::Ok || magic != s_traceMagic || version != s_traceVersion )
+        return false;
+
+    records.clear();
+    for( quint32 i = 0; i < count && s.status() == QDataStream::Ok; ++i ) {
+        Record r;
+        s >> r.timestamp >> r.duration >> r.transferLength >> r.result
+          >> r.opcode >> r.senseKey >> r.asc >> r.ascq;
+        records.append( r );
+    }
+
+    return s.status() == QDataStream::Ok;
+}
+
+
+void K3b::Device::CommandTrace::setEnabled( bool enabled )
+{
+    s_enabled.storeRelaxed( enabled ? 1 : 0 );
+}
+
+
+bool K3b::Device::CommandTrace::isEnabled()
+{
+    return s_enabled.loadRelaxed();
+}
@@ -0,0 +1,171 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef _K3B_COMMAND_TRACE_H_
+#define _K3B_COMMAND_TRACE_H_
+
+#include "k3bdevice_export.h"
+
+#include <qglobal.h>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+class QIODevice;
+
+namespace K3b {
+    namespace Device
+    {
+        /**
+         * The CommandTrace records the commands sent to a device.
+         *
+         * Every command is stored in a ring buffer which keeps the last
+         * RingSize commands. In addition per-opcode counters and a latency
+         * histogram are maintained over the whole lifetime of the trace.
+         *
+         * Recording does neither lock nor allocate memory so it is cheap enough
+         * to be enabled all the time. Readers get a consistent snapshot of the
+         * records, commands which are being recorded at the same time may be
+         * missing from it.
+         *
+         * To look at the commands of a certain period only, take a snapshot()
+         * at its start and pass it to the reading methods. Unlike reset() this
+         * is safe while commands are being recorded.
+         *
+         * Each Device has its own trace, see Device::commandTrace().
+         */
+        class LIBK3BDEVICE_EXPORT CommandTrace
+        {
+        public:
+            enum {
+                RingSize = 1024,
+
+                /**
+                 * Bucket 0 counts commands which took less than 1 microsecond,
+                 * bucket n those which took less than 2^n microseconds. The last
+                 * bucket counts all commands which took longer.
+                 */
+                HistogramBuckets = 24
+            };
+
+            struct Record {
+                qint64 timestamp;        /**< start of the command in microseconds since the trace was created */
+                quint32 duration;        /**< in microseconds */
+                quint32 transferLength;  /**< in bytes */
+                qint32 result;           /**< 0 on success */
+                quint8 opcode;
+                quint8 senseKey;
+                quint8 asc;
+                quint8 ascq;
+            };
+
+            struct Statistics {
+                Statistics();
+
+                /**
+                 * \return An estimation of the duration (in microseconds) which
+                 *         @p percent of the commands did not exceed.
+                 */
+                quint32 percentile( int percent ) const;
+
+                quint64 count;
+                quint64 failures;
+                quint64 bytes;
+                quint64 totalDuration;
+                quint32 maxDuration;
+                QVector<quint64> histogram;
+            };
+
+            /**
+             * The state of the trace at a certain point in time.
+             * A default constructed snapshot is the state after the last reset.
+             */
+            struct Snapshot {
+                Snapshot();
+
+                quint64 sequence;  /**< the number of commands recorded before */
+                QHash<unsigned char, Statistics> statistics;
+            };
+
+            CommandTrace();
+            ~CommandTrace();
+
+            /**
+             * Record a finished command. The sense data is ignored if @p result is 0.
+             *
+             * This is called by ScsiCommand and ReadQueue. It may be called from
+             * several threads at the same time.
+             */
+            void record( unsigned char opcode,
+                         quint32 transferLength,
+                         quint32 duration,
+                         int result,
+                         unsigned char senseKey = 0,
+                         unsigned char asc = 0,
+                         unsigned char ascq = 0 );
+
+            Snapshot snapshot() const;
+
+            /**
+             * \return The last recorded commands since @p since, oldest first.
+             */
+            QList<Record> records( const Snapshot& since = Snapshot() ) const;
+
+            /**
+             * \return The opcodes which have been recorded since @p since.
+             */
+            QList<unsigned char> opcodes( const Snapshot& since = Snapshot() ) const;
+
+            /**
+             * The maximum duration of a statistics since a snapshot is taken from
+             * the records which are still kept.
+             */
+            Statistics statistics( unsigned char opcode, const Snapshot& since = Snapshot() ) const;
+
+            /**
+             * \return The number of commands recorded since @p since.
+             */
+            quint64 commands( const Snapshot& since = Snapshot() ) const;
+
+            /**
+             * Clear the records and statistics. Must not be called while commands
+             * are being recorded.
+             */
+            void reset();
+
+            /**
+             * \return A human readable table of the per-opcode statistics.
+             */
+            QString toString( const Snapshot& since = Snapshot() ) const;
+
+            /**
+             * Write the records to @p dev in the binary trace format.
+             */
+            bool save( QIODevice* dev, const Snapshot& since = Snapshot() ) const;
+
+            /**
+             * Read records written by save().
+             */
+            static bool load( QIODevice* dev, QList<Record>& records );
+
+            /**
+             * Enable or disable the recording of commands for all devices.
+             *
+             * Default is enabled.
+             */
+            static void setEnabled( bool enabled );
+            static bool isEnabled();
+
+        private:
+            class Private;
+            Private* const d;
+
+            Q_DISABLE_COPY( CommandTrace )
+        };
+    }
+}
+
+#endif
@@ -11,6 +11,7 @@
 #include "k3bmmc.h"
 #include "k3bscsicommand.h"
 #include "k3bcrc.h"
+#include "k3bcommandtrace.h"
 
 #include "config-k3b.h"
 
@@ -25,7 +26,9 @@
 #include <qglobal.h>
 #include <QDebug>
 #include <QFile>
+#include <QHash>
 #include <QMutex>
+#include <QSet>
 #include <QStringList>
 
 #include <sys/types.h>
@@ -52,6 +55,8 @@ typedef unsigned char u8;
 #undef __STRICT_ANSI__
 #include <linux/cdrom.h>
 #define __STRICT_ANSI__
+#include <scsi/sg.h>
+#include <sys/mount.h>
 
 #endif // Q_OS_LINUX
 
@@ -105,6 +110,9 @@ namespace {
         else
             return 3324;
     }
+
+    // larger transfers do not make optical drives any faster
+    const int s_maxTransferLength = 1024*1024;
 }
 
 class K3b::Device::Device::Private
@@ -113,6 +121,9 @@ public:
     Private()
         : deviceHandle(HANDLE_DEFAULT_VALUE),
           openedReadWrite(false),
+          handleReferences(0),
+          handleOwners(0),
+          maxTransferLength(0),
           burnfree(false) {
     }
 
@@ -121,6 +132,7 @@ public:
     QString vendor;
     QString description;
     QString version;
+    QString serialNumber;
     int maxReadSpeed;
     int maxWriteSpeed;
     int currentWriteSpeed;
@@ -139,10 +151,17 @@ public:
     MediaTypes supportedProfiles;
     Handle deviceHandle;
     bool openedReadWrite;
+    int handleReferences;
+    int handleOwners;
+    QSet<QByteArray> twoStepCommands;
+    QMutex twoStepMutex;
+    int maxTransferLength;
     bool burnfree;
 
     QMutex mutex;
     QMutex openCloseMutex;
+
+    CommandTrace commandTrace;
 };
 
 #ifdef Q_OS_FREEBSD
@@ -281,6 +300,12 @@ QString K3b::Device::Device::version() const
 }
 
 
+QString K3b::Device::Device::serialNumber() const
+{
+    return d->serialNumber;
+}
+
+
 bool K3b::Device::Device::dvdMinusTestwrite() const
 {
     return d->dvdMinusTestwrite;
@@ -305,6 +330,50 @@ int K3b::Device::Device::bufferSize() const
 }
 
 
+K3b::Device::CommandTrace* K3b::Device::Device::commandTrace() const
+{
+    return &d->commandTrace;
+}
+
+
+int K3b::Device::Device::maxTransferLength() const
+{
+    if( d->maxTransferLength > 0 )
+        return d->maxTransferLength;
+
+    int len = 0;
+    HandleReference ref( this );
+#ifdef Q_OS_LINUX
+    if( ref.isValid() ) {
+        unsigned short sectors = 0;
+        int reservedSize = 0;
+        if( ::ioctl( handle(), BLKSECTGET, &sectors ) == 0 && sectors > 0 )
+            len = int( sectors ) * 512;
+        else if( ::ioctl( handle(), SG_GET_RESERVED_SIZE, &reservedSize ) == 0 && reservedSize > 0 )
+            len = reservedSize;
+    }
+#endif
+
+    if( len <= 0 ) {
+        // the values which proved to work in the past
+#ifdef Q_OS_NETBSD
+        len = 31*2048;
+#else
+        len = 128*2048;
+#endif
+    }
+    len = qMin( len, s_maxTransferLength );
+
+    // without a handle we could not ask the kernel
+    if( ref.isValid() ) {
+        d->maxTransferLength = len;
+        qDebug() << "(K3b::Device::Device)" << blockDeviceName() << "max transfer length:" << len;
+    }
+
+    return len;
+}
+
+
 QString K3b::Device::Device::blockDeviceName() const
 {
     return d->blockDevice;
@@ -365,33 +434,10 @@ bool K3b::Device::Device::init( bool bCheckWritingModes )
     if( !open() )
         return false;
 
-    //
-    // inquiry
-    // use a 36 bytes buffer since not all devices return the full inquiry struct
-    //
-    ScsiCommand cmd( this );
-    unsigned char buf[36];
-    cmd.clear();
-    ::memset( buf, 0, sizeof(buf) );
-    struct inquiry* inq = (struct inquiry*)buf;
-    cmd[0] = MMC_INQUIRY;
-    cmd[4] = sizeof(buf);
-    cmd[5] = 0;
-    if( cmd.transport( TR_DIR_READ, buf, sizeof(buf) ) ) {
-        qCritical() << "(K3b::Device::Device) Unable to do inquiry." << Qt::endl;
+    if( !identify() ) {
         close();
         return false;
     }
-    else {
-        d->vendor = QString::fromLatin1( (char*)(inq->vendor), 8 ).trimmed();
-        d->description = QString::fromLatin1( (char*)(inq->product), 16 ).trimmed();
-        d->version = QString::fromLatin1( (char*)(inq->revision), 4 ).trimmed();
-    }
-
-    if( d->vendor.isEmpty() )
-        d->vendor = "UNKNOWN";
-    if( d->description.isEmpty() )
-        d->description = "UNKNOWN";
 
     //
     // We probe all features of the device. Since not all devices support the GET CONFIGURATION command
@@ -437,10 +483,99 @@ bool K3b::Device::Device::init( bool bCheckWritingModes )
 }
 
 
+bool K3b::Device::Device::identify()
+{
+    HandleReference ref( this );
+    if( !ref.isValid() )
+        return false;
+
+    //
+    // inquiry
+    // use a 36 bytes buffer since not all devices return the full inquiry struct
+    //
+    ScsiCommand cmd( this );
+    unsigned char buf[36];
+    cmd.clear();
+    ::memset( buf, 0, sizeof(buf) );
+    struct inquiry* inq = (struct inquiry*)buf;
+    cmd[0] = MMC_INQUIRY;
+    cmd[4] = sizeof(buf);
+    cmd[5] = 0;
+    if( cmd.transport( TR_DIR_READ, buf, sizeof(buf) ) ) {
+        qCritical() << "(K3b::Device::Device) Unable to do inquiry." << Qt::endl;
+        return false;
+    }
+    else {
+        d->vendor = QString::fromLatin1( (char*)(inq->vendor), 8 ).trimmed();
+        d->description = QString::fromLatin1( (char*)(inq->product), 16 ).trimmed();
+        d->version = QString::fromLatin1( (char*)(inq->revision), 4 ).trimmed();
+    }
+
+    if( d->vendor.isEmpty() )
+        d->vendor = "UNKNOWN";
+    if( d->description.isEmpty() )
+        d->description = "UNKNOWN";
+
+    //
+    // The unit serial number VPD page is optional. Many drives do not have it.
+    //
+    unsigned char vpd[4+64];
+    cmd.clear();
+    cmd.enableErrorMessages( false );
+    ::memset( vpd, 0, sizeof(vpd) );
+    cmd[0] = MMC_INQUIRY;
+    cmd[1] = 0x1;   // EVPD
+    cmd[2] = 0x80;  // unit serial number
+    cmd[4] = sizeof(vpd);
+    cmd[5] = 0;
+    d->serialNumber.clear();
+    if( !cmd.transport( TR_DIR_READ, vpd, sizeof(vpd) ) && vpd[1] == 0x80 )
+        d->serialNumber = QString::fromLatin1( (char*)&vpd[4], qMin<int>( vpd[3], sizeof(vpd)-4 ) ).trimmed();
+
+    return true;
+}
+
+
+QVariantMap K3b::Device::Device::capabilities() const
+{
+    QVariantMap map;
+    map["read capabilities"] = int( d->readCapabilities );
+    map["write capabilities"] = int( d->writeCapabilities );
+    map["supported profiles"] = int( d->supportedProfiles );
+    map["writing modes"] = int( d->writeModes );
+    map["max read speed"] = d->maxReadSpeed;
+    map["max write speed"] = d->maxWriteSpeed;
+    map["buffer size"] = d->bufferSize;
+    map["burnfree"] = d->burnfree;
+    map["dvd minus testwrite"] = d->dvdMinusTestwrite;
+    return map;
+}
+
+
+void K3b::Device::Device::setCapabilities( const QVariantMap& map )
+{
+    d->readCapabilities = MediaTypes( QFlag( map["read capabilities"].toInt() ) );
+    d->writeCapabilities = MediaTypes( QFlag( map["write capabilities"].toInt() ) );
+    d->supportedProfiles = MediaTypes( QFlag( map["supported profiles"].toInt() ) );
+    d->writeModes = WritingModes( QFlag( map["writing modes"].toInt() ) );
+    d->maxReadSpeed = map["max read speed"].toInt();
+    d->maxWriteSpeed = map["max write speed"].toInt();
+    d->bufferSize = map["buffer size"].toInt();
+    d->burnfree = map["burnfree"].toBool();
+    d->dvdMinusTestwrite = map["dvd minus testwrite"].toBool();
+}
+
+
 bool K3b::Device::Device::furtherInit()
 {
 #ifdef Q_OS_LINUX
 
+    //
+    // An emulated drive has no kernel driver we could ask
+    //
+    if( transportHook() )
+        return true;
+
     //
     // Since all CDR drives at least support WRITINGMODE_TAO, all CDRW drives should support
     // mode page 2a and all DVD writer should support mode page 2a or the GET CONFIGURATION
@@ -721,12 +856,11 @@ bool K3b::Device::Device::isDVD() const
 
 int K3b::Device::Device::isEmpty() const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
     int ret = STATE_UNKNOWN;
-    if( !open() )
+    if( !ref.isValid() )
         return STATE_UNKNOWN;
 
     if( !testUnitReady() )
@@ -752,9 +886,6 @@ int K3b::Device::Device::isEmpty() const
         }
     }
 
-    if( needToClose )
-        close();
-
     return ret;
 }
 
@@ -808,11 +939,11 @@ int K3b::Device::Device::numSessions() const
 
 K3b::Device::Track::DataMode K3b::Device::Device::getDataMode( const K3b::Msf& sector ) const
 {
-    bool needToClose = !isOpen();
+    HandleReference ref( this );
 
     Track::DataMode ret = Track::UNKNOWN;
 
-    if( !open() )
+    if( !ref.isValid() )
         return ret;
 
     // we use readCdMsf here since it's defined mandatory in MMC1 and
@@ -849,9 +980,6 @@ K3b::Device::Track::DataMode K3b::Device::Device::getDataMode( const K3b::Msf& s
         }
     }
 
-    if( needToClose )
-        close();
-
     return ret;
 }
 
@@ -865,13 +993,12 @@ K3b::Device::Track::DataMode K3b::Device::Device::getTrackDataMode( const K3b::D
 
 K3b::Device::Toc K3b::Device::Device::readToc() const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
     Toc toc;
 
-    if( !open() )
+    if( !ref.isValid() )
         return toc;
 
     int mt = mediaType();
@@ -947,9 +1074,6 @@ K3b::Device::Toc K3b::Device::Device::readToc() const
         }
     }
 
-    if( needToClose )
-        close();
-
     return toc;
 }
 
@@ -981,9 +1105,8 @@ void K3b::Device::Device::readIsrcMcn( K3b::Device::Toc& toc ) const
 
 bool K3b::Device::Device::readFormattedToc( K3b::Device::Toc& toc, int mt ) const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
     bool success = false;
 
@@ -1115,25 +1238,20 @@ bool K3b::Device::Device::readFormattedToc( K3b::Device::Toc& toc, int mt ) cons
         }
     }
 
-
-    if( needToClose )
-        close();
-
     return success;
 }
 
 
 bool K3b::Device::Device::readRawToc( K3b::Device::Toc& toc ) const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
     bool success = false;
 
     toc.clear();
 
-    if( open() ) {
+    if( ref.isValid() ) {
         //
         // Read Raw TOC (format: 0010b)
         //
@@ -1242,9 +1360,6 @@ bool K3b::Device::Device::readRawToc( K3b::Device::Toc& toc ) const
         }
     }
 
-    if( needToClose )
-        close();
-
     return success;
 }
 
@@ -1764,15 +1879,17 @@ K3b::Device::Device::Handle K3b::Device::Device::handle() const
 
 bool K3b::Device::Device::open( bool write ) const
 {
-    if( d->openedReadWrite != write )
+    // a handle opened for writing can be used for reading, too. Reopening it
+    // read-only would only cost another open/close cycle.
+    if( write && !d->openedReadWrite )
         close();
 
     QMutexLocker ml( &d->openCloseMutex );
 
-    d->openedReadWrite = write;
-
-    if( d->deviceHandle == HANDLE_DEFAULT_VALUE)
+    if( d->deviceHandle == HANDLE_DEFAULT_VALUE) {
+        d->openedReadWrite = write;
         d->deviceHandle = openDevice( QFile::encodeName(blockDeviceName()), write );
+    }
 
     return ( d->deviceHandle != HANDLE_DEFAULT_VALUE);
 }
@@ -1802,6 +1919,182 @@ bool K3b::Device::Device::isOpen() const
 }
 
 
+bool K3b::Device::Device::acquireHandle( bool write ) const
+{
+    usageLock();
+    // every reference which had to open the device owns the handle. The device
+    // is closed once the last reference is released and one of them owned it.
+    const bool opened = !isOpen();
+    bool success = open( write );
+    if( success ) {
+        ++d->handleReferences;
+        if( opened )
+            ++d->handleOwners;
+    }
+    usageUnlock();
+    return success;
+}
+
+
+void K3b::Device::Device::releaseHandle() const
+{
+    usageLock();
+    if( d->handleReferences > 0 &&
+        --d->handleReferences == 0 &&
+        d->handleOwners > 0 ) {
+        d->handleOwners = 0;
+        close();
+    }
+    usageUnlock();
+}
+
+
+namespace {
+    int transportWithLength( K3b::Device::ScsiCommand& cmd, unsigned int lengthPos,
+                             K3b::Device::UByteArray& data, unsigned int len )
+    {
+        data.resize( len );
+        ::memset( data.data(), 0, data.size() );
+
+        cmd[lengthPos] = len >> 8;
+        cmd[lengthPos+1] = len;
+        return cmd.transport( K3b::Device::TR_DIR_READ, data.data(), data.size() );
+    }
+
+    unsigned int replyLength( const K3b::Device::UByteArray& data, unsigned int pos, unsigned int size )
+    {
+        quint64 len = ( size == 4
+                        ? K3b::Device::from4Byte( data.data() + pos )
+                        : K3b::Device::from2Byte( data.data() + pos ) );
+        return qMin<quint64>( len + pos + size, 0x10000 );
+    }
+
+    //
+    // The result of ScsiCommand::transport() contains the sense key and the ASC
+    //
+    bool invalidFieldInCdb( int result )
+    {
+        return( result > 0 &&
+                ( ( result >> 16 ) & 0x0F ) == 0x05 &&  // ILLEGAL REQUEST
+                ( ( result >> 8 ) & 0xFF ) == 0x24 );   // INVALID FIELD IN CDB
+    }
+
+    //
+    // Identifies a query by all command bytes but the allocation length. That way
+    // the pages of MODE SENSE or the formats of READ TOC are told apart.
+    //
+    QByteArray queryKey( K3b::Device::ScsiCommand& cmd, unsigned int lengthPos )
+    {
+        QByteArray key( 12, '\0' );
+        for( int i = 0; i < key.size(); ++i ) {
+            if( i != int( lengthPos ) && i != int( lengthPos ) + 1 )
+                key[i] = cmd[i];
+        }
+        return key;
+    }
+
+    //
+    // The allocation length field only has 16 bits and not all drives like uneven numbers
+    //
+    unsigned int allocationLength( unsigned int len )
+    {
+        if( len >= 0xFFFF )
+            return 0xFFFF;
+        else
+            return len + len%2;
+    }
+}
+
+
+//
+// Most MMC queries report the length of the available data in the reply header.
+// Instead of reading this header first and then sending the command again with the
+// real length we send the command once with an allocation length which fits the
+// usual reply and only repeat it if the reply was truncated.
+//
+// Some firmwares reject an allocation length that exceeds the available data with
+// ILLEGAL REQUEST / INVALID FIELD IN CDB. Only then we fall back to the two-step
+// query. Any other failure (no medium, unsupported page) is reported right away.
+// If the two-step query succeeds the command keeps using it, the command being
+// identified by all its bytes but the allocation length.
+//
+bool K3b::Device::Device::query( ScsiCommand& cmd, UByteArray& data,
+                                 const QueryFormat& format, unsigned int len ) const
+{
+    const QByteArray key = queryKey( cmd, format.allocationLengthPos );
+    d->twoStepMutex.lock();
+    const bool twoStep = d->twoStepCommands.contains( key );
+    d->twoStepMutex.unlock();
+
+    if( !twoStep ) {
+        len = allocationLength( len );
+        const int result = transportWithLength( cmd, format.allocationLengthPos, data, len );
+        if( result == 0 ) {
+            unsigned int reply = replyLength( data, format.replyLengthPos, format.replyLengthSize );
+            if( reply > len && len < 0xFFFF ) {
+                // truncated
+                if( transportWithLength( cmd, format.allocationLengthPos, data, allocationLength( reply ) ) ) {
+                    qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": " << commandString( cmd[0] )
+                             << " with real length " << data.size() << " failed." << Qt::endl;
+                    data.clear();
+                    return false;
+                }
+                reply = replyLength( data, format.replyLengthPos, format.replyLengthSize );
+            }
+            data.resize( qMin<unsigned int>( data.size(), reply ) );
+            return true;
+        }
+        else if( !invalidFieldInCdb( result ) ) {
+            data.clear();
+            return false;
+        }
+    }
+
+    //
+    // The two-step query: first we read the header
+    //
+    if( transportWithLength( cmd, format.allocationLengthPos, data, format.headerLength ) ) {
+        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": " << commandString( cmd[0] )
+                 << " length det failed." << Qt::endl;
+        data.clear();
+        return false;
+    }
+
+    unsigned int reply = replyLength( data, format.replyLengthPos, format.replyLengthSize );
+
+    //
+    // Some buggy firmwares do not return the size of the available data
+    // but the returned data or something invalid altogether.
+    // So we use the fallback length to be on the safe side with these buggy drives.
+    //
+    if( reply <= format.headerLength ) {
+        if( format.fallbackLength == 0 ) {
+            data.resize( qMin<unsigned int>( data.size(), reply ) );
+            return true;
+        }
+        reply = format.fallbackLength;
+    }
+
+    // again with real length
+    if( transportWithLength( cmd, format.allocationLengthPos, data, allocationLength( reply ) ) ) {
+        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": " << commandString( cmd[0] )
+                 << " with real length " << data.size() << " failed." << Qt::endl;
+        data.clear();
+        return false;
+    }
+
+    if( !twoStep ) {
+        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": using two-step queries for "
+                 << commandString( cmd[0] ) << Qt::endl;
+        QMutexLocker ml( &d->twoStepMutex );
+        d->twoStepCommands.insert( key );
+    }
+
+    data.resize( qMin<unsigned int>( data.size(), replyLength( data, format.replyLengthPos, format.replyLengthSize ) ) );
+    return true;
+}
+
+
 int K3b::Device::Device::supportedProfiles() const
 {
     return d->supportedProfiles;
@@ -1885,11 +2178,10 @@ K3b::Device::DiskInfo K3b::Device::Device::diskInfo() const
 {
     DiskInfo inf;
 
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
-    if( open() ) {
+    if( ref.isValid() ) {
 
         UByteArray data;
 
@@ -2332,9 +2624,6 @@ K3b::Device::DiskInfo K3b::Device::Device::diskInfo() const
             }
             }
         }
-
-        if( needToClose )
-            close();
     }
 
     return inf;
@@ -3332,11 +3621,10 @@ bool K3b::Device::Device::getSupportedWriteSpeedsViaGP( QList<int>& list, MediaT
 
 int K3b::Device::Device::getIndex( unsigned long lba ) const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
-    if( !open() )
+    if( !ref.isValid() )
         return -1;
 
     int ret = -1;
@@ -3414,48 +3702,187 @@ int K3b::Device::Device::getIndex( unsigned long lba ) const
             qDebug() << "(K3b::Device::Device::getIndex) seek or readSubChannel failed.";
     }
 
-    if( needToClose )
-        close();
-
     return ret;
 }
 
 
+//
+// Reads the Q subchannel of whole seconds with a single READ CD command and
+// answers index queries with the same semantics as Device::getIndex().
+// Drives which cannot read the subchannel of several sectors at once are
+// queried sector by sector. Only Q subchannel data with a valid CRC is used
+// in both cases.
+//
+class K3b::Device::Device::IndexReader
+{
+public:
+    IndexReader( const Device* dev, unsigned long lastSector )
+        : m_device( dev ),
+          m_lastSector( lastSector ),
+          m_chunkSectors( s_bulkSectors ),
+          m_bulkReadingVerified( false ) {
+    }
+
+    int index( unsigned long lba ) {
+        const unsigned char* q = subchannel( lba );
+        if( !q )
+            return m_device->getIndex( lba );
+
+        //
+        // The index is found in the Mode-1 Q which occupies at least 9 out of 10 successive CD frames
+        // So if the current sector does not provide Mode-1 Q subchannel we try the previous.
+        //
+        if( isMode1Q( q ) )
+            return q[2];
+
+        q = subchannel( lba-1 );
+        if( !q )
+            return m_device->getIndex( lba );
+        else if( isMode1Q( q ) )
+            return q[2];
+        else
+            return -2;
+    }
+
+private:
+    static const unsigned long s_bulkSectors = 75;
+
+    // byte 0: 4 bits CONTROL (MSB) + 4 bits ADR (LSB)
+    static bool isMode1Q( const unsigned char* q ) {
+        if( (q[0]&0x0f) != 0x1 )
+            return false;
+
+        unsigned char data[12];
+        ::memcpy( data, q, 12 );
+        return checkQCrc( data );
+    }
+
+    const unsigned char* subchannel( unsigned long lba ) {
+        const unsigned long chunkStart = lba - lba % m_chunkSectors;
+        QHash<unsigned long, QByteArray>::const_iterator it = m_chunks.constFind( chunkStart );
+        if( it == m_chunks.constEnd() ) {
+            // never read beyond the audio tracks
+            if( lba > m_lastSector )
+                return 0;
+
+            const unsigned long sectors = qMin( m_chunkSectors, m_lastSector - chunkStart + 1 );
+            QByteArray chunk( sectors*16, 0 );
+            if( !m_device->readCd( reinterpret_cast<unsigned char*>( chunk.data() ),
+                                   chunk.size(),
+                                   1, // CD-DA
+                                   0, // no DAP
+                                   chunkStart,
+                                   sectors,
+                                   false,
+                                   false,
+                                   false,
+                                   false,
+                                   false,
+                                   0,
+                                   2 // Q-Subchannel
+                    ) ) {
+                if( m_chunkSectors > 1 && !m_bulkReadingVerified ) {
+                    qDebug() << "(K3b::Device::Device::IndexReader) reading Q subchannel of several sectors failed.";
+                    m_chunkSectors = 1;
+                    return subchannel( lba );
+                }
+                return 0;
+            }
+            m_bulkReadingVerified = true;
+            it = m_chunks.insert( chunkStart, chunk );
+        }
+
+        return reinterpret_cast<const unsigned char*>( it.value().constData() ) + ( lba - chunkStart )*16;
+    }
+
+    const Device* m_device;
+    unsigned long m_lastSector;
+    unsigned long m_chunkSectors;
+    bool m_bulkReadingVerified;
+    QHash<unsigned long, QByteArray> m_chunks;
+};
+
+
 bool K3b::Device::Device::searchIndex0( unsigned long startSec,
                                       unsigned long endSec,
                                       long& pregapStart ) const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
-    if( !open() )
+    if( !ref.isValid() )
         return false;
 
+    IndexReader reader( this, endSec );
+    return searchIndex0( reader, startSec, endSec, pregapStart );
+}
+
+
+bool K3b::Device::Device::searchIndex0( IndexReader& reader,
+                                      unsigned long startSec,
+                                      unsigned long endSec,
+                                      long& pregapStart ) const
+{
+    //
+    // A sector without a valid Q subchannel tells us nothing about the pregap.
+    // Thus we step past it to the closest sector between lower and upper (excluded)
+    // with a valid index, first backwards and then forward.
+    // Returns -1 if there is no such sector.
+    //
+    auto validIndex = [&reader]( unsigned long& lba, unsigned long lower, unsigned long upper ) -> int {
+        for( unsigned long sector = lba; ; --sector ) {
+            const int index = reader.index( sector );
+            if( index >= 0 ) {
+                lba = sector;
+                return index;
+            }
+            if( sector == lower )
+                break;
+        }
+        for( unsigned long sector = lba + 1; sector < upper; ++sector ) {
+            const int index = reader.index( sector );
+            if( index >= 0 ) {
+                lba = sector;
+                return index;
+            }
+        }
+        return -1;
+    };
+
     bool ret = false;
 
-    int lastIndex = getIndex( endSec );
+    int lastIndex = reader.index( endSec );
     if( lastIndex == 0 ) {
         // there is a pregap
         // let's find the position where the index turns to 0
-        // we jump in 1 sec steps backwards until we find an index > 0
+        // we jump backwards in growing steps until we find an index > 0
         unsigned long sector = endSec;
+        unsigned long zeroSector = endSec;
+        unsigned long step = 75;
         while( lastIndex == 0 && sector > startSec ) {
-            sector -= 75;
-            if( sector < startSec )
-                sector = startSec;
-            lastIndex = getIndex(sector);
+            zeroSector = sector;
+            sector = ( sector - startSec > step ? sector - step : startSec );
+            lastIndex = validIndex( sector, startSec, zeroSector );
+            step *= 2;
         }
 
         if( lastIndex == 0 ) {
             qDebug() << "(K3b::Device::Device) warning: no index != 0 found.";
         }
         else {
-            // search forward to the first index = 0
-            while( getIndex( sector ) != 0 && sector < endSec )
-                sector++;
+            // bisect for the first index = 0
+            while( sector + 1 < zeroSector ) {
+                unsigned long middle = sector + ( zeroSector - sector ) / 2;
+                const int index = validIndex( middle, sector + 1, zeroSector );
+                if( index < 0 )
+                    break; // no valid index in between
+                else if( index == 0 )
+                    zeroSector = middle;
+                else
+                    sector = middle;
+            }
 
-            pregapStart = sector;
+            pregapStart = zeroSector;
             ret = true;
         }
     }
@@ -3465,30 +3892,33 @@ bool K3b::Device::Device::searchIndex0( unsigned long startSec,
         ret = true;
     }
 
-    if( needToClose )
-        close();
-
     return ret;
 }
 
 
 bool K3b::Device::Device::indexScan( K3b::Device::Toc& toc ) const
 {
-    // if the device is already opened we do not close it
-    // to allow fast multiple method calls in a row
-    bool needToClose = !isOpen();
+    // keep the device open for all the commands below
+    HandleReference ref( this );
 
-    if( !open() )
+    if( !ref.isValid() )
         return false;
 
     bool ret = true;
 
+    unsigned long lastSector = 0;
+    for( Toc::const_iterator it = toc.constBegin(); it != toc.constEnd(); ++it ) {
+        if( it->type() == Track::TYPE_AUDIO )
+            lastSector = qMax<unsigned long>( lastSector, it->lastSector().lba() );
+    }
+    IndexReader reader( this, lastSector );
+
     for( Toc::iterator it = toc.begin(); it != toc.end(); ++it ) {
         Track& track = *it;
         if( track.type() == Track::TYPE_AUDIO ) {
             track.setIndices( QList<K3b::Msf>() );
             long index0 = -1;
-            if( searchIndex0( track.firstSector().lba(), track.lastSector().lba(), index0 ) ) {
+            if( searchIndex0( reader, track.firstSector().lba(), track.lastSector().lba(), index0 ) ) {
                 qDebug() << "(K3b::Device::Device) found index 0: " << index0;
             }
             if( index0 > 0 )
@@ -3497,25 +3927,22 @@ bool K3b::Device::Device::indexScan( K3b::Device::Toc& toc ) const
                 track.setIndex0( 0 );
 
             if( index0 > 0 )
-                searchIndexTransitions( track.firstSector().lba(), index0-1, track );
+                searchIndexTransitions( reader, track.firstSector().lba(), index0-1, track );
             else
-                searchIndexTransitions( track.firstSector().lba(), track.lastSector().lba(), track );
+                searchIndexTransitions( reader, track.firstSector().lba(), track.lastSector().lba(), track );
         }
     }
 
-    if( needToClose )
-        close();
-
     return ret;
 }
 
 
-void K3b::Device::Device::searchIndexTransitions( long start, long end, K3b::Device::Track& track ) const
+void K3b::Device::Device::searchIndexTransitions( IndexReader& reader, long start, long end, K3b::Device::Track& track ) const
 {
     qDebug() << "(K3b::Device::Device) searching for index transitions between "
              << start << " and " << end << Qt::endl;
-    int startIndex = getIndex( start );
-    int endIndex = getIndex( end );
+    int startIndex = reader.index( start );
+    int endIndex = reader.index( end );
 
     if( startIndex < 0 || endIndex < 0 ) {
         qDebug() << "(K3b::Device::Device) could not retrieve index values.";
@@ -3536,8 +3963,8 @@ void K3b::Device::Device::searchIndexTransitions( long start, long end, K3b::Dev
                 track.setIndices( indices ); // FIXME: better API
             }
             else {
-                searchIndexTransitions( start, start+(end-start)/2, track );
-                searchIndexTransitions( start+(end-start)/2, end, track );
+                searchIndexTransitions( reader, start, start+(end-start)/2, track );
+                searchIndexTransitions( reader, start+(end-start)/2, end, track );
             }
         }
     }
@@ -13,6 +13,7 @@
 #include "k3bdevice_export.h"
 
 #include <qglobal.h>
+#include <QVariant>
 #include <QVarLengthArray>
 
 #if defined(__FreeBSD_kernel__)
@@ -37,6 +38,8 @@ namespace K3b {
     namespace Device
     {
         class Toc;
+        class ScsiCommand;
+        class CommandTrace;
 
         typedef QVarLengthArray< unsigned char > UByteArray;
 
@@ -111,6 +114,12 @@ namespace K3b {
              */
             QString version() const;
 
+            /**
+             * \return The unit serial number as reported by the device's firmware
+             *         or an empty string if the device does not report one.
+             */
+            QString serialNumber() const;
+
             /**
              * Shortcut for \code writesCd() || writesDvd() \endcode
              *
@@ -208,6 +217,25 @@ namespace K3b {
              */
             int bufferSize() const;
 
+            /**
+             * The maximum number of bytes a single read command can transfer.
+             *
+             * The value is determined once from the kernel (the maximum request
+             * size of the block device or the reserved size of the SCSI generic
+             * driver) and cached. Systems which do not provide the information
+             * get a conservative default.
+             *
+             * Readers should use this as the upper bound of their transfer size
+             * instead of guessing.
+             */
+            int maxTransferLength() const;
+
+            /**
+             * The commands sent to the device together with their durations
+             * and per-command statistics.
+             */
+            CommandTrace* commandTrace() const;
+
             /**
              * for SCSI devices this should be something like /dev/scd0 or /dev/sr0
              * for IDE device this should be something like /dev/hdb1
@@ -428,6 +456,26 @@ namespace K3b {
              */
             Handle handle() const;
 
+            /**
+             * Opens the device if necessary and keeps it open until the matching
+             * call to releaseHandle(). Calls may be nested and may come from different
+             * threads. As long as a reference is held commands do not open and close
+             * the device for each of them.
+             *
+             * The device is closed when the last reference is released if one of
+             * the references had to open it. A device opened via open() before
+             * stays open.
+             *
+             * @return true on success. Only then releaseHandle() has to be called.
+             * @see HandleReference
+             */
+            bool acquireHandle( bool write = false ) const;
+
+            /**
+             * Releases a reference obtained via acquireHandle().
+             */
+            void releaseHandle() const;
+
             /**
              * \return \li -1 on error (no DVD)
              *         \li 1 (CSS/CPPM)
@@ -624,6 +672,55 @@ namespace K3b {
              */
             int readBufferCapacity( long long& bufferLength, long long& bufferAvail ) const;
 
+            /**
+             * MMC command WRITE 10
+             *
+             * @param length The number of sectors in @p data.
+             *
+             * \return \see ScsiCommand::transport()
+             */
+            int write10( const unsigned char* data,
+                         unsigned int dataLen,
+                         unsigned long startAdress,
+                         unsigned int length ) const;
+
+            /**
+             * MMC command SYNCHRONIZE CACHE
+             *
+             * @param immediate If true the command returns before the cache
+             *                  has been written. Use testUnitReady() to wait
+             *                  for it.
+             */
+            bool synchronizeCache( bool immediate = false ) const;
+
+            /**
+             * MMC command CLOSE TRACK/SESSION
+             *
+             * @param function \li 001b - close the track @p number
+             *                 \li 010b - close the last session (or stop the
+             *                           background formatting of DVD+RW media)
+             *                 \li 110b - finalize the disc (DVD+R and BD-R)
+             * @param immediate \see synchronizeCache()
+             */
+            bool closeTrackSession( int function, unsigned int number = 0, bool immediate = false ) const;
+
+            /**
+             * MMC command RESERVE TRACK which is needed for DAO writing of DVD-R(W) media.
+             *
+             * @param length The size of the track in sectors.
+             */
+            bool reserveTrack( unsigned long length ) const;
+
+            /**
+             * Change mode page 05h for writing DVD-R(W) media.
+             *
+             * @param writeType \li 0 - incremental sequential
+             *                  \li 2 - disc at once
+             * @param testWrite Only simulate the writing.
+             * @param multiSession Keep the disc appendable.
+             */
+            bool setDvdWriteParameters( int writeType, bool testWrite, bool multiSession ) const;
+
             /**
              * @returns the index number on success
              *          -1 on general error
@@ -634,9 +731,12 @@ namespace K3b {
             bool searchIndex0( unsigned long startSec, unsigned long endSec, long& pregapStart ) const;
 
             /**
-             * For now this just searches index 0 for all tracks and sets
-             * the value in the tracks.
-             * In the future this should scan for all indices.
+             * Searches index 0 and the index transitions of all audio tracks
+             * and sets the values in the tracks.
+             *
+             * The Q subchannel is read in blocks of one second which are cached
+             * during the scan. Drives which fail to do so are queried sector
+             * by sector.
              */
             bool indexScan( Toc& toc ) const;
 
@@ -718,7 +818,23 @@ namespace K3b {
              */
             bool init( bool checkWritingModes = true );
 
-            void searchIndexTransitions( long start, long end, K3b::Device::Track& track ) const;
+            /**
+             * Reads vendor, description, firmware version, and the unit serial
+             * number. This is a small part of init() which is enough to recognize
+             * a known device.
+             */
+            bool identify();
+
+            /**
+             * The capabilities determined by init(). Used by the DeviceManager to
+             * restore a known device without probing it again.
+             */
+            QVariantMap capabilities() const;
+            void setCapabilities( const QVariantMap& );
+
+            class IndexReader;
+            bool searchIndex0( IndexReader& reader, unsigned long startSec, unsigned long endSec, long& pregapStart ) const;
+            void searchIndexTransitions( IndexReader& reader, long start, long end, K3b::Device::Track& track ) const;
             void checkWritingModes();
             void checkFeatures();
             void checkForJustLink();
@@ -738,12 +854,70 @@ namespace K3b {
 
             QByteArray mediaId( int mediaType ) const;
 
+            /**
+             * Describes how a query command and its reply are structured.
+             */
+            struct QueryFormat {
+                unsigned int allocationLengthPos; ///< position of the 16 bit allocation length in the CDB
+                unsigned int replyLengthPos;      ///< position of the length field in the reply header
+                unsigned int replyLengthSize;     ///< size of the length field (2 or 4 bytes)
+                unsigned int headerLength;        ///< bytes to read when only determining the length
+                unsigned int fallbackLength;      ///< used if the reported length is bogus, 0 for none
+            };
+
+            /**
+             * Sends a query command which reports the length of the available data
+             * in the reply header. The command is sent once with @p allocationLength
+             * and only repeated if the reply was truncated.
+             *
+             * On success @p data is resized to the length reported by the device.
+             */
+            bool query( ScsiCommand& cmd, UByteArray& data,
+                        const QueryFormat& format, unsigned int allocationLength ) const;
+
             class Private;
             Private* d;
 
             friend class DeviceManager;
         };
 
+        /**
+         * Keeps a device open for its lifetime. Use it to group a batch
+         * of commands:
+         *
+         * \code
+         * K3b::Device::HandleReference ref( dev );
+         * DiskInfo info = dev->diskInfo();
+         * Toc toc = dev->readToc();
+         * \endcode
+         *
+         * \sa Device::acquireHandle()
+         */
+        class HandleReference
+        {
+        public:
+            explicit HandleReference( const Device* dev, bool write = false )
+                : m_device( dev ),
+                  m_acquired( dev->acquireHandle( write ) ) {
+            }
+
+            ~HandleReference() {
+                if( m_acquired )
+                    m_device->releaseHandle();
+            }
+
+            /**
+             * \return true if the device could be opened.
+             */
+            bool isValid() const { return m_acquired; }
+
+        private:
+            Q_DISABLE_COPY( HandleReference )
+
+            const Device* m_device;
+            bool m_acquired;
+        };
+
         /**
          * This should always be used to open a device since it
          * uses the resmgr
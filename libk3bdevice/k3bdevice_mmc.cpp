@@ -11,6 +11,7 @@
 #include "k3bdevice.h"
 #include "k3bscsicommand.h"
 #include "k3bdeviceglobals.h"
+#include "k3bmmc.h"
 #include "QDebug"
 
 #include <string.h>
@@ -28,50 +29,15 @@ bool K3b::Device::Device::testUnitReady() const
 
 bool K3b::Device::Device::getFeature( UByteArray& data, unsigned int feature ) const
 {
-    unsigned char header[2048];
-    ::memset( header, 0, 2048 );
-
     ScsiCommand cmd( this );
     cmd[0] = MMC_GET_CONFIGURATION;
     cmd[1] = 2;      // read only specified feature
     cmd[2] = feature>>8;
     cmd[3] = feature;
-    cmd[8] = 8;      // we only read the data length first
     cmd[9] = 0;      // Necessary to set the proper command length
 
-    // we only read the data length first
-    unsigned int dataLen = 8;
-    if( !cmd.transport( TR_DIR_READ, header, 8 ) )
-        dataLen = from4Byte( header ) + 4;
-    else
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": GET CONFIGURATION length det failed.";
-
-    //
-    // Some buggy firmwares do not return the size of the available data
-    // but the returned data or something invalid altogether.
-    // So we simply use the maximum possible value to be on the safe side
-    // with these buggy drives.
-    // We cannot use this as default since many firmwares fail with a too high data length.
-    //
-    if( (dataLen-8) % 8 || dataLen <= 8 )
-        dataLen = 0xFFFF;
-
-    // again with real length
-    data.resize( dataLen );
-    ::memset( data.data(), 0, data.size() );
-
-    cmd[7] = data.size() >> 8;
-    cmd[8] = data.size();
-    if( cmd.transport( TR_DIR_READ, data.data(), data.size() ) == 0 ) {
-        data.resize( qMin( data.size(), (int)from4Byte( data.data() ) + 4 ) );
-        return true;
-    }
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": GET CONFIGURATION with real length "
-                 << data.size() << " failed." << Qt::endl;
-        data.clear();
-        return false;
-    }
+    static const QueryFormat format = { 7, 0, 4, 8, 0xFFFF };
+    return query( cmd, data, format, 2048 );
 }
 
 
@@ -259,9 +225,6 @@ bool K3b::Device::Device::seek( unsigned long lba ) const
 
 bool K3b::Device::Device::readTrackInformation( UByteArray& data, int type, int value ) const
 {
-    unsigned char header[2048];
-    ::memset( header, 0, 2048 );
-
     ScsiCommand cmd( this );
     cmd[0] = MMC_READ_TRACK_INFORMATION;
     cmd[9] = 0;      // Necessary to set the proper command length
@@ -281,48 +244,16 @@ bool K3b::Device::Device::readTrackInformation( UByteArray& data, int type, int
         return false;
     }
 
-    // first we read the header
-    unsigned int dataLen = 4;
-    cmd[8] = 4;
-    if( cmd.transport( TR_DIR_READ, header, 4 ) == 0 )
-        dataLen = from2Byte( header ) + 2;
-    else
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TRACK INFORMATION length det failed.";
-
     //
-    // Some buggy firmwares do not return the size of the available data
-    // but the returned data.
-    // So we try to determine the correct size based on the medium type
+    // The size of the track information depends on the medium type:
     // DVD+R:  40 (MMC4)
     // DVD-DL: 48 (MMC5)
     // CD:     36 (MMC2)
+    // We ask for the biggest one which is also used for buggy firmwares
+    // that do not report the size of the available data.
     //
-    if( dataLen <= 6 ) {
-        int m = mediaType();
-        if( m & (MEDIA_DVD_R_DL|MEDIA_DVD_R_DL_SEQ|MEDIA_DVD_R_DL_JUMP) )
-            dataLen = 48;
-        else if( m & (MEDIA_DVD_PLUS_R|MEDIA_DVD_PLUS_R_DL) )
-            dataLen = 40;
-        else
-            dataLen = 36;
-    }
-
-    // again with real length
-    data.resize( dataLen );
-    ::memset( data.data(), 0, data.size() );
-
-    cmd[7] = data.size() >> 8;
-    cmd[8] = data.size();
-    if( cmd.transport( TR_DIR_READ, data.data(), data.size() ) == 0 ) {
-        data.resize( qMin( data.size(), from2Byte( data.data() ) + 2 ) );
-        return true;
-    }
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TRACK INFORMATION with real length "
-                 << data.size() << " failed." << Qt::endl;
-        data.clear();
-        return false;
-    }
+    static const QueryFormat format = { 7, 0, 2, 4, 48 };
+    return query( cmd, data, format, 48 );
 }
 
 
@@ -479,49 +410,16 @@ bool K3b::Device::Device::readSubChannel( UByteArray& data,
                                         unsigned int subchannelParam,
                                         unsigned int trackNumber ) const
 {
-    unsigned char header[2048];
-    ::memset( header, 0, 2048 );
-
     ScsiCommand cmd( this );
     cmd[0] = MMC_READ_SUB_CHANNEL;
     cmd[2] = 0x40;    // SUBQ
     cmd[3] = subchannelParam;
     cmd[6] = trackNumber;   // only used when subchannelParam == 03h (ISRC)
-    cmd[8] = 4;
     cmd[9] = 0;      // Necessary to set the proper command length
 
-    // first we read the header
-    unsigned int dataLen = 4;
-    if( cmd.transport( TR_DIR_READ, header, 4 ) == 0 )
-        dataLen = from2Byte( &header[2] ) + 4;
-    else
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ SUB-CHANNEL length det failed.";
-
-    //
-    // Some buggy firmwares do not return the size of the available data
-    // but the returned data. So we simply use the maximum possible value to be on the safe side
-    // with these buggy drives.
-    // We cannot use this as default since many firmwares fail with a too high data length.
-    //
-    if( dataLen <= 4 )
-        dataLen = 0xFFFF;
-
-    // again with real length
-    data.resize( dataLen );
-    ::memset( data.data(), 0, data.size() );
-
-    cmd[7] = data.size() >> 8;
-    cmd[8] = data.size();
-    if( cmd.transport( TR_DIR_READ, data.data(), data.size() ) == 0 ) {
-        data.resize( qMin( data.size(), from2Byte( &data[2] ) + 4 ) );
-        return true;
-    }
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ SUB-CHANNEL with real length "
-                 << data.size() << " failed." << Qt::endl;
-        data.clear();
-        return false;
-    }
+    // the sub-channel data formats are 24 bytes at most
+    static const QueryFormat format = { 7, 2, 2, 4, 0xFFFF };
+    return query( cmd, data, format, 48 );
 }
 
 
@@ -550,66 +448,30 @@ bool K3b::Device::Device::readTocPmaAtip( UByteArray& data, int format, bool tim
         break;
     }
 
-    unsigned char header[2048];
-    ::memset( header, 0, 2048 );
-
     ScsiCommand cmd( this );
     cmd[0] = MMC_READ_TOC_PMA_ATIP;
     cmd[1] = ( time ? 0x2 : 0x0 );
     cmd[2] = format & 0x0F;
     cmd[6] = track;
-    cmd[8] = 4;
     cmd[9] = 0;      // Necessary to set the proper command length
 
-    // we only read the header
-    unsigned int dataLen = 4;
-    if( cmd.transport( TR_DIR_READ, header, 4 ) == 0 )
-        dataLen = from2Byte( header ) + 2;
-    else
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TOC/PMA/ATIP length det failed.";
-
-    //
-    // Some buggy firmwares return an invalid size here
-    // So we simply use the maximum possible value to be on the safe side
-    // with these buggy drives.
-    // We cannot use this as default since many firmwares fail with a too high data length.
-    //
-    if( descLen != 0 && ((dataLen-4) % descLen || dataLen < 4+descLen) ) {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TOC/PMA/ATIP invalid length returned: " << dataLen;
-        dataLen = 0xFFFF;
+    static const QueryFormat queryFormat = { 7, 0, 2, 4, 0xFFFF };
+    if( !query( cmd, data, queryFormat, 2048 ) ) {
+        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TOC/PMA/ATIP format "
+                 << format << " failed." << Qt::endl;
+        return false;
     }
 
-    //
-    // Not all drives like uneven numbers
-    //
-    if( dataLen%2 )
-        ++dataLen;
-
-    // again with real length
-    data.resize( dataLen );
-    ::memset( data.data(), 0, data.size() );
-
-    cmd[7] = data.size() >> 8;
-    cmd[8] = data.size();
-    if( cmd.transport( TR_DIR_READ, data.data(), data.size() ) == 0 ) {
-        dataLen = qMin( dataLen, from2Byte( data.data() ) + 2u );
-        if( descLen == 0 || (dataLen-4) % descLen || dataLen < 4+descLen ) {
-            // useless length
-            data.clear();
-            return false;
-        }
-        else {
-            data.resize( dataLen );
-            return true;
-        }
-    }
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TOC/PMA/ATIP format "
-                 << format << " with real length "
-                 << data.size() << " failed." << Qt::endl;
+    unsigned int dataLen = data.size();
+    if( descLen == 0 || (dataLen-4) % descLen || dataLen < 4+descLen ) {
+        // useless length
+        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ TOC/PMA/ATIP invalid length returned: " << dataLen;
         data.clear();
         return false;
     }
+    else {
+        return true;
+    }
 }
 
 
@@ -665,48 +527,17 @@ bool K3b::Device::Device::mechanismStatus( UByteArray& data ) const
 
 bool K3b::Device::Device::modeSense(UByteArray& pageData, int page) const
 {
-    unsigned char header[2048];
-    ::memset(header, 0, sizeof(header));
-
     ScsiCommand cmd(this);
     cmd[0] = MMC_MODE_SENSE;
     cmd[1] = 0x8;         // Disable Block Descriptors
     cmd[2] = page & 0x3F;
-    cmd[8] = 8;
     cmd[9] = 0;           // Necessary to set the proper command length
 
-    // first we determine the data length
-    int replyLen = 8;
-    if (cmd.transport(TR_DIR_READ, header, 8) == 0)
-        replyLen = from2Byte(header) + 2;
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() <<
-            ": MODE SENSE length det failed.";
-    }
     // FIXME: rumor or misnomer?
     // Some buggy firmwares do not return the size of the available data
-    // but the returned data. So we simply use the maximum possible value to be
-    // on the safe side with these buggy drives.
-    // We cannot use this as default since many firmwares fail with a too high
-    // data length.
-    if (replyLen == 8)
-        replyLen = 0xFFFF;
-
-    // again with real length
-    pageData.resize(replyLen);
-    ::memset(pageData.data(), 0, pageData.size());
-
-    cmd[7] = pageData.size() >> 8;
-    cmd[8] = pageData.size();
-    if (cmd.transport(TR_DIR_READ, pageData.data(), pageData.size()) == 0 ) {
-        pageData.resize(qMin(pageData.size(), from2Byte(pageData.data()) + 2));
-        return true;
-    } else {
-        pageData.clear();
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() <<
-            ": MODE SENSE with real length " << replyLen << " failed." << Qt::endl;
-        return false;
-    }
+    // but the returned data. Thus, the fallback length is the maximum.
+    static const QueryFormat format = { 7, 0, 2, 8, 0xFFFF };
+    return query(cmd, pageData, format, 2048);
 }
 
 
@@ -808,42 +639,13 @@ bool K3b::Device::Device::readFormatCapacity( int wantedFormat, K3b::Msf& r,
 
 bool K3b::Device::Device::readDiscInformation( UByteArray& data ) const
 {
-    unsigned char header[2];
-    ::memset( header, 0, 2 );
-
     ScsiCommand cmd( this );
     cmd[0] = MMC_READ_DISC_INFORMATION;
-    cmd[8] = 2;
     cmd[9] = 0;      // Necessary to set the proper command length
 
-    unsigned int dataLen = 0;
-    if( cmd.transport( TR_DIR_READ, header, 2 ) == 0 )
-        dataLen = from2Byte( header ) + 2u;
-    else
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName()
-                 << ": READ DISC INFORMATION length det failed" << Qt::endl;
-
-    if( dataLen < 32 ) {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName()
-                 << ": Device reports bogus disc information length of " << dataLen << Qt::endl;
-        dataLen = 32;
-    }
-
-    data.resize( dataLen );
-    ::memset( data.data(), 0, data.size() );
-
-    cmd[7] = data.size() >> 8;
-    cmd[8] = data.size();
-    if( cmd.transport( TR_DIR_READ, data.data(), data.size() ) == 0 ) {
-        data.resize( qMin( data.size(), from2Byte( data.data() ) + 2 ) );
-        return true;
-    }
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ DISC INFORMATION with real length "
-                 << dataLen << " failed." << Qt::endl;
-        data.clear();
-        return false;
-    }
+    // the disc information block is at least 32 bytes
+    static const QueryFormat format = { 7, 0, 2, 2, 32 };
+    return query( cmd, data, format, 2048 );
 }
 
 
@@ -864,9 +666,6 @@ bool K3b::Device::Device::readDiscStructure( UByteArray& data,
                                            unsigned long address,
                                            unsigned int agid ) const
 {
-    unsigned char header[4];
-    ::memset( header, 0, 4 );
-
     ScsiCommand cmd( this );
     cmd[0] = MMC_READ_DVD_STRUCTURE;
     cmd[1] = mediaType & 0xF;
@@ -879,30 +678,9 @@ bool K3b::Device::Device::readDiscStructure( UByteArray& data,
     cmd[10] = (agid<<6);
     cmd[11] = 0;      // Necessary to set the proper command length
 
-    cmd[9] = 4;
-    if( cmd.transport( TR_DIR_READ, header, 4 ) == 0 ) {
-        // again with real length
-        unsigned int dataLen = from2Byte( header ) + 2;
-
-        data.resize( dataLen );
-        ::memset( data.data(), 0, data.size() );
-
-        cmd[8] = data.size() >> 8;
-        cmd[9] = data.size();
-        if( cmd.transport( TR_DIR_READ, data.data(), data.size() ) == 0 ) {
-            data.resize( qMin( data.size(), from2Byte( data.data() ) + 2 ) );
-            return true;
-        }
-        else {
-            qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ DVD STRUCTURE with real length failed.";
-            data.clear();
-            return false;
-        }
-    }
-    else {
-        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": READ DVD STRUCTURE length det failed";
-        return false;
-    }
+    // the biggest structures (like the physical format information) are 2048 bytes plus the header
+    static const QueryFormat queryFormat = { 8, 0, 2, 4, 0 };
+    return query( cmd, data, queryFormat, 2052 );
 }
 
 
@@ -931,3 +709,87 @@ int K3b::Device::Device::readBufferCapacity( long long& bufferLength, long long&
 
     return 0;
 }
+
+
+int K3b::Device::Device::write10( const unsigned char* data,
+                                  unsigned int dataLen,
+                                  unsigned long startAdress,
+                                  unsigned int length ) const
+{
+    ScsiCommand cmd( this );
+    cmd[0] = MMC_WRITE_10;
+    cmd[2] = startAdress>>24;
+    cmd[3] = startAdress>>16;
+    cmd[4] = startAdress>>8;
+    cmd[5] = startAdress;
+    cmd[7] = length>>8;
+    cmd[8] = length;
+    cmd[9] = 0;      // Necessary to set the proper command length
+
+    // the transport does not change the data when writing
+    return cmd.transport( TR_DIR_WRITE, const_cast<unsigned char*>( data ), dataLen );
+}
+
+
+bool K3b::Device::Device::synchronizeCache( bool immediate ) const
+{
+    ScsiCommand cmd( this );
+    cmd[0] = MMC_SYNCHRONIZE_CACHE;
+    cmd[1] = ( immediate ? 0x2 : 0x0 );
+    cmd[9] = 0;      // Necessary to set the proper command length
+    return( cmd.transport() == 0 );
+}
+
+
+bool K3b::Device::Device::closeTrackSession( int function, unsigned int number, bool immediate ) const
+{
+    ScsiCommand cmd( this );
+    cmd[0] = MMC_CLOSE_TRACK_SESSION;
+    cmd[1] = ( immediate ? 0x1 : 0x0 );
+    cmd[2] = function & 0x7;
+    cmd[4] = number>>8;
+    cmd[5] = number;
+    cmd[9] = 0;      // Necessary to set the proper command length
+    return( cmd.transport() == 0 );
+}
+
+
+bool K3b::Device::Device::reserveTrack( unsigned long length ) const
+{
+    ScsiCommand cmd( this );
+    cmd[0] = MMC_RESERVE_TRACK;
+    cmd[5] = length>>24;
+    cmd[6] = length>>16;
+    cmd[7] = length>>8;
+    cmd[8] = length;
+    cmd[9] = 0;      // Necessary to set the proper command length
+    return( cmd.transport() == 0 );
+}
+
+
+bool K3b::Device::Device::setDvdWriteParameters( int writeType, bool testWrite, bool multiSession ) const
+{
+    // header size is 8
+    UByteArray buffer;
+    if( !modeSense( buffer, 0x05 ) || buffer.size() < 18 ) {
+        qDebug() << "(K3b::Device::Device) " << blockDeviceName() << ": modeSense 0x05 failed!";
+        return false;
+    }
+
+    wr_param_page_05* mp = (struct wr_param_page_05*)(buffer.data()+8);
+
+    mp->PS = 0;
+    mp->BUFE = 1;
+    mp->LS_V = 0;
+    mp->test_write = ( testWrite ? 1 : 0 );
+    mp->write_type = writeType;
+    mp->multi_session = ( multiSession ? 3 : 0 );
+    mp->fp = 0;
+    mp->copy = 0;
+    mp->track_mode = 5;     // data track, recorded incrementally
+    mp->dbtype = 8;         // Mode 1
+    mp->host_appl_code = 0;
+    mp->session_format = 0;
+
+    return modeSelect( buffer, 1, 0 );
+}
@@ -27,11 +27,15 @@
 #endif
 
 #include <QDebug>
+#include <QHash>
+#include <QSharedPointer>
 #include <QString>
 #include <QStringList>
 #include <QFile>
 #include <QFileInfo>
 #include <QTemporaryFile>
+#include <QThreadPool>
+#include <QVector>
 
 #include <iostream>
 #include <limits.h>
@@ -101,6 +105,29 @@ typedef unsigned char u8;
 #endif
 
 
+namespace {
+    QString capabilityCacheKey( const K3b::Device::Device* dev )
+    {
+        return ( QStringList()
+                 << dev->vendor()
+                 << dev->description()
+                 << dev->version()
+                 << dev->serialNumber() ).join( ' ' ).trimmed();
+    }
+
+    // values read from the config file are strings
+    bool sameCapabilities( const QVariantMap& a, const QVariantMap& b )
+    {
+        if( a.keys() != b.keys() )
+            return false;
+        for( QVariantMap::const_iterator it = a.constBegin(); it != a.constEnd(); ++it ) {
+            if( it.value().toString() != b[it.key()].toString() )
+                return false;
+        }
+        return true;
+    }
+}
+
 
 class K3b::Device::DeviceManager::Private
 {
@@ -114,6 +141,17 @@ public:
     QList<Device*> bdWriter;
 
     bool checkWritingModes;
+
+    // capabilities of known devices, see saveConfig()
+    QHash<QString, QVariantMap> capabilityCache;
+
+    // the speeds configured per device type, see readConfig()
+    QHash<QString, QStringList> configuredSpeeds;
+
+    // devices initialized by scanBus() which have not been added yet
+    QHash<QString, Device*> initializedDevices;
+
+    QThreadPool revalidationPool;
 };
 
 
@@ -131,6 +169,7 @@ K3b::Device::DeviceManager::DeviceManager( QObject* parent )
 
 K3b::Device::DeviceManager::~DeviceManager()
 {
+    d->revalidationPool.waitForDone();
     qDeleteAll( d->allDevices );
     delete d;
 }
@@ -227,12 +266,65 @@ int K3b::Device::DeviceManager::scanBus()
     int cnt = 0;
 
     QList<Solid::Device> dl = Solid::Device::listFromType( Solid::DeviceInterface::OpticalDrive );
+
+    //
+    // Initializing a device takes a lot of commands and some devices take seconds
+    // to answer. Thus, we initialize all new devices at once before adding them.
+    //
+    QList<Device*> devices;
     Q_FOREACH( const Solid::Device& solidDev, dl ) {
-        if ( checkDevice( solidDev ) ) {
+        if( solidDev.is<Solid::OpticalDrive>() && solidDev.is<Solid::Block>() ) {
+            Device* device = new Device( solidDev );
+            if( findDevice( device->blockDeviceName() ) )
+                delete device;
+            else
+                devices.append( device );
+        }
+    }
+
+    QVector<char> results( devices.count(), 0 );
+    QVector<char> fromCache( devices.count(), 0 );
+    if( devices.count() > 1 ) {
+        QThreadPool pool;
+        pool.setMaxThreadCount( devices.count() );
+        for( int i = 0; i < devices.count(); ++i ) {
+            pool.start( [&, i]() {
+                bool c = false;
+                results[i] = initDevice( devices[i], &c );
+                fromCache[i] = c;
+            } );
+        }
+        pool.waitForDone();
+    }
+    else if( !devices.isEmpty() ) {
+        bool c = false;
+        results[0] = initDevice( devices[0], &c );
+        fromCache[0] = c;
+    }
+
+    QStringList failedDevices;
+    for( int i = 0; i < devices.count(); ++i ) {
+        if( results[i] ) {
+            deviceInitialized( devices[i], fromCache[i] );
+            d->initializedDevices.insert( devices[i]->solidDevice().udi(), devices[i] );
+        }
+        else {
+            qDebug() << "Could not initialize device " << devices[i]->blockDeviceName();
+            failedDevices.append( devices[i]->solidDevice().udi() );
+            delete devices[i];
+        }
+    }
+
+    Q_FOREACH( const Solid::Device& solidDev, dl ) {
+        if ( !failedDevices.contains( solidDev.udi() ) && checkDevice( solidDev ) ) {
             ++cnt;
         }
     }
 
+    // in case a subclass did not want some of them
+    qDeleteAll( d->initializedDevices );
+    d->initializedDevices.clear();
+
     return cnt;
 }
 
@@ -306,13 +398,26 @@ bool K3b::Device::DeviceManager::readConfig( const KConfigGroup& c )
         QStringList list = c.readEntry( configEntryName, QStringList() );
         if( !list.isEmpty() ) {
             qDebug() << "(K3b::Device::DeviceManager) found config entry for devicetype: " << configEntryName;
-
-            dev->setMaxReadSpeed( list[0].toInt() );
-            if( list.count() > 1 )
-                dev->setMaxWriteSpeed( list[1].toInt() );
+            d->configuredSpeeds.insert( configEntryName, list );
+            applyConfiguredSpeeds( dev );
         }
     }
 
+    //
+    // The cached capabilities. Entries determined in this session are newer.
+    //
+    const KConfigGroup cacheGroup = c.group( QStringLiteral( "Capabilities" ) );
+    Q_FOREACH( const QString& key, cacheGroup.groupList() ) {
+        if( d->capabilityCache.contains( key ) )
+            continue;
+
+        QVariantMap capabilities;
+        const QMap<QString, QString> entries = cacheGroup.group( key ).entryMap();
+        for( QMap<QString, QString>::const_iterator it = entries.constBegin(); it != entries.constEnd(); ++it )
+            capabilities.insert( it.key(), it.value() );
+        d->capabilityCache.insert( key, capabilities );
+    }
+
     return true;
 }
 
@@ -342,6 +447,19 @@ bool K3b::Device::DeviceManager::saveConfig( KConfigGroup c )
         c.writeEntry( configEntryName, list );
     }
 
+    //
+    // The capabilities are saved for every single device as determined by
+    // Device::init(), i.e. without the user's speed settings from above.
+    // The firmware version is part of the key since an update may change them.
+    //
+    KConfigGroup cacheGroup = c.group( QStringLiteral( "Capabilities" ) );
+    for( QHash<QString, QVariantMap>::const_iterator it = d->capabilityCache.constBegin();
+         it != d->capabilityCache.constEnd(); ++it ) {
+        KConfigGroup deviceGroup = cacheGroup.group( it.key() );
+        for( QVariantMap::const_iterator entry = it.value().constBegin(); entry != it.value().constEnd(); ++entry )
+            deviceGroup.writeEntry( entry.key(), entry.value() );
+    }
+
     return true;
 }
 
@@ -350,11 +468,24 @@ K3b::Device::Device* K3b::Device::DeviceManager::addDevice( const Solid::Device&
 {
     if( const Solid::Block* blockDevice = solidDevice.as<Solid::Block>() ) {
 #ifndef Q_OS_NETBSD
-        if( !findDevice( blockDevice->device() ) )
+        if( !findDevice( blockDevice->device() ) ) {
 #else
-        if( !findDevice( solidDevice.as<Solid::GenericInterface>()->propertyExists("block.netbsd.raw_device") ? solidDevice.as<Solid::GenericInterface>()->property("block.netbsd.raw_device").toString() : blockDevice->device() ) )
+        if( !findDevice( solidDevice.as<Solid::GenericInterface>()->propertyExists("block.netbsd.raw_device") ? solidDevice.as<Solid::GenericInterface>()->property("block.netbsd.raw_device").toString() : blockDevice->device() ) ) {
 #endif
-            return addDevice( new K3b::Device::Device( solidDevice ) );
+            // scanBus() initializes the devices in advance
+            Device* device = d->initializedDevices.take( solidDevice.udi() );
+            if( !device ) {
+                device = new K3b::Device::Device( solidDevice );
+                bool fromCache = false;
+                if( !initDevice( device, &fromCache ) ) {
+                    qDebug() << "Could not initialize device " << device->blockDeviceName();
+                    delete device;
+                    return 0;
+                }
+                deviceInitialized( device, fromCache );
+            }
+            return addDevice( device );
+        }
         else
             qDebug() << "(K3b::Device::DeviceManager) dev " << blockDevice->device()  << " already found";
     }
@@ -362,16 +493,82 @@ K3b::Device::Device* K3b::Device::DeviceManager::addDevice( const Solid::Device&
 }
 
 
-K3b::Device::Device* K3b::Device::DeviceManager::addDevice( K3b::Device::Device* device )
+bool K3b::Device::DeviceManager::initDevice( Device* device, bool* fromCache ) const
 {
-    const QString devicename = device->blockDeviceName();
+    *fromCache = false;
+
+    if( !d->capabilityCache.isEmpty() && device->identify() ) {
+        QHash<QString, QVariantMap>::const_iterator it = d->capabilityCache.constFind( capabilityCacheKey( device ) );
+        if( it != d->capabilityCache.constEnd() ) {
+            qDebug() << "(K3b::Device::DeviceManager) using cached capabilities for" << device->blockDeviceName();
+            device->setCapabilities( it.value() );
+            *fromCache = true;
+            return true;
+        }
+    }
 
-    if( !device->init() ) {
-        qDebug() << "Could not initialize device " << devicename;
-        delete device;
-        return 0;
+    return device->init();
+}
+
+
+void K3b::Device::DeviceManager::applyConfiguredSpeeds( Device* dev ) const
+{
+    const QStringList list = d->configuredSpeeds.value( dev->vendor() + ' ' + dev->description() );
+    if( !list.isEmpty() ) {
+        dev->setMaxReadSpeed( list[0].toInt() );
+        if( list.count() > 1 )
+            dev->setMaxWriteSpeed( list[1].toInt() );
     }
+}
+
+
+void K3b::Device::DeviceManager::deviceInitialized( Device* device, bool fromCache )
+{
+    if( !fromCache ) {
+        d->capabilityCache.insert( capabilityCacheKey( device ), device->capabilities() );
+        return;
+    }
+
+    //
+    // Make sure the cache is still valid without delaying the startup. A fresh
+    // Device object is probed in the background and only if the result differs
+    // from the cache the capabilities of the device in use are updated.
+    //
+    // The probe does not hold the usage lock of the device in use. Thus it only
+    // sends queries and leaves out the writing modes which are determined by
+    // changing the write parameters page. Those are kept from the cache.
+    //
+    const QString udi = device->solidDevice().udi();
+    QSharedPointer<Device> probe( new Device( device->solidDevice() ) );
+    d->revalidationPool.start( [this, probe, udi]() {
+        const bool success = probe->init( false );
+        QMetaObject::invokeMethod( this, [this, probe, udi, success]() {
+            if( !success )
+                return;
+
+            const QString key = capabilityCacheKey( probe.data() );
+            const QVariantMap cached = d->capabilityCache.value( key );
+            QVariantMap capabilities = probe->capabilities();
+            if( cached.contains( QStringLiteral( "writing modes" ) ) )
+                capabilities.insert( QStringLiteral( "writing modes" ), cached[QStringLiteral( "writing modes" )] );
+            const bool modified = !sameCapabilities( cached, capabilities );
+            d->capabilityCache.insert( key, capabilities );
+
+            Device* dev = findDeviceByUdi( udi );
+            if( modified && dev && capabilityCacheKey( dev ) == key ) {
+                qDebug() << "(K3b::Device::DeviceManager) capabilities of" << dev->blockDeviceName() << "changed.";
+                dev->setCapabilities( capabilities );
+                applyConfiguredSpeeds( dev );
+                emit changed( this );
+                emit changed();
+            }
+        }, Qt::QueuedConnection );
+    } );
+}
 
+
+K3b::Device::Device* K3b::Device::DeviceManager::addDevice( K3b::Device::Device* device )
+{
     if( device ) {
         d->allDevices.append( device );
 
@@ -149,9 +149,17 @@ namespace K3b {
 
             /**
              * Reads the device information from the config file.
+             *
+             * This includes the cached capabilities of known devices. To benefit
+             * from them the config needs to be read before calling scanBus().
              */
             virtual bool readConfig( const KConfigGroup& );
 
+            /**
+             * Saves the device settings and the capabilities of all devices
+             * ever initialized by vendor, model, firmware version, and serial
+             * number.
+             */
             virtual bool saveConfig( KConfigGroup );
 
 
@@ -164,6 +172,10 @@ namespace K3b {
             /**
              * Scan the system for devices. Call this to initialize all devices.
              *
+             * The devices are initialized concurrently. Devices known from the
+             * config come up with their cached capabilities which are then
+             * revalidated in the background.
+             *
              * \return Number of found devices.
              **/
             virtual int scanBus();
@@ -205,9 +217,26 @@ namespace K3b {
             Private* const d;
 
             /**
-             * Add a device to the managers device lists and initialize the device.
+             * Add an initialized device to the managers device lists.
              */
             Device *addDevice( Device* );
+
+            /**
+             * Initializes @p dev from the capability cache if possible or probes
+             * it otherwise. Safe to be called from several threads at once.
+             */
+            bool initDevice( Device* dev, bool* fromCache ) const;
+
+            /**
+             * Updates the capability cache or starts the revalidation of a device
+             * restored from the cache.
+             */
+            void deviceInitialized( Device* dev, bool fromCache );
+
+            /**
+             * Applies the maximum speeds configured for the type of @p dev.
+             */
+            void applyConfiguredSpeeds( Device* dev ) const;
         };
     }
 }
@@ -0,0 +1,350 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#include "k3breadqueue.h"
+#include "k3bdevice.h"
+#include "k3bscsicommand.h"
+#include "k3bcommandtrace.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QVector>
+
+#include <string.h>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <scsi/sg.h>
+
+#if !defined(SG_FLAG_LUN_INHIBIT)
+# if defined(SG_FLAG_UNUSED_LUN_INHIBIT)
+#  define SG_FLAG_LUN_INHIBIT SG_FLAG_UNUSED_LUN_INHIBIT
+# else
+#  define SG_FLAG_LUN_INHIBIT 0
+# endif
+#endif
+#endif
+
+
+namespace {
+    // the sg driver accepts at most 16 commands per file handle (SG_MAX_QUEUE)
+    const int s_maxDepth = 16;
+
+    const int s_senseLength = 32;
+
+#ifdef Q_OS_LINUX
+    //
+    // The generic device of a drive is listed in sysfs below its block device,
+    // i.e. /sys/class/block/sr0/device/scsi_generic/sg1
+    //
+    QString genericDeviceName( const K3b::Device::Device* dev )
+    {
+        QString blockDevice = QFileInfo( dev->blockDeviceName() ).canonicalFilePath();
+        if( blockDevice.isEmpty() )
+            blockDevice = dev->blockDeviceName();
+
+        QDir dir( QString( "/sys/class/block/%1/device/scsi_generic" ).arg( blockDevice.section( '/', -1 ) ) );
+        const QStringList entries = dir.entryList( QDir::Dirs|QDir::NoDotAndDotDot );
+        if( entries.isEmpty() )
+            return QString();
+        else
+            return "/dev/" + entries.first();
+    }
+#endif
+}
+
+
+class K3b::Device::ReadQueue::Private
+{
+public:
+    struct Command {
+        unsigned char cdb[12];
+        unsigned char sense[s_senseLength];
+        unsigned int dataLen;
+        int result;
+        QElapsedTimer timer;
+#ifdef Q_OS_LINUX
+        struct sg_io_hdr sgIo;
+#endif
+    };
+
+    const Device* device;
+    int handle;
+    bool emulated;
+    int depth;
+    int first;
+    int pending;
+    int nextPackId;
+    QVector<Command> commands;
+};
+
+
+K3b::Device::ReadQueue::ReadQueue( const Device* dev )
+    : d( new Private )
+{
+    d->device = dev;
+    d->handle = -1;
+    d->emulated = false;
+    d->depth = 0;
+    d->first = 0;
+    d->pending = 0;
+    d->nextPackId = 0;
+}
+
+
+K3b::Device::ReadQueue::~ReadQueue()
+{
+    close();
+    delete d;
+}
+
+
+bool K3b::Device::ReadQueue::open( int depth )
+{
+    close();
+
+    if( transportHook() ) {
+        // emulated drives execute the commands right away
+        d->emulated = true;
+    }
+    else {
+#ifdef Q_OS_LINUX
+        const QString genericDevice = genericDeviceName( d->device );
+        if( genericDevice.isEmpty() ) {
+            qDebug() << "(K3b::Device::ReadQueue) no generic device found for" << d->device->blockDeviceName();
+            return false;
+        }
+
+        d->handle = ::open( QFile::encodeName( genericDevice ), O_RDWR|O_CLOEXEC );
+        if( d->handle < 0 ) {
+            qDebug() << "(K3b::Device::ReadQueue) could not open" << genericDevice << ::strerror( errno );
+            return false;
+        }
+
+        // asynchronous commands with sg_io_hdr need the version 3 interface
+        int version = 0;
+        int forcePackId = 1;
+        if( ::ioctl( d->handle, SG_GET_VERSION_NUM, &version ) < 0 || version < 30000 ||
+            ::ioctl( d->handle, SG_SET_FORCE_PACK_ID, &forcePackId ) < 0 ) {
+            qDebug() << "(K3b::Device::ReadQueue)" << genericDevice << "does not support queued commands.";
+            ::close( d->handle );
+            d->handle = -1;
+            return false;
+        }
+
+        qDebug() << "(K3b::Device::ReadQueue) using" << genericDevice << "for" << d->device->blockDeviceName();
+#else
+        return false;
+#endif
+    }
+
+    d->depth = qBound( 1, depth, s_maxDepth );
+    d->commands.resize( d->depth );
+    d->first = 0;
+    d->pending = 0;
+
+    return true;
+}
+
+
+void K3b::Device::ReadQueue::close()
+{
+    // the kernel may still write into the buffers of pending commands
+    while( d->pending > 0 )
+        waitForCompletion();
+
+#ifdef Q_OS_LINUX
+    if( d->handle >= 0 )
+        ::close( d->handle );
+#endif
+    d->handle = -1;
+    d->emulated = false;
+    d->depth = 0;
+}
+
+
+bool K3b::Device::ReadQueue::isOpen() const
+{
+    return d->depth > 0;
+}
+
+
+int K3b::Device::ReadQueue::depth() const
+{
+    return d->depth;
+}
+
+
+int K3b::Device::ReadQueue::pending() const
+{
+    return d->pending;
+}
+
+
+bool K3b::Device::ReadQueue::submitRead10( unsigned char* data,
+                                           unsigned int dataLen,
+                                           unsigned long startAdress,
+                                           unsigned int length )
+{
+    unsigned char cdb[12];
+    ::memset( cdb, 0, sizeof(cdb) );
+    cdb[0] = MMC_READ_10;
+    cdb[2] = startAdress>>24;
+    cdb[3] = startAdress>>16;
+    cdb[4] = startAdress>>8;
+    cdb[5] = startAdress;
+    cdb[7] = length>>8;
+    cdb[8] = length;
+
+    return submit( cdb, 10, data, dataLen );
+}
+
+
+bool K3b::Device::ReadQueue::submitReadCd( unsigned char* data,
+                                           unsigned int dataLen,
+                                           int sectorType,
+                                           bool dap,
+                                           unsigned long startAdress,
+                                           unsigned long length,
+                                           bool sync,
+                                           bool header,
+                                           bool subHeader,
+                                           bool userData,
+                                           bool edcEcc,
+                                           int c2,
+                                           int subChannel )
+{
+    unsigned char cdb[12];
+    ::memset( cdb, 0, sizeof(cdb) );
+    cdb[0] = MMC_READ_CD;
+    cdb[1] = (sectorType<<2 & 0x1c) | ( dap ? 0x2 : 0x0 );
+    cdb[2] = startAdress>>24;
+    cdb[3] = startAdress>>16;
+    cdb[4] = startAdress>>8;
+    cdb[5] = startAdress;
+    cdb[6] = length>>16;
+    cdb[7] = length>>8;
+    cdb[8] = length;
+    cdb[9] = ( ( sync      ? 0x80 : 0x0 ) |
+               ( subHeader ? 0x40 : 0x0 ) |
+               ( header    ? 0x20 : 0x0 ) |
+               ( userData  ? 0x10 : 0x0 ) |
+               ( edcEcc    ? 0x8  : 0x0 ) |
+               ( c2<<1 & 0x6 ) );
+    cdb[10] = subChannel & 0x7;
+
+    return submit( cdb, 12, data, dataLen );
+}
+
+
+bool K3b::Device::ReadQueue::submit( const unsigned char* cdb, int cdbLen, unsigned char* data, unsigned int dataLen )
+{
+    if( !isOpen() || d->pending >= d->depth )
+        return false;
+
+    Private::Command& command = d->commands[( d->first + d->pending ) % d->depth];
+    ::memcpy( command.cdb, cdb, sizeof(command.cdb) );
+    ::memset( command.sense, 0, s_senseLength );
+    ::memset( data, 0, dataLen );
+    command.dataLen = dataLen;
+    command.timer.start();
+
+    if( d->emulated ) {
+        HandleReference ref( d->device );
+        if( ref.isValid() )
+            command.result = transportHook()( d->device, command.cdb, TR_DIR_READ, data, dataLen, command.sense );
+        else
+            command.result = -1;
+    }
+#ifdef Q_OS_LINUX
+    else {
+        struct sg_io_hdr& sgIo = command.sgIo;
+        ::memset( &sgIo, 0, sizeof(struct sg_io_hdr) );
+        sgIo.interface_id    = 'S';
+        sgIo.dxfer_direction = SG_DXFER_FROM_DEV;
+        sgIo.cmd_len         = cdbLen;
+        sgIo.mx_sb_len       = s_senseLength;
+        sgIo.cmdp            = command.cdb;
+        sgIo.sbp             = command.sense;
+        sgIo.flags           = SG_FLAG_LUN_INHIBIT;
+        sgIo.dxferp          = data;
+        sgIo.dxfer_len       = dataLen;
+        sgIo.timeout         = 5000;
+        sgIo.pack_id         = d->nextPackId++;
+
+        ssize_t r = 0;
+        do {
+            r = ::write( d->handle, &sgIo, sizeof(struct sg_io_hdr) );
+        } while( r < 0 && errno == EINTR );
+
+        if( r < 0 ) {
+            qDebug() << "(K3b::Device::ReadQueue) failed to queue" << commandString( cdb[0] ) << ::strerror( errno );
+            return false;
+        }
+    }
+#endif
+
+    ++d->pending;
+    return true;
+}
+
+
+bool K3b::Device::ReadQueue::waitForCompletion()
+{
+    if( d->pending == 0 )
+        return false;
+
+    Private::Command& command = d->commands[d->first];
+    d->first = ( d->first + 1 ) % d->depth;
+    --d->pending;
+
+    if( !d->emulated ) {
+#ifdef Q_OS_LINUX
+        // with SG_SET_FORCE_PACK_ID read() returns the reply to this very command
+        struct sg_io_hdr reply;
+        ::memset( &reply, 0, sizeof(struct sg_io_hdr) );
+        reply.interface_id = 'S';
+        reply.dxfer_direction = SG_DXFER_FROM_DEV;
+        reply.pack_id = command.sgIo.pack_id;
+
+        ssize_t r = 0;
+        do {
+            r = ::read( d->handle, &reply, sizeof(struct sg_io_hdr) );
+        } while( r < 0 && errno == EINTR );
+
+        if( r < 0 )
+            command.result = -1;
+        else if( ( reply.info&SG_INFO_OK_MASK ) != SG_INFO_OK )
+            command.result = 1;
+        else
+            command.result = 0;
+#else
+        command.result = -1;
+#endif
+    }
+
+    // for queued commands this includes the time spent waiting behind the earlier ones
+    d->device->commandTrace()->record( command.cdb[0], command.dataLen, command.timer.nsecsElapsed()/1000, command.result,
+                                       command.sense[2] & 0xF, command.sense[12], command.sense[13] );
+
+    if( command.result ) {
+        qDebug() << "(K3b::Device::ReadQueue)" << d->device->blockDeviceName() << ":"
+                 << commandString( command.cdb[0] ) << "failed:"
+                 << "sense key" << QString::number( command.sense[2] & 0xF, 16 )
+                 << "asc" << QString::number( command.sense[12], 16 )
+                 << "ascq" << QString::number( command.sense[13], 16 );
+        return false;
+    }
+    else {
+        return true;
+    }
+}
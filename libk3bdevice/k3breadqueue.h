@@ -0,0 +1,110 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+#ifndef _K3B_READ_QUEUE_H_
+#define _K3B_READ_QUEUE_H_
+
+#include "k3bdevice_export.h"
+
+#include <qglobal.h>
+
+namespace K3b {
+    namespace Device
+    {
+        class Device;
+
+        /**
+         * The ReadQueue sends READ commands to a drive without waiting for them
+         * to finish. This keeps the drive busy while the data of earlier commands
+         * is processed.
+         *
+         * On Linux the commands are queued via the asynchronous interface of the
+         * SCSI generic driver (write/read on /dev/sg*). On other systems or if
+         * the drive has no generic device open() fails and the caller needs to
+         * fall back to the synchronous reading methods of Device.
+         *
+         * Commands finish in the order they were submitted. The data buffers
+         * need to stay valid until the command has been completed via
+         * waitForCompletion() or close().
+         */
+        class LIBK3BDEVICE_EXPORT ReadQueue
+        {
+        public:
+            explicit ReadQueue( const Device* dev );
+            ~ReadQueue();
+
+            /**
+             * Open the queue with room for @p depth commands in flight.
+             * The depth is limited to what the generic driver supports.
+             *
+             * \return false if queued reading is not supported.
+             */
+            bool open( int depth );
+
+            /**
+             * Waits for all pending commands and closes the queue.
+             */
+            void close();
+
+            bool isOpen() const;
+
+            /**
+             * \return The maximum number of commands in flight.
+             */
+            int depth() const;
+
+            /**
+             * \return The number of submitted commands which have not been
+             *         completed yet.
+             */
+            int pending() const;
+
+            /**
+             * Queues a READ 10 command. See Device::read10 for the parameters.
+             *
+             * \return false if the command could not be queued. This happens if
+             *         depth() commands are pending already.
+             */
+            bool submitRead10( unsigned char* data,
+                               unsigned int dataLen,
+                               unsigned long startAdress,
+                               unsigned int length );
+
+            /**
+             * Queues a READ CD command. See Device::readCd for the parameters.
+             */
+            bool submitReadCd( unsigned char* data,
+                               unsigned int dataLen,
+                               int sectorType,
+                               bool dap,
+                               unsigned long startAdress,
+                               unsigned long length,
+                               bool sync,
+                               bool header,
+                               bool subHeader,
+                               bool userData,
+                               bool edcEcc,
+                               int c2,
+                               int subChannel );
+
+            /**
+             * Blocks until the oldest pending command has finished.
+             *
+             * \return true if the command succeeded.
+             */
+            bool waitForCompletion();
+
+        private:
+            bool submit( const unsigned char* cdb, int cdbLen, unsigned char* data, unsigned int dataLen );
+
+            class Private;
+            Private* const d;
+
+            Q_DISABLE_COPY( ReadQueue )
+        };
+    }
+}
+
+#endif
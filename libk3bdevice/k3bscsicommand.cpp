@@ -8,6 +8,23 @@
 #include <QDebug>
 
 
+namespace {
+    K3b::Device::TransportHook s_transportHook = 0;
+}
+
+
+void K3b::Device::setTransportHook( TransportHook hook )
+{
+    s_transportHook = hook;
+}
+
+
+K3b::Device::TransportHook K3b::Device::transportHook()
+{
+    return s_transportHook;
+}
+
+
 QString K3b::Device::commandString( const unsigned char& command )
 {
     if( command == MMC_BLANK )
@@ -75,6 +75,36 @@ namespace K3b {
             TR_DIR_WRITE
         };
 
+        /**
+         * A transport hook replaces the ioctl which sends a command to the drive.
+         * It is used to emulate drives in the unit tests.
+         *
+         * The hook is called with the device already opened. @p cdb points to the
+         * 12 command bytes and @p sense to a buffer of 18 bytes which should be
+         * filled with fixed format sense data in case of an error.
+         *
+         * \return 0 on success, non-zero otherwise.
+         */
+        typedef int (*TransportHook)( const Device* dev,
+                                      const unsigned char* cdb,
+                                      TransportDirection dir,
+                                      unsigned char* data,
+                                      size_t len,
+                                      unsigned char* sense );
+
+        /**
+         * Install @p hook for all commands sent via ScsiCommand. Use 0 to
+         * restore the default transport.
+         *
+         * So far this is only supported on Linux.
+         */
+        LIBK3BDEVICE_EXPORT void setTransportHook( TransportHook hook );
+
+        /**
+         * \return the currently installed transport hook or 0.
+         */
+        TransportHook transportHook();
+
         class ScsiCommand
         {
         public:
@@ -8,8 +8,10 @@
 
 #include "k3bscsicommand.h"
 #include "k3bdevice.h"
+#include "k3bcommandtrace.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include <stdio.h>
 #include <errno.h>
@@ -75,7 +77,11 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
         return -1;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
     int ret = d->transport( m_device, dir, data, len );
+    const quint32 duration = timer.nsecsElapsed()/1000;
     if( ret != 0 ) {
         const struct scsi_sense_data& s = d->get_ccb().csio.sense_data;
         int errorCode, senseKey, addSenseCode, addSenseCodeQual;
@@ -86,6 +92,11 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
                     senseKey,
                     addSenseCode,
                     addSenseCodeQual );
+        m_device->commandTrace()->record( d->get_ccb().csio.cdb_io.cdb_bytes[0], len, duration, ret,
+                                          senseKey, addSenseCode, addSenseCodeQual );
+    }
+    else {
+        m_device->commandTrace()->record( d->get_ccb().csio.cdb_io.cdb_bytes[0], len, duration, ret );
     }
 
     if( needToClose )
@@ -10,8 +10,10 @@
 
 #include "k3bscsicommand.h"
 #include "k3bdevice.h"
+#include "k3bcommandtrace.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include <sys/ioctl.h>
 #undef __STRICT_ANSI__
@@ -105,8 +107,14 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
 
     int i = -1;
 
+    QElapsedTimer timer;
+    timer.start();
+
+    if( s_transportHook ) {
+        i = s_transportHook( m_device, d->cmd.cmd, dir, (unsigned char*)data, len, (unsigned char*)&d->sense );
+    }
 #ifdef SG_IO
-    if( d->useSgIo ) {
+    else if( d->useSgIo ) {
         d->sgIo.interface_id= 'S';
         d->sgIo.mx_sb_len = sizeof( struct request_sense );
         d->sgIo.cmdp      = d->cmd.cmd;
@@ -127,8 +135,8 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
         if( ( d->sgIo.info&SG_INFO_OK_MASK ) != SG_INFO_OK )
             i = -1;
     }
-    else {
 #endif
+    else {
         d->cmd.buffer = (unsigned char*)data;
         d->cmd.buflen = len;
         if( dir == TR_DIR_READ )
@@ -139,9 +147,10 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
             d->cmd.data_direction = CGC_DATA_NONE;
 
         i = ::ioctl( deviceHandle, CDROM_SEND_PACKET, &d->cmd );
-#ifdef SG_IO
     }
-#endif
+
+    m_device->commandTrace()->record( d->cmd.cmd[0], len, timer.nsecsElapsed()/1000, i,
+                                      d->sense.sense_key, d->sense.asc, d->sense.ascq );
 
     if( needToClose )
         m_device->close();
@@ -158,10 +167,10 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
                     d->sense.ascq );
 
         int errCode =
-            ((d->sense.error_code<<24) & 0xF000) |
-            ((d->sense.sense_key<<16)  & 0x0F00) |
-            ((d->sense.asc<<8)         & 0x00F0) |
-            ((d->sense.ascq)           & 0x000F);
+            ((d->sense.error_code<<24) & 0x7F000000) |
+            ((d->sense.sense_key<<16)  & 0x000F0000) |
+            ((d->sense.asc<<8)         & 0x0000FF00) |
+            ((d->sense.ascq)           & 0x000000FF);
 
         return( errCode != 0 ? errCode : 1 );
     }
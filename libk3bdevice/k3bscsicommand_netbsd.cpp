@@ -8,8 +8,10 @@
 
 #include "k3bscsicommand.h"
 #include "k3bdevice.h"
+#include "k3bcommandtrace.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
 
 #include <sys/ioctl.h>
 #include <sys/scsiio.h>
@@ -82,7 +84,15 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
         break;
     }
 
+    QElapsedTimer timer;
+    timer.start();
+
     int i = ::ioctl( deviceHandle, SCIOCCOMMAND, &d->cmd );
+    if( !i && d->cmd.retsts != SCCMD_OK )
+        i = 1;
+
+    m_device->commandTrace()->record( d->cmd.cmd[0], len, timer.nsecsElapsed()/1000, i,
+                                      d->cmd.sense[2] & 0xF, d->cmd.sense[12], d->cmd.sense[13] );
 
     if ( m_device ) {
         if( needToClose )
@@ -90,14 +100,24 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
         m_device->usageUnlock();
     }
 
-    if( i || (d->cmd.retsts != SCCMD_OK)) {
+    if( i ) {
         debugError( d->cmd.cmd[0],
                     d->cmd.retsts,
                     d->cmd.sense[2],
                     d->cmd.sense[12],
                     d->cmd.sense[13] );
 
-        return 1;
+        // the sense data is only valid if the drive returned some
+        if( d->cmd.retsts != SCCMD_SENSE )
+            return 1;
+
+        int errCode =
+            ((d->cmd.sense[0]<<24)  & 0x7F000000) |
+            ((d->cmd.sense[2]<<16)  & 0x000F0000) |
+            ((d->cmd.sense[12]<<8)  & 0x0000FF00) |
+            ((d->cmd.sense[13])     & 0x000000FF);
+
+        return( errCode != 0 ? errCode : 1 );
     }
     else
         return 0;
@@ -99,10 +99,10 @@ int K3b::Device::ScsiCommand::transport( TransportDirection dir,
             d->m_senseData.SD_ASCQ );
 
         int errCode =
-            (d->m_senseData.SD_Error << 24)    & 0xF000 |
-            (d->m_senseData.SD_SenseKey << 16) & 0x0F00 |
-            (d->m_senseData.SD_ASC << 8)       & 0x00F0 |
-            (d->m_senseData.SD_ASCQ)           & 0x000F;
+            (d->m_senseData.SD_Error << 24)    & 0x7F000000 |
+            (d->m_senseData.SD_SenseKey << 16) & 0x000F0000 |
+            (d->m_senseData.SD_ASC << 8)       & 0x0000FF00 |
+            (d->m_senseData.SD_ASCQ)           & 0x000000FF;
 
         return ( errCode != 0 ? errCode : 1 );
     }
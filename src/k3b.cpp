@@ -51,6 +51,7 @@
 #include "k3bview.h"
 #include "k3bwelcomewidget.h"
 #include "misc/k3bimagewritingdialog.h"
+#include "misc/k3bbatchingestdialog.h"
 #include "misc/k3bmediacopydialog.h"
 #include "misc/k3bmediaformattingdialog.h"
 #include "option/k3boptiondialog.h"
@@ -410,6 +411,12 @@ void K3b::MainWindow::initActions()
     actionCollection()->addAction( "tools_copy_medium", actionToolsMediaCopy );
     connect( actionToolsMediaCopy, SIGNAL(triggered(bool)), this, SLOT(slotMediaCopy()) );
 
+    QAction* actionToolsBatchIngest = new QAction( QIcon::fromTheme( "media-optical-data" ), i18n("&Image Several Discs..."), this );
+    actionToolsBatchIngest->setToolTip( i18n("Read every disc inserted into the selected drives into an image") );
+    actionToolsBatchIngest->setStatusTip( actionToolsBatchIngest->toolTip() );
+    actionCollection()->addAction( "tools_batch_ingest", actionToolsBatchIngest );
+    connect( actionToolsBatchIngest, SIGNAL(triggered(bool)), this, SLOT(slotBatchIngest()) );
+
     QAction* actionToolsCddaRip = new QAction( QIcon::fromTheme( "tools-rip-audio-cd" ), i18n("Rip Audio CD..."), this );
     actionToolsCddaRip->setToolTip( i18n("Digitally extract tracks from an audio CD") );
     actionToolsCddaRip->setStatusTip( actionToolsCddaRip->toolTip() );
@@ -1329,6 +1336,20 @@ void K3b::MainWindow::slotMediaCopy()
 }
 
 
+void K3b::MainWindow::batchIngest( const QString& targetDir )
+{
+    K3b::BatchIngestDialog d( this );
+    d.setTargetDirectory( targetDir );
+    d.exec();
+}
+
+
+void K3b::MainWindow::slotBatchIngest()
+{
+    batchIngest( QString() );
+}
+
+
 // void K3b::MainWindow::slotVideoDvdCopy()
 // {
 //   K3b::VideoDvdCopyDialog d( this );
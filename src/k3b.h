@@ -83,6 +83,8 @@ namespace K3b {
         void slotFormatMedium();
         void mediaCopy( K3b::Device::Device* );
         void slotMediaCopy();
+        void batchIngest( const QString& targetDir );
+        void slotBatchIngest();
         void cddaRip( K3b::Device::Device* );
         void slotCddaRip();
         void videoDvdRip( K3b::Device::Device* );
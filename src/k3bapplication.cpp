@@ -190,6 +190,10 @@ void K3b::Application::processCmdLineArgs()
         dialogOpen = true;
         m_mainWindow->formatMedium( m_core->deviceManager()->findDeviceByUdi( m_cmdLine->value( "format" ) ) );
     }
+    else if( m_cmdLine->isSet("ingest") ) {
+        dialogOpen = true;
+        m_mainWindow->batchIngest( m_cmdLine->value( "ingest" ) );
+    }
 
     // no dialog used here
     if( m_cmdLine->isSet( "cddarip" ) ) {
@@ -6,6 +6,7 @@
 #include "k3bburnprogressdialog.h"
 
 #include "k3bapplication.h"
+#include "k3bburntelemetry.h"
 #include "k3bdevice.h"
 #include "k3bjob.h"
 #include "k3bstdguiitems.h"
@@ -14,10 +15,20 @@
 
 #include <KLocalizedString>
 
+#include <QDateTime>
+#include <QDir>
 #include <QLocale>
 #include <QGridLayout>
 #include <QLabel>
 #include <QProgressBar>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+
+namespace {
+    // the number of telemetry logs kept to compare burns
+    const int s_maxTelemetryLogs = 20;
+}
 
 
 K3b::BurnProgressDialog::BurnProgressDialog( QWidget *parent, bool showSubProgress )
@@ -54,7 +65,18 @@ K3b::BurnProgressDialog::BurnProgressDialog( QWidget *parent, bool showSubProgre
 
     m_progressDeviceBuffer = new QProgressBar( m_frameExtraInfo );
     m_frameExtraInfoLayout->addWidget( m_progressDeviceBuffer, 2, 3 );
-    m_frameExtraInfoLayout->addWidget( K3b::StdGuiItems::verticalLine( m_frameExtraInfo ), 1, 1, 2, 1 );
+
+    // only shown for jobs which use a prefetch buffer
+    m_labelPrefetchBuffer = new QLabel( i18n("Prefetch buffer:"), m_frameExtraInfo );
+    m_frameExtraInfoLayout->addWidget( m_labelPrefetchBuffer, 3, 2 );
+    m_progressPrefetchBuffer = new QProgressBar( m_frameExtraInfo );
+    m_frameExtraInfoLayout->addWidget( m_progressPrefetchBuffer, 3, 3 );
+    m_labelPrefetchBuffer->hide();
+    m_progressPrefetchBuffer->hide();
+
+    m_frameExtraInfoLayout->addWidget( K3b::StdGuiItems::verticalLine( m_frameExtraInfo ), 1, 1, 3, 1 );
+
+    m_telemetry = new K3b::BurnTelemetry( this );
 }
 
 K3b::BurnProgressDialog::~BurnProgressDialog()
@@ -73,14 +95,19 @@ void K3b::BurnProgressDialog::setJob( K3b::Job* job )
 
 void K3b::BurnProgressDialog::setBurnJob( K3b::BurnJob* burnJob )
 {
+    // connect first to get the last sample before slotFinished is called
+    m_telemetry->setJob( burnJob );
+
     K3b::JobProgressDialog::setJob(burnJob);
 
     if( burnJob ) {
         connect( burnJob, SIGNAL(bufferStatus(int)), this, SLOT(slotBufferStatus(int)) );
         connect( burnJob, SIGNAL(deviceBuffer(int)), this, SLOT(slotDeviceBuffer(int)) );
+        connect( burnJob, SIGNAL(prefetchBuffer(int)), this, SLOT(slotPrefetchBuffer(int)) );
         connect( burnJob, SIGNAL(writeSpeed(int,K3b::Device::SpeedMultiplicator)), this, SLOT(slotWriteSpeed(int,K3b::Device::SpeedMultiplicator)) );
         connect( burnJob, SIGNAL(burning(bool)), m_progressWritingBuffer, SLOT(setEnabled(bool)) );
         connect( burnJob, SIGNAL(burning(bool)), m_progressDeviceBuffer, SLOT(setEnabled(bool)) );
+        connect( burnJob, SIGNAL(burning(bool)), m_progressPrefetchBuffer, SLOT(setEnabled(bool)) );
         connect( burnJob, SIGNAL(burning(bool)), m_labelWritingSpeed, SLOT(setEnabled(bool)) );
 
         if( burnJob->writer() )
@@ -90,21 +117,53 @@ void K3b::BurnProgressDialog::setBurnJob( K3b::BurnJob* burnJob )
         m_labelWritingSpeed->setText( i18n("no info") );
         m_progressWritingBuffer->setFormat( i18n("no info") );
         m_progressDeviceBuffer->setFormat( i18n("no info") );
+        m_prefetchHistory.clear();
     }
 }
 
 
 void K3b::BurnProgressDialog::slotFinished( bool success )
 {
+    logTelemetry();
+
     K3b::JobProgressDialog::slotFinished( success );
     if( success ) {
         m_labelWritingSpeed->setEnabled( false );
         m_progressWritingBuffer->setEnabled( false );
         m_progressDeviceBuffer->setEnabled( false );
+        m_progressPrefetchBuffer->setEnabled( false );
     }
 }
 
 
+void K3b::BurnProgressDialog::logTelemetry()
+{
+    if( m_telemetry->samples().isEmpty() )
+        return;
+
+    Q_FOREACH( const QString& line, m_telemetry->summary().split( '\n' ) )
+        slotDebuggingOutput( "Burn Telemetry", line );
+    Q_FOREACH( const QString& line, m_telemetry->toCsv().split( '\n' ) )
+        slotDebuggingOutput( "Burn Telemetry CSV", line );
+
+    //
+    // The binary log of every burn is kept to be summarized and compared with
+    // k3btelemetry. The timestamp in the name sorts the logs by age.
+    //
+    QDir dir( QStandardPaths::writableLocation( QStandardPaths::AppDataLocation ) + "/telemetry" );
+    if( !dir.mkpath( "." ) )
+        return;
+
+    QSaveFile file( dir.filePath( QDateTime::currentDateTime().toString( "yyyyMMdd-HHmmss-zzz" ) + ".telemetry" ) );
+    if( !file.open( QIODevice::WriteOnly ) || !m_telemetry->save( &file ) || !file.commit() )
+        return;
+
+    const QStringList logs = dir.entryList( QStringList() << "*.telemetry", QDir::Files, QDir::Name );
+    for( int i = 0; i < logs.count() - s_maxTelemetryLogs; ++i )
+        dir.remove( logs[i] );
+}
+
+
 void K3b::BurnProgressDialog::slotBufferStatus( int b )
 {
     m_progressWritingBuffer->setFormat( "%p%" );
@@ -119,6 +178,27 @@ void K3b::BurnProgressDialog::slotDeviceBuffer( int b )
 }
 
 
+void K3b::BurnProgressDialog::slotPrefetchBuffer( int b )
+{
+    if( m_progressPrefetchBuffer->isHidden() ) {
+        m_labelPrefetchBuffer->show();
+        m_progressPrefetchBuffer->show();
+    }
+
+    // the buffer reports its fill level twice a second
+    m_prefetchHistory.append( b );
+    while( m_prefetchHistory.count() > 120 )
+        m_prefetchHistory.removeFirst();
+
+    int lowest = b;
+    Q_FOREACH( int level, m_prefetchHistory )
+        lowest = qMin( lowest, level );
+
+    m_progressPrefetchBuffer->setValue( b );
+    m_progressPrefetchBuffer->setToolTip( i18n("Lowest fill level during the last minute: %1%", lowest) );
+}
+
+
 void K3b::BurnProgressDialog::slotWriteSpeed( int s, K3b::Device::SpeedMultiplicator multiplicator )
 {
     m_labelWritingSpeed->setText( QString("%1 KB/s (%2x)").arg(s).arg(QLocale::system().toString((double)s/(double)multiplicator,'g',2)) );
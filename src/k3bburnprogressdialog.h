@@ -9,11 +9,14 @@
 #include "k3bjobprogressdialog.h"
 #include "k3bdevicetypes.h"
 
+#include <QList>
+
 class QProgressBar;
 class QLabel;
 
 namespace K3b {
     class BurnJob;
+    class BurnTelemetry;
     class ThemedLabel;
 
     /**
@@ -34,13 +37,28 @@ namespace K3b {
         void slotWriteSpeed( int, K3b::Device::SpeedMultiplicator );
         void slotBufferStatus( int );
         void slotDeviceBuffer( int );
+        void slotPrefetchBuffer( int );
         void slotFinished(bool) override;
 
     protected:
         ThemedLabel* m_labelWriter;
         QProgressBar* m_progressWritingBuffer;
         QProgressBar* m_progressDeviceBuffer;
+        QLabel* m_labelPrefetchBuffer;
+        QProgressBar* m_progressPrefetchBuffer;
         QLabel* m_labelWritingSpeed;
+
+    private:
+        /**
+         * Adds the recorded telemetry to the debugging output and saves
+         * it next to the log file.
+         */
+        void logTelemetry();
+
+        // the fill levels of the prefetch buffer during the last minute
+        QList<int> m_prefetchHistory;
+
+        BurnTelemetry* m_telemetry;
     };
 }
 
@@ -11,6 +11,8 @@
 #include "k3b.h"
 #include "k3bapplication.h"
 #include "k3bcore.h"
+#include "k3bcommandtrace.h"
+#include "k3bdevice.h"
 #include "k3bdevicemanager.h"
 #include "k3bdoc.h"
 #include "k3bglobals.h"
@@ -18,6 +20,7 @@
 #include "k3bview.h"
 
 #include <QList>
+#include <QSaveFile>
 #include <QTimer>
 #include <QDBusConnection>
 
@@ -204,6 +207,28 @@ bool Interface::blocked() const
     return k3bcore->jobsRunning();
 }
 
+
+QString Interface::commandStatistics( const QString& dev )
+{
+    if( Device::Device* device = k3bcore->deviceManager()->findDeviceByUdi( dev ) )
+        return device->commandTrace()->toString();
+    else
+        return QString();
+}
+
+
+bool Interface::saveCommandTrace( const QString& dev, const QString& path )
+{
+    Device::Device* device = k3bcore->deviceManager()->findDeviceByUdi( dev );
+    if( !device )
+        return false;
+
+    QSaveFile file( path );
+    return( file.open( QIODevice::WriteOnly ) &&
+            device->commandTrace()->save( &file ) &&
+            file.commit() );
+}
+
 } // namespace K3b
 
 #include "moc_k3binterface.cpp"
@@ -73,6 +73,18 @@ namespace K3b {
         */
         bool blocked() const;
 
+        /**
+        * @return the per-command statistics of the device with the
+        * Solid UDI @p dev as human readable table.
+        */
+        QString commandStatistics( const QString& dev );
+
+        /**
+        * Save the last commands sent to the device with the Solid UDI
+        * @p dev to @p path in the binary trace format.
+        */
+        bool saveCommandTrace( const QString& dev, const QString& path );
+
     private:
         MainWindow* m_main;
     };
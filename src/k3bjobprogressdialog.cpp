@@ -16,7 +16,9 @@
 #include "k3b.h"
 #include "k3bjob.h"
 #include "k3bdevice.h"
+#include "k3bcommandtrace.h"
 #include "k3bdevicemanager.h"
+#include "k3bcore.h"
 #include "k3bdeviceglobals.h"
 #include "k3bglobals.h"
 #include "k3bkjobbridge.h"
@@ -47,10 +49,13 @@
 #include <QFrame>
 #include <QGridLayout>
 #include <QHBoxLayout>
+#include <QHash>
 #include <QLabel>
 #include <QProgressBar>
 #include <QPushButton>
+#include <QSaveFile>
 #include <QScrollBar>
+#include <QStandardPaths>
 #include <QTreeWidget>
 #include <QVBoxLayout>
 
@@ -60,6 +65,10 @@ class K3b::JobProgressDialog::Private
 public:
     int lastProgress;
 
+    // the commands sent before the job started are not part of its log
+    QHash<K3b::Device::Device*, K3b::Device::CommandTrace::Snapshot> traceSnapshots;
+    QList<K3b::Device::Device*> usedDevices;
+
     QFrame* headerFrame;
     QFrame* progressHeaderFrame;
     QTreeWidget* viewInfo;
@@ -79,6 +88,9 @@ K3b::JobProgressDialog::JobProgressDialog( QWidget* parent,
     }
 
     m_job = 0;
+
+    connect( k3bcore, SIGNAL(deviceInUse(K3b::Device::Device*)),
+             this, SLOT(slotDeviceInUse(K3b::Device::Device*)) );
 }
 
 
@@ -361,6 +373,7 @@ void K3b::JobProgressDialog::slotFinished( bool success )
 {
     qDebug() << "received finished signal!";
 
+    logCommandTraces();
     m_logFile.close();
 
     const KColorScheme colorScheme( QPalette::Normal, KColorScheme::Window );
@@ -440,6 +453,12 @@ void K3b::JobProgressDialog::setJob( K3b::Job* job )
         m_labelTask->setPalette( k3bappcore->themeManager()->currentTheme()->palette() );
     m_logCache.clear();
 
+    // only the commands of this job should end up in the log
+    d->traceSnapshots.clear();
+    d->usedDevices.clear();
+    Q_FOREACH( K3b::Device::Device* dev, k3bcore->deviceManager()->allDevices() )
+        d->traceSnapshots.insert( dev, dev->commandTrace()->snapshot() );
+
     // disconnect from the former job
     if( m_job )
         disconnect( m_job );
@@ -522,6 +541,43 @@ void K3b::JobProgressDialog::slotStarted()
 }
 
 
+void K3b::JobProgressDialog::slotDeviceInUse( K3b::Device::Device* dev )
+{
+    if( m_job && !d->usedDevices.contains( dev ) )
+        d->usedDevices.append( dev );
+}
+
+
+void K3b::JobProgressDialog::logCommandTraces()
+{
+    const QString dirPath = QStandardPaths::writableLocation( QStandardPaths::AppDataLocation );
+
+    QList<K3b::Device::Device*> devices = d->usedDevices;
+    if( m_job && m_job->writer() && !devices.contains( m_job->writer() ) )
+        devices.append( m_job->writer() );
+
+    Q_FOREACH( K3b::Device::Device* dev, devices ) {
+        // devices which have been removed in the meantime
+        if( !k3bcore->deviceManager()->allDevices().contains( dev ) )
+            continue;
+
+        K3b::Device::CommandTrace* trace = dev->commandTrace();
+        const K3b::Device::CommandTrace::Snapshot since = d->traceSnapshots.value( dev );
+        if( trace->commands( since ) == 0 )
+            continue;
+
+        const QString group = QString( "SCSI Commands %1" ).arg( dev->blockDeviceName() );
+        Q_FOREACH( const QString& line, trace->toString( since ).split( '\n' ) )
+            slotDebuggingOutput( group, line );
+
+        // the binary trace of the last commands goes next to the log file
+        QSaveFile file( dirPath + QString( "/lastlog-%1.trace" ).arg( dev->blockDeviceName().section( '/', -1 ) ) );
+        if( file.open( QIODevice::WriteOnly ) && trace->save( &file, since ) )
+            file.commit();
+    }
+}
+
+
 void K3b::JobProgressDialog::slotDebuggingOutput( const QString& type, const QString& output )
 {
     m_logCache.addOutput( type, output );
@@ -28,6 +28,9 @@ class QElapsedTimer;
 namespace K3b {
     class Job;
     class ThemedLabel;
+    namespace Device {
+        class Device;
+    }
 
     class JobProgressDialog : public QDialog, public JobHandler
     {
@@ -121,7 +124,16 @@ namespace K3b {
 
         QGridLayout* m_frameExtraInfoLayout;
 
+    private Q_SLOTS:
+        void slotDeviceInUse( K3b::Device::Device* dev );
+
     private:
+        /**
+         * Adds the command statistics of the devices used by the job to the log
+         * and saves their command traces next to the log file.
+         */
+        void logCommandTraces();
+
         class Private;
         Private* d;
 
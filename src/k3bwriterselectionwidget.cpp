@@ -500,9 +500,9 @@ void K3b::WriterSelectionWidget::slotRefreshWritingApps()
 
     // select the ones that make sense
     if( Device::isDvdMedia( k3bappcore->mediaCache()->diskInfo( writerDevice() ).mediaType() ) )
-        i = K3b::WritingAppGrowisofs|K3b::WritingAppDvdRwFormat|K3b::WritingAppCdrecord;
+        i = K3b::WritingAppGrowisofs|K3b::WritingAppDvdRwFormat|K3b::WritingAppCdrecord|K3b::WritingAppNative;
     else if ( K3b::Device::isBdMedia( k3bappcore->mediaCache()->diskInfo( writerDevice() ).mediaType() ) )
-        i = K3b::WritingAppGrowisofs|K3b::WritingAppCdrecord;
+        i = K3b::WritingAppGrowisofs|K3b::WritingAppCdrecord|K3b::WritingAppNative;
     else
         i = K3b::WritingAppCdrdao|K3b::WritingAppCdrecord;
 
@@ -522,6 +522,8 @@ void K3b::WriterSelectionWidget::slotRefreshWritingApps()
         m_comboWritingApp->insertItem( K3b::WritingAppDvdRwFormat, "dvd+rw-format" );
     if (i & K3b::WritingAppCdrskin)
         m_comboWritingApp->insertItem(K3b::WritingAppCdrskin, "cdrskin");
+    if( i & K3b::WritingAppNative )
+        m_comboWritingApp->insertItem( K3b::WritingAppNative, "native" );
 
     m_comboWritingApp->setSelectedValue( lastSelected );
 
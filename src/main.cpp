@@ -113,6 +113,7 @@ int main( int argc, char* argv[] )
     parser->addOption( QCommandLineOption( "copy", i18n("Open the copy dialog, optionally specify the source device"), "device" ) );
     parser->addOption( QCommandLineOption( "image", i18n("Write an image to a CD or DVD"), "url" ) );
     parser->addOption( QCommandLineOption( "format", i18n("Format a rewritable medium"), "device" ) );
+    parser->addOption( QCommandLineOption( "ingest", i18n("Read every inserted disc into an image in the given folder"), "folder" ) );
     parser->addOption( QCommandLineOption( "cddarip", i18n("Extract Audio tracks digitally (+encoding)"), "device" ) );
     parser->addOption( QCommandLineOption( "videodvdrip", i18n("Rip Video DVD Titles (+transcoding)"), "device" ) );
     parser->addOption( QCommandLineOption( "videocdrip", i18n("Rip Video CD Tracks"), "device" ) );
@@ -0,0 +1,213 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bbatchingestdialog.h"
+
+#include "k3bbatchingestjob.h"
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3bdevicemanager.h"
+#include "k3bglobals.h"
+#include "k3bjobprogressdialog.h"
+#include "k3bstdguiitems.h"
+
+#include <KConfig>
+#include <KSharedConfig>
+#include <KLocalizedString>
+#include <KUrlRequester>
+
+#include <QCheckBox>
+#include <QDir>
+#include <QGroupBox>
+#include <QLabel>
+#include <QLayout>
+#include <QListWidget>
+#include <QSpinBox>
+
+
+K3b::BatchIngestDialog::BatchIngestDialog( QWidget* parent )
+    : K3b::InteractionDialog( parent,
+                              i18n("Image Several Discs"),
+                              i18n("Every inserted disc is read into an image"),
+                              START_BUTTON|CANCEL_BUTTON,
+                              START_BUTTON,
+                              "Batch Imaging" ) // config group
+{
+    QWidget* frame = mainWidget();
+
+    QGroupBox* groupDevices = new QGroupBox( i18n("Drives"), frame );
+    m_listDevices = new QListWidget( groupDevices );
+    Q_FOREACH( K3b::Device::Device* dev, k3bcore->deviceManager()->readingDevices() ) {
+        QListWidgetItem* item = new QListWidgetItem( QString( "%1 %2 (%3)" )
+                                                     .arg( dev->vendor() )
+                                                     .arg( dev->description() )
+                                                     .arg( dev->blockDeviceName() ),
+                                                     m_listDevices );
+        item->setData( Qt::UserRole, dev->blockDeviceName() );
+        item->setCheckState( Qt::Checked );
+    }
+    QVBoxLayout* groupDevicesLayout = new QVBoxLayout( groupDevices );
+    groupDevicesLayout->addWidget( m_listDevices );
+
+    QGroupBox* groupDirectory = new QGroupBox( i18n("Destination"), frame );
+    m_editDirectory = new KUrlRequester( groupDirectory );
+    m_editDirectory->setMode( KFile::Directory | KFile::LocalOnly );
+    QLabel* directoryLabel = new QLabel( i18n("Write images to:"), groupDirectory );
+    directoryLabel->setBuddy( m_editDirectory );
+    QHBoxLayout* groupDirectoryLayout = new QHBoxLayout( groupDirectory );
+    groupDirectoryLayout->addWidget( directoryLabel );
+    groupDirectoryLayout->addWidget( m_editDirectory, 1 );
+
+    QGroupBox* groupOptions = new QGroupBox( i18n("Settings"), frame );
+    m_spinDiscCount = new QSpinBox( groupOptions );
+    m_spinDiscCount->setRange( 0, 9999 );
+    m_spinDiscCount->setSpecialValueText( i18n("Unlimited") );
+    m_spinReadersPerBus = new QSpinBox( groupOptions );
+    m_spinReadersPerBus->setRange( 1, 16 );
+    m_spinRetries = new QSpinBox( groupOptions );
+    m_spinRetries->setRange( 1, 128 );
+    m_checkEject = new QCheckBox( i18n("Eject discs once they have been read"), groupOptions );
+    m_checkIgnoreReadErrors = K3b::StdGuiItems::ignoreAudioReadErrorsCheckBox( groupOptions );
+    QGridLayout* groupOptionsLayout = new QGridLayout( groupOptions );
+    groupOptionsLayout->addWidget( new QLabel( i18n("Number of discs:"), groupOptions ), 0, 0 );
+    groupOptionsLayout->addWidget( m_spinDiscCount, 0, 1 );
+    groupOptionsLayout->addWidget( new QLabel( i18n("Drives reading at the same time per bus:"), groupOptions ), 1, 0 );
+    groupOptionsLayout->addWidget( m_spinReadersPerBus, 1, 1 );
+    groupOptionsLayout->addWidget( new QLabel( i18n("Read retries:"), groupOptions ), 2, 0 );
+    groupOptionsLayout->addWidget( m_spinRetries, 2, 1 );
+    groupOptionsLayout->addWidget( m_checkEject, 3, 0, 1, 2 );
+    groupOptionsLayout->addWidget( m_checkIgnoreReadErrors, 4, 0, 1, 2 );
+    groupOptionsLayout->setRowStretch( 5, 1 );
+
+    QGridLayout* grid = new QGridLayout( frame );
+    grid->setContentsMargins( 0, 0, 0, 0 );
+    grid->addWidget( groupDevices, 0, 0, 2, 1 );
+    grid->addWidget( groupDirectory, 0, 1 );
+    grid->addWidget( groupOptions, 1, 1 );
+    grid->setRowStretch( 1, 1 );
+
+    m_spinDiscCount->setToolTip( i18n("Stop once this number of discs has been read") );
+    m_spinReadersPerBus->setWhatsThis( i18n("<p>Drives which are connected to the same bus, for example "
+                                            "several USB drives behind one hub, share its bandwidth. "
+                                            "K3b only lets this number of them read at the same time. "
+                                            "The discs in the other drives wait in the order in which "
+                                            "they have been inserted.") );
+    m_checkIgnoreReadErrors->setWhatsThis( i18n("<p>If this option is checked and K3b is not able to read a sector from "
+                                                "a disc it will be replaced with zeros in the image.") );
+
+    connect( m_listDevices, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(slotToggleAll()) );
+    connect( m_editDirectory, SIGNAL(textChanged(QString)), this, SLOT(slotToggleAll()) );
+}
+
+
+K3b::BatchIngestDialog::~BatchIngestDialog()
+{
+}
+
+
+void K3b::BatchIngestDialog::setTargetDirectory( const QString& dir )
+{
+    m_targetDirectory = dir;
+}
+
+
+void K3b::BatchIngestDialog::init()
+{
+    // the settings have been loaded by now
+    if( !m_targetDirectory.isEmpty() )
+        m_editDirectory->setUrl( QUrl::fromLocalFile( QDir( m_targetDirectory ).absolutePath() ) );
+    toggleAll();
+}
+
+
+void K3b::BatchIngestDialog::slotStartClicked()
+{
+    QList<K3b::Device::Device*> devices;
+    for( int i = 0; i < m_listDevices->count(); ++i ) {
+        QListWidgetItem* item = m_listDevices->item( i );
+        if( item->checkState() == Qt::Checked ) {
+            K3b::Device::Device* dev = k3bcore->deviceManager()->findDevice( item->data( Qt::UserRole ).toString() );
+            if( dev )
+                devices.append( dev );
+        }
+    }
+
+    K3b::JobProgressDialog dlg( parentWidget(), false );
+    K3b::BatchIngestJob* job = new K3b::BatchIngestJob( &dlg, this );
+
+    job->setDevices( devices );
+    job->setTargetDirectory( m_editDirectory->url().toLocalFile() );
+    job->setDiscCount( m_spinDiscCount->value() );
+    job->setMaxReadersPerBus( m_spinReadersPerBus->value() );
+    job->setEjectWhenDone( m_checkEject->isChecked() );
+    job->setIgnoreReadErrors( m_checkIgnoreReadErrors->isChecked() );
+    job->setReadRetries( m_spinRetries->value() );
+
+    hide();
+
+    dlg.startJob( job );
+
+    delete job;
+
+    if( KConfigGroup( KSharedConfig::openConfig(), QStringLiteral("General Options") ).readEntry( "keep action dialogs open", false ) )
+        show();
+    else
+        close();
+}
+
+
+void K3b::BatchIngestDialog::toggleAll()
+{
+    bool deviceChecked = false;
+    for( int i = 0; i < m_listDevices->count(); ++i ) {
+        if( m_listDevices->item( i )->checkState() == Qt::Checked )
+            deviceChecked = true;
+    }
+
+    setButtonEnabled( START_BUTTON, deviceChecked && !m_editDirectory->url().isEmpty() );
+}
+
+
+void K3b::BatchIngestDialog::loadSettings( const KConfigGroup& c )
+{
+    // all drives are used unless some have been deselected before
+    const QStringList devices = c.readEntry( "devices", QStringList() );
+    for( int i = 0; i < m_listDevices->count(); ++i ) {
+        QListWidgetItem* item = m_listDevices->item( i );
+        item->setCheckState( devices.isEmpty() || devices.contains( item->data( Qt::UserRole ).toString() )
+                             ? Qt::Checked : Qt::Unchecked );
+    }
+
+    m_editDirectory->setUrl( QUrl::fromLocalFile( c.readEntry( "image folder", K3b::defaultTempPath() ) ) );
+    m_spinDiscCount->setValue( c.readEntry( "disc count", 0 ) );
+    m_spinReadersPerBus->setValue( c.readEntry( "readers per bus", 1 ) );
+    m_spinRetries->setValue( c.readEntry( "read retries", 128 ) );
+    m_checkEject->setChecked( c.readEntry( "eject", true ) );
+    m_checkIgnoreReadErrors->setChecked( c.readEntry( "ignore read errors", false ) );
+
+    toggleAll();
+}
+
+
+void K3b::BatchIngestDialog::saveSettings( KConfigGroup c )
+{
+    QStringList devices;
+    for( int i = 0; i < m_listDevices->count(); ++i ) {
+        QListWidgetItem* item = m_listDevices->item( i );
+        if( item->checkState() == Qt::Checked )
+            devices.append( item->data( Qt::UserRole ).toString() );
+    }
+
+    c.writeEntry( "devices", devices );
+    c.writeEntry( "image folder", m_editDirectory->url().toLocalFile() );
+    c.writeEntry( "disc count", m_spinDiscCount->value() );
+    c.writeEntry( "readers per bus", m_spinReadersPerBus->value() );
+    c.writeEntry( "read retries", m_spinRetries->value() );
+    c.writeEntry( "eject", m_checkEject->isChecked() );
+    c.writeEntry( "ignore read errors", m_checkIgnoreReadErrors->isChecked() );
+}
+
+#include "moc_k3bbatchingestdialog.cpp"
@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef _K3B_BATCH_INGEST_DIALOG_H_
+#define _K3B_BATCH_INGEST_DIALOG_H_
+
+#include "k3binteractiondialog.h"
+
+class KUrlRequester;
+class QCheckBox;
+class QListWidget;
+class QSpinBox;
+
+namespace K3b {
+
+    /**
+     * Dialog for the BatchIngestJob which images the discs inserted into
+     * several drives one after the other.
+     */
+    class BatchIngestDialog : public InteractionDialog
+    {
+        Q_OBJECT
+
+    public:
+        explicit BatchIngestDialog( QWidget* parent = 0 );
+        ~BatchIngestDialog() override;
+
+    public Q_SLOTS:
+        /**
+         * Overrides the folder from the saved settings.
+         */
+        void setTargetDirectory( const QString& dir );
+
+    protected Q_SLOTS:
+        void slotStartClicked() override;
+
+    protected:
+        void toggleAll() override;
+        void init() override;
+
+    private:
+        void loadSettings( const KConfigGroup& ) override;
+        void saveSettings( KConfigGroup ) override;
+
+        QListWidget* m_listDevices;
+        KUrlRequester* m_editDirectory;
+        QSpinBox* m_spinDiscCount;
+        QSpinBox* m_spinReadersPerBus;
+        QSpinBox* m_spinRetries;
+        QCheckBox* m_checkEject;
+        QCheckBox* m_checkIgnoreReadErrors;
+
+        QString m_targetDirectory;
+    };
+}
+
+#endif
@@ -45,8 +45,10 @@
 #include <QGroupBox>
 #include <QLayout>
 #include <QLabel>
+#include <QListWidget>
 #include <QPushButton>
 #include <QRadioButton>
+#include <QSignalBlocker>
 #include <QSizePolicy>
 #include <QSpinBox>
 #include <QToolTip>
@@ -121,10 +123,25 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     groupOptionsLayout->addWidget( m_checkVerifyData );
     groupOptionsLayout->addStretch( 1 );
 
+    QGroupBox* groupAdditionalWriters = new QGroupBox( i18n("Write Simultaneously On"), optionTab );
+    m_listAdditionalWriters = new QListWidget( groupAdditionalWriters );
+    Q_FOREACH( K3b::Device::Device* dev, k3bcore->deviceManager()->burningDevices() ) {
+        QListWidgetItem* item = new QListWidgetItem( QString( "%1 %2 (%3)" )
+                                                     .arg( dev->vendor() )
+                                                     .arg( dev->description() )
+                                                     .arg( dev->blockDeviceName() ),
+                                                     m_listAdditionalWriters );
+        item->setData( Qt::UserRole, dev->blockDeviceName() );
+        item->setCheckState( Qt::Unchecked );
+    }
+    QVBoxLayout* groupAdditionalWritersLayout = new QVBoxLayout( groupAdditionalWriters );
+    groupAdditionalWritersLayout->addWidget( m_listAdditionalWriters );
+
     optionTabGrid->addWidget( groupCopyMode, 0, 0 );
     optionTabGrid->addWidget( groupWritingMode, 1, 0 );
     optionTabGrid->addWidget( groupOptions, 0, 1, 3, 1 );
     optionTabGrid->addWidget( groupCopies, 2, 0 );
+    optionTabGrid->addWidget( groupAdditionalWriters, 3, 0, 1, 2 );
     optionTabGrid->setRowStretch( 2, 1 );
     optionTabGrid->setColumnStretch( 1, 1 );
 
@@ -156,10 +173,12 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     m_spinDataRetries->setRange( 1, 128 );
     m_checkIgnoreDataReadErrors = K3b::StdGuiItems::ignoreAudioReadErrorsCheckBox( m_groupAdvancedDataOptions );
     m_checkNoCorrection = new QCheckBox( i18n("No error correction"), m_groupAdvancedDataOptions );
+    m_checkRescueMode = new QCheckBox( i18n("Rescue mode"), m_groupAdvancedDataOptions );
     groupAdvancedDataOptionsLayout->addWidget( new QLabel( i18n("Read retries:"), m_groupAdvancedDataOptions ), 0, 0 );
     groupAdvancedDataOptionsLayout->addWidget( m_spinDataRetries, 0, 1 );
     groupAdvancedDataOptionsLayout->addWidget( m_checkIgnoreDataReadErrors, 1, 0, 1, 2 );
     groupAdvancedDataOptionsLayout->addWidget( m_checkNoCorrection, 2, 0, 1, 2 );
+    groupAdvancedDataOptionsLayout->addWidget( m_checkRescueMode, 3, 0, 1, 2 );
     groupAdvancedDataOptionsLayout->setRowStretch( 4, 1 );
 
     m_groupAdvancedAudioOptions = new QGroupBox( i18n("Audio"), advancedTab );
@@ -200,10 +219,14 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     connect( m_checkOnlyCreateImage, SIGNAL(toggled(bool)), this, SLOT(slotToggleAll()) );
     connect( m_comboCopyMode, SIGNAL(activated(int)), this, SLOT(slotToggleAll()) );
     connect( m_checkReadCdText, SIGNAL(toggled(bool)), this, SLOT(slotToggleAll()) );
+    connect( m_checkRescueMode, SIGNAL(toggled(bool)), this, SLOT(slotToggleAll()) );
+    connect( m_listAdditionalWriters, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(slotToggleAll()) );
 
     m_checkIgnoreDataReadErrors->setToolTip( i18n("Skip unreadable data sectors") );
     m_checkNoCorrection->setToolTip( i18n("Disable the source drive's error correction") );
+    m_checkRescueMode->setToolTip( i18n("Read damaged media in several passes") );
     m_checkReadCdText->setToolTip( i18n("Copy CD-Text from the source CD if available.") );
+    m_listAdditionalWriters->setToolTip( i18n("Write one copy on each of the checked drives at the same time") );
 
     m_checkNoCorrection->setWhatsThis( i18n("<p>If this option is checked K3b will disable the "
                                             "source drive's ECC/EDC error correction. This way sectors "
@@ -213,6 +236,17 @@ K3b::MediaCopyDialog::MediaCopyDialog( QWidget *parent )
     m_checkReadCdText->setWhatsThis( i18n("<p>If this option is checked K3b will search for CD-Text on the source CD. "
                                           "Disable it if your CD drive has problems with reading CD-Text or you want "
                                           "to stick to CDDB info.") );
+    m_checkRescueMode->setWhatsThis( i18n("<p>If this option is checked K3b first reads all sectors which can be read "
+                                          "easily and skips the areas with read errors. These are read again in later "
+                                          "passes with smaller and smaller blocks."
+                                          "<p>The state of every sector is saved next to the image. If the medium "
+                                          "could not be read completely K3b keeps the image and continues with the "
+                                          "missing sectors when the copy is started again with the same image file."
+                                          "<p>Rescue mode always creates an image and the copies cannot be verified.") );
+    m_listAdditionalWriters->setWhatsThis( i18n("<p>K3b writes one copy on the selected writer and one on each of the "
+                                                "checked drives at the same time. The source medium is read only once "
+                                                "and every copy is verified in its own drive."
+                                                "<p>This is only possible when copying DVD or Blu-ray media.") );
     m_checkIgnoreDataReadErrors->setWhatsThis( i18n("<p>If this option is checked and K3b is not able to read a data sector from the "
                                                     "source medium it will be replaced with zeros on the resulting copy.") );
 
@@ -337,6 +371,7 @@ void K3b::MediaCopyDialog::slotStartClicked()
         job->setIgnoreDataReadErrors( m_checkIgnoreDataReadErrors->isChecked() );
         job->setIgnoreAudioReadErrors( m_checkIgnoreAudioReadErrors->isChecked() );
         job->setNoCorrection( m_checkNoCorrection->isChecked() );
+        job->setRescueMode( m_checkRescueMode->isChecked() );
         job->setWritingMode( m_writingModeWidget->writingMode() );
 
         burnJob = job;
@@ -356,7 +391,9 @@ void K3b::MediaCopyDialog::slotStartClicked()
         job->setWritingMode( m_writingModeWidget->writingMode() );
         job->setIgnoreReadErrors( m_checkIgnoreDataReadErrors->isChecked() );
         job->setReadRetries( m_spinDataRetries->value() );
+        job->setRescueMode( m_checkRescueMode->isChecked() );
         job->setVerifyData( m_checkVerifyData->isChecked() );
+        job->setAdditionalWriterDevices( additionalWriters() );
 
         burnJob = job;
     }
@@ -404,7 +441,36 @@ void K3b::MediaCopyDialog::toggleAll()
     }
 
     m_checkDeleteImages->setEnabled( !m_checkOnlyCreateImage->isChecked() && m_checkCacheImage->isChecked() );
-    m_spinCopies->setDisabled( m_checkSimulate->isChecked() || m_checkOnlyCreateImage->isChecked() );
+
+    // only the DVD copy job writes on several drives at the same time
+    const bool parallelWriting = m_comboCopyMode->currentIndex() == 0 &&
+                                 !m_checkOnlyCreateImage->isChecked() &&
+                                 ( K3b::Device::isDvdMedia( sourceMedium.diskInfo().mediaType() ) ||
+                                   K3b::Device::isBdMedia( sourceMedium.diskInfo().mediaType() ) );
+    const K3b::Device::MediaTypes parallelMediaTypes = K3b::Device::isBdMedia( sourceMedium.diskInfo().mediaType() )
+                                                       ? K3b::Device::MEDIA_WRITABLE_BD
+                                                       : K3b::Device::MEDIA_WRITABLE_DVD;
+    {
+        // changing the flags emits itemChanged
+        QSignalBlocker blocker( m_listAdditionalWriters );
+        for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+            QListWidgetItem* item = m_listAdditionalWriters->item( i );
+            K3b::Device::Device* dev = k3bcore->deviceManager()->findDevice( item->data( Qt::UserRole ).toString() );
+            // the source drive can only write once the image has been read
+            const bool usable = parallelWriting && dev && dev != burnDev &&
+                                ( dev != readDev || m_checkCacheImage->isChecked() ) &&
+                                ( dev->writeCapabilities() & parallelMediaTypes );
+            if( usable )
+                item->setFlags( item->flags() | Qt::ItemIsEnabled );
+            else
+                item->setFlags( item->flags() & ~Qt::ItemIsEnabled );
+        }
+    }
+    m_listAdditionalWriters->setEnabled( parallelWriting );
+
+    // every additional writer writes exactly one copy
+    m_spinCopies->setDisabled( m_checkSimulate->isChecked() || m_checkOnlyCreateImage->isChecked() ||
+                               !additionalWriters().isEmpty() );
     m_tempDirSelectionWidget->setDisabled( !m_checkCacheImage->isChecked() && !m_checkOnlyCreateImage->isChecked() );
     m_writerSelectionWidget->setDisabled( m_checkOnlyCreateImage->isChecked() );
     m_checkCacheImage->setEnabled( !m_checkOnlyCreateImage->isChecked() );
@@ -497,6 +563,14 @@ void K3b::MediaCopyDialog::toggleAll()
         }
     }
 
+    // rescue mode always reads into an image
+    m_checkRescueMode->setEnabled( m_comboCopyMode->currentIndex() == 0 );
+    if( m_checkRescueMode->isEnabled() && m_checkRescueMode->isChecked() ) {
+        m_checkCacheImage->setChecked(true);
+        m_checkCacheImage->setEnabled(false);
+        m_checkVerifyData->setEnabled(false);
+    }
+
     m_tempDirSelectionWidget->setNeededSize( neededSize() );
 
     if( sourceMedium.toc().contentType() == K3b::Device::DATA &&
@@ -532,6 +606,24 @@ void K3b::MediaCopyDialog::toggleAll()
 }
 
 
+QList<K3b::Device::Device*> K3b::MediaCopyDialog::additionalWriters() const
+{
+    QList<K3b::Device::Device*> devices;
+    if( !m_listAdditionalWriters->isEnabled() )
+        return devices;
+
+    for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+        QListWidgetItem* item = m_listAdditionalWriters->item( i );
+        if( item->checkState() == Qt::Checked && ( item->flags() & Qt::ItemIsEnabled ) ) {
+            K3b::Device::Device* dev = k3bcore->deviceManager()->findDevice( item->data( Qt::UserRole ).toString() );
+            if( dev )
+                devices.append( dev );
+        }
+    }
+    return devices;
+}
+
+
 void K3b::MediaCopyDialog::updateOverrideDevice()
 {
     if( !m_checkCacheImage->isChecked() ) {
@@ -572,6 +664,13 @@ void K3b::MediaCopyDialog::loadSettings( const KConfigGroup& c )
     m_checkIgnoreDataReadErrors->setChecked( c.readEntry( "ignore data read errors", false ) );
     m_checkIgnoreAudioReadErrors->setChecked( c.readEntry( "ignore audio read errors", true ) );
     m_checkNoCorrection->setChecked( c.readEntry( "no correction", false ) );
+    m_checkRescueMode->setChecked( c.readEntry( "rescue mode", false ) );
+
+    const QStringList additionalWriters = c.readEntry( "additional writers", QStringList() );
+    for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+        QListWidgetItem* item = m_listAdditionalWriters->item( i );
+        item->setCheckState( additionalWriters.contains( item->data( Qt::UserRole ).toString() ) ? Qt::Checked : Qt::Unchecked );
+    }
 
     m_spinDataRetries->setValue( c.readEntry( "data retries", 128 ) );
     m_spinAudioRetries->setValue( c.readEntry( "audio retries", 5 ) );
@@ -600,6 +699,15 @@ void K3b::MediaCopyDialog::saveSettings( KConfigGroup c )
     c.writeEntry( "ignore data read errors", m_checkIgnoreDataReadErrors->isChecked() );
     c.writeEntry( "ignore audio read errors", m_checkIgnoreAudioReadErrors->isChecked() );
     c.writeEntry( "no correction", m_checkNoCorrection->isChecked() );
+    c.writeEntry( "rescue mode", m_checkRescueMode->isChecked() );
+
+    QStringList additionalWriters;
+    for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+        QListWidgetItem* item = m_listAdditionalWriters->item( i );
+        if( item->checkState() == Qt::Checked )
+            additionalWriters.append( item->data( Qt::UserRole ).toString() );
+    }
+    c.writeEntry( "additional writers", additionalWriters );
     c.writeEntry( "data retries", m_spinDataRetries->value() );
     c.writeEntry( "audio retries", m_spinAudioRetries->value() );
 
@@ -15,6 +15,7 @@ class QCheckBox;
 class QSpinBox;
 class QGroupBox;
 class QComboBox;
+class QListWidget;
 
 namespace K3b {
     namespace Device {
@@ -50,6 +51,7 @@ namespace K3b {
         void saveSettings( KConfigGroup ) override;
 
         KIO::filesize_t neededSize() const;
+        QList<Device::Device*> additionalWriters() const;
 
         WriterSelectionWidget* m_writerSelectionWidget;
         TempDirSelectionWidget* m_tempDirSelectionWidget;
@@ -61,6 +63,7 @@ namespace K3b {
         QCheckBox* m_checkIgnoreDataReadErrors;
         QCheckBox* m_checkIgnoreAudioReadErrors;
         QCheckBox* m_checkNoCorrection;
+        QCheckBox* m_checkRescueMode;
         QCheckBox* m_checkVerifyData;
         MediaSelectionComboBox* m_comboSourceDevice;
         QComboBox* m_comboParanoiaMode;
@@ -69,6 +72,7 @@ namespace K3b {
         QSpinBox* m_spinAudioRetries;
         WritingModeWidget* m_writingModeWidget;
         QComboBox* m_comboCopyMode;
+        QListWidget* m_listAdditionalWriters;
 
         QGroupBox* m_groupAdvancedDataOptions;
         QGroupBox* m_groupAdvancedAudioOptions;
@@ -56,13 +56,24 @@ void K3b::AdvancedOptionTab::setupGui()
     m_editWritingBufferSize->setRange( 1, 100 );
     m_editWritingBufferSize->setValue( 4 );
     m_editWritingBufferSize->setSuffix( ' ' + i18n("MB") );
+    QLabel* onTheFlyBufferLabel = new QLabel( i18n("On-the-fly &buffer size:"), groupWritingApp );
+    m_editOnTheFlyBufferSize = new QSpinBox( groupWritingApp );
+    m_editOnTheFlyBufferSize->setRange( 0, 1024 );
+    m_editOnTheFlyBufferSize->setValue( 64 );
+    m_editOnTheFlyBufferSize->setSuffix( ' ' + i18n("MB") );
+    m_editOnTheFlyBufferSize->setSpecialValueText( i18n("Disabled") );
+    onTheFlyBufferLabel->setBuddy( m_editOnTheFlyBufferSize );
+    m_checkOnTheFlyBufferSpill = new QCheckBox( i18n("&Spill on-the-fly buffer to the temporary folder"), groupWritingApp );
     m_checkShowForceGuiElements = new QCheckBox( i18n("Show &advanced GUI elements"), groupWritingApp );
     bufferLayout->addWidget( m_checkBurnfree, 0, 0, 1, 3 );
     bufferLayout->addWidget( m_checkOverburn, 1, 0, 1, 2 );
     bufferLayout->addWidget( m_checkForceUnsafeOperations, 2, 0, 1, 3 );
     bufferLayout->addWidget( m_checkManualWritingBufferSize, 3, 0 );
     bufferLayout->addWidget( m_editWritingBufferSize, 3, 1 );
-    bufferLayout->addWidget( m_checkShowForceGuiElements, 4, 0, 1, 3 );
+    bufferLayout->addWidget( onTheFlyBufferLabel, 4, 0 );
+    bufferLayout->addWidget( m_editOnTheFlyBufferSize, 4, 1 );
+    bufferLayout->addWidget( m_checkOnTheFlyBufferSpill, 5, 0, 1, 3 );
+    bufferLayout->addWidget( m_checkShowForceGuiElements, 6, 0, 1, 3 );
     bufferLayout->setColumnStretch( 2, 1 );
 
     QGroupBox* groupMisc = new QGroupBox( i18n("Miscellaneous"), this );
@@ -71,6 +82,26 @@ void K3b::AdvancedOptionTab::setupGui()
     groupMiscLayout->addWidget( m_checkEject );
     m_checkAutoErasingRewritable = new QCheckBox( i18n("Automatically erase CD-RWs and DVD-RWs"), groupMisc );
     groupMiscLayout->addWidget( m_checkAutoErasingRewritable );
+    QHBoxLayout* imageCacheLayout = new QHBoxLayout();
+    QLabel* imageCacheLabel = new QLabel( i18n("Data &image cache size:"), groupMisc );
+    m_editImageCacheSize = new QSpinBox( groupMisc );
+    m_editImageCacheSize->setRange( 0, 10000 );
+    m_editImageCacheSize->setSuffix( ' ' + i18n("GB") );
+    m_editImageCacheSize->setSpecialValueText( i18n("Disabled") );
+    imageCacheLabel->setBuddy( m_editImageCacheSize );
+    imageCacheLayout->addWidget( imageCacheLabel );
+    imageCacheLayout->addWidget( m_editImageCacheSize );
+    imageCacheLayout->addStretch( 1 );
+    groupMiscLayout->addLayout( imageCacheLayout );
+    QHBoxLayout* verificationLayout = new QHBoxLayout();
+    m_checkSampledVerification = new QCheckBox( i18n("&Verify only a sample with a confidence of"), groupMisc );
+    m_editVerificationConfidence = new QSpinBox( groupMisc );
+    m_editVerificationConfidence->setRange( 50, 99 );
+    m_editVerificationConfidence->setSuffix( "%" );
+    verificationLayout->addWidget( m_checkSampledVerification );
+    verificationLayout->addWidget( m_editVerificationConfidence );
+    verificationLayout->addStretch( 1 );
+    groupMiscLayout->addLayout( verificationLayout );
 
     groupAdvancedLayout->addWidget( groupWritingApp, 0, 0 );
     groupAdvancedLayout->addWidget( groupMisc, 1, 0 );
@@ -81,15 +112,24 @@ void K3b::AdvancedOptionTab::setupGui()
              m_editWritingBufferSize, SLOT(setEnabled(bool)) );
     connect( m_checkManualWritingBufferSize, SIGNAL(toggled(bool)),
              this, SLOT(slotSetDefaultBufferSizes(bool)) );
+    connect( m_editOnTheFlyBufferSize, SIGNAL(valueChanged(int)),
+             this, SLOT(slotOnTheFlyBufferSizeChanged(int)) );
+    connect( m_checkSampledVerification, SIGNAL(toggled(bool)),
+             m_editVerificationConfidence, SLOT(setEnabled(bool)) );
 
 
     m_editWritingBufferSize->setDisabled( true );
+    m_checkOnTheFlyBufferSpill->setDisabled( true );
+    m_editVerificationConfidence->setDisabled( true );
     // -----------------------------------------------------------------------
 
 
     m_checkOverburn->setToolTip( i18n("Allow burning more than the official media capacities") );
     m_checkShowForceGuiElements->setToolTip( i18n("Show advanced GUI elements like allowing to choose between cdrecord and cdrdao") );
     m_checkAutoErasingRewritable->setToolTip( i18n("Automatically erase CD-RWs and DVD-RWs without asking") );
+    m_editImageCacheSize->setToolTip( i18n("Keep the images of data projects to write them again without recreating them") );
+    m_checkSampledVerification->setToolTip( i18n("Verify written data by reading only a part of it") );
+    m_editOnTheFlyBufferSize->setToolTip( i18n("Buffer the data between the source and the writer when writing on-the-fly") );
     m_checkEject->setToolTip( i18n("Do not eject the burn medium after a completed burn process") );
     m_checkForceUnsafeOperations->setToolTip( i18n("Force K3b to continue some operations otherwise deemed as unsafe") );
 
@@ -122,6 +162,31 @@ void K3b::AdvancedOptionTab::setupGui()
                                                        "<p>If this option is checked the value specified will be used for both "
                                                        "CD and DVD burning.", 4, 32) );
 
+    m_editOnTheFlyBufferSize->setWhatsThis( i18n("<p>When writing on-the-fly the data is created or read while it is written. "
+                                                 "K3b buffers the data between the source and the writer to bridge "
+                                                 "moments in which the source is slow, for example due to a busy hard disk."
+                                                 "<p>The buffer is filled before the writing starts and grows up to the "
+                                                 "size specified here if the source delivers its data unsteadily. "
+                                                 "If it is about to run empty K3b tries to lower the writing speed.") );
+
+    m_editImageCacheSize->setWhatsThis( i18n("<p>If the cache is enabled K3b keeps the images of written data projects "
+                                             "in the temporary folder. When the same project is written again "
+                                             "and none of its files changed the image is written from the cache "
+                                             "instead of creating it again."
+                                             "<p>Once the cache exceeds the size specified here the least recently "
+                                             "used images are removed.") );
+
+    m_checkSampledVerification->setWhatsThis( i18n("<p>If this option is checked K3b only reads a random sample of "
+                                                   "the written data to verify it. The sample is big enough to detect "
+                                                   "damage of at least one percent of the data with the given confidence."
+                                                   "<p>Images taken from the image cache are always verified "
+                                                   "completely.") );
+
+    m_checkOnTheFlyBufferSpill->setWhatsThis( i18n("<p>If this option is checked data which does not fit into the "
+                                                   "on-the-fly buffer is written to the temporary folder instead of "
+                                                   "making the source wait. This only helps if the temporary folder "
+                                                   "is on a fast disk which is not used as the source.") );
+
     m_checkEject->setWhatsThis( i18n("<p>If this option is checked K3b will not eject the medium once the burn process "
                                      "finishes. This can be helpful in case one leaves the computer after starting the "
                                      "burning and does not want the tray to be open all the time."
@@ -151,6 +216,11 @@ void K3b::AdvancedOptionTab::readSettings()
     m_checkManualWritingBufferSize->setChecked( k3bcore->globalSettings()->useManualBufferSize() );
     if( k3bcore->globalSettings()->useManualBufferSize() )
         m_editWritingBufferSize->setValue( k3bcore->globalSettings()->bufferSize() );
+    m_editOnTheFlyBufferSize->setValue( k3bcore->globalSettings()->onTheFlyBufferSize() );
+    m_checkOnTheFlyBufferSpill->setChecked( k3bcore->globalSettings()->onTheFlyBufferSpill() );
+    m_editImageCacheSize->setValue( k3bcore->globalSettings()->imageCacheSize() );
+    m_checkSampledVerification->setChecked( k3bcore->globalSettings()->sampledVerification() );
+    m_editVerificationConfidence->setValue( k3bcore->globalSettings()->verificationConfidence() );
 }
 
 
@@ -166,6 +236,11 @@ void K3b::AdvancedOptionTab::saveSettings()
     k3bcore->globalSettings()->setBurnfree( m_checkBurnfree->isChecked() );
     k3bcore->globalSettings()->setUseManualBufferSize( m_checkManualWritingBufferSize->isChecked() );
     k3bcore->globalSettings()->setBufferSize( m_editWritingBufferSize->value() );
+    k3bcore->globalSettings()->setOnTheFlyBufferSize( m_editOnTheFlyBufferSize->value() );
+    k3bcore->globalSettings()->setOnTheFlyBufferSpill( m_checkOnTheFlyBufferSpill->isChecked() );
+    k3bcore->globalSettings()->setImageCacheSize( m_editImageCacheSize->value() );
+    k3bcore->globalSettings()->setSampledVerification( m_checkSampledVerification->isChecked() );
+    k3bcore->globalSettings()->setVerificationConfidence( m_editVerificationConfidence->value() );
     k3bcore->globalSettings()->setForce( m_checkForceUnsafeOperations->isChecked() );
 }
 
@@ -177,4 +252,9 @@ void K3b::AdvancedOptionTab::slotSetDefaultBufferSizes( bool b )
     }
 }
 
+void K3b::AdvancedOptionTab::slotOnTheFlyBufferSizeChanged( int size )
+{
+    m_checkOnTheFlyBufferSpill->setEnabled( size > 0 );
+}
+
 #include "moc_k3badvancedoptiontab.cpp"
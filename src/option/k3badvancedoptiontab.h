@@ -28,6 +28,7 @@ namespace K3b {
 
     private Q_SLOTS:
         void slotSetDefaultBufferSizes( bool );
+        void slotOnTheFlyBufferSizeChanged( int );
 
     private:
         void setupGui();
@@ -38,6 +39,11 @@ namespace K3b {
         QCheckBox*    m_checkOverburn;
         QCheckBox*    m_checkManualWritingBufferSize;
         QSpinBox*     m_editWritingBufferSize;
+        QSpinBox*     m_editOnTheFlyBufferSize;
+        QCheckBox*    m_checkOnTheFlyBufferSpill;
+        QSpinBox*     m_editImageCacheSize;
+        QCheckBox*    m_checkSampledVerification;
+        QSpinBox*     m_editVerificationConfidence;
         QCheckBox*    m_checkShowForceGuiElements;
         QCheckBox*    m_checkForceUnsafeOperations;
     };
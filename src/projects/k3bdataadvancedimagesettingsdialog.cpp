@@ -77,6 +77,8 @@ void K3b::DataAdvancedImageSettingsDialog::load( const K3b::IsoOptions& options
     // misc (FIXME: should not be here)
     m_checkDoNotCacheInodes->setChecked( options.doNotCacheInodes() );
     m_checkDoNotImportSession->setChecked( options.doNotImportSession() );
+    m_checkOptimizeLayout->setChecked( options.optimizeLayout() );
+    m_checkDeduplicateFiles->setChecked( options.deduplicateFiles() );
 }
 
 
@@ -112,6 +114,8 @@ void K3b::DataAdvancedImageSettingsDialog::save( K3b::IsoOptions& options )
     options.setJolietLong( m_checkJolietLong->isChecked() );
     options.setDoNotCacheInodes( m_checkDoNotCacheInodes->isChecked() );
     options.setDoNotImportSession( m_checkDoNotImportSession->isChecked() );
+    options.setOptimizeLayout( m_checkOptimizeLayout->isChecked() );
+    options.setDeduplicateFiles( m_checkDeduplicateFiles->isChecked() );
 }
 
 #include "moc_k3bdataadvancedimagesettingsdialog.cpp"
@@ -11,7 +11,9 @@
 
 #include "k3bisooptions.h"
 #include "k3bdatadoc.h"
+#include "k3bdatajob.h"
 #include "k3bdevice.h"
+#include "k3bdevicemanager.h"
 #include "k3bwriterselectionwidget.h"
 #include "k3btempdirselectionwidget.h"
 #include "k3bjob.h"
@@ -31,6 +33,7 @@
 #include <QGroupBox>
 #include <QLabel>
 #include <QLineEdit>
+#include <QListWidget>
 #include <QPushButton>
 #include <QToolButton>
 #include <QLayout>
@@ -38,6 +41,7 @@
 #include <QRadioButton>
 #include <QTabWidget>
 #include <QSpinBox>
+#include <QSignalBlocker>
 #include <QGridLayout>
 
 #include <KConfig>
@@ -70,6 +74,8 @@ K3b::DataBurnDialog::DataBurnDialog(K3b::DataDoc* _doc, QWidget *parent )
 
     connect( m_comboMultisession, SIGNAL(activated(int)),
              this, SLOT(slotMultiSessionModeChanged()) );
+    connect( m_comboMultisession, SIGNAL(activated(int)),
+             this, SLOT(slotToggleAll()) );
 
     m_writerSelectionWidget->setWantedMediumState( K3b::Device::STATE_EMPTY|K3b::Device::STATE_INCOMPLETE );
 
@@ -149,9 +155,32 @@ void K3b::DataBurnDialog::setupSettingsTab()
     QVBoxLayout* groupMultiSessionLayout = new QVBoxLayout( groupMultiSession );
     groupMultiSessionLayout->addWidget( m_comboMultisession );
 
+    QGroupBox* groupAdditionalWriters = new QGroupBox( i18n("Write Simultaneously On"), frame );
+    m_listAdditionalWriters = new QListWidget( groupAdditionalWriters );
+    Q_FOREACH( K3b::Device::Device* dev, k3bcore->deviceManager()->burningDevices() ) {
+        QListWidgetItem* item = new QListWidgetItem( QString( "%1 %2 (%3)" )
+                                                     .arg( dev->vendor() )
+                                                     .arg( dev->description() )
+                                                     .arg( dev->blockDeviceName() ),
+                                                     m_listAdditionalWriters );
+        item->setData( Qt::UserRole, dev->blockDeviceName() );
+        item->setCheckState( Qt::Unchecked );
+    }
+    QVBoxLayout* groupAdditionalWritersLayout = new QVBoxLayout( groupAdditionalWriters );
+    groupAdditionalWritersLayout->addWidget( m_listAdditionalWriters );
+
+    connect( m_listAdditionalWriters, SIGNAL(itemChanged(QListWidgetItem*)), this, SLOT(slotToggleAll()) );
+
+    m_listAdditionalWriters->setToolTip( i18n("Write one copy on each of the checked drives at the same time") );
+    m_listAdditionalWriters->setWhatsThis( i18n("<p>K3b writes one copy on the selected writer and one on each of the "
+                                                "checked drives at the same time. The image is created only once "
+                                                "and every copy is verified in its own drive."
+                                                "<p>This is only possible if the project is not written as multisession.") );
+
     frameLayout->addWidget( m_groupDataMode, 0, 0 );
     frameLayout->addWidget( groupMultiSession, 1, 0 );
-    frameLayout->setRowStretch( 2, 1 );
+    frameLayout->addWidget( groupAdditionalWriters, 2, 0 );
+    frameLayout->setRowStretch( 3, 1 );
 
     addPage( frame, i18n("Misc") );
 }
@@ -204,6 +233,12 @@ void K3b::DataBurnDialog::loadSettings( const KConfigGroup& c )
 
     m_checkVerify->setChecked( c.readEntry( "verify data", false ) );
 
+    const QStringList additionalWriters = c.readEntry( "additional writers", QStringList() );
+    for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+        QListWidgetItem* item = m_listAdditionalWriters->item( i );
+        item->setCheckState( additionalWriters.contains( item->data( Qt::UserRole ).toString() ) ? Qt::Checked : Qt::Unchecked );
+    }
+
     toggleAll();
 }
 
@@ -220,6 +255,14 @@ void K3b::DataBurnDialog::saveSettings( KConfigGroup c )
     o.save( c );
 
     c.writeEntry( "verify data", m_checkVerify->isChecked() );
+
+    QStringList additionalWriters;
+    for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+        QListWidgetItem* item = m_listAdditionalWriters->item( i );
+        if( item->checkState() == Qt::Checked )
+            additionalWriters.append( item->data( Qt::UserRole ).toString() );
+    }
+    c.writeEntry( "additional writers", additionalWriters );
 }
 
 
@@ -255,6 +298,54 @@ void K3b::DataBurnDialog::toggleAll()
     else {
         m_comboMultisession->setEnabled(true);
     }
+
+    // only projects without multisession are written on several drives at the same time
+    const bool parallelWriting = !m_checkOnlyCreateImage->isChecked() &&
+                                 m_comboMultisession->multiSessionMode() == K3b::DataDoc::NONE;
+    K3b::Device::Device* burnDev = m_writerSelectionWidget->writerDevice();
+    {
+        // changing the flags emits itemChanged
+        QSignalBlocker blocker( m_listAdditionalWriters );
+        for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+            QListWidgetItem* item = m_listAdditionalWriters->item( i );
+            K3b::Device::Device* dev = k3bcore->deviceManager()->findDevice( item->data( Qt::UserRole ).toString() );
+            const bool usable = parallelWriting && dev && dev != burnDev &&
+                                ( dev->writeCapabilities() & doc()->supportedMediaTypes() );
+            if( usable )
+                item->setFlags( item->flags() | Qt::ItemIsEnabled );
+            else
+                item->setFlags( item->flags() & ~Qt::ItemIsEnabled );
+        }
+    }
+    m_listAdditionalWriters->setEnabled( parallelWriting );
+
+    // every additional writer writes exactly one copy
+    if( !additionalWriters().isEmpty() )
+        m_spinCopies->setEnabled( false );
+}
+
+
+void K3b::DataBurnDialog::prepareJob( K3b::BurnJob* job )
+{
+    static_cast<K3b::DataJob*>( job )->setAdditionalWriterDevices( additionalWriters() );
+}
+
+
+QList<K3b::Device::Device*> K3b::DataBurnDialog::additionalWriters() const
+{
+    QList<K3b::Device::Device*> devices;
+    if( !m_listAdditionalWriters->isEnabled() )
+        return devices;
+
+    for( int i = 0; i < m_listAdditionalWriters->count(); ++i ) {
+        QListWidgetItem* item = m_listAdditionalWriters->item( i );
+        if( item->checkState() == Qt::Checked && ( item->flags() & Qt::ItemIsEnabled ) ) {
+            K3b::Device::Device* dev = k3bcore->deviceManager()->findDevice( item->data( Qt::UserRole ).toString() );
+            if( dev )
+                devices.append( dev );
+        }
+    }
+    return devices;
 }
 
 
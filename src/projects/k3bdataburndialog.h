@@ -8,11 +8,18 @@
 
 #include "k3bprojectburndialog.h"
 
+#include <QList>
+
 class QCheckBox;
 class QGroupBox;
 class QLabel;
+class QListWidget;
 
 namespace K3b {
+    namespace Device {
+        class Device;
+    }
+
     class DataDoc;
     class DataImageSettingsWidget;
     class DataModeWidget;
@@ -35,6 +42,9 @@ namespace K3b {
         void loadSettings( const KConfigGroup& ) override;
         void saveSettings( KConfigGroup ) override;
         void toggleAll() override;
+        void prepareJob( BurnJob* ) override;
+
+        QList<Device::Device*> additionalWriters() const;
 
         // --- settings tab ---------------------------
         DataImageSettingsWidget* m_imageSettingsWidget;
@@ -43,6 +53,7 @@ namespace K3b {
         QGroupBox* m_groupDataMode;
         DataModeWidget* m_dataModeWidget;
         DataMultiSessionCombobox* m_comboMultisession;
+        QListWidget* m_listAdditionalWriters;
 
         QCheckBox* m_checkVerify;
 
@@ -35,6 +35,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QList>
+#include <QSet>
 #include <QUrl>
 #include <QDialogButtonBox>
 #include <QGridLayout>
@@ -511,6 +512,7 @@ void K3b::DataUrlAddingDialog::slotAddUrls()
             if( !newDirItem ) { // maybe we reuse an already existing dir
                 newDirItem = new K3b::DirItem( newName );
                 newDirItem->setLocalPath( url.toLocalFile() ); // HACK: see k3bdiritem.h
+                newDirItem->updateLocalTimestamps();
                 dir->addDataItem( newDirItem );
             }
 
@@ -518,12 +520,18 @@ void K3b::DataUrlAddingDialog::slotAddUrls()
             KIO::UDSEntryList list;
             connect(lj, &KIO::ListJob::entries, this, [&](KIO::Job *, const KIO::UDSEntryList &l) { list.append(l); });
             lj->exec();
+            QSet<QString> localEntries( newDirItem->localEntries() );
             foreach( const KIO::UDSEntry& entry, list ) {
                 const QString fileName = entry.stringValue( KIO::UDSEntry::UDS_NAME );
                 if (fileName != QStringLiteral(".") && fileName != QStringLiteral("..")) {
                     m_urlQueue.append( qMakePair( QUrl::fromLocalFile(absoluteFilePath + '/' + fileName ), newDirItem ) );
+                    localEntries.insert( fileName );
                 }
             }
+
+            // a later rescan only adds entries which are not listed yet
+            newDirItem->setLocalEntries( localEntries );
+            m_localDirItems.append( newDirItem );
         }
         else {
             m_newItems[ dir ].append( new K3b::FileItem( &statBuf, &resolvedStatBuf, url.toLocalFile(), *dir->getDoc(), newName ) );
@@ -534,6 +542,18 @@ void K3b::DataUrlAddingDialog::slotAddUrls()
         Q_FOREACH( DirItem* dir, m_newItems.keys() ) {
             dir->addDataItems( m_newItems[ dir ] );
         }
+
+        // remember the choices for the folders so a rescan can apply them to new entries
+        K3b::DirItem::LocalAddOptions addOptions;
+        if( m_iAddHiddenFiles == 1 )
+            addOptions |= K3b::DirItem::AddHiddenFiles;
+        if( m_iAddSystemFiles == 1 )
+            addOptions |= K3b::DirItem::AddSystemFiles;
+        if( m_bFolderLinksFollowAll )
+            addOptions |= K3b::DirItem::FollowFolderLinks;
+        Q_FOREACH( DirItem* dir, m_localDirItems ) {
+            dir->setLocalAddOptions( addOptions );
+        }
         m_dirSizeJob->cancel();
         m_progressWidget->setMaximum( 100 );
         accept();
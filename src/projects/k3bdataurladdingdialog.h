@@ -76,6 +76,7 @@ namespace K3b {
         QList< QPair<DataItem*, DirItem*> > m_items;
         QList<QUrl> m_dirSizeQueue;
         QHash< DirItem*, QList<DataItem*> > m_newItems;
+        QList<DirItem*> m_localDirItems;
 
         DataDoc* m_doc;
         bool m_bExistingItemsReplaceAll;
@@ -75,6 +75,7 @@ K3b::DataView::DataView( K3b::DataDoc* doc, QWidget* parent )
     toolBox()->addAction( actionCollection()->action( "project_data_import_session" ) );
     toolBox()->addAction( actionCollection()->action( "project_data_clear_imported_session" ) );
     toolBox()->addAction( actionCollection()->action( "project_data_edit_boot_images" ) );
+    toolBox()->addAction( actionCollection()->action( "project_data_rescan" ) );
     toolBox()->addSeparator();
     toolBox()->addAction( actionCollection()->action( "parent_dir" ) );
     toolBox()->addSeparator();
@@ -92,6 +93,7 @@ K3b::DataView::DataView( K3b::DataDoc* doc, QWidget* parent )
             "  <Action name=\"project_data_import_session\"/>"
             "  <Action name=\"project_data_clear_imported_session\"/>"
             "  <Action name=\"project_data_edit_boot_images\"/>"
+            "  <Action name=\"project_data_rescan\"/>"
             " </Menu>"
             "</MenuBar>"
             "</gui>", true );
@@ -13,6 +13,7 @@
 #include "k3bdatamultisessionimportdialog.h"
 #include "k3bdataprojectdelegate.h"
 #include "k3bdataprojectmodel.h"
+#include "k3bdatarescanjob.h"
 #include "k3bdataprojectsortproxymodel.h"
 #include "k3bdatapropertiesdialog.h"
 #include "k3bdataurladdingdialog.h"
@@ -71,9 +72,11 @@ K3b::DataViewImpl::DataViewImpl( View* view, DataDoc* doc, KActionCollection* ac
     m_doc( doc ),
     m_model( new DataProjectModel( doc, view ) ),
     m_sortModel( new DataProjectSortProxyModel( this ) ),
-    m_fileView( new QTreeView( view ) )
+    m_fileView( new QTreeView( view ) ),
+    m_rescanJob( new DataRescanJob( doc, this ) )
 {
     connect( m_doc, SIGNAL(importedSessionChanged(int)), this, SLOT(slotImportedSessionChanged(int)) );
+    connect( m_rescanJob, SIGNAL(finished(bool)), this, SLOT(slotRescanFinished()) );
     connect( m_model, SIGNAL(addUrlsRequested(QList<QUrl>,K3b::DirItem*)), SLOT(slotAddUrlsRequested(QList<QUrl>,K3b::DirItem*)) );
     connect( m_model, SIGNAL(moveItemsRequested(QList<K3b::DataItem*>,K3b::DirItem*)), SLOT(slotMoveItemsRequested(QList<K3b::DataItem*>,K3b::DirItem*)) );
 
@@ -154,6 +157,11 @@ K3b::DataViewImpl::DataViewImpl( View* view, DataDoc* doc, KActionCollection* ac
     actionCollection->addAction( "project_data_edit_boot_images", m_actionEditBootImages );
     connect( m_actionEditBootImages, SIGNAL(triggered(bool)), this, SLOT(slotEditBootImages()) );
 
+    m_actionRescan = new QAction( QIcon::fromTheme( "view-refresh" ), i18n("&Rescan Folders"), m_view );
+    m_actionRescan->setToolTip( i18n("Update the project with the changes made to the local folders since they were added") );
+    actionCollection->addAction( "project_data_rescan", m_actionRescan );
+    connect( m_actionRescan, SIGNAL(triggered(bool)), this, SLOT(slotRescan()) );
+
     QWidgetAction* volumeNameWidgetAction = new VolumeNameWidgetAction( m_doc, this );
     actionCollection->addAction( "project_volume_name", volumeNameWidgetAction );
 
@@ -375,6 +383,22 @@ void K3b::DataViewImpl::slotClearImportedSession()
 }
 
 
+void K3b::DataViewImpl::slotRescan()
+{
+    // the folders are read in a thread, the project is updated once it is done
+    if( !m_rescanJob->active() ) {
+        m_actionRescan->setEnabled( false );
+        m_rescanJob->start();
+    }
+}
+
+
+void K3b::DataViewImpl::slotRescanFinished()
+{
+    m_actionRescan->setEnabled( true );
+}
+
+
 void K3b::DataViewImpl::slotEditBootImages()
 {
     BootImageDialog dlg( m_doc );
@@ -22,6 +22,7 @@ namespace K3b {
     class DataDoc;
     class DataItem;
     class DataProjectModel;
+    class DataRescanJob;
     class DirItem;
     class View;
 
@@ -58,6 +59,8 @@ namespace K3b {
         void slotImportSession();
         void slotClearImportedSession();
         void slotEditBootImages();
+        void slotRescan();
+        void slotRescanFinished();
         void slotImportedSessionChanged( int importedSession );
         void slotAddUrlsRequested( QList<QUrl> urls, K3b::DirItem* targetDir );
         void slotMoveItemsRequested( QList<K3b::DataItem*> items, K3b::DirItem* targetDir );
@@ -69,6 +72,7 @@ namespace K3b {
         QSortFilterProxyModel* m_sortModel;
         QTreeView* m_fileView;
         ViewColumnAdjuster* m_columnAdjuster;
+        DataRescanJob* m_rescanJob;
 
         QAction* m_actionParentDir;
         QAction* m_actionRemove;
@@ -79,6 +83,7 @@ namespace K3b {
         QAction* m_actionImportSession;
         QAction* m_actionClearSession;
         QAction* m_actionEditBootImages;
+        QAction* m_actionRescan;
     };
 
 } // namespace K3b
@@ -0,0 +1,133 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+//
+// Summarizes and compares the telemetry logs K3b saves after burning
+// (telemetry/<date>-<time>.telemetry in the application data folder, the
+// last 20 burns are kept).
+//
+// k3btelemetry <log>               prints a summary of the log
+// k3btelemetry --csv <log>         prints the samples as CSV
+// k3btelemetry <log1> <log2> ...   prints a table comparing the logs
+//
+
+#include "k3bburntelemetry.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <stdio.h>
+
+
+namespace {
+    bool loadLog( const QString& path, K3b::BurnTelemetry& telemetry )
+    {
+        QFile file( path );
+        if( !file.open( QIODevice::ReadOnly ) ) {
+            fprintf( stderr, "Unable to open %s\n", qPrintable( path ) );
+            return false;
+        }
+        if( !telemetry.load( &file ) ) {
+            fprintf( stderr, "%s is not a K3b telemetry log\n", qPrintable( path ) );
+            return false;
+        }
+        return true;
+    }
+
+    QString minimum( const K3b::BurnTelemetry& telemetry, K3b::BurnTelemetry::Column column )
+    {
+        const K3b::BurnTelemetry::Statistics s = telemetry.statistics( column );
+        return s.count > 0 ? QString::number( s.min ) : QString( "-" );
+    }
+
+    QString average( const K3b::BurnTelemetry& telemetry, K3b::BurnTelemetry::Column column )
+    {
+        const K3b::BurnTelemetry::Statistics s = telemetry.statistics( column );
+        return s.count > 0 ? QString::number( s.average, 'f', 1 ) : QString( "-" );
+    }
+
+    QString lowTime( const K3b::BurnTelemetry& telemetry, K3b::BurnTelemetry::Column column )
+    {
+        if( telemetry.statistics( column ).count == 0 )
+            return QString( "-" );
+        return QString::number( telemetry.timeBelow( column, 20 ) / 1000 );
+    }
+}
+
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+    QCoreApplication::setApplicationName( "k3btelemetry" );
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription( "Summarize and compare K3b burn telemetry logs." );
+    parser.addHelpOption();
+    QCommandLineOption csvOption( "csv", "Print the samples of a log as comma separated values." );
+    parser.addOption( csvOption );
+    parser.addPositionalArgument( "logs", "The telemetry logs.", "<log> [<log>...]" );
+    parser.process( app );
+
+    const QStringList logs = parser.positionalArguments();
+    if( logs.isEmpty() )
+        parser.showHelp( 1 );
+
+    QTextStream out( stdout );
+
+    if( logs.count() == 1 || parser.isSet( csvOption ) ) {
+        Q_FOREACH( const QString& path, logs ) {
+            K3b::BurnTelemetry telemetry;
+            if( !loadLog( path, telemetry ) )
+                return 1;
+            out << ( parser.isSet( csvOption ) ? telemetry.toCsv() : telemetry.summary() ) << '\n';
+        }
+        return 0;
+    }
+
+    //
+    // One line per log. The low columns give the seconds in which the
+    // buffer was below 20%.
+    //
+    out << QString( "%1 %2 %3 %4 %5 %6 %7 %8 %9" )
+        .arg( "log", -24 )
+        .arg( "secs", 6 )
+        .arg( "speed", 6 )
+        .arg( "source", 8 )
+        .arg( "prefetch", 9 )
+        .arg( "fifo", 5 )
+        .arg( "fifo low", 9 )
+        .arg( "dev low", 8 )
+        .arg( "cpu", 6 )
+        << '\n';
+
+    Q_FOREACH( const QString& path, logs ) {
+        K3b::BurnTelemetry telemetry;
+        if( !loadLog( path, telemetry ) )
+            return 1;
+
+        const QVector<K3b::BurnTelemetry::Sample> samples = telemetry.samples();
+        const K3b::BurnTelemetry::Statistics speed = telemetry.statistics( K3b::BurnTelemetry::WriteSpeed );
+
+        out << QString( "%1 %2 %3 %4 %5 %6 %7 %8 %9" )
+            .arg( QFileInfo( path ).fileName().left( 24 ), -24 )
+            .arg( samples.isEmpty() ? 0 : samples.last().time / 1000, 6 )
+            .arg( speed.count > 0 && telemetry.speedMultiplicator() > 0
+                  ? QString::number( speed.average / telemetry.speedMultiplicator(), 'f', 2 ) + 'x'
+                  : QString( "-" ), 6 )
+            .arg( average( telemetry, K3b::BurnTelemetry::SourceRate ), 8 )
+            .arg( minimum( telemetry, K3b::BurnTelemetry::PrefetchBuffer ), 9 )
+            .arg( minimum( telemetry, K3b::BurnTelemetry::WriterBuffer ), 5 )
+            .arg( lowTime( telemetry, K3b::BurnTelemetry::WriterBuffer ), 9 )
+            .arg( lowTime( telemetry, K3b::BurnTelemetry::DeviceBuffer ), 8 )
+            .arg( average( telemetry, K3b::BurnTelemetry::CpuUsage ), 6 )
+            << '\n';
+    }
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+//
+// Compares feeding an image file to the raw stdin of a process the way the
+// writers are fed, and copying it to another file, by copying it through
+// user space and by moving it inside the kernel. Prints one line per run:
+//
+//   <mode>: <MiB> MiB in <ms> ms (<MiB/s> MiB/s)
+//
+// The image is read from the page cache, i.e. the numbers show the overhead
+// of the pumping itself.
+//
+
+#include "k3bactivepipebenchmark.h"
+#include "k3bprocess.h"
+
+#include <QCryptographicHash>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( ActivePipeBenchmark )
+
+namespace {
+    const int s_imageSize = 128*1024*1024;
+
+    void printRate( qint64 elapsed )
+    {
+        const double rate = elapsed > 0 ? double( s_imageSize ) / 1024.0 / 1024.0 * 1000.0 / double( elapsed ) : 0.0;
+        qDebug().noquote() << QString( "%1: %2 MiB in %3 ms (%4 MiB/s)" )
+            .arg( QTest::currentDataTag() )
+            .arg( s_imageSize / 1024 / 1024 )
+            .arg( elapsed )
+            .arg( rate, 0, 'f', 1 );
+    }
+
+    QByteArray md5( const QString& path )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return QByteArray();
+        QCryptographicHash hash( QCryptographicHash::Md5 );
+        hash.addData( &f );
+        return hash.result();
+    }
+}
+
+
+qint64 CopyingPipe::writeData( const char* data, qint64 max )
+{
+    return K3b::ActivePipe::writeData( data, max );
+}
+
+
+ActivePipeBenchmark::ActivePipeBenchmark()
+{
+}
+
+
+void ActivePipeBenchmark::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+    m_image = m_dir.filePath( "image.iso" );
+
+    QFile f( m_image );
+    QVERIFY( f.open( QIODevice::WriteOnly ) );
+    QByteArray block( 1024*1024, 0 );
+    for( int i = 0; i < s_imageSize / block.size(); ++i ) {
+        block.fill( char( i ) );
+        QCOMPARE( f.write( block ), qint64( block.size() ) );
+    }
+}
+
+
+void ActivePipeBenchmark::testFeedProcess_data()
+{
+    QTest::addColumn<bool>( "direct" );
+    QTest::newRow( "copy" ) << false;
+    QTest::newRow( "splice" ) << true;
+}
+
+
+void ActivePipeBenchmark::testFeedProcess()
+{
+    QFETCH( bool, direct );
+
+    K3b::Process process;
+    process.setFlags( K3bQProcess::RawStdin );
+    process << "wc" << "-c";
+    QSignalSpy finishedSpy( &process, SIGNAL(finished(int,QProcess::ExitStatus)) );
+    QVERIFY( process.start( KProcess::SeparateChannels ) );
+
+    QFile image( m_image );
+    K3b::ActivePipe* pipe = direct ? new K3b::ActivePipe() : new CopyingPipe();
+    pipe->readFrom( &image, true );
+    pipe->writeTo( &process, true );
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY( pipe->open( true ) );
+    QVERIFY( finishedSpy.wait( 60000 ) );
+    const qint64 elapsed = timer.elapsed();
+
+    QCOMPARE( pipe->bytesWritten(), quint64( s_imageSize ) );
+    QCOMPARE( process.readAllStandardOutput().trimmed().toLongLong(), qint64( s_imageSize ) );
+    delete pipe;
+
+    printRate( elapsed );
+}
+
+
+void ActivePipeBenchmark::testCopyFile_data()
+{
+    QTest::addColumn<bool>( "direct" );
+    QTest::newRow( "copy to file" ) << false;
+    QTest::newRow( "copy_file_range" ) << true;
+}
+
+
+void ActivePipeBenchmark::testCopyFile()
+{
+    QFETCH( bool, direct );
+
+    const QString target = m_dir.filePath( "copy.iso" );
+    QFile::remove( target );
+
+    QFile image( m_image );
+    QFile copy( target );
+    K3b::ActivePipe* pipe = direct ? new K3b::ActivePipe() : new CopyingPipe();
+    pipe->readFrom( &image );
+    pipe->writeTo( &copy );
+
+    // closing the pipe waits for the pumping as the files are left open
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY( pipe->open() );
+    pipe->close();
+    const qint64 elapsed = timer.elapsed();
+
+    QCOMPARE( pipe->bytesWritten(), quint64( s_imageSize ) );
+    delete pipe;
+    copy.close();
+
+    QCOMPARE( QFile( target ).size(), qint64( s_imageSize ) );
+    QCOMPARE( md5( target ), md5( m_image ) );
+
+    printRate( elapsed );
+}
+
+#include "moc_k3bactivepipebenchmark.cpp"
@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_ACTIVE_PIPE_BENCHMARK_H
+#define K3B_ACTIVE_PIPE_BENCHMARK_H
+
+#include "k3bactivepipe.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+/**
+ * Forces the pumping through readData() and writeData(). Like every
+ * subclass it never gets the data moved inside the kernel.
+ */
+class CopyingPipe : public K3b::ActivePipe
+{
+    Q_OBJECT
+protected:
+    qint64 writeData( const char* data, qint64 max ) override;
+};
+
+class ActivePipeBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    ActivePipeBenchmark();
+private slots:
+    void initTestCase();
+    void testFeedProcess_data();
+    void testFeedProcess();
+    void testCopyFile_data();
+    void testCopyFile();
+
+private:
+    QTemporaryDir m_dir;
+    QString m_image;
+};
+
+#endif // K3B_ACTIVE_PIPE_BENCHMARK_H
@@ -0,0 +1,270 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bbatchingestjobtest.h"
+#include "k3bbatchingestjob.h"
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3bmediacache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <string.h>
+
+QTEST_GUILESS_MAIN( BatchIngestJobTest )
+
+namespace {
+    const int s_imageSectors = 600;
+
+    void setBothEndian16( char* p, quint16 value )
+    {
+        p[0] = char( value );
+        p[1] = char( value >> 8 );
+        p[2] = char( value >> 8 );
+        p[3] = char( value );
+    }
+
+    void setBothEndian32( char* p, quint32 value )
+    {
+        for( int i = 0; i < 4; ++i ) {
+            p[i] = char( value >> ( 8*i ) );
+            p[7-i] = char( value >> ( 8*i ) );
+        }
+    }
+
+    int directoryRecord( char* p, quint32 extent, quint32 size, const QByteArray& name )
+    {
+        const int len = 33 + name.size() + ( name.size() % 2 ? 0 : 1 );
+        ::memset( p, 0, len );
+        p[0] = len;
+        setBothEndian32( p + 2, extent );
+        setBothEndian32( p + 10, size );
+        p[18] = 126; // 2026
+        p[19] = 1;
+        p[20] = 1;
+        p[25] = 0x02;
+        setBothEndian16( p + 28, 1 );
+        p[32] = name.size();
+        ::memcpy( p + 33, name.constData(), name.size() );
+        return len;
+    }
+
+    bool runJob( K3b::Job* job )
+    {
+        QSignalSpy spy( job, SIGNAL(finished(bool)) );
+        job->start();
+        if( spy.isEmpty() && !spy.wait( 60000 ) )
+            return false;
+        return spy.first().first().toBool();
+    }
+
+    QByteArray fileContents( const QString& path )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return QByteArray();
+        return f.readAll();
+    }
+}
+
+
+BatchIngestJobTest::BatchIngestJobTest()
+    : m_core( 0 ),
+      m_manager( 0 ),
+      m_device( 0 )
+{
+}
+
+
+K3b::Device::MediaType BatchIngestJobTest::waitForMedium( K3b::Device::Device* dev,
+                                                          K3b::Device::MediaStates,
+                                                          K3b::Device::MediaTypes,
+                                                          const K3b::Msf&,
+                                                          const QString& )
+{
+    return dev->diskInfo().mediaType();
+}
+
+
+bool BatchIngestJobTest::questionYesNo( const QString&,
+                                        const QString&,
+                                        const KGuiItem&,
+                                        const KGuiItem& )
+{
+    return true;
+}
+
+
+void BatchIngestJobTest::blockingInformation( const QString&,
+                                              const QString& )
+{
+}
+
+
+//
+// An ISO9660 file system with an empty root folder. The remaining sectors
+// differ from disc to disc.
+//
+QString BatchIngestJobTest::createImage( const QByteArray& volumeId )
+{
+    QByteArray image( s_imageSectors*2048, 0 );
+
+    char* pvd = image.data() + 16*2048;
+    pvd[0] = 1;
+    ::memcpy( pvd + 1, "CD001", 5 );
+    pvd[6] = 1;
+    ::memset( pvd + 8, ' ', 64 );
+    ::memcpy( pvd + 40, volumeId.constData(), volumeId.size() );
+    setBothEndian32( pvd + 80, s_imageSectors );
+    setBothEndian16( pvd + 120, 1 );
+    setBothEndian16( pvd + 124, 1 );
+    setBothEndian16( pvd + 128, 2048 );
+    directoryRecord( pvd + 156, 18, 2048, QByteArray( 1, '\0' ) );
+    ::memset( pvd + 190, ' ', 623 );
+    ::memset( pvd + 813, '0', 68 );
+    pvd[881] = 1;
+
+    char* terminator = image.data() + 17*2048;
+    terminator[0] = char( 255 );
+    ::memcpy( terminator + 1, "CD001", 5 );
+    terminator[6] = 1;
+
+    char* dir = image.data() + 18*2048;
+    const int pos = directoryRecord( dir, 18, 2048, QByteArray( 1, '\0' ) );
+    directoryRecord( dir + pos, 18, 2048, QByteArray( 1, '\1' ) );
+
+    const uint seed = qHash( volumeId );
+    for( int sector = 19; sector < s_imageSectors; ++sector ) {
+        quint32* words = reinterpret_cast<quint32*>( image.data() + sector*2048 );
+        for( int i = 0; i < 512; ++i )
+            words[i] = ( quint32( sector ) * 2654435761U ^ i ) + seed;
+    }
+
+    const QString path = m_dir.filePath( QString::fromLatin1( volumeId ) + ".source" );
+    QFile f( path );
+    if( !f.open( QIODevice::WriteOnly ) || f.write( image ) != image.size() )
+        return QString();
+    return path;
+}
+
+
+void BatchIngestJobTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    const QString image = createImage( "K3B_INGEST_1" );
+    QVERIFY( !image.isEmpty() );
+    QVERIFY( m_drive.setImage( image, TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.install();
+
+    m_core = new K3b::Core( this );
+
+    m_manager = new TestUtils::EmulatedDeviceManager( this );
+    m_device = m_manager->addEmulatedDevice( m_dir.path() );
+    QVERIFY( m_device );
+
+    // the job learns about inserted discs from the media cache
+    m_core->mediaCache()->buildDeviceList( m_manager );
+}
+
+
+void BatchIngestJobTest::cleanupTestCase()
+{
+    if( m_core )
+        m_core->mediaCache()->clearDeviceList();
+    delete m_manager;
+    m_manager = 0;
+    delete m_core;
+    m_core = 0;
+    m_drive.uninstall();
+}
+
+
+void BatchIngestJobTest::init()
+{
+    m_drive.clearReadErrors();
+    m_drive.resetCounters();
+}
+
+
+void BatchIngestJobTest::testIngestDiscs()
+{
+    const QString first = m_dir.filePath( "K3B_INGEST_1.source" );
+    const QString second = createImage( "K3B_INGEST_2" );
+    QVERIFY( !second.isEmpty() );
+    QVERIFY( m_drive.setImage( first, TestUtils::EmulatedDrive::CD_ROM ) );
+
+    const QString target = m_dir.filePath( "images" );
+
+    K3b::BatchIngestJob job( this, this );
+    job.setDevices( QList<K3b::Device::Device*>() << m_device );
+    job.setTargetDirectory( target );
+    job.setDiscCount( 2 );
+    job.setEjectWhenDone( true );
+
+    // the second disc is inserted once the first one has been ejected
+    QSignalSpy imagedSpy( &job, SIGNAL(discImaged(K3b::Device::Device*,QString)) );
+    QSignalSpy finishedSpy( &job, SIGNAL(finished(bool)) );
+    job.start();
+
+    QVERIFY( imagedSpy.count() > 0 || imagedSpy.wait( 60000 ) );
+    QTRY_VERIFY_WITH_TIMEOUT( !m_drive.mediumLoaded(), 10000 );
+    QVERIFY( m_drive.setImage( second, TestUtils::EmulatedDrive::CD_ROM ) );
+
+    QVERIFY( finishedSpy.count() > 0 || finishedSpy.wait( 60000 ) );
+    QVERIFY( finishedSpy.first().first().toBool() );
+    QCOMPARE( job.imagedDiscs(), 2 );
+    QCOMPARE( job.failedDiscs(), 0 );
+    QCOMPARE( imagedSpy.count(), 2 );
+
+    const QStringList sources = QStringList() << first << second;
+    for( int i = 0; i < 2; ++i ) {
+        const QString imagePath = imagedSpy[i][1].toString();
+        QVERIFY( QFileInfo( imagePath ).fileName().startsWith( QString( "K3B_INGEST_%1-" ).arg( i+1 ) ) );
+        QCOMPARE( QFileInfo( imagePath ).absolutePath(), QDir( target ).absolutePath() );
+
+        const QByteArray source = fileContents( sources[i] );
+        QCOMPARE( fileContents( imagePath ), source );
+
+        // the checksum file can be checked with md5sum -c
+        const QByteArray md5 = QCryptographicHash::hash( source, QCryptographicHash::Md5 ).toHex();
+        QCOMPARE( fileContents( imagePath + ".md5" ),
+                  md5 + "  " + QFileInfo( imagePath ).fileName().toUtf8() + '\n' );
+    }
+
+    QVERIFY( !m_drive.mediumLoaded() );
+}
+
+
+void BatchIngestJobTest::testReadError()
+{
+    const QString image = m_dir.filePath( "K3B_INGEST_1.source" );
+    QVERIFY( m_drive.setImage( image, TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.addReadError( 100 );
+
+    const QString target = m_dir.filePath( "failed" );
+
+    K3b::BatchIngestJob job( this, this );
+    job.setDevices( QList<K3b::Device::Device*>() << m_device );
+    job.setTargetDirectory( target );
+    job.setDiscCount( 1 );
+    job.setEjectWhenDone( false );
+    job.setReadRetries( 1 );
+
+    QVERIFY( !runJob( &job ) );
+    QCOMPARE( job.imagedDiscs(), 0 );
+    QCOMPARE( job.failedDiscs(), 1 );
+
+    // the incomplete image is removed
+    QVERIFY( QDir( target ).entryList( QStringList() << "*.iso", QDir::Files ).isEmpty() );
+}
+
+#include "moc_k3bbatchingestjobtest.cpp"
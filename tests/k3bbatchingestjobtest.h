@@ -0,0 +1,58 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_BATCH_INGEST_JOB_TEST_H
+#define K3B_BATCH_INGEST_JOB_TEST_H
+
+#include "k3bemulateddrive.h"
+#include "k3bjobhandler.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+namespace K3b {
+    class Core;
+    namespace Device {
+        class Device;
+    }
+}
+
+class BatchIngestJobTest : public QObject, public K3b::JobHandler
+{
+    Q_OBJECT
+public:
+    BatchIngestJobTest();
+
+    K3b::Device::MediaType waitForMedium( K3b::Device::Device*,
+                                          K3b::Device::MediaStates mediaState,
+                                          K3b::Device::MediaTypes mediaType,
+                                          const K3b::Msf& minMediaSize,
+                                          const QString& message ) override;
+    bool questionYesNo( const QString& text,
+                        const QString& caption,
+                        const KGuiItem& buttonYes,
+                        const KGuiItem& buttonNo ) override;
+    void blockingInformation( const QString& text,
+                              const QString& caption ) override;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void testIngestDiscs();
+    void testReadError();
+
+private:
+    QString createImage( const QByteArray& volumeId );
+
+    QTemporaryDir m_dir;
+    K3b::Core* m_core;
+    TestUtils::EmulatedDeviceManager* m_manager;
+    K3b::Device::Device* m_device;
+    TestUtils::EmulatedDrive m_drive;
+};
+
+#endif // K3B_BATCH_INGEST_JOB_TEST_H
@@ -0,0 +1,116 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bburntelemetrytest.h"
+#include "k3bburntelemetry.h"
+
+#include <QBuffer>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( BurnTelemetryTest )
+
+
+FakeBurnJob::FakeBurnJob()
+    : K3b::BurnJob( 0 )
+{
+}
+
+
+QString FakeBurnJob::jobDescription() const
+{
+    return "Fake burn job";
+}
+
+
+void FakeBurnJob::start()
+{
+}
+
+
+void FakeBurnJob::cancel()
+{
+}
+
+
+BurnTelemetryTest::BurnTelemetryTest()
+{
+}
+
+
+void BurnTelemetryTest::testSaveLoad()
+{
+    FakeBurnJob job;
+    K3b::BurnTelemetry telemetry;
+    telemetry.setJob( &job );
+
+    emit job.started();
+    emit job.sourceThroughput( 5000 );
+    emit job.prefetchBuffer( 80 );
+    emit job.bufferStatus( 90 );
+    emit job.writeSpeed( 11080, K3b::Device::SPEED_FACTOR_DVD );
+    QTest::qWait( 1200 );
+    emit job.deviceBuffer( 10 );
+    emit job.finished( true );
+
+    const QVector<K3b::BurnTelemetry::Sample> samples = telemetry.samples();
+    QVERIFY( samples.count() >= 2 );
+    QCOMPARE( samples.last().values[K3b::BurnTelemetry::DeviceBuffer], 10 );
+    QCOMPARE( samples.first().values[K3b::BurnTelemetry::DeviceBuffer], -1 );
+
+    QBuffer buffer;
+    QVERIFY( buffer.open( QIODevice::WriteOnly ) );
+    QVERIFY( telemetry.save( &buffer ) );
+    buffer.close();
+
+    QVERIFY( buffer.open( QIODevice::ReadOnly ) );
+    K3b::BurnTelemetry loaded;
+    QVERIFY( loaded.load( &buffer ) );
+    QVERIFY( buffer.atEnd() );
+
+    QCOMPARE( loaded.description(), QString( "Fake burn job" ) );
+    QCOMPARE( loaded.speedMultiplicator(), int( K3b::Device::SPEED_FACTOR_DVD ) );
+    QCOMPARE( loaded.samples().count(), samples.count() );
+    for( int i = 0; i < samples.count(); ++i ) {
+        QCOMPARE( loaded.samples()[i].time, samples[i].time );
+        for( int c = 0; c < K3b::BurnTelemetry::NumColumns; ++c )
+            QCOMPARE( loaded.samples()[i].values[c], samples[i].values[c] );
+    }
+    QCOMPARE( loaded.toCsv(), telemetry.toCsv() );
+    QCOMPARE( loaded.summary(), telemetry.summary() );
+}
+
+
+void BurnTelemetryTest::testLoadInvalid()
+{
+    FakeBurnJob job;
+    K3b::BurnTelemetry telemetry;
+    telemetry.setJob( &job );
+    emit job.started();
+    emit job.finished( true );
+    QCOMPARE( telemetry.samples().count(), 1 );
+
+    QByteArray data;
+    QBuffer buffer( &data );
+    QVERIFY( buffer.open( QIODevice::WriteOnly ) );
+    QVERIFY( telemetry.save( &buffer ) );
+    buffer.close();
+
+    // a truncated log is rejected and leaves the samples alone
+    K3b::BurnTelemetry loaded;
+    QBuffer truncated;
+    truncated.setData( data.left( data.size() - 1 ) );
+    QVERIFY( truncated.open( QIODevice::ReadOnly ) );
+    QVERIFY( !loaded.load( &truncated ) );
+    QVERIFY( loaded.samples().isEmpty() );
+
+    QBuffer garbage;
+    garbage.setData( QByteArray( 64, 'x' ) );
+    QVERIFY( garbage.open( QIODevice::ReadOnly ) );
+    QVERIFY( !loaded.load( &garbage ) );
+    QVERIFY( loaded.description().isEmpty() );
+}
+
+#include "moc_k3bburntelemetrytest.cpp"
@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_BURN_TELEMETRY_TEST_H
+#define K3B_BURN_TELEMETRY_TEST_H
+
+#include "k3bjob.h"
+
+#include <QObject>
+
+/**
+ * A burn job which only reports what the test tells it to.
+ */
+class FakeBurnJob : public K3b::BurnJob
+{
+    Q_OBJECT
+public:
+    FakeBurnJob();
+
+    QString jobDescription() const override;
+
+public Q_SLOTS:
+    void start() override;
+    void cancel() override;
+};
+
+class BurnTelemetryTest : public QObject
+{
+    Q_OBJECT
+public:
+    BurnTelemetryTest();
+private slots:
+    void testSaveLoad();
+    void testLoadInvalid();
+};
+
+#endif // K3B_BURN_TELEMETRY_TEST_H
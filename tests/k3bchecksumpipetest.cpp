@@ -0,0 +1,136 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bchecksumpipetest.h"
+#include "k3bchecksumpipe.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( ChecksumPipeTest )
+
+namespace {
+    QByteArray testData( int size )
+    {
+        QByteArray data( size, 0 );
+        for( int i = 0; i < size; ++i )
+            data[i] = char( i * 13 + i / 251 );
+        return data;
+    }
+
+    QByteArray md5( const QByteArray& data )
+    {
+        return QCryptographicHash::hash( data, QCryptographicHash::Md5 ).toHex();
+    }
+
+    // the pipe only serves as a conduit since no source is set
+    bool writeChunked( K3b::ChecksumPipe& pipe, const QByteArray& data, int chunkSize )
+    {
+        for( int pos = 0; pos < data.size(); pos += chunkSize ) {
+            const int len = qMin( chunkSize, data.size() - pos );
+            if( pipe.write( data.constData() + pos, len ) != len )
+                return false;
+        }
+        return true;
+    }
+}
+
+
+ChecksumPipeTest::ChecksumPipeTest()
+{
+}
+
+
+void ChecksumPipeTest::testExtentChecksums_data()
+{
+    QTest::addColumn<int>( "dataSize" );
+    QTest::addColumn<int>( "extentSize" );
+    QTest::addColumn<int>( "chunkSize" );
+
+    QTest::newRow( "whole extents" ) << 4*4096 << 4096 << 1000;
+    QTest::newRow( "partial last extent" ) << 4*4096 + 100 << 4096 << 1000;
+    QTest::newRow( "chunks spanning extents" ) << 10*1000 + 1 << 1000 << 2500;
+    QTest::newRow( "chunks matching extents" ) << 8*2048 << 2048 << 2048;
+    QTest::newRow( "single bytes" ) << 3*64 + 1 << 64 << 1;
+    QTest::newRow( "less than one extent" ) << 100 << 4096 << 30;
+}
+
+
+void ChecksumPipeTest::testExtentChecksums()
+{
+    QFETCH( int, dataSize );
+    QFETCH( int, extentSize );
+    QFETCH( int, chunkSize );
+
+    const QByteArray data = testData( dataSize );
+
+    QBuffer sink;
+    K3b::ChecksumPipe pipe;
+    pipe.writeTo( &sink, true );
+    pipe.setExtentSize( extentSize );
+    QVERIFY( pipe.open() );
+    QVERIFY( writeChunked( pipe, data, chunkSize ) );
+    pipe.close();
+
+    QCOMPARE( sink.data(), data );
+    QCOMPARE( pipe.checksum(), md5( data ) );
+
+    // the last extent covers the remaining data
+    QList<QByteArray> expected;
+    for( int pos = 0; pos < dataSize; pos += extentSize )
+        expected << md5( data.mid( pos, extentSize ) );
+    QCOMPARE( pipe.extentChecksums(), expected );
+
+    // asking again does not add the partial extent twice
+    QCOMPARE( pipe.extentChecksums(), expected );
+}
+
+
+void ChecksumPipeTest::testNoExtents()
+{
+    const QByteArray data = testData( 10000 );
+
+    QBuffer sink;
+    K3b::ChecksumPipe pipe;
+    pipe.writeTo( &sink, true );
+    QCOMPARE( pipe.extentSize(), qint64( 0 ) );
+    QVERIFY( pipe.open() );
+    QVERIFY( writeChunked( pipe, data, 999 ) );
+    pipe.close();
+
+    QCOMPARE( pipe.checksum(), md5( data ) );
+    QVERIFY( pipe.extentChecksums().isEmpty() );
+}
+
+
+void ChecksumPipeTest::testReopen()
+{
+    const QByteArray first = testData( 5000 );
+    const QByteArray second = testData( 2500 );
+
+    QBuffer sink;
+    K3b::ChecksumPipe pipe;
+    pipe.writeTo( &sink, true );
+    pipe.setExtentSize( 1024 );
+    QVERIFY( pipe.open() );
+    QVERIFY( writeChunked( pipe, first, 700 ) );
+    pipe.close();
+    QCOMPARE( pipe.extentChecksums().count(), 5 );
+
+    // opening the pipe again starts new checksums
+    QVERIFY( pipe.open() );
+    QVERIFY( writeChunked( pipe, second, 700 ) );
+    pipe.close();
+
+    QCOMPARE( pipe.checksum(), md5( second ) );
+    QCOMPARE( pipe.extentChecksums(),
+              QList<QByteArray>() << md5( second.left( 1024 ) )
+                                  << md5( second.mid( 1024, 1024 ) )
+                                  << md5( second.mid( 2048 ) ) );
+}
+
+#include "moc_k3bchecksumpipetest.cpp"
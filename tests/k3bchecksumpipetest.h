@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_CHECKSUM_PIPE_TEST_H
+#define K3B_CHECKSUM_PIPE_TEST_H
+
+#include <QObject>
+
+class ChecksumPipeTest : public QObject
+{
+    Q_OBJECT
+public:
+    ChecksumPipeTest();
+private slots:
+    void testExtentChecksums_data();
+    void testExtentChecksums();
+    void testNoExtents();
+    void testReopen();
+};
+
+#endif // K3B_CHECKSUM_PIPE_TEST_H
@@ -6,21 +6,57 @@
 */
 
 #include "k3bdataprojectmodeltest.h"
+#include "k3bcore.h"
 #include "k3bdatadoc.h"
 #include "k3bdataprojectmodel.h"
 #include "k3bdataitem.h"
+#include "k3bdatarescanjob.h"
 #include "k3bdiritem.h"
 #include "k3bspecialdataitem.h"
 #include "k3btestutils.h"
 
+#include <QDir>
+#include <QFile>
 #include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTest>
 
+#include <utime.h>
+
 QTEST_GUILESS_MAIN( DataProjectModelTest )
 
 Q_DECLARE_METATYPE( QModelIndex )
 
+namespace {
+    bool writeFile( const QString& path, int size )
+    {
+        QFile file( path );
+        if( !file.open( QIODevice::WriteOnly|QIODevice::Truncate ) )
+            return false;
+        return file.write( QByteArray( size, 'x' ) ) == size;
+    }
+
+    // make sure a change is visible even on filesystems with coarse timestamps
+    bool touchDir( const QString& path )
+    {
+        struct utimbuf times;
+        times.actime = times.modtime = 1000;
+        return ::utime( QFile::encodeName( path ), &times ) == 0;
+    }
+
+    int rescan( K3b::DataDoc* doc )
+    {
+        K3b::DataRescanJob job( doc );
+        QSignalSpy spy( &job, SIGNAL(finished(bool)) );
+        job.start();
+        if( !spy.wait( 10000 ) || !spy.first().first().toBool() )
+            return -1;
+        return job.changes();
+    }
+}
+
 DataProjectModelTest::DataProjectModelTest()
+    : m_core( new K3b::Core( this ) )
 {
     qRegisterMetaType<QModelIndex>();
 }
@@ -86,4 +122,85 @@ void DataProjectModelTest::testRemove()
     spy.check( model.indexForItem( m_doc->root() ), 3 );
 }
 
+void DataProjectModelTest::testRescan()
+{
+    QTemporaryDir tempDir;
+    QVERIFY( tempDir.isValid() );
+    const QString sourcePath = tempDir.path() + "/source";
+    QVERIFY( QDir().mkpath( sourcePath + "/unchanged" ) );
+    QVERIFY( writeFile( sourcePath + "/kept", 100 ) );
+    QVERIFY( writeFile( sourcePath + "/removed", 200 ) );
+    QVERIFY( writeFile( sourcePath + "/unchanged/file", 300 ) );
+
+    m_doc->addUrlsToDir( QList<QUrl>() << QUrl::fromLocalFile( sourcePath ), m_doc->root() );
+    K3b::DirItem* dir = dynamic_cast<K3b::DirItem*>( m_doc->root()->find( "source" ) );
+    QVERIFY( dir != 0 );
+    QCOMPARE( dir->children().count(), 3 );
+    QCOMPARE( dir->size(), KIO::filesize_t( 600 ) );
+
+    // nothing changed on disk
+    QCOMPARE( rescan( m_doc ), 0 );
+
+    QVERIFY( QFile::remove( sourcePath + "/removed" ) );
+    QVERIFY( writeFile( sourcePath + "/added", 400 ) );
+    QVERIFY( writeFile( sourcePath + "/kept", 150 ) );
+
+    QVERIFY( touchDir( sourcePath ) );
+
+    K3b::DataProjectModel model( m_doc );
+    TestUtils::InsertRemoveModelSpy spy( &model,
+                                         SIGNAL(rowsAboutToBeInserted(QModelIndex,int,int)),
+                                         SIGNAL(rowsInserted(QModelIndex,int,int)) );
+
+    // one removed, one added and one updated item
+    QCOMPARE( rescan( m_doc ), 3 );
+    QVERIFY( dir->find( "removed" ) == 0 );
+    QVERIFY( dir->find( "added" ) != 0 );
+    QCOMPARE( dir->find( "kept" )->size(), KIO::filesize_t( 150 ) );
+    QCOMPARE( dir->size(), KIO::filesize_t( 850 ) );
+
+    // the updated and the new item are inserted in one go
+    spy.check( model.indexForItem( dir ), 1, 2 );
+
+    QCOMPARE( rescan( m_doc ), 0 );
+}
+
+
+void DataProjectModelTest::testRescanKeepsChoices()
+{
+    QTemporaryDir tempDir;
+    QVERIFY( tempDir.isValid() );
+    const QString sourcePath = tempDir.path() + "/source";
+    QVERIFY( QDir().mkpath( sourcePath ) );
+    QVERIFY( writeFile( sourcePath + "/removed", 100 ) );
+    QVERIFY( writeFile( sourcePath + "/kept", 100 ) );
+
+    m_doc->addUrlsToDir( QList<QUrl>() << QUrl::fromLocalFile( sourcePath ), m_doc->root() );
+    K3b::DirItem* dir = dynamic_cast<K3b::DirItem*>( m_doc->root()->find( "source" ) );
+    QVERIFY( dir != 0 );
+    QCOMPARE( dir->children().count(), 2 );
+
+    // as if the user chose not to add hidden files and removed an item afterwards
+    dir->setLocalAddOptions( K3b::DirItem::LocalAddOptions() );
+    delete dir->find( "removed" );
+    QCOMPARE( dir->children().count(), 1 );
+
+    QVERIFY( writeFile( sourcePath + "/.hidden", 100 ) );
+    QVERIFY( QDir().mkpath( sourcePath + "/newdir/.hiddendir" ) );
+    QVERIFY( writeFile( sourcePath + "/newdir/file", 100 ) );
+    QVERIFY( touchDir( sourcePath ) );
+
+    // only the new folder and its visible contents
+    QCOMPARE( rescan( m_doc ), 2 );
+    QVERIFY( dir->find( "removed" ) == 0 );
+    QVERIFY( dir->find( ".hidden" ) == 0 );
+    K3b::DirItem* newDir = dynamic_cast<K3b::DirItem*>( dir->find( "newdir" ) );
+    QVERIFY( newDir != 0 );
+    QCOMPARE( newDir->children().count(), 1 );
+    QVERIFY( newDir->find( "file" ) != 0 );
+    QCOMPARE( newDir->localAddOptions(), K3b::DirItem::LocalAddOptions() );
+
+    QCOMPARE( rescan( m_doc ), 0 );
+}
+
 #include "moc_k3bdataprojectmodeltest.cpp"
@@ -11,7 +11,7 @@
 #include <QObject>
 #include <QPointer>
 
-namespace K3b { class DataDoc; }
+namespace K3b { class Core; class DataDoc; }
 
 class DataProjectModelTest : public QObject
 {
@@ -26,8 +26,11 @@ private slots:
     void testCreate();
     void testAdd();
     void testRemove();
+    void testRescan();
+    void testRescanKeepsChoices();
 
 private:
+    K3b::Core* m_core;
     QPointer<K3b::DataDoc> m_doc;
 };
 
@@ -0,0 +1,298 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bdevicequerytest.h"
+#include "k3bcommandtrace.h"
+#include "k3bdevice.h"
+#include "k3bscsicommand.h"
+
+#include <QBuffer>
+#include <QFile>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( DeviceQueryTest )
+
+namespace {
+    const K3b::Device::WritingModes s_writingModes = ( K3b::Device::WRITINGMODE_TAO |
+                                                       K3b::Device::WRITINGMODE_SAO |
+                                                       K3b::Device::WRITINGMODE_SAO_R96R |
+                                                       K3b::Device::WRITINGMODE_RAW |
+                                                       K3b::Device::WRITINGMODE_RAW_R96R );
+}
+
+
+DeviceQueryTest::DeviceQueryTest()
+    : m_manager( 0 ),
+      m_device( 0 )
+{
+}
+
+void DeviceQueryTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    const QString image = m_dir.filePath( "data.iso" );
+    QFile imageFile( image );
+    QVERIFY( imageFile.open( QIODevice::WriteOnly ) );
+    QVERIFY( imageFile.resize( 300*2048 ) );
+    imageFile.close();
+
+    QVERIFY( m_drive.setImage( image, TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.setWritingModes( s_writingModes );
+    m_drive.install();
+
+    m_manager = new TestUtils::EmulatedDeviceManager( this );
+    m_device = m_manager->addEmulatedDevice( m_dir.path() );
+    QVERIFY( m_device );
+    QCOMPARE( m_device->vendor(), QString( "K3B" ) );
+    QVERIFY( !m_device->isOpen() );
+}
+
+void DeviceQueryTest::cleanupTestCase()
+{
+    delete m_manager;
+    m_manager = 0;
+    m_drive.uninstall();
+}
+
+void DeviceQueryTest::init()
+{
+    m_drive.setCdText( QByteArray() );
+    m_drive.setBusyCommands( 0 );
+    m_drive.setRejectOversizedAllocations( false );
+    m_drive.resetCounters();
+}
+
+void DeviceQueryTest::testWritingModes()
+{
+    // determined by init() via MODE SELECT
+    QCOMPARE( m_device->writingModes(), s_writingModes );
+    QVERIFY( m_device->writesCd() );
+}
+
+void DeviceQueryTest::testSingleRoundTrip()
+{
+    K3b::Device::UByteArray data;
+
+    QVERIFY( m_device->readDiscInformation( data ) );
+    QCOMPARE( int( data.size() ), 34 );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->readTrackInformation( data, 1, 1 ) );
+    QCOMPARE( int( data.size() ), 36 );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->readTocPmaAtip( data, 0, false, 0 ) );
+    QCOMPARE( int( data.size() ), 20 );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->getFeature( data, 0 ) );
+    QCOMPARE( int( data.size() ), 20 );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->modeSense( data, 0x2A ) );
+    QCOMPARE( int( data.size() ), 36 );
+    QCOMPARE( m_drive.commands(), 1 );
+}
+
+void DeviceQueryTest::testTruncatedReply()
+{
+    // more CD-TEXT than fits into the first reply
+    m_drive.setCdText( QByteArray( 18*150, 0 ) );
+
+    K3b::Device::UByteArray data;
+    QVERIFY( m_device->readTocPmaAtip( data, 5, false, 0 ) );
+    QCOMPARE( int( data.size() ), 4 + 18*150 );
+    QCOMPARE( m_drive.commands(), 2 );
+}
+
+void DeviceQueryTest::testHandleReference()
+{
+    m_device->diskInfo();
+    QVERIFY( m_drive.commands() > 1 );
+    QCOMPARE( m_drive.opens(), 1 );
+    QVERIFY( !m_device->isOpen() );
+
+    m_drive.resetCounters();
+    {
+        K3b::Device::HandleReference ref( m_device );
+        QVERIFY( ref.isValid() );
+        m_device->diskInfo();
+        m_device->readToc();
+        QVERIFY( m_device->isOpen() );
+    }
+    QCOMPARE( m_drive.opens(), 1 );
+    QVERIFY( !m_device->isOpen() );
+}
+
+void DeviceQueryTest::testHandleOwners()
+{
+    // the device has been opened explicitly, the first reference does not own it
+    QVERIFY( m_device->open() );
+    {
+        K3b::Device::HandleReference outer( m_device );
+        QVERIFY( outer.isValid() );
+        m_device->close();
+
+        // the inner reference has to open the device again and thus owns it
+        K3b::Device::HandleReference inner( m_device );
+        QVERIFY( inner.isValid() );
+        QVERIFY( m_device->isOpen() );
+    }
+    QVERIFY( !m_device->isOpen() );
+
+    // an explicitly opened device stays open
+    QVERIFY( m_device->open() );
+    {
+        K3b::Device::HandleReference ref( m_device );
+        QVERIFY( ref.isValid() );
+    }
+    QVERIFY( m_device->isOpen() );
+    m_device->close();
+}
+
+void DeviceQueryTest::testCommandTrace()
+{
+    K3b::Device::CommandTrace* trace = m_device->commandTrace();
+    trace->reset();
+
+    K3b::Device::UByteArray data;
+    QVERIFY( m_device->readDiscInformation( data ) );
+    QVERIFY( m_device->readDiscInformation( data ) );
+    QVERIFY( !m_device->modeSense( data, 0x0E ) );
+
+    QCOMPARE( trace->commands(), quint64( m_drive.commands() ) );
+
+    K3b::Device::CommandTrace::Statistics s = trace->statistics( K3b::Device::MMC_READ_DISC_INFORMATION );
+    QCOMPARE( s.count, quint64( 2 ) );
+    QCOMPARE( s.failures, quint64( 0 ) );
+    QVERIFY( s.bytes >= 2*34 );
+    quint64 histogramCount = 0;
+    Q_FOREACH( quint64 n, s.histogram )
+        histogramCount += n;
+    QCOMPARE( histogramCount, s.count );
+
+    s = trace->statistics( K3b::Device::MMC_MODE_SENSE );
+    QVERIFY( s.failures > 0 );
+
+    // the sense data is kept for failed commands only
+    QList<K3b::Device::CommandTrace::Record> records = trace->records();
+    QCOMPARE( quint64( records.count() ), trace->commands() );
+    QCOMPARE( records.first().opcode, quint8( K3b::Device::MMC_READ_DISC_INFORMATION ) );
+    QCOMPARE( records.first().result, 0 );
+    QCOMPARE( records.first().senseKey, quint8( 0 ) );
+    QCOMPARE( records.last().opcode, quint8( K3b::Device::MMC_MODE_SENSE ) );
+    QVERIFY( records.last().result != 0 );
+    QCOMPARE( records.last().senseKey, quint8( 0x05 ) );
+    QCOMPARE( records.last().asc, quint8( 0x24 ) );
+
+    QVERIFY( trace->toString().contains( "READ DISC INFORMATION" ) );
+
+    QBuffer buffer;
+    QVERIFY( buffer.open( QIODevice::ReadWrite ) );
+    QVERIFY( trace->save( &buffer ) );
+    buffer.seek( 0 );
+    QList<K3b::Device::CommandTrace::Record> loaded;
+    QVERIFY( K3b::Device::CommandTrace::load( &buffer, loaded ) );
+    QCOMPARE( loaded.count(), records.count() );
+    for( int i = 0; i < loaded.count(); ++i ) {
+        QCOMPARE( loaded[i].timestamp, records[i].timestamp );
+        QCOMPARE( loaded[i].duration, records[i].duration );
+        QCOMPARE( loaded[i].opcode, records[i].opcode );
+        QCOMPARE( loaded[i].asc, records[i].asc );
+    }
+
+    // only the commands after the snapshot
+    const K3b::Device::CommandTrace::Snapshot snapshot = trace->snapshot();
+    QVERIFY( m_device->readTrackInformation( data, 1, 1 ) );
+    QCOMPARE( trace->commands( snapshot ), quint64( 1 ) );
+    QCOMPARE( trace->opcodes( snapshot ), QList<unsigned char>() << K3b::Device::MMC_READ_TRACK_INFORMATION );
+    QCOMPARE( trace->statistics( K3b::Device::MMC_READ_DISC_INFORMATION, snapshot ).count, quint64( 0 ) );
+    QCOMPARE( trace->records( snapshot ).count(), 1 );
+    QCOMPARE( trace->records( snapshot ).first().opcode, quint8( K3b::Device::MMC_READ_TRACK_INFORMATION ) );
+    QCOMPARE( trace->records().count(), records.count() + 1 );
+
+    trace->reset();
+    QCOMPARE( trace->commands(), quint64( 0 ) );
+    QVERIFY( trace->records().isEmpty() );
+}
+
+void DeviceQueryTest::testTransientFailure()
+{
+    // a busy drive fails the query right away and does not make the device
+    // fall back to two-step queries
+    m_drive.setBusyCommands( 1 );
+
+    K3b::Device::UByteArray data;
+    QVERIFY( !m_device->readDiscInformation( data ) );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->readDiscInformation( data ) );
+    QCOMPARE( int( data.size() ), 34 );
+    QCOMPARE( m_drive.commands(), 1 );
+}
+
+void DeviceQueryTest::testFailingProbe()
+{
+    K3b::Device::UByteArray data;
+
+    // a drive which is not ready is no reason to try the two-step query
+    m_drive.setBusyCommands( 1 );
+    QVERIFY( !m_device->readTrackInformation( data, 1, 1 ) );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    // an unsupported page is rejected as an invalid field, the header request
+    // fails as well and the command does not switch to two-step queries
+    m_drive.resetCounters();
+    QVERIFY( !m_device->modeSense( data, 0x0E ) );
+    QCOMPARE( m_drive.commands(), 2 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->modeSense( data, 0x2A ) );
+    QCOMPARE( m_drive.commands(), 1 );
+}
+
+void DeviceQueryTest::testTwoStepFallback()
+{
+    // needs to be the last test since the commands keep using two-step queries
+    m_drive.setRejectOversizedAllocations( true );
+
+    // the single-step attempt, then the header and the real length
+    K3b::Device::UByteArray data;
+    QVERIFY( m_device->readDiscInformation( data ) );
+    QCOMPARE( int( data.size() ), 34 );
+    QCOMPARE( m_drive.commands(), 3 );
+
+    m_drive.resetCounters();
+    QVERIFY( m_device->readDiscInformation( data ) );
+    QCOMPARE( int( data.size() ), 34 );
+    QCOMPARE( m_drive.commands(), 2 );
+
+    // the fallback is kept per command
+    m_drive.resetCounters();
+    m_drive.setRejectOversizedAllocations( false );
+    QVERIFY( m_device->readTrackInformation( data, 1, 1 ) );
+    QCOMPARE( int( data.size() ), 36 );
+    QCOMPARE( m_drive.commands(), 1 );
+
+    // and per mode page
+    m_drive.resetCounters();
+    m_drive.setRejectOversizedAllocations( true );
+    QVERIFY( m_device->modeSense( data, 0x2A ) );
+    QCOMPARE( m_drive.commands(), 3 );
+
+    m_drive.resetCounters();
+    m_drive.setRejectOversizedAllocations( false );
+    QVERIFY( m_device->modeSense( data, 0x05 ) );
+    QCOMPARE( m_drive.commands(), 1 );
+}
+
+#include "moc_k3bdevicequerytest.cpp"
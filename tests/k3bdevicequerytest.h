@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_DEVICE_QUERY_TEST_H
+#define K3B_DEVICE_QUERY_TEST_H
+
+#include "k3bemulateddrive.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+namespace K3b {
+    namespace Device {
+        class Device;
+    }
+}
+
+class DeviceQueryTest : public QObject
+{
+    Q_OBJECT
+public:
+    DeviceQueryTest();
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void testWritingModes();
+    void testSingleRoundTrip();
+    void testTruncatedReply();
+    void testHandleReference();
+    void testHandleOwners();
+    void testCommandTrace();
+    void testTransientFailure();
+    void testFailingProbe();
+    void testTwoStepFallback();
+
+private:
+    QTemporaryDir m_dir;
+    TestUtils::EmulatedDrive m_drive;
+    TestUtils::EmulatedDeviceManager* m_manager;
+    K3b::Device::Device* m_device;
+};
+
+#endif // K3B_DEVICE_QUERY_TEST_H
@@ -0,0 +1,1035 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bemulateddrive.h"
+#include "k3btrack.h"
+
+#include <Solid/Device>
+
+#include <QDebug>
+#include <QDir>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <string.h>
+#include <unistd.h>
+
+
+namespace {
+    TestUtils::EmulatedDrive* s_drive = 0;
+
+    const char s_udi[] = "/org/kde/solid/fakehw/k3b_emulated_drive";
+
+    const int s_audioSectorSize = 2352;
+    const int s_dataSectorSize = 2048;
+
+    // the DVD data area starts at physical sector 30000h
+    const unsigned long s_dvdStartSector = 0x30000;
+
+    // a single layer DVD+R
+    const unsigned long s_dvdPlusRCapacity = 2295104;
+
+    const long long s_bufferSize = 4*1024*1024;
+
+    // the disc status field of READ DISC INFORMATION
+    enum DiscStatus {
+        DISC_EMPTY = 0,
+        DISC_INCOMPLETE = 1,
+        DISC_COMPLETE = 2
+    };
+
+    enum SenseKey {
+        NOT_READY = 0x02,
+        MEDIUM_ERROR = 0x03,
+        ILLEGAL_REQUEST = 0x05
+    };
+
+    enum AdditionalSenseCode {
+        LOGICAL_UNIT_NOT_READY = 0x04,
+        WRITE_ERROR = 0x0C,
+        UNRECOVERED_READ_ERROR = 0x11,
+        INVALID_COMMAND_OPERATION_CODE = 0x20,
+        LBA_OUT_OF_RANGE = 0x21,
+        INVALID_FIELD_IN_CDB = 0x24,
+        INVALID_FIELD_IN_PARAMETER_LIST = 0x26,
+        MEDIUM_NOT_PRESENT = 0x3A,
+        ILLEGAL_MODE_FOR_THIS_TRACK = 0x64
+    };
+
+    //
+    // The writing mode selected by the write type and the data block type of
+    // the write parameters mode page
+    //
+    K3b::Device::WritingModes writingMode( int writeType, int dataBlockType )
+    {
+        switch( writeType ) {
+        case 0x1: // track at once
+            if( dataBlockType == 8 )
+                return K3b::Device::WRITINGMODE_TAO;
+            break;
+        case 0x2: // session at once
+            switch( dataBlockType ) {
+            case 8: return K3b::Device::WRITINGMODE_SAO;
+            case 2: return K3b::Device::WRITINGMODE_SAO_R96P;
+            case 3: return K3b::Device::WRITINGMODE_SAO_R96R;
+            }
+            break;
+        case 0x3: // raw
+            switch( dataBlockType ) {
+            case 1: return K3b::Device::WRITINGMODE_RAW_R16;
+            case 2: return K3b::Device::WRITINGMODE_RAW_R96P;
+            case 3: return K3b::Device::WRITINGMODE_RAW_R96R;
+            }
+            break;
+        }
+        return K3b::Device::WritingModes();
+    }
+
+    int fail( unsigned char* sense, unsigned char key, unsigned char asc, unsigned char ascq = 0 )
+    {
+        sense[0] = 0x70;
+        sense[2] = key;
+        sense[7] = 10;
+        sense[12] = asc;
+        sense[13] = ascq;
+        return 1;
+    }
+
+    void setLength( QByteArray& reply, int pos, int size )
+    {
+        const int len = reply.size() - pos - size;
+        for( int i = 0; i < size; ++i )
+            reply[pos+i] = char( len >> ( 8*( size-i-1 ) ) );
+    }
+
+    void set32( QByteArray& reply, int pos, quint32 value )
+    {
+        reply[pos]   = char( value >> 24 );
+        reply[pos+1] = char( value >> 16 );
+        reply[pos+2] = char( value >> 8 );
+        reply[pos+3] = char( value );
+    }
+
+    unsigned char toBcd( int i )
+    {
+        return ( i/10 ) << 4 | ( i%10 );
+    }
+
+    void lbaToMsf( unsigned long lba, unsigned char* msf, bool bcd )
+    {
+        const unsigned long abs = lba + 150;
+        const int m = abs / 75 / 60;
+        const int s = abs / 75 % 60;
+        const int f = abs % 75;
+        msf[0] = bcd ? toBcd( m ) : m;
+        msf[1] = bcd ? toBcd( s ) : s;
+        msf[2] = bcd ? toBcd( f ) : f;
+    }
+
+    // CRC-16/CCITT as used for the Q subchannel
+    quint16 crc16( const unsigned char* data, int len )
+    {
+        quint16 crc = 0;
+        while( len-- ) {
+            crc ^= quint16( *data++ ) << 8;
+            for( int i = 0; i < 8; ++i )
+                crc = ( crc & 0x8000 ) ? ( crc << 1 ) ^ 0x1021 : crc << 1;
+        }
+        return crc;
+    }
+
+    unsigned char control( const K3b::Device::Track& track )
+    {
+        return track.type() == K3b::Device::Track::TYPE_DATA ? 0x4 : 0x0;
+    }
+
+    int sectorSize( const K3b::Device::Track& track )
+    {
+        return track.type() == K3b::Device::Track::TYPE_AUDIO ? s_audioSectorSize : s_dataSectorSize;
+    }
+}
+
+
+TestUtils::EmulatedDrive::EmulatedDrive()
+    : m_medium( CD_ROM ),
+      m_latency( 0 ),
+      m_transferRate( 0 ),
+      m_maxTransferLength( 0 ),
+      m_maxSubchannelSectors( 0 ),
+      m_rejectOversizedAllocations( false ),
+      m_loaded( false ),
+      m_discStatus( DISC_COMPLETE ),
+      m_closedSessions( 0 ),
+      m_nextWritable( 0 ),
+      m_busyCommands( 0 ),
+      m_busyWrites( 0 ),
+      m_commands( 0 ),
+      m_opens( 0 ),
+      m_bytesTransferred( 0 )
+{
+}
+
+
+TestUtils::EmulatedDrive::~EmulatedDrive()
+{
+    uninstall();
+}
+
+
+bool TestUtils::EmulatedDrive::setImage( const QString& image, Medium medium, const K3b::Device::Toc& toc )
+{
+    // the media cache might poll the drive in the meantime
+    QMutexLocker locker( &m_mutex );
+
+    m_loaded = true;
+    m_discStatus = DISC_COMPLETE;
+    m_image.close();
+    m_image.setFileName( image );
+    if( !m_image.open( QIODevice::ReadOnly ) ) {
+        qDebug() << "(TestUtils::EmulatedDrive) could not open" << image;
+        return false;
+    }
+
+    m_medium = medium;
+    m_toc = toc;
+    if( m_toc.isEmpty() ) {
+        K3b::Device::Track track( 0,
+                                  m_image.size() / s_dataSectorSize - 1,
+                                  K3b::Device::Track::TYPE_DATA,
+                                  medium == DVD_ROM ? K3b::Device::Track::DVD : K3b::Device::Track::MODE1 );
+        track.setSession( 1 );
+        m_toc.append( track );
+    }
+
+    const qint64 size = imageOffset( m_toc.last().lastSector().lba() + 1 );
+    if( m_image.size() < size ) {
+        qDebug() << "(TestUtils::EmulatedDrive)" << image << "is too small for the toc:" << m_image.size() << "<" << size;
+        return false;
+    }
+
+    return true;
+}
+
+
+bool TestUtils::EmulatedDrive::insertBlankMedium( const QString& image )
+{
+    QMutexLocker locker( &m_mutex );
+
+    m_loaded = true;
+    m_medium = DVD_PLUS_R;
+    m_toc = K3b::Device::Toc();
+    m_discStatus = DISC_EMPTY;
+    m_closedSessions = 0;
+    m_nextWritable = 0;
+
+    m_image.close();
+    m_image.setFileName( image );
+    if( !m_image.open( QIODevice::ReadWrite|QIODevice::Truncate ) ) {
+        qDebug() << "(TestUtils::EmulatedDrive) could not create" << image;
+        return false;
+    }
+
+    return true;
+}
+
+
+void TestUtils::EmulatedDrive::resetCounters()
+{
+    QMutexLocker locker( &m_mutex );
+    m_commands = 0;
+    m_opens = 0;
+    m_opcodeCommands.clear();
+    m_bytesTransferred = 0;
+}
+
+
+void TestUtils::EmulatedDrive::setBusyCommands( int count )
+{
+    QMutexLocker locker( &m_mutex );
+    m_busyCommands = count;
+}
+
+
+void TestUtils::EmulatedDrive::setBusyWrites( int count )
+{
+    QMutexLocker locker( &m_mutex );
+    m_busyWrites = count;
+}
+
+
+bool TestUtils::EmulatedDrive::mediumLoaded() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_loaded;
+}
+
+
+int TestUtils::EmulatedDrive::commands() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_commands;
+}
+
+
+int TestUtils::EmulatedDrive::commands( unsigned char opcode ) const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_opcodeCommands.value( opcode );
+}
+
+
+qint64 TestUtils::EmulatedDrive::bytesTransferred() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_bytesTransferred;
+}
+
+
+int TestUtils::EmulatedDrive::opens() const
+{
+    QMutexLocker locker( &m_mutex );
+    return m_opens;
+}
+
+
+void TestUtils::EmulatedDrive::install()
+{
+    s_drive = this;
+    K3b::Device::setTransportHook( transport );
+}
+
+
+void TestUtils::EmulatedDrive::uninstall()
+{
+    if( s_drive == this ) {
+        K3b::Device::setTransportHook( 0 );
+        s_drive = 0;
+    }
+}
+
+
+int TestUtils::EmulatedDrive::transport( const K3b::Device::Device* dev,
+                                         const unsigned char* cdb,
+                                         K3b::Device::TransportDirection dir,
+                                         unsigned char* data,
+                                         size_t len,
+                                         unsigned char* sense )
+{
+    EmulatedDrive* drive = s_drive;
+    if( !drive )
+        return -1;
+
+    QByteArray reply;
+    int ret = 0;
+    {
+        QMutexLocker locker( &drive->m_mutex );
+        ++drive->m_commands;
+        ++drive->m_opcodeCommands[cdb[0]];
+
+        // the position of a freshly opened handle is 0
+        if( ::lseek( dev->handle(), 1, SEEK_CUR ) == 1 )
+            ++drive->m_opens;
+
+        // the host adapter rejects the command before it reaches the drive
+        if( drive->m_maxTransferLength > 0 && len > size_t( drive->m_maxTransferLength ) )
+            return -1;
+
+        if( drive->m_busyCommands > 0 ) {
+            --drive->m_busyCommands;
+            return fail( sense, NOT_READY, LOGICAL_UNIT_NOT_READY );
+        }
+
+        if( dir == K3b::Device::TR_DIR_WRITE )
+            ret = drive->execute( cdb, data, len, reply, sense );
+        else
+            ret = drive->execute( cdb, 0, 0, reply, sense );
+
+        if( ret == 0 && dir == K3b::Device::TR_DIR_READ &&
+            drive->m_rejectOversizedAllocations && len > size_t( reply.size() ) )
+            return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+
+        if( ret == 0 && dir == K3b::Device::TR_DIR_READ ) {
+            const size_t replyLen = qMin( len, size_t( reply.size() ) );
+            ::memcpy( data, reply.constData(), replyLen );
+            drive->m_bytesTransferred += replyLen;
+        }
+    }
+
+    unsigned long usecs = drive->m_latency;
+    if( drive->m_transferRate > 0 )
+        usecs += qint64( reply.size() ) * 1000 / drive->m_transferRate;
+    if( usecs > 0 )
+        QThread::usleep( usecs );
+
+    return ret;
+}
+
+
+int TestUtils::EmulatedDrive::execute( const unsigned char* cdb, const unsigned char* parameters, size_t len,
+                                       QByteArray& reply, unsigned char* sense )
+{
+    switch( cdb[0] ) {
+    case K3b::Device::MMC_TEST_UNIT_READY:
+        return m_loaded ? 0 : fail( sense, NOT_READY, MEDIUM_NOT_PRESENT );
+
+    case K3b::Device::MMC_PREVENT_ALLOW_MEDIUM_REMOVAL:
+        return 0;
+
+    case K3b::Device::MMC_START_STOP_UNIT:
+        // with LoEj set the start bit loads the medium, otherwise it is ejected
+        if( cdb[4] & 0x2 )
+            m_loaded = ( cdb[4] & 0x1 );
+        return 0;
+
+    case K3b::Device::MMC_INQUIRY:
+        return inquiry( reply );
+
+    case K3b::Device::MMC_GET_CONFIGURATION:
+        return getConfiguration( cdb, reply );
+
+    case K3b::Device::MMC_READ_DISC_INFORMATION:
+        return readDiscInformation( reply );
+
+    case K3b::Device::MMC_READ_TRACK_INFORMATION:
+        return readTrackInformation( cdb, reply, sense );
+
+    case K3b::Device::MMC_READ_TOC_PMA_ATIP:
+        return readToc( cdb, reply, sense );
+
+    case K3b::Device::MMC_READ_CAPACITY:
+        return readCapacity( reply );
+
+    case K3b::Device::MMC_READ_DVD_STRUCTURE:
+        return readDvdStructure( cdb, reply, sense );
+
+    case K3b::Device::MMC_MODE_SENSE:
+        return modeSense( cdb, reply, sense );
+
+    case K3b::Device::MMC_MODE_SELECT:
+        return modeSelect( parameters, len, sense );
+
+    case K3b::Device::MMC_READ_10:
+        return read( cdb[2]<<24 | cdb[3]<<16 | cdb[4]<<8 | cdb[5],
+                     cdb[7]<<8 | cdb[8],
+                     reply, sense );
+
+    case K3b::Device::MMC_READ_12:
+        return read( cdb[2]<<24 | cdb[3]<<16 | cdb[4]<<8 | cdb[5],
+                     cdb[6]<<24 | cdb[7]<<16 | cdb[8]<<8 | cdb[9],
+                     reply, sense );
+
+    case K3b::Device::MMC_READ_CD:
+        return readCd( cdb, reply, sense );
+
+    case K3b::Device::MMC_WRITE_10:
+        return write( cdb, parameters, len, sense );
+
+    case K3b::Device::MMC_SYNCHRONIZE_CACHE:
+        // the data is written right away
+        return writable() ? 0 : fail( sense, ILLEGAL_REQUEST, INVALID_COMMAND_OPERATION_CODE );
+
+    case K3b::Device::MMC_CLOSE_TRACK_SESSION:
+        return closeTrackSession( cdb, sense );
+
+    case K3b::Device::MMC_READ_BUFFER_CAPACITY:
+        return readBufferCapacity( reply );
+
+    default:
+        return fail( sense, ILLEGAL_REQUEST, INVALID_COMMAND_OPERATION_CODE );
+    }
+}
+
+
+int TestUtils::EmulatedDrive::inquiry( QByteArray& reply )
+{
+    reply = QByteArray( 36, 0 );
+    reply[0] = 0x05; // MMC device
+    reply[4] = 31;
+    reply.replace( 8, 28, "K3B     EMULATED DRIVE  1.00" );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::getConfiguration( const unsigned char* cdb, QByteArray& reply )
+{
+    const char profiles[] = { 0x08, 0x10, 0x1B };
+    const char profile = profiles[m_medium];
+
+    reply = QByteArray( 8, 0 );
+    reply[7] = profile;
+
+    // the profile list is the only feature the drive reports
+    const int startingFeature = cdb[2]<<8 | cdb[3];
+    if( startingFeature == 0 && ( cdb[1] & 0x3 ) != 1 ) {
+        QByteArray feature( 4, 0 );
+        feature[2] = 0x03;
+        for( int i = int( sizeof( profiles ) ) - 1; i >= 0; --i ) {
+            QByteArray descriptor( 4, 0 );
+            descriptor[1] = profiles[i];
+            descriptor[2] = ( profiles[i] == profile ? 0x01 : 0x00 );
+            feature.append( descriptor );
+        }
+        feature[3] = feature.size() - 4;
+        reply.append( feature );
+    }
+
+    setLength( reply, 0, 4 );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readDiscInformation( QByteArray& reply )
+{
+    reply = QByteArray( 34, 0 );
+    reply[3] = 1;
+    if( m_discStatus == DISC_COMPLETE ) {
+        reply[2] = 0x0E; // complete disc, complete last session
+        reply[4] = qMax( 1, m_closedSessions );
+        reply[5] = 1;
+        reply[6] = m_toc.count();
+    }
+    else {
+        // the last session is the empty one containing the invisible track
+        reply[2] = m_discStatus;
+        reply[4] = m_closedSessions + 1;
+        reply[5] = m_toc.count() + 1;
+        reply[6] = m_toc.count() + 1;
+    }
+    reply.replace( 17, 3, "\xff\xff\xff" );
+    reply.replace( 21, 3, "\xff\xff\xff" );
+    setLength( reply, 0, 2 );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readTrackInformation( const unsigned char* cdb, QByteArray& reply, unsigned char* sense )
+{
+    const unsigned long value = cdb[2]<<24 | cdb[3]<<16 | cdb[4]<<8 | cdb[5];
+
+    int track = -1;
+    switch( cdb[1] & 0x3 ) {
+    case 0: // LBA
+        track = trackIndex( value );
+        break;
+    case 1: // track number
+        if( value >= 1 && value <= unsigned( m_toc.count() ) )
+            track = value - 1;
+        break;
+    }
+
+    if( track < 0 && writable() &&
+        ( cdb[1] & 0x3 ) == 1 && ( value == unsigned( m_toc.count() + 1 ) || value == 0xFF ) ) {
+        // the invisible track
+        reply = QByteArray( 36, 0 );
+        reply[2] = m_toc.count() + 1;
+        reply[3] = m_closedSessions + 1;
+        reply[6] = 0x40 | 0x1; // blank, data recorded incrementally
+        reply[7] = 0x1;        // next writable address valid
+        set32( reply, 8, trackStart() );
+        set32( reply, 12, m_nextWritable );
+        set32( reply, 16, s_dvdPlusRCapacity - m_nextWritable );
+        set32( reply, 24, s_dvdPlusRCapacity - trackStart() );
+        setLength( reply, 0, 2 );
+        return 0;
+    }
+
+    if( track < 0 )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+
+    const K3b::Device::Track& t = m_toc[track];
+    reply = QByteArray( 36, 0 );
+    reply[2] = track + 1;
+    reply[3] = 1;
+    reply[5] = control( t );
+    reply[6] = ( t.type() == K3b::Device::Track::TYPE_DATA ? 0x1 : 0xF );
+    set32( reply, 8, t.firstSector().lba() );
+    set32( reply, 24, t.length().lba() );
+    set32( reply, 28, t.lastSector().lba() );
+    setLength( reply, 0, 2 );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readToc( const unsigned char* cdb, QByteArray& reply, unsigned char* sense )
+{
+    if( m_toc.isEmpty() )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+
+    const bool msf = cdb[1] & 0x2;
+    const unsigned long leadOut = m_toc.last().lastSector().lba() + 1;
+
+    switch( cdb[2] & 0xF ) {
+    case 0x0: {
+        reply = QByteArray( 4, 0 );
+        reply[2] = 1;
+        reply[3] = m_toc.count();
+        for( int i = 0; i <= m_toc.count(); ++i ) {
+            const bool isLeadOut = ( i == m_toc.count() );
+            if( !isLeadOut && i + 1 < cdb[6] )
+                continue;
+            QByteArray desc( 8, 0 );
+            desc[1] = 0x10 | control( m_toc[isLeadOut ? i-1 : i] );
+            desc[2] = isLeadOut ? char( 0xAA ) : char( i + 1 );
+            const unsigned long lba = isLeadOut ? leadOut : m_toc[i].firstSector().lba();
+            if( msf )
+                lbaToMsf( lba, reinterpret_cast<unsigned char*>( desc.data() ) + 5, false );
+            else
+                set32( desc, 4, lba );
+            reply.append( desc );
+        }
+        break;
+    }
+
+    case 0x1: {
+        reply = QByteArray( 4 + 8, 0 );
+        reply[2] = 1;
+        reply[3] = 1;
+        reply[5] = 0x10 | control( m_toc.first() );
+        reply[6] = 1;
+        break;
+    }
+
+    case 0x2: {
+        reply = QByteArray( 4, 0 );
+        reply[2] = 1;
+        reply[3] = 1;
+        for( int i = -3; i < m_toc.count(); ++i ) {
+            QByteArray desc( 11, 0 );
+            unsigned char* d = reinterpret_cast<unsigned char*>( desc.data() );
+            d[0] = 1;
+            d[1] = 0x10 | control( m_toc[qMax( 0, i )] );
+            if( i == -3 ) {
+                d[3] = 0xA0;
+                d[8] = 1;
+                d[9] = 0x00; // CD-DA or CD-ROM
+            }
+            else if( i == -2 ) {
+                d[1] = 0x10 | control( m_toc.last() );
+                d[3] = 0xA1;
+                d[8] = m_toc.count();
+            }
+            else if( i == -1 ) {
+                d[1] = 0x10 | control( m_toc.last() );
+                d[3] = 0xA2;
+                lbaToMsf( leadOut, d + 8, false );
+            }
+            else {
+                d[3] = i + 1;
+                lbaToMsf( m_toc[i].firstSector().lba(), d + 8, false );
+            }
+            reply.append( desc );
+        }
+        break;
+    }
+
+    case 0x5:
+        if( m_medium != CD_ROM )
+            return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+        reply = QByteArray( 4, 0 );
+        reply.append( m_cdText );
+        break;
+
+    default:
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+    }
+
+    setLength( reply, 0, 2 );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readCapacity( QByteArray& reply )
+{
+    reply = QByteArray( 8, 0 );
+    if( m_toc.isEmpty() )
+        return 0;
+    set32( reply, 0, m_toc.last().lastSector().lba() );
+    set32( reply, 4, s_dataSectorSize );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readDvdStructure( const unsigned char* cdb, QByteArray& reply, unsigned char* sense )
+{
+    if( m_medium != DVD_ROM )
+        return fail( sense, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK );
+
+    switch( cdb[7] ) {
+    case 0x0: // physical format information
+        reply = QByteArray( 4 + 2048, 0 );
+        reply[4] = 0x01; // DVD-ROM, version 1
+        reply[4+2] = 0x01; // one layer, embossed
+        set32( reply, 4+4, s_dvdStartSector );
+        set32( reply, 4+8, s_dvdStartSector + m_toc.last().lastSector().lba() );
+        break;
+
+    case 0x1: // copyright information
+        reply = QByteArray( 4 + 4, 0 );
+        break;
+
+    default:
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+    }
+
+    setLength( reply, 0, 2 );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::read( unsigned long lba, unsigned long sectors, QByteArray& reply, unsigned char* sense )
+{
+    reply = QByteArray( sectors*s_dataSectorSize, 0 );
+    for( unsigned long i = 0; i < sectors; ++i ) {
+        const int track = trackIndex( lba + i );
+        if( track < 0 )
+            return fail( sense, ILLEGAL_REQUEST, LBA_OUT_OF_RANGE );
+        if( m_toc[track].type() != K3b::Device::Track::TYPE_DATA )
+            return fail( sense, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK );
+        if( !readSector( lba + i, reply.data() + i*s_dataSectorSize, s_dataSectorSize ) )
+            return fail( sense, MEDIUM_ERROR, UNRECOVERED_READ_ERROR );
+    }
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readCd( const unsigned char* cdb, QByteArray& reply, unsigned char* sense )
+{
+    if( m_medium != CD_ROM )
+        return fail( sense, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK );
+
+    const int sectorType = cdb[1]>>2 & 0x7;
+    const unsigned long lba = cdb[2]<<24 | cdb[3]<<16 | cdb[4]<<8 | cdb[5];
+    const unsigned long sectors = cdb[6]<<16 | cdb[7]<<8 | cdb[8];
+    const bool sync = cdb[9] & 0x80;
+    const bool header = cdb[9] & 0x20;
+    const bool userData = cdb[9] & 0x10;
+    const bool edcEcc = cdb[9] & 0x08;
+    const int c2 = cdb[9]>>1 & 0x3;
+    const int subChannel = cdb[10] & 0x7;
+
+    // only the Q subchannel is emulated
+    if( subChannel != 0 && subChannel != 2 )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+    if( subChannel == 2 && m_maxSubchannelSectors > 0 && sectors > unsigned( m_maxSubchannelSectors ) )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+
+    for( unsigned long i = 0; i < sectors; ++i ) {
+        const int track = trackIndex( lba + i );
+        if( track < 0 )
+            return fail( sense, ILLEGAL_REQUEST, LBA_OUT_OF_RANGE );
+
+        const bool audio = ( m_toc[track].type() == K3b::Device::Track::TYPE_AUDIO );
+        if( ( sectorType == 1 && !audio ) || ( sectorType > 1 && audio ) || sectorType > 2 )
+            return fail( sense, ILLEGAL_REQUEST, ILLEGAL_MODE_FOR_THIS_TRACK );
+
+        if( audio ) {
+            if( sync || header || userData || edcEcc ) {
+                QByteArray sector( s_audioSectorSize, 0 );
+                if( !readSector( lba + i, sector.data(), sector.size() ) )
+                    return fail( sense, MEDIUM_ERROR, UNRECOVERED_READ_ERROR );
+                reply.append( sector );
+            }
+        }
+        else {
+            QByteArray sector( s_dataSectorSize, 0 );
+            if( ( sync || header || userData || edcEcc ) &&
+                !readSector( lba + i, sector.data(), sector.size() ) )
+                return fail( sense, MEDIUM_ERROR, UNRECOVERED_READ_ERROR );
+            if( sync )
+                reply.append( "\x00\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x00", 12 );
+            if( header ) {
+                unsigned char h[4];
+                lbaToMsf( lba + i, h, true );
+                h[3] = 1;
+                reply.append( reinterpret_cast<const char*>( h ), 4 );
+            }
+            if( userData )
+                reply.append( sector );
+            if( edcEcc )
+                reply.append( QByteArray( 288, 0 ) );
+        }
+
+        if( c2 )
+            reply.append( QByteArray( c2 == 2 ? 296 : 294, 0 ) );
+
+        if( subChannel == 2 ) {
+            unsigned char q[16];
+            qSubchannel( lba + i, q );
+            reply.append( reinterpret_cast<const char*>( q ), 16 );
+        }
+    }
+
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::modeSense( const unsigned char* cdb, QByteArray& reply, unsigned char* sense )
+{
+    switch( cdb[2] & 0x3F ) {
+    case 0x05: // write parameters
+        if( !m_writingModes )
+            return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+        if( m_writeParameters.isEmpty() ) {
+            m_writeParameters = QByteArray( 2 + 0x32, 0 );
+            m_writeParameters[0] = 0x05;
+            m_writeParameters[1] = 0x32;
+            m_writeParameters[2] = 0x01; // track at once
+            m_writeParameters[3] = 0x04;
+            m_writeParameters[4] = 0x08; // mode 1
+        }
+        reply = QByteArray( 8, 0 );
+        reply.append( m_writeParameters );
+        break;
+
+    case 0x2A: // capabilities
+        reply = QByteArray( 8 + 28, 0 );
+        reply[8] = 0x2A;
+        reply[9] = 26;
+        break;
+
+    default:
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+    }
+
+    setLength( reply, 0, 2 );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::modeSelect( const unsigned char* parameters, size_t len, unsigned char* sense )
+{
+    // the mode parameter header is followed by exactly one page
+    if( len < 8 + 2 || !parameters )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST );
+
+    const unsigned char* page = parameters + 8;
+    if( ( page[0] & 0x3F ) != 0x05 || !m_writingModes )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST );
+    if( len < size_t( 8 + 2 + page[1] ) || page[1] < 3 )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST );
+
+    const K3b::Device::WritingModes mode = writingMode( page[2] & 0x0F, page[4] & 0x0F );
+    if( !( m_writingModes & mode ) )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_PARAMETER_LIST );
+
+    m_writeParameters = QByteArray( reinterpret_cast<const char*>( page ), 2 + page[1] );
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::write( const unsigned char* cdb, const unsigned char* data, size_t len, unsigned char* sense )
+{
+    if( !writable() )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_COMMAND_OPERATION_CODE );
+
+    if( m_busyWrites > 0 ) {
+        --m_busyWrites;
+        return fail( sense, NOT_READY, LOGICAL_UNIT_NOT_READY, 0x08 ); // LONG WRITE IN PROGRESS
+    }
+
+    const unsigned long lba = cdb[2]<<24 | cdb[3]<<16 | cdb[4]<<8 | cdb[5];
+    const unsigned long sectors = cdb[7]<<8 | cdb[8];
+
+    // DVD+R is written sequentially
+    if( lba != m_nextWritable || lba + sectors > s_dvdPlusRCapacity )
+        return fail( sense, ILLEGAL_REQUEST, LBA_OUT_OF_RANGE, 0x02 ); // INVALID ADDRESS FOR WRITE
+    if( !data || len != sectors*s_dataSectorSize )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+
+    if( !m_image.seek( qint64( lba )*s_dataSectorSize ) ||
+        m_image.write( reinterpret_cast<const char*>( data ), len ) != qint64( len ) )
+        return fail( sense, MEDIUM_ERROR, WRITE_ERROR );
+
+    m_nextWritable += sectors;
+    m_discStatus = DISC_INCOMPLETE;
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::closeTrackSession( const unsigned char* cdb, unsigned char* sense )
+{
+    if( !writable() )
+        return fail( sense, ILLEGAL_REQUEST, INVALID_COMMAND_OPERATION_CODE );
+
+    switch( cdb[2] & 0x7 ) {
+    case 0x1: // close track
+        if( m_nextWritable > trackStart() ) {
+            K3b::Device::Track track( trackStart(), m_nextWritable - 1,
+                                      K3b::Device::Track::TYPE_DATA, K3b::Device::Track::DVD );
+            track.setSession( m_closedSessions + 1 );
+            m_toc.append( track );
+        }
+        break;
+
+    case 0x2: // close session
+        if( m_nextWritable > 0 ) {
+            ++m_closedSessions;
+            m_discStatus = DISC_INCOMPLETE;
+        }
+        break;
+
+    case 0x6: // finalize
+        if( m_nextWritable > 0 ) {
+            ++m_closedSessions;
+            m_discStatus = DISC_COMPLETE;
+        }
+        break;
+
+    default:
+        return fail( sense, ILLEGAL_REQUEST, INVALID_FIELD_IN_CDB );
+    }
+
+    m_image.flush();
+    return 0;
+}
+
+
+int TestUtils::EmulatedDrive::readBufferCapacity( QByteArray& reply )
+{
+    // the data is written right away, the buffer is always empty
+    reply = QByteArray( 12, 0 );
+    set32( reply, 4, s_bufferSize );
+    set32( reply, 8, s_bufferSize );
+    setLength( reply, 0, 2 );
+    return 0;
+}
+
+
+bool TestUtils::EmulatedDrive::writable() const
+{
+    return m_medium == DVD_PLUS_R && m_discStatus != DISC_COMPLETE;
+}
+
+
+unsigned long TestUtils::EmulatedDrive::trackStart() const
+{
+    return m_toc.isEmpty() ? 0 : m_toc.last().lastSector().lba() + 1;
+}
+
+
+int TestUtils::EmulatedDrive::trackIndex( unsigned long lba ) const
+{
+    for( int i = 0; i < m_toc.count(); ++i ) {
+        if( lba >= unsigned( m_toc[i].firstSector().lba() ) &&
+            lba <= unsigned( m_toc[i].lastSector().lba() ) )
+            return i;
+    }
+    return -1;
+}
+
+
+qint64 TestUtils::EmulatedDrive::imageOffset( unsigned long lba ) const
+{
+    qint64 offset = 0;
+    Q_FOREACH( const K3b::Device::Track& track, m_toc ) {
+        const unsigned long first = track.firstSector().lba();
+        const unsigned long last = track.lastSector().lba();
+        if( lba <= last )
+            return offset + qint64( lba - first ) * sectorSize( track );
+        offset += qint64( last - first + 1 ) * sectorSize( track );
+    }
+    return offset;
+}
+
+
+bool TestUtils::EmulatedDrive::readSector( unsigned long lba, char* data, int len )
+{
+    if( m_readErrors.contains( lba ) )
+        return false;
+
+    return( m_image.seek( imageOffset( lba ) ) &&
+            m_image.read( data, len ) == len );
+}
+
+
+void TestUtils::EmulatedDrive::qSubchannel( unsigned long lba, unsigned char* q ) const
+{
+    ::memset( q, 0, 16 );
+    if( m_qMissing.contains( lba ) )
+        return;
+
+    int track = trackIndex( lba );
+    const K3b::Device::Track& t = m_toc[track];
+    const unsigned long rel = lba - t.firstSector().lba();
+
+    int index = 1;
+    const QList<K3b::Msf> indices = t.indices();
+    for( int i = 1; i < indices.count(); ++i ) {
+        if( indices[i] > 0 && rel >= unsigned( indices[i].lba() ) )
+            index = i + 1;
+    }
+
+    // the pregap belongs to the next track and counts down to its start
+    unsigned long relTime = rel;
+    if( t.index0() > 0 && rel >= unsigned( t.index0().lba() ) && track + 1 < m_toc.count() ) {
+        index = 0;
+        relTime = t.lastSector().lba() - lba + 1;
+        ++track;
+    }
+
+    if( !m_mcn.isEmpty() && lba % 100 == 50 ) {
+        // 13 digits in BCD and the absolute frame
+        unsigned char msf[3];
+        lbaToMsf( lba, msf, true );
+        q[0] = control( t ) << 4 | 0x2;
+        for( int i = 0; i < 13 && i < m_mcn.size(); ++i )
+            q[1 + i/2] |= ( m_mcn[i] - '0' ) << ( i%2 ? 0 : 4 );
+        q[9] = msf[2];
+    }
+    else {
+        q[0] = control( t ) << 4 | 0x1;
+        q[1] = toBcd( track + 1 );
+        q[2] = toBcd( index );
+        q[3] = toBcd( relTime / 75 / 60 );
+        q[4] = toBcd( relTime / 75 % 60 );
+        q[5] = toBcd( relTime % 75 );
+        lbaToMsf( lba, q + 7, true );
+    }
+
+    // Red Book stores the CRC inverted
+    const quint16 crc = crc16( q, 10 );
+    q[10] = ~( crc >> 8 );
+    q[11] = ~( crc & 0xff );
+    if( m_qErrors.contains( lba ) ) {
+        q[2] ^= 0x55;
+        q[10] = q[11] = 0;
+    }
+}
+
+
+TestUtils::EmulatedDeviceManager::EmulatedDeviceManager( QObject* parent )
+    : K3b::Device::DeviceManager( parent )
+{
+}
+
+
+K3b::Device::Device* TestUtils::EmulatedDeviceManager::addEmulatedDevice( const QString& dir )
+{
+    const QString node = QDir( dir ).filePath( "sr0" );
+    QFile nodeFile( node );
+    if( !nodeFile.open( QIODevice::WriteOnly ) )
+        return 0;
+    nodeFile.close();
+
+    const QString xml = QDir( dir ).filePath( "fakecomputer.xml" );
+    QFile xmlFile( xml );
+    if( !xmlFile.open( QIODevice::WriteOnly ) )
+        return 0;
+    xmlFile.write( QString( "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                            "<machine>\n"
+                            "    <device udi=\"%1\">\n"
+                            "        <property key=\"name\">Emulated Drive</property>\n"
+                            "        <property key=\"interfaces\">Block,StorageDrive,OpticalDrive</property>\n"
+                            "        <property key=\"major\">11</property>\n"
+                            "        <property key=\"minor\">0</property>\n"
+                            "        <property key=\"device\">%2</property>\n"
+                            "    </device>\n"
+                            "</machine>\n" ).arg( s_udi, node ).toUtf8() );
+    xmlFile.close();
+    qputenv( "SOLID_FAKEHW", QFile::encodeName( xml ) );
+
+    return addDevice( Solid::Device( s_udi ) );
+}
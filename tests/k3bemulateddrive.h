@@ -0,0 +1,264 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_EMULATED_DRIVE_H
+#define K3B_EMULATED_DRIVE_H
+
+#include "k3bdevicemanager.h"
+#include "k3bdevicetypes.h"
+#include "k3bscsicommand.h"
+#include "k3btoc.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+
+namespace TestUtils
+{
+    /**
+     * Emulates an MMC drive with a complete medium inserted. The drive is
+     * plugged in as transport hook (K3b::Device::setTransportHook) so every
+     * command sent via ScsiCommand is answered from an image file.
+     *
+     * The image contains the sectors of all tracks one after the other:
+     * 2352 bytes per audio sector and 2048 bytes per data sector. The Q
+     * subchannel is generated from the TOC including index 0 and the
+     * indices set in the tracks.
+     *
+     * Only one drive can be installed at a time. It answers the commands
+     * for all devices.
+     */
+    class EmulatedDrive
+    {
+    public:
+        enum Medium {
+            CD_ROM,
+            DVD_ROM,
+            DVD_PLUS_R
+        };
+
+        EmulatedDrive();
+        ~EmulatedDrive();
+
+        /**
+         * Use @p image with the tracks in @p toc. An empty toc means one
+         * data track covering the whole image.
+         *
+         * This inserts the medium if it has been ejected.
+         */
+        bool setImage( const QString& image, Medium medium, const K3b::Device::Toc& toc = K3b::Device::Toc() );
+
+        /**
+         * Inserts a blank DVD+R. The sectors written with WRITE 10 are stored
+         * in @p image which is created or truncated. Closing a track adds it
+         * to the toc.
+         */
+        bool insertBlankMedium( const QString& image );
+
+        /**
+         * \return false once the medium has been ejected with START STOP UNIT.
+         */
+        bool mediumLoaded() const;
+
+        const K3b::Device::Toc& toc() const { return m_toc; }
+
+        /**
+         * Raw CD-Text packs as returned by READ TOC format 5.
+         */
+        void setCdText( const QByteArray& packs ) { m_cdText = packs; }
+
+        /**
+         * Time spent for every command in microseconds.
+         */
+        void setCommandLatency( int usecs ) { m_latency = usecs; }
+
+        /**
+         * Emulated transfer rate in KB/s. 0 means no limit.
+         */
+        void setTransferRate( int kbPerSec ) { m_transferRate = kbPerSec; }
+
+        /**
+         * Commands transferring more than @p bytes fail like they would
+         * with a host adapter which does not support them. 0 means no limit.
+         */
+        void setMaxTransferLength( int bytes ) { m_maxTransferLength = bytes; }
+
+        /**
+         * Every hundredth sector carries the media catalog number (Mode-2 Q)
+         * instead of the position. An empty @p mcn removes it.
+         */
+        void setMediaCatalogNumber( const QByteArray& mcn ) { m_mcn = mcn; }
+
+        /**
+         * The Q subchannel of @p lba is returned with a damaged index and a
+         * CRC of zero like some drives report it.
+         */
+        void addQSubchannelError( unsigned long lba ) { m_qErrors.insert( lba ); }
+
+        /**
+         * The Q subchannel of @p lba is returned empty (ADR 0) as if the drive
+         * could not read it.
+         */
+        void addMissingQSubchannel( unsigned long lba ) { m_qMissing.insert( lba ); }
+        void clearMissingQSubchannel() { m_qMissing.clear(); }
+
+        /**
+         * Reading the subchannel of more than @p sectors sectors with one
+         * READ CD command fails. 0 means no limit.
+         */
+        void setMaxSubchannelSectors( int sectors ) { m_maxSubchannelSectors = sectors; }
+
+        /**
+         * The CD writing modes accepted in the write parameters mode page.
+         * A drive without writing modes is a reader which does not know
+         * the page at all.
+         */
+        void setWritingModes( K3b::Device::WritingModes modes ) { m_writingModes = modes; }
+
+        /**
+         * Queries with an allocation length exceeding the reply fail like
+         * with some firmwares.
+         */
+        void setRejectOversizedAllocations( bool b ) { m_rejectOversizedAllocations = b; }
+
+        /**
+         * The next @p count commands fail since the drive is not ready.
+         */
+        void setBusyCommands( int count );
+
+        /**
+         * The next @p count WRITE commands fail with LONG WRITE IN PROGRESS
+         * like with a drive busy with its power calibration.
+         */
+        void setBusyWrites( int count );
+
+        /**
+         * Reading @p lba fails with an unrecovered read error.
+         */
+        void addReadError( unsigned long lba ) { m_readErrors.insert( lba ); }
+        void clearReadErrors() { m_readErrors.clear(); }
+
+        void resetCounters();
+
+        /**
+         * \return The number of commands since the last resetCounters()
+         */
+        int commands() const;
+
+        /**
+         * \return The number of commands with opcode @p opcode since the
+         *         last resetCounters()
+         */
+        int commands( unsigned char opcode ) const;
+
+        /**
+         * \return The number of bytes returned to the host since the last
+         *         resetCounters()
+         */
+        qint64 bytesTransferred() const;
+
+        /**
+         * \return The number of device handles commands have been sent through
+         *         since the last resetCounters(). Only works with a plain file
+         *         as device node.
+         */
+        int opens() const;
+
+        /**
+         * Install the drive as transport hook. The destructor removes it.
+         */
+        void install();
+        void uninstall();
+
+    private:
+        static int transport( const K3b::Device::Device* dev,
+                              const unsigned char* cdb,
+                              K3b::Device::TransportDirection dir,
+                              unsigned char* data,
+                              size_t len,
+                              unsigned char* sense );
+
+        int execute( const unsigned char* cdb, const unsigned char* parameters, size_t len,
+                     QByteArray& reply, unsigned char* sense );
+
+        int inquiry( QByteArray& reply );
+        int getConfiguration( const unsigned char* cdb, QByteArray& reply );
+        int readDiscInformation( QByteArray& reply );
+        int readTrackInformation( const unsigned char* cdb, QByteArray& reply, unsigned char* sense );
+        int readToc( const unsigned char* cdb, QByteArray& reply, unsigned char* sense );
+        int readCapacity( QByteArray& reply );
+        int readDvdStructure( const unsigned char* cdb, QByteArray& reply, unsigned char* sense );
+        int read( unsigned long lba, unsigned long sectors, QByteArray& reply, unsigned char* sense );
+        int readCd( const unsigned char* cdb, QByteArray& reply, unsigned char* sense );
+        int modeSense( const unsigned char* cdb, QByteArray& reply, unsigned char* sense );
+        int modeSelect( const unsigned char* parameters, size_t len, unsigned char* sense );
+        int write( const unsigned char* cdb, const unsigned char* data, size_t len, unsigned char* sense );
+        int closeTrackSession( const unsigned char* cdb, unsigned char* sense );
+        int readBufferCapacity( QByteArray& reply );
+
+        bool writable() const;
+        unsigned long trackStart() const;
+
+        int trackIndex( unsigned long lba ) const;
+        qint64 imageOffset( unsigned long lba ) const;
+        bool readSector( unsigned long lba, char* data, int len );
+        void qSubchannel( unsigned long lba, unsigned char* q ) const;
+
+        QFile m_image;
+        Medium m_medium;
+        K3b::Device::Toc m_toc;
+        QByteArray m_cdText;
+        int m_latency;
+        int m_transferRate;
+        int m_maxTransferLength;
+        int m_maxSubchannelSectors;
+        K3b::Device::WritingModes m_writingModes;
+        bool m_rejectOversizedAllocations;
+        bool m_loaded;
+
+        // the recording state of a DVD_PLUS_R
+        int m_discStatus;
+        int m_closedSessions;
+        unsigned long m_nextWritable;
+        QByteArray m_writeParameters;
+        QByteArray m_mcn;
+        QSet<unsigned long> m_readErrors;
+        QSet<unsigned long> m_qErrors;
+        QSet<unsigned long> m_qMissing;
+
+        mutable QMutex m_mutex;
+        int m_busyCommands;
+        int m_busyWrites;
+        int m_commands;
+        int m_opens;
+        QHash<int, int> m_opcodeCommands;
+        qint64 m_bytesTransferred;
+    };
+
+    /**
+     * A device manager for tests which adds a drive answered by the
+     * installed EmulatedDrive.
+     */
+    class EmulatedDeviceManager : public K3b::Device::DeviceManager
+    {
+    public:
+        explicit EmulatedDeviceManager( QObject* parent = 0 );
+
+        /**
+         * Describes one optical drive in a Solid fake hardware file in @p dir
+         * and adds it. A plain file in @p dir serves as device node.
+         *
+         * Needs to be called before Solid is used for the first time since
+         * Solid reads the fake hardware only once.
+         */
+        K3b::Device::Device* addEmulatedDevice( const QString& dir );
+    };
+}
+
+#endif // K3B_EMULATED_DRIVE_H
@@ -0,0 +1,594 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+//
+// Measures the number of commands and the throughput of the device layer and
+// the reading jobs against an emulated drive. Every benchmark prints one line
+// per operation:
+//
+//   <operation>: <commands> commands (<read commands> reads), <KiB> KiB in <ms> ms (<MiB/s> MiB/s)
+//
+// The emulated drive answers without delay unless a row sets a command latency.
+//
+
+#include "k3bemulateddrivebenchmark.h"
+#include "k3bcdcopyjob.h"
+#include "k3bcdtext.h"
+#include "k3bcore.h"
+#include "k3bdatatrackreader.h"
+#include "k3bdevice.h"
+#include "k3bdiskinfo.h"
+#include "k3bdvdcopyjob.h"
+#include "k3biso9660.h"
+#include "k3btrack.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <string.h>
+
+QTEST_GUILESS_MAIN( EmulatedDriveBenchmark )
+
+namespace {
+    const int s_isoFiles = 256;
+    const int s_isoFileSectors = 32;
+    const int s_audioTrackSectors = 750;
+
+    void setBothEndian16( char* p, quint16 value )
+    {
+        p[0] = char( value );
+        p[1] = char( value >> 8 );
+        p[2] = char( value >> 8 );
+        p[3] = char( value );
+    }
+
+    void setBothEndian32( char* p, quint32 value )
+    {
+        for( int i = 0; i < 4; ++i ) {
+            p[i] = char( value >> ( 8*i ) );
+            p[7-i] = char( value >> ( 8*i ) );
+        }
+    }
+
+    int directoryRecord( char* p, quint32 extent, quint32 size, bool dir, const QByteArray& name )
+    {
+        const int len = 33 + name.size() + ( name.size() % 2 ? 0 : 1 );
+        ::memset( p, 0, len );
+        p[0] = len;
+        setBothEndian32( p + 2, extent );
+        setBothEndian32( p + 10, size );
+        p[18] = 126; // 2026
+        p[19] = 1;
+        p[20] = 1;
+        p[25] = dir ? 0x02 : 0x00;
+        setBothEndian16( p + 28, 1 );
+        p[32] = name.size();
+        ::memcpy( p + 33, name.constData(), name.size() );
+        return len;
+    }
+
+    //
+    // A plain ISO9660 file system with s_isoFiles files in the root folder.
+    // The file contents differ in every sector.
+    //
+    QByteArray createIsoImage()
+    {
+        QList<QByteArray> names;
+        for( int i = 0; i < s_isoFiles; ++i )
+            names.append( QString( "FILE%1.DAT;1" ).arg( i, 4, 10, QChar( '0' ) ).toLatin1() );
+
+        // directory records must not cross sector boundaries
+        int rootSectors = 1;
+        int pos = 2*34;
+        Q_FOREACH( const QByteArray& name, names ) {
+            const int len = 33 + name.size() + ( name.size() % 2 ? 0 : 1 );
+            if( pos + len > 2048 ) {
+                ++rootSectors;
+                pos = 0;
+            }
+            pos += len;
+        }
+
+        const int rootSector = 18;
+        const int firstFileSector = rootSector + rootSectors;
+        const int sectors = firstFileSector + s_isoFiles*s_isoFileSectors;
+        QByteArray image( sectors*2048, 0 );
+
+        // primary volume descriptor
+        char* pvd = image.data() + 16*2048;
+        pvd[0] = 1;
+        ::memcpy( pvd + 1, "CD001", 5 );
+        pvd[6] = 1;
+        ::memset( pvd + 8, ' ', 64 );
+        ::memcpy( pvd + 40, "K3B_BENCHMARK", 13 );
+        setBothEndian32( pvd + 80, sectors );
+        setBothEndian16( pvd + 120, 1 );
+        setBothEndian16( pvd + 124, 1 );
+        setBothEndian16( pvd + 128, 2048 );
+        directoryRecord( pvd + 156, rootSector, rootSectors*2048, true, QByteArray( 1, '\0' ) );
+        ::memset( pvd + 190, ' ', 623 );
+        ::memset( pvd + 813, '0', 68 );
+        pvd[881] = 1;
+
+        // volume descriptor set terminator
+        char* terminator = image.data() + 17*2048;
+        terminator[0] = char( 255 );
+        ::memcpy( terminator + 1, "CD001", 5 );
+        terminator[6] = 1;
+
+        // the root folder
+        char* dir = image.data() + rootSector*2048;
+        pos = directoryRecord( dir, rootSector, rootSectors*2048, true, QByteArray( 1, '\0' ) );
+        pos += directoryRecord( dir + pos, rootSector, rootSectors*2048, true, QByteArray( 1, '\1' ) );
+        for( int i = 0; i < s_isoFiles; ++i ) {
+            const int len = 33 + names[i].size() + ( names[i].size() % 2 ? 0 : 1 );
+            if( pos % 2048 + len > 2048 )
+                pos += 2048 - pos % 2048;
+            pos += directoryRecord( dir + pos, firstFileSector + i*s_isoFileSectors, s_isoFileSectors*2048, false, names[i] );
+        }
+
+        // the file contents
+        for( int sector = firstFileSector; sector < sectors; ++sector ) {
+            quint32* words = reinterpret_cast<quint32*>( image.data() + sector*2048 );
+            for( int i = 0; i < 512; ++i )
+                words[i] = quint32( sector ) * 2654435761U ^ i;
+        }
+
+        return image;
+    }
+
+    QByteArray createAudioImage()
+    {
+        QByteArray image( 3*s_audioTrackSectors*2352, 0 );
+        qint16* samples = reinterpret_cast<qint16*>( image.data() );
+        for( int i = 0; i < image.size() / 2; ++i )
+            samples[i] = qint16( i * 7 );
+        return image;
+    }
+
+    K3b::Device::Toc audioToc()
+    {
+        K3b::Device::Toc toc;
+        for( int i = 0; i < 3; ++i ) {
+            K3b::Device::Track track( i*s_audioTrackSectors,
+                                      ( i+1 )*s_audioTrackSectors - 1,
+                                      K3b::Device::Track::TYPE_AUDIO );
+            track.setSession( 1 );
+            toc.append( track );
+        }
+
+        // a pregap before the second track and an index in the last track
+        toc[0].setIndex0( s_audioTrackSectors - 150 );
+        toc[2].setIndices( QList<K3b::Msf>() << K3b::Msf() << K3b::Msf( 300 ) );
+        return toc;
+    }
+
+    K3b::Device::CdText audioCdText()
+    {
+        K3b::Device::CdText text;
+        text.setTitle( "K3b Benchmark" );
+        text.setPerformer( "K3b" );
+        for( int i = 0; i < 3; ++i ) {
+            K3b::Device::TrackCdText track;
+            track.setTitle( QString( "Track %1" ).arg( i+1 ) );
+            text.insert( i, track );
+        }
+        return text;
+    }
+
+    bool compareFile( const QString& path, const QByteArray& expected, const QList<int>& skippedSectors = QList<int>() )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return false;
+        const QByteArray data = f.readAll();
+        if( data.size() != expected.size() ) {
+            qDebug() << path << "has" << data.size() << "bytes instead of" << expected.size();
+            return false;
+        }
+        for( int sector = 0; sector < data.size() / 2048; ++sector ) {
+            if( !skippedSectors.contains( sector ) &&
+                ::memcmp( data.constData() + sector*2048, expected.constData() + sector*2048, 2048 ) != 0 ) {
+                qDebug() << path << "differs in sector" << sector;
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+
+EmulatedDriveBenchmark::EmulatedDriveBenchmark()
+    : m_core( 0 ),
+      m_manager( 0 ),
+      m_device( 0 )
+{
+}
+
+
+K3b::Device::MediaType EmulatedDriveBenchmark::waitForMedium( K3b::Device::Device* dev,
+                                                              K3b::Device::MediaStates,
+                                                              K3b::Device::MediaTypes,
+                                                              const K3b::Msf&,
+                                                              const QString& )
+{
+    return dev->diskInfo().mediaType();
+}
+
+
+bool EmulatedDriveBenchmark::questionYesNo( const QString&,
+                                            const QString&,
+                                            const KGuiItem&,
+                                            const KGuiItem& )
+{
+    return true;
+}
+
+
+void EmulatedDriveBenchmark::blockingInformation( const QString&,
+                                                  const QString& )
+{
+}
+
+
+void EmulatedDriveBenchmark::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    m_isoImage = m_dir.filePath( "source.iso" );
+    QFile isoFile( m_isoImage );
+    QVERIFY( isoFile.open( QIODevice::WriteOnly ) );
+    isoFile.write( createIsoImage() );
+    isoFile.close();
+
+    m_audioImage = m_dir.filePath( "source.bin" );
+    QFile audioFile( m_audioImage );
+    QVERIFY( audioFile.open( QIODevice::WriteOnly ) );
+    audioFile.write( createAudioImage() );
+    audioFile.close();
+
+    QVERIFY( m_drive.setImage( m_isoImage, TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.install();
+
+    m_core = new K3b::Core( this );
+
+    m_manager = new TestUtils::EmulatedDeviceManager( this );
+    m_device = m_manager->addEmulatedDevice( m_dir.path() );
+    QVERIFY( m_device );
+}
+
+
+void EmulatedDriveBenchmark::cleanupTestCase()
+{
+    delete m_manager;
+    m_manager = 0;
+    delete m_core;
+    m_core = 0;
+    m_drive.uninstall();
+}
+
+
+void EmulatedDriveBenchmark::init()
+{
+    m_drive.setCommandLatency( 0 );
+    m_drive.setTransferRate( 0 );
+    m_drive.setMaxTransferLength( 0 );
+    m_drive.clearReadErrors();
+    QVERIFY( m_drive.setImage( m_isoImage, TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.resetCounters();
+}
+
+
+bool EmulatedDriveBenchmark::runJob( K3b::Job* job )
+{
+    QSignalSpy spy( job, SIGNAL(finished(bool)) );
+    job->start();
+    if( spy.isEmpty() && !spy.wait( 120000 ) )
+        return false;
+    return spy.first().first().toBool();
+}
+
+
+void EmulatedDriveBenchmark::report( const QString& operation, qint64 elapsed )
+{
+    const qint64 bytes = m_drive.bytesTransferred();
+    const int reads = ( m_drive.commands( K3b::Device::MMC_READ_10 ) +
+                        m_drive.commands( K3b::Device::MMC_READ_12 ) +
+                        m_drive.commands( K3b::Device::MMC_READ_CD ) );
+    const double rate = elapsed > 0 ? double( bytes ) / 1024.0 / 1024.0 * 1000.0 / double( elapsed ) : 0.0;
+    qDebug().noquote() << QString( "%1 [%2]: %3 commands (%4 reads), %5 KiB in %6 ms (%7 MiB/s)" )
+        .arg( operation )
+        .arg( QTest::currentDataTag() )
+        .arg( m_drive.commands() )
+        .arg( reads )
+        .arg( bytes / 1024 )
+        .arg( elapsed )
+        .arg( rate, 0, 'f', 1 );
+    m_drive.resetCounters();
+}
+
+
+void EmulatedDriveBenchmark::testQueries_data()
+{
+    QTest::addColumn<int>( "medium" );
+    QTest::addColumn<bool>( "audio" );
+
+    QTest::newRow( "cd-rom" ) << int( TestUtils::EmulatedDrive::CD_ROM ) << false;
+    QTest::newRow( "dvd-rom" ) << int( TestUtils::EmulatedDrive::DVD_ROM ) << false;
+    QTest::newRow( "audio cd" ) << int( TestUtils::EmulatedDrive::CD_ROM ) << true;
+}
+
+
+void EmulatedDriveBenchmark::testQueries()
+{
+    QFETCH( int, medium );
+    QFETCH( bool, audio );
+
+    if( audio ) {
+        QVERIFY( m_drive.setImage( m_audioImage, TestUtils::EmulatedDrive::CD_ROM, audioToc() ) );
+        m_drive.setCdText( audioCdText().rawPackData() );
+    }
+    else {
+        QVERIFY( m_drive.setImage( m_isoImage, TestUtils::EmulatedDrive::Medium( medium ) ) );
+        m_drive.setCdText( QByteArray() );
+    }
+    m_drive.resetCounters();
+
+    QElapsedTimer timer;
+    timer.start();
+    const K3b::Device::DiskInfo info = m_device->diskInfo();
+    report( "diskInfo", timer.elapsed() );
+    QCOMPARE( info.diskState(), K3b::Device::STATE_COMPLETE );
+    QCOMPARE( info.mediaType(), medium == TestUtils::EmulatedDrive::DVD_ROM ? K3b::Device::MEDIA_DVD_ROM : K3b::Device::MEDIA_CD_ROM );
+
+    timer.restart();
+    const K3b::Device::Toc toc = m_device->readToc();
+    report( "readToc", timer.elapsed() );
+    QCOMPARE( toc.count(), m_drive.toc().count() );
+    QCOMPARE( toc.last().lastSector(), m_drive.toc().last().lastSector() );
+
+    if( audio ) {
+        timer.restart();
+        const K3b::Device::CdText cdText = m_device->readCdText();
+        report( "readCdText", timer.elapsed() );
+        QCOMPARE( cdText.title(), QString( "K3b Benchmark" ) );
+        QCOMPARE( cdText.count(), 3 );
+
+        K3b::Device::Toc indexToc = toc;
+        timer.restart();
+        QVERIFY( m_device->indexScan( indexToc ) );
+        report( "indexScan", timer.elapsed() );
+        QCOMPARE( indexToc[0].index0(), m_drive.toc()[0].index0() );
+        QCOMPARE( indexToc[2].indices().value( 1 ), K3b::Msf( 300 ) );
+    }
+}
+
+
+void EmulatedDriveBenchmark::testDataTrackReader_data()
+{
+    QTest::addColumn<int>( "queueDepth" );
+    QTest::addColumn<int>( "maxTransferLength" );
+    QTest::addColumn<int>( "latency" );
+    QTest::addColumn<QList<int> >( "readErrors" );
+
+    QTest::newRow( "default" ) << 4 << 0 << 0 << QList<int>();
+    QTest::newRow( "no queue" ) << 1 << 0 << 0 << QList<int>();
+    QTest::newRow( "64 KiB transfers" ) << 4 << 64*1024 << 0 << QList<int>();
+    QTest::newRow( "1 ms latency" ) << 4 << 0 << 1000 << QList<int>();
+    QTest::newRow( "1 ms latency, no queue" ) << 1 << 0 << 1000 << QList<int>();
+    QTest::newRow( "read errors" ) << 4 << 0 << 0 << ( QList<int>() << 100 << 2000 << 2001 << 5000 );
+}
+
+
+void EmulatedDriveBenchmark::testDataTrackReader()
+{
+    QFETCH( int, queueDepth );
+    QFETCH( int, maxTransferLength );
+    QFETCH( int, latency );
+    QFETCH( QList<int>, readErrors );
+
+    m_drive.setMaxTransferLength( maxTransferLength );
+    m_drive.setCommandLatency( latency );
+    Q_FOREACH( int sector, readErrors )
+        m_drive.addReadError( sector );
+
+    const QString imagePath = m_dir.filePath( "datatrackreader.iso" );
+    K3b::DataTrackReader reader( this );
+    reader.setDevice( m_device );
+    reader.setImagePath( imagePath );
+    reader.setSectorRange( m_drive.toc().first().firstSector(), m_drive.toc().first().lastSector() );
+    reader.setSectorSize( K3b::DataTrackReader::MODE1 );
+    reader.setQueueDepth( queueDepth );
+    reader.setIgnoreErrors( !readErrors.isEmpty() );
+    reader.setRetries( 1 );
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY( runJob( &reader ) );
+    report( "DataTrackReader", timer.elapsed() );
+
+    QFile source( m_isoImage );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    QVERIFY( compareFile( imagePath, source.readAll(), readErrors ) );
+    QFile::remove( imagePath );
+}
+
+
+void EmulatedDriveBenchmark::testRescueReading()
+{
+    // a scratch of 40 sectors and a single bad sector
+    QList<int> readErrors;
+    for( int sector = 3000; sector < 3040; ++sector )
+        readErrors << sector;
+    readErrors << 6000;
+    Q_FOREACH( int sector, readErrors )
+        m_drive.addReadError( sector );
+
+    const QString imagePath = m_dir.filePath( "rescue.iso" );
+    const QString mapPath = imagePath + ".map";
+    QFile::remove( imagePath );
+    QFile::remove( mapPath );
+
+    QElapsedTimer timer;
+    timer.start();
+    {
+        K3b::DataTrackReader reader( this );
+        reader.setDevice( m_device );
+        reader.setImagePath( imagePath );
+        reader.setSectorRange( m_drive.toc().first().firstSector(), m_drive.toc().first().lastSector() );
+        reader.setSectorSize( K3b::DataTrackReader::MODE1 );
+        reader.setRescueMode( true );
+        reader.setRetries( 2 );
+        QVERIFY( !runJob( &reader ) );
+    }
+    report( "DataTrackReader rescue", timer.elapsed() );
+
+    QFile source( m_isoImage );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    const QByteArray image = source.readAll();
+    QVERIFY( compareFile( imagePath, image, readErrors ) );
+
+    // exactly the unreadable sectors are marked bad
+    QFile mapFile( mapPath );
+    QVERIFY( mapFile.open( QIODevice::ReadOnly|QIODevice::Text ) );
+    QList<int> badSectors;
+    Q_FOREACH( const QByteArray& line, mapFile.readAll().split( '\n' ) ) {
+        const QList<QByteArray> fields = line.split( ' ' );
+        if( fields.count() == 3 && fields[2] == "-" ) {
+            for( int i = 0; i < fields[1].toInt(); ++i )
+                badSectors << fields[0].toInt() + i;
+        }
+        else if( fields.count() == 3 && !line.startsWith( '#' ) ) {
+            QCOMPARE( fields[2], QByteArray( "+" ) );
+        }
+    }
+    mapFile.close();
+    QCOMPARE( badSectors, readErrors );
+
+    // the second run only retries the bad sectors
+    m_drive.clearReadErrors();
+    timer.restart();
+    {
+        K3b::DataTrackReader reader( this );
+        reader.setDevice( m_device );
+        reader.setImagePath( imagePath );
+        reader.setSectorRange( m_drive.toc().first().firstSector(), m_drive.toc().first().lastSector() );
+        reader.setSectorSize( K3b::DataTrackReader::MODE1 );
+        reader.setRescueMode( true );
+        QVERIFY( runJob( &reader ) );
+    }
+    QCOMPARE( m_drive.commands( K3b::Device::MMC_READ_10 ), readErrors.count() );
+    report( "DataTrackReader rescue resumed", timer.elapsed() );
+
+    QVERIFY( compareFile( imagePath, image ) );
+    QFile::remove( imagePath );
+    QFile::remove( mapPath );
+}
+
+
+void EmulatedDriveBenchmark::testIso9660_data()
+{
+    QTest::addColumn<int>( "maxTransferLength" );
+    QTest::addColumn<int>( "latency" );
+
+    QTest::newRow( "default" ) << 0 << 0;
+    QTest::newRow( "64 KiB transfers" ) << 64*1024 << 0;
+    QTest::newRow( "1 ms latency" ) << 0 << 1000;
+}
+
+
+void EmulatedDriveBenchmark::testIso9660()
+{
+    QFETCH( int, maxTransferLength );
+    QFETCH( int, latency );
+
+    m_drive.setMaxTransferLength( maxTransferLength );
+    m_drive.setCommandLatency( latency );
+
+    QFile source( m_isoImage );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    const QByteArray image = source.readAll();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    K3b::Iso9660 iso( m_device );
+    QVERIFY( iso.open() );
+    const K3b::Iso9660Directory* root = iso.firstIsoDirEntry();
+    QVERIFY( root );
+    report( "Iso9660::open", timer.elapsed() );
+
+    timer.restart();
+    int files = 0;
+    QByteArray buffer( 64*1024, 0 );
+    Q_FOREACH( const QString& name, root->entries() ) {
+        const K3b::Iso9660Entry* entry = root->entry( name );
+        if( !entry->isFile() )
+            continue;
+        const K3b::Iso9660File* file = static_cast<const K3b::Iso9660File*>( entry );
+        for( unsigned int pos = 0; pos < file->size(); ) {
+            const int read = file->read( pos, buffer.data(), buffer.size() );
+            QVERIFY( read > 0 );
+            QVERIFY( ::memcmp( buffer.constData(), image.constData() + file->startPostion() + pos, read ) == 0 );
+            pos += read;
+        }
+        ++files;
+    }
+    report( QString( "Iso9660File::read (%1 files)" ).arg( files ), timer.elapsed() );
+    QCOMPARE( files, s_isoFiles );
+}
+
+
+void EmulatedDriveBenchmark::testCopyJobs_data()
+{
+    QTest::addColumn<int>( "medium" );
+
+    QTest::newRow( "cd copy" ) << int( TestUtils::EmulatedDrive::CD_ROM );
+    QTest::newRow( "dvd copy" ) << int( TestUtils::EmulatedDrive::DVD_ROM );
+}
+
+
+void EmulatedDriveBenchmark::testCopyJobs()
+{
+    QFETCH( int, medium );
+
+    QVERIFY( m_drive.setImage( m_isoImage, TestUtils::EmulatedDrive::Medium( medium ) ) );
+    m_drive.resetCounters();
+
+    const QString imagePath = m_dir.filePath( "copy.iso" );
+    QFile::remove( imagePath );
+
+    QElapsedTimer timer;
+    timer.start();
+    if( medium == TestUtils::EmulatedDrive::DVD_ROM ) {
+        K3b::DvdCopyJob job( this );
+        job.setReaderDevice( m_device );
+        job.setImagePath( imagePath );
+        job.setOnlyCreateImage( true );
+        job.setOnTheFly( false );
+        job.setRemoveImageFiles( false );
+        QVERIFY( runJob( &job ) );
+    }
+    else {
+        K3b::CdCopyJob job( this );
+        job.setReaderDevice( m_device );
+        job.setTempPath( imagePath );
+        job.setOnlyCreateImage( true );
+        job.setKeepImage( true );
+        job.setCopyCdText( false );
+        QVERIFY( runJob( &job ) );
+    }
+    report( "image creation", timer.elapsed() );
+
+    QFile source( m_isoImage );
+    QVERIFY( source.open( QIODevice::ReadOnly ) );
+    QVERIFY( compareFile( imagePath, source.readAll() ) );
+    QFile::remove( imagePath );
+}
+
+#include "moc_k3bemulateddrivebenchmark.cpp"
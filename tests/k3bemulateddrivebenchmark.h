@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_EMULATED_DRIVE_BENCHMARK_H
+#define K3B_EMULATED_DRIVE_BENCHMARK_H
+
+#include "k3bemulateddrive.h"
+#include "k3bjobhandler.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+namespace K3b {
+    class Core;
+    class Job;
+    namespace Device {
+        class Device;
+    }
+}
+
+class EmulatedDriveBenchmark : public QObject, public K3b::JobHandler
+{
+    Q_OBJECT
+public:
+    EmulatedDriveBenchmark();
+
+    K3b::Device::MediaType waitForMedium( K3b::Device::Device*,
+                                          K3b::Device::MediaStates mediaState,
+                                          K3b::Device::MediaTypes mediaType,
+                                          const K3b::Msf& minMediaSize,
+                                          const QString& message ) override;
+    bool questionYesNo( const QString& text,
+                        const QString& caption,
+                        const KGuiItem& buttonYes,
+                        const KGuiItem& buttonNo ) override;
+    void blockingInformation( const QString& text,
+                              const QString& caption ) override;
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void testQueries_data();
+    void testQueries();
+    void testDataTrackReader_data();
+    void testDataTrackReader();
+    void testRescueReading();
+    void testIso9660_data();
+    void testIso9660();
+    void testCopyJobs_data();
+    void testCopyJobs();
+
+private:
+    bool runJob( K3b::Job* job );
+    void report( const QString& operation, qint64 elapsed );
+
+    QTemporaryDir m_dir;
+    QString m_isoImage;
+    QString m_audioImage;
+    K3b::Core* m_core;
+    TestUtils::EmulatedDeviceManager* m_manager;
+    K3b::Device::Device* m_device;
+    TestUtils::EmulatedDrive m_drive;
+};
+
+#endif // K3B_EMULATED_DRIVE_BENCHMARK_H
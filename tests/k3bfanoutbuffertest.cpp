@@ -0,0 +1,123 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bfanoutbuffertest.h"
+#include "k3bfanoutbuffer.h"
+#include "k3btestdevices.h"
+
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( FanOutBufferTest )
+
+using namespace TestUtils;
+
+namespace {
+    const int s_dataSize = 1024*1024 + 123;
+}
+
+FanOutBufferTest::FanOutBufferTest()
+{
+}
+
+void FanOutBufferTest::testAllSinksGetData()
+{
+    const QByteArray data = testData( s_dataSize );
+
+    QBuffer sink1, sink2, sink3;
+    K3b::FanOutBuffer buffer( 64*1024 );
+    buffer.addSink( &sink1, true );
+    buffer.addSink( &sink2, true );
+    buffer.addSink( &sink3 );
+    QVERIFY( buffer.open() );
+
+    QVERIFY( writeAll( &buffer, data ) );
+    buffer.waitForSinks();
+
+    QVERIFY( !buffer.isOpen() );
+    QVERIFY( !sink1.isOpen() );
+    QVERIFY( !sink2.isOpen() );
+    QVERIFY( sink3.isOpen() );
+    QCOMPARE( sink1.data(), data );
+    QCOMPARE( sink2.data(), data );
+    QCOMPARE( sink3.data(), data );
+    QCOMPARE( buffer.sinkBytesWritten( &sink1 ), quint64( data.size() ) );
+    QVERIFY( !buffer.sinkDropped( &sink1 ) );
+}
+
+void FanOutBufferTest::testFailingSinkIsDropped()
+{
+    const QByteArray data = testData( s_dataSize );
+
+    QBuffer sink;
+    FailingDevice failing( 100*1024 );
+    K3b::FanOutBuffer buffer( 64*1024 );
+    buffer.addSink( &failing );
+    buffer.addSink( &sink );
+    QVERIFY( buffer.open() );
+
+    // the failing sink must not block the other one
+    QVERIFY( writeAll( &buffer, data ) );
+    buffer.waitForSinks();
+
+    QCOMPARE( sink.data(), data );
+    QVERIFY( buffer.sinkDropped( &failing ) );
+    QVERIFY( !buffer.sinkDropped( &sink ) );
+    QCOMPARE( buffer.sinkBytesWritten( &failing ), quint64( 100*1024 ) );
+}
+
+void FanOutBufferTest::testWriteFailsWithoutSinks()
+{
+    const QByteArray data = testData( s_dataSize );
+
+    FailingDevice failing1( 1000 );
+    FailingDevice failing2( 200*1024 );
+    K3b::FanOutBuffer buffer( 64*1024 );
+    buffer.addSink( &failing1 );
+    buffer.addSink( &failing2 );
+    QVERIFY( buffer.open() );
+
+    QVERIFY( !writeAll( &buffer, data ) );
+    QVERIFY( buffer.sinkDropped( &failing1 ) );
+    QVERIFY( buffer.sinkDropped( &failing2 ) );
+    buffer.waitForSinks();
+}
+
+void FanOutBufferTest::testStuckSinkIsLeftBehind()
+{
+    const QByteArray data = testData( s_dataSize );
+
+    // the drop flag cannot interrupt a write which does not return
+    QMutex* gate = new QMutex();
+    gate->lock();
+    GatedDevice* stuck = new GatedDevice( gate );
+
+    QBuffer sink;
+    K3b::FanOutBuffer buffer( 64*1024 );
+    buffer.addSink( stuck );
+    buffer.addSink( &sink );
+    QVERIFY( buffer.open() );
+
+    QCOMPARE( buffer.write( data.constData(), 1000 ), qint64( 1000 ) );
+    buffer.dropSink( stuck );
+    QVERIFY( writeAll( &buffer, data.mid( 1000 ) ) );
+
+    QElapsedTimer timer;
+    timer.start();
+    buffer.waitForSinks();
+    QVERIFY( timer.elapsed() < 10000 );
+
+    QVERIFY( !buffer.isOpen() );
+    QCOMPARE( sink.data(), data );
+
+    // the sink left behind finishes once its write returns. The device is
+    // leaked since there is no way to tell when the thread is done with it.
+    gate->unlock();
+}
+
+#include "moc_k3bfanoutbuffertest.cpp"
@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_FAN_OUT_BUFFER_TEST_H
+#define K3B_FAN_OUT_BUFFER_TEST_H
+
+#include <QObject>
+
+class FanOutBufferTest : public QObject
+{
+    Q_OBJECT
+public:
+    FanOutBufferTest();
+private slots:
+    void testAllSinksGetData();
+    void testFailingSinkIsDropped();
+    void testWriteFailsWithoutSinks();
+    void testStuckSinkIsLeftBehind();
+};
+
+#endif // K3B_FAN_OUT_BUFFER_TEST_H
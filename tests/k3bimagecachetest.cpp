@@ -0,0 +1,177 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bimagecachetest.h"
+#include "k3bimagecache.h"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( ImageCacheTest )
+
+namespace {
+    const qint64 s_imageSize = 1000;
+
+    bool writeImage( const QString& path, qint64 size )
+    {
+        QFile f( path );
+        return f.open( QIODevice::WriteOnly ) && f.write( QByteArray( size, 'x' ) ) == size;
+    }
+
+    // the cache uses the modification time as the time of the last use
+    void setLastUse( const QString& path, const QDateTime& time )
+    {
+        QFile f( path );
+        QVERIFY( f.open( QIODevice::ReadWrite ) );
+        QVERIFY( f.setFileTime( time, QFileDevice::FileModificationTime ) );
+    }
+
+    void addImage( K3b::ImageCache& cache, const QByteArray& key, qint64 size )
+    {
+        const QString path = cache.newImagePath( key );
+        QVERIFY( writeImage( path, size ) );
+        QVERIFY( cache.insert( key, "checksum-" + key ) );
+    }
+}
+
+ImageCacheTest::ImageCacheTest()
+    : m_dir( 0 )
+{
+}
+
+void ImageCacheTest::init()
+{
+    delete m_dir;
+    m_dir = new QTemporaryDir();
+    QVERIFY( m_dir->isValid() );
+}
+
+QString ImageCacheTest::cacheDir() const
+{
+    return QDir( m_dir->path() ).filePath( "cache" );
+}
+
+void ImageCacheTest::testInsert()
+{
+    K3b::ImageCache cache( cacheDir(), 10*s_imageSize );
+    QVERIFY( cache.isEnabled() );
+
+    // an unfinished image is not visible
+    const QString newPath = cache.newImagePath( "a" );
+    QVERIFY( newPath.endsWith( ".part" ) );
+    QVERIFY( writeImage( newPath, s_imageSize ) );
+    QVERIFY( cache.lookup( "a" ).isEmpty() );
+    QCOMPARE( cache.size(), qint64( 0 ) );
+
+    QVERIFY( cache.insert( "a", "checksum-a" ) );
+    QVERIFY( !QFile::exists( newPath ) );
+
+    QByteArray checksum;
+    const QString path = cache.lookup( "a", &checksum );
+    QVERIFY( !path.isEmpty() );
+    QVERIFY( path.endsWith( ".iso" ) );
+    QCOMPARE( QFileInfo( path ).size(), s_imageSize );
+    QCOMPARE( checksum, QByteArray( "checksum-a" ) );
+    QCOMPARE( cache.size(), s_imageSize );
+
+    // nothing to insert without an image
+    QVERIFY( !cache.insert( "b", "checksum-b" ) );
+    QVERIFY( cache.lookup( "b" ).isEmpty() );
+}
+
+void ImageCacheTest::testInsertFile()
+{
+    K3b::ImageCache cache( cacheDir(), 10*s_imageSize );
+
+    const QString image = QDir( m_dir->path() ).filePath( "image.iso" );
+    QVERIFY( writeImage( image, s_imageSize ) );
+
+    // a moved image is taken over without an unfinished copy
+    QVERIFY( cache.insertFile( "a", image, "checksum-a", true ) );
+    QVERIFY( !QFile::exists( image ) );
+    QVERIFY( !QFile::exists( cache.newImagePath( "a" ) ) );
+
+    QByteArray checksum;
+    const QString path = cache.lookup( "a", &checksum );
+    QVERIFY( !path.isEmpty() );
+    QCOMPARE( QFileInfo( path ).size(), s_imageSize );
+    QCOMPARE( checksum, QByteArray( "checksum-a" ) );
+
+    // a clone which is not supported leaves neither the image nor an unfinished copy
+    QVERIFY( writeImage( image, s_imageSize ) );
+    if( cache.insertFile( "b", image, "checksum-b", false ) ) {
+        QVERIFY( QFile::exists( image ) );
+        QVERIFY( !cache.lookup( "b" ).isEmpty() );
+    }
+    else {
+        QVERIFY( QFile::exists( image ) );
+        QVERIFY( cache.lookup( "b" ).isEmpty() );
+    }
+    QVERIFY( !QFile::exists( cache.newImagePath( "b" ) ) );
+}
+
+void ImageCacheTest::testEvictLeastRecentlyUsed()
+{
+    K3b::ImageCache cache( cacheDir(), 3*s_imageSize );
+
+    addImage( cache, "a", s_imageSize );
+    addImage( cache, "b", s_imageSize );
+    addImage( cache, "c", s_imageSize );
+    QCOMPARE( cache.size(), 3*s_imageSize );
+
+    const QDateTime now = QDateTime::currentDateTime();
+    setLastUse( cache.lookup( "a" ), now.addSecs( -300 ) );
+    setLastUse( cache.lookup( "b" ), now.addSecs( -200 ) );
+    setLastUse( cache.lookup( "c" ), now.addSecs( -100 ) );
+
+    // using "a" makes "b" the least recently used image
+    QVERIFY( !cache.lookup( "a" ).isEmpty() );
+
+    addImage( cache, "d", s_imageSize );
+    QCOMPARE( cache.size(), 3*s_imageSize );
+    QVERIFY( cache.lookup( "b" ).isEmpty() );
+    QVERIFY( !cache.lookup( "a" ).isEmpty() );
+    QVERIFY( !cache.lookup( "c" ).isEmpty() );
+    QVERIFY( !cache.lookup( "d" ).isEmpty() );
+
+    // a larger image evicts as many images as necessary
+    setLastUse( cache.lookup( "a" ), now.addSecs( -100 ) );
+    setLastUse( cache.lookup( "c" ), now.addSecs( -300 ) );
+    setLastUse( cache.lookup( "d" ), now.addSecs( -200 ) );
+    addImage( cache, "e", 2*s_imageSize );
+    QVERIFY( cache.size() <= 3*s_imageSize );
+    QVERIFY( cache.lookup( "c" ).isEmpty() );
+    QVERIFY( cache.lookup( "d" ).isEmpty() );
+    QVERIFY( !cache.lookup( "a" ).isEmpty() );
+    QVERIFY( !cache.lookup( "e" ).isEmpty() );
+}
+
+void ImageCacheTest::testRejectOversizedImage()
+{
+    K3b::ImageCache cache( cacheDir(), 2*s_imageSize );
+    addImage( cache, "a", s_imageSize );
+
+    // an existing image is left in place
+    const QString image = QDir( m_dir->path() ).filePath( "image.iso" );
+    QVERIFY( writeImage( image, 3*s_imageSize ) );
+    QVERIFY( !cache.insertFile( "b", image, "checksum-b", true ) );
+    QVERIFY( QFile::exists( image ) );
+    QVERIFY( cache.lookup( "b" ).isEmpty() );
+
+    // an image created in the cache is removed without evicting the others
+    const QString newPath = cache.newImagePath( "c" );
+    QVERIFY( writeImage( newPath, 3*s_imageSize ) );
+    QVERIFY( !cache.insert( "c", "checksum-c" ) );
+    QVERIFY( !QFile::exists( newPath ) );
+    QVERIFY( cache.lookup( "c" ).isEmpty() );
+    QVERIFY( !cache.lookup( "a" ).isEmpty() );
+    QCOMPARE( cache.size(), s_imageSize );
+}
+
+#include "moc_k3bimagecachetest.cpp"
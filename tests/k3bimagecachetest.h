@@ -0,0 +1,31 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_IMAGE_CACHE_TEST_H
+#define K3B_IMAGE_CACHE_TEST_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+class ImageCacheTest : public QObject
+{
+    Q_OBJECT
+public:
+    ImageCacheTest();
+private slots:
+    void init();
+    void testInsert();
+    void testInsertFile();
+    void testEvictLeastRecentlyUsed();
+    void testRejectOversizedImage();
+
+private:
+    QString cacheDir() const;
+
+    QTemporaryDir* m_dir;
+};
+
+#endif // K3B_IMAGE_CACHE_TEST_H
@@ -0,0 +1,236 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bindexscantest.h"
+#include "k3bdevice.h"
+#include "k3btoc.h"
+#include "k3btrack.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( IndexScanTest )
+
+namespace {
+    //
+    // The emulated audio CD:
+    //
+    // track 1:     0 - 14999  index 2 at 5000, index 3 at 9000, index 0 from 14825
+    // track 2: 15000 - 29999  index 0 from 29700
+    // track 3: 30000 - 44999  index 2 at 40000
+    //
+    // Every hundredth sector carries a Mode-2 Q (ADR 2) and every hundredth
+    // sector has a damaged Q.
+    //
+    const unsigned long s_trackSectors = 15000;
+
+    K3b::Device::Toc audioToc()
+    {
+        K3b::Device::Toc toc;
+        for( int i = 0; i < 3; ++i ) {
+            K3b::Device::Track track( s_trackSectors*i, s_trackSectors*i + s_trackSectors - 1,
+                                      K3b::Device::Track::TYPE_AUDIO );
+            track.setSession( 1 );
+            toc.append( track );
+        }
+        return toc;
+    }
+
+    K3b::Device::Toc discToc()
+    {
+        K3b::Device::Toc toc = audioToc();
+        toc[0].setIndex0( 14825 );
+        toc[0].setIndices( QList<K3b::Msf>() << K3b::Msf() << K3b::Msf( 5000 ) << K3b::Msf( 9000 ) );
+        toc[1].setIndex0( 14700 );
+        toc[2].setIndices( QList<K3b::Msf>() << K3b::Msf() << K3b::Msf( 10000 ) );
+        return toc;
+    }
+
+    //
+    // The search for index 0 as done before the Q subchannel was read in blocks:
+    // jump backwards in 1 sec steps and walk forward to the first index 0.
+    //
+    long forwardWalkIndex0( K3b::Device::Device* dev, unsigned long startSec, unsigned long endSec )
+    {
+        int lastIndex = dev->getIndex( endSec );
+        if( lastIndex != 0 )
+            return -1;
+
+        unsigned long sector = endSec;
+        while( lastIndex == 0 && sector > startSec ) {
+            sector -= 75;
+            if( sector < startSec )
+                sector = startSec;
+            lastIndex = dev->getIndex( sector );
+        }
+
+        if( lastIndex == 0 )
+            return -1;
+
+        while( dev->getIndex( sector ) != 0 && sector < endSec )
+            sector++;
+        return sector;
+    }
+
+    void verifyIndices( const K3b::Device::Toc& toc )
+    {
+        QCOMPARE( toc[0].index0().lba(), 14825 );
+        QCOMPARE( toc[0].indexCount(), 2 );
+        QCOMPARE( toc[0].indices().value( 1 ).lba(), 5000 );
+        QCOMPARE( toc[0].indices().value( 2 ).lba(), 9000 );
+
+        QCOMPARE( toc[1].index0().lba(), 14700 );
+
+        QCOMPARE( toc[2].index0().lba(), 0 );
+        QCOMPARE( toc[2].indices().value( 1 ).lba(), 10000 );
+    }
+}
+
+
+IndexScanTest::IndexScanTest()
+    : m_manager( 0 ),
+      m_device( 0 )
+{
+}
+
+void IndexScanTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    // the image is sparse, only the subchannel is read
+    const QString image = m_dir.filePath( "audio.bin" );
+    QFile imageFile( image );
+    QVERIFY( imageFile.open( QIODevice::WriteOnly ) );
+    QVERIFY( imageFile.resize( qint64( 3*s_trackSectors )*2352 ) );
+    imageFile.close();
+
+    QVERIFY( m_drive.setImage( image, TestUtils::EmulatedDrive::CD_ROM, discToc() ) );
+    m_drive.setMediaCatalogNumber( "0123456789012" );
+    for( unsigned long lba = 20; lba < 3*s_trackSectors; lba += 100 )
+        m_drive.addQSubchannelError( lba );
+    m_drive.install();
+
+    m_manager = new TestUtils::EmulatedDeviceManager( this );
+    m_device = m_manager->addEmulatedDevice( m_dir.path() );
+    QVERIFY( m_device );
+}
+
+void IndexScanTest::cleanupTestCase()
+{
+    delete m_manager;
+    m_manager = 0;
+    m_drive.uninstall();
+}
+
+void IndexScanTest::init()
+{
+    m_drive.setMaxSubchannelSectors( 0 );
+    m_drive.clearMissingQSubchannel();
+    m_drive.resetCounters();
+}
+
+void IndexScanTest::testSearchIndex0()
+{
+    long pregapStart = 0;
+    QVERIFY( m_device->searchIndex0( 0, 14999, pregapStart ) );
+    QCOMPARE( pregapStart, 14825L );
+
+    QVERIFY( m_device->searchIndex0( 15000, 29999, pregapStart ) );
+    QCOMPARE( pregapStart, 29700L );
+
+    QVERIFY( m_device->searchIndex0( 30000, 44999, pregapStart ) );
+    QCOMPARE( pregapStart, -1L );
+}
+
+void IndexScanTest::testIndexScan()
+{
+    K3b::Device::Toc toc = audioToc();
+    QVERIFY( m_device->indexScan( toc ) );
+    verifyIndices( toc );
+}
+
+void IndexScanTest::testSingleSectorFallback()
+{
+    K3b::Device::Toc bulkToc = audioToc();
+    QVERIFY( m_device->indexScan( bulkToc ) );
+    verifyIndices( bulkToc );
+    const int bulkCommands = m_drive.commands();
+
+    // a drive which only reads the subchannel of single sectors
+    m_drive.resetCounters();
+    m_drive.setMaxSubchannelSectors( 1 );
+    K3b::Device::Toc singleToc = audioToc();
+    QVERIFY( m_device->indexScan( singleToc ) );
+    verifyIndices( singleToc );
+    const int singleCommands = m_drive.commands();
+
+    qDebug() << "commands for the index scan:" << bulkCommands << "bulk," << singleCommands << "single sector";
+
+    QCOMPARE( bulkToc.count(), singleToc.count() );
+    for( int i = 0; i < bulkToc.count(); ++i ) {
+        QCOMPARE( bulkToc[i].index0(), singleToc[i].index0() );
+        QCOMPARE( bulkToc[i].indices(), singleToc[i].indices() );
+    }
+    QVERIFY( bulkCommands < singleCommands );
+}
+
+void IndexScanTest::testMissingQSubchannel()
+{
+    //
+    // Pairs of sectors without Q subchannel inside the pregaps. Their index
+    // cannot be determined, neither from the sector nor from the previous one.
+    // The sectors right at the start of the pregap are readable.
+    //
+    for( unsigned long lba = 14829; lba < s_trackSectors; lba += 10 ) {
+        m_drive.addMissingQSubchannel( lba );
+        m_drive.addMissingQSubchannel( lba + 1 );
+    }
+    for( unsigned long lba = 29705; lba < 2*s_trackSectors; lba += 10 ) {
+        m_drive.addMissingQSubchannel( lba );
+        m_drive.addMissingQSubchannel( lba + 1 );
+    }
+
+    const long expected[] = { 14825, 29700 };
+    for( int track = 0; track < 2; ++track ) {
+        const unsigned long startSec = track*s_trackSectors;
+        const unsigned long endSec = startSec + s_trackSectors - 1;
+
+        const long forwardWalk = forwardWalkIndex0( m_device, startSec, endSec );
+        QCOMPARE( forwardWalk, expected[track] );
+
+        long bulk = 0;
+        m_drive.setMaxSubchannelSectors( 0 );
+        QVERIFY( m_device->searchIndex0( startSec, endSec, bulk ) );
+        QCOMPARE( bulk, forwardWalk );
+
+        long single = 0;
+        m_drive.setMaxSubchannelSectors( 1 );
+        QVERIFY( m_device->searchIndex0( startSec, endSec, single ) );
+        QCOMPARE( single, forwardWalk );
+    }
+}
+
+void IndexScanTest::testSameAsForwardWalk()
+{
+    // the damaged Q subchannel every hundredth sector is in place
+    K3b::Device::Toc bulkToc = audioToc();
+    QVERIFY( m_device->indexScan( bulkToc ) );
+
+    m_drive.setMaxSubchannelSectors( 1 );
+    K3b::Device::Toc singleToc = audioToc();
+    QVERIFY( m_device->indexScan( singleToc ) );
+
+    for( int i = 0; i < bulkToc.count(); ++i ) {
+        const K3b::Device::Track& track = bulkToc[i];
+        const long forwardWalk = forwardWalkIndex0( m_device, track.firstSector().lba(), track.lastSector().lba() );
+        const int index0 = ( forwardWalk > 0 ? forwardWalk - track.firstSector().lba() : 0 );
+        QCOMPARE( track.index0().lba(), index0 );
+        QCOMPARE( singleToc[i].index0().lba(), index0 );
+    }
+}
+
+#include "moc_k3bindexscantest.cpp"
@@ -0,0 +1,147 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+//
+// Replays file reads against an ISO9660 image and reports the seek distance
+// and the read throughput. Used to compare images created with and without
+// the optimized file layout (IsoOptions::optimizeLayout).
+//
+// Usage: k3bisolayoutbenchmark <image> [<replay list>]
+//
+// The replay list contains one path (relative to the image root) per line.
+// Without a list all files are read folder by folder in alphabetical order
+// which is what file managers and copy tools do.
+//
+
+#include "k3biso9660.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+#include <stdio.h>
+
+
+namespace {
+    void collectFiles( const K3b::Iso9660Directory* dir, const QString& path, QStringList& files )
+    {
+        QStringList entries = dir->entries();
+        entries.sort();
+
+        QStringList subDirs;
+        Q_FOREACH( const QString& name, entries ) {
+            const K3b::Iso9660Entry* entry = dir->entry( name );
+            if( entry->isDirectory() )
+                subDirs.append( name );
+            else if( entry->isFile() )
+                files.append( path + name );
+        }
+
+        Q_FOREACH( const QString& name, subDirs ) {
+            collectFiles( static_cast<const K3b::Iso9660Directory*>( dir->entry( name ) ), path + name + '/', files );
+        }
+    }
+}
+
+
+int main( int argc, char* argv[] )
+{
+    QCoreApplication app( argc, argv );
+
+    const QStringList args = app.arguments();
+    if( args.count() < 2 ) {
+        fprintf( stderr, "Usage: %s <image> [<replay list>]\n", qPrintable( args.first() ) );
+        return 1;
+    }
+
+    K3b::Iso9660 iso( args[1] );
+    if( !iso.open() ) {
+        fprintf( stderr, "Could not open %s\n", qPrintable( args[1] ) );
+        return 1;
+    }
+
+    const K3b::Iso9660Directory* root = iso.firstRRDirEntry();
+    if( !root )
+        root = iso.firstJolietDirEntry();
+    if( !root )
+        root = iso.firstIsoDirEntry();
+    if( !root ) {
+        fprintf( stderr, "No file system found in %s\n", qPrintable( args[1] ) );
+        return 1;
+    }
+
+    QStringList files;
+    if( args.count() > 2 ) {
+        QFile f( args[2] );
+        if( !f.open( QIODevice::ReadOnly ) ) {
+            fprintf( stderr, "Could not open %s\n", qPrintable( args[2] ) );
+            return 1;
+        }
+        QTextStream s( &f );
+        while( !s.atEnd() ) {
+            const QString line = s.readLine().trimmed();
+            if( !line.isEmpty() && !line.startsWith( '#' ) )
+                files.append( line );
+        }
+    }
+    else {
+        collectFiles( root, QString(), files );
+    }
+
+    qint64 bytes = 0;
+    qint64 seeks = 0;
+    qint64 seekDistance = 0;
+    qint64 nextSector = -1;
+    int missing = 0;
+
+    QByteArray buffer( 64*2048, 0 );
+    QElapsedTimer timer;
+    timer.start();
+
+    Q_FOREACH( const QString& path, files ) {
+        const K3b::Iso9660Entry* entry = root->entry( path );
+        if( !entry || !entry->isFile() ) {
+            ++missing;
+            continue;
+        }
+
+        const K3b::Iso9660File* file = static_cast<const K3b::Iso9660File*>( entry );
+        if( file->size() == 0 )
+            continue;
+
+        // every read which does not continue where the last one ended is a seek
+        const qint64 start = file->startSector();
+        if( nextSector >= 0 && start != nextSector ) {
+            ++seeks;
+            seekDistance += qAbs( start - nextSector );
+        }
+        nextSector = start + ( file->size() + 2047 ) / 2048;
+
+        unsigned int pos = 0;
+        while( pos < file->size() ) {
+            const int r = file->read( pos, buffer.data(), buffer.size() );
+            if( r <= 0 )
+                break;
+            pos += r;
+        }
+        bytes += pos;
+    }
+
+    const qint64 msecs = qMax( timer.elapsed(), qint64( 1 ) );
+
+    printf( "files:          %d (%d not found)\n", int( files.count() - missing ), missing );
+    printf( "bytes read:     %lld\n", bytes );
+    printf( "seeks:          %lld\n", seeks );
+    printf( "seek distance:  %lld sectors (%.1f MB), %.1f sectors per seek\n",
+            seekDistance, double( seekDistance ) * 2048.0 / 1024.0 / 1024.0,
+            seeks ? double( seekDistance ) / double( seeks ) : 0.0 );
+    printf( "throughput:     %.2f MB/s (%lld ms)\n",
+            double( bytes ) / 1024.0 / 1024.0 / ( double( msecs ) / 1000.0 ), msecs );
+
+    return 0;
+}
@@ -0,0 +1,128 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bmediumtest.h"
+#include "k3bmedium.h"
+#include "k3bdevice.h"
+#include "k3bdiskinfo.h"
+
+#include <QFile>
+#include <QTest>
+
+#include <string.h>
+
+QTEST_GUILESS_MAIN( MediumTest )
+
+namespace {
+    const int s_imageSectors = 300;
+}
+
+
+MediumTest::MediumTest()
+    : m_manager( 0 ),
+      m_device( 0 )
+{
+}
+
+
+//
+// The images only differ in the sector of the primary volume descriptor
+//
+QString MediumTest::createImage( const QString& name, char fill )
+{
+    QByteArray image( s_imageSectors*2048, 0 );
+    ::memset( image.data() + 16*2048, fill, 2048 );
+
+    const QString path = m_dir.filePath( name );
+    QFile f( path );
+    if( !f.open( QIODevice::WriteOnly ) || f.write( image ) != image.size() )
+        return QString();
+    return path;
+}
+
+
+void MediumTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+    QVERIFY( !createImage( "first.iso", 'a' ).isEmpty() );
+    QVERIFY( !createImage( "second.iso", 'b' ).isEmpty() );
+
+    QVERIFY( m_drive.setImage( m_dir.filePath( "first.iso" ), TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.install();
+
+    m_manager = new TestUtils::EmulatedDeviceManager( this );
+    m_device = m_manager->addEmulatedDevice( m_dir.path() );
+    QVERIFY( m_device );
+}
+
+
+void MediumTest::cleanupTestCase()
+{
+    delete m_manager;
+    m_manager = 0;
+    m_drive.uninstall();
+}
+
+
+void MediumTest::init()
+{
+    QVERIFY( m_drive.setImage( m_dir.filePath( "first.iso" ), TestUtils::EmulatedDrive::CD_ROM ) );
+    m_drive.resetCounters();
+}
+
+
+void MediumTest::testKnownMedium()
+{
+    K3b::Medium first( m_device );
+    QVERIFY( !first.update( QList<K3b::Medium>() ) );
+    QVERIFY( !first.fingerprint().isEmpty() );
+    const int fullCommands = m_drive.commands();
+
+    // reinserting the medium only costs the queries for the fingerprint
+    m_drive.resetCounters();
+    K3b::Medium reinserted( m_device );
+    QVERIFY( reinserted.update( QList<K3b::Medium>() << first ) );
+    QCOMPARE( reinserted.fingerprint(), first.fingerprint() );
+    QVERIFY( reinserted == first );
+    QVERIFY( m_drive.commands() < fullCommands );
+}
+
+
+void MediumTest::testChangedMedium()
+{
+    K3b::Medium first( m_device );
+    first.update();
+
+    QVERIFY( m_drive.setImage( m_dir.filePath( "second.iso" ), TestUtils::EmulatedDrive::CD_ROM ) );
+    K3b::Medium second( m_device );
+    QVERIFY( !second.update( QList<K3b::Medium>() << first ) );
+    QVERIFY( !second.fingerprint().isEmpty() );
+    QVERIFY( second.fingerprint() != first.fingerprint() );
+
+    // the first medium is recognized among others
+    QVERIFY( m_drive.setImage( m_dir.filePath( "first.iso" ), TestUtils::EmulatedDrive::CD_ROM ) );
+    K3b::Medium reinserted( m_device );
+    QVERIFY( reinserted.update( QList<K3b::Medium>() << second << first ) );
+    QCOMPARE( reinserted.fingerprint(), first.fingerprint() );
+}
+
+
+void MediumTest::testBlankMedia()
+{
+    QVERIFY( m_drive.insertBlankMedium( m_dir.filePath( "blank1.img" ) ) );
+    K3b::Medium blank( m_device );
+    QVERIFY( !blank.update( QList<K3b::Medium>() ) );
+    QCOMPARE( blank.diskInfo().diskState(), K3b::Device::STATE_EMPTY );
+    QVERIFY( blank.fingerprint().isEmpty() );
+
+    // another blank medium of the same type is never taken for the first one
+    QVERIFY( m_drive.insertBlankMedium( m_dir.filePath( "blank2.img" ) ) );
+    K3b::Medium other( m_device );
+    QVERIFY( !other.update( QList<K3b::Medium>() << blank ) );
+    QCOMPARE( other.diskInfo().diskState(), K3b::Device::STATE_EMPTY );
+}
+
+#include "moc_k3bmediumtest.cpp"
@@ -0,0 +1,43 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_MEDIUM_TEST_H
+#define K3B_MEDIUM_TEST_H
+
+#include "k3bemulateddrive.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+namespace K3b {
+    namespace Device {
+        class Device;
+    }
+}
+
+class MediumTest : public QObject
+{
+    Q_OBJECT
+public:
+    MediumTest();
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void testKnownMedium();
+    void testChangedMedium();
+    void testBlankMedia();
+
+private:
+    QString createImage( const QString& name, char fill );
+
+    QTemporaryDir m_dir;
+    TestUtils::EmulatedDrive m_drive;
+    TestUtils::EmulatedDeviceManager* m_manager;
+    K3b::Device::Device* m_device;
+};
+
+#endif // K3B_MEDIUM_TEST_H
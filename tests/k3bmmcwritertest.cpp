@@ -0,0 +1,196 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bmmcwritertest.h"
+#include "k3bcore.h"
+#include "k3bdevice.h"
+#include "k3bdiskinfo.h"
+#include "k3bmediacache.h"
+#include "k3bmedium.h"
+#include "k3bmmcwriter.h"
+#include "k3bscsicommand.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( MmcWriterTest )
+
+namespace {
+    // not a multiple of the sector size to test the padding
+    const int s_sourceSize = 1000*2048 + 100;
+    const int s_trackSectors = 1001;
+
+    // the writer sends blocks of 32 sectors
+    const int s_writeCommands = ( s_trackSectors + 31 ) / 32;
+
+    bool runJob( K3b::Job* job )
+    {
+        QSignalSpy spy( job, SIGNAL(finished(bool)) );
+        job->start();
+        if( spy.isEmpty() && !spy.wait( 60000 ) )
+            return false;
+        return spy.first().first().toBool();
+    }
+
+    QByteArray fileContents( const QString& path )
+    {
+        QFile f( path );
+        if( !f.open( QIODevice::ReadOnly ) )
+            return QByteArray();
+        return f.readAll();
+    }
+}
+
+
+MmcWriterTest::MmcWriterTest()
+    : m_core( 0 ),
+      m_manager( 0 ),
+      m_device( 0 )
+{
+}
+
+
+K3b::Device::MediaType MmcWriterTest::waitForMedium( K3b::Device::Device* dev,
+                                                     K3b::Device::MediaStates,
+                                                     K3b::Device::MediaTypes,
+                                                     const K3b::Msf&,
+                                                     const QString& )
+{
+    return dev->diskInfo().mediaType();
+}
+
+
+bool MmcWriterTest::questionYesNo( const QString&,
+                                   const QString&,
+                                   const KGuiItem&,
+                                   const KGuiItem& )
+{
+    return true;
+}
+
+
+void MmcWriterTest::blockingInformation( const QString&,
+                                         const QString& )
+{
+}
+
+
+void MmcWriterTest::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    QByteArray data( s_sourceSize, 0 );
+    for( int i = 0; i < data.size(); ++i )
+        data[i] = char( i * 7 + i / 2048 );
+    m_source = m_dir.filePath( "source.iso" );
+    QFile source( m_source );
+    QVERIFY( source.open( QIODevice::WriteOnly ) );
+    QCOMPARE( source.write( data ), qint64( data.size() ) );
+    source.close();
+
+    QVERIFY( m_drive.insertBlankMedium( m_dir.filePath( "disc" ) ) );
+    m_drive.install();
+
+    m_core = new K3b::Core( this );
+
+    m_manager = new TestUtils::EmulatedDeviceManager( this );
+    m_device = m_manager->addEmulatedDevice( m_dir.path() );
+    QVERIFY( m_device );
+
+    // the writer takes the medium from the media cache
+    m_core->mediaCache()->buildDeviceList( m_manager );
+}
+
+
+void MmcWriterTest::cleanupTestCase()
+{
+    if( m_core )
+        m_core->mediaCache()->clearDeviceList();
+    delete m_manager;
+    m_manager = 0;
+    delete m_core;
+    m_core = 0;
+    m_drive.uninstall();
+}
+
+
+void MmcWriterTest::init()
+{
+    QVERIFY( m_drive.insertBlankMedium( m_dir.filePath( "disc" ) ) );
+    m_drive.setBusyWrites( 0 );
+    m_drive.resetCounters();
+
+    m_core->mediaCache()->resetDevice( m_device );
+    QTRY_VERIFY_WITH_TIMEOUT( m_core->mediaCache()->medium( m_device ).diskInfo().mediaType() == K3b::Device::MEDIA_DVD_PLUS_R &&
+                              m_core->mediaCache()->medium( m_device ).diskInfo().empty(), 10000 );
+}
+
+
+void MmcWriterTest::testWriteImage()
+{
+    K3b::MmcWriter writer( m_device, this, this );
+    writer.setBurnSpeed( -1 );
+    writer.setImageToWrite( m_source );
+    writer.setCloseDvd( true );
+
+    QVERIFY( runJob( &writer ) );
+
+    // the last sector is padded with zeros
+    QByteArray expected = fileContents( m_source );
+    expected.append( QByteArray( s_trackSectors*2048 - expected.size(), 0 ) );
+    QCOMPARE( fileContents( m_dir.filePath( "disc" ) ), expected );
+
+    QCOMPARE( m_drive.commands( K3b::Device::MMC_WRITE_10 ), s_writeCommands );
+    QCOMPARE( m_drive.commands( K3b::Device::MMC_SYNCHRONIZE_CACHE ), 1 );
+    QCOMPARE( m_drive.commands( K3b::Device::MMC_CLOSE_TRACK_SESSION ), 2 );
+    QCOMPARE( m_drive.toc().count(), 1 );
+    QCOMPARE( m_drive.toc().first().length().lba(), s_trackSectors );
+}
+
+
+void MmcWriterTest::testLongWriteInProgress()
+{
+    // the writer keeps sending the block until the drive is ready
+    m_drive.setBusyWrites( 50 );
+
+    K3b::MmcWriter writer( m_device, this, this );
+    writer.setBurnSpeed( -1 );
+    writer.setImageToWrite( m_source );
+
+    QVERIFY( runJob( &writer ) );
+
+    QCOMPARE( fileContents( m_dir.filePath( "disc" ) ).left( s_sourceSize ), fileContents( m_source ) );
+    QCOMPARE( m_drive.commands( K3b::Device::MMC_WRITE_10 ), s_writeCommands + 50 );
+}
+
+
+void MmcWriterTest::testCancelWhileDriveIsBusy()
+{
+    // a drive which would keep the writer retrying for a minute
+    m_drive.setBusyWrites( 1000000 );
+
+    K3b::MmcWriter writer( m_device, this, this );
+    writer.setBurnSpeed( -1 );
+    writer.setImageToWrite( m_source );
+
+    QSignalSpy spy( &writer, SIGNAL(finished(bool)) );
+    writer.start();
+    QTRY_VERIFY_WITH_TIMEOUT( m_drive.commands( K3b::Device::MMC_WRITE_10 ) > 0, 10000 );
+
+    // cleaning up on the GUI thread does not wait for the busy drive
+    QElapsedTimer timer;
+    timer.start();
+    writer.cancel();
+    QVERIFY( timer.elapsed() < 1000 );
+
+    QVERIFY( spy.count() > 0 || spy.wait( 10000 ) );
+    QVERIFY( !spy.first().first().toBool() );
+    QCOMPARE( m_drive.commands( K3b::Device::MMC_CLOSE_TRACK_SESSION ), 0 );
+}
+
+#include "moc_k3bmmcwritertest.cpp"
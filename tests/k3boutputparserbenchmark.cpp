@@ -0,0 +1,375 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+//
+// Replays the output of cdrecord, growisofs, mkisofs and transcode through a
+// process the way the jobs receive it and compares decoding every line and
+// matching it with a regular expression to scanning the raw lines. Prints one
+// line per run:
+//
+//   <tool> <mode>: <lines> progress lines in <ms> ms (<ms> ms parsing)
+//
+// The writer runs additionally pass the lines to the debugging output like
+// the writers and the iso imager do, once for every progress line and once
+// throttled by the ProgressLineFilter:
+//
+//   <tool> <mode>: <lines> progress lines, <lines> logged in <ms> ms (<ms> ms handling)
+//
+
+#include "k3boutputparserbenchmark.h"
+#include "k3boutputparser.h"
+#include "k3bprocess.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRegularExpression>
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( OutputParserBenchmark )
+
+namespace {
+    const int s_progressLines = 100000;
+
+    // every that many progress lines the tools print something else
+    const int s_otherLineInterval = 1000;
+
+    QByteArray cdrecordLog()
+    {
+        QByteArray log( "Starting new track at sector: 0\n" );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            if( i % s_otherLineInterval == 0 )
+                log += "\ncdrecord: Input/output error. Not necessarily serious.";
+            // cdrecord overwrites the progress line with a carriage return
+            log += "\r" + QByteArray( QString::asprintf( "Track 01: %5d of 99999 MB written (fifo %3d%%) [buf %3d%%]  16.2x.",
+                                                         i, 100 - i % 10, 90 + i % 10 ).toLatin1() );
+        }
+        log += "\nFixating...\n";
+        return log;
+    }
+
+    QByteArray growisofsLog()
+    {
+        QByteArray log( "Executing 'builtin_dd if=/dev/fd/0 of=/dev/sr0 obs=32k seek=0'\n" );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            if( i % s_otherLineInterval == 0 )
+                log += "/dev/sr0: \"Current Write Speed\" is 4.1x1385KBps.\n";
+            log += QString::asprintf( " %10lld/4700372992 (%4.1f%%) @3.9x, remaining %d:%02d RBU 100.0%% UBU  %4.1f%%\n",
+                                      qint64( i ) * 32768, i * 100.0 / s_progressLines, i / 60 % 60, i % 60, 90.0 + i % 10 ).toLatin1();
+        }
+        log += "builtin_dd: 2295104*2KB out @ average 3.9x1385KBps\n";
+        return log;
+    }
+
+    QByteArray mkisofsLog()
+    {
+        QByteArray log( "Using ISO-9660 Level 3.\n" );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            if( i % s_otherLineInterval == 0 )
+                log += "Using FILE000.TXT;1 for  /file.txt (file.TXT)\n";
+            log += QString::asprintf( " %5.2f%% done, estimate finish Mon Oct 19 12:00:00 2026\n",
+                                      double( i % 10000 ) / 100.0 ).toLatin1();
+        }
+        log += "Total extents written = 2295104\n";
+        return log;
+    }
+
+    QByteArray transcodeLog()
+    {
+        QByteArray log( "[transcode] V: import frame size | 720x576 (WxH)\n" );
+        for( int i = 0; i < s_progressLines; ++i ) {
+            if( i % s_otherLineInterval == 0 )
+                log += "[export_xvid4.so] Warning: the video codec is deprecated\n";
+            log += QString::asprintf( "encoding=1 frame=%d first=0 last=-1 fps=24.000 done=-1.000000 timestamp=%d.000 timeleft=-1 decodebuf=12 filterbuf=5 encodebuf=3\n",
+                                      i, i / 25 ).toLatin1();
+        }
+        return log;
+    }
+
+    //
+    // The way the jobs parsed their progress before the output parser
+    //
+    qint64 matchDecoded( const QString& tool, const QString& line )
+    {
+        static const QRegularExpression s_cdrecordRx( QRegularExpression::anchoredPattern( "Track\\s(\\d\\d)\\:\\s*(\\d*)\\sof\\s*(\\d*)\\sMB\\swritten\\s(?:\\(fifo\\s*(\\d*)\\%\\)\\s*)?(?:\\[buf\\s*(\\d*)\\%\\])?.*" ) );
+        static const QRegularExpression s_growisofsRx( "^\\s*(\\d+)/(\\d+)\\s*\\(\\s*([\\d.]+)%\\)\\s*@([\\d.]+)x, remaining.*RBU\\s*([\\d.]+)%(?:\\s*UBU\\s*([\\d.]+)%)?" );
+        static const QRegularExpression s_mkisofsRx( "^\\s*(\\d+[.,]\\d+)%\\s*done, estimate" );
+        static const QRegularExpression s_transcodeRx( "^encoding=\\d+ frame=(\\d+)" );
+
+        QRegularExpressionMatch match;
+        if( tool == QLatin1String( "cdrecord" ) ) {
+            if( ( match = s_cdrecordRx.match( line ) ).hasMatch() )
+                return match.capturedView( 2 ).toLongLong();
+        }
+        else if( tool == QLatin1String( "growisofs" ) ) {
+            if( ( match = s_growisofsRx.match( line ) ).hasMatch() )
+                return match.capturedView( 1 ).toLongLong();
+        }
+        else if( tool == QLatin1String( "mkisofs" ) ) {
+            if( ( match = s_mkisofsRx.match( line ) ).hasMatch() )
+                return qint64( match.captured( 1 ).replace( ',', '.' ).toDouble() * 100.0 + 0.5 );
+        }
+        else if( ( match = s_transcodeRx.match( line ) ).hasMatch() ) {
+            return match.capturedView( 1 ).toLongLong();
+        }
+        return -1;
+    }
+
+    qint64 scanRaw( const QString& tool, const QByteArray& line )
+    {
+        K3b::ProgressEvent progress;
+        if( tool == QLatin1String( "cdrecord" ) )
+            progress = K3b::parseCdrecordProgress( line );
+        else if( tool == QLatin1String( "growisofs" ) )
+            progress = K3b::parseGrowisofsProgress( line );
+        else if( tool == QLatin1String( "mkisofs" ) ) {
+            progress = K3b::parseMkisofsProgress( line );
+            progress.done = qint64( progress.percent * 100.0 + 0.5 );
+        }
+        else
+            progress = K3b::parseTranscodeProgress( line );
+
+        return progress.isValid() ? progress.done : -1;
+    }
+}
+
+
+OutputJob::OutputJob()
+    : K3b::Job( 0 )
+{
+}
+
+
+void OutputJob::start()
+{
+}
+
+
+void OutputJob::cancel()
+{
+}
+
+
+OutputParserBenchmark::OutputParserBenchmark()
+{
+}
+
+
+void OutputParserBenchmark::initTestCase()
+{
+    QVERIFY( m_dir.isValid() );
+
+    const QByteArray logs[] = { cdrecordLog(), growisofsLog(), mkisofsLog(), transcodeLog() };
+    const char* const names[] = { "cdrecord", "growisofs", "mkisofs", "transcode" };
+    for( int i = 0; i < 4; ++i ) {
+        QFile f( m_dir.filePath( QLatin1String( names[i] ) + QLatin1String( ".log" ) ) );
+        QVERIFY( f.open( QIODevice::WriteOnly ) );
+        QCOMPARE( f.write( logs[i] ), qint64( logs[i].size() ) );
+    }
+}
+
+
+void OutputParserBenchmark::testParseLines()
+{
+    K3b::ProgressEvent p = K3b::parseCdrecordProgress( "Track 01:   12 of  345 MB written (fifo 100%) [buf  99%]  16.2x." );
+    QCOMPARE( p.type, K3b::ProgressEvent::TrackWritten );
+    QCOMPARE( p.track, 1 );
+    QCOMPARE( p.done, qint64( 12 ) );
+    QCOMPARE( p.total, qint64( 345 ) );
+    QCOMPARE( p.fifo, 100 );
+    QCOMPARE( p.deviceBuffer, 99 );
+    QCOMPARE( p.speed, 16.2 );
+
+    // some patched versions do not print the fifo
+    p = K3b::parseCdrecordProgress( "Track 02: 7 of 12 MB written [buf 88%]" );
+    QCOMPARE( p.done, qint64( 7 ) );
+    QCOMPARE( p.fifo, -1 );
+    QCOMPARE( p.deviceBuffer, 88 );
+
+    QVERIFY( !K3b::parseCdrecordProgress( "Track 01: data  345 MB" ).isValid() );
+
+    p = K3b::parseGrowisofsProgress( " 1234567168/4700000000 (26.3%) @3.9x, remaining 5:42 RBU 100.0% UBU  98.2%" );
+    QCOMPARE( p.type, K3b::ProgressEvent::DataWritten );
+    QCOMPARE( p.done, qint64( 1234567168 ) );
+    QCOMPARE( p.total, qint64( 4700000000LL ) );
+    QCOMPARE( p.percent, 26.3 );
+    QCOMPARE( p.speed, 3.9 );
+    QCOMPARE( p.fifo, 100 );
+    QCOMPARE( p.deviceBuffer, 98 );
+
+    // growisofs < 5.11 does not print the speed
+    p = K3b::parseGrowisofsProgress( "  32768/4700000000 ( 0.0%) remaining ??:??" );
+    QVERIFY( p.isValid() );
+    QCOMPARE( p.speed, -1.0 );
+    QCOMPARE( p.fifo, -1 );
+
+    QVERIFY( !K3b::parseGrowisofsProgress( "/dev/sr0: \"Current Write Speed\" is 4.1x1385KBps." ).isValid() );
+
+    p = K3b::parseMkisofsProgress( " 52.31% done, estimate finish Mon Oct 19 12:00:00 2026" );
+    QCOMPARE( p.type, K3b::ProgressEvent::ImageCreated );
+    QCOMPARE( p.percent, 52.31 );
+    QCOMPARE( K3b::parseMkisofsProgress( "  9,50% done, estimate finish" ).percent, 9.5 );
+    QVERIFY( !K3b::parseMkisofsProgress( "Total extents written = 2295104" ).isValid() );
+
+    p = K3b::parseTranscodeProgress( "encoding=1 frame=1491 first=0 last=-1 fps=14.815" );
+    QCOMPARE( p.type, K3b::ProgressEvent::FramesEncoded );
+    QCOMPARE( p.done, qint64( 1491 ) );
+    QCOMPARE( K3b::parseTranscodeProgress( "encoding frames [000000-000144],  27.58 fps, EMT: 0:00:05" ).done, qint64( 144 ) );
+    QVERIFY( !K3b::parseTranscodeProgress( "[transcode] V: import frame size" ).isValid() );
+}
+
+
+void OutputParserBenchmark::testReplayLog_data()
+{
+    QTest::addColumn<QString>( "tool" );
+    QTest::addColumn<bool>( "raw" );
+    const char* const names[] = { "cdrecord", "growisofs", "mkisofs", "transcode" };
+    for( const char* name : names ) {
+        QTest::newRow( ( QByteArray( name ) + " regexp" ).constData() ) << QString::fromLatin1( name ) << false;
+        QTest::newRow( ( QByteArray( name ) + " scanner" ).constData() ) << QString::fromLatin1( name ) << true;
+    }
+}
+
+
+void OutputParserBenchmark::testReplayLog()
+{
+    QFETCH( QString, tool );
+    QFETCH( bool, raw );
+
+    K3b::Process process;
+    process.setSplitStdout( true );
+    process.setSuppressEmptyLines( true );
+    process << "cat" << m_dir.filePath( tool + QLatin1String( ".log" ) );
+
+    int progressLines = 0;
+    qint64 lastDone = -1;
+    QElapsedTimer parseTimer;
+    qint64 parseTime = 0;
+    if( raw ) {
+        connect( &process, &K3b::Process::rawStdoutLine, [&]( const QByteArray& line ) {
+            parseTimer.start();
+            const qint64 done = scanRaw( tool, line );
+            parseTime += parseTimer.nsecsElapsed();
+            if( done >= 0 ) {
+                ++progressLines;
+                lastDone = done;
+            }
+        } );
+    }
+    else {
+        connect( &process, &K3b::Process::stdoutLine, [&]( const QString& line ) {
+            parseTimer.start();
+            const qint64 done = matchDecoded( tool, line );
+            parseTime += parseTimer.nsecsElapsed();
+            if( done >= 0 ) {
+                ++progressLines;
+                lastDone = done;
+            }
+        } );
+    }
+
+    QSignalSpy finishedSpy( &process, SIGNAL(finished(int,QProcess::ExitStatus)) );
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY( process.start( KProcess::SeparateChannels ) );
+    QVERIFY( finishedSpy.wait( 60000 ) );
+    const qint64 elapsed = timer.elapsed();
+
+    // K3b::Process considers a chunk of output which ends in a point a
+    // finished line, thus a few lines may be split at a decimal point
+    QVERIFY( progressLines <= s_progressLines );
+    QVERIFY( progressLines >= s_progressLines - s_progressLines / 100 );
+    QVERIFY( lastDone > 0 );
+
+    qDebug( "%s %s: %d progress lines in %lld ms (%lld ms parsing)",
+            qPrintable( tool ), raw ? "scanner" : "regexp",
+            progressLines, elapsed, parseTime / 1000000 );
+}
+
+void OutputParserBenchmark::testWriterOutput_data()
+{
+    QTest::addColumn<QString>( "tool" );
+    QTest::addColumn<bool>( "throttled" );
+    const char* const names[] = { "cdrecord", "growisofs", "mkisofs" };
+    for( const char* name : names ) {
+        QTest::newRow( ( QByteArray( name ) + " every line" ).constData() ) << QString::fromLatin1( name ) << false;
+        QTest::newRow( ( QByteArray( name ) + " throttled" ).constData() ) << QString::fromLatin1( name ) << true;
+    }
+}
+
+
+void OutputParserBenchmark::testWriterOutput()
+{
+    QFETCH( QString, tool );
+    QFETCH( bool, throttled );
+
+    K3b::Process process;
+    process.setSplitStdout( true );
+    process.setSuppressEmptyLines( true );
+    process << "cat" << m_dir.filePath( tool + QLatin1String( ".log" ) );
+
+    // the debugging output ends up in a list of lines in the progress dialog
+    OutputJob job;
+    QStringList log;
+    connect( &job, &K3b::Job::debuggingOutput, [&]( const QString&, const QString& line ) {
+        log.append( line );
+    } );
+
+    // an interval of 0 logs every progress line like the writers used to
+    K3b::ProgressLineFilter filter( throttled ? 1000 : 0 );
+    int progressLines = 0;
+    int otherLines = 0;
+    QElapsedTimer handleTimer;
+    qint64 handleTime = 0;
+    connect( &process, &K3b::Process::rawStdoutLine, [&]( const QByteArray& line ) {
+        handleTimer.start();
+        if( scanRaw( tool, line ) >= 0 ) {
+            ++progressLines;
+            if( filter.accept( line ) )
+                emit job.debuggingOutput( tool, QString::fromLatin1( line ) );
+        }
+        else {
+            ++otherLines;
+            const QByteArray skipped = filter.takeSkipped();
+            if( !skipped.isEmpty() )
+                emit job.debuggingOutput( tool, QString::fromLatin1( skipped ) );
+            emit job.debuggingOutput( tool, QString::fromLocal8Bit( line ) );
+        }
+        handleTime += handleTimer.nsecsElapsed();
+    } );
+
+    QSignalSpy finishedSpy( &process, SIGNAL(finished(int,QProcess::ExitStatus)) );
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY( process.start( KProcess::SeparateChannels ) );
+    QVERIFY( finishedSpy.wait( 60000 ) );
+    const QByteArray skipped = filter.takeSkipped();
+    if( !skipped.isEmpty() )
+        emit job.debuggingOutput( tool, QString::fromLatin1( skipped ) );
+    const qint64 elapsed = timer.elapsed();
+
+    QVERIFY( progressLines >= s_progressLines - s_progressLines / 100 );
+
+    QVERIFY( otherLines >= s_progressLines / s_otherLineInterval );
+    if( throttled ) {
+        // the other lines, the progress right before them, one progress line
+        // per second, and the last one
+        QVERIFY( log.count() <= 2 * otherLines + elapsed / 1000 + 2 );
+        QVERIFY( filter.skippedLines() > 0 );
+    }
+    else {
+        QCOMPARE( filter.skippedLines(), 0 );
+        QCOMPARE( log.count(), progressLines + otherLines );
+    }
+
+    qDebug( "%s %s: %d progress lines, %d logged in %lld ms (%lld ms handling)",
+            qPrintable( tool ), throttled ? "throttled" : "every line",
+            progressLines, int( log.count() ), elapsed, handleTime / 1000000 );
+}
+
+#include "moc_k3boutputparserbenchmark.cpp"
@@ -0,0 +1,46 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_OUTPUT_PARSER_BENCHMARK_H
+#define K3B_OUTPUT_PARSER_BENCHMARK_H
+
+#include "k3bjob.h"
+
+#include <QObject>
+#include <QTemporaryDir>
+
+/**
+ * Only used to emit the debugging output the way the writers do.
+ */
+class OutputJob : public K3b::Job
+{
+    Q_OBJECT
+public:
+    OutputJob();
+
+public Q_SLOTS:
+    void start() override;
+    void cancel() override;
+};
+
+class OutputParserBenchmark : public QObject
+{
+    Q_OBJECT
+public:
+    OutputParserBenchmark();
+private slots:
+    void initTestCase();
+    void testParseLines();
+    void testReplayLog_data();
+    void testReplayLog();
+    void testWriterOutput_data();
+    void testWriterOutput();
+
+private:
+    QTemporaryDir m_dir;
+};
+
+#endif // K3B_OUTPUT_PARSER_BENCHMARK_H
@@ -0,0 +1,83 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bprefetchbuffertest.h"
+#include "k3bprefetchbuffer.h"
+#include "k3btestdevices.h"
+
+#include <QBuffer>
+#include <QMutex>
+#include <QTemporaryDir>
+#include <QTest>
+
+QTEST_GUILESS_MAIN( PrefetchBufferTest )
+
+using namespace TestUtils;
+
+PrefetchBufferTest::PrefetchBufferTest()
+{
+}
+
+void PrefetchBufferTest::testSinkGetsData()
+{
+    const QByteArray data = testData( 5*1024*1024 + 123 );
+
+    QBuffer sink;
+    K3b::PrefetchBuffer buffer;
+    buffer.setSize( 1024*1024, 2*1024*1024 );
+    buffer.writeTo( &sink, true );
+    QVERIFY( buffer.open() );
+
+    QVERIFY( writeAll( &buffer, data ) );
+    buffer.close();
+
+    QTRY_VERIFY( !buffer.isOpen() );
+    QVERIFY( !sink.isOpen() );
+    QCOMPARE( sink.data(), data );
+}
+
+void PrefetchBufferTest::testSpillWhileSinkBlocks()
+{
+    const QByteArray data = testData( 4*1024*1024 + 123 );
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+
+    QMutex gate;
+    gate.lock();
+
+    GatedDevice sink( &gate );
+    K3b::PrefetchBuffer buffer;
+    buffer.setSize( 1024*1024, 1024*1024 );
+    buffer.setSpillDirectory( dir.path(), 8*1024*1024 );
+    buffer.writeTo( &sink );
+    QVERIFY( buffer.open() );
+
+    // does not block although the sink does not take anything
+    QVERIFY( writeAll( &buffer, data ) );
+
+    gate.unlock();
+    buffer.close();
+
+    QTRY_VERIFY( !buffer.isOpen() );
+    QVERIFY( sink.isOpen() );
+    QCOMPARE( sink.data, data );
+}
+
+void PrefetchBufferTest::testWriteFailsAfterAbort()
+{
+    QBuffer sink;
+    K3b::PrefetchBuffer buffer;
+    buffer.writeTo( &sink );
+    QVERIFY( buffer.open() );
+
+    buffer.abort();
+    QCOMPARE( buffer.write( "foo", 3 ), qint64( -1 ) );
+
+    QTRY_VERIFY( !buffer.isOpen() );
+}
+
+#include "moc_k3bprefetchbuffertest.cpp"
@@ -0,0 +1,23 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_PREFETCH_BUFFER_TEST_H
+#define K3B_PREFETCH_BUFFER_TEST_H
+
+#include <QObject>
+
+class PrefetchBufferTest : public QObject
+{
+    Q_OBJECT
+public:
+    PrefetchBufferTest();
+private slots:
+    void testSinkGetsData();
+    void testSpillWhileSinkBlocks();
+    void testWriteFailsAfterAbort();
+};
+
+#endif // K3B_PREFETCH_BUFFER_TEST_H
@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3btestdevices.h"
+
+#include <QMutex>
+
+namespace TestUtils
+{
+
+FailingDevice::FailingDevice( qint64 limit )
+    : m_limit( limit ),
+      m_written( 0 )
+{
+}
+
+qint64 FailingDevice::readData( char*, qint64 )
+{
+    return -1;
+}
+
+qint64 FailingDevice::writeData( const char*, qint64 len )
+{
+    if( m_written >= m_limit )
+        return -1;
+    len = qMin( len, m_limit - m_written );
+    m_written += len;
+    return len;
+}
+
+
+GatedDevice::GatedDevice( QMutex* gate )
+    : m_gate( gate )
+{
+}
+
+qint64 GatedDevice::readData( char*, qint64 )
+{
+    return -1;
+}
+
+qint64 GatedDevice::writeData( const char* buf, qint64 len )
+{
+    m_gate->lock();
+    m_gate->unlock();
+    data.append( buf, len );
+    return len;
+}
+
+
+QByteArray testData( int size )
+{
+    QByteArray data( size, 0 );
+    for( int i = 0; i < data.size(); ++i )
+        data[i] = char( i * 7 + i / 4096 );
+    return data;
+}
+
+bool writeAll( QIODevice* dev, const QByteArray& data )
+{
+    for( int pos = 0; pos < data.size(); pos += 10000 ) {
+        if( dev->write( data.constData() + pos, qMin( 10000, data.size() - pos ) ) < 0 )
+            return false;
+    }
+    return true;
+}
+
+} // namespace TestUtils
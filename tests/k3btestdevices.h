@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_TEST_DEVICES_H
+#define K3B_TEST_DEVICES_H
+
+#include <QByteArray>
+#include <QIODevice>
+
+class QMutex;
+
+namespace TestUtils
+{
+    /**
+     * Accepts the given number of bytes and fails afterwards.
+     */
+    class FailingDevice : public QIODevice
+    {
+    public:
+        explicit FailingDevice( qint64 limit );
+
+    protected:
+        qint64 readData( char*, qint64 ) override;
+        qint64 writeData( const char* data, qint64 len ) override;
+
+    private:
+        qint64 m_limit;
+        qint64 m_written;
+    };
+
+    /**
+     * Blocks every write while the gate is locked.
+     */
+    class GatedDevice : public QIODevice
+    {
+    public:
+        explicit GatedDevice( QMutex* gate );
+
+        QByteArray data;
+
+    protected:
+        qint64 readData( char*, qint64 ) override;
+        qint64 writeData( const char* buf, qint64 len ) override;
+
+    private:
+        QMutex* m_gate;
+    };
+
+    /**
+     * \return @p size bytes of data which does not repeat within 4096 bytes.
+     */
+    QByteArray testData( int size );
+
+    /**
+     * Writes @p data in chunks of 10000 bytes which do not fit any
+     * buffer size evenly.
+     */
+    bool writeAll( QIODevice* dev, const QByteArray& data );
+
+} // namespace TestUtils
+
+#endif // K3B_TEST_DEVICES_H
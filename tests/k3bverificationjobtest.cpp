@@ -0,0 +1,95 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "k3bverificationjobtest.h"
+#include "k3bverificationjob.h"
+
+#include <QTest>
+
+QTEST_GUILESS_MAIN( VerificationJobTest )
+
+namespace {
+    // the sample is random so each case is checked several times
+    const int s_runs = 20;
+}
+
+
+VerificationJobTest::VerificationJobTest()
+{
+}
+
+
+void VerificationJobTest::testAllExtents_data()
+{
+    QTest::addColumn<int>( "extents" );
+    QTest::addColumn<int>( "confidence" );
+
+    QTest::newRow( "sampling disabled" ) << 1000 << 0;
+    QTest::newRow( "full confidence" ) << 1000 << 100;
+    QTest::newRow( "fewer extents than samples" ) << 200 << 95;
+    QTest::newRow( "as many extents as samples" ) << 299 << 95;
+    QTest::newRow( "single extent" ) << 1 << 95;
+}
+
+
+void VerificationJobTest::testAllExtents()
+{
+    QFETCH( int, extents );
+    QFETCH( int, confidence );
+
+    QList<int> expected;
+    for( int i = 0; i < extents; ++i )
+        expected << i;
+
+    QCOMPARE( K3b::VerificationJob::sampleExtents( extents, confidence ), expected );
+}
+
+
+void VerificationJobTest::testSampledExtents_data()
+{
+    QTest::addColumn<int>( "extents" );
+    QTest::addColumn<int>( "confidence" );
+    QTest::addColumn<int>( "samples" );
+
+    // ceil( log( 1 - confidence ) / log( 0.99 ) )
+    QTest::newRow( "90%" ) << 500 << 90 << 230;
+    QTest::newRow( "95%" ) << 1000 << 95 << 299;
+    QTest::newRow( "95% barely sampled" ) << 300 << 95 << 299;
+    QTest::newRow( "99%" ) << 100000 << 99 << 459;
+}
+
+
+void VerificationJobTest::testSampledExtents()
+{
+    QFETCH( int, extents );
+    QFETCH( int, confidence );
+    QFETCH( int, samples );
+
+    for( int run = 0; run < s_runs; ++run ) {
+        const QList<int> sample = K3b::VerificationJob::sampleExtents( extents, confidence );
+
+        // one extent per stratum plus the first and the last one
+        QVERIFY( sample.count() >= samples );
+        QVERIFY( sample.count() <= samples + 2 );
+        QCOMPARE( sample.first(), 0 );
+        QCOMPARE( sample.last(), extents - 1 );
+
+        for( int i = 1; i < sample.count(); ++i )
+            QVERIFY( sample[i-1] < sample[i] );
+
+        int pos = 0;
+        for( int stratum = 0; stratum < samples; ++stratum ) {
+            const int first = qint64( extents ) * stratum / samples;
+            const int next = qint64( extents ) * ( stratum + 1 ) / samples;
+            while( pos < sample.count() && sample[pos] < first )
+                ++pos;
+            QVERIFY2( pos < sample.count() && sample[pos] < next,
+                      qPrintable( QString( "no extent in stratum %1" ).arg( stratum ) ) );
+        }
+    }
+}
+
+#include "moc_k3bverificationjobtest.cpp"
@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2026 The K3b Developers
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef K3B_VERIFICATION_JOB_TEST_H
+#define K3B_VERIFICATION_JOB_TEST_H
+
+#include <QObject>
+
+class VerificationJobTest : public QObject
+{
+    Q_OBJECT
+public:
+    VerificationJobTest();
+private slots:
+    void testAllExtents_data();
+    void testAllExtents();
+    void testSampledExtents_data();
+    void testSampledExtents();
+};
+
+#endif // K3B_VERIFICATION_JOB_TEST_H